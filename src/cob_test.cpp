@@ -1,10 +1,17 @@
+#include <chrono>
+#include <cmath>
 #include <fstream>
 #include <iomanip>
 #include <iostream>
 #include <rwe/Cob.h>
+#include <rwe/GameSimulation.h>
+#include <rwe/SimulationDriver.h>
 #include <rwe/_3do.h>
+#include <rwe/cob/CobExecutionContext.h>
+#include <rwe/cob/CobExecutionService.h>
 #include <rwe/cob/CobOpCode.h>
 #include <rwe/optional_io.h>
+#include <string>
 #include <vector>
 
 namespace rwe
@@ -216,11 +223,151 @@ void printCob(const rwe::CobScript& cob)
     CobInstructionPrinter<std::vector<unsigned int>::const_iterator>(cob.instructions.begin(), cob.instructions.end()).printInstructions();
 }
 
+namespace rwe
+{
+    /**
+     * Creates a unit with a bare mesh whose pieces are named after the script's,
+     * so that piece instructions have something to act on.
+     */
+    Unit createBenchmarkUnit(const CobScript& cob, const SimVector& position)
+    {
+        UnitMesh mesh;
+        for (const auto& pieceName : cob.pieces)
+        {
+            auto& piece = mesh.pieces.emplace_back();
+            piece.name = pieceName;
+            if (mesh.pieces.size() > 1)
+            {
+                piece.parent = 0;
+            }
+        }
+
+        Unit unit(mesh, std::make_unique<CobEnvironment>(&cob), std::make_shared<SelectionMesh>(SelectionMesh{CollisionMesh(), GlMesh(VaoHandle(), VboHandle(), 0)}));
+        for (unsigned int i = 0; i < cob.pieces.size(); ++i)
+        {
+            unit.scriptPieceIndices.emplace_back(i);
+        }
+        unit.position = position;
+        unit.maxHitPoints = 100;
+        unit.hitPoints = 100;
+        unit.buildTime = 100;
+        unit.buildTimeCompleted = 100;
+        unit.footprintX = 1;
+        unit.footprintZ = 1;
+        unit.isMobile = true;
+        return unit;
+    }
+
+    /**
+     * Runs a script on many units the way the game does,
+     * calling the entry points that unit behaviour calls,
+     * and reports how fast cob instructions are executed.
+     *
+     * The units alternate between moving and standing still every few seconds
+     * and always have a target, so their walk and aim scripts are exercised.
+     * Scripts are run in parallel on the calling thread
+     * and the given number of worker threads.
+     */
+    void benchmarkCob(const CobScript& cob, unsigned int unitCount, unsigned int tickCount, unsigned int workerCount)
+    {
+        const unsigned int gridSide = static_cast<unsigned int>(std::ceil(std::sqrt(static_cast<double>(unitCount))));
+        const unsigned int mapSize = (gridSide * 2) + 2;
+
+        MapTerrain terrain(
+            std::vector<TextureRegion>(),
+            Grid<std::size_t>(1, 1, 0),
+            Grid<unsigned char>(mapSize + 1, mapSize + 1, 0),
+            0_ss);
+        GameSimulation simulation(std::move(terrain), 0);
+        ThreadPool threadPool(workerCount);
+        SimulationDriver driver(&simulation, nullptr, nullptr, nullptr, &threadPool);
+        CobExecutionService cobExecutionService;
+        std::vector<CobUnitCommand> commands;
+
+        std::vector<UnitId> unitIds;
+        for (unsigned int i = 0; i < unitCount; ++i)
+        {
+            auto position = simulation.terrain.heightmapIndexToWorldCenter(static_cast<int>(((i % gridSide) * 2) + 1), static_cast<int>(((i / gridSide) * 2) + 1));
+            auto unitId = simulation.tryAddUnit(createBenchmarkUnit(cob, position));
+            if (!unitId)
+            {
+                throw std::logic_error("Failed to place benchmark unit");
+            }
+            unitIds.push_back(*unitId);
+            simulation.getUnit(*unitId).cobEnvironment->createThread(CobEntryPoint::Create);
+        }
+
+        const unsigned int movePhaseTicks = 180;
+        const unsigned int aimIntervalTicks = 15;
+
+        std::uint64_t instructionCount = 0;
+        auto start = std::chrono::steady_clock::now();
+
+        for (unsigned int tick = 0; tick < tickCount; ++tick)
+        {
+            simulation.gameTime += GameTime(1);
+            cobExecutionService.wakeSleepingThreads(simulation);
+
+            for (auto unitId : unitIds)
+            {
+                auto& unit = simulation.getUnit(unitId);
+                auto& env = *unit.cobEnvironment;
+
+                if (tick % movePhaseTicks == 0)
+                {
+                    env.createThread((tick / movePhaseTicks) % 2 == 0 ? CobEntryPoint::StartMoving : CobEntryPoint::StopMoving);
+                }
+
+                if (tick % aimIntervalTicks == 0)
+                {
+                    auto heading = static_cast<int>((tick * 1000) % 65536);
+                    env.createThread(CobEntryPoint::AimPrimary, {heading, 2000});
+                }
+
+                // run synchronously, as UnitBehaviorService does
+                for (auto entryPoint : {CobEntryPoint::QueryPrimary, CobEntryPoint::AimFromPrimary})
+                {
+                    auto thread = env.createNonScheduledThread(entryPoint, {0});
+                    if (thread)
+                    {
+                        CobCommandBuffer buffer;
+                        CobExecutionContext context(&buffer, &simulation, &simulation.rng, &env, &*thread, unitId);
+                        context.execute();
+                        instructionCount += context.getInstructionCount();
+                    }
+                }
+
+                if (unit.mesh.update(SimulationDriver::SecondsPerTick))
+                {
+                    env.blockedQueueDirty = true;
+                }
+            }
+
+            // run scripts in parallel, as SimulationDriver does
+            commands.clear();
+            instructionCount += cobExecutionService.runUnits(threadPool, simulation, unitIds, commands);
+            for (const auto& command : commands)
+            {
+                driver.applyCobUnitCommand(command);
+            }
+        }
+
+        auto end = std::chrono::steady_clock::now();
+        auto seconds = std::chrono::duration<double>(end - start).count();
+
+        std::cout << unitCount << " units, " << tickCount << " ticks, " << threadPool.getThreadCount() << " worker threads" << std::endl;
+        std::cout << "  " << instructionCount << " instructions in " << (seconds * 1000.0) << " ms" << std::endl;
+        std::cout << "  " << (static_cast<double>(instructionCount) / seconds / 1e6) << " million instructions/s" << std::endl;
+        std::cout << "  " << (seconds * 1e6 / tickCount) << " us/tick" << std::endl;
+    }
+}
+
 int main(int argc, char* argv[])
 {
     if (argc < 2)
     {
         std::cerr << "Specify a cob file to dump." << std::endl;
+        std::cerr << "Usage: cob_test <file.cob> [--bench [unit count] [tick count] [worker count]]" << std::endl;
         return 1;
     }
 
@@ -230,6 +377,15 @@ int main(int argc, char* argv[])
 
     auto script = rwe::parseCob(fh);
 
+    if (argc > 2 && std::string(argv[2]) == "--bench")
+    {
+        unsigned int unitCount = argc > 3 ? std::stoul(argv[3]) : 500;
+        unsigned int tickCount = argc > 4 ? std::stoul(argv[4]) : 1800;
+        unsigned int workerCount = argc > 5 ? std::stoul(argv[5]) : 1;
+        rwe::benchmarkCob(script, unitCount, tickCount, workerCount);
+        return 0;
+    }
+
     printCob(script);
 
     return 0;
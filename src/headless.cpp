@@ -0,0 +1,509 @@
+#include <boost/program_options.hpp>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <rwe/ColorPalette.h>
+#include <rwe/GameParameters.h>
+#include <rwe/MapFeatureService.h>
+#include <rwe/MeshService.h>
+#include <rwe/MovementClassCollisionService.h>
+#include <rwe/SideData.h>
+#include <rwe/SimulationDriver.h>
+#include <rwe/TextureService.h>
+#include <rwe/ThreadPool.h>
+#include <rwe/UnitFactory.h>
+#include <rwe/game_loading.h>
+#include <rwe/ota.h>
+#include <rwe/rwe_string.h>
+#include <rwe/rwe_time.h>
+#include <rwe/snapshot/SnapshotStream.h>
+#include <rwe/snapshot/snapshot_io.h>
+#include <rwe/tdf.h>
+#include <rwe/vfs/CompositeVirtualFileSystem.h>
+#include <spdlog/sinks/stdout_sinks.h>
+#include <spdlog/spdlog.h>
+#include <sstream>
+
+namespace po = boost::program_options;
+
+namespace rwe
+{
+    std::vector<char> readRequiredFile(AbstractVirtualFileSystem& vfs, const std::string& path)
+    {
+        auto bytes = vfs.readFile(path);
+        if (!bytes)
+        {
+            throw std::runtime_error("Failed to read " + path);
+        }
+
+        return std::move(*bytes);
+    }
+
+    ColorPalette readRequiredPalette(AbstractVirtualFileSystem& vfs, const std::string& path)
+    {
+        auto bytes = readRequiredFile(vfs, path);
+        auto palette = readPalette(bytes);
+        if (!palette)
+        {
+            throw std::runtime_error("Failed to read palette " + path);
+        }
+
+        return std::move(*palette);
+    }
+
+    /** Parses "name;side;color". */
+    PlayerInfo parseHeadlessPlayer(const std::string& playerString)
+    {
+        auto components = utf8Split(playerString, ';');
+        if (components.size() != 3)
+        {
+            throw std::runtime_error("Invalid player arg: " + playerString);
+        }
+
+        std::stringstream colorStream(components[2]);
+        unsigned int color;
+        colorStream >> color;
+        if (colorStream.fail() || color > 9)
+        {
+            throw std::runtime_error("Invalid player colour: " + components[2]);
+        }
+
+        return PlayerInfo{components[0], PlayerControllerTypeComputer(), components[1], PlayerColorIndex(color), Metal(1000), Energy(1000)};
+    }
+
+    UnitFireOrders parseFireOrders(const std::string& s)
+    {
+        if (s == "hold")
+        {
+            return UnitFireOrders::HoldFire;
+        }
+        if (s == "return")
+        {
+            return UnitFireOrders::ReturnFire;
+        }
+        if (s == "fire")
+        {
+            return UnitFireOrders::FireAtWill;
+        }
+
+        throw std::runtime_error("Unknown fire orders: " + s);
+    }
+
+    using ScriptedCommands = std::map<GameTime, std::vector<std::pair<PlayerId, PlayerCommand>>>;
+
+    /**
+     * Reads a command script.
+     * Each non-empty line not starting with '#' has the form:
+     *
+     *   <tick> <player> <unit> move <x> <z>
+     *   <tick> <player> <unit> queue-move <x> <z>
+     *   <tick> <player> <unit> attack <target unit>
+     *   <tick> <player> <unit> attack-ground <x> <z>
+     *   <tick> <player> <unit> build <unit type> <x> <z>
+     *   <tick> <player> <unit> build-queue <unit type> <count>
+     *   <tick> <player> <unit> stop
+     *   <tick> <player> <unit> on|off
+     *   <tick> <player> <unit> fire-orders hold|return|fire
+     *
+     * Commands are applied at the start of the given tick.
+     * World coordinates are given relative to the map centre.
+     */
+    ScriptedCommands parseCommandScript(std::istream& input, const GameSimulation& simulation)
+    {
+        ScriptedCommands commands;
+
+        auto readPosition = [&simulation](std::istream& s) {
+            float x;
+            float z;
+            s >> x >> z;
+            SimVector position(SimScalar(x), 0_ss, SimScalar(z));
+            position.y = simulation.terrain.getHeightAt(position.x, position.z);
+            return position;
+        };
+
+        std::string line;
+        for (unsigned int lineNumber = 1; std::getline(input, line); ++lineNumber)
+        {
+            if (line.empty() || line[0] == '#')
+            {
+                continue;
+            }
+
+            std::istringstream s(line);
+            unsigned int tick;
+            unsigned int player;
+            unsigned int unit;
+            std::string verb;
+            s >> tick >> player >> unit >> verb;
+            if (s.fail())
+            {
+                throw std::runtime_error("Malformed command on line " + std::to_string(lineNumber));
+            }
+
+            UnitId unitId(unit);
+            std::optional<PlayerUnitCommand::Command> command;
+            if (verb == "move")
+            {
+                command = PlayerUnitCommand::IssueOrder(MoveOrder(readPosition(s)), PlayerUnitCommand::IssueOrder::IssueKind::Immediate);
+            }
+            else if (verb == "queue-move")
+            {
+                command = PlayerUnitCommand::IssueOrder(MoveOrder(readPosition(s)), PlayerUnitCommand::IssueOrder::IssueKind::Queued);
+            }
+            else if (verb == "attack")
+            {
+                unsigned int target;
+                s >> target;
+                command = PlayerUnitCommand::IssueOrder(AttackOrder(UnitId(target)), PlayerUnitCommand::IssueOrder::IssueKind::Immediate);
+            }
+            else if (verb == "attack-ground")
+            {
+                command = PlayerUnitCommand::IssueOrder(AttackOrder(readPosition(s)), PlayerUnitCommand::IssueOrder::IssueKind::Immediate);
+            }
+            else if (verb == "build")
+            {
+                std::string unitType;
+                s >> unitType;
+                command = PlayerUnitCommand::IssueOrder(BuildOrder(unitType, readPosition(s)), PlayerUnitCommand::IssueOrder::IssueKind::Immediate);
+            }
+            else if (verb == "build-queue")
+            {
+                std::string unitType;
+                int count;
+                s >> unitType >> count;
+                command = PlayerUnitCommand::ModifyBuildQueue{count, unitType};
+            }
+            else if (verb == "stop")
+            {
+                command = PlayerUnitCommand::Stop();
+            }
+            else if (verb == "on" || verb == "off")
+            {
+                command = PlayerUnitCommand::SetOnOff{verb == "on"};
+            }
+            else if (verb == "fire-orders")
+            {
+                std::string orders;
+                s >> orders;
+                command = PlayerUnitCommand::SetFireOrders{parseFireOrders(orders)};
+            }
+            else
+            {
+                throw std::runtime_error("Unknown command '" + verb + "' on line " + std::to_string(lineNumber));
+            }
+
+            if (s.fail())
+            {
+                throw std::runtime_error("Malformed arguments on line " + std::to_string(lineNumber));
+            }
+
+            commands[GameTime(tick)].emplace_back(PlayerId(player), PlayerUnitCommand(unitId, *command));
+        }
+
+        return commands;
+    }
+
+    /** Reads the last snapshot in a snapshot stream, such as a state log or a desync dump. */
+    SimulationSnapshot readLastSnapshot(const std::string& path)
+    {
+        std::ifstream input(path, std::ios::binary);
+        if (!input.is_open())
+        {
+            throw std::runtime_error("Failed to open snapshot file " + path);
+        }
+
+        SnapshotStreamReader reader(&input);
+        std::optional<std::vector<char>> last;
+        while (auto record = reader.read())
+        {
+            last = std::move(record->second);
+        }
+
+        if (!last)
+        {
+            throw std::runtime_error("No snapshots in " + path);
+        }
+
+        return deserializeSnapshot(*last);
+    }
+
+    double toMilliseconds(std::chrono::nanoseconds duration)
+    {
+        return std::chrono::duration<double, std::milli>(duration).count();
+    }
+
+    void printPhase(const char* name, std::chrono::nanoseconds total, unsigned int ticks)
+    {
+        std::cout << "  " << std::left << std::setw(16) << name
+                  << std::right << std::setw(12) << std::fixed << std::setprecision(3) << toMilliseconds(total) << " ms total"
+                  << std::setw(12) << std::fixed << std::setprecision(4) << (toMilliseconds(total) / ticks) << " ms/tick"
+                  << std::endl;
+    }
+
+    int runHeadless(const std::vector<std::string>& dataPaths, const std::string& mapName, unsigned int schemaIndex, const std::vector<std::string>& playerStrings, unsigned int tickCount, const std::optional<std::string>& commandFile, const std::optional<std::string>& cobProfileFile, const std::optional<std::string>& restoreFile)
+    {
+        // Shared by file loading, path finding and unit scripts.
+        ThreadPool threadPool;
+        CompositeVirtualFileSystem vfs;
+        for (const auto& path : dataPaths)
+        {
+            addToVfs(vfs, path, &threadPool);
+        }
+
+        auto palette = readRequiredPalette(vfs, "palettes/PALETTE.PAL");
+        auto guiPalette = readRequiredPalette(vfs, "palettes/GUIPAL.PAL");
+
+        // Nothing is drawn, so textures and meshes are loaded without uploading them to a GPU.
+        TextureService textureService(nullptr, &vfs, &palette);
+        MapFeatureService featureService(&vfs);
+        featureService.loadAllFeatureDefinitions();
+
+        std::unordered_map<std::string, SideData> sideDataMap;
+        {
+            auto sideDataBytes = readRequiredFile(vfs, "gamedata/SIDEDATA.TDF");
+            std::string sideDataString(sideDataBytes.data(), sideDataBytes.size());
+            for (auto& side : parseSidesFromSideData(parseTdfFromString(sideDataString)))
+            {
+                std::string name = side.name;
+                sideDataMap.insert({std::move(name), std::move(side)});
+            }
+        }
+
+        GameParameters gameParameters(mapName, schemaIndex);
+        if (playerStrings.size() > gameParameters.players.size())
+        {
+            throw std::runtime_error("too many players");
+        }
+        for (unsigned int i = 0; i < playerStrings.size(); ++i)
+        {
+            gameParameters.players[i] = parseHeadlessPlayer(playerStrings[i]);
+        }
+
+        auto loadStart = getTimestamp();
+
+        auto otaBytes = readRequiredFile(vfs, "maps/" + mapName + ".ota");
+        auto ota = parseOta(parseTdfFromString(std::string(otaBytes.data(), otaBytes.size())));
+
+        auto simulation = createInitialSimulation(&vfs, nullptr, &textureService, &palette, &featureService, mapName, ota, schemaIndex);
+        auto seedSeq = seedFromGameParameters(gameParameters);
+        simulation.rng.seed(seedSeq);
+
+        auto meshService = MeshService::createMeshService(&vfs, nullptr, &palette);
+        auto unitDatabase = createUnitDatabase(&vfs, nullptr);
+
+        MovementClassCollisionService collisionService;
+        for (auto it = unitDatabase.movementClassBegin(); it != unitDatabase.movementClassEnd(); ++it)
+        {
+            collisionService.registerMovementClass(it->first, computeWalkableGrid(simulation, it->second));
+        }
+
+        std::vector<PlayerId> playerIds;
+        for (const auto& params : gameParameters.players)
+        {
+            if (!params)
+            {
+                continue;
+            }
+
+            GamePlayerInfo gpi{params->name, GamePlayerType::Computer, params->color, GamePlayerStatus::Alive, params->side, params->metal, params->metal, params->energy, params->energy};
+            playerIds.push_back(simulation.addPlayer(gpi));
+        }
+
+        UnitFactory unitFactory(&textureService, std::move(unitDatabase), std::move(meshService), &collisionService, &palette, &guiPalette);
+        SimulationDriver driver(&simulation, &collisionService, &unitFactory, &textureService, &threadPool);
+        if (cobProfileFile)
+        {
+            driver.setCobProfilingEnabled(true);
+        }
+
+        if (restoreFile)
+        {
+            driver.restoreSnapshot(readLastSnapshot(*restoreFile));
+        }
+        else
+        {
+            const auto& schema = ota.schemas.at(schemaIndex);
+            for (unsigned int i = 0, playerIndex = 0; i < gameParameters.players.size(); ++i)
+            {
+                const auto& player = gameParameters.players[i];
+                if (!player)
+                {
+                    continue;
+                }
+
+                std::string startPosKey("StartPos");
+                startPosKey.append(std::to_string(i + 1));
+
+                auto startPosIt = std::find_if(schema.specials.begin(), schema.specials.end(), [&startPosKey](const OtaSpecial& s) { return s.specialWhat == startPosKey; });
+                if (startPosIt == schema.specials.end())
+                {
+                    throw std::runtime_error("Missing key from schema: " + startPosKey);
+                }
+
+                auto worldStartPos = simulation.terrain.topLeftCoordinateToWorld(SimVector(SimScalar(startPosIt->xPos), 0_ss, SimScalar(startPosIt->zPos)));
+                worldStartPos.y = simulation.terrain.getHeightAt(worldStartPos.x, worldStartPos.z);
+
+                auto sideIt = sideDataMap.find(player->side);
+                if (sideIt == sideDataMap.end())
+                {
+                    throw std::runtime_error("Missing side data for " + player->side);
+                }
+
+                driver.spawnCompletedUnit(sideIt->second.commander, playerIds.at(playerIndex), worldStartPos);
+                ++playerIndex;
+            }
+        }
+
+        ScriptedCommands scriptedCommands;
+        if (commandFile)
+        {
+            std::ifstream commandStream(*commandFile);
+            if (!commandStream.is_open())
+            {
+                throw std::runtime_error("Failed to open command file " + *commandFile);
+            }
+            scriptedCommands = parseCommandScript(commandStream, simulation);
+        }
+
+        auto loadEnd = getTimestamp();
+        std::cout << "Loaded " << mapName << " in " << std::fixed << std::setprecision(1) << toMilliseconds(loadEnd - loadStart) << " ms" << std::endl;
+
+        SimulationTickTimings totals;
+        std::vector<std::pair<PlayerId, std::vector<PlayerCommand>>> tickCommands;
+        auto runStart = getTimestamp();
+        for (unsigned int i = 0; i < tickCount; ++i)
+        {
+            tickCommands.clear();
+            for (const auto& playerId : playerIds)
+            {
+                tickCommands.emplace_back(playerId, std::vector<PlayerCommand>());
+            }
+
+            if (auto it = scriptedCommands.find(simulation.gameTime + GameTime(1)); it != scriptedCommands.end())
+            {
+                for (const auto& [playerId, command] : it->second)
+                {
+                    if (playerId.value >= tickCommands.size())
+                    {
+                        throw std::runtime_error("Scripted command refers to unknown player " + std::to_string(playerId.value));
+                    }
+                    tickCommands[playerId.value].second.push_back(command);
+                }
+            }
+
+            driver.tick(tickCommands);
+            totals += driver.getLastTickTimings();
+        }
+        auto runEnd = getTimestamp();
+
+        auto elapsedMs = toMilliseconds(runEnd - runStart);
+        std::cout << "Ran " << tickCount << " ticks in " << std::fixed << std::setprecision(1) << elapsedMs << " ms"
+                  << " (" << std::setprecision(1) << (tickCount / (elapsedMs / 1000.0)) << " ticks/sec)" << std::endl;
+
+        std::cout << "Phase timings:" << std::endl;
+        printPhase("commands", totals.playerCommands, tickCount);
+        printPhase("resources", totals.resources, tickCount);
+        printPhase("pathfinding", totals.pathFinding, tickCount);
+        printPhase("unit behavior", totals.unitBehavior, tickCount);
+        printPhase("unit animation", totals.unitAnimation, tickCount);
+        printPhase("unit scripts", totals.unitScripts, tickCount);
+        printPhase("projectiles", totals.projectiles, tickCount);
+        printPhase("explosions", totals.explosions, tickCount);
+        printPhase("cleanup", totals.cleanup, tickCount);
+        printPhase("hash", totals.hash, tickCount);
+
+        if (cobProfileFile)
+        {
+            saveCobProfile(*cobProfileFile, driver.getCobProfiler().getEntries());
+            std::cout << "Wrote cob profile to " << *cobProfileFile << std::endl;
+        }
+
+        std::cout << "Final game time: " << simulation.gameTime.value << std::endl;
+        auto finalHash = simulation.computeHash();
+        std::cout << "Final hash: " << std::hex << std::setw(8) << std::setfill('0') << finalHash.value << std::dec << std::setfill(' ') << std::endl;
+        if (driver.getGameHash() != finalHash)
+        {
+            std::cerr << "Incremental hash " << std::hex << std::setw(8) << std::setfill('0') << driver.getGameHash().value << std::dec << std::setfill(' ') << " did not match the final hash" << std::endl;
+            return 1;
+        }
+
+        return 0;
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    po::options_description desc("Runs the game simulation without rendering, audio or networking");
+
+    // clang-format off
+    desc.add_options()
+        ("help", "produce help message")
+        ("data-path", po::value<std::vector<std::string>>()->required(), "Sets the location(s) to search for game data")
+        ("map", po::value<std::string>()->required(), "The map to run the simulation on")
+        ("schema", po::value<unsigned int>()->default_value(0), "Map schema index")
+        ("player", po::value<std::vector<std::string>>()->required(), "name;side;color")
+        ("ticks", po::value<unsigned int>()->default_value(3600), "Number of game ticks to simulate")
+        ("commands", po::value<std::string>(), "File of scripted player commands to apply during the run")
+        ("cob-profile", po::value<std::string>(), "Profiles unit scripts and writes the results to the given .csv or .json file")
+        ("restore", po::value<std::string>(), "Starts from the last snapshot in the given snapshot stream instead of spawning the commanders");
+    // clang-format on
+
+    try
+    {
+        po::variables_map vm;
+        po::store(po::parse_command_line(argc, argv, desc), vm);
+
+        if (vm.count("help"))
+        {
+            std::cout << desc << std::endl;
+            return 0;
+        }
+
+        po::notify(vm);
+
+        // Rates are reported per tick, so there must be at least one.
+        if (vm["ticks"].as<unsigned int>() == 0)
+        {
+            throw std::runtime_error("--ticks must be at least 1");
+        }
+
+        // Parts of the engine log through the global "rwe" logger.
+        auto logger = spdlog::stderr_logger_mt("rwe");
+        logger->set_level(spdlog::level::warn);
+
+        std::optional<std::string> commandFile;
+        if (vm.count("commands"))
+        {
+            commandFile = vm["commands"].as<std::string>();
+        }
+
+        std::optional<std::string> cobProfileFile;
+        if (vm.count("cob-profile"))
+        {
+            cobProfileFile = vm["cob-profile"].as<std::string>();
+        }
+
+        std::optional<std::string> restoreFile;
+        if (vm.count("restore"))
+        {
+            restoreFile = vm["restore"].as<std::string>();
+        }
+
+        return rwe::runHeadless(
+            vm["data-path"].as<std::vector<std::string>>(),
+            vm["map"].as<std::string>(),
+            vm["schema"].as<unsigned int>(),
+            vm["player"].as<std::vector<std::string>>(),
+            vm["ticks"].as<unsigned int>(),
+            commandFile,
+            cobProfileFile,
+            restoreFile);
+    }
+    catch (const std::exception& e)
+    {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+}
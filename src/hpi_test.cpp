@@ -2,8 +2,10 @@
 #include <fstream>
 #include <iostream>
 #include <memory>
+#include <optional>
 #include <rwe/Hpi.h>
 #include <rwe/overloaded.h>
+#include <rwe/vfs/MappedFile.h>
 #include <string>
 
 namespace fs = boost::filesystem;
@@ -59,16 +61,19 @@ void printFile(unsigned int indent, const std::string& name, const rwe::HpiArchi
 int listCommand(const std::string& filename)
 {
     std::cout << "HPI archive: " << filename << std::endl;
-    std::ifstream file(filename, std::ios::binary);
-
-    if (!file.is_open())
+    std::optional<rwe::MappedFile> file;
+    try
+    {
+        file.emplace(filename);
+    }
+    catch (const std::runtime_error&)
     {
         std::cerr << "Failed to open file." << std::endl;
         return 1;
     }
 
     std::cout << "Opening..." << std::endl;
-    rwe::HpiArchive archive(&file);
+    rwe::HpiArchive archive(file->data(), file->size());
 
     std::cout << "Enumerating contents..." << std::endl;
     printDir(0, "<ROOT>", archive.root());
@@ -79,16 +84,19 @@ int listCommand(const std::string& filename)
 int extractCommand(const std::string& hpiPath, const std::string& filePath, const std::string& destinationPath)
 {
     std::cout << "HPI archive: " << hpiPath << std::endl;
-    std::ifstream file(hpiPath, std::ios::binary);
-
-    if (!file.is_open())
+    std::optional<rwe::MappedFile> file;
+    try
+    {
+        file.emplace(hpiPath);
+    }
+    catch (const std::runtime_error&)
     {
         std::cerr << "Failed to open file." << std::endl;
         return 1;
     }
 
     std::cout << "Opening..." << std::endl;
-    rwe::HpiArchive archive(&file);
+    rwe::HpiArchive archive(file->data(), file->size());
 
     std::cout << "Finding file..." << std::endl;
     auto entry = archive.findFile(filePath);
@@ -138,16 +146,19 @@ void extractRecursive(rwe::HpiArchive& archive, const rwe::HpiArchive::Directory
 int extractAllCommand(const std::string& hpiPath, const std::string& destinationPath)
 {
     std::cout << "HPI archive: " << hpiPath << std::endl;
-    std::ifstream file(hpiPath, std::ios::binary);
-
-    if (!file.is_open())
+    std::optional<rwe::MappedFile> file;
+    try
+    {
+        file.emplace(hpiPath);
+    }
+    catch (const std::runtime_error&)
     {
         std::cerr << "Failed to open file." << std::endl;
         return 1;
     }
 
     std::cout << "Extracting..." << std::endl;
-    rwe::HpiArchive archive(&file);
+    rwe::HpiArchive archive(file->data(), file->size());
 
     for (const auto& e : archive.root().entries)
     {
@@ -18,6 +18,7 @@
 #include <rwe/SceneManager.h>
 #include <rwe/SdlContextManager.h>
 #include <rwe/ShaderService.h>
+#include <rwe/ThreadPool.h>
 #include <rwe/ViewportService.h>
 #include <rwe/config.h>
 #include <rwe/gui.h>
@@ -227,10 +228,12 @@ namespace rwe
         ImGuiContext imGuiContext(imGuiIniPath, window.get(), glContext.get());
 
         logger.info("Initializing virtual file system");
+        // Shared by file loading, path finding and unit scripts.
+        ThreadPool threadPool;
         CompositeVirtualFileSystem vfs;
         for (const auto& path : searchPath)
         {
-            addToVfs(vfs, path.string());
+            addToVfs(vfs, path.string(), &threadPool);
         }
 
         logger.info("Loading palette");
@@ -272,14 +275,13 @@ namespace rwe
 
         // load sound definitions
         logger.info("Loading global sound definitions");
-        auto allSoundBytes = vfs.readFile("gamedata/ALLSOUND.TDF");
+        auto allSoundBytes = vfs.readFileView("gamedata/ALLSOUND.TDF");
         if (!allSoundBytes)
         {
             throw std::runtime_error("Couldn't read ALLSOUND.TDF");
         }
 
-        std::string allSoundString(allSoundBytes->data(), allSoundBytes->size());
-        auto allSoundTdf = parseTdfFromString(allSoundString);
+        auto allSoundTdf = parseTdfFromBytes(allSoundBytes->asStringView());
 
         logger.info("Loading cursors");
         CursorService cursor(
@@ -298,15 +300,14 @@ namespace rwe
         SceneManager sceneManager(sdlContext, window.get(), &graphics, &timeService, &imGuiContext, &cursor, &globalConfig, UiRenderService(&graphics, &shaders, UiCamera(viewportService.width(), viewportService.height())));
 
         logger.info("Loading side data");
-        auto sideDataBytes = vfs.readFile("gamedata/SIDEDATA.TDF");
+        auto sideDataBytes = vfs.readFileView("gamedata/SIDEDATA.TDF");
         if (!sideDataBytes)
         {
             throw std::runtime_error("Missing side data");
         }
-        std::string sideDataString(sideDataBytes->data(), sideDataBytes->size());
         std::unordered_map<std::string, SideData> sideDataMap;
         {
-            auto sideData = parseSidesFromSideData(parseTdfFromString(sideDataString));
+            auto sideData = parseSidesFromSideData(parseTdfFromBytes(sideDataBytes->asStringView()));
             for (auto& side : sideData)
             {
                 std::string name = side.name;
@@ -330,7 +331,8 @@ namespace rwe
             &sceneManager,
             &sideDataMap,
             &timeService,
-            &globalConfig);
+            &globalConfig,
+            &threadPool);
 
         if (gameParameters)
         {
@@ -502,6 +504,8 @@ int main(int argc, char* argv[])
             ("help", "produce help message")
             ("log", po::value<std::string>(), "Sets the log output file path")
             ("state-log", po::value<std::string>(), "Sets the output file for sim-state logs. This is a desync debugging feature.")
+            ("state-log-interval", po::value<unsigned int>()->default_value(1), "Sets the number of ticks between sim-state log entries")
+            ("cob-profile", po::value<std::string>(), "Profiles unit scripts and writes the results to the given .csv or .json file when the game ends")
             ("width", po::value<unsigned int>()->default_value(800), "Sets the window width in pixels")
             ("height", po::value<unsigned int>()->default_value(600), "Sets the window height in pixels")
             ("fullscreen", po::bool_switch(), "Starts the application in fullscreen mode")
@@ -548,6 +552,11 @@ int main(int argc, char* argv[])
                 {
                     gameParameters->stateLogFile = vm["state-log"].as<std::string>();
                 }
+                gameParameters->stateLogInterval = vm["state-log-interval"].as<unsigned int>();
+                if (vm.count("cob-profile"))
+                {
+                    gameParameters->cobProfileFile = vm["cob-profile"].as<std::string>();
+                }
                 gameParameters->localNetworkPort = vm["port"].as<std::string>();
                 unsigned int playerIndex = 0;
                 if (players.size() > 10)
@@ -0,0 +1,176 @@
+#include <chrono>
+#include <iostream>
+#include <random>
+#include <rwe/OccupiedGrid.h>
+#include <rwe/pathfinding/AStarPathFinder.h>
+#include <rwe/pathfinding/FootprintCollisionMap.h>
+#include <rwe/pathfinding/UnitPathFinder.h>
+#include <rwe/pathfinding/pathfinding_utils.h>
+#include <spdlog/sinks/stdout_sinks.h>
+#include <spdlog/spdlog.h>
+#include <string>
+#include <vector>
+
+namespace rwe
+{
+    /**
+     * The unit path finder as it was before it was moved onto GridAStarPathFinder,
+     * kept here as the baseline to measure against.
+     * It searches with the generic AStarPathFinder and its hash-map backed state.
+     */
+    class BaselineUnitPathFinder : public AStarPathFinder<Point, PathCost>
+    {
+    private:
+        const OccupiedGrid* const occupiedGrid;
+        const unsigned int footprintX;
+        const unsigned int footprintZ;
+        const Point goal;
+
+    public:
+        BaselineUnitPathFinder(const OccupiedGrid* occupiedGrid, unsigned int footprintX, unsigned int footprintZ, const Point& goal)
+            : occupiedGrid(occupiedGrid), footprintX(footprintX), footprintZ(footprintZ), goal(goal)
+        {
+        }
+
+    protected:
+        bool isGoal(const Point& vertex) override
+        {
+            return vertex == goal;
+        }
+
+        PathCost estimateCostToGoal(const Point& start) override
+        {
+            auto distance = octileDistance(start, goal);
+            unsigned int turns = (distance.straight > 0 && distance.diagonal > 0) ? 1 : 0;
+            return PathCost(distance, turns);
+        }
+
+        std::vector<VertexInfo> getSuccessors(const VertexInfo& info) override
+        {
+            std::optional<Direction> prevDirection;
+            if (info.predecessor)
+            {
+                prevDirection = pointToDirection(info.vertex - (*info.predecessor)->vertex);
+            }
+
+            std::vector<VertexInfo> vs;
+            for (auto direction : Directions)
+            {
+                auto neighbour = info.vertex + directionToPoint(direction);
+                if (isCollisionAt(*occupiedGrid, DiscreteRect(neighbour.x, neighbour.y, footprintX, footprintZ), UnitId(0)))
+                {
+                    continue;
+                }
+
+                auto distance = octileDistance(info.vertex, neighbour);
+                if (isAdjacentToObstacle(*occupiedGrid, DiscreteRect(neighbour.x, neighbour.y, footprintX, footprintZ)))
+                {
+                    distance = distance + distance;
+                }
+                unsigned int turns = (!prevDirection || direction == *prevDirection) ? 0 : 1;
+                vs.push_back(VertexInfo{info.costToReach + PathCost(distance, turns), neighbour, &info});
+            }
+
+            return vs;
+        }
+    };
+
+    OccupiedGrid createRandomGrid(std::mt19937& rng, std::size_t size, float obstacleDensity)
+    {
+        OccupiedGrid grid(size, size, OccupiedCell());
+        std::bernoulli_distribution isObstacle(obstacleDensity);
+        for (std::size_t y = 0; y < size; ++y)
+        {
+            for (std::size_t x = 0; x < size; ++x)
+            {
+                if (isObstacle(rng))
+                {
+                    grid.set(x, y, OccupiedCell::fromFeature(FeatureId(0)));
+                }
+            }
+        }
+        return grid;
+    }
+
+    template <typename Func>
+    double timeSearches(const std::vector<std::pair<Point, Point>>& queries, Func&& search)
+    {
+        auto start = std::chrono::steady_clock::now();
+        for (const auto& q : queries)
+        {
+            search(q.first, q.second);
+        }
+        auto end = std::chrono::steady_clock::now();
+        return std::chrono::duration<double, std::milli>(end - start).count();
+    }
+
+    int benchCommand(std::size_t gridSize, std::size_t searchCount, float obstacleDensity, unsigned int footprint)
+    {
+        std::mt19937 rng(1234);
+        auto grid = createRandomGrid(rng, gridSize, obstacleDensity);
+
+        std::uniform_int_distribution<int> coord(0, static_cast<int>(gridSize - footprint));
+        std::vector<std::pair<Point, Point>> queries;
+        while (queries.size() < searchCount)
+        {
+            Point start(coord(rng), coord(rng));
+            Point goal(coord(rng), coord(rng));
+            if (isCollisionAt(grid, DiscreteRect(start.x, start.y, footprint, footprint)))
+            {
+                continue;
+            }
+            queries.emplace_back(start, goal);
+        }
+
+        std::vector<std::vector<Point>> baselinePaths;
+        auto baselineTime = timeSearches(queries, [&](const Point& start, const Point& goal) {
+            BaselineUnitPathFinder finder(&grid, footprint, footprint, goal);
+            baselinePaths.push_back(finder.findPath(start).path);
+        });
+
+        std::vector<std::vector<Point>> gridPaths;
+        auto gridTime = timeSearches(queries, [&](const Point& start, const Point& goal) {
+            UnitPathFinder finder(&grid, nullptr, nullptr, UnitId(0), DiscreteRect(0, 0, 0, 0), footprint, footprint, goal);
+            gridPaths.push_back(finder.findPath(start).path);
+        });
+
+        FootprintCollisionMap collisionMap(grid, footprint, footprint);
+        std::vector<std::vector<Point>> collisionMapPaths;
+        auto collisionMapTime = timeSearches(queries, [&](const Point& start, const Point& goal) {
+            UnitPathFinder finder(&grid, &collisionMap, nullptr, UnitId(0), DiscreteRect(0, 0, 0, 0), footprint, footprint, goal);
+            collisionMapPaths.push_back(finder.findPath(start).path);
+        });
+
+        std::cout << "Grid " << gridSize << "x" << gridSize << ", " << searchCount << " searches, obstacle density " << obstacleDensity << ", footprint " << footprint << std::endl;
+        std::cout << "  AStarPathFinder:     " << baselineTime << " ms (" << (baselineTime / searchCount) << " ms/search)" << std::endl;
+        std::cout << "  GridAStarPathFinder: " << gridTime << " ms (" << (gridTime / searchCount) << " ms/search)" << std::endl;
+        std::cout << "  + collision map:     " << collisionMapTime << " ms (" << (collisionMapTime / searchCount) << " ms/search)" << std::endl;
+
+        if (baselinePaths != gridPaths || baselinePaths != collisionMapPaths)
+        {
+            std::cerr << "Path finders disagreed on the resulting paths" << std::endl;
+            return 1;
+        }
+
+        return 0;
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    auto logger = spdlog::stderr_logger_mt("rwe");
+    logger->set_level(spdlog::level::warn);
+
+    std::size_t gridSize = argc > 1 ? std::stoul(argv[1]) : 256;
+    std::size_t searchCount = argc > 2 ? std::stoul(argv[2]) : 500;
+    float obstacleDensity = argc > 3 ? std::stof(argv[3]) : 0.2f;
+    unsigned int footprint = argc > 4 ? std::stoul(argv[4]) : 2;
+
+    if (footprint == 0 || gridSize < footprint + 2 || searchCount == 0)
+    {
+        std::cerr << "Usage: pathfinding_bench [grid size] [search count] [obstacle density] [footprint size]" << std::endl;
+        return 1;
+    }
+
+    return rwe::benchCommand(gridSize, searchCount, obstacleDensity, footprint);
+}
@@ -3,6 +3,7 @@
 #include <functional>
 #include <memory>
 #include <rwe/SdlContextManager.h>
+#include <rwe/SoundHandle.h>
 #include <rwe/observable/Subject.h>
 #include <rwe/vfs/AbstractVirtualFileSystem.h>
 #include <unordered_map>
@@ -13,7 +14,7 @@ namespace rwe
     {
     public:
         using Sound = Mix_Chunk;
-        using SoundHandle = std::shared_ptr<Sound>;
+        using SoundHandle = rwe::SoundHandle;
 
         class LoopToken
         {
@@ -1,8 +1,25 @@
 #include "Cob.h"
+#include <algorithm>
 #include <rwe/io_utils.h>
 
 namespace rwe
 {
+    CobEntryPointTable resolveCobEntryPoints(const std::vector<CobFunctionInfo>& functions)
+    {
+        CobEntryPointTable table;
+        for (unsigned int i = 0; i < CobEntryPointCount; ++i)
+        {
+            auto name = getCobEntryPointName(static_cast<CobEntryPoint>(i));
+            auto it = std::find_if(functions.begin(), functions.end(), [name](const auto& f) { return f.name == name; });
+            if (it != functions.end())
+            {
+                table[i] = static_cast<unsigned int>(it - functions.begin());
+            }
+        }
+
+        return table;
+    }
+
     CobScript parseCob(std::istream& stream)
     {
         auto header = readRaw<CobHeader>(stream);
@@ -50,6 +67,9 @@ namespace rwe
             stream.seekg(loc);
         }
 
+        script.decodedInstructions = decodeCobInstructions(script.instructions);
+        script.entryPoints = resolveCobEntryPoints(script.functions);
+
         return script;
     }
 }
@@ -1,6 +1,10 @@
 #pragma once
 
+#include <array>
 #include <cstdint>
+#include <optional>
+#include <rwe/cob/CobEntryPoint.h>
+#include <rwe/cob/CobInstruction.h>
 #include <string>
 #include <vector>
 
@@ -29,13 +33,28 @@ namespace rwe
         unsigned int address;
     };
 
+    /**
+     * For each entry point, the index of the function that implements it,
+     * or nullopt if the script doesn't have one.
+     */
+    using CobEntryPointTable = std::array<std::optional<unsigned int>, CobEntryPointCount>;
+
     struct CobScript
     {
         std::vector<uint32_t> instructions;
         std::vector<std::string> pieces;
         std::vector<CobFunctionInfo> functions;
         unsigned int staticVariableCount;
+
+        /** instructions, decoded ahead of time for the interpreter. */
+        std::vector<CobInstruction> decodedInstructions;
+
+        /** functions that implement entry points, resolved ahead of time. */
+        CobEntryPointTable entryPoints;
     };
 
+    /** Finds the functions that implement each entry point, matching names exactly. */
+    CobEntryPointTable resolveCobEntryPoints(const std::vector<CobFunctionInfo>& functions);
+
     CobScript parseCob(std::istream& stream);
 }
@@ -0,0 +1,165 @@
+#include "FixedSimScalar.h"
+#include <algorithm>
+#include <array>
+#include <cmath>
+
+namespace rwe
+{
+    static constexpr unsigned int QuarterTurnSteps = 16384;
+    static constexpr unsigned int EighthTurnSteps = 8192;
+
+    /**
+     * sin for each step of the first quarter turn, inclusive of both ends.
+     * Built with integer arithmetic only, rather than std::sin,
+     * so that it comes out the same regardless of the platform's libm.
+     */
+    static std::array<std::int32_t, QuarterTurnSteps + 1> buildQuarterSineTable()
+    {
+        // Taylor series evaluated with 30 fractional bits.
+        constexpr std::int64_t OneQ30 = std::int64_t(1) << 30;
+        constexpr std::int64_t HalfPiQ30 = 1686629713; // pi/2 * 2^30
+
+        std::array<std::int32_t, QuarterTurnSteps + 1> table;
+        for (std::int64_t i = 0; i <= QuarterTurnSteps; ++i)
+        {
+            auto x = (i * HalfPiQ30) / QuarterTurnSteps;
+            auto x2 = (x * x) / OneQ30;
+
+            auto term = x;
+            auto sum = x;
+            for (std::int64_t k = 1; k <= 10; ++k)
+            {
+                term = -((term * x2) / OneQ30) / ((2 * k) * (2 * k + 1));
+                sum += term;
+            }
+
+            // round from 30 to 16 fractional bits
+            table[i] = static_cast<std::int32_t>((sum + (std::int64_t(1) << 13)) >> 14);
+        }
+
+        return table;
+    }
+
+    static const std::array<std::int32_t, QuarterTurnSteps + 1>& getQuarterSineTable()
+    {
+        static const auto table = buildQuarterSineTable();
+        return table;
+    }
+
+    /**
+     * Integer square root, rounded down. Requires n < 2^63.
+     *
+     * The floating-point sqrt is only used as a first guess.
+     * The guess is then corrected with exact integer comparisons,
+     * so the result does not depend on how the platform rounds.
+     */
+    static std::uint64_t isqrt(std::uint64_t n)
+    {
+        auto result = static_cast<std::uint64_t>(std::sqrt(static_cast<double>(n)));
+        while (result * result > n)
+        {
+            --result;
+        }
+        while ((result + 1) * (result + 1) <= n)
+        {
+            ++result;
+        }
+
+        return result;
+    }
+
+    FixedSimScalar sqrt(FixedSimScalar s)
+    {
+        if (s.value <= 0)
+        {
+            return FixedSimScalar::fromRaw(0);
+        }
+
+        return FixedSimScalar::fromRaw(static_cast<std::int64_t>(isqrt(static_cast<std::uint64_t>(s.value) << FixedSimScalar::FractionalBits)));
+    }
+
+    FixedSimScalar fixedSin(std::uint16_t angle)
+    {
+        const auto& table = getQuarterSineTable();
+        unsigned int offset = angle % QuarterTurnSteps;
+        switch (angle / QuarterTurnSteps)
+        {
+            case 0:
+                return FixedSimScalar::fromRaw(table[offset]);
+            case 1:
+                return FixedSimScalar::fromRaw(table[QuarterTurnSteps - offset]);
+            case 2:
+                return FixedSimScalar::fromRaw(-table[offset]);
+            default:
+                return FixedSimScalar::fromRaw(-table[QuarterTurnSteps - offset]);
+        }
+    }
+
+    FixedSimScalar fixedCos(std::uint16_t angle)
+    {
+        return fixedSin(static_cast<std::uint16_t>(angle + QuarterTurnSteps));
+    }
+
+    /**
+     * Returns the angle in [0, EighthTurnSteps] whose tangent is nearest to y/x.
+     * Requires 0 <= y <= x and x > 0, with both below 2^31.
+     */
+    static std::int64_t firstOctantAtan(std::int64_t y, std::int64_t x)
+    {
+        const auto& table = getQuarterSineTable();
+
+        // y*cos(a) - x*sin(a) decreases as a increases across the octant
+        // and crosses zero at the answer.
+        auto residual = [&](std::int64_t a) { return y * table[QuarterTurnSteps - a] - x * table[a]; };
+
+        // Start from a floating-point estimate, which is usually exact,
+        // then walk to the last step at or before the crossing.
+        // The walk only looks at the table, so the result
+        // does not depend on the platform's atan.
+        auto estimate = std::atan(static_cast<double>(y) / static_cast<double>(x)) * (QuarterTurnSteps * 2 / 3.14159265358979323846);
+        auto lo = std::clamp<std::int64_t>(static_cast<std::int64_t>(estimate), 0, EighthTurnSteps - 1);
+        while (lo > 0 && residual(lo) < 0)
+        {
+            --lo;
+        }
+        while (lo < EighthTurnSteps - 1 && residual(lo + 1) >= 0)
+        {
+            ++lo;
+        }
+
+        auto hi = lo + 1;
+        return residual(lo) <= -residual(hi) ? lo : hi;
+    }
+
+    std::uint16_t fixedAtan2(FixedSimScalar y, FixedSimScalar x)
+    {
+        auto ay = y.value < 0 ? -y.value : y.value;
+        auto ax = x.value < 0 ? -x.value : x.value;
+        if (ax == 0 && ay == 0)
+        {
+            return 0;
+        }
+
+        // Only the ratio matters, so bring both into range for the multiplications.
+        while (ax >= (std::int64_t(1) << 31) || ay >= (std::int64_t(1) << 31))
+        {
+            ax >>= 1;
+            ay >>= 1;
+        }
+
+        auto angle = ay <= ax
+            ? firstOctantAtan(ay, ax)
+            : QuarterTurnSteps - firstOctantAtan(ax, ay);
+
+        if (x.value < 0)
+        {
+            angle = 2 * QuarterTurnSteps - angle;
+        }
+        if (y.value < 0)
+        {
+            angle = -angle;
+        }
+
+        return static_cast<std::uint16_t>(angle & 0xFFFF);
+    }
+}
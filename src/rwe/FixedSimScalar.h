@@ -0,0 +1,124 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <rwe/OpaqueId.h>
+#include <rwe/fixed_point.h>
+#include <type_traits>
+
+namespace rwe
+{
+    struct SimScalarTag;
+
+    /**
+     * A fixed-point number with 16 fractional bits,
+     * the same resolution as the 16.16 values used by COB scripts,
+     * stored in 64 bits so that squared world distances don't overflow.
+     *
+     * All arithmetic is integer arithmetic,
+     * so results are bit-identical on every compiler and CPU.
+     * The value field holds the raw representation,
+     * i.e. the number multiplied by One.
+     */
+    struct FixedSimScalar : public OpaqueId<std::int64_t, SimScalarTag>
+    {
+        static constexpr unsigned int FractionalBits = FixedPointFractionalBits;
+        static constexpr std::int64_t One = std::int64_t(1) << FractionalBits;
+
+        static constexpr FixedSimScalar fromRaw(std::int64_t raw)
+        {
+            return FixedSimScalar(RawTag(), raw);
+        }
+
+        FixedSimScalar() = default;
+
+        template <typename T, std::enable_if_t<std::is_integral_v<T>, int> = 0>
+        explicit constexpr FixedSimScalar(T v) : OpaqueId<std::int64_t, SimScalarTag>(static_cast<std::int64_t>(v) * One)
+        {
+        }
+
+        /** Rounds to the nearest representable value, halves away from zero. */
+        template <typename T, std::enable_if_t<std::is_floating_point_v<T>, int> = 0>
+        explicit constexpr FixedSimScalar(T v)
+            : OpaqueId<std::int64_t, SimScalarTag>(static_cast<std::int64_t>(v * static_cast<T>(One) + (v < 0 ? T(-0.5) : T(0.5))))
+        {
+        }
+
+        bool operator<(FixedSimScalar b) const { return value < b.value; }
+        bool operator>(FixedSimScalar b) const { return value > b.value; }
+        bool operator<=(FixedSimScalar b) const { return value <= b.value; }
+        bool operator>=(FixedSimScalar b) const { return value >= b.value; }
+
+        FixedSimScalar operator+(FixedSimScalar b) const { return fromRaw(value + b.value); }
+        FixedSimScalar& operator+=(FixedSimScalar b)
+        {
+            value += b.value;
+            return *this;
+        }
+        FixedSimScalar operator-() const { return fromRaw(-value); }
+        FixedSimScalar operator-(FixedSimScalar b) const { return fromRaw(value - b.value); }
+        FixedSimScalar& operator-=(FixedSimScalar b)
+        {
+            value -= b.value;
+            return *this;
+        }
+        FixedSimScalar operator%(FixedSimScalar b) const { return fromRaw(value % b.value); }
+
+        /** Rounds towards negative infinity. */
+        FixedSimScalar operator*(FixedSimScalar b) const { return fromRaw((value * b.value) >> FractionalBits); }
+        FixedSimScalar& operator*=(FixedSimScalar b) { return *this = *this * b; }
+
+        /**
+         * Rounds towards zero.
+         * Division by zero saturates, as the float backend goes to infinity.
+         */
+        FixedSimScalar operator/(FixedSimScalar b) const
+        {
+            if (b.value == 0)
+            {
+                return fromRaw(value < 0 ? std::numeric_limits<std::int64_t>::min() : std::numeric_limits<std::int64_t>::max());
+            }
+            return fromRaw((value * One) / b.value);
+        }
+        FixedSimScalar& operator/=(FixedSimScalar b) { return *this = *this / b; }
+
+    private:
+        struct RawTag
+        {
+        };
+
+        constexpr FixedSimScalar(RawTag, std::int64_t raw) : OpaqueId<std::int64_t, SimScalarTag>(raw)
+        {
+        }
+    };
+
+    FixedSimScalar sqrt(FixedSimScalar s);
+
+    /**
+     * Returns sin of the given angle,
+     * where the angle is given in 1/65536ths of a full turn.
+     */
+    FixedSimScalar fixedSin(std::uint16_t angle);
+
+    FixedSimScalar fixedCos(std::uint16_t angle);
+
+    /**
+     * Returns the angle of the vector (x, y) anticlockwise from the x axis,
+     * in 1/65536ths of a full turn, rounded to the nearest step.
+     * Returns 0 if both are 0.
+     */
+    std::uint16_t fixedAtan2(FixedSimScalar y, FixedSimScalar x);
+}
+
+namespace std
+{
+    template <>
+    struct hash<rwe::FixedSimScalar>
+    {
+        std::size_t operator()(const rwe::FixedSimScalar& f) const noexcept
+        {
+            return std::hash<std::int64_t>()(f.value);
+        }
+    };
+}
@@ -1,4 +1,5 @@
 #include "GameHash_util.h"
+#include <cstring>
 
 namespace rwe
 {
@@ -27,24 +28,36 @@ namespace rwe
         return GameHash(static_cast<uint32_t>(i));
     }
 
-    GameHash computeHashOf(const std::string& s)
+    GameHash computeHashOf(int64_t i)
+    {
+        return GameHash(static_cast<uint32_t>(i));
+    }
+
+    /**
+     * 32-bit FNV-1a.
+     * Unlike summing the characters,
+     * this is sensitive to their order and spreads short strings
+     * across the whole hash range.
+     */
+    uint32_t hashBytes(const char* begin, const char* end)
     {
-        uint32_t sum = 0;
-        for (const char& c : s)
+        uint32_t hash = 2166136261u;
+        for (auto it = begin; it != end; ++it)
         {
-            sum += c;
+            hash ^= static_cast<unsigned char>(*it);
+            hash *= 16777619u;
         }
-        return GameHash(sum);
+        return hash;
+    }
+
+    GameHash computeHashOf(const std::string& s)
+    {
+        return GameHash(hashBytes(s.data(), s.data() + s.size()));
     }
 
     GameHash computeHashOf(const char* s)
     {
-        uint32_t sum = 0;
-        for (; *s != '\0'; ++s)
-        {
-            sum += *s;
-        }
-        return GameHash(sum);
+        return GameHash(hashBytes(s, s + std::strlen(s)));
     }
 
     GameHash computeHashOf(const GamePlayerInfo& p)
@@ -106,18 +119,12 @@ namespace rwe
 
     GameHash computeHashOf(const Projectile& projectile)
     {
-        GameHash h = combineHashes(
+        return combineHashes(
+            projectile.weapon->weaponType,
             projectile.owner,
             projectile.position,
             projectile.origin,
-            projectile.velocity,
-            projectile.damageRadius);
-
-        for (const auto& [_, damage] : projectile.damage)
-        {
-            h += computeHashOf(damage);
-        }
-        return h;
+            projectile.velocity);
     }
 
     GameHash computeHashOf(const IdleState&)
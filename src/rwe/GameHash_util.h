@@ -17,6 +17,8 @@ namespace rwe
 
     GameHash computeHashOf(int32_t i);
 
+    GameHash computeHashOf(int64_t i);
+
     GameHash computeHashOf(const std::string& s);
 
     GameHash computeHashOf(const char* s);
@@ -0,0 +1,42 @@
+#include "GameParameters.h"
+#include <algorithm>
+#include <iterator>
+#include <vector>
+
+namespace rwe
+{
+    GameParameters::GameParameters(const std::string& mapName, unsigned int schemaIndex)
+        : mapName(mapName),
+          schemaIndex(schemaIndex)
+    {
+    }
+
+    std::seed_seq seedFromGameParameters(const GameParameters& params)
+    {
+        std::vector<unsigned int> initialVec;
+        std::copy(params.mapName.begin(), params.mapName.end(), std::back_inserter(initialVec));
+
+        for (const auto& e : params.players)
+        {
+            if (!e)
+            {
+                initialVec.push_back(0);
+                continue;
+            }
+
+            initialVec.push_back(e->color.value);
+            initialVec.push_back(e->energy.value);
+            initialVec.push_back(e->metal.value);
+            if (e->name)
+            {
+                std::copy(e->name->begin(), e->name->end(), std::back_inserter(initialVec));
+            }
+            else
+            {
+                initialVec.push_back(0);
+            }
+        }
+
+        return std::seed_seq(initialVec.begin(), initialVec.end());
+    }
+}
@@ -0,0 +1,78 @@
+#pragma once
+
+#include <array>
+#include <optional>
+#include <random>
+#include <rwe/Energy.h>
+#include <rwe/Metal.h>
+#include <rwe/PlayerColorIndex.h>
+#include <string>
+#include <utility>
+#include <variant>
+
+namespace rwe
+{
+    struct PlayerControllerTypeHuman
+    {
+    };
+    struct PlayerControllerTypeComputer
+    {
+    };
+    struct PlayerControllerTypeNetwork
+    {
+        std::string host;
+        std::string port;
+    };
+
+    using PlayerControllerType = std::variant<PlayerControllerTypeHuman, PlayerControllerTypeComputer, PlayerControllerTypeNetwork>;
+
+    class IsHumanVisitor
+    {
+    public:
+        bool operator()(const PlayerControllerTypeHuman&) const { return true; }
+        bool operator()(const PlayerControllerTypeComputer&) const { return false; }
+        bool operator()(const PlayerControllerTypeNetwork&) const { return false; }
+    };
+
+    class IsComputerVisitor
+    {
+    public:
+        bool operator()(const PlayerControllerTypeHuman&) const { return false; }
+        bool operator()(const PlayerControllerTypeComputer&) const { return true; }
+        bool operator()(const PlayerControllerTypeNetwork&) const { return false; }
+    };
+
+    class GetNetworkAddressVisitor
+    {
+    public:
+        std::optional<std::pair<std::reference_wrapper<const std::string>, std::reference_wrapper<const std::string>>> operator()(const PlayerControllerTypeHuman&) const { return std::nullopt; }
+        std::optional<std::pair<std::reference_wrapper<const std::string>, std::reference_wrapper<const std::string>>> operator()(const PlayerControllerTypeComputer&) const { return std::nullopt; }
+        std::optional<std::pair<std::reference_wrapper<const std::string>, std::reference_wrapper<const std::string>>> operator()(const PlayerControllerTypeNetwork& p) const { return std::make_pair(std::cref(p.host), std::cref(p.port)); }
+    };
+
+    struct PlayerInfo
+    {
+        std::optional<std::string> name;
+        PlayerControllerType controller;
+        std::string side;
+        PlayerColorIndex color;
+
+        Metal metal;
+        Energy energy;
+    };
+
+    struct GameParameters
+    {
+        std::string mapName;
+        unsigned int schemaIndex;
+        std::array<std::optional<PlayerInfo>, 10> players;
+        std::string localNetworkPort{"1337"};
+        std::optional<std::string> stateLogFile;
+        unsigned int stateLogInterval{1};
+        std::optional<std::string> cobProfileFile;
+
+        GameParameters(const std::string& mapName, unsigned int schemaIndex);
+    };
+
+    std::seed_seq seedFromGameParameters(const GameParameters& params);
+}
@@ -4,9 +4,10 @@
 #include <fstream>
 #include <functional>
 #include <rwe/Mesh.h>
-#include <rwe/dump_util.h>
 #include <rwe/overloaded.h>
 #include <rwe/resource_io.h>
+#include <rwe/snapshot/SimulationSnapshot.h>
+#include <rwe/snapshot/snapshot_io.h>
 #include <rwe/ui/UiStagedButton.h>
 #include <spdlog/spdlog.h>
 #include <unordered_set>
@@ -18,68 +19,6 @@ namespace rwe
         return Line3x<SimScalar>(floatToSimVector(line.start), floatToSimVector(line.end));
     }
 
-    bool projectileCollides(const GameSimulation& sim, const Projectile& projectile, const OccupiedCell& cellValue)
-    {
-        auto collidesWithOccupiedCell = match(
-            cellValue.occupiedType,
-            [&](const OccupiedUnit& v) {
-                const auto& unit = sim.getUnit(v.id);
-
-                if (unit.isOwnedBy(projectile.owner))
-                {
-                    return false;
-                }
-
-                // ignore if the projectile is above or below the unit
-                if (projectile.position.y < unit.position.y || projectile.position.y > unit.position.y + unit.height)
-                {
-                    return false;
-                }
-
-                return true;
-            },
-            [&](const OccupiedFeature& v) {
-                const auto& feature = sim.getFeature(v.id);
-
-                // ignore if the projectile is above or below the feature
-                if (projectile.position.y < feature.position.y || projectile.position.y > feature.position.y + feature.height)
-                {
-                    return false;
-                }
-
-                return true;
-            },
-
-            [&](const OccupiedNone&) {
-                return false;
-            });
-
-        if (collidesWithOccupiedCell)
-        {
-            return true;
-        }
-
-        if (cellValue.buildingCell && !cellValue.buildingCell->passable)
-        {
-            const auto& unit = sim.getUnit(cellValue.buildingCell->unit);
-
-            if (unit.isOwnedBy(projectile.owner))
-            {
-                return false;
-            }
-
-            // ignore if the projectile is above or below the unit
-            if (projectile.position.y < unit.position.y || projectile.position.y > unit.position.y + unit.height)
-            {
-                return false;
-            }
-
-            return true;
-        }
-
-        return false;
-    }
-
     const Rectangle2f GameScene::minimapViewport = Rectangle2f::fromTopLeft(0.0f, 0.0f, GuiSizeLeft, GuiSizeLeft);
 
     GameScene::GameScene(
@@ -100,7 +39,9 @@ namespace rwe
         const std::shared_ptr<SpriteSeries>& guiFont,
         PlayerId localPlayerId,
         TdfBlock* audioLookup,
-        std::optional<std::ofstream>&& stateLogStream)
+        std::optional<std::ofstream>&& stateLogStream,
+        unsigned int stateLogInterval,
+        const std::optional<std::string>& cobProfileFile)
         : sceneContext(sceneContext),
           worldViewport(ViewportService(GuiSizeLeft, GuiSizeTop, sceneContext.viewportService->width() - GuiSizeLeft - GuiSizeRight, sceneContext.viewportService->height() - GuiSizeTop - GuiSizeBottom)),
           playerCommandService(std::move(playerCommandService)),
@@ -111,9 +52,7 @@ namespace rwe
           collisionService(std::move(collisionService)),
           unitFactory(sceneContext.textureService, std::move(unitDatabase), std::move(meshService), &this->collisionService, sceneContext.palette, sceneContext.guiPalette),
           gameNetworkService(std::move(gameNetworkService)),
-          pathFindingService(&this->simulation, &this->collisionService),
-          cobExecutionService(),
-          unitBehaviorService(this, &this->unitFactory, &this->cobExecutionService),
+          simulationDriver(&this->simulation, &this->collisionService, &this->unitFactory, sceneContext.textureService, sceneContext.threadPool),
           minimap(minimap),
           minimapDots(minimapDots),
           minimapDotHighlight(minimapDotHighlight),
@@ -122,8 +61,36 @@ namespace rwe
           guiFont(guiFont),
           localPlayerId(localPlayerId),
           uiFactory(sceneContext.textureService, sceneContext.audioService, audioLookup, sceneContext.vfs, sceneContext.viewportService->width(), sceneContext.viewportService->height()),
-          stateLogStream(std::move(stateLogStream))
+          stateLogStream(std::move(stateLogStream)),
+          stateLogInterval(std::max(stateLogInterval, 1u)),
+          cobProfileFile(cobProfileFile)
     {
+        if (this->stateLogStream)
+        {
+            stateLogWriter.emplace(&*this->stateLogStream, StateLogKeyframeInterval);
+        }
+
+        if (this->cobProfileFile)
+        {
+            simulationDriver.setCobProfilingEnabled(true);
+        }
+    }
+
+    GameScene::~GameScene()
+    {
+        if (!cobProfileFile)
+        {
+            return;
+        }
+
+        try
+        {
+            saveCobProfile(*cobProfileFile, simulationDriver.getCobProfiler().getEntries());
+        }
+        catch (const std::exception& e)
+        {
+            spdlog::get("rwe")->error("Failed to write cob profile: {0}", e.what());
+        }
     }
 
     void GameScene::init()
@@ -485,7 +452,7 @@ namespace rwe
 
         if (pathfindingVisualisationVisible)
         {
-            worldRenderService.drawPathfindingVisualisation(simulation.terrain, pathFindingService.lastPathDebugInfo);
+            worldRenderService.drawPathfindingVisualisation(simulation.terrain, simulationDriver.getPathFindingService().lastPathDebugInfo);
         }
 
         if (auto selectedUnit = getSingleSelectedUnit(); selectedUnit && movementClassGridVisible)
@@ -687,12 +654,77 @@ namespace rwe
             ImGui::SetKeyboardFocusHere(-1);
         }
         ImGui::Separator();
+        renderCobProfile();
+        ImGui::Separator();
         std::scoped_lock<std::mutex> lock(playingUnitChannelsLock);
         ImGui::LabelText("Unit sounds", "%d", playingUnitChannels.size());
         ImGui::LabelText("Sound volume", "%d", computeSoundVolume(playingUnitChannels.size()));
         ImGui::End();
     }
 
+    void GameScene::renderCobProfile()
+    {
+        auto profilingEnabled = simulationDriver.isCobProfilingEnabled();
+        if (ImGui::Checkbox("Cob profiler", &profilingEnabled))
+        {
+            simulationDriver.setCobProfilingEnabled(profilingEnabled);
+        }
+        ImGui::SameLine();
+        if (ImGui::Button("Reset"))
+        {
+            simulationDriver.clearCobProfile();
+        }
+
+        auto entries = simulationDriver.getCobProfiler().getEntries();
+        if (entries.empty())
+        {
+            return;
+        }
+
+        ImGui::Columns(8, "cob profile");
+        ImGui::Text("Unit");
+        ImGui::NextColumn();
+        ImGui::Text("Function");
+        ImGui::NextColumn();
+        ImGui::Text("Time (ms)");
+        ImGui::NextColumn();
+        ImGui::Text("Instructions");
+        ImGui::NextColumn();
+        ImGui::Text("Runs");
+        ImGui::NextColumn();
+        ImGui::Text("Threads");
+        ImGui::NextColumn();
+        ImGui::Text("Polls");
+        ImGui::NextColumn();
+        ImGui::Text("Signals");
+        ImGui::NextColumn();
+        ImGui::Separator();
+
+        // the slowest functions are first, so only show the ones worth looking at
+        auto shownCount = std::min<std::size_t>(entries.size(), 20);
+        for (std::size_t i = 0; i < shownCount; ++i)
+        {
+            const auto& e = entries[i];
+            ImGui::Text("%s", e.unitType.c_str());
+            ImGui::NextColumn();
+            ImGui::Text("%s", e.functionName.c_str());
+            ImGui::NextColumn();
+            ImGui::Text("%.2f", std::chrono::duration<double, std::milli>(e.profile.time).count());
+            ImGui::NextColumn();
+            ImGui::Text("%llu", static_cast<unsigned long long>(e.profile.instructions));
+            ImGui::NextColumn();
+            ImGui::Text("%llu", static_cast<unsigned long long>(e.profile.runs));
+            ImGui::NextColumn();
+            ImGui::Text("%llu", static_cast<unsigned long long>(e.profile.threadsCreated));
+            ImGui::NextColumn();
+            ImGui::Text("%llu", static_cast<unsigned long long>(e.profile.blockedPolls));
+            ImGui::NextColumn();
+            ImGui::Text("%llu", static_cast<unsigned long long>(e.profile.signalsSent));
+            ImGui::NextColumn();
+        }
+        ImGui::Columns(1);
+    }
+
     void GameScene::onKeyDown(const SDL_Keysym& keysym)
     {
         currentPanel->keyDown(KeyEvent(keysym.sym));
@@ -1385,32 +1417,12 @@ namespace rwe
 
     std::optional<UnitId> GameScene::spawnUnit(const std::string& unitType, PlayerId owner, const SimVector& position)
     {
-        // TODO: if we failed to add the unit throw some warning
-        auto unitId = simulation.tryAddUnit(
-            unitFactory.createUnit(unitType, owner, simulation.getPlayer(owner).color, position));
-
-        if (unitId)
-        {
-            unitBehaviorService.onCreate(*unitId);
-
-            // initialise local-player-specific UI data
-            const auto& unit = getUnit(*unitId);
-            unitGuiInfos.insert_or_assign(*unitId, UnitGuiInfo{unit.builder ? UnitGuiInfo::Section::Build : UnitGuiInfo::Section::Orders, 0});
-        }
-
-        return unitId;
+        return simulationDriver.spawnUnit(unitType, owner, position);
     }
 
     void GameScene::spawnCompletedUnit(const std::string& unitType, PlayerId owner, const SimVector& position)
     {
-        auto unitId = spawnUnit(unitType, owner, position);
-        if (unitId)
-        {
-            auto& unit = getUnit(*unitId);
-            // units start as unbuilt nanoframes,
-            // we we need to convert it immediately into a completed unit.
-            unit.finishBuilding();
-        }
+        simulationDriver.spawnCompletedUnit(unitType, owner, position);
     }
 
     void GameScene::setCameraPosition(const Vector3f& newPosition)
@@ -1423,45 +1435,45 @@ namespace rwe
         return simulation.terrain;
     }
 
-    void GameScene::showObject(UnitId unitId, const std::string& name)
+    void GameScene::showObject(UnitId unitId, unsigned int pieceId)
     {
-        simulation.showObject(unitId, name);
+        simulation.showObject(unitId, pieceId);
     }
 
-    void GameScene::hideObject(UnitId unitId, const std::string& name)
+    void GameScene::hideObject(UnitId unitId, unsigned int pieceId)
     {
-        simulation.hideObject(unitId, name);
+        simulation.hideObject(unitId, pieceId);
     }
 
     void
-    GameScene::moveObject(UnitId unitId, const std::string& name, Axis axis, SimScalar position, SimScalar speed)
+    GameScene::moveObject(UnitId unitId, unsigned int pieceId, Axis axis, SimScalar position, SimScalar speed)
     {
-        simulation.moveObject(unitId, name, axis, position, speed);
+        simulation.moveObject(unitId, pieceId, axis, position, speed);
     }
 
-    void GameScene::moveObjectNow(UnitId unitId, const std::string& name, Axis axis, SimScalar position)
+    void GameScene::moveObjectNow(UnitId unitId, unsigned int pieceId, Axis axis, SimScalar position)
     {
-        simulation.moveObjectNow(unitId, name, axis, position);
+        simulation.moveObjectNow(unitId, pieceId, axis, position);
     }
 
-    void GameScene::turnObject(UnitId unitId, const std::string& name, Axis axis, SimAngle angle, SimScalar speed)
+    void GameScene::turnObject(UnitId unitId, unsigned int pieceId, Axis axis, SimAngle angle, SimScalar speed)
     {
-        simulation.turnObject(unitId, name, axis, angle, speed);
+        simulation.turnObject(unitId, pieceId, axis, angle, speed);
     }
 
-    void GameScene::turnObjectNow(UnitId unitId, const std::string& name, Axis axis, SimAngle angle)
+    void GameScene::turnObjectNow(UnitId unitId, unsigned int pieceId, Axis axis, SimAngle angle)
     {
-        simulation.turnObjectNow(unitId, name, axis, angle);
+        simulation.turnObjectNow(unitId, pieceId, axis, angle);
     }
 
-    bool GameScene::isPieceMoving(UnitId unitId, const std::string& name, Axis axis) const
+    bool GameScene::isPieceMoving(UnitId unitId, unsigned int pieceId, Axis axis) const
     {
-        return simulation.isPieceMoving(unitId, name, axis);
+        return simulation.isPieceMoving(unitId, pieceId, axis);
     }
 
-    bool GameScene::isPieceTurning(UnitId unitId, const std::string& name, Axis axis) const
+    bool GameScene::isPieceTurning(UnitId unitId, unsigned int pieceId, Axis axis) const
     {
-        return simulation.isPieceTurning(unitId, name, axis);
+        return simulation.isPieceTurning(unitId, pieceId, axis);
     }
 
     GameTime GameScene::getGameTime() const
@@ -1552,9 +1564,9 @@ namespace rwe
     {
         if (!playerCommandService->checkHashes())
         {
-            std::ofstream dumpFile;
-            dumpFile.open("rwe-dump-" + std::to_string(std::rand()) + ".json");
-            dumpFile << dumpJson(simulation);
+            std::ofstream dumpFile("rwe-dump-" + std::to_string(std::rand()) + ".snapshot", std::ios::binary);
+            SnapshotStreamWriter dumpWriter(&dumpFile, 1);
+            dumpWriter.write(simulation.gameTime, serializeSnapshot(simulationDriver.captureSnapshot()));
             dumpFile.close();
             throw std::runtime_error("Desync detected");
         }
@@ -1567,118 +1579,10 @@ namespace rwe
         }
 
         sceneTime += SceneTime(1);
-        simulation.gameTime += GameTime(1);
 
         processActions();
 
-        processPlayerCommands(*playerCommands);
-
-        // run resource updates once per second
-        if (simulation.gameTime % GameTime(60) == GameTime(0))
-        {
-            for (auto& player : simulation.players)
-            {
-                player.metal += player.metalProductionBuffer;
-                player.metalProductionBuffer = Metal(0);
-                player.energy += player.energyProductionBuffer;
-                player.energyProductionBuffer = Energy(0);
-
-                if (player.metal > Metal(0))
-                {
-                    player.metal -= player.actualMetalConsumptionBuffer;
-                    player.actualMetalConsumptionBuffer = Metal(0);
-                    player.metalStalled = false;
-                }
-                else
-                {
-                    player.metalStalled = true;
-                }
-
-                player.previousDesiredMetalConsumptionBuffer = player.desiredMetalConsumptionBuffer;
-                player.desiredMetalConsumptionBuffer = Metal(0);
-
-                if (player.energy > Energy(0))
-                {
-                    player.energy -= player.actualEnergyConsumptionBuffer;
-                    player.actualEnergyConsumptionBuffer = Energy(0);
-                    player.energyStalled = false;
-                }
-                else
-                {
-                    player.energyStalled = true;
-                }
-
-                player.previousDesiredEnergyConsumptionBuffer = player.desiredEnergyConsumptionBuffer;
-                player.desiredEnergyConsumptionBuffer = Energy(0);
-
-                if (player.metal > player.maxMetal)
-                {
-                    player.metal = player.maxMetal;
-                }
-
-                if (player.energy > player.maxEnergy)
-                {
-                    player.energy = player.maxEnergy;
-                }
-            }
-
-            for (auto& entry : simulation.units)
-            {
-                const auto& unitId = entry.first;
-                auto& unit = entry.second;
-
-                unit.resetResourceBuffers();
-
-                if (!unit.isBeingBuilt())
-                {
-                    simulation.addResourceDelta(unitId, unit.energyMake, unit.metalMake);
-                }
-
-                if (unit.activated)
-                {
-                    if (unit.isSufficientlyPowered)
-                    {
-                        // extract metal
-                        if (unit.extractsMetal != Metal(0))
-                        {
-                            auto footprint = computeFootprintRegion(unit.position, unit.footprintX, unit.footprintZ);
-                            auto metalValue = simulation.metalGrid.accumulate(simulation.metalGrid.clipRegion(footprint), 0u, std::plus<>());
-                            simulation.addResourceDelta(unitId, Energy(0), Metal(metalValue * unit.extractsMetal.value));
-                        }
-                    }
-
-                    unit.isSufficientlyPowered = simulation.addResourceDelta(unitId, -unit.energyUse, -unit.metalUse);
-                }
-            }
-        }
-
-        pathFindingService.update();
-
-        // run unit scripts
-        for (auto& entry : simulation.units)
-        {
-            auto unitId = entry.first;
-            auto& unit = entry.second;
-
-            unitBehaviorService.update(unitId);
-
-            unit.mesh.update(SecondsPerTick);
-
-            cobExecutionService.run(*this, simulation, unitId);
-        }
-
-        updateProjectiles();
-
-        updateExplosions();
-
-        // if a commander died this frame, kill the player that owns it
-        for (const auto& p : simulation.units)
-        {
-            if (p.second.isCommander() && p.second.isDead())
-            {
-                killPlayer(p.second.owner);
-            }
-        }
+        simulationDriver.tick(*playerCommands);
 
         auto winStatus = simulation.computeWinStatus();
         match(
@@ -1693,19 +1597,13 @@ namespace rwe
                 // do nothing, game still in progress
             });
 
-        deleteDeadUnits();
-
-        deleteDeadProjectiles();
-
-        spawnNewUnits();
-
-        auto gameHash = simulation.computeHash();
+        auto gameHash = simulationDriver.getGameHash();
         playerCommandService->pushHash(localPlayerId, gameHash);
         gameNetworkService->submitGameHash(gameHash);
 
-        if (stateLogStream)
+        if (stateLogWriter && simulation.gameTime.value % stateLogInterval == 0)
         {
-            *stateLogStream << dumpJson(simulation) << std::endl;
+            stateLogWriter->write(simulation.gameTime, serializeSnapshot(simulationDriver.captureSnapshot()));
         }
     }
 
@@ -1867,48 +1765,6 @@ namespace rwe
         refreshBuildGuiTotal(unitId, unitType);
     }
 
-    void GameScene::issueUnitOrder(UnitId unitId, const UnitOrder& order)
-    {
-        auto unit = tryGetUnit(unitId);
-        if (unit)
-        {
-            unit->get().clearOrders();
-            unit->get().addOrder(order);
-        }
-    }
-
-    void GameScene::enqueueUnitOrder(UnitId unitId, const UnitOrder& order)
-    {
-        auto unit = tryGetUnit(unitId);
-        if (unit)
-        {
-            unit->get().addOrder(order);
-        }
-    }
-
-    void GameScene::stopUnit(UnitId unitId)
-    {
-        auto unit = tryGetUnit(unitId);
-        if (unit)
-        {
-            unit->get().clearOrders();
-        }
-    }
-
-    void GameScene::setFireOrders(UnitId unitId, UnitFireOrders orders)
-    {
-        auto unit = tryGetUnit(unitId);
-        if (unit)
-        {
-            unit->get().fireOrders = orders;
-
-            if (auto selectedUnit = getSingleSelectedUnit(); selectedUnit && *selectedUnit == unitId)
-            {
-                fireOrders.next(orders);
-            }
-        }
-    }
-
     bool GameScene::isShiftDown() const
     {
         return leftShiftDown || rightShiftDown;
@@ -1950,11 +1806,6 @@ namespace rwe
         return simulation.isCollisionAt(rect, self);
     }
 
-    void GameScene::moveUnitOccupiedArea(const DiscreteRect& oldRect, const DiscreteRect& newRect, UnitId unitId)
-    {
-        simulation.moveUnitOccupiedArea(oldRect, newRect, unitId);
-    }
-
     GameSimulation& GameScene::getSimulation()
     {
         return simulation;
@@ -1971,490 +1822,66 @@ namespace rwe
         return !getUnit(id).isOwnedBy(localPlayerId);
     }
 
-    void GameScene::updateProjectiles()
+    void GameScene::processActions()
     {
-        auto gameTime = getGameTime();
-        for (auto& [id, projectile] : simulation.projectiles)
+        for (auto& a : actions)
         {
-            // remove if it's time to die
-            if (projectile.dieOnFrame && *projectile.dieOnFrame <= gameTime)
-            {
-                projectile.isDead = true;
-                continue;
-            }
-
-            if (projectile.gravity)
-            {
-                projectile.velocity.y -= 112_ss / 6000_ss;
-            }
-            projectile.position += projectile.velocity;
-
-            // emit smoke trail
-            if (projectile.smokeTrail)
-            {
-                if (gameTime > projectile.lastSmoke + *projectile.smokeTrail)
-                {
-                    createLightSmoke(projectile.position);
-                    projectile.lastSmoke = gameTime;
-                }
-            }
-
-            // test collision with terrain
-            auto terrainHeight = simulation.terrain.tryGetHeightAt(projectile.position.x, projectile.position.z);
-            if (!terrainHeight)
+            if (!a)
             {
-                // silently remove projectiles that go outside the map
-                projectile.isDead = true;
                 continue;
             }
 
-            auto seaLevel = simulation.terrain.getSeaLevel();
-
-            // test collision with sea
-            // FIXME: waterweapons should be allowed in water
-            if (seaLevel > terrainHeight && projectile.position.y <= seaLevel)
-            {
-                doProjectileImpact(projectile, ImpactType::Water);
-                projectile.isDead = true;
-            }
-            else if (projectile.position.y <= terrainHeight)
-            {
-                doProjectileImpact(projectile, ImpactType::Normal);
-                projectile.isDead = true;
-            }
-            else
-            {
-                // detect collision with something's footprint
-                auto heightMapPos = simulation.terrain.worldToHeightmapCoordinate(projectile.position);
-                auto cellValue = simulation.occupiedGrid.tryGet(heightMapPos);
-                if (cellValue)
-                {
-                    auto collides = projectileCollides(simulation, projectile, cellValue->get());
-                    if (collides)
-                    {
-                        doProjectileImpact(projectile, ImpactType::Normal);
-                        projectile.isDead = true;
-                    }
-                }
-            }
-        }
-    }
-
-    void GameScene::updateExplosions()
-    {
-        auto end = simulation.explosions.end();
-        for (auto it = simulation.explosions.begin(); it != end;)
-        {
-            auto& exp = *it;
-            if (exp.isFinished(simulation.gameTime))
+            if (sceneTime < a->triggerTime)
             {
-                exp = std::move(*--end);
                 continue;
             }
 
-            if (exp.floats)
-            {
-                // TODO: drift with the wind
-                exp.position.y += 0.5_ssf;
-            }
-
-            ++it;
-        }
-        simulation.explosions.erase(end, simulation.explosions.end());
-    }
-
-    void GameScene::doProjectileImpact(const Projectile& projectile, ImpactType impactType)
-    {
-        switch (impactType)
-        {
-            case ImpactType::Normal:
-            {
-                if (projectile.soundHit)
-                {
-                    playSoundAt(simVectorToFloat(projectile.position), *projectile.soundHit);
-                }
-                if (projectile.explosion)
-                {
-                    simulation.spawnExplosion(projectile.position, *projectile.explosion);
-                }
-                if (projectile.endSmoke)
-                {
-                    createLightSmoke(projectile.position);
-                }
-                break;
-            }
-            case ImpactType::Water:
-            {
-                if (projectile.soundWater)
-                {
-                    playSoundAt(simVectorToFloat(projectile.position), *projectile.soundWater);
-                }
-                if (projectile.waterExplosion)
-                {
-                    simulation.spawnExplosion(projectile.position, *projectile.waterExplosion);
-                }
-                break;
-            }
-        }
-
-        applyDamageInRadius(projectile.position, projectile.damageRadius, projectile);
-    }
-
-    void GameScene::applyDamageInRadius(const SimVector& position, SimScalar radius, const Projectile& projectile)
-    {
-        auto minX = position.x - radius;
-        auto maxX = position.x + radius;
-        auto minZ = position.z - radius;
-        auto maxZ = position.z + radius;
-
-        auto minPoint = simulation.terrain.worldToHeightmapCoordinate(SimVector(minX, position.y, minZ));
-        auto maxPoint = simulation.terrain.worldToHeightmapCoordinate(SimVector(maxX, position.y, maxZ));
-        auto minCell = simulation.occupiedGrid.clampToCoords(minPoint);
-        auto maxCell = simulation.occupiedGrid.clampToCoords(maxPoint);
-
-        assert(minCell.x <= maxCell.x);
-        assert(minCell.y <= maxCell.y);
-
-        auto radiusSquared = radius * radius;
-
-        std::unordered_set<UnitId> seenUnits;
-
-        auto region = GridRegion::fromCoordinates(minCell, maxCell);
-
-        // for each cell
-        region.forEach([&](const auto& coords) {
-            // check if it's in range
-            auto cellCenter = simulation.terrain.heightmapIndexToWorldCenter(coords.x, coords.y);
-            Rectangle2x<SimScalar> cellRectangle(
-                Vector2x<SimScalar>(cellCenter.x, cellCenter.z),
-                Vector2x<SimScalar>(MapTerrain::HeightTileWidthInWorldUnits / 2_ss, MapTerrain::HeightTileHeightInWorldUnits / 2_ss));
-            auto cellDistanceSquared = cellRectangle.distanceSquared(Vector2x<SimScalar>(position.x, position.z));
-            if (cellDistanceSquared > radiusSquared)
-            {
-                return;
-            }
-
-            // check if a unit (or feature) is there
-            auto occupiedType = simulation.occupiedGrid.get(coords);
-            auto u = match(
-                occupiedType.occupiedType,
-                [&](const OccupiedUnit& u) { return std::optional(u.id); },
-                [&](const auto&) { return std::optional<UnitId>(); });
-            if (!u && occupiedType.buildingCell && !occupiedType.buildingCell->passable)
-            {
-                u = occupiedType.buildingCell->unit;
-            }
-            if (!u)
-            {
-                return;
-            }
-
-            // check if the unit was seen/mark as seen
-            auto pair = seenUnits.insert(*u);
-            if (!pair.second) // the unit was already present
-            {
-                return;
-            }
-
-            const auto& unit = simulation.getUnit(*u);
-
-            // skip dead units
-            if (unit.isDead())
-            {
-                return;
-            }
-
-            // add in the third dimension component to distance,
-            // check if we are still in range
-            auto unitDistanceSquared = createBoundingBox(unit).distanceSquared(position);
-            if (unitDistanceSquared > radiusSquared)
-            {
-                return;
-            }
-
-            // apply appropriate damage
-            auto damageScale = std::clamp(1_ss - (sqrt(unitDistanceSquared) / radius), 0_ss, 1_ss);
-            auto rawDamage = projectile.getDamage(unit.unitType);
-            auto scaledDamage = simScalarToUInt(SimScalar(rawDamage) * damageScale);
-            applyDamage(*u, scaledDamage);
-        });
-    }
-
-    void GameScene::applyDamage(UnitId unitId, unsigned int damagePoints)
-    {
-        auto& unit = simulation.getUnit(unitId);
-        if (unit.hitPoints <= damagePoints)
-        {
-            killUnit(unitId);
-        }
-        else
-        {
-            unit.hitPoints -= damagePoints;
-        }
-    }
-
-    void GameScene::createLightSmoke(const SimVector& position)
-    {
-        simulation.spawnSmoke(position, sceneContext.textureService->getGafEntry("anims/FX.GAF", "smoke 1"));
-    }
-
-    void GameScene::activateUnit(UnitId unitId)
-    {
-        auto unit = tryGetUnit(unitId);
-        if (unit)
-        {
-            unit->get().activate();
-
-            if (unit->get().activateSound)
-            {
-                playNotificationSound(unit->get().owner, *unit->get().activateSound);
-            }
-
-            if (auto selectedUnit = getSingleSelectedUnit(); selectedUnit && *selectedUnit == unitId)
-            {
-                onOff.next(true);
-            }
-        }
-    }
-
-    void GameScene::deactivateUnit(UnitId unitId)
-    {
-        auto unit = tryGetUnit(unitId);
-        if (unit)
-        {
-            unit->get().deactivate();
-
-            if (unit->get().deactivateSound)
-            {
-                playNotificationSound(unit->get().owner, *unit->get().deactivateSound);
-            }
-
-            if (auto selectedUnit = getSingleSelectedUnit(); selectedUnit && *selectedUnit == unitId)
-            {
-                onOff.next(false);
-            }
-        }
-    }
-
-    void GameScene::modifyBuildQueue(UnitId unitId, const std::string& unitType, int count)
-    {
-        auto unit = tryGetUnit(unitId);
-        if (unit)
-        {
-            unit->get().modifyBuildQueue(unitType, count);
-
-            updateUnconfirmedBuildQueueDelta(unitId, unitType, -count);
-            refreshBuildGuiTotal(unitId, unitType);
-        }
-    }
-
-    void GameScene::setBuildStance(UnitId unitId, bool value)
-    {
-        getUnit(unitId).inBuildStance = value;
-    }
-
-    void GameScene::setYardOpen(UnitId unitId, bool value)
-    {
-        simulation.trySetYardOpen(unitId, value);
-    }
-
-    void GameScene::setBuggerOff(UnitId unitId, bool value)
-    {
-        if (value)
-        {
-            simulation.emitBuggerOff(unitId);
+            a->callback();
+            a = std::nullopt;
         }
     }
 
-    void GameScene::deleteDeadUnits()
+    void GameScene::onSimulationEvent(const SimulationEvent& event)
     {
-        for (auto it = simulation.units.begin(); it != simulation.units.end();)
-        {
-            const auto& unit = it->second;
-            if (unit.isDead())
-            {
-                deselectUnit(it->first);
+        match(
+            event,
+            [&](const PlaySoundAtEvent& e) {
+                playSoundAt(e.position, e.sound);
+            },
+            [&](const PlayNotificationSoundEvent& e) {
+                playNotificationSound(e.player, e.sound);
+            },
+            [&](const UnitSpawnedEvent& e) {
+                // initialise local-player-specific UI data
+                const auto& unit = getUnit(e.unitId);
+                unitGuiInfos.insert_or_assign(e.unitId, UnitGuiInfo{unit.builder ? UnitGuiInfo::Section::Build : UnitGuiInfo::Section::Orders, 0});
+            },
+            [&](const UnitDeletedEvent& e) {
+                deselectUnit(e.unitId);
 
-                if (hoveredUnit && *hoveredUnit == it->first)
+                if (hoveredUnit && *hoveredUnit == e.unitId)
                 {
                     hoveredUnit = std::nullopt;
                 }
 
-                auto footprintRect = computeFootprintRegion(unit.position, unit.footprintX, unit.footprintZ);
-                auto footprintRegion = simulation.occupiedGrid.tryToRegion(footprintRect);
-                assert(!!footprintRegion);
-                if (unit.isMobile)
-                {
-                    simulation.occupiedGrid.forEach(*footprintRegion, [](auto& cell) {
-                        cell.occupiedType = OccupiedNone();
-                    });
-                }
-                else
-                {
-                    simulation.occupiedGrid.forEach(*footprintRegion, [&](auto& cell) {
-                        if (cell.buildingCell && cell.buildingCell->unit == it->first)
-                        {
-                            cell.buildingCell = std::nullopt;
-                        }
-                    });
-                }
-
-
-                unitGuiInfos.erase(it->first);
-                it = simulation.units.erase(it);
-            }
-            else
-            {
-                ++it;
-            }
-        }
-    }
-
-    void GameScene::deleteDeadProjectiles()
-    {
-        for (auto it = simulation.projectiles.begin(); it != simulation.projectiles.end();)
-        {
-            const auto& projectile = it->second;
-            if (projectile.isDead)
-            {
-                it = simulation.projectiles.erase(it);
-            }
-            else
-            {
-                ++it;
-            }
-        }
-    }
-
-    void GameScene::spawnNewUnits()
-    {
-        for (const auto& unitId : simulation.unitCreationRequests)
-        {
-            auto unit = tryGetUnit(unitId);
-            if (!unit)
-            {
-                continue;
-            }
-
-            if (auto s = std::get_if<CreatingUnitState>(&unit->get().behaviourState); s != nullptr)
-            {
-
-                if (!std::holds_alternative<UnitCreationStatusPending>(s->status))
-                {
-                    continue;
-                }
-
-                auto newUnitId = spawnUnit(s->unitType, s->owner, s->position);
-                if (!newUnitId)
-                {
-                    s->status = UnitCreationStatusFailed();
-                    continue;
-                }
-
-                s->status = UnitCreationStatusDone{*newUnitId};
-            }
-
-            if (auto s = std::get_if<FactoryStateCreatingUnit>(&unit->get().factoryState); s != nullptr)
-            {
-                if (!std::holds_alternative<UnitCreationStatusPending>(s->status))
+                unitGuiInfos.erase(e.unitId);
+            },
+            [&](const UnitActivationChangedEvent& e) {
+                if (auto selectedUnit = getSingleSelectedUnit(); selectedUnit && *selectedUnit == e.unitId)
                 {
-                    continue;
+                    onOff.next(e.activated);
                 }
-
-                auto newUnitId = spawnUnit(s->unitType, s->owner, s->position);
-                if (!newUnitId)
+            },
+            [&](const UnitFireOrdersChangedEvent& e) {
+                if (auto selectedUnit = getSingleSelectedUnit(); selectedUnit && *selectedUnit == e.unitId)
                 {
-                    s->status = UnitCreationStatusFailed();
-                    continue;
+                    fireOrders.next(e.orders);
                 }
-
-                s->status = UnitCreationStatusDone{*newUnitId};
-            }
-        }
-
-        simulation.unitCreationRequests.clear();
-    }
-
-    BoundingBox3x<SimScalar> GameScene::createBoundingBox(const Unit& unit) const
-    {
-        auto footprint = simulation.computeFootprintRegion(unit.position, unit.footprintX, unit.footprintZ);
-        auto min = SimVector(SimScalar(footprint.x), unit.position.y, SimScalar(footprint.y));
-        auto max = SimVector(SimScalar(footprint.x + footprint.width), unit.position.y + unit.height, SimScalar(footprint.y + footprint.height));
-        auto worldMin = simulation.terrain.heightmapToWorldSpace(min);
-        auto worldMax = simulation.terrain.heightmapToWorldSpace(max);
-        return BoundingBox3x<SimScalar>::fromMinMax(worldMin, worldMax);
-    }
-
-    void GameScene::killUnit(UnitId unitId)
-    {
-        auto& unit = simulation.getUnit(unitId);
-
-        unit.markAsDead();
-
-        // TODO: spawn debris particles, corpse
-        if (unit.explosionWeapon)
-        {
-            auto impactType = unit.position.y < simulation.terrain.getSeaLevel() ? ImpactType::Water : ImpactType::Normal;
-            auto projectile = simulation.createProjectileFromWeapon(unit.owner, *unit.explosionWeapon, unit.position, SimVector(0_ss, -1_ss, 0_ss), 0_ss);
-            doProjectileImpact(projectile, impactType);
-        }
-    }
-
-    void GameScene::quietlyKillUnit(UnitId unitId)
-    {
-        auto& unit = simulation.getUnit(unitId);
-
-        unit.markAsDead();
-    }
-
-    void GameScene::killPlayer(PlayerId playerId)
-    {
-        simulation.getPlayer(playerId).status = GamePlayerStatus::Dead;
-        for (auto& p : simulation.units)
-        {
-            auto& unit = p.second;
-            if (unit.isDead())
-            {
-                continue;
-            }
-
-            if (!unit.isOwnedBy(playerId))
-            {
-                continue;
-            }
-
-            killUnit(p.first);
-        }
-    }
-
-    void GameScene::processActions()
-    {
-        for (auto& a : actions)
-        {
-            if (!a)
-            {
-                continue;
-            }
-
-            if (sceneTime < a->triggerTime)
-            {
-                continue;
-            }
-
-            a->callback();
-            a = std::nullopt;
-        }
-    }
-
-    void GameScene::processPlayerCommands(const std::vector<std::pair<PlayerId, std::vector<PlayerCommand>>>& commands)
-    {
-        for (const auto& [_, playerCommands] : commands)
-        {
-            for (const auto& command : playerCommands)
-            {
-                processPlayerCommand(command);
-            }
-        }
+            },
+            [&](const UnitBuildQueueChangedEvent& e) {
+                updateUnconfirmedBuildQueueDelta(e.unitId, e.unitType, -e.count);
+                refreshBuildGuiTotal(e.unitId, e.unitType);
+            });
     }
 
     void GameScene::attachOrdersMenuEventHandlers()
@@ -2959,57 +2386,6 @@ namespace rwe
         return panel;
     }
 
-    void GameScene::processPlayerCommand(const PlayerCommand& playerCommand)
-    {
-        match(
-            playerCommand,
-            [&](const PlayerUnitCommand& c) {
-                processUnitCommand(c);
-            },
-            [](const PlayerPauseGameCommand&) {
-                // TODO
-            },
-            [](const PlayerUnpauseGameCommand&) {
-                // TODO
-            });
-    }
-
-    void GameScene::processUnitCommand(const PlayerUnitCommand& unitCommand)
-    {
-        match(
-            unitCommand.command,
-            [&](const PlayerUnitCommand::IssueOrder& c) {
-                switch (c.issueKind)
-                {
-                    case PlayerUnitCommand::IssueOrder::IssueKind::Immediate:
-                        issueUnitOrder(unitCommand.unit, c.order);
-                        break;
-                    case PlayerUnitCommand::IssueOrder::IssueKind::Queued:
-                        enqueueUnitOrder(unitCommand.unit, c.order);
-                        break;
-                }
-            },
-            [&](const PlayerUnitCommand::ModifyBuildQueue& c) {
-                modifyBuildQueue(unitCommand.unit, c.unitType, c.count);
-            },
-            [&](const PlayerUnitCommand::Stop&) {
-                stopUnit(unitCommand.unit);
-            },
-            [&](const PlayerUnitCommand::SetFireOrders& c) {
-                setFireOrders(unitCommand.unit, c.orders);
-            },
-            [&](const PlayerUnitCommand::SetOnOff& c) {
-                if (c.on)
-                {
-                    activateUnit(unitCommand.unit);
-                }
-                else
-                {
-                    deactivateUnit(unitCommand.unit);
-                }
-            });
-    }
-
     bool GameScene::leftClickMode() const
     {
         return sceneContext.globalConfig->leftClickInterfaceMode;
@@ -23,18 +23,17 @@
 #include <rwe/SceneManager.h>
 #include <rwe/SceneTime.h>
 #include <rwe/SimScalar.h>
+#include <rwe/SimulationDriver.h>
 #include <rwe/TextureService.h>
 #include <rwe/UiRenderService.h>
 #include <rwe/Unit.h>
-#include <rwe/UnitBehaviorService.h>
 #include <rwe/UnitDatabase.h>
 #include <rwe/UnitFactory.h>
 #include <rwe/UnitId.h>
 #include <rwe/ViewportService.h>
 #include <rwe/camera/UiCamera.h>
-#include <rwe/cob/CobExecutionService.h>
 #include <rwe/observable/BehaviorSubject.h>
-#include <rwe/pathfinding/PathFindingService.h>
+#include <rwe/snapshot/SnapshotStream.h>
 #include <rwe/ui/UiFactory.h>
 #include <rwe/ui/UiPanel.h>
 #include <variant>
@@ -129,12 +128,6 @@ namespace rwe
 
     using CursorMode = std::variant<AttackCursorMode, MoveCursorMode, BuildCursorMode, NormalCursorMode>;
 
-    enum class ImpactType
-    {
-        Normal,
-        Water
-    };
-
     struct UnitGuiInfo
     {
         enum class Section
@@ -174,6 +167,9 @@ namespace rwe
          */
         static constexpr float CameraPanSpeed = 1000.0f;
 
+        /** Number of snapshots written to the state log between each full (non-delta) snapshot. */
+        static constexpr unsigned int StateLogKeyframeInterval = 60;
+
         static const Rectangle2f minimapViewport;
 
         SceneContext sceneContext;
@@ -196,9 +192,9 @@ namespace rwe
 
         std::unique_ptr<GameNetworkService> gameNetworkService;
 
-        PathFindingService pathFindingService;
-        CobExecutionService cobExecutionService;
-        UnitBehaviorService unitBehaviorService;
+        SimulationDriver simulationDriver;
+
+        std::unique_ptr<Subscription> simulationEventsSub = simulationDriver.events().subscribe([this](const SimulationEvent& event) { onSimulationEvent(event); });
 
         std::shared_ptr<Sprite> minimap;
         std::shared_ptr<SpriteSeries> minimapDots;
@@ -254,6 +250,13 @@ namespace rwe
         std::vector<std::pair<GameTime, GameHash>> gameHashes;
 
         std::optional<std::ofstream> stateLogStream;
+        std::optional<SnapshotStreamWriter> stateLogWriter;
+
+        /** Number of ticks between snapshots written to the state log. */
+        unsigned int stateLogInterval;
+
+        /** If set, unit scripts are profiled for the whole game and the results written here when the scene ends. */
+        std::optional<std::string> cobProfileFile;
 
         bool showDebugWindow{false};
         char unitSpawnText[20]{""};
@@ -281,7 +284,11 @@ namespace rwe
             const std::shared_ptr<SpriteSeries>& guiFont,
             PlayerId localPlayerId,
             TdfBlock* audioLookup,
-            std::optional<std::ofstream>&& stateLogStream);
+            std::optional<std::ofstream>&& stateLogStream,
+            unsigned int stateLogInterval,
+            const std::optional<std::string>& cobProfileFile);
+
+        ~GameScene() override;
 
         void init() override;
 
@@ -309,21 +316,21 @@ namespace rwe
 
         const MapTerrain& getTerrain() const;
 
-        void showObject(UnitId unitId, const std::string& name);
+        void showObject(UnitId unitId, unsigned int pieceId);
 
-        void hideObject(UnitId unitId, const std::string& name);
+        void hideObject(UnitId unitId, unsigned int pieceId);
 
-        void moveObject(UnitId unitId, const std::string& name, Axis axis, SimScalar position, SimScalar speed);
+        void moveObject(UnitId unitId, unsigned int pieceId, Axis axis, SimScalar position, SimScalar speed);
 
-        void moveObjectNow(UnitId unitId, const std::string& name, Axis axis, SimScalar position);
+        void moveObjectNow(UnitId unitId, unsigned int pieceId, Axis axis, SimScalar position);
 
-        void turnObject(UnitId unitId, const std::string& name, Axis axis, SimAngle angle, SimScalar speed);
+        void turnObject(UnitId unitId, unsigned int pieceId, Axis axis, SimAngle angle, SimScalar speed);
 
-        void turnObjectNow(UnitId unitId, const std::string& name, Axis axis, SimAngle angle);
+        void turnObjectNow(UnitId unitId, unsigned int pieceId, Axis axis, SimAngle angle);
 
-        bool isPieceMoving(UnitId unitId, const std::string& name, Axis axis) const;
+        bool isPieceMoving(UnitId unitId, unsigned int pieceId, Axis axis) const;
 
-        bool isPieceTurning(UnitId unitId, const std::string& name, Axis axis) const;
+        bool isPieceTurning(UnitId unitId, unsigned int pieceId, Axis axis) const;
 
         GameTime getGameTime() const;
 
@@ -337,29 +344,10 @@ namespace rwe
 
         DiscreteRect computeFootprintRegion(const SimVector& position, unsigned int footprintX, unsigned int footprintZ) const;
 
-        void moveUnitOccupiedArea(const DiscreteRect& oldRect, const DiscreteRect& newRect, UnitId unitId);
-
         GameSimulation& getSimulation();
 
         const GameSimulation& getSimulation() const;
 
-        void doProjectileImpact(const Projectile& projectile, ImpactType impactType);
-
-        void createLightSmoke(const SimVector& position);
-
-        void activateUnit(UnitId unitId);
-        void deactivateUnit(UnitId unitId);
-
-        void modifyBuildQueue(UnitId unitId, const std::string& unitType, int count);
-
-        void setBuildStance(UnitId unitId, bool value);
-
-        void setYardOpen(UnitId unitId, bool value);
-
-        void quietlyKillUnit(UnitId unitId);
-
-        void setBuggerOff(UnitId unitId, bool value);
-
         void onChannelFinished(int channel);
 
     private:
@@ -395,14 +383,6 @@ namespace rwe
 
         void localPlayerModifyBuildQueue(UnitId unitId, const std::string& unitType, int count);
 
-        void issueUnitOrder(UnitId unitId, const UnitOrder& order);
-
-        void enqueueUnitOrder(UnitId unitId, const UnitOrder& order);
-
-        void stopUnit(UnitId unitId);
-
-        void setFireOrders(UnitId unitId, UnitFireOrders orders);
-
         bool isShiftDown() const;
 
         Unit& getUnit(UnitId id);
@@ -417,33 +397,9 @@ namespace rwe
 
         bool isEnemy(UnitId id) const;
 
-        void updateProjectiles();
-
-        void updateExplosions();
-
-        void applyDamageInRadius(const SimVector& position, SimScalar radius, const Projectile& projectile);
-
-        void applyDamage(UnitId unitId, unsigned int damagePoints);
-
-        void deleteDeadUnits();
-
-        void deleteDeadProjectiles();
-
-        void spawnNewUnits();
-
-        BoundingBox3x<SimScalar> createBoundingBox(const Unit& unit) const;
-
-        void killUnit(UnitId unitId);
-
-        void killPlayer(PlayerId playerId);
-
         void processActions();
 
-        void processPlayerCommands(const std::vector<std::pair<PlayerId, std::vector<PlayerCommand>>>& commands);
-
-        void processPlayerCommand(const PlayerCommand& playerCommand);
-
-        void processUnitCommand(const PlayerUnitCommand& unitCommand);
+        void onSimulationEvent(const SimulationEvent& event);
 
         template <typename T>
         void delay(SceneTime interval, T&& f)
@@ -457,6 +413,8 @@ namespace rwe
 
         void renderDebugWindow();
 
+        void renderCobProfile();
+
         void renderUnitOrderLines(UnitId unitId);
 
         void renderBuildBoxes(const Unit& unit, const Color& color);
@@ -1,4 +1,5 @@
 #include "GameSimulation.h"
+#include <algorithm>
 #include <rwe/SimScalar.h>
 #include <rwe/collection_util.h>
 #include <rwe/overloaded.h>
@@ -80,19 +81,27 @@ namespace rwe
     GameSimulation::GameSimulation(MapTerrain&& terrain, unsigned char surfaceMetal)
         : terrain(std::move(terrain)),
           occupiedGrid(this->terrain.getHeightMap().getWidth() - 1, this->terrain.getHeightMap().getHeight() - 1, OccupiedCell()),
-          metalGrid(this->terrain.getHeightMap().getWidth() - 1, this->terrain.getHeightMap().getHeight() - 1, surfaceMetal)
+          metalGrid(this->terrain.getHeightMap().getWidth() - 1, this->terrain.getHeightMap().getHeight() - 1, surfaceMetal),
+          unitIndex(this->terrain.getHeightMap().getWidth() - 1, this->terrain.getHeightMap().getHeight() - 1)
     {
     }
 
     FeatureId GameSimulation::addFeature(MapFeature&& newFeature)
     {
         auto featureId = FeatureId(features.emplace(std::move(newFeature)));
+        if (featureId.value >= OccupiedCell::MaxIdValue)
+        {
+            features.remove(featureId);
+            throw std::runtime_error("Too many features to fit in the occupied grid");
+        }
 
         auto& f = features.tryGet(featureId)->get();
         if (f.isBlocking)
         {
             auto footprintRegion = computeFootprintRegion(f.position, f.footprintX, f.footprintZ);
-            occupiedGrid.forEach(occupiedGrid.clipRegion(footprintRegion), [featureId](auto& cell) { cell.occupiedType = OccupiedFeature(featureId); });
+            occupiedGrid.forEach(occupiedGrid.clipRegion(footprintRegion), [featureId](auto& cell) { cell.setFeature(featureId); });
+            staticCollisionChanges.push_back(footprintRegion);
+            occupiedGridChanges.push_back(footprintRegion);
         }
 
         if (!f.isBlocking && f.isIndestructible && f.metal)
@@ -121,6 +130,12 @@ namespace rwe
         }
 
         auto unitId = units.emplace(std::move(unit));
+        if (unitId.value >= OccupiedCell::MaxIdValue)
+        {
+            units.remove(unitId);
+            throw std::runtime_error("Too many units to fit in the occupied grid");
+        }
+
         const auto& insertedUnit = units.tryGet(unitId)->get();
 
         auto footprintRegion = occupiedGrid.tryToRegion(footprintRect);
@@ -128,15 +143,21 @@ namespace rwe
 
         if (insertedUnit.isMobile)
         {
-            occupiedGrid.forEach(*footprintRegion, [unitId](auto& cell) { cell.occupiedType = OccupiedUnit(unitId); });
+            occupiedGrid.forEach(*footprintRegion, [unitId](auto& cell) { cell.setUnit(unitId); });
         }
         else
         {
             assert(!!insertedUnit.yardMap);
             occupiedGrid.forEach2(footprintRegion->x, footprintRegion->y, *insertedUnit.yardMap, [&](auto& cell, const auto& yardMapCell) {
-                cell.buildingCell = BuildingOccupiedCell{unitId, isPassable(yardMapCell, insertedUnit.yardOpen)};
+                cell.setBuildingCell(BuildingOccupiedCell{unitId, isPassable(yardMapCell, insertedUnit.yardOpen)});
             });
+            staticCollisionChanges.push_back(footprintRect);
         }
+        occupiedGridChanges.push_back(footprintRect);
+
+        unitIndex.insert(unitId, footprintRect);
+
+        changedUnits.push_back(unitId);
 
         return unitId;
     }
@@ -156,10 +177,10 @@ namespace rwe
         return true;
     }
 
-    DiscreteRect GameSimulation::computeFootprintRegion(const SimVector& position, unsigned int footprintX, unsigned int footprintZ) const
+    DiscreteRect computeFootprintRegion(const MapTerrain& terrain, const SimVector& position, unsigned int footprintX, unsigned int footprintZ)
     {
-        auto halfFootprintX = SimScalar(footprintX * MapTerrain::HeightTileWidthInWorldUnits.value / 2);
-        auto halfFootprintZ = SimScalar(footprintZ * MapTerrain::HeightTileHeightInWorldUnits.value / 2);
+        auto halfFootprintX = SimScalar(footprintX) * MapTerrain::HeightTileWidthInWorldUnits / 2_ss;
+        auto halfFootprintZ = SimScalar(footprintZ) * MapTerrain::HeightTileHeightInWorldUnits / 2_ss;
         SimVector topLeft(
             position.x - halfFootprintX,
             position.y,
@@ -170,134 +191,76 @@ namespace rwe
         return DiscreteRect(cell.x, cell.y, footprintX, footprintZ);
     }
 
-    bool GameSimulation::isCollisionAt(const DiscreteRect& rect) const
+    DiscreteRect GameSimulation::computeFootprintRegion(const SimVector& position, unsigned int footprintX, unsigned int footprintZ) const
     {
-        auto region = occupiedGrid.tryToRegion(rect);
-        if (!region)
-        {
-            return true;
-        }
+        return rwe::computeFootprintRegion(terrain, position, footprintX, footprintZ);
+    }
 
-        return isCollisionAt(*region);
+    bool GameSimulation::isCollisionAt(const DiscreteRect& rect) const
+    {
+        return rwe::isCollisionAt(occupiedGrid, rect);
     }
 
     bool GameSimulation::isCollisionAt(const GridRegion& region) const
     {
-        return occupiedGrid.any(region, [&](const auto& cell) {
-            auto isColliding = match(
-                cell.occupiedType,
-                [](const OccupiedNone&) { return false; },
-                [](const OccupiedUnit&) { return true; },
-                [](const OccupiedFeature&) { return true; });
-            if (isColliding)
-            {
-                return true;
-            }
-
-            if (cell.buildingCell && !cell.buildingCell->passable)
-            {
-                return true;
-            }
-
-            return false;
-        });
+        return rwe::isCollisionAt(occupiedGrid, region);
     }
 
     bool GameSimulation::isCollisionAt(const DiscreteRect& rect, UnitId self) const
     {
-        auto region = occupiedGrid.tryToRegion(rect);
-        if (!region)
-        {
-            return true;
-        }
-
-        return occupiedGrid.any(*region, [&](const auto& cell) {
-            auto inCollision = match(
-                cell.occupiedType,
-                [&](const OccupiedNone&) { return false; },
-                [&](const OccupiedUnit& u) { return u.id != self; },
-                [&](const OccupiedFeature&) { return true; });
-            if (inCollision)
-            {
-                return true;
-            }
-
-            if (cell.buildingCell && cell.buildingCell->unit != self && !cell.buildingCell->passable)
-            {
-                return true;
-            }
+        return rwe::isCollisionAt(occupiedGrid, rect, self);
+    }
 
-            return false;
-        });
+    bool GameSimulation::isStaticCollisionAt(const DiscreteRect& rect) const
+    {
+        return rwe::isStaticCollisionAt(occupiedGrid, rect);
     }
 
     bool GameSimulation::isYardmapBlocked(unsigned int x, unsigned int y, const Grid<YardMapCell>& yardMap, bool open) const
     {
         return occupiedGrid.any2(x, y, yardMap, [&](const auto& cell, const auto& yardMapCell) {
-            if (isPassable(yardMapCell, open))
-            {
-                return false;
-            }
-
-            auto inCollision = match(
-                cell.occupiedType,
-                [&](const OccupiedNone&) { return false; },
-                [&](const OccupiedUnit&) { return true; },
-                [&](const OccupiedFeature&) { return true; });
-            if (inCollision)
-            {
-                return true;
-            }
-
-            return false;
+            return (cell.getOccupiedType() != OccupiedType::None) & !isPassable(yardMapCell, open);
         });
     }
 
     bool GameSimulation::isAdjacentToObstacle(const DiscreteRect& rect) const
     {
-        DiscreteRect top(rect.x - 1, rect.y - 1, rect.width + 2, 1);
-        DiscreteRect bottom(rect.x - 1, rect.y + rect.width, rect.width + 2, 1);
-        DiscreteRect left(rect.x - 1, rect.y, 1, rect.height);
-        DiscreteRect right(rect.x + rect.width, rect.y, 1, rect.height);
-        return isCollisionAt(top)
-            || isCollisionAt(bottom)
-            || isCollisionAt(left)
-            || isCollisionAt(right);
+        return rwe::isAdjacentToObstacle(occupiedGrid, rect);
     }
 
-    void GameSimulation::showObject(UnitId unitId, const std::string& name)
+    void GameSimulation::showObject(UnitId unitId, unsigned int pieceId)
     {
-        auto mesh = getUnit(unitId).mesh.find(name);
-        if (mesh)
+        auto piece = getUnit(unitId).findScriptPiece(pieceId);
+        if (piece)
         {
-            mesh->get().visible = true;
+            piece->get().visible = true;
         }
     }
 
-    void GameSimulation::hideObject(UnitId unitId, const std::string& name)
+    void GameSimulation::hideObject(UnitId unitId, unsigned int pieceId)
     {
-        auto mesh = getUnit(unitId).mesh.find(name);
-        if (mesh)
+        auto piece = getUnit(unitId).findScriptPiece(pieceId);
+        if (piece)
         {
-            mesh->get().visible = false;
+            piece->get().visible = false;
         }
     }
 
-    void GameSimulation::enableShading(UnitId unitId, const std::string& name)
+    void GameSimulation::enableShading(UnitId unitId, unsigned int pieceId)
     {
-        auto mesh = getUnit(unitId).mesh.find(name);
-        if (mesh)
+        auto piece = getUnit(unitId).findScriptPiece(pieceId);
+        if (piece)
         {
-            mesh->get().shaded = true;
+            piece->get().shaded = true;
         }
     }
 
-    void GameSimulation::disableShading(UnitId unitId, const std::string& name)
+    void GameSimulation::disableShading(UnitId unitId, unsigned int pieceId)
     {
-        auto mesh = getUnit(unitId).mesh.find(name);
-        if (mesh)
+        auto piece = getUnit(unitId).findScriptPiece(pieceId);
+        if (piece)
         {
-            mesh->get().shaded = false;
+            piece->get().shaded = false;
         }
     }
 
@@ -355,44 +318,44 @@ namespace rwe
         return players.at(player.value);
     }
 
-    void GameSimulation::moveObject(UnitId unitId, const std::string& name, Axis axis, SimScalar position, SimScalar speed)
+    void GameSimulation::moveObject(UnitId unitId, unsigned int pieceId, Axis axis, SimScalar position, SimScalar speed)
     {
-        getUnit(unitId).moveObject(name, axis, position, speed);
+        getUnit(unitId).moveObject(pieceId, axis, position, speed);
     }
 
-    void GameSimulation::moveObjectNow(UnitId unitId, const std::string& name, Axis axis, SimScalar position)
+    void GameSimulation::moveObjectNow(UnitId unitId, unsigned int pieceId, Axis axis, SimScalar position)
     {
-        getUnit(unitId).moveObjectNow(name, axis, position);
+        getUnit(unitId).moveObjectNow(pieceId, axis, position);
     }
 
-    void GameSimulation::turnObject(UnitId unitId, const std::string& name, Axis axis, SimAngle angle, SimScalar speed)
+    void GameSimulation::turnObject(UnitId unitId, unsigned int pieceId, Axis axis, SimAngle angle, SimScalar speed)
     {
-        getUnit(unitId).turnObject(name, axis, angle, speed);
+        getUnit(unitId).turnObject(pieceId, axis, angle, speed);
     }
 
-    void GameSimulation::turnObjectNow(UnitId unitId, const std::string& name, Axis axis, SimAngle angle)
+    void GameSimulation::turnObjectNow(UnitId unitId, unsigned int pieceId, Axis axis, SimAngle angle)
     {
-        getUnit(unitId).turnObjectNow(name, axis, angle);
+        getUnit(unitId).turnObjectNow(pieceId, axis, angle);
     }
 
-    void GameSimulation::spinObject(UnitId unitId, const std::string& name, Axis axis, SimScalar speed, SimScalar acceleration)
+    void GameSimulation::spinObject(UnitId unitId, unsigned int pieceId, Axis axis, SimScalar speed, SimScalar acceleration)
     {
-        getUnit(unitId).spinObject(name, axis, speed, acceleration);
+        getUnit(unitId).spinObject(pieceId, axis, speed, acceleration);
     }
 
-    void GameSimulation::stopSpinObject(UnitId unitId, const std::string& name, Axis axis, SimScalar deceleration)
+    void GameSimulation::stopSpinObject(UnitId unitId, unsigned int pieceId, Axis axis, SimScalar deceleration)
     {
-        getUnit(unitId).stopSpinObject(name, axis, deceleration);
+        getUnit(unitId).stopSpinObject(pieceId, axis, deceleration);
     }
 
-    bool GameSimulation::isPieceMoving(UnitId unitId, const std::string& name, Axis axis) const
+    bool GameSimulation::isPieceMoving(UnitId unitId, unsigned int pieceId, Axis axis) const
     {
-        return getUnit(unitId).isMoveInProgress(name, axis);
+        return getUnit(unitId).isMoveInProgress(pieceId, axis);
     }
 
-    bool GameSimulation::isPieceTurning(UnitId unitId, const std::string& name, Axis axis) const
+    bool GameSimulation::isPieceTurning(UnitId unitId, unsigned int pieceId, Axis axis) const
     {
-        return getUnit(unitId).isTurnInProgress(name, axis);
+        return getUnit(unitId).isTurnInProgress(pieceId, axis);
     }
 
     std::optional<UnitId> GameSimulation::getFirstCollidingUnit(const Ray3f& ray) const
@@ -400,19 +363,58 @@ namespace rwe
         auto bestDistance = std::numeric_limits<float>::infinity();
         std::optional<UnitId> it;
 
-        for (const auto& entry : units)
+        for (const auto& unitId : findUnitsUnderRay(ray))
         {
-            auto distance = entry.second.selectionIntersect(ray);
+            auto distance = getUnit(unitId).selectionIntersect(ray);
             if (distance && distance < bestDistance)
             {
                 bestDistance = *distance;
-                it = entry.first;
+                it = unitId;
             }
         }
 
         return it;
     }
 
+    std::vector<UnitId> GameSimulation::findUnitsNear(const SimVector& position, SimScalar radius) const
+    {
+        auto minPoint = terrain.worldToHeightmapCoordinate(SimVector(position.x - radius, position.y, position.z - radius));
+        auto maxPoint = terrain.worldToHeightmapCoordinate(SimVector(position.x + radius, position.y, position.z + radius));
+
+        // expand by a cell to cover rounding in footprint placement
+        return unitIndex.query(DiscreteRect::fromPoints(minPoint, maxPoint).expand(1));
+    }
+
+    std::vector<UnitId> GameSimulation::findUnitsUnderRay(const Ray3f& ray) const
+    {
+        // Selection meshes are tested against the segment of the ray up to t = 1.
+        // Units can only be hit where that segment passes through
+        // the band of heights between the lowest terrain
+        // and the top of a unit standing on the highest terrain,
+        // so we only need units underneath that part of the segment.
+        auto bandBottom = simScalarToFloat(MapTerrain::MinHeight);
+        auto bandTop = simScalarToFloat(MapTerrain::MaxHeight) + SelectionHeightMargin;
+
+        auto start = ray.origin;
+        auto end = ray.pointAt(1.0f);
+        if (ray.direction.y != 0.0f)
+        {
+            auto tBottom = (bandBottom - ray.origin.y) / ray.direction.y;
+            auto tTop = (bandTop - ray.origin.y) / ray.direction.y;
+            auto tMin = std::clamp(std::min(tBottom, tTop), 0.0f, 1.0f);
+            auto tMax = std::clamp(std::max(tBottom, tTop), 0.0f, 1.0f);
+            start = ray.pointAt(tMin);
+            end = ray.pointAt(tMax);
+        }
+
+        auto p1 = terrain.worldToHeightmapCoordinate(SimVector(floatToSimScalar(start.x), 0_ss, floatToSimScalar(start.z)));
+        auto p2 = terrain.worldToHeightmapCoordinate(SimVector(floatToSimScalar(end.x), 0_ss, floatToSimScalar(end.z)));
+
+        // Selection meshes may overhang their unit's footprint,
+        // so look one bucket further out in every direction.
+        return unitIndex.query(DiscreteRect::fromPoints(p1, p2).expand(UnitSpatialIndex::BucketSize));
+    }
+
     std::optional<SimVector> GameSimulation::intersectLineWithTerrain(const Line3x<SimScalar>& line) const
     {
         return terrain.intersectLine(line);
@@ -425,8 +427,12 @@ namespace rwe
         auto newRegion = occupiedGrid.tryToRegion(newRect);
         assert(!!newRegion);
 
-        occupiedGrid.forEach(*oldRegion, [](auto& cell) { cell.occupiedType = OccupiedNone(); });
-        occupiedGrid.forEach(*newRegion, [unitId](auto& cell) { cell.occupiedType = OccupiedUnit(unitId); });
+        occupiedGrid.forEach(*oldRegion, [](auto& cell) { cell.clearOccupant(); });
+        occupiedGrid.forEach(*newRegion, [unitId](auto& cell) { cell.setUnit(unitId); });
+        occupiedGridChanges.push_back(oldRect);
+        occupiedGridChanges.push_back(newRect);
+
+        unitIndex.move(unitId, oldRect, newRect);
     }
 
     void GameSimulation::requestPath(UnitId unitId)
@@ -450,28 +456,15 @@ namespace rwe
         PlayerId owner, const UnitWeapon& weapon, const SimVector& position, const SimVector& direction, SimScalar distanceToTarget)
     {
         Projectile projectile;
+        projectile.weapon = weapon.definition;
         projectile.owner = owner;
         projectile.position = position;
         projectile.origin = position;
         projectile.velocity = direction * weapon.velocity;
         projectile.gravity = weapon.physicsType == ProjectilePhysicsType::Ballistic;
 
-        projectile.renderType = weapon.renderType;
-
-        projectile.endSmoke = weapon.endSmoke;
-        projectile.smokeTrail = weapon.smokeTrail;
         projectile.lastSmoke = gameTime;
 
-        projectile.soundHit = weapon.soundHit;
-        projectile.soundWater = weapon.soundWater;
-
-        projectile.explosion = weapon.explosion;
-        projectile.waterExplosion = weapon.waterExplosion;
-
-        projectile.damage = weapon.damage;
-
-        projectile.damageRadius = weapon.damageRadius;
-
         if (weapon.weaponTimer)
         {
             projectile.dieOnFrame = gameTime + *weapon.weaponTimer;
@@ -556,24 +549,37 @@ namespace rwe
         return player.addResourceDelta(apparentEnergy, apparentMetal, actualEnergy, actualMetal);
     }
 
-    bool GameSimulation::trySetYardOpen(const UnitId& unitId, bool open)
+    bool GameSimulation::canSetYardOpen(const UnitId& unitId, bool open) const
     {
-        auto& unit = getUnit(unitId);
+        const auto& unit = getUnit(unitId);
         auto footprintRect = computeFootprintRegion(unit.position, unit.footprintX, unit.footprintZ);
         auto footprintRegion = occupiedGrid.tryToRegion(footprintRect);
         assert(!!footprintRegion);
 
         assert(!!unit.yardMap);
-        if (isYardmapBlocked(footprintRegion->x, footprintRegion->y, *unit.yardMap, open))
+        return !isYardmapBlocked(footprintRegion->x, footprintRegion->y, *unit.yardMap, open);
+    }
+
+    bool GameSimulation::trySetYardOpen(const UnitId& unitId, bool open)
+    {
+        if (!canSetYardOpen(unitId, open))
         {
             return false;
         }
 
+        auto& unit = getUnit(unitId);
+        auto footprintRect = computeFootprintRegion(unit.position, unit.footprintX, unit.footprintZ);
+        auto footprintRegion = occupiedGrid.tryToRegion(footprintRect);
+        assert(!!footprintRegion);
+
         occupiedGrid.forEach2(footprintRegion->x, footprintRegion->y, *unit.yardMap, [&](auto& cell, const auto& yardMapCell) {
-            cell.buildingCell = BuildingOccupiedCell{unitId, isPassable(yardMapCell, open)};
+            cell.setBuildingCell(BuildingOccupiedCell{unitId, isPassable(yardMapCell, open)});
         });
+        staticCollisionChanges.push_back(footprintRect);
+        occupiedGridChanges.push_back(footprintRect);
 
         unit.yardOpen = open;
+        changedUnits.push_back(unitId);
 
         return true;
     }
@@ -585,15 +591,20 @@ namespace rwe
         auto footprintRegion = occupiedGrid.tryToRegion(footprintRect);
         assert(!!footprintRegion);
 
+        // A unit covers several cells in a row,
+        // so skip over repeats of the one we just told.
+        std::optional<UnitId> lastUnitId;
         occupiedGrid.forEach(*footprintRegion, [&](const auto& e) {
-            auto unitId = match(
-                e.occupiedType,
-                [&](const OccupiedUnit& u) { return std::optional(u.id); },
-                [&](const auto&) { return std::optional<UnitId>(); });
+            if (e.getOccupiedType() != OccupiedType::Unit)
+            {
+                return;
+            }
 
-            if (unitId)
+            auto unitId = *e.getUnit();
+            if (unitId != lastUnitId)
             {
-                tellToBuggerOff(*unitId, footprintRect);
+                tellToBuggerOff(unitId, footprintRect);
+                lastUnitId = unitId;
             }
         });
     }
@@ -13,7 +13,9 @@
 #include <rwe/Projectile.h>
 #include <rwe/ProjectileId.h>
 #include <rwe/Unit.h>
+#include <rwe/UnitSpatialIndex.h>
 #include <rwe/VectorMap.h>
+#include <rwe/cob/CobTimerWheel.h>
 #include <unordered_map>
 
 namespace rwe
@@ -87,8 +89,20 @@ namespace rwe
     };
     using WinStatus = std::variant<WinStatusWon, WinStatusDraw, WinStatusUndecided>;
 
+    /**
+     * Returns the region of heightmap cells covered by a footprint
+     * of the given size centered on the given position.
+     */
+    DiscreteRect computeFootprintRegion(const MapTerrain& terrain, const SimVector& position, unsigned int footprintX, unsigned int footprintZ);
+
     struct GameSimulation
     {
+        /**
+         * How far above the highest possible terrain
+         * a unit's selection mesh might reach.
+         */
+        static constexpr float SelectionHeightMargin = 256.0f;
+
         std::minstd_rand rng;
 
         WinStatus gameStatus{WinStatusUndecided()};
@@ -107,6 +121,9 @@ namespace rwe
 
         VectorMap<Unit, UnitIdTag> units;
 
+        /** Spatial index of unit footprints, kept in step with occupiedGrid. */
+        UnitSpatialIndex unitIndex;
+
         VectorMap<Projectile, ProjectileIdTag> projectiles;
 
         std::vector<Explosion> explosions;
@@ -115,6 +132,32 @@ namespace rwe
 
         std::deque<UnitId> unitCreationRequests;
 
+        /**
+         * Footprints of features and buildings that have been placed, removed
+         * or have had their yards opened or closed since the pathfinder last looked.
+         */
+        std::vector<DiscreteRect> staticCollisionChanges;
+
+        /**
+         * Every region of the occupied grid that has been modified
+         * since the pathfinder last looked, including unit movement.
+         */
+        std::vector<DiscreteRect> occupiedGridChanges;
+
+        /**
+         * Units that have been added, removed or had any hashed state modified
+         * since the game hash was last brought up to date.
+         * May contain duplicates.
+         */
+        std::vector<UnitId> changedUnits;
+
+        /**
+         * When units' sleeping cob threads are due to wake up.
+         * Derived from the units' blocked queues,
+         * so it is rebuilt rather than saved in snapshots.
+         */
+        CobTimerWheel cobSleepTimers;
+
         GameTime gameTime{0};
 
         explicit GameSimulation(MapTerrain&& terrain, unsigned char surfaceMetal);
@@ -144,17 +187,23 @@ namespace rwe
 
         bool isCollisionAt(const DiscreteRect& rect, UnitId self) const;
 
+        /**
+         * Like isCollisionAt, but ignores mobile units,
+         * so only terrain features and buildings count.
+         */
+        bool isStaticCollisionAt(const DiscreteRect& rect) const;
+
         bool isYardmapBlocked(unsigned int x, unsigned int y, const Grid<YardMapCell>& yardMap, bool open) const;
 
         bool isAdjacentToObstacle(const DiscreteRect& rect) const;
 
-        void showObject(UnitId unitId, const std::string& name);
+        void showObject(UnitId unitId, unsigned int pieceId);
 
-        void hideObject(UnitId unitId, const std::string& name);
+        void hideObject(UnitId unitId, unsigned int pieceId);
 
-        void enableShading(UnitId unitId, const std::string& name);
+        void enableShading(UnitId unitId, unsigned int pieceId);
 
-        void disableShading(UnitId unitId, const std::string& name);
+        void disableShading(UnitId unitId, unsigned int pieceId);
 
         Unit& getUnit(UnitId id);
 
@@ -174,24 +223,38 @@ namespace rwe
 
         const GamePlayerInfo& getPlayer(PlayerId player) const;
 
-        void moveObject(UnitId unitId, const std::string& name, Axis axis, SimScalar position, SimScalar speed);
+        void moveObject(UnitId unitId, unsigned int pieceId, Axis axis, SimScalar position, SimScalar speed);
 
-        void moveObjectNow(UnitId unitId, const std::string& name, Axis axis, SimScalar position);
+        void moveObjectNow(UnitId unitId, unsigned int pieceId, Axis axis, SimScalar position);
 
-        void turnObject(UnitId unitId, const std::string& name, Axis axis, SimAngle angle, SimScalar speed);
+        void turnObject(UnitId unitId, unsigned int pieceId, Axis axis, SimAngle angle, SimScalar speed);
 
-        void turnObjectNow(UnitId unitId, const std::string& name, Axis axis, SimAngle angle);
+        void turnObjectNow(UnitId unitId, unsigned int pieceId, Axis axis, SimAngle angle);
 
-        void spinObject(UnitId unitId, const std::string& name, Axis axis, SimScalar speed, SimScalar acceleration);
+        void spinObject(UnitId unitId, unsigned int pieceId, Axis axis, SimScalar speed, SimScalar acceleration);
 
-        void stopSpinObject(UnitId unitId, const std::string& name, Axis axis, SimScalar deceleration);
+        void stopSpinObject(UnitId unitId, unsigned int pieceId, Axis axis, SimScalar deceleration);
 
-        bool isPieceMoving(UnitId unitId, const std::string& name, Axis axis) const;
+        bool isPieceMoving(UnitId unitId, unsigned int pieceId, Axis axis) const;
 
-        bool isPieceTurning(UnitId unitId, const std::string& name, Axis axis) const;
+        bool isPieceTurning(UnitId unitId, unsigned int pieceId, Axis axis) const;
 
         std::optional<UnitId> getFirstCollidingUnit(const Ray3f& ray) const;
 
+        /**
+         * Returns the IDs of units whose footprints might lie
+         * within the given radius of the given position on the XZ plane,
+         * in ascending ID order.
+         * Callers must still check the distance to each unit precisely.
+         */
+        std::vector<UnitId> findUnitsNear(const SimVector& position, SimScalar radius) const;
+
+        /**
+         * Returns the IDs of units whose selection meshes
+         * might be hit by the given ray, in ascending ID order.
+         */
+        std::vector<UnitId> findUnitsUnderRay(const Ray3f& ray) const;
+
         std::optional<SimVector> intersectLineWithTerrain(const Line3x<SimScalar>& line) const;
 
         void moveUnitOccupiedArea(const DiscreteRect& oldRect, const DiscreteRect& newRect, UnitId unitId);
@@ -208,9 +271,21 @@ namespace rwe
 
         WinStatus computeWinStatus() const;
 
+        /**
+         * Charges or credits the unit's owner and records the delta in the unit's resource buffers.
+         * The buffers are hashed, so the caller must list the unit in changedUnits
+         * if they end up different from the start of the tick.
+         */
         bool addResourceDelta(const UnitId& unitId, const Energy& apparentEnergy, const Metal& apparentMetal, const Energy& actualEnergy, const Metal& actualMetal);
         bool addResourceDelta(const UnitId& unitId, const Energy& energy, const Metal& metal);
 
+        /**
+         * Returns true if nothing is standing on the parts of the building
+         * that would become impassable.
+         * Only reads the occupied grid, so scripts may call it while units run in parallel.
+         */
+        bool canSetYardOpen(const UnitId& unitId, bool open) const;
+
         bool trySetYardOpen(const UnitId& unitId, bool open);
 
         void emitBuggerOff(const UnitId& unitId);
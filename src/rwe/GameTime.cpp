@@ -9,6 +9,6 @@ namespace rwe
 
     GameTime deltaSecondsToTicks(SimScalar seconds)
     {
-        return GameTime(seconds.value * 60.0f);
+        return GameTime(simScalarToUInt(seconds * 60_ss));
     }
 }
@@ -8,6 +8,9 @@ namespace rwe
     struct GameTimeTag;
     using GameTime = OpaqueUnit<unsigned int, GameTimeTag>;
 
+    /** Number of milliseconds between each game tick. */
+    constexpr unsigned int TickInterval = 1000 / 60;
+
     GameTime deltaSecondsToTicks(float seconds);
     GameTime deltaSecondsToTicks(SimScalar seconds);
 }
@@ -1,7 +1,6 @@
 #pragma once
 
 #include <GL/glew.h>
-#include <SDL.h>
 #include <memory>
 #include <rwe/ColorPalette.h>
 #include <rwe/GlMesh.h>
@@ -4,7 +4,7 @@
 #include <algorithm>
 #include <memory>
 #include <optional>
-#include <rwe/io_utils.h>
+#include <rwe/ThreadPool.h>
 #include <rwe/rwe_string.h>
 
 #include <zlib.h>
@@ -13,54 +13,11 @@ namespace rwe
 {
     HpiException::HpiException(const char* message) : runtime_error(message) {}
 
-    /**
-     * Decrypts the contents of the buffer.
-     * @param key The decryption key.
-     * @param seed The seed for decryption,
-     * typically the position of the starting byte in the file.
-     * @param buf The buffer to decrypt.
-     * @param size The size of the buffer.
-     */
-    void decrypt(unsigned char key, unsigned char seed, char buf[], std::streamsize size)
-    {
-        if (key == 0)
-        {
-            return;
-        }
-
-        for (std::streamsize i = 0; i < size; ++i)
-        {
-            auto pos = seed + static_cast<unsigned char>(i);
-            buf[i] = (pos ^ key) ^ buf[i];
-        }
-    }
-
-    void readAndDecrypt(std::istream& stream, unsigned char key, char buf[], std::streamsize size)
-    {
-        auto seed = static_cast<unsigned char>(stream.tellg());
-        stream.read(buf, size);
-        decrypt(key, seed, buf, stream.gcount());
-    }
-
     unsigned char transformKey(unsigned char key)
     {
         return (key << 2) | (key >> 6);
     }
 
-    template <typename T>
-    T readAndDecryptRaw(std::istream& stream, unsigned char key)
-    {
-        T val;
-        readAndDecrypt(stream, key, reinterpret_cast<char*>(&val), sizeof(T));
-        return val;
-    }
-
-    template <typename T>
-    void readAndDecryptRawArray(std::istream& stream, unsigned char key, T* buffer, std::size_t size)
-    {
-        readAndDecrypt(stream, key, reinterpret_cast<char*>(buffer), sizeof(T) * size);
-    }
-
     void decryptInner(char* buffer, std::size_t size)
     {
         for (std::size_t i = 0; i < size; ++i)
@@ -259,9 +216,32 @@ namespace rwe
         return Directory{v};
     }
 
-    HpiArchive::HpiArchive(std::istream* stream) : stream(stream)
+    void HpiArchive::readAndDecrypt(std::size_t offset, char* buffer, std::size_t count) const
+    {
+        if (offset > size || count > size - offset)
+        {
+            throw HpiException("Read past end of archive");
+        }
+
+        const char* in = data + offset;
+        if (decryptionKey == 0)
+        {
+            std::copy(in, in + count, buffer);
+            return;
+        }
+
+        // the key is mixed with the position of each byte in the archive
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            auto pos = static_cast<unsigned char>(offset + i);
+            buffer[i] = static_cast<char>((pos ^ decryptionKey) ^ static_cast<unsigned char>(in[i]));
+        }
+    }
+
+    HpiArchive::HpiArchive(const char* data, std::size_t size) : data(data), size(size)
     {
-        auto v = readRaw<HpiVersion>(*stream);
+        // the key is still 0 here, so the headers are read as they are
+        auto v = readAndDecryptRaw<HpiVersion>(0);
         if (v.marker != HpiMagicNumber)
         {
             throw HpiException("Invalid HPI file marker");
@@ -272,21 +252,40 @@ namespace rwe
             throw HpiException("Unsupported HPI version");
         }
 
-        auto h = readRaw<HpiHeader>(*stream);
+        auto h = readAndDecryptRaw<HpiHeader>(sizeof(HpiVersion));
 
         decryptionKey = transformKey(static_cast<unsigned char>(h.headerKey));
 
-        stream->seekg(h.start);
-        auto data = std::make_unique<char[]>(h.directorySize);
-        readAndDecrypt(*stream, decryptionKey, data.get() + h.start, h.directorySize - h.start);
-
         if (h.start + sizeof(HpiDirectoryData) > h.directorySize)
         {
             throw HpiException("Runaway root directory");
         }
 
-        auto directory = reinterpret_cast<HpiDirectoryData*>(data.get() + h.start);
-        _root = convertDirectory(*directory, data.get(), h.directorySize);
+        auto directoryData = std::make_unique<char[]>(h.directorySize);
+        readAndDecrypt(h.start, directoryData.get() + h.start, h.directorySize - h.start);
+
+        auto directory = reinterpret_cast<HpiDirectoryData*>(directoryData.get() + h.start);
+        _root = convertDirectory(*directory, directoryData.get(), h.directorySize);
+        indexDirectory(_root, "");
+    }
+
+    void HpiArchive::indexDirectory(const Directory& directory, const std::string& upperPrefix)
+    {
+        for (const auto& e : directory.entries)
+        {
+            auto path = upperPrefix + toUpper(e.name);
+
+            // if names clash, the first entry wins, as it did when directories were searched in order
+            match(
+                e.data,
+                [&](const File& f) { fileIndex.insert({path, &f}); },
+                [&](const Directory& d) {
+                    if (directoryIndex.insert({path, &d}).second)
+                    {
+                        indexDirectory(d, path + "/");
+                    }
+                });
+        }
     }
 
     const HpiArchive::Directory& HpiArchive::root() const
@@ -295,172 +294,171 @@ namespace rwe
     }
 
     void HpiArchive::extract(const HpiArchive::File& file, char* buffer) const
+    {
+        extractFile(file, buffer, nullptr);
+    }
+
+    const char* HpiArchive::tryGetStoredData(const HpiArchive::File& file) const
+    {
+        if (file.compressionScheme != File::CompressionScheme::None || decryptionKey != 0)
+        {
+            return nullptr;
+        }
+
+        if (file.offset > size || file.size > size - file.offset)
+        {
+            throw HpiException("Read past end of archive");
+        }
+
+        return data + file.offset;
+    }
+
+    void HpiArchive::extract(const HpiArchive::File& file, char* buffer, ThreadPool& threadPool) const
+    {
+        extractFile(file, buffer, &threadPool);
+    }
+
+    void HpiArchive::extractFile(const HpiArchive::File& file, char* buffer, ThreadPool* threadPool) const
     {
         switch (file.compressionScheme)
         {
             case HpiArchive::File::CompressionScheme::None:
-                stream->seekg(file.offset);
-                readAndDecrypt(*stream, decryptionKey, buffer, file.size);
+                readAndDecrypt(file.offset, buffer, file.size);
                 break;
             case HpiArchive::File::CompressionScheme::LZ77:
             case HpiArchive::File::CompressionScheme::ZLib:
-                extractCompressed(file, buffer);
+                extractCompressed(file, buffer, threadPool);
                 break;
             default:
                 throw HpiException("Invalid file entry compression scheme");
         }
     }
 
-    void HpiArchive::extractCompressed(const HpiArchive::File& file, char* buffer) const
+    void HpiArchive::extractCompressed(const HpiArchive::File& file, char* buffer, ThreadPool* threadPool) const
     {
-        auto chunkCount = (file.size / 65536) + (file.size % 65536 == 0 ? 0 : 1);
-        stream->seekg(file.offset);
+        auto chunks = locateChunks(file);
 
-        auto chunkSizes = std::make_unique<uint32_t[]>(chunkCount);
-        readAndDecryptRawArray(*stream, decryptionKey, chunkSizes.get(), chunkCount);
-
-        std::size_t bufferOffset = 0;
-        for (std::size_t i = 0; i < chunkCount; ++i)
+        if (threadPool == nullptr || chunks.size() < MinParallelChunks)
         {
-            auto chunkHeader = readAndDecryptRaw<HpiChunk>(*stream, decryptionKey);
-            if (chunkHeader.marker != HpiChunkMagicNumber)
+            // reused for each chunk, since the chunks must be decrypted before decompressing
+            std::vector<char> chunkBuffer;
+            for (const auto& chunk : chunks)
             {
-                throw HpiException("Invalid chunk header");
+                extractChunk(chunk, buffer, chunkBuffer);
             }
+            return;
+        }
 
-            if (bufferOffset + chunkHeader.decompressedSize > file.size)
+        // each chunk decompresses into its own part of the buffer,
+        // so the jobs don't need to coordinate
+        threadPool->forEachChunk(chunks.size(), 1, [&](std::size_t, std::size_t begin, std::size_t end) {
+            std::vector<char> chunkBuffer;
+            for (std::size_t i = begin; i < end; ++i)
             {
-                throw HpiException("Extracted file larger than expected");
+                extractChunk(chunks[i], buffer, chunkBuffer);
             }
+        });
+    }
 
-            auto chunkBuffer = std::make_unique<char[]>(chunkHeader.compressedSize);
-            readAndDecrypt(*stream, decryptionKey, chunkBuffer.get(), chunkHeader.compressedSize);
+    std::vector<HpiArchive::ChunkLocation> HpiArchive::locateChunks(const File& file) const
+    {
+        auto chunkCount = (file.size / HpiChunkSize) + (file.size % HpiChunkSize == 0 ? 0 : 1);
 
-            auto checksum = computeChecksum(chunkBuffer.get(), chunkHeader.compressedSize);
-            if (checksum != chunkHeader.checksum)
-            {
-                throw HpiException("Invalid chunk checksum");
-            }
+        // skip the table of chunk sizes, the chunk headers repeat them
+        auto offset = file.offset + (chunkCount * sizeof(uint32_t));
 
-            if (chunkHeader.encrypted != 0)
+        std::vector<ChunkLocation> chunks;
+        chunks.reserve(chunkCount);
+
+        std::size_t fileOffset = 0;
+        for (std::size_t i = 0; i < chunkCount; ++i)
+        {
+            auto chunkHeader = readAndDecryptRaw<HpiChunk>(offset);
+            offset += sizeof(HpiChunk);
+            if (chunkHeader.marker != HpiChunkMagicNumber)
             {
-                decryptInner(chunkBuffer.get(), chunkHeader.compressedSize);
+                throw HpiException("Invalid chunk header");
             }
 
-            switch (chunkHeader.compressionScheme)
+            if (fileOffset + chunkHeader.decompressedSize > file.size)
             {
-                case 0: // no compression
-                    if (chunkHeader.compressedSize != chunkHeader.decompressedSize)
-                    {
-                        throw HpiException("Uncompressed chunk has different decompressed and compressed sizes");
-                    }
-
-                    std::copy(chunkBuffer.get(), chunkBuffer.get() + chunkHeader.compressedSize, buffer + bufferOffset);
-                    bufferOffset += chunkHeader.decompressedSize;
-                    break;
-
-                case 1: // LZ77 compression
-                    decompressLZ77(chunkBuffer.get(), chunkHeader.compressedSize, buffer + bufferOffset, chunkHeader.decompressedSize);
-                    bufferOffset += chunkHeader.decompressedSize;
-                    break;
-
-                case 2: // ZLib compression
-                    decompressZLib(chunkBuffer.get(), chunkHeader.compressedSize, buffer + bufferOffset, chunkHeader.decompressedSize);
-                    bufferOffset += chunkHeader.decompressedSize;
-                    break;
-                default:
-                    throw HpiException("Invalid compression scheme");
+                throw HpiException("Extracted file larger than expected");
             }
+
+            chunks.push_back(ChunkLocation{chunkHeader, offset, fileOffset});
+            offset += chunkHeader.compressedSize;
+            fileOffset += chunkHeader.decompressedSize;
         }
+
+        return chunks;
     }
 
-    std::optional<std::reference_wrapper<const HpiArchive::File>> findFileInner(const HpiArchive::Directory& dir, const std::string& name)
+    void HpiArchive::extractChunk(const ChunkLocation& chunk, char* buffer, std::vector<char>& chunkBuffer) const
     {
-        auto it = std::find_if(
-            dir.entries.begin(),
-            dir.entries.end(),
-            [name](const HpiArchive::DirectoryEntry& e) {
-                return toUpper(e.name) == toUpper(name);
-            });
-
-        if (it == dir.entries.end())
+        const auto& chunkHeader = chunk.header;
+
+        chunkBuffer.resize(chunkHeader.compressedSize);
+        readAndDecrypt(chunk.dataOffset, chunkBuffer.data(), chunkHeader.compressedSize);
+
+        auto checksum = computeChecksum(chunkBuffer.data(), chunkHeader.compressedSize);
+        if (checksum != chunkHeader.checksum)
         {
-            return std::nullopt;
+            throw HpiException("Invalid chunk checksum");
         }
 
-        return match(
-            it->data,
-            [&](const HpiArchive::Directory&) { return std::optional<std::reference_wrapper<const HpiArchive::File>>(); },
-            [&](const HpiArchive::File& f) { return std::make_optional(std::ref(f)); });
-    }
+        if (chunkHeader.encrypted != 0)
+        {
+            decryptInner(chunkBuffer.data(), chunkHeader.compressedSize);
+        }
 
-    std::optional<std::reference_wrapper<const HpiArchive::File>> HpiArchive::findFile(const std::string& path) const
-    {
-        auto components = split(path, '/');
+        auto out = buffer + chunk.fileOffset;
+        switch (chunkHeader.compressionScheme)
+        {
+            case 0: // no compression
+                if (chunkHeader.compressedSize != chunkHeader.decompressedSize)
+                {
+                    throw HpiException("Uncompressed chunk has different decompressed and compressed sizes");
+                }
 
-        const Directory* dir = &root();
+                std::copy(chunkBuffer.data(), chunkBuffer.data() + chunkHeader.compressedSize, out);
+                break;
 
-        // traverse to the correct directory
-        for (auto cIt = components.cbegin(), cEnd = --components.cend(); cIt != cEnd; ++cIt)
-        {
-            auto& c = *cIt;
-            auto begin = dir->entries.begin();
-            auto end = dir->entries.end();
-            auto it = std::find_if(
-                begin,
-                end,
-                [c](const DirectoryEntry& e) {
-                    return toUpper(e.name) == toUpper(c);
-                });
-            if (it == end)
-            {
-                return std::nullopt;
-            }
+            case 1: // LZ77 compression
+                decompressLZ77(chunkBuffer.data(), chunkHeader.compressedSize, out, chunkHeader.decompressedSize);
+                break;
 
-            auto foundDir = std::get_if<Directory>(&it->data);
-            if (!foundDir)
-            {
-                return std::nullopt;
-            }
+            case 2: // ZLib compression
+                decompressZLib(chunkBuffer.data(), chunkHeader.compressedSize, out, chunkHeader.decompressedSize);
+                break;
+            default:
+                throw HpiException("Invalid compression scheme");
+        }
+    }
 
-            dir = foundDir;
+    std::optional<std::reference_wrapper<const HpiArchive::File>> HpiArchive::findFile(const std::string& path) const
+    {
+        auto it = fileIndex.find(toUpper(path));
+        if (it == fileIndex.end())
+        {
+            return std::nullopt;
         }
 
-        // find the file in the directory
-        return findFileInner(*dir, components.back());
+        return *it->second;
     }
 
     std::optional<std::reference_wrapper<const HpiArchive::Directory>> HpiArchive::findDirectory(const std::string& path) const
     {
-        auto components = split(path, '/');
-
-        const Directory* dir = &root();
-
-        // traverse to the correct directory
-        for (const auto& c : components)
+        if (path.empty())
         {
-            auto begin = dir->entries.begin();
-            auto end = dir->entries.end();
-            auto it = std::find_if(
-                begin,
-                end,
-                [c](const DirectoryEntry& e) {
-                    return toUpper(e.name) == toUpper(c);
-                });
-            if (it == end)
-            {
-                return std::nullopt;
-            }
-
-            auto foundDir = std::get_if<Directory>(&it->data);
-            if (!foundDir)
-            {
-                return std::nullopt;
-            }
+            return _root;
+        }
 
-            dir = foundDir;
+        auto it = directoryIndex.find(toUpper(path));
+        if (it == directoryIndex.end())
+        {
+            return std::nullopt;
         }
 
-        return *dir;
+        return *it->second;
     }
 }
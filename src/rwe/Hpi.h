@@ -2,8 +2,10 @@
 
 #include <cstdint>
 #include <functional>
-#include <istream>
 #include <optional>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
 #include <variant>
 #include <vector>
 
@@ -21,6 +23,11 @@ namespace rwe
     /** The magic number at the start of HPI chunks ("SQSH"). */
     static const unsigned int HpiChunkMagicNumber = 0x48535153;
 
+    /** Compressed files are split into chunks that decompress to this size, except the last. */
+    static const std::size_t HpiChunkSize = 65536;
+
+    class ThreadPool;
+
     class HpiException : public std::runtime_error
     {
     public:
@@ -99,9 +106,19 @@ namespace rwe
 
 #pragma pack()
 
+    /**
+     * Reads an HPI archive from its bytes in memory,
+     * typically a mapped file.
+     * The bytes must outlive the archive.
+     * The archive never modifies its state after construction,
+     * so files may be extracted from several threads at once.
+     */
     class HpiArchive
     {
     public:
+        /** Files with fewer chunks than this are always extracted on the calling thread. */
+        static constexpr std::size_t MinParallelChunks = 4;
+
         struct DirectoryEntry;
         struct File
         {
@@ -126,12 +143,36 @@ namespace rwe
         };
 
     private:
-        std::istream* stream;
-        unsigned char decryptionKey;
+        struct ChunkLocation
+        {
+            HpiChunk header;
+
+            /** The offset of the chunk's compressed data in the archive. */
+            std::size_t dataOffset;
+
+            /** The offset of the chunk's decompressed data in the file. */
+            std::size_t fileOffset;
+        };
+
+        const char* data;
+        std::size_t size;
+        unsigned char decryptionKey{0};
         Directory _root;
 
+        /**
+         * Every file and directory below the root, keyed by upper-cased path.
+         * Points into _root, so the archive must not be copied.
+         */
+        std::unordered_map<std::string, const File*> fileIndex;
+        std::unordered_map<std::string, const Directory*> directoryIndex;
+
     public:
-        explicit HpiArchive(std::istream* stream);
+        HpiArchive(const char* data, std::size_t size);
+
+        HpiArchive(const HpiArchive&) = delete;
+        HpiArchive& operator=(const HpiArchive&) = delete;
+        HpiArchive(HpiArchive&&) = default;
+        HpiArchive& operator=(HpiArchive&&) = default;
 
         const Directory& root() const;
 
@@ -141,11 +182,50 @@ namespace rwe
 
         void extract(const File& file, char* buffer) const;
 
+        /**
+         * Returns the file's bytes inside the archive
+         * if they can be used without extracting them,
+         * i.e. the file is uncompressed and the archive is not encrypted.
+         * Otherwise returns nullptr.
+         */
+        const char* tryGetStoredData(const File& file) const;
+
+        /**
+         * Extracts the file as above, but decompresses the chunks
+         * of large compressed files in parallel on the thread pool.
+         */
+        void extract(const File& file, char* buffer, ThreadPool& threadPool) const;
+
     private:
-        void extractCompressed(const File& file, char* buffer) const;
+        /**
+         * Copies bytes from the archive into the buffer,
+         * decrypting them on the way.
+         * Throws if the range runs past the end of the archive.
+         */
+        void readAndDecrypt(std::size_t offset, char* buffer, std::size_t count) const;
+
+        template <typename T>
+        T readAndDecryptRaw(std::size_t offset) const
+        {
+            T val;
+            readAndDecrypt(offset, reinterpret_cast<char*>(&val), sizeof(T));
+            return val;
+        }
+
+        /** Extracts the file, in parallel if threadPool is not null. */
+        void extractFile(const File& file, char* buffer, ThreadPool* threadPool) const;
+
+        void extractCompressed(const File& file, char* buffer, ThreadPool* threadPool) const;
+
+        /** Reads the chunk headers to find where each chunk's data is and where it goes. */
+        std::vector<ChunkLocation> locateChunks(const File& file) const;
+
+        /** Decrypts and decompresses the chunk into the file buffer, using chunkBuffer as scratch space. */
+        void extractChunk(const ChunkLocation& chunk, char* buffer, std::vector<char>& chunkBuffer) const;
         HpiArchive::File convertFile(const HpiFileData& file);
         HpiArchive::DirectoryEntry convertDirectoryEntry(const HpiDirectoryEntry& entry, const char* buffer, std::size_t size);
         HpiArchive::Directory convertDirectory(const HpiDirectoryData& directory, const char buffer[], std::size_t size);
+        void indexDirectory(const Directory& directory, const std::string& upperPrefix);
     };
 
     unsigned char transformKey(unsigned char key);
@@ -1,24 +1,25 @@
 #pragma once
 
-#include <rwe/AudioService.h>
+#include <optional>
+#include <rwe/SoundHandle.h>
 
 namespace rwe
 {
     struct InGameSoundsInfo
     {
-        std::optional<AudioService::SoundHandle> immediateOrders;
-        std::optional<AudioService::SoundHandle> specialOrders;
-        std::optional<AudioService::SoundHandle> setFireOrders;
+        std::optional<SoundHandle> immediateOrders;
+        std::optional<SoundHandle> specialOrders;
+        std::optional<SoundHandle> setFireOrders;
 
-        std::optional<AudioService::SoundHandle> nextBuildMenu;
+        std::optional<SoundHandle> nextBuildMenu;
 
-        std::optional<AudioService::SoundHandle> buildButton;
-        std::optional<AudioService::SoundHandle> ordersButton;
+        std::optional<SoundHandle> buildButton;
+        std::optional<SoundHandle> ordersButton;
 
-        std::optional<AudioService::SoundHandle> addBuild;
-        std::optional<AudioService::SoundHandle> okToBuild;
-        std::optional<AudioService::SoundHandle> notOkToBuild;
+        std::optional<SoundHandle> addBuild;
+        std::optional<SoundHandle> okToBuild;
+        std::optional<SoundHandle> notOkToBuild;
 
-        std::optional<AudioService::SoundHandle> selectMultipleUnits;
+        std::optional<SoundHandle> selectMultipleUnits;
     };
 }
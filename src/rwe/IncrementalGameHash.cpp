@@ -0,0 +1,72 @@
+#include "IncrementalGameHash.h"
+#include <algorithm>
+#include <rwe/GameHash_util.h>
+
+namespace rwe
+{
+    GameHash computeUnitEntryHash(UnitId unitId, const Unit& unit)
+    {
+        // must match how computeHashOf(VectorMap) hashes each entry
+        return computeHashOf(unitId) + computeHashOf(unit);
+    }
+
+    GameHash IncrementalGameHash::update(GameSimulation& simulation)
+    {
+        auto& changedUnits = simulation.changedUnits;
+        std::sort(changedUnits.begin(), changedUnits.end(), [](const auto& a, const auto& b) { return a.value < b.value; });
+        changedUnits.erase(std::unique(changedUnits.begin(), changedUnits.end()), changedUnits.end());
+
+        for (const auto& unitId : changedUnits)
+        {
+            auto it = unitHashes.find(unitId);
+            if (it != unitHashes.end())
+            {
+                unitsHash = GameHash(unitsHash.value - it->second.value);
+            }
+
+            auto unit = simulation.tryGetUnit(unitId);
+            if (!unit)
+            {
+                if (it != unitHashes.end())
+                {
+                    unitHashes.erase(it);
+                }
+                continue;
+            }
+
+            auto hash = computeUnitEntryHash(unitId, unit->get());
+            unitsHash += hash;
+            if (it != unitHashes.end())
+            {
+                it->second = hash;
+            }
+            else
+            {
+                unitHashes.emplace(unitId, hash);
+            }
+        }
+
+        changedUnits.clear();
+
+        return combineHashes(
+            simulation.gameTime,
+            simulation.players,
+            unitsHash,
+            simulation.projectiles);
+    }
+
+    void IncrementalGameHash::rebuild(GameSimulation& simulation)
+    {
+        unitHashes.clear();
+        unitsHash = GameHash(0);
+
+        for (const auto& [unitId, unit] : simulation.units)
+        {
+            auto hash = computeUnitEntryHash(unitId, unit);
+            unitsHash += hash;
+            unitHashes.emplace(unitId, hash);
+        }
+
+        simulation.changedUnits.clear();
+    }
+}
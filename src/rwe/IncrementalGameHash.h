@@ -0,0 +1,44 @@
+#pragma once
+
+#include <rwe/GameHash.h>
+#include <rwe/UnitId.h>
+#include <unordered_map>
+
+namespace rwe
+{
+    struct GameSimulation;
+
+    /**
+     * Maintains the hash of a GameSimulation without rehashing every unit each tick.
+     *
+     * The hash of each unit is cached and only recomputed
+     * when the simulation lists the unit in GameSimulation::changedUnits.
+     * Because the simulation hash is a sum of independent parts,
+     * the cached unit hashes can be kept as a running total
+     * and the result is identical to GameSimulation::computeHash,
+     * provided every modification to hashed unit state is recorded.
+     *
+     * Players and projectiles are few or change every tick anyway,
+     * so they are always hashed in full.
+     */
+    class IncrementalGameHash
+    {
+    private:
+        std::unordered_map<UnitId, GameHash> unitHashes;
+        GameHash unitsHash{0};
+
+    public:
+        /**
+         * Brings the cached unit hashes up to date with the units
+         * the simulation has marked as changed, clears the list of changed units
+         * and returns the hash of the whole simulation.
+         */
+        GameHash update(GameSimulation& simulation);
+
+        /**
+         * Discards the cache and rehashes every unit from scratch.
+         * Also clears the simulation's list of changed units.
+         */
+        void rebuild(GameSimulation& simulation);
+    };
+}
@@ -0,0 +1,183 @@
+#pragma once
+
+#include <cassert>
+#include <functional>
+#include <limits>
+#include <vector>
+
+namespace rwe
+{
+    /**
+     * A binary min-heap whose items are identified by dense integer indices
+     * in the range [0, capacity).
+     *
+     * This does the same job as MinHeap, but each item's position in the heap
+     * is kept in a flat array indexed by the item rather than in a hash map,
+     * so pushOrDecrease needs no hashing or allocation.
+     * clear() is O(1). Positions are validated against a generation stamp
+     * instead of being wiped, so the heap can be reused cheaply for many searches.
+     */
+    template <typename Priority, typename LessThan = std::less<Priority>>
+    class IndexedMinHeap
+    {
+    public:
+        struct Entry
+        {
+            Priority priority;
+            std::size_t index;
+        };
+
+    private:
+        std::vector<Entry> heap;
+        std::vector<std::size_t> positions;
+        std::vector<unsigned int> stamps;
+        unsigned int generation{1};
+
+        LessThan lessThan;
+
+    public:
+        IndexedMinHeap() = default;
+        explicit IndexedMinHeap(std::size_t capacity) : positions(capacity), stamps(capacity, 0) {}
+        IndexedMinHeap(std::size_t capacity, const LessThan& lessThan) : positions(capacity), stamps(capacity, 0), lessThan(lessThan) {}
+
+        /** Empties the heap and makes room for indices up to capacity. */
+        void reset(std::size_t capacity)
+        {
+            clear();
+            if (capacity > positions.size())
+            {
+                positions.resize(capacity);
+                stamps.resize(capacity, 0);
+            }
+        }
+
+        void clear()
+        {
+            heap.clear();
+            generation += 1;
+            if (generation == 0)
+            {
+                // The stamp wrapped around, so old stamps could be mistaken for new ones.
+                std::fill(stamps.begin(), stamps.end(), 0);
+                generation = 1;
+            }
+        }
+
+        std::size_t capacity() const
+        {
+            return positions.size();
+        }
+
+        const Entry& top() const
+        {
+            return heap.front();
+        }
+
+        bool empty() const
+        {
+            return heap.empty();
+        }
+
+        bool contains(std::size_t index) const
+        {
+            return stamps[index] == generation && positions[index] != NotInHeap;
+        }
+
+        void pop()
+        {
+            auto firstElement = heap.front();
+            auto lastElement = heap.back();
+            heap.pop_back();
+            positions[lastElement.index] = NotInHeap;
+
+            if (heap.size() > 0)
+            {
+                positions[firstElement.index] = NotInHeap;
+                siftDown(0, lastElement);
+            }
+        }
+
+        /**
+         * Inserts the item if it is not present,
+         * otherwise lowers its priority if the new one is smaller.
+         * Returns true if the heap was changed.
+         */
+        bool pushOrDecrease(std::size_t index, const Priority& priority)
+        {
+            assert(index < positions.size());
+            Entry item{priority, index};
+
+            if (!contains(index))
+            {
+                heap.resize(heap.size() + 1);
+                stamps[index] = generation;
+                siftUp(heap.size() - 1, item);
+                return true;
+            }
+
+            auto position = positions[index];
+            if (!lessThan(item.priority, heap[position].priority))
+            {
+                return false;
+            }
+
+            siftUp(position, item);
+            return true;
+        }
+
+    private:
+        static constexpr std::size_t NotInHeap = std::numeric_limits<std::size_t>::max();
+
+        void siftUp(std::size_t position, const Entry& element)
+        {
+            while (position > 0)
+            {
+                auto parentPosition = (position - 1) / 2;
+                const auto& parentElement = heap[parentPosition];
+                if (!lessThan(element.priority, parentElement.priority))
+                {
+                    break;
+                }
+
+                heap[position] = parentElement;
+                positions[parentElement.index] = position;
+                position = parentPosition;
+            }
+
+            heap[position] = element;
+            positions[element.index] = position;
+        }
+
+        void siftDown(std::size_t position, const Entry& element)
+        {
+            auto firstLeafPosition = heap.size() / 2;
+            while (position < firstLeafPosition) // while non-leaf
+            {
+                auto smallestChildPosition = (position * 2) + 1;
+                const auto* smallestChild = &heap[smallestChildPosition];
+                auto rightChildPosition = (position * 2) + 2;
+                if (rightChildPosition < heap.size())
+                {
+                    const auto* rightChild = &heap[rightChildPosition];
+                    if (lessThan(rightChild->priority, smallestChild->priority))
+                    {
+                        smallestChildPosition = rightChildPosition;
+                        smallestChild = rightChild;
+                    }
+                }
+
+                if (lessThan(element.priority, smallestChild->priority))
+                {
+                    break;
+                }
+
+                heap[position] = *smallestChild;
+                positions[smallestChild->index] = position;
+                position = smallestChildPosition;
+            }
+
+            heap[position] = element;
+            positions[element.index] = position;
+        }
+    };
+}
@@ -1,20 +1,12 @@
 #include "LoadingScene.h"
-#include <boost/interprocess/streams/bufferstream.hpp>
 #include <rwe/GameNetworkService.h>
-#include <rwe/WeaponTdf.h>
+#include <rwe/game_loading.h>
 #include <rwe/ota.h>
 #include <rwe/tdf.h>
-#include <rwe/tnt/TntArchive.h>
 #include <rwe/ui/UiLabel.h>
 
 namespace rwe
 {
-    GameParameters::GameParameters(const std::string& mapName, unsigned int schemaIndex)
-        : mapName(mapName),
-          schemaIndex(schemaIndex)
-    {
-    }
-
     LoadingScene::LoadingScene(
         const SceneContext& sceneContext,
         MapFeatureService* featureService,
@@ -102,35 +94,6 @@ namespace rwe
         panel->render(scaledUiRenderService);
     }
 
-    std::seed_seq seedFromGameParameters(const GameParameters& params)
-    {
-        std::vector<unsigned int> initialVec;
-        std::copy(params.mapName.begin(), params.mapName.end(), std::back_inserter(initialVec));
-
-        for (const auto& e : params.players)
-        {
-            if (!e)
-            {
-                initialVec.push_back(0);
-                continue;
-            }
-
-            initialVec.push_back(e->color.value);
-            initialVec.push_back(e->energy.value);
-            initialVec.push_back(e->metal.value);
-            if (e->name)
-            {
-                std::copy(e->name->begin(), e->name->end(), std::back_inserter(initialVec));
-            }
-            else
-            {
-                initialVec.push_back(0);
-            }
-        }
-
-        return std::seed_seq(initialVec.begin(), initialVec.end());
-    }
-
     std::unique_ptr<GameScene> LoadingScene::createGameScene(const std::string& mapName, unsigned int schemaIndex)
     {
         auto otaRaw = sceneContext.vfs->readFile(std::string("maps/").append(mapName).append(".ota"));
@@ -142,7 +105,7 @@ namespace rwe
         std::string otaStr(otaRaw->begin(), otaRaw->end());
         auto ota = parseOta(parseTdfFromString(otaStr));
 
-        auto simulation = createInitialSimulation(mapName, ota, schemaIndex);
+        auto simulation = createInitialSimulation(sceneContext.vfs, sceneContext.graphics, sceneContext.textureService, sceneContext.palette, featureService, mapName, ota, schemaIndex);
         auto seedSeq = seedFromGameParameters(gameParameters);
         simulation.rng.seed(seedSeq);
 
@@ -160,7 +123,7 @@ namespace rwe
 
         auto meshService = MeshService::createMeshService(sceneContext.vfs, sceneContext.graphics, sceneContext.palette);
 
-        auto unitDatabase = createUnitDatabase();
+        auto unitDatabase = createUnitDatabase(sceneContext.vfs, sceneContext.audioService);
 
         MovementClassCollisionService collisionService;
 
@@ -266,7 +229,9 @@ namespace rwe
             consoleFont,
             *localPlayerId,
             audioLookup,
-            std::move(stateLogStream));
+            std::move(stateLogStream),
+            gameParameters.stateLogInterval,
+            gameParameters.cobProfileFile);
 
         const auto& schema = ota.schemas.at(schemaIndex);
 
@@ -312,236 +277,6 @@ namespace rwe
         return gameScene;
     }
 
-    GameSimulation LoadingScene::createInitialSimulation(const std::string& mapName, const OtaRecord& ota, unsigned int schemaIndex)
-    {
-        auto tntBytes = sceneContext.vfs->readFile("maps/" + mapName + ".tnt");
-        if (!tntBytes)
-        {
-            throw std::runtime_error("Failed to load map bytes");
-        }
-
-        boost::interprocess::bufferstream tntStream(tntBytes->data(), tntBytes->size());
-        TntArchive tnt(&tntStream);
-
-        auto tileTextures = getTileTextures(tnt);
-
-        auto dataGrid = getMapData(tnt);
-
-        Grid<TntTileAttributes> mapAttributes(tnt.getHeader().width, tnt.getHeader().height);
-        tnt.readMapAttributes(mapAttributes.getData());
-
-        auto heightGrid = getHeightGrid(mapAttributes);
-
-        MapTerrain terrain(
-            std::move(tileTextures),
-            std::move(dataGrid),
-            std::move(heightGrid),
-            SimScalar(tnt.getHeader().seaLevel));
-
-        const auto& schema = ota.schemas.at(schemaIndex);
-
-        GameSimulation simulation(std::move(terrain), schema.surfaceMetal);
-
-        auto featureTemplates = getFeatures(tnt);
-
-        for (std::size_t y = 0; y < mapAttributes.getHeight(); ++y)
-        {
-            for (std::size_t x = 0; x < mapAttributes.getWidth(); ++x)
-            {
-                const auto& e = mapAttributes.get(x, y);
-                switch (e.feature)
-                {
-                    case TntTileAttributes::FeatureNone:
-                    case TntTileAttributes::FeatureUnknown:
-                    case TntTileAttributes::FeatureVoid:
-                        break;
-                    default:
-                        const auto& featureTemplate = featureTemplates[e.feature];
-                        auto pos = computeFeaturePosition(simulation.terrain, featureTemplate, x, y);
-                        auto feature = createFeature(pos, featureTemplate);
-                        simulation.addFeature(std::move(feature));
-                }
-            }
-        }
-
-        // add features from the OTA schema
-        for (const auto& f : schema.features)
-        {
-            const auto& featureTemplate = featureService->getFeatureDefinition(f.featureName);
-            auto pos = computeFeaturePosition(simulation.terrain, featureTemplate, f.xPos, f.zPos);
-            auto feature = createFeature(pos, featureTemplate);
-            simulation.addFeature(std::move(feature));
-        }
-
-        return simulation;
-    }
-
-    std::vector<TextureRegion> LoadingScene::getTileTextures(TntArchive& tnt)
-    {
-        static const unsigned int tileWidth = 32;
-        static const unsigned int tileHeight = 32;
-        static const unsigned int textureWidth = 1024;
-        static const unsigned int textureHeight = 1024;
-        static const auto textureWidthInTiles = textureWidth / tileWidth;
-        static const auto textureHeightInTiles = textureHeight / tileHeight;
-        static const auto tilesPerTexture = textureWidthInTiles * textureHeightInTiles;
-
-        std::vector<TextureRegion> tileTextures;
-
-        Grid<Color> textureBuffer(textureWidth, textureHeight);
-
-        std::vector<SharedTextureHandle> textureHandles;
-
-        // read the tile graphics into textures
-        {
-            unsigned int tileCount = 0;
-            tnt.readTiles([this, &tileCount, &textureBuffer, &textureHandles](const char* tile) {
-                if (tileCount == tilesPerTexture)
-                {
-                    SharedTextureHandle handle(sceneContext.graphics->createTexture(textureBuffer));
-                    textureHandles.push_back(std::move(handle));
-                    tileCount = 0;
-                }
-
-                auto tileX = tileCount % textureWidthInTiles;
-                auto tileY = tileCount / textureWidthInTiles;
-                auto startX = tileX * tileWidth;
-                auto startY = tileY * tileHeight;
-                for (unsigned int dy = 0; dy < tileHeight; ++dy)
-                {
-                    for (unsigned int dx = 0; dx < tileWidth; ++dx)
-                    {
-                        auto textureX = startX + dx;
-                        auto textureY = startY + dy;
-                        auto index = static_cast<unsigned char>(tile[(dy * tileWidth) + dx]);
-                        textureBuffer.set(textureX, textureY, (*sceneContext.palette)[index]);
-                    }
-                }
-
-                tileCount += 1;
-            });
-        }
-        textureHandles.emplace_back(sceneContext.graphics->createTexture(textureBuffer));
-
-        // populate the list of texture regions referencing the textures
-        for (unsigned int i = 0; i < tnt.getHeader().numberOfTiles; ++i)
-        {
-            auto textureIndex = i / tilesPerTexture;
-            auto tileIndex = i % tilesPerTexture;
-            const float regionWidth = static_cast<float>(tileWidth) / static_cast<float>(textureWidth);
-            const float regionHeight = static_cast<float>(tileHeight) / static_cast<float>(textureHeight);
-            auto x = tileIndex % textureWidthInTiles;
-            auto y = tileIndex / textureWidthInTiles;
-
-            assert(textureHandles.size() > i / tilesPerTexture);
-            tileTextures.emplace_back(
-                textureHandles[textureIndex],
-                Rectangle2f::fromTopLeft(x * regionWidth, y * regionHeight, regionWidth, regionHeight));
-        }
-
-        return tileTextures;
-    }
-
-    Grid<std::size_t> LoadingScene::getMapData(TntArchive& tnt)
-    {
-        auto mapWidthInTiles = tnt.getHeader().width / 2;
-        auto mapHeightInTiles = tnt.getHeader().height / 2;
-        std::vector<uint16_t> mapData(mapWidthInTiles * mapHeightInTiles);
-        tnt.readMapData(mapData.data());
-        std::vector<std::size_t> dataCopy;
-        dataCopy.reserve(mapData.size());
-        std::copy(mapData.begin(), mapData.end(), std::back_inserter(dataCopy));
-        Grid<std::size_t> dataGrid(mapWidthInTiles, mapHeightInTiles, std::move(dataCopy));
-        return dataGrid;
-    }
-
-    std::vector<FeatureDefinition> LoadingScene::getFeatures(TntArchive& tnt)
-    {
-        std::vector<FeatureDefinition> features;
-
-        tnt.readFeatures([this, &features](const auto& featureName) {
-            const auto& feature = featureService->getFeatureDefinition(featureName);
-            features.push_back(feature);
-        });
-
-        return features;
-    }
-
-    MapFeature LoadingScene::createFeature(const SimVector& pos, const FeatureDefinition& definition)
-    {
-        MapFeature f;
-        f.footprintX = definition.footprintX;
-        f.footprintZ = definition.footprintZ;
-        f.height = SimScalar(definition.height);
-        f.isBlocking = definition.blocking;
-        f.isIndestructible = definition.indestructible;
-        f.metal = definition.metal;
-        f.position = pos;
-        f.transparentAnimation = definition.animTrans;
-        f.transparentShadow = definition.shadTrans;
-        if (!definition.fileName.empty() && !definition.seqName.empty())
-        {
-            f.animation = sceneContext.textureService->getGafEntry("anims/" + definition.fileName + ".GAF", definition.seqName);
-        }
-        if (!f.animation)
-        {
-            f.animation = sceneContext.textureService->getDefaultSpriteSeries();
-        }
-
-        if (!definition.fileName.empty() && !definition.seqNameShad.empty())
-        {
-            // Some third-party features have broken shadow anim names (e.g. "empty"),
-            // ignore them if they don't exist.
-            f.shadowAnimation = sceneContext.textureService->tryGetGafEntry("anims/" + definition.fileName + ".GAF", definition.seqNameShad);
-        }
-
-        return f;
-    }
-
-    Grid<unsigned char> LoadingScene::getHeightGrid(const Grid<TntTileAttributes>& attrs) const
-    {
-        const auto& sourceData = attrs.getVector();
-
-        std::vector<unsigned char> data;
-        data.reserve(sourceData.size());
-
-        std::transform(sourceData.begin(), sourceData.end(), std::back_inserter(data), [](const TntTileAttributes& e) {
-            return e.height;
-        });
-
-        return Grid<unsigned char>(attrs.getWidth(), attrs.getHeight(), std::move(data));
-    }
-
-    SimVector LoadingScene::computeFeaturePosition(
-        const MapTerrain& terrain,
-        const FeatureDefinition& featureDefinition,
-        std::size_t x,
-        std::size_t y) const
-    {
-        const auto& heightmap = terrain.getHeightMap();
-
-        unsigned int height = 0;
-        if (x < heightmap.getWidth() - 1 && y < heightmap.getHeight() - 1)
-        {
-            height = computeMidpointHeight(heightmap, x, y);
-        }
-
-        auto position = terrain.heightmapIndexToWorldCorner(x, y);
-        position.y = SimScalar(height);
-
-        position.x += (SimScalar(featureDefinition.footprintX) * MapTerrain::HeightTileWidthInWorldUnits) / 2_ss;
-        position.z += (SimScalar(featureDefinition.footprintZ) * MapTerrain::HeightTileHeightInWorldUnits) / 2_ss;
-
-        return position;
-    }
-
-    unsigned int LoadingScene::computeMidpointHeight(const Grid<unsigned char>& heightmap, std::size_t x, std::size_t y)
-    {
-        assert(x < heightmap.getWidth() - 1);
-        assert(y < heightmap.getHeight() - 1);
-        return (heightmap.get(x, y) + heightmap.get(x + 1, y) + heightmap.get(x, y + 1) + heightmap.get(x + 1, y + 1)) / 4u;
-    }
-
     const SideData& LoadingScene::getSideData(const std::string& side) const
     {
         auto it = sceneContext.sideData->find(side);
@@ -553,167 +288,6 @@ namespace rwe
         return it->second;
     }
 
-    UnitDatabase LoadingScene::createUnitDatabase()
-    {
-        UnitDatabase db;
-
-        // read sound categories
-        {
-            auto bytes = sceneContext.vfs->readFile("gamedata/SOUND.TDF");
-            if (!bytes)
-            {
-                throw std::runtime_error("Failed to read gamedata/SOUND.TDF");
-            }
-
-            std::string soundString(bytes->data(), bytes->size());
-            auto sounds = parseSoundTdf(parseTdfFromString(soundString));
-            for (auto& s : sounds)
-            {
-                const auto& c = s.second;
-                preloadSound(db, c.select1);
-                preloadSound(db, c.unitComplete);
-                preloadSound(db, c.activate);
-                preloadSound(db, c.deactivate);
-                preloadSound(db, c.ok1);
-                preloadSound(db, c.arrived1);
-                preloadSound(db, c.cant1);
-                preloadSound(db, c.underAttack);
-                preloadSound(db, c.build);
-                preloadSound(db, c.repair);
-                preloadSound(db, c.working);
-                preloadSound(db, c.cloak);
-                preloadSound(db, c.uncloak);
-                preloadSound(db, c.capture);
-                preloadSound(db, c.count5);
-                preloadSound(db, c.count4);
-                preloadSound(db, c.count3);
-                preloadSound(db, c.count2);
-                preloadSound(db, c.count1);
-                preloadSound(db, c.count0);
-                preloadSound(db, c.cancelDestruct);
-                db.addSoundClass(s.first, std::move(s.second));
-            }
-        }
-
-        // read movement classes
-        {
-            auto bytes = sceneContext.vfs->readFile("gamedata/MOVEINFO.TDF");
-            if (!bytes)
-            {
-                throw std::runtime_error("Failed to read gamedata/MOVEINFO.TDF");
-            }
-
-            std::string movementString(bytes->data(), bytes->size());
-            auto classes = parseMovementTdf(parseTdfFromString(movementString));
-            for (auto& c : classes)
-            {
-                auto name = c.second.name;
-                db.addMovementClass(name, std::move(c.second));
-            }
-        }
-
-        // read weapons
-        {
-            auto weaponFiles = sceneContext.vfs->getFileNames("weapons", ".tdf");
-
-            for (const auto& fileName : weaponFiles)
-            {
-                auto bytes = sceneContext.vfs->readFile("weapons/" + fileName);
-                if (!bytes)
-                {
-                    throw std::runtime_error("File in listing could not be read: " + fileName);
-                }
-
-                std::string tdfString(bytes->data(), bytes->size());
-                auto entries = parseWeaponTdf(parseTdfFromString(tdfString));
-
-                for (auto& pair : entries)
-                {
-                    preloadSound(db, pair.second.soundStart);
-                    preloadSound(db, pair.second.soundHit);
-                    preloadSound(db, pair.second.soundWater);
-                    db.addWeapon(pair.first, std::move(pair.second));
-                }
-            }
-        }
-
-        // read unit FBIs
-        {
-            auto fbis = sceneContext.vfs->getFileNames("units", ".fbi");
-
-            for (const auto& fbiName : fbis)
-            {
-                auto bytes = sceneContext.vfs->readFile("units/" + fbiName);
-                if (!bytes)
-                {
-                    throw std::runtime_error("File in listing could not be read: " + fbiName);
-                }
-
-                std::string fbiString(bytes->data(), bytes->size());
-                auto fbi = parseUnitFbi(parseTdfFromString(fbiString));
-
-                // if it's a builder, also attempt to read its gui pages
-                if (fbi.builder)
-                {
-                    auto guiPages = loadBuilderGui(fbi.unitName);
-                    if (guiPages)
-                    {
-                        db.addBuilderGui(fbi.unitName, std::move(*guiPages));
-                    }
-
-                    // TODO: if no gui defined, attempt to build it dynamically?
-                    // Need a database of download.tdf mappings first...
-                }
-
-                db.addUnitInfo(fbi.unitName, fbi);
-            }
-        }
-
-        // read unit scripts
-        {
-            auto scripts = sceneContext.vfs->getFileNames("scripts", ".cob");
-
-            for (const auto& scriptName : scripts)
-            {
-                auto bytes = sceneContext.vfs->readFile("scripts/" + scriptName);
-                if (!bytes)
-                {
-                    throw std::runtime_error("File in listing could not be read: " + scriptName);
-                }
-
-                boost::interprocess::bufferstream s(bytes->data(), bytes->size());
-                auto cob = parseCob(s);
-
-                auto scriptNameWithoutExtension = scriptName.substr(0, scriptName.size() - 4);
-
-                db.addUnitScript(scriptNameWithoutExtension, std::move(cob));
-            }
-        }
-
-        return db;
-    }
-
-    void LoadingScene::preloadSound(UnitDatabase& db, const std::optional<std::string>& soundName)
-    {
-        if (!soundName)
-        {
-            return;
-        }
-
-        preloadSound(db, *soundName);
-    }
-
-    void LoadingScene::preloadSound(UnitDatabase& db, const std::string& soundName)
-    {
-        auto sound = sceneContext.audioService->loadSound(soundName);
-        if (!sound)
-        {
-            return; // sometimes sound categories name invalid sounds
-        }
-
-        db.addSound(soundName, *sound);
-    }
-
     std::optional<AudioService::SoundHandle> LoadingScene::lookUpSound(const std::string& key)
     {
         auto soundBlock = audioLookup->findBlock(key);
@@ -730,25 +304,4 @@ namespace rwe
 
         return sceneContext.audioService->loadSound(*soundName);
     }
-
-    std::optional<std::vector<std::vector<GuiEntry>>> LoadingScene::loadBuilderGui(const std::string& unitName)
-    {
-        std::vector<std::vector<GuiEntry>> entries;
-        for (int i = 1; auto rawGui = sceneContext.vfs->readFile("guis/" + unitName + std::to_string(i) + ".GUI"); ++i)
-        {
-            auto parsedGui = parseGuiFromBytes(*rawGui);
-            if (!parsedGui)
-            {
-                throw std::runtime_error("Failed to parse unit builder GUI: " + unitName + std::to_string(i));
-            }
-            entries.push_back(std::move(*parsedGui));
-        }
-
-        if (entries.empty())
-        {
-            return std::nullopt;
-        }
-
-        return entries;
-    }
 }
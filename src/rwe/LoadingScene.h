@@ -3,7 +3,7 @@
 #include <memory>
 #include <rwe/AudioService.h>
 #include <rwe/CursorService.h>
-#include <rwe/Energy.h>
+#include <rwe/GameParameters.h>
 #include <rwe/GameScene.h>
 #include <rwe/LoadingNetworkService.h>
 #include <rwe/MapFeatureService.h>
@@ -17,73 +17,12 @@
 #include <rwe/UnitDatabase.h>
 #include <rwe/ViewportService.h>
 #include <rwe/ota.h>
-#include <rwe/tnt/TntArchive.h>
 #include <rwe/ui/UiFactory.h>
 #include <rwe/ui/UiLightBar.h>
 #include <rwe/ui/UiPanel.h>
 
 namespace rwe
 {
-    struct PlayerControllerTypeHuman
-    {
-    };
-    struct PlayerControllerTypeComputer
-    {
-    };
-    struct PlayerControllerTypeNetwork
-    {
-        std::string host;
-        std::string port;
-    };
-
-    using PlayerControllerType = std::variant<PlayerControllerTypeHuman, PlayerControllerTypeComputer, PlayerControllerTypeNetwork>;
-
-    class IsHumanVisitor
-    {
-    public:
-        bool operator()(const PlayerControllerTypeHuman&) const { return true; }
-        bool operator()(const PlayerControllerTypeComputer&) const { return false; }
-        bool operator()(const PlayerControllerTypeNetwork&) const { return false; }
-    };
-
-    class IsComputerVisitor
-    {
-    public:
-        bool operator()(const PlayerControllerTypeHuman&) const { return false; }
-        bool operator()(const PlayerControllerTypeComputer&) const { return true; }
-        bool operator()(const PlayerControllerTypeNetwork&) const { return false; }
-    };
-
-    class GetNetworkAddressVisitor
-    {
-    public:
-        std::optional<std::pair<std::reference_wrapper<const std::string>, std::reference_wrapper<const std::string>>> operator()(const PlayerControllerTypeHuman&) const { return std::nullopt; }
-        std::optional<std::pair<std::reference_wrapper<const std::string>, std::reference_wrapper<const std::string>>> operator()(const PlayerControllerTypeComputer&) const { return std::nullopt; }
-        std::optional<std::pair<std::reference_wrapper<const std::string>, std::reference_wrapper<const std::string>>> operator()(const PlayerControllerTypeNetwork& p) const { return std::make_pair(std::cref(p.host), std::cref(p.port)); }
-    };
-
-    struct PlayerInfo
-    {
-        std::optional<std::string> name;
-        PlayerControllerType controller;
-        std::string side;
-        PlayerColorIndex color;
-
-        Metal metal;
-        Energy energy;
-    };
-
-    struct GameParameters
-    {
-        std::string mapName;
-        unsigned int schemaIndex;
-        std::array<std::optional<PlayerInfo>, 10> players;
-        std::string localNetworkPort{"1337"};
-        std::optional<std::string> stateLogFile;
-
-        GameParameters(const std::string& mapName, unsigned int schemaIndex);
-    };
-
     class LoadingScene : public SceneManager::Scene
     {
     private:
@@ -121,34 +60,10 @@ namespace rwe
         void render() override;
 
     private:
-        static unsigned int computeMidpointHeight(const Grid<unsigned char>& heightmap, std::size_t x, std::size_t y);
-
         std::unique_ptr<GameScene> createGameScene(const std::string& mapName, unsigned int schemaIndex);
 
-        GameSimulation createInitialSimulation(const std::string& mapName, const rwe::OtaRecord& ota, unsigned int schemaIndex);
-
-        std::vector<TextureRegion> getTileTextures(TntArchive& tnt);
-
-        Grid<std::size_t> getMapData(TntArchive& tnt);
-
-        Grid<unsigned char> getHeightGrid(const Grid<TntTileAttributes>& attrs) const;
-
-        std::vector<FeatureDefinition> getFeatures(TntArchive& tnt);
-
-        MapFeature createFeature(const SimVector& pos, const FeatureDefinition& definition);
-
-        SimVector computeFeaturePosition(const MapTerrain& terrain, const FeatureDefinition& featureDefinition, std::size_t x, std::size_t y) const;
-
         const SideData& getSideData(const std::string& side) const;
 
-        UnitDatabase createUnitDatabase();
-
-        void preloadSound(UnitDatabase& db, const std::string& soundName);
-
-        void preloadSound(UnitDatabase& db, const std::optional<std::string>& soundName);
-
         std::optional<AudioService::SoundHandle> lookUpSound(const std::string& key);
-
-        std::optional<std::vector<std::vector<GuiEntry>>> loadBuilderGui(const std::string& unitName);
     };
 }
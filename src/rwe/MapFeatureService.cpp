@@ -9,15 +9,13 @@ namespace rwe
 
         for (const auto& name : files)
         {
-            auto bytes = vfs->readFile("features/" + name);
+            auto bytes = vfs->readFileView("features/" + name);
             if (!bytes)
             {
                 throw std::runtime_error("Failed to read feature " + name);
             }
 
-            std::string tdfString(bytes->data(), bytes->size());
-
-            auto tdfRoot = parseTdfFromString(tdfString);
+            auto tdfRoot = parseTdfFromBytes(bytes->asStringView());
             for (const auto& e : tdfRoot.blocks)
             {
                 auto featureDefinition = FeatureDefinition::fromTdf(*e.second);
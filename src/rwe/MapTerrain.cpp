@@ -33,7 +33,7 @@ namespace rwe
         auto newX = (position.x + (widthInWorldUnits / 2_ss)) / TileWidthInWorldUnits;
         auto newY = (position.z + (heightInWorldUnits / 2_ss)) / TileHeightInWorldUnits;
 
-        return Point(static_cast<int>(newX.value), static_cast<int>(newY.value));
+        return Point(simScalarToInt(newX), simScalarToInt(newY));
     }
 
     SimVector MapTerrain::tileCoordinateToWorldCorner(int x, int y) const
@@ -50,7 +50,7 @@ namespace rwe
     Point MapTerrain::worldToHeightmapCoordinate(const SimVector& position) const
     {
         auto heightPos = worldToHeightmapSpace(position);
-        return Point(static_cast<int>(heightPos.x.value), static_cast<int>(heightPos.z.value));
+        return Point(simScalarToInt(heightPos.x), simScalarToInt(heightPos.z));
     }
 
     Point MapTerrain::worldToHeightmapCoordinateNearest(const SimVector& position) const
@@ -178,7 +178,7 @@ namespace rwe
     std::optional<SimVector> MapTerrain::intersectLine(const Line3x<SimScalar>& line) const
     {
         auto heightmapPosition = worldToHeightmapSpace(line.start);
-        Point startCell(static_cast<int>(heightmapPosition.x.value), static_cast<int>(heightmapPosition.z.value));
+        Point startCell(simScalarToInt(heightmapPosition.x), simScalarToInt(heightmapPosition.z));
 
         auto ray = Ray3x<SimScalar>::fromLine(line);
 
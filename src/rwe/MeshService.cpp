@@ -106,13 +106,13 @@ namespace rwe
         // load all the textures into memory
         for (const auto& gafName : gafs)
         {
-            auto bytes = vfs->readFile("textures/" + gafName);
+            auto bytes = vfs->readFileView("textures/" + gafName);
             if (!bytes)
             {
                 throw std::runtime_error("File in listing could not be read: " + gafName);
             }
 
-            boost::interprocess::bufferstream stream(bytes->data(), bytes->size());
+            boost::interprocess::ibufferstream stream(bytes->data(), bytes->size());
             GafArchive gaf(&stream);
 
             bool isTeamDependent = toUpper(gafName) == "LOGOS.GAF";
@@ -181,19 +181,25 @@ namespace rwe
                 });
         }
 
-        SharedTextureHandle atlasTexture(graphics->createTexture(atlas));
+        SharedTextureHandle atlasTexture;
+        if (graphics != nullptr)
+        {
+            atlasTexture = SharedTextureHandle(graphics->createTexture(atlas));
+        }
 
-        return MeshService(vfs, palette, std::move(atlasTexture), std::move(atlasMap), std::move(attribs), std::move(atlasColorMap));
+        return MeshService(vfs, graphics, palette, std::move(atlasTexture), std::move(atlasMap), std::move(attribs), std::move(atlasColorMap));
     }
 
     MeshService::MeshService(
         AbstractVirtualFileSystem* vfs,
+        GraphicsContext* graphics,
         const ColorPalette* palette,
         SharedTextureHandle&& atlas,
         std::unordered_map<FrameId, Rectangle2f>&& atlasMap,
         std::unordered_map<std::string, TextureAttributes> textureAttributesMap,
         std::vector<Vector2f>&& atlasColorMap)
         : vfs(vfs),
+          graphics(graphics),
           palette(palette),
           atlas(std::move(atlas)),
           atlasMap(std::move(atlasMap)),
@@ -258,48 +264,80 @@ namespace rwe
     UnitMesh MeshService::unitMeshFrom3do(const _3do::Object& o, const PlayerColorIndex& teamColor)
     {
         UnitMesh m;
-        m.origin = Vector3x<SimScalar>(
+        appendUnitMeshPieces(m, o, std::nullopt, teamColor);
+        return m;
+    }
+
+    void MeshService::appendUnitMeshPieces(UnitMesh& m, const _3do::Object& o, std::optional<unsigned int> parent, const PlayerColorIndex& teamColor)
+    {
+        auto index = static_cast<unsigned int>(m.pieces.size());
+
+        auto& piece = m.pieces.emplace_back();
+        piece.parent = parent;
+        piece.origin = Vector3x<SimScalar>(
             simScalarFromFixed(o.x),
             simScalarFromFixed(o.y),
             -simScalarFromFixed(o.z)); // flip to convert from left-handed to right-handed
-        m.name = o.name;
+        piece.name = o.name;
         auto mesh = meshFrom3do(o, teamColor);
-        m.mesh = std::make_shared<ShaderMesh>(convertMesh(mesh));
+        piece.mesh = std::make_shared<ShaderMesh>(convertMesh(mesh));
 
         for (const auto& c : o.children)
         {
-            m.children.push_back(unitMeshFrom3do(c, teamColor));
+            appendUnitMeshPieces(m, c, index, teamColor);
         }
-
-        return m;
     }
 
     MeshService::UnitMeshInfo MeshService::loadUnitMesh(const std::string& name, const PlayerColorIndex& teamColor)
     {
-        auto bytes = vfs->readFile("objects3d/" + name + ".3do");
+        MeshId id(toUpper(name), teamColor.value);
+        auto it = unitMeshPrototypes.find(id);
+        if (it == unitMeshPrototypes.end())
+        {
+            it = unitMeshPrototypes.insert({std::move(id), readUnitMesh(name, teamColor)}).first;
+        }
+
+        return it->second;
+    }
+
+    UnitMesh MeshService::loadProjectileMesh(const std::string& name, const PlayerColorIndex& teamColor)
+    {
+        MeshId id(toUpper(name), teamColor.value);
+        auto it = projectileMeshPrototypes.find(id);
+        if (it == projectileMeshPrototypes.end())
+        {
+            it = projectileMeshPrototypes.insert({std::move(id), readProjectileMesh(name, teamColor)}).first;
+        }
+
+        return it->second;
+    }
+
+    MeshService::UnitMeshInfo MeshService::readUnitMesh(const std::string& name, const PlayerColorIndex& teamColor)
+    {
+        auto bytes = vfs->readFileView("objects3d/" + name + ".3do");
         if (!bytes)
         {
             throw std::runtime_error("Failed to load object bytes: " + name);
         }
 
-        boost::interprocess::bufferstream s(bytes->data(), bytes->size());
+        boost::interprocess::ibufferstream s(bytes->data(), bytes->size());
         auto objects = parse3doObjects(s, s.tellg());
         assert(objects.size() == 1);
         auto selectionMesh = selectionMeshFrom3do(objects.front());
         auto unitMesh = unitMeshFrom3do(objects.front(), teamColor);
         auto unitHeight = findHighestVertex(objects.front()).y;
-        return UnitMeshInfo{std::move(unitMesh), std::move(selectionMesh), simScalarFromFixed(unitHeight)};
+        return UnitMeshInfo{std::move(unitMesh), std::make_shared<SelectionMesh>(std::move(selectionMesh)), simScalarFromFixed(unitHeight)};
     }
 
-    UnitMesh MeshService::loadProjectileMesh(const std::string& name, const PlayerColorIndex& teamColor)
+    UnitMesh MeshService::readProjectileMesh(const std::string& name, const PlayerColorIndex& teamColor)
     {
-        auto bytes = vfs->readFile("objects3d/" + name + ".3do");
+        auto bytes = vfs->readFileView("objects3d/" + name + ".3do");
         if (!bytes)
         {
             throw std::runtime_error("Failed to load object bytes: " + name);
         }
 
-        boost::interprocess::bufferstream s(bytes->data(), bytes->size());
+        boost::interprocess::ibufferstream s(bytes->data(), bytes->size());
         auto objects = parse3doObjects(s, s.tellg());
         assert(objects.size() == 1);
         return unitMeshFrom3do(objects.front(), teamColor);
@@ -366,6 +404,11 @@ namespace rwe
 
     GlMesh MeshService::createSelectionMesh(const Vector3f& a, const Vector3f& b, const Vector3f& c, const Vector3f& d)
     {
+        if (graphics == nullptr)
+        {
+            return GlMesh(VaoHandle(), VboHandle(), 0);
+        }
+
         const Vector3f color(0.325f, 0.875f, 0.310f);
 
         std::vector<GlColoredVertex> buffer{
@@ -386,6 +429,11 @@ namespace rwe
 
     ShaderMesh MeshService::convertMesh(const Mesh& mesh)
     {
+        if (graphics == nullptr)
+        {
+            return ShaderMesh(mesh.texture, GlMesh(VaoHandle(), VboHandle(), 0));
+        }
+
         std::vector<GlTexturedNormalVertex> texturedVerticesBuffer;
         texturedVerticesBuffer.reserve(mesh.faces.size() * 3);
 
@@ -35,6 +35,16 @@ namespace rwe
             bool isTeamDependent;
         };
 
+        struct UnitMeshInfo
+        {
+            UnitMesh mesh;
+            std::shared_ptr<SelectionMesh> selectionMesh;
+            SimScalar height;
+        };
+
+        /** Identifies a loaded mesh by its upper-cased object name and team color. */
+        using MeshId = std::pair<std::string, unsigned int>;
+
     private:
         AbstractVirtualFileSystem* vfs;
         GraphicsContext* graphics;
@@ -44,7 +54,20 @@ namespace rwe
         std::unordered_map<std::string, TextureAttributes> textureAttributesMap;
         std::vector<Vector2f> atlasColorMap;
 
+        /**
+         * Meshes already loaded from disk.
+         * Their piece GPU buffers and selection meshes are shared
+         * with every mesh copied from them.
+         */
+        std::unordered_map<MeshId, UnitMeshInfo> unitMeshPrototypes;
+        std::unordered_map<MeshId, UnitMesh> projectileMeshPrototypes;
+
     public:
+        /**
+         * graphics may be null, in which case nothing is uploaded to the GPU.
+         * Meshes still carry their geometry, selection quads and heights,
+         * which is all the simulation needs.
+         */
         static MeshService createMeshService(
             AbstractVirtualFileSystem* vfs,
             GraphicsContext* graphics,
@@ -52,24 +75,29 @@ namespace rwe
 
         MeshService(
             AbstractVirtualFileSystem* vfs,
+            GraphicsContext* graphics,
             const ColorPalette* palette,
             SharedTextureHandle&& atlas,
             std::unordered_map<FrameId, Rectangle2f>&& atlasMap,
             std::unordered_map<std::string, TextureAttributes> textureAttributesMap,
             std::vector<Vector2f>&& atlasColorMap);
 
-        struct UnitMeshInfo
-        {
-            UnitMesh mesh;
-            SelectionMesh selectionMesh;
-            SimScalar height;
-        };
-
+        /**
+         * Returns a copy of the unit mesh with the given name and team color.
+         * The object is only read from disk and uploaded to the GPU
+         * the first time it is asked for.
+         * After that the copy just duplicates the pieces' transform state.
+         */
         UnitMeshInfo loadUnitMesh(const std::string& name, const PlayerColorIndex& teamColor);
 
+        /** Returns a copy of the projectile mesh, cached as for unit meshes. */
         UnitMesh loadProjectileMesh(const std::string& name, const PlayerColorIndex& teamColor);
 
     private:
+        UnitMeshInfo readUnitMesh(const std::string& name, const PlayerColorIndex& teamColor);
+
+        UnitMesh readProjectileMesh(const std::string& name, const PlayerColorIndex& teamColor);
+
         SharedTextureHandle getMeshTextureAtlas();
         Rectangle2f getTextureRegion(const std::string& name, const PlayerColorIndex& teamColor);
         Vector2f getColorTexturePoint(unsigned int colorIndex);
@@ -78,6 +106,8 @@ namespace rwe
 
         UnitMesh unitMeshFrom3do(const _3do::Object& o, const PlayerColorIndex& teamColor);
 
+        void appendUnitMeshPieces(UnitMesh& m, const _3do::Object& o, std::optional<unsigned int> parent, const PlayerColorIndex& teamColor);
+
         SelectionMesh selectionMeshFrom3do(const _3do::Object& o);
 
         GlMesh createSelectionMesh(const Vector3f& a, const Vector3f& b, const Vector3f& c, const Vector3f& d);
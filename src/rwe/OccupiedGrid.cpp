@@ -1,33 +1,80 @@
 #include "OccupiedGrid.h"
-#include <rwe/FeatureId.h>
 
 namespace rwe
 {
-    OccupiedUnit::OccupiedUnit(const UnitId& id) : id(id)
+    /**
+     * Returns true if f returns true for any cell in the region.
+     * Each row is scanned in full without stopping early,
+     * so the inner loop has no branches and can be vectorised.
+     */
+    template <typename Func>
+    static bool anyInRegion(const OccupiedGrid& grid, const GridRegion& region, Func f)
     {
+        for (unsigned int y = region.y; y < region.y + region.height; ++y)
+        {
+            const auto* row = grid.getData() + grid.toIndex(region.x, y);
+            bool found = false;
+            for (unsigned int x = 0; x < region.width; ++x)
+            {
+                found |= f(row[x]);
+            }
+
+            if (found)
+            {
+                return true;
+            }
+        }
+
+        return false;
     }
 
-    bool OccupiedUnit::operator==(const OccupiedUnit& rhs) const
+    bool isCollisionAt(const OccupiedGrid& grid, const DiscreteRect& rect)
     {
-        return id == rhs.id;
+        auto region = grid.tryToRegion(rect);
+        if (!region)
+        {
+            return true;
+        }
+
+        return isCollisionAt(grid, *region);
     }
 
-    bool OccupiedUnit::operator!=(const OccupiedUnit& rhs) const
+    bool isCollisionAt(const OccupiedGrid& grid, const GridRegion& region)
     {
-        return !(rhs == *this);
+        return anyInRegion(grid, region, [](const OccupiedCell& cell) { return cell.isBlocking(); });
     }
 
-    OccupiedFeature::OccupiedFeature(const FeatureId& id) : id(id)
+    bool isCollisionAt(const OccupiedGrid& grid, const DiscreteRect& rect, UnitId self)
     {
+        auto region = grid.tryToRegion(rect);
+        if (!region)
+        {
+            return true;
+        }
+
+        return anyInRegion(grid, *region, [self](const OccupiedCell& cell) { return cell.isBlockingFor(self); });
     }
 
-    bool OccupiedFeature::operator==(const OccupiedFeature& rhs) const
+    bool isAdjacentToObstacle(const OccupiedGrid& grid, const DiscreteRect& rect)
     {
-        return id == rhs.id;
+        DiscreteRect top(rect.x - 1, rect.y - 1, rect.width + 2, 1);
+        DiscreteRect bottom(rect.x - 1, rect.y + rect.width, rect.width + 2, 1);
+        DiscreteRect left(rect.x - 1, rect.y, 1, rect.height);
+        DiscreteRect right(rect.x + rect.width, rect.y, 1, rect.height);
+        return isCollisionAt(grid, top)
+            || isCollisionAt(grid, bottom)
+            || isCollisionAt(grid, left)
+            || isCollisionAt(grid, right);
     }
 
-    bool OccupiedFeature::operator!=(const OccupiedFeature& rhs) const
+    bool isStaticCollisionAt(const OccupiedGrid& grid, const DiscreteRect& rect)
     {
-        return !(rhs == *this);
+        auto region = grid.tryToRegion(rect);
+        if (!region)
+        {
+            return true;
+        }
+
+        return anyInRegion(grid, *region, [](const OccupiedCell& cell) { return cell.isStaticallyBlocking(); });
     }
 }
@@ -1,54 +1,210 @@
 #pragma once
 
+#include <cstdint>
+#include <optional>
+#include <rwe/DiscreteRect.h>
 #include <rwe/FeatureId.h>
 #include <rwe/Grid.h>
 #include <rwe/UnitId.h>
-#include <variant>
+#include <stdexcept>
+#include <string>
 
 namespace rwe
 {
-    struct OccupiedUnit
+    enum class OccupiedType : std::uint32_t
     {
-        UnitId id;
-
-        explicit OccupiedUnit(const UnitId& id);
-
-        bool operator==(const OccupiedUnit& rhs) const;
+        None = 0,
+        Unit = 1,
+        Feature = 2
+    };
 
-        bool operator!=(const OccupiedUnit& rhs) const;
+    struct BuildingOccupiedCell
+    {
+        UnitId unit;
+        bool passable;
     };
 
-    struct OccupiedFeature
+    /**
+     * What occupies one cell of the map, packed into 8 bytes
+     * so that collision scans touch as little memory as possible.
+     *
+     * A cell holds at most one occupant, either a mobile unit or a feature,
+     * and independently may be part of a building's yard,
+     * which may be passable or not.
+     *
+     * Ids are stored in the upper 30 bits of each word,
+     * so ids stored in a cell must be less than MaxIdValue.
+     * Storing a larger id throws rather than corrupting the low bits.
+     */
+    class OccupiedCell
     {
-        FeatureId id;
+    public:
+        static constexpr std::uint32_t MaxIdValue = 1u << 30;
 
-        explicit OccupiedFeature(const FeatureId& id);
+    private:
+        static constexpr std::uint32_t IdShift = 2;
+        static constexpr std::uint32_t TypeMask = 0x3;
+        static constexpr std::uint32_t BuildingPresentBit = 0x1;
+        static constexpr std::uint32_t BuildingPassableBit = 0x2;
+        static constexpr std::uint32_t BuildingFlagsMask = BuildingPresentBit | BuildingPassableBit;
 
-        bool operator==(const OccupiedFeature& rhs) const;
+        /** The occupant's id, shifted up, with its OccupiedType in the low bits. */
+        std::uint32_t occupant{0};
 
-        bool operator!=(const OccupiedFeature& rhs) const;
-    };
+        /** The building's unit id, shifted up, with the present and passable bits in the low bits. */
+        std::uint32_t building{0};
 
-    struct OccupiedNone
-    {
-        bool operator==(const OccupiedNone&) const { return true; }
+        static std::uint32_t packId(std::uint32_t id)
+        {
+            if (id >= MaxIdValue)
+            {
+                throw std::out_of_range("Id too large to store in an occupied cell: " + std::to_string(id));
+            }
+            return id << IdShift;
+        }
 
-        bool operator!=(const OccupiedNone&) const { return true; }
-    };
+    public:
+        static OccupiedCell fromUnit(const UnitId& unitId)
+        {
+            OccupiedCell cell;
+            cell.setUnit(unitId);
+            return cell;
+        }
 
-    using OccupiedType = std::variant<OccupiedNone, OccupiedUnit, OccupiedFeature>;
+        static OccupiedCell fromFeature(const FeatureId& featureId)
+        {
+            OccupiedCell cell;
+            cell.setFeature(featureId);
+            return cell;
+        }
 
-    struct BuildingOccupiedCell
-    {
-        UnitId unit;
-        bool passable;
-    };
+        OccupiedType getOccupiedType() const
+        {
+            return static_cast<OccupiedType>(occupant & TypeMask);
+        }
 
-    struct OccupiedCell
-    {
-        OccupiedType occupiedType;
-        std::optional<BuildingOccupiedCell> buildingCell;
+        std::optional<UnitId> getUnit() const
+        {
+            if (getOccupiedType() != OccupiedType::Unit)
+            {
+                return std::nullopt;
+            }
+            return UnitId(occupant >> IdShift);
+        }
+
+        std::optional<FeatureId> getFeature() const
+        {
+            if (getOccupiedType() != OccupiedType::Feature)
+            {
+                return std::nullopt;
+            }
+            return FeatureId(occupant >> IdShift);
+        }
+
+        void setUnit(const UnitId& unitId)
+        {
+            occupant = packId(unitId.value) | static_cast<std::uint32_t>(OccupiedType::Unit);
+        }
+
+        void setFeature(const FeatureId& featureId)
+        {
+            occupant = packId(featureId.value) | static_cast<std::uint32_t>(OccupiedType::Feature);
+        }
+
+        void clearOccupant()
+        {
+            occupant = 0;
+        }
+
+        std::optional<BuildingOccupiedCell> getBuildingCell() const
+        {
+            if ((building & BuildingPresentBit) == 0)
+            {
+                return std::nullopt;
+            }
+            return BuildingOccupiedCell{UnitId(building >> IdShift), (building & BuildingPassableBit) != 0};
+        }
+
+        bool hasBuildingCell() const
+        {
+            return (building & BuildingPresentBit) != 0;
+        }
+
+        bool isBuildingCellOf(const UnitId& unitId) const
+        {
+            return hasBuildingCell() && (building >> IdShift) == unitId.value;
+        }
+
+        void setBuildingCell(const BuildingOccupiedCell& buildingCell)
+        {
+            building = packId(buildingCell.unit.value) | BuildingPresentBit | (buildingCell.passable ? BuildingPassableBit : 0);
+        }
+
+        void clearBuildingCell()
+        {
+            building = 0;
+        }
+
+        /** True if the cell is part of a building's yard that can't be walked through. */
+        bool hasImpassableBuilding() const
+        {
+            return (building & BuildingFlagsMask) == BuildingPresentBit;
+        }
+
+        /** True if a unit or feature is here, or the cell is impassable building. */
+        bool isBlocking() const
+        {
+            return ((occupant & TypeMask) != 0) | hasImpassableBuilding();
+        }
+
+        /** As isBlocking, but ignoring anything belonging to the given unit. */
+        bool isBlockingFor(const UnitId& self) const
+        {
+            auto selfOccupant = (self.value << IdShift) | static_cast<std::uint32_t>(OccupiedType::Unit);
+            bool occupantBlocks = ((occupant & TypeMask) != 0) & (occupant != selfOccupant);
+            bool buildingBlocks = hasImpassableBuilding() & ((building >> IdShift) != self.value);
+            return occupantBlocks | buildingBlocks;
+        }
+
+        /** True if a feature or impassable building is here. Mobile units are not counted. */
+        bool isStaticallyBlocking() const
+        {
+            return ((occupant & TypeMask) == static_cast<std::uint32_t>(OccupiedType::Feature)) | hasImpassableBuilding();
+        }
+
+        bool operator==(const OccupiedCell& rhs) const
+        {
+            return occupant == rhs.occupant && building == rhs.building;
+        }
+
+        bool operator!=(const OccupiedCell& rhs) const
+        {
+            return !(rhs == *this);
+        }
     };
 
+    static_assert(sizeof(OccupiedCell) == 8, "OccupiedCell should pack into 8 bytes");
+
     using OccupiedGrid = Grid<OccupiedCell>;
+
+    /**
+     * Returns true if anything occupies the given region,
+     * or if the region lies partly outside the grid.
+     */
+    bool isCollisionAt(const OccupiedGrid& grid, const DiscreteRect& rect);
+
+    bool isCollisionAt(const OccupiedGrid& grid, const GridRegion& region);
+
+    /**
+     * As above, but cells occupied by the given unit are ignored.
+     */
+    bool isCollisionAt(const OccupiedGrid& grid, const DiscreteRect& rect, UnitId self);
+
+    bool isAdjacentToObstacle(const OccupiedGrid& grid, const DiscreteRect& rect);
+
+    /**
+     * Returns true if a feature or impassable building occupies the given region,
+     * or if the region lies partly outside the grid.
+     */
+    bool isStaticCollisionAt(const OccupiedGrid& grid, const DiscreteRect& rect);
 }
@@ -5,25 +5,6 @@
 
 namespace rwe
 {
-    class IsOccupiedVisitor
-    {
-    public:
-        bool operator()(const OccupiedNone&) const
-        {
-            return false;
-        }
-
-        bool operator()(const OccupiedUnit&) const
-        {
-            return true;
-        }
-
-        bool operator()(const OccupiedFeature&) const
-        {
-            return true;
-        }
-    };
-
     RenderService::RenderService(
         GraphicsContext* graphics,
         ShaderService* shaders,
@@ -51,7 +32,7 @@ namespace rwe
         graphics->bindShader(shader.handle.get());
         graphics->setUniformMatrix(shader.mvpMatrix, camera.getViewProjectionMatrix() * matrix);
         graphics->setUniformFloat(shader.alpha, 1.0f);
-        graphics->drawLineLoop(unit.selectionMesh.visualMesh);
+        graphics->drawLineLoop(unit.selectionMesh->visualMesh);
     }
 
     void RenderService::drawNanolatheLine(const Vector3f& start, const Vector3f& end)
@@ -78,27 +59,44 @@ namespace rwe
         }
     }
 
-    void RenderService::drawUnitMesh(const UnitMesh& mesh, const Matrix4f& modelMatrix, float seaLevel)
+    void RenderService::computePieceMatrices(const UnitMesh& mesh, const Matrix4f& modelMatrix)
     {
-        auto matrix = modelMatrix * toFloatMatrix(mesh.getTransform());
-
-        if (mesh.visible)
+        // the simulation keeps the transforms within the unit up to date
+        const auto& pieceTransforms = mesh.getPieceTransforms();
+        pieceMatrices.resize(pieceTransforms.size());
+        for (std::size_t i = 0; i < pieceTransforms.size(); ++i)
         {
-            drawShaderMesh(*mesh.mesh, matrix, seaLevel, mesh.shaded);
+            pieceMatrices[i] = modelMatrix * toFloatMatrix(pieceTransforms[i]);
         }
+    }
 
-        for (const auto& c : mesh.children)
+    void RenderService::drawUnitMesh(const UnitMesh& mesh, const Matrix4f& modelMatrix, float seaLevel)
+    {
+        computePieceMatrices(mesh, modelMatrix);
+
+        for (std::size_t i = 0; i < mesh.pieces.size(); ++i)
         {
-            drawUnitMesh(c, matrix, seaLevel);
+            const auto& piece = mesh.pieces[i];
+            if (piece.visible)
+            {
+                drawShaderMesh(*piece.mesh, pieceMatrices[i], seaLevel, piece.shaded);
+            }
         }
     }
 
     void RenderService::drawBuildingUnitMesh(const UnitMesh& mesh, const Matrix4f& modelMatrix, float seaLevel, float percentComplete, float unitY, float time)
     {
-        auto matrix = modelMatrix * toFloatMatrix(mesh.getTransform());
+        computePieceMatrices(mesh, modelMatrix);
 
-        if (mesh.visible)
+        for (std::size_t i = 0; i < mesh.pieces.size(); ++i)
         {
+            const auto& piece = mesh.pieces[i];
+            if (!piece.visible)
+            {
+                continue;
+            }
+
+            const auto& matrix = pieceMatrices[i];
             auto mvpMatrix = camera.getViewProjectionMatrix() * matrix;
 
             // TODO: draw colored vertices
@@ -106,22 +104,17 @@ namespace rwe
             {
                 const auto& buildShader = shaders->unitBuild;
                 graphics->bindShader(buildShader.handle.get());
-                graphics->bindTexture(mesh.mesh->texture.get());
+                graphics->bindTexture(piece.mesh->texture.get());
                 graphics->setUniformMatrix(buildShader.mvpMatrix, mvpMatrix);
                 graphics->setUniformMatrix(buildShader.modelMatrix, matrix);
                 graphics->setUniformFloat(buildShader.unitY, unitY);
                 graphics->setUniformFloat(buildShader.seaLevel, seaLevel);
-                graphics->setUniformBool(buildShader.shade, mesh.shaded);
+                graphics->setUniformBool(buildShader.shade, piece.shaded);
                 graphics->setUniformFloat(buildShader.percentComplete, percentComplete);
                 graphics->setUniformFloat(buildShader.time, time);
-                graphics->drawTriangles(mesh.mesh->texturedVertices);
+                graphics->drawTriangles(piece.mesh->texturedVertices);
             }
         }
-
-        for (const auto& c : mesh.children)
-        {
-            drawBuildingUnitMesh(c, matrix, seaLevel, percentComplete, unitY, time);
-        }
     }
 
     void RenderService::drawOccupiedGrid(const MapTerrain& terrain, const OccupiedGrid& occupiedGrid)
@@ -174,7 +167,7 @@ namespace rwe
                 lines.emplace_back(pos, downPos);
 
                 const auto& cell = occupiedGrid.get(x, y);
-                if (std::visit(IsOccupiedVisitor(), cell.occupiedType))
+                if (cell.getOccupiedType() != OccupiedType::None)
                 {
                     auto downRightPos = simVectorToFloat(terrain.heightmapIndexToWorldCorner(x + 1, y + 1));
                     downRightPos.y = terrain.getHeightMap().get(x + 1, y + 1);
@@ -185,7 +178,7 @@ namespace rwe
 
                 const auto insetAmount = 4.0f;
 
-                if (cell.buildingCell && !cell.buildingCell->passable)
+                if (cell.hasImpassableBuilding())
                 {
                     auto topLeftPos = pos + Vector3f(insetAmount, 0.0f, insetAmount);
                     auto topRightPos = rightPos + Vector3f(-insetAmount, 0.0f, insetAmount);
@@ -198,7 +191,7 @@ namespace rwe
                     buildingTris.emplace_back(topLeftPos, downRightPos, topRightPos);
                 }
 
-                if (cell.buildingCell && cell.buildingCell->passable)
+                if (cell.hasBuildingCell() && !cell.hasImpassableBuilding())
                 {
                     auto topLeftPos = pos + Vector3f(insetAmount, 0.0f, insetAmount);
                     auto topRightPos = rightPos + Vector3f(-insetAmount, 0.0f, insetAmount);
@@ -315,13 +308,13 @@ namespace rwe
 
         for (const auto& item : pathInfo.closedVertices)
         {
-            if (!item.second.predecessor)
+            if (!item.predecessor)
             {
                 continue;
             }
 
-            auto start = (*item.second.predecessor)->vertex;
-            auto end = item.second.vertex;
+            auto start = *item.predecessor;
+            auto end = item.vertex;
             drawTerrainArrow(terrain, start, end, Color(255, 0, 0));
         }
 
@@ -527,7 +520,7 @@ namespace rwe
             auto position = simVectorToFloat(projectile.position);
 
             match(
-                projectile.renderType,
+                projectile.weapon->renderType,
                 [&](const ProjectileRenderTypeLaser& l) {
                     auto backPosition = simVectorToFloat(projectile.getBackPosition(l));
 
@@ -41,6 +41,9 @@ namespace rwe
 
         CabinetCamera camera;
 
+        /** Scratch space for the world matrix of each piece of the mesh being drawn. */
+        std::vector<Matrix4f> pieceMatrices;
+
     public:
         RenderService(
             GraphicsContext* graphics,
@@ -120,6 +123,8 @@ namespace rwe
     private:
         void drawShaderMesh(const ShaderMesh& mesh, const Matrix4f& matrix, float seaLevel, bool shaded);
 
+        void computePieceMatrices(const UnitMesh& mesh, const Matrix4f& modelMatrix);
+
         GlMesh createTemporaryLinesMesh(const std::vector<Line3f>& lines);
 
         GlMesh createTemporaryLinesMesh(const std::vector<Line3f>& lines, const Color& color);
@@ -7,6 +7,7 @@
 #include <rwe/SceneManager.h>
 #include <rwe/SideData.h>
 #include <rwe/TextureService.h>
+#include <rwe/ThreadPool.h>
 #include <rwe/ViewportService.h>
 #include <rwe/rwe_time.h>
 #include <rwe/vfs/AbstractVirtualFileSystem.h>
@@ -30,6 +31,7 @@ namespace rwe
         const std::unordered_map<std::string, SideData>* const sideData;
         TimeService* const timeService;
         const GlobalConfig* const globalConfig;
+        ThreadPool* const threadPool;
 
         SceneContext(
             SdlContext* const sdl,
@@ -45,7 +47,8 @@ namespace rwe
             SceneManager* const sceneManager,
             const std::unordered_map<std::string, SideData>* const sideData,
             TimeService* const timeService,
-            const GlobalConfig* const globalConfig)
+            const GlobalConfig* const globalConfig,
+            ThreadPool* const threadPool)
             : sdl(sdl),
               viewportService(viewportService),
               graphics(graphics),
@@ -59,7 +62,8 @@ namespace rwe
               sceneManager(sceneManager),
               sideData(sideData),
               timeService(timeService),
-              globalConfig(globalConfig)
+              globalConfig(globalConfig),
+              threadPool(threadPool)
         {
         }
     };
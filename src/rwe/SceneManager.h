@@ -2,6 +2,7 @@
 
 #include <memory>
 #include <rwe/CursorService.h>
+#include <rwe/GameTime.h>
 #include <rwe/GlobalConfig.h>
 #include <rwe/GraphicsContext.h>
 #include <rwe/ImGuiContext.h>
@@ -58,7 +59,7 @@ namespace rwe
 
     public:
         // Number of milliseconds between each game tick.
-        static const unsigned int TickInterval = 1000 / 60;
+        static const unsigned int TickInterval = rwe::TickInterval;
 
         explicit SceneManager(SdlContext* sdl, SDL_Window* window, GraphicsContext* graphics, TimeService* timeService, ImGuiContext* imGuiContext, CursorService* cursorService, GlobalConfig* globalConfig, UiRenderService&& uiRenderService);
         void setNextScene(std::shared_ptr<Scene> scene);
@@ -13,6 +13,28 @@ namespace rwe
     {
         return SimAngle(static_cast<uint16_t>(std::round((angle.value / Pif) * 32768.0f)));
     }
+#ifdef RWE_FIXED_POINT_SIM
+    SimAngle atan(SimScalar v)
+    {
+        return SimAngle(fixedAtan2(v, 1_ss));
+    }
+    SimAngle atan2(SimScalar a, SimScalar b)
+    {
+        return SimAngle(fixedAtan2(a, b));
+    }
+    SimScalar hypot(SimScalar a, SimScalar b)
+    {
+        return sqrt((a * a) + (b * b));
+    }
+    SimScalar cos(SimAngle a)
+    {
+        return fixedCos(a.value);
+    }
+    SimScalar sin(SimAngle a)
+    {
+        return fixedSin(a.value);
+    }
+#else
     SimAngle atan(SimScalar v)
     {
         return fromRadians(RadiansAngle::fromUnwrappedAngle(std::atan(v.value)));
@@ -33,6 +55,7 @@ namespace rwe
     {
         return SimScalar(std::sin(toRadians(a).value));
     }
+#endif
     SimAngle angleBetween(SimAngle a, SimAngle b)
     {
         auto turn = b - a;
@@ -31,10 +31,11 @@ namespace rwe
 
     SimAngle fromRadians(RadiansAngle angle);
 
+    /** Converts a non-negative number of angular units into an angle. */
     inline SimAngle simAngleFromSimScalar(SimScalar s)
     {
-        assert(s.value >= 0.0f);
-        return SimAngle(static_cast<uint16_t>(s.value));
+        assert(s >= 0_ss);
+        return SimAngle(static_cast<uint16_t>(simScalarToUInt(s)));
     }
 
     SimAngle atan(SimScalar v);
@@ -9,8 +9,10 @@ namespace rwe
         return s > 0_ss ? s : -s;
     }
 
+#ifndef RWE_FIXED_POINT_SIM
     SimScalar sqrt(SimScalar s)
     {
         return SimScalar(std::sqrt(s.value));
     }
+#endif
 }
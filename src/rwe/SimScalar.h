@@ -1,11 +1,29 @@
 #pragma once
 
+#include <rwe/FixedSimScalar.h>
 #include <rwe/OpaqueField.h>
 
 namespace rwe
 {
     struct SimScalarTag;
-    using SimScalar = OpaqueField<float, SimScalarTag>;
+
+    using FloatSimScalar = OpaqueField<float, SimScalarTag>;
+
+    /**
+     * The number type used for all game simulation state.
+     * Builds with RWE_FIXED_POINT_SIM use fixed-point arithmetic,
+     * which gives bit-identical results on every platform.
+     * Other builds use floats.
+     *
+     * Code outside the simulation should convert
+     * with the helpers below rather than touching the value field,
+     * whose meaning differs between the two.
+     */
+#ifdef RWE_FIXED_POINT_SIM
+    using SimScalar = FixedSimScalar;
+#else
+    using SimScalar = FloatSimScalar;
+#endif
 
     constexpr SimScalar operator"" _ss(unsigned long long val)
     {
@@ -17,6 +35,44 @@ namespace rwe
         return SimScalar(val);
     }
 
+#ifdef RWE_FIXED_POINT_SIM
+    inline float simScalarToFloat(SimScalar s)
+    {
+        return static_cast<float>(s.value) / static_cast<float>(SimScalar::One);
+    }
+
+    inline SimScalar floatToSimScalar(float f)
+    {
+        return SimScalar(f);
+    }
+
+    inline unsigned int simScalarToUInt(SimScalar s)
+    {
+        return static_cast<unsigned int>(s.value / SimScalar::One);
+    }
+
+    /** Rounds towards zero. */
+    inline int simScalarToInt(SimScalar s)
+    {
+        return static_cast<int>(s.value / SimScalar::One);
+    }
+
+    inline int roundToInt(SimScalar s)
+    {
+        return static_cast<int>((s + 0.5_ssf).value / SimScalar::One);
+    }
+
+    inline SimScalar simScalarFromFixed(int f)
+    {
+        return SimScalar::fromRaw(f);
+    }
+
+    inline int simScalarToFixed(SimScalar f)
+    {
+        return static_cast<int>(f.value);
+    }
+
+#else
     inline float simScalarToFloat(SimScalar s)
     {
         return static_cast<float>(s.value);
@@ -32,6 +88,12 @@ namespace rwe
         return static_cast<unsigned int>(s.value);
     }
 
+    /** Rounds towards zero. */
+    inline int simScalarToInt(SimScalar s)
+    {
+        return static_cast<int>(s.value);
+    }
+
     inline int roundToInt(SimScalar s)
     {
         return static_cast<int>((s + 0.5_ssf).value);
@@ -47,12 +109,20 @@ namespace rwe
         return static_cast<int>(f.value * 65536.0f);
     }
 
+#endif
+
     SimScalar abs(SimScalar s);
 
     SimScalar sqrt(SimScalar s);
 
+    /** Converts from TA angular units (65536 per turn) to radians. */
     inline SimScalar angularToRadians(SimScalar s)
     {
+#ifdef RWE_FIXED_POINT_SIM
+        // 2pi in 16.16 fixed point
+        return SimScalar::fromRaw((s.value * 411775) / 65536);
+#else
         return SimScalar((s.value / 65536.0f) * 2.0f * 3.14159265358979323846f);
+#endif
     }
 }
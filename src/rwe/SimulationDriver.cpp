@@ -0,0 +1,1047 @@
+#include "SimulationDriver.h"
+#include <algorithm>
+#include <cassert>
+#include <rwe/overloaded.h>
+#include <rwe/rwe_time.h>
+#include <spdlog/spdlog.h>
+#include <tuple>
+
+namespace rwe
+{
+    bool projectileCollides(const GameSimulation& sim, const Projectile& projectile, const OccupiedCell& cellValue)
+    {
+        // Most cells a projectile passes over are empty.
+        if (!cellValue.isBlocking())
+        {
+            return false;
+        }
+
+        if (auto unitId = cellValue.getUnit(); unitId)
+        {
+            const auto& unit = sim.getUnit(*unitId);
+
+            // ignore if the unit is ours,
+            // or if the projectile is above or below the unit
+            if (!unit.isOwnedBy(projectile.owner) && projectile.position.y >= unit.position.y && projectile.position.y <= unit.position.y + unit.height)
+            {
+                return true;
+            }
+        }
+        else if (auto featureId = cellValue.getFeature(); featureId)
+        {
+            const auto& feature = sim.getFeature(*featureId);
+
+            // ignore if the projectile is above or below the feature
+            if (projectile.position.y >= feature.position.y && projectile.position.y <= feature.position.y + feature.height)
+            {
+                return true;
+            }
+        }
+
+        if (cellValue.hasImpassableBuilding())
+        {
+            const auto& unit = sim.getUnit(cellValue.getBuildingCell()->unit);
+
+            if (unit.isOwnedBy(projectile.owner))
+            {
+                return false;
+            }
+
+            // ignore if the projectile is above or below the unit
+            if (projectile.position.y < unit.position.y || projectile.position.y > unit.position.y + unit.height)
+            {
+                return false;
+            }
+
+            return true;
+        }
+
+        return false;
+    }
+
+    /** The unit fields included in the game hash that updateResources may modify. */
+    static auto getHashedResourceState(const Unit& unit)
+    {
+        return std::make_tuple(
+            unit.isSufficientlyPowered,
+            unit.energyProductionBuffer,
+            unit.metalProductionBuffer,
+            unit.previousEnergyConsumptionBuffer,
+            unit.previousMetalConsumptionBuffer,
+            unit.energyConsumptionBuffer,
+            unit.metalConsumptionBuffer);
+    }
+
+    SimulationTickTimings& SimulationTickTimings::operator+=(const SimulationTickTimings& rhs)
+    {
+        playerCommands += rhs.playerCommands;
+        resources += rhs.resources;
+        pathFinding += rhs.pathFinding;
+        unitBehavior += rhs.unitBehavior;
+        unitAnimation += rhs.unitAnimation;
+        unitScripts += rhs.unitScripts;
+        projectiles += rhs.projectiles;
+        explosions += rhs.explosions;
+        cleanup += rhs.cleanup;
+        hash += rhs.hash;
+        return *this;
+    }
+
+    SimulationDriver::SimulationDriver(
+        GameSimulation* simulation,
+        MovementClassCollisionService* collisionService,
+        UnitFactory* unitFactory,
+        TextureService* textureService,
+        ThreadPool* threadPool)
+        : simulation(simulation),
+          unitFactory(unitFactory),
+          textureService(textureService),
+          threadPool(threadPool),
+          pathFindingService(simulation, collisionService, threadPool),
+          cobExecutionService(),
+          unitBehaviorService(this, unitFactory, &cobExecutionService)
+    {
+    }
+
+    void SimulationDriver::tick(const std::vector<std::pair<PlayerId, std::vector<PlayerCommand>>>& playerCommands)
+    {
+        lastTickTimings = SimulationTickTimings();
+
+        simulation->gameTime += GameTime(1);
+
+        auto start = getTimestamp();
+        processPlayerCommands(playerCommands);
+        auto afterCommands = getTimestamp();
+        lastTickTimings.playerCommands = afterCommands - start;
+
+        // run resource updates once per second
+        if (simulation->gameTime % GameTime(60) == GameTime(0))
+        {
+            updateResources();
+        }
+        auto afterResources = getTimestamp();
+        lastTickTimings.resources = afterResources - afterCommands;
+
+        pathFindingService.update();
+        auto afterPathFinding = getTimestamp();
+        lastTickTimings.pathFinding = afterPathFinding - afterResources;
+
+        // records its own per-phase timings
+        updateUnits();
+
+        auto beforeProjectiles = getTimestamp();
+        updateProjectiles();
+        auto afterProjectiles = getTimestamp();
+        lastTickTimings.projectiles = afterProjectiles - beforeProjectiles;
+
+        updateExplosions();
+        auto afterExplosions = getTimestamp();
+        lastTickTimings.explosions = afterExplosions - afterProjectiles;
+
+        killDeadCommanderOwners();
+
+        deleteDeadUnits();
+
+        deleteDeadProjectiles();
+
+        spawnNewUnits();
+
+        auto afterCleanup = getTimestamp();
+        lastTickTimings.cleanup = afterCleanup - afterExplosions;
+
+        updateHash();
+        lastTickTimings.hash = getTimestamp() - afterCleanup;
+    }
+
+    GameHash SimulationDriver::getGameHash() const
+    {
+        return gameHash;
+    }
+
+    SimulationSnapshot SimulationDriver::captureSnapshot() const
+    {
+        auto snapshot = rwe::captureSnapshot(*simulation);
+        snapshot.pendingPaths = pathFindingService.capturePendingPaths();
+        return snapshot;
+    }
+
+    void SimulationDriver::restoreSnapshot(const SimulationSnapshot& snapshot)
+    {
+        rwe::restoreSnapshot(snapshot, *simulation, *unitFactory);
+        pathFindingService.restorePendingPaths(snapshot.pendingPaths);
+
+        for (auto& entry : simulation->units)
+        {
+            entry.second.cobEnvironment->setProfilingEnabled(cobProfilingEnabled);
+        }
+
+        incrementalHash.rebuild(*simulation);
+        gameHash = simulation->computeHash();
+    }
+
+    void SimulationDriver::updateHash()
+    {
+        gameHash = incrementalHash.update(*simulation);
+
+        // Any code that modifies hashed unit state without marking the unit changed
+        // leaves the incremental hash stale, so every so often compare it
+        // with a full recompute.
+        // A mismatch is a bug in the simulation, so debug builds stop here.
+        // Release builds resynchronise rather than desync from their peers.
+        if (simulation->gameTime % FullHashCheckInterval == GameTime(0))
+        {
+            auto fullHash = simulation->computeHash();
+            if (fullHash != gameHash)
+            {
+                spdlog::get("rwe")->critical("Incremental game hash {0} did not match full hash {1} at game time {2}, a unit was modified without being marked changed", gameHash.value, fullHash.value, simulation->gameTime.value);
+                assert(fullHash == gameHash);
+                incrementalHash.rebuild(*simulation);
+                gameHash = fullHash;
+            }
+        }
+    }
+
+    const SimulationTickTimings& SimulationDriver::getLastTickTimings() const
+    {
+        return lastTickTimings;
+    }
+
+    void SimulationDriver::setCobProfilingEnabled(bool enabled)
+    {
+        if (enabled == cobProfilingEnabled)
+        {
+            return;
+        }
+
+        // keep whatever was counted since the last tick
+        collectCobProfiles();
+
+        cobProfilingEnabled = enabled;
+        for (auto& entry : simulation->units)
+        {
+            entry.second.cobEnvironment->setProfilingEnabled(enabled);
+        }
+    }
+
+    bool SimulationDriver::isCobProfilingEnabled() const
+    {
+        return cobProfilingEnabled;
+    }
+
+    const CobProfiler& SimulationDriver::getCobProfiler() const
+    {
+        return cobProfiler;
+    }
+
+    void SimulationDriver::clearCobProfile()
+    {
+        collectCobProfiles();
+        cobProfiler.clear();
+    }
+
+    void SimulationDriver::collectCobProfiles()
+    {
+        if (!cobProfilingEnabled)
+        {
+            return;
+        }
+
+        for (auto& entry : simulation->units)
+        {
+            cobProfiler.collect(entry.second.unitType, *entry.second.cobEnvironment);
+        }
+    }
+
+    Observable<const SimulationEvent&>& SimulationDriver::events()
+    {
+        return eventsSubject;
+    }
+
+    const PathFindingService& SimulationDriver::getPathFindingService() const
+    {
+        return pathFindingService;
+    }
+
+    GameSimulation& SimulationDriver::getSimulation()
+    {
+        return *simulation;
+    }
+
+    const GameSimulation& SimulationDriver::getSimulation() const
+    {
+        return *simulation;
+    }
+
+    const MapTerrain& SimulationDriver::getTerrain() const
+    {
+        return simulation->terrain;
+    }
+
+    GameTime SimulationDriver::getGameTime() const
+    {
+        return simulation->gameTime;
+    }
+
+    DiscreteRect SimulationDriver::computeFootprintRegion(const SimVector& position, unsigned int footprintX, unsigned int footprintZ) const
+    {
+        return simulation->computeFootprintRegion(position, footprintX, footprintZ);
+    }
+
+    bool SimulationDriver::isCollisionAt(const DiscreteRect& rect, UnitId self) const
+    {
+        return simulation->isCollisionAt(rect, self);
+    }
+
+    void SimulationDriver::moveUnitOccupiedArea(const DiscreteRect& oldRect, const DiscreteRect& newRect, UnitId unitId)
+    {
+        simulation->moveUnitOccupiedArea(oldRect, newRect, unitId);
+    }
+
+    std::optional<UnitId> SimulationDriver::spawnUnit(const std::string& unitType, PlayerId owner, const SimVector& position)
+    {
+        // TODO: if we failed to add the unit throw some warning
+        auto unitId = simulation->tryAddUnit(
+            unitFactory->createUnit(unitType, owner, simulation->getPlayer(owner).color, position));
+
+        if (unitId)
+        {
+            if (cobProfilingEnabled)
+            {
+                simulation->getUnit(*unitId).cobEnvironment->setProfilingEnabled(true);
+            }
+            unitBehaviorService.onCreate(*unitId);
+            eventsSubject.next(UnitSpawnedEvent{*unitId});
+        }
+
+        return unitId;
+    }
+
+    void SimulationDriver::spawnCompletedUnit(const std::string& unitType, PlayerId owner, const SimVector& position)
+    {
+        auto unitId = spawnUnit(unitType, owner, position);
+        if (unitId)
+        {
+            auto& unit = simulation->getUnit(*unitId);
+            // units start as unbuilt nanoframes,
+            // we we need to convert it immediately into a completed unit.
+            unit.finishBuilding();
+        }
+    }
+
+    void SimulationDriver::playNotificationSound(const PlayerId& playerId, const SoundHandle& sound)
+    {
+        eventsSubject.next(PlayNotificationSoundEvent{playerId, sound});
+    }
+
+    void SimulationDriver::playSoundAt(const Vector3f& position, const SoundHandle& sound)
+    {
+        eventsSubject.next(PlaySoundAtEvent{position, sound});
+    }
+
+    void SimulationDriver::updateResources()
+    {
+        for (auto& player : simulation->players)
+        {
+            player.metal += player.metalProductionBuffer;
+            player.metalProductionBuffer = Metal(0);
+            player.energy += player.energyProductionBuffer;
+            player.energyProductionBuffer = Energy(0);
+
+            if (player.metal > Metal(0))
+            {
+                player.metal -= player.actualMetalConsumptionBuffer;
+                player.actualMetalConsumptionBuffer = Metal(0);
+                player.metalStalled = false;
+            }
+            else
+            {
+                player.metalStalled = true;
+            }
+
+            player.previousDesiredMetalConsumptionBuffer = player.desiredMetalConsumptionBuffer;
+            player.desiredMetalConsumptionBuffer = Metal(0);
+
+            if (player.energy > Energy(0))
+            {
+                player.energy -= player.actualEnergyConsumptionBuffer;
+                player.actualEnergyConsumptionBuffer = Energy(0);
+                player.energyStalled = false;
+            }
+            else
+            {
+                player.energyStalled = true;
+            }
+
+            player.previousDesiredEnergyConsumptionBuffer = player.desiredEnergyConsumptionBuffer;
+            player.desiredEnergyConsumptionBuffer = Energy(0);
+
+            if (player.metal > player.maxMetal)
+            {
+                player.metal = player.maxMetal;
+            }
+
+            if (player.energy > player.maxEnergy)
+            {
+                player.energy = player.maxEnergy;
+            }
+        }
+
+        for (auto& entry : simulation->units)
+        {
+            const auto& unitId = entry.first;
+            auto& unit = entry.second;
+
+            // Most units make and use the same amounts every tick,
+            // so only mark those whose hashed resource state actually moved.
+            auto resourceStateBefore = getHashedResourceState(unit);
+
+            unit.resetResourceBuffers();
+
+            if (!unit.isBeingBuilt())
+            {
+                simulation->addResourceDelta(unitId, unit.energyMake, unit.metalMake);
+            }
+
+            if (unit.activated)
+            {
+                if (unit.isSufficientlyPowered)
+                {
+                    // extract metal
+                    if (unit.extractsMetal != Metal(0))
+                    {
+                        auto footprint = computeFootprintRegion(unit.position, unit.footprintX, unit.footprintZ);
+                        auto metalValue = simulation->metalGrid.accumulate(simulation->metalGrid.clipRegion(footprint), 0u, std::plus<>());
+                        simulation->addResourceDelta(unitId, Energy(0), Metal(metalValue * unit.extractsMetal.value));
+                    }
+                }
+
+                unit.isSufficientlyPowered = simulation->addResourceDelta(unitId, -unit.energyUse, -unit.metalUse);
+            }
+
+            if (getHashedResourceState(unit) != resourceStateBefore)
+            {
+                simulation->changedUnits.push_back(unitId);
+            }
+        }
+    }
+
+    void SimulationDriver::updateUnits()
+    {
+        cobExecutionService.wakeSleepingThreads(*simulation);
+
+        auto start = getTimestamp();
+        for (auto& entry : simulation->units)
+        {
+            unitBehaviorService.update(entry.first);
+        }
+        auto afterBehavior = getTimestamp();
+
+        // gathered after behavior, which may have created units
+        updatedUnitIds.clear();
+        for (const auto& entry : simulation->units)
+        {
+            updatedUnitIds.push_back(entry.first);
+        }
+
+        // Animation only touches the unit's own pieces,
+        // so units can be animated in parallel.
+        threadPool->forEachChunk(updatedUnitIds.size(), CobExecutionService::MinUnitsPerJob, [this](std::size_t, std::size_t begin, std::size_t end) {
+            for (auto i = begin; i < end; ++i)
+            {
+                auto& unit = simulation->getUnit(updatedUnitIds[i]);
+                if (unit.mesh.update(SecondsPerTick))
+                {
+                    unit.cobEnvironment->blockedQueueDirty = true;
+                }
+            }
+        });
+        auto afterAnimation = getTimestamp();
+
+        // run unit scripts, then apply what they did to the rest of the world
+        cobUnitCommands.clear();
+        cobExecutionService.runUnits(*threadPool, *simulation, updatedUnitIds, cobUnitCommands);
+        for (const auto& command : cobUnitCommands)
+        {
+            applyCobUnitCommand(command);
+        }
+        auto afterScripts = getTimestamp();
+
+        lastTickTimings.unitBehavior += afterBehavior - start;
+        lastTickTimings.unitAnimation += afterAnimation - afterBehavior;
+        lastTickTimings.unitScripts += afterScripts - afterAnimation;
+
+        collectCobProfiles();
+    }
+
+    void SimulationDriver::updateProjectiles()
+    {
+        auto gameTime = getGameTime();
+        for (auto& [id, projectile] : simulation->projectiles)
+        {
+            // remove if it's time to die
+            if (projectile.dieOnFrame && *projectile.dieOnFrame <= gameTime)
+            {
+                projectile.isDead = true;
+                continue;
+            }
+
+            if (projectile.gravity)
+            {
+                projectile.velocity.y -= 112_ss / 6000_ss;
+            }
+            projectile.position += projectile.velocity;
+
+            // emit smoke trail
+            if (projectile.weapon->smokeTrail)
+            {
+                if (gameTime > projectile.lastSmoke + *projectile.weapon->smokeTrail)
+                {
+                    createLightSmoke(projectile.position);
+                    projectile.lastSmoke = gameTime;
+                }
+            }
+
+            // test collision with terrain
+            auto terrainHeight = simulation->terrain.tryGetHeightAt(projectile.position.x, projectile.position.z);
+            if (!terrainHeight)
+            {
+                // silently remove projectiles that go outside the map
+                projectile.isDead = true;
+                continue;
+            }
+
+            auto seaLevel = simulation->terrain.getSeaLevel();
+
+            // test collision with sea
+            // FIXME: waterweapons should be allowed in water
+            if (seaLevel > terrainHeight && projectile.position.y <= seaLevel)
+            {
+                doProjectileImpact(projectile, ImpactType::Water);
+                projectile.isDead = true;
+            }
+            else if (projectile.position.y <= terrainHeight)
+            {
+                doProjectileImpact(projectile, ImpactType::Normal);
+                projectile.isDead = true;
+            }
+            else
+            {
+                // detect collision with something's footprint
+                auto heightMapPos = simulation->terrain.worldToHeightmapCoordinate(projectile.position);
+                auto cellValue = simulation->occupiedGrid.tryGet(heightMapPos);
+                if (cellValue)
+                {
+                    auto collides = projectileCollides(*simulation, projectile, cellValue->get());
+                    if (collides)
+                    {
+                        doProjectileImpact(projectile, ImpactType::Normal);
+                        projectile.isDead = true;
+                    }
+                }
+            }
+        }
+    }
+
+    void SimulationDriver::updateExplosions()
+    {
+        auto end = simulation->explosions.end();
+        for (auto it = simulation->explosions.begin(); it != end;)
+        {
+            auto& exp = *it;
+            if (exp.isFinished(simulation->gameTime))
+            {
+                exp = std::move(*--end);
+                continue;
+            }
+
+            if (exp.floats)
+            {
+                // TODO: drift with the wind
+                exp.position.y += 0.5_ssf;
+            }
+
+            ++it;
+        }
+        simulation->explosions.erase(end, simulation->explosions.end());
+    }
+
+    void SimulationDriver::killDeadCommanderOwners()
+    {
+        // if a commander died this frame, kill the player that owns it
+        for (const auto& p : simulation->units)
+        {
+            if (p.second.isCommander() && p.second.isDead())
+            {
+                killPlayer(p.second.owner);
+            }
+        }
+    }
+
+    void SimulationDriver::doProjectileImpact(const Projectile& projectile, ImpactType impactType)
+    {
+        const auto& weapon = *projectile.weapon;
+        switch (impactType)
+        {
+            case ImpactType::Normal:
+            {
+                if (weapon.soundHit)
+                {
+                    playSoundAt(simVectorToFloat(projectile.position), *weapon.soundHit);
+                }
+                if (weapon.explosion)
+                {
+                    simulation->spawnExplosion(projectile.position, *weapon.explosion);
+                }
+                if (weapon.endSmoke)
+                {
+                    createLightSmoke(projectile.position);
+                }
+                break;
+            }
+            case ImpactType::Water:
+            {
+                if (weapon.soundWater)
+                {
+                    playSoundAt(simVectorToFloat(projectile.position), *weapon.soundWater);
+                }
+                if (weapon.waterExplosion)
+                {
+                    simulation->spawnExplosion(projectile.position, *weapon.waterExplosion);
+                }
+                break;
+            }
+        }
+
+        applyDamageInRadius(projectile.position, weapon.damageRadius, projectile);
+    }
+
+    void SimulationDriver::applyDamageInRadius(const SimVector& position, SimScalar radius, const Projectile& projectile)
+    {
+        auto radiusSquared = radius * radius;
+
+        for (const auto& unitId : simulation->findUnitsNear(position, radius))
+        {
+            const auto& unit = simulation->getUnit(unitId);
+
+            // skip dead units
+            if (unit.isDead())
+            {
+                continue;
+            }
+
+            // check that a cell the unit occupies is in range.
+            // Passable yard cells don't count, so buildings are not hit through them.
+            auto footprintRegion = simulation->occupiedGrid.clipRegion(simulation->computeFootprintRegion(unit.position, unit.footprintX, unit.footprintZ));
+            auto occupiesCellInRange = footprintRegion.any([&](const auto& coords) {
+                const auto& cell = simulation->occupiedGrid.get(coords);
+                auto occupant = cell.getUnit();
+                auto building = cell.getBuildingCell();
+                auto occupiedByUnit = occupant
+                    ? *occupant == unitId
+                    : building && !building->passable && building->unit == unitId;
+                if (!occupiedByUnit)
+                {
+                    return false;
+                }
+
+                auto cellCenter = simulation->terrain.heightmapIndexToWorldCenter(coords.x, coords.y);
+                Rectangle2x<SimScalar> cellRectangle(
+                    Vector2x<SimScalar>(cellCenter.x, cellCenter.z),
+                    Vector2x<SimScalar>(MapTerrain::HeightTileWidthInWorldUnits / 2_ss, MapTerrain::HeightTileHeightInWorldUnits / 2_ss));
+                return cellRectangle.distanceSquared(Vector2x<SimScalar>(position.x, position.z)) <= radiusSquared;
+            });
+            if (!occupiesCellInRange)
+            {
+                continue;
+            }
+
+            // add in the third dimension component to distance,
+            // check if we are still in range
+            auto unitDistanceSquared = createBoundingBox(unit).distanceSquared(position);
+            if (unitDistanceSquared > radiusSquared)
+            {
+                continue;
+            }
+
+            // apply appropriate damage
+            auto damageScale = std::clamp(1_ss - (sqrt(unitDistanceSquared) / radius), 0_ss, 1_ss);
+            auto rawDamage = projectile.weapon->getDamage(unit.unitTypeId);
+            auto scaledDamage = simScalarToUInt(SimScalar(rawDamage) * damageScale);
+            applyDamage(unitId, scaledDamage);
+        }
+    }
+
+    void SimulationDriver::applyDamage(UnitId unitId, unsigned int damagePoints)
+    {
+        auto& unit = simulation->getUnit(unitId);
+        if (unit.hitPoints <= damagePoints)
+        {
+            killUnit(unitId);
+        }
+        else
+        {
+            unit.hitPoints -= damagePoints;
+            simulation->changedUnits.push_back(unitId);
+        }
+    }
+
+    void SimulationDriver::createLightSmoke(const SimVector& position)
+    {
+        simulation->spawnSmoke(position, textureService->getGafEntry("anims/FX.GAF", "smoke 1"));
+    }
+
+    void SimulationDriver::activateUnit(UnitId unitId)
+    {
+        auto unit = simulation->tryGetUnit(unitId);
+        if (unit)
+        {
+            unit->get().activate();
+            simulation->changedUnits.push_back(unitId);
+
+            if (unit->get().activateSound)
+            {
+                playNotificationSound(unit->get().owner, *unit->get().activateSound);
+            }
+
+            eventsSubject.next(UnitActivationChangedEvent{unitId, true});
+        }
+    }
+
+    void SimulationDriver::deactivateUnit(UnitId unitId)
+    {
+        auto unit = simulation->tryGetUnit(unitId);
+        if (unit)
+        {
+            unit->get().deactivate();
+            simulation->changedUnits.push_back(unitId);
+
+            if (unit->get().deactivateSound)
+            {
+                playNotificationSound(unit->get().owner, *unit->get().deactivateSound);
+            }
+
+            eventsSubject.next(UnitActivationChangedEvent{unitId, false});
+        }
+    }
+
+    void SimulationDriver::modifyBuildQueue(UnitId unitId, const std::string& unitType, int count)
+    {
+        auto unit = simulation->tryGetUnit(unitId);
+        if (unit)
+        {
+            unit->get().modifyBuildQueue(unitType, count);
+
+            eventsSubject.next(UnitBuildQueueChangedEvent{unitId, unitType, count});
+        }
+    }
+
+    void SimulationDriver::setBuildStance(UnitId unitId, bool value)
+    {
+        simulation->getUnit(unitId).inBuildStance = value;
+        simulation->changedUnits.push_back(unitId);
+    }
+
+    void SimulationDriver::setYardOpen(UnitId unitId, bool value)
+    {
+        simulation->trySetYardOpen(unitId, value);
+    }
+
+    void SimulationDriver::setBuggerOff(UnitId unitId, bool value)
+    {
+        if (value)
+        {
+            simulation->emitBuggerOff(unitId);
+        }
+    }
+
+    void SimulationDriver::applyCobUnitCommand(const CobUnitCommand& command)
+    {
+        match(
+            command.command,
+            [&](const CobUnitCommand::SetActivation& c) {
+                if (c.value)
+                {
+                    activateUnit(command.unit);
+                }
+                else
+                {
+                    deactivateUnit(command.unit);
+                }
+            },
+            [&](const CobUnitCommand::SetBuildStance& c) {
+                setBuildStance(command.unit, c.value);
+            },
+            [&](const CobUnitCommand::SetYardOpen& c) {
+                setYardOpen(command.unit, c.value);
+            },
+            [&](const CobUnitCommand::BuggerOff&) {
+                setBuggerOff(command.unit, true);
+            });
+    }
+
+    void SimulationDriver::deleteDeadUnits()
+    {
+        for (auto it = simulation->units.begin(); it != simulation->units.end();)
+        {
+            const auto& unit = it->second;
+            if (unit.isDead())
+            {
+                eventsSubject.next(UnitDeletedEvent{it->first});
+
+                auto footprintRect = computeFootprintRegion(unit.position, unit.footprintX, unit.footprintZ);
+                auto footprintRegion = simulation->occupiedGrid.tryToRegion(footprintRect);
+                assert(!!footprintRegion);
+                if (unit.isMobile)
+                {
+                    simulation->occupiedGrid.forEach(*footprintRegion, [](auto& cell) {
+                        cell.clearOccupant();
+                    });
+                }
+                else
+                {
+                    simulation->occupiedGrid.forEach(*footprintRegion, [&](auto& cell) {
+                        if (cell.isBuildingCellOf(it->first))
+                        {
+                            cell.clearBuildingCell();
+                        }
+                    });
+                    simulation->staticCollisionChanges.push_back(footprintRect);
+                }
+                simulation->occupiedGridChanges.push_back(footprintRect);
+
+                simulation->unitIndex.remove(it->first, footprintRect);
+                simulation->changedUnits.push_back(it->first);
+
+                it = simulation->units.erase(it);
+            }
+            else
+            {
+                ++it;
+            }
+        }
+    }
+
+    void SimulationDriver::deleteDeadProjectiles()
+    {
+        for (auto it = simulation->projectiles.begin(); it != simulation->projectiles.end();)
+        {
+            const auto& projectile = it->second;
+            if (projectile.isDead)
+            {
+                it = simulation->projectiles.erase(it);
+            }
+            else
+            {
+                ++it;
+            }
+        }
+    }
+
+    void SimulationDriver::spawnNewUnits()
+    {
+        for (const auto& unitId : simulation->unitCreationRequests)
+        {
+            auto unit = simulation->tryGetUnit(unitId);
+            if (!unit)
+            {
+                continue;
+            }
+
+            if (auto s = std::get_if<CreatingUnitState>(&unit->get().behaviourState); s != nullptr)
+            {
+
+                if (!std::holds_alternative<UnitCreationStatusPending>(s->status))
+                {
+                    continue;
+                }
+
+                auto newUnitId = spawnUnit(s->unitType, s->owner, s->position);
+                simulation->changedUnits.push_back(unitId);
+                if (!newUnitId)
+                {
+                    s->status = UnitCreationStatusFailed();
+                    continue;
+                }
+
+                s->status = UnitCreationStatusDone{*newUnitId};
+            }
+
+            if (auto s = std::get_if<FactoryStateCreatingUnit>(&unit->get().factoryState); s != nullptr)
+            {
+                if (!std::holds_alternative<UnitCreationStatusPending>(s->status))
+                {
+                    continue;
+                }
+
+                auto newUnitId = spawnUnit(s->unitType, s->owner, s->position);
+                if (!newUnitId)
+                {
+                    s->status = UnitCreationStatusFailed();
+                    continue;
+                }
+
+                s->status = UnitCreationStatusDone{*newUnitId};
+            }
+        }
+
+        simulation->unitCreationRequests.clear();
+    }
+
+    BoundingBox3x<SimScalar> SimulationDriver::createBoundingBox(const Unit& unit) const
+    {
+        auto footprint = simulation->computeFootprintRegion(unit.position, unit.footprintX, unit.footprintZ);
+        auto min = SimVector(SimScalar(footprint.x), unit.position.y, SimScalar(footprint.y));
+        auto max = SimVector(SimScalar(footprint.x + footprint.width), unit.position.y + unit.height, SimScalar(footprint.y + footprint.height));
+        auto worldMin = simulation->terrain.heightmapToWorldSpace(min);
+        auto worldMax = simulation->terrain.heightmapToWorldSpace(max);
+        return BoundingBox3x<SimScalar>::fromMinMax(worldMin, worldMax);
+    }
+
+    void SimulationDriver::killUnit(UnitId unitId)
+    {
+        auto& unit = simulation->getUnit(unitId);
+
+        unit.markAsDead();
+        simulation->changedUnits.push_back(unitId);
+
+        // TODO: spawn debris particles, corpse
+        if (unit.explosionWeapon)
+        {
+            auto impactType = unit.position.y < simulation->terrain.getSeaLevel() ? ImpactType::Water : ImpactType::Normal;
+            auto projectile = simulation->createProjectileFromWeapon(unit.owner, *unit.explosionWeapon, unit.position, SimVector(0_ss, -1_ss, 0_ss), 0_ss);
+            doProjectileImpact(projectile, impactType);
+        }
+    }
+
+    void SimulationDriver::quietlyKillUnit(UnitId unitId)
+    {
+        auto& unit = simulation->getUnit(unitId);
+
+        unit.markAsDead();
+        simulation->changedUnits.push_back(unitId);
+    }
+
+    void SimulationDriver::killPlayer(PlayerId playerId)
+    {
+        simulation->getPlayer(playerId).status = GamePlayerStatus::Dead;
+        for (auto& p : simulation->units)
+        {
+            auto& unit = p.second;
+            if (unit.isDead())
+            {
+                continue;
+            }
+
+            if (!unit.isOwnedBy(playerId))
+            {
+                continue;
+            }
+
+            killUnit(p.first);
+        }
+    }
+
+    void SimulationDriver::processPlayerCommands(const std::vector<std::pair<PlayerId, std::vector<PlayerCommand>>>& commands)
+    {
+        for (const auto& [_, playerCommands] : commands)
+        {
+            for (const auto& command : playerCommands)
+            {
+                processPlayerCommand(command);
+            }
+        }
+    }
+
+    void SimulationDriver::processPlayerCommand(const PlayerCommand& playerCommand)
+    {
+        match(
+            playerCommand,
+            [&](const PlayerUnitCommand& c) {
+                processUnitCommand(c);
+            },
+            [](const PlayerPauseGameCommand&) {
+                // TODO
+            },
+            [](const PlayerUnpauseGameCommand&) {
+                // TODO
+            });
+    }
+
+    void SimulationDriver::processUnitCommand(const PlayerUnitCommand& unitCommand)
+    {
+        match(
+            unitCommand.command,
+            [&](const PlayerUnitCommand::IssueOrder& c) {
+                switch (c.issueKind)
+                {
+                    case PlayerUnitCommand::IssueOrder::IssueKind::Immediate:
+                        issueUnitOrder(unitCommand.unit, c.order);
+                        break;
+                    case PlayerUnitCommand::IssueOrder::IssueKind::Queued:
+                        enqueueUnitOrder(unitCommand.unit, c.order);
+                        break;
+                }
+            },
+            [&](const PlayerUnitCommand::ModifyBuildQueue& c) {
+                modifyBuildQueue(unitCommand.unit, c.unitType, c.count);
+            },
+            [&](const PlayerUnitCommand::Stop&) {
+                stopUnit(unitCommand.unit);
+            },
+            [&](const PlayerUnitCommand::SetFireOrders& c) {
+                setFireOrders(unitCommand.unit, c.orders);
+            },
+            [&](const PlayerUnitCommand::SetOnOff& c) {
+                if (c.on)
+                {
+                    activateUnit(unitCommand.unit);
+                }
+                else
+                {
+                    deactivateUnit(unitCommand.unit);
+                }
+            });
+    }
+
+    void SimulationDriver::issueUnitOrder(UnitId unitId, const UnitOrder& order)
+    {
+        auto unit = simulation->tryGetUnit(unitId);
+        if (unit)
+        {
+            unit->get().clearOrders();
+            unit->get().addOrder(order);
+            simulation->changedUnits.push_back(unitId);
+        }
+    }
+
+    void SimulationDriver::enqueueUnitOrder(UnitId unitId, const UnitOrder& order)
+    {
+        auto unit = simulation->tryGetUnit(unitId);
+        if (unit)
+        {
+            unit->get().addOrder(order);
+        }
+    }
+
+    void SimulationDriver::stopUnit(UnitId unitId)
+    {
+        auto unit = simulation->tryGetUnit(unitId);
+        if (unit)
+        {
+            unit->get().clearOrders();
+            simulation->changedUnits.push_back(unitId);
+        }
+    }
+
+    void SimulationDriver::setFireOrders(UnitId unitId, UnitFireOrders orders)
+    {
+        auto unit = simulation->tryGetUnit(unitId);
+        if (unit)
+        {
+            unit->get().fireOrders = orders;
+            simulation->changedUnits.push_back(unitId);
+
+            eventsSubject.next(UnitFireOrdersChangedEvent{unitId, orders});
+        }
+    }
+}
@@ -0,0 +1,238 @@
+#pragma once
+
+#include <chrono>
+#include <rwe/GameHash.h>
+#include <rwe/GameSimulation.h>
+#include <rwe/GameTime.h>
+#include <rwe/IncrementalGameHash.h>
+#include <rwe/MovementClassCollisionService.h>
+#include <rwe/PlayerCommand.h>
+#include <rwe/PlayerId.h>
+#include <rwe/SimScalar.h>
+#include <rwe/SimulationEvent.h>
+#include <rwe/SoundHandle.h>
+#include <rwe/TextureService.h>
+#include <rwe/ThreadPool.h>
+#include <rwe/UnitBehaviorService.h>
+#include <rwe/UnitFactory.h>
+#include <rwe/UnitId.h>
+#include <rwe/cob/CobExecutionService.h>
+#include <rwe/cob/CobProfiler.h>
+#include <rwe/observable/Subject.h>
+#include <rwe/pathfinding/PathFindingService.h>
+#include <rwe/snapshot/SimulationSnapshot.h>
+
+namespace rwe
+{
+    enum class ImpactType
+    {
+        Normal,
+        Water
+    };
+
+    /** Wall-clock time spent in each phase of the most recent tick. */
+    struct SimulationTickTimings
+    {
+        std::chrono::nanoseconds playerCommands{0};
+        std::chrono::nanoseconds resources{0};
+        std::chrono::nanoseconds pathFinding{0};
+        std::chrono::nanoseconds unitBehavior{0};
+        std::chrono::nanoseconds unitAnimation{0};
+        std::chrono::nanoseconds unitScripts{0};
+        std::chrono::nanoseconds projectiles{0};
+        std::chrono::nanoseconds explosions{0};
+        std::chrono::nanoseconds cleanup{0};
+        std::chrono::nanoseconds hash{0};
+
+        SimulationTickTimings& operator+=(const SimulationTickTimings& rhs);
+    };
+
+    /**
+     * Advances a GameSimulation one tick at a time.
+     * This contains all the game logic that runs each tick
+     * and has no dependency on rendering, audio, input or networking.
+     * Anything the presentation layer cares about is published via events().
+     */
+    class SimulationDriver
+    {
+    public:
+        static inline const SimScalar SecondsPerTick = SimScalar(TickInterval) / 1000_ss;
+
+        /**
+         * How often the incrementally maintained game hash
+         * is checked against a full recompute.
+         */
+        static inline const GameTime FullHashCheckInterval = GameTime(600);
+
+    private:
+        GameSimulation* const simulation;
+        UnitFactory* const unitFactory;
+        TextureService* const textureService;
+
+        /**
+         * Runs path searches in the background,
+         * and unit animation and scripts, which only touch their own unit, in parallel.
+         */
+        ThreadPool* const threadPool;
+
+        PathFindingService pathFindingService;
+        CobExecutionService cobExecutionService;
+        UnitBehaviorService unitBehaviorService;
+
+        /** Scratch space for updateUnits, kept to avoid reallocating every tick. */
+        std::vector<UnitId> updatedUnitIds;
+        std::vector<CobUnitCommand> cobUnitCommands;
+
+        Subject<const SimulationEvent&> eventsSubject;
+
+        SimulationTickTimings lastTickTimings;
+
+        /** Totals of the units' script profiles, gathered each tick while profiling is enabled. */
+        CobProfiler cobProfiler;
+        bool cobProfilingEnabled{false};
+
+        IncrementalGameHash incrementalHash;
+
+        GameHash gameHash{0};
+
+    public:
+        SimulationDriver(
+            GameSimulation* simulation,
+            MovementClassCollisionService* collisionService,
+            UnitFactory* unitFactory,
+            TextureService* textureService,
+            ThreadPool* threadPool);
+
+        SimulationDriver(const SimulationDriver&) = delete;
+        SimulationDriver& operator=(const SimulationDriver&) = delete;
+
+        /**
+         * Runs one game tick, applying the given player commands first.
+         */
+        void tick(const std::vector<std::pair<PlayerId, std::vector<PlayerCommand>>>& playerCommands);
+
+        const SimulationTickTimings& getLastTickTimings() const;
+
+        /**
+         * Turns profiling of unit scripts on or off for every unit,
+         * including units spawned later.
+         * Totals gathered so far are kept until clearCobProfile is called.
+         */
+        void setCobProfilingEnabled(bool enabled);
+
+        bool isCobProfilingEnabled() const;
+
+        const CobProfiler& getCobProfiler() const;
+
+        void clearCobProfile();
+
+        /**
+         * Returns the hash of the simulation as of the end of the last tick.
+         */
+        GameHash getGameHash() const;
+
+        /**
+         * Captures the simulation along with the path searches
+         * still in progress for it.
+         */
+        SimulationSnapshot captureSnapshot() const;
+
+        /**
+         * Replaces the state of the simulation with the snapshot,
+         * as if the simulation had just finished the tick it was taken at.
+         * See rwe::restoreSnapshot for the requirements on the snapshot.
+         */
+        void restoreSnapshot(const SimulationSnapshot& snapshot);
+
+        Observable<const SimulationEvent&>& events();
+
+        const PathFindingService& getPathFindingService() const;
+
+        GameSimulation& getSimulation();
+
+        const GameSimulation& getSimulation() const;
+
+        const MapTerrain& getTerrain() const;
+
+        GameTime getGameTime() const;
+
+        DiscreteRect computeFootprintRegion(const SimVector& position, unsigned int footprintX, unsigned int footprintZ) const;
+
+        bool isCollisionAt(const DiscreteRect& rect, UnitId self) const;
+
+        void moveUnitOccupiedArea(const DiscreteRect& oldRect, const DiscreteRect& newRect, UnitId unitId);
+
+        std::optional<UnitId> spawnUnit(const std::string& unitType, PlayerId owner, const SimVector& position);
+
+        void spawnCompletedUnit(const std::string& unitType, PlayerId owner, const SimVector& position);
+
+        void playNotificationSound(const PlayerId& playerId, const SoundHandle& sound);
+
+        void playSoundAt(const Vector3f& position, const SoundHandle& sound);
+
+        void doProjectileImpact(const Projectile& projectile, ImpactType impactType);
+
+        void createLightSmoke(const SimVector& position);
+
+        void activateUnit(UnitId unitId);
+
+        void deactivateUnit(UnitId unitId);
+
+        void modifyBuildQueue(UnitId unitId, const std::string& unitType, int count);
+
+        void setBuildStance(UnitId unitId, bool value);
+
+        void setYardOpen(UnitId unitId, bool value);
+
+        void setBuggerOff(UnitId unitId, bool value);
+
+        void applyCobUnitCommand(const CobUnitCommand& command);
+
+        void quietlyKillUnit(UnitId unitId);
+
+    private:
+        void updateHash();
+
+        void updateResources();
+
+        void updateUnits();
+
+        void collectCobProfiles();
+
+        void updateProjectiles();
+
+        void updateExplosions();
+
+        void killDeadCommanderOwners();
+
+        void applyDamageInRadius(const SimVector& position, SimScalar radius, const Projectile& projectile);
+
+        void applyDamage(UnitId unitId, unsigned int damagePoints);
+
+        void deleteDeadUnits();
+
+        void deleteDeadProjectiles();
+
+        void spawnNewUnits();
+
+        BoundingBox3x<SimScalar> createBoundingBox(const Unit& unit) const;
+
+        void killUnit(UnitId unitId);
+
+        void killPlayer(PlayerId playerId);
+
+        void processPlayerCommands(const std::vector<std::pair<PlayerId, std::vector<PlayerCommand>>>& commands);
+
+        void processPlayerCommand(const PlayerCommand& playerCommand);
+
+        void processUnitCommand(const PlayerUnitCommand& unitCommand);
+
+        void issueUnitOrder(UnitId unitId, const UnitOrder& order);
+
+        void enqueueUnitOrder(UnitId unitId, const UnitOrder& order);
+
+        void stopUnit(UnitId unitId);
+
+        void setFireOrders(UnitId unitId, UnitFireOrders orders);
+    };
+}
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <rwe/PlayerId.h>
+#include <rwe/SoundHandle.h>
+#include <rwe/UnitFireOrders.h>
+#include <rwe/UnitId.h>
+#include <rwe/math/Vector3f.h>
+#include <string>
+#include <variant>
+
+namespace rwe
+{
+    struct PlaySoundAtEvent
+    {
+        Vector3f position;
+        SoundHandle sound;
+    };
+
+    /** A sound that should only be heard by the given player. */
+    struct PlayNotificationSoundEvent
+    {
+        PlayerId player;
+        SoundHandle sound;
+    };
+
+    struct UnitSpawnedEvent
+    {
+        UnitId unitId;
+    };
+
+    /** Raised just before a dead unit is removed from the simulation. */
+    struct UnitDeletedEvent
+    {
+        UnitId unitId;
+    };
+
+    struct UnitActivationChangedEvent
+    {
+        UnitId unitId;
+        bool activated;
+    };
+
+    struct UnitFireOrdersChangedEvent
+    {
+        UnitId unitId;
+        UnitFireOrders orders;
+    };
+
+    struct UnitBuildQueueChangedEvent
+    {
+        UnitId unitId;
+        std::string unitType;
+        int count;
+    };
+
+    /**
+     * Things that happen inside the simulation that the presentation layer
+     * (sound, UI) may want to react to.
+     * The simulation itself never depends on anyone listening.
+     */
+    using SimulationEvent = std::variant<
+        PlaySoundAtEvent,
+        PlayNotificationSoundEvent,
+        UnitSpawnedEvent,
+        UnitDeletedEvent,
+        UnitActivationChangedEvent,
+        UnitFireOrdersChangedEvent,
+        UnitBuildQueueChangedEvent>;
+}
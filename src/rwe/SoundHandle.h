@@ -0,0 +1,15 @@
+#pragma once
+
+#include <memory>
+
+struct Mix_Chunk;
+
+namespace rwe
+{
+    /**
+     * A loaded sound effect.
+     * The simulation only passes these around for AudioService to play,
+     * so it can hold them without seeing SDL_mixer.
+     */
+    using SoundHandle = std::shared_ptr<Mix_Chunk>;
+}
@@ -8,6 +8,28 @@
 
 namespace rwe
 {
+    /** Uploads the texture, or returns an empty handle when there is no GPU to upload to. */
+    static SharedTextureHandle createTextureOrEmpty(GraphicsContext* graphics, unsigned int width, unsigned int height, const std::vector<Color>& buffer)
+    {
+        if (graphics == nullptr)
+        {
+            return SharedTextureHandle();
+        }
+
+        return SharedTextureHandle(graphics->createTexture(width, height, buffer));
+    }
+
+    /** As createTextureOrEmpty, the sprite keeps its bounds but has no mesh when there is no GPU. */
+    static Sprite createSpriteOrEmpty(GraphicsContext* graphics, const Rectangle2f& bounds, const Rectangle2f& textureRegion, const SharedTextureHandle& texture)
+    {
+        if (graphics == nullptr)
+        {
+            return Sprite(bounds, texture, std::make_shared<GlMesh>(VaoHandle(), VboHandle(), 0));
+        }
+
+        return graphics->createSprite(bounds, textureRegion, texture);
+    }
+
     class BufferGafAdapter : public GafReaderAdapter
     {
     private:
@@ -59,7 +81,7 @@ namespace rwe
 
         void endFrame() override
         {
-            SharedTextureHandle handle(graphics->createTexture(currentFrameHeader.width, currentFrameHeader.height, buffer));
+            auto handle = createTextureOrEmpty(graphics, currentFrameHeader.width, currentFrameHeader.height, buffer);
 
             auto bounds = Rectangle2f::fromTopLeft(
                 -currentFrameHeader.posX,
@@ -69,7 +91,7 @@ namespace rwe
 
             auto region = Rectangle2f::fromTopLeft(0.0f, 0.0f, 1.0f, 1.0f);
 
-            auto sprite = std::make_shared<Sprite>(graphics->createSprite(bounds, region, handle));
+            auto sprite = std::make_shared<Sprite>(createSpriteOrEmpty(graphics, bounds, region, handle));
             spriteSeries.sprites.push_back(std::move(sprite));
         }
 
@@ -82,8 +104,14 @@ namespace rwe
     TextureService::TextureService(GraphicsContext* graphics, AbstractVirtualFileSystem* fileSystem, const ColorPalette* palette)
         : graphics(graphics), fileSystem(fileSystem), palette(palette)
     {
-        SharedTextureHandle handle(graphics->createColorTexture(Color(255, 0, 255)));
-        auto sprite = graphics->createSprite(
+        SharedTextureHandle handle;
+        if (graphics != nullptr)
+        {
+            handle = SharedTextureHandle(graphics->createColorTexture(Color(255, 0, 255)));
+        }
+
+        auto sprite = createSpriteOrEmpty(
+            graphics,
             Rectangle2f(0.5f, 0.5f, 0.5f, 0.5f),
             Rectangle2f(0.5f, 0.5f, 0.5f, 0.5f),
             handle);
@@ -104,13 +132,13 @@ namespace rwe
             return it->second;
         }
 
-        auto gafBytes = fileSystem->readFile(gafName);
+        auto gafBytes = fileSystem->readFileView(gafName);
         if (!gafBytes)
         {
             return std::nullopt;
         }
 
-        boost::interprocess::bufferstream gafStream(gafBytes->data(), gafBytes->size());
+        boost::interprocess::ibufferstream gafStream(gafBytes->data(), gafBytes->size());
         GafArchive gafArchive(&gafStream);
 
         auto gafEntry = gafArchive.findEntry(normEntryName);
@@ -186,7 +214,7 @@ namespace rwe
             static_cast<float>(width) / static_cast<float>(bitmap.width),
             static_cast<float>(height) / static_cast<float>(bitmap.height));
         auto bounds = Rectangle2f::fromTopLeft(x, y, width, height);
-        return std::make_shared<Sprite>(graphics->createSprite(bounds, region, bitmap.handle));
+        return std::make_shared<Sprite>(createSpriteOrEmpty(graphics, bounds, region, bitmap.handle));
     }
 
     TextureService::TextureInfo TextureService::getBitmapInternal(const std::string& bitmapName)
@@ -219,7 +247,7 @@ namespace rwe
             buffer[i] = palette[paletteIndex].toColor();
         }
 
-        SharedTextureHandle handle(graphics->createTexture(width, height, buffer));
+        auto handle = createTextureOrEmpty(graphics, width, height, buffer);
         TextureInfo info(width, height, handle);
         bitmapCache[bitmapName] = info;
         return info;
@@ -233,13 +261,13 @@ namespace rwe
             return it->second;
         }
 
-        auto tntData = fileSystem->readFile("maps/" + mapName + ".tnt");
+        auto tntData = fileSystem->readFileView("maps/" + mapName + ".tnt");
         if (!tntData)
         {
             throw std::runtime_error("map tnt not found!");
         }
 
-        boost::interprocess::bufferstream tntStream(tntData->data(), tntData->size());
+        boost::interprocess::ibufferstream tntStream(tntData->data(), tntData->size());
         TntArchive tnt(&tntStream);
         auto minimap = tnt.readMinimap();
 
@@ -249,8 +277,9 @@ namespace rwe
             return (*p)[pixel];
         });
 
-        SharedTextureHandle texture(graphics->createTexture(minimap.width, minimap.height, rgbMinimap));
-        auto sprite = graphics->createSprite(
+        auto texture = createTextureOrEmpty(graphics, minimap.width, minimap.height, rgbMinimap);
+        auto sprite = createSpriteOrEmpty(
+            graphics,
             Rectangle2f::fromTopLeft(0.0f, 0.0f, minimap.width, minimap.height),
             Rectangle2f::fromTopLeft(0.0f, 0.0f, 1.0f, 1.0f),
             texture);
@@ -301,8 +330,9 @@ namespace rwe
             // the last font in the file is often missing the last byte or two.
             rgbGlyph.resize(width * fnt.glyphHeight());
 
-            SharedTextureHandle texture(graphics->createTexture(width, fnt.glyphHeight(), rgbGlyph));
-            auto sprite = std::make_shared<Sprite>(graphics->createSprite(
+            auto texture = createTextureOrEmpty(graphics, width, fnt.glyphHeight(), rgbGlyph);
+            auto sprite = std::make_shared<Sprite>(createSpriteOrEmpty(
+                graphics,
                 Rectangle2f::fromTopLeft(0.0f, 0.0f, width, fnt.glyphHeight()),
                 Rectangle2f::fromTopLeft(0.0f, 0.0f, 1.0f, 1.0f),
                 texture));
@@ -35,6 +35,10 @@ namespace rwe
         std::unordered_map<std::string, std::shared_ptr<Sprite>> minimapCache;
 
     public:
+        /**
+         * graphics may be null, in which case nothing is uploaded to the GPU.
+         * Sprites are still created with their bounds, but with empty textures and meshes.
+         */
         TextureService(GraphicsContext* graphics, AbstractVirtualFileSystem* filesystem, const ColorPalette* palette);
 
         std::optional<std::shared_ptr<SpriteSeries>> tryGetGafEntry(const std::string& gafName, const std::string& entryName);
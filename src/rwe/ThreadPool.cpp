@@ -0,0 +1,68 @@
+#include "ThreadPool.h"
+#include <algorithm>
+
+namespace rwe
+{
+    ThreadPool::ThreadPool(unsigned int threadCount)
+    {
+        threadCount = std::max(threadCount, 1u);
+        for (unsigned int i = 0; i < threadCount; ++i)
+        {
+            workers.emplace_back(&ThreadPool::run, this);
+        }
+    }
+
+    ThreadPool::ThreadPool()
+        : ThreadPool(std::thread::hardware_concurrency() > 1 ? std::thread::hardware_concurrency() - 1 : 1)
+    {
+    }
+
+    ThreadPool::~ThreadPool()
+    {
+        {
+            std::scoped_lock<std::mutex> lock(mutex);
+            stopping = true;
+            jobs.clear();
+        }
+        jobAvailable.notify_all();
+
+        for (auto& worker : workers)
+        {
+            worker.join();
+        }
+    }
+
+    std::size_t ThreadPool::getThreadCount() const
+    {
+        return workers.size();
+    }
+
+    std::size_t ThreadPool::getChunkCount(std::size_t count, std::size_t minChunkSize) const
+    {
+        auto maxChunks = workers.size() + 1;
+        auto chunks = count / std::max(minChunkSize, std::size_t(1));
+        return std::clamp(chunks, std::size_t(1), maxChunks);
+    }
+
+    void ThreadPool::run()
+    {
+        while (true)
+        {
+            std::function<void()> job;
+
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                jobAvailable.wait(lock, [this]() { return stopping || !jobs.empty(); });
+                if (stopping)
+                {
+                    return;
+                }
+
+                job = std::move(jobs.front());
+                jobs.pop_front();
+            }
+
+            job();
+        }
+    }
+}
@@ -0,0 +1,173 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace rwe
+{
+    /**
+     * A fixed set of worker threads that run submitted jobs in FIFO order.
+     * The exception is the jobs of forEachChunk, which are queued
+     * ahead of other jobs because their caller is waiting on them.
+     * The caller also works through any chunks the pool hasn't started,
+     * so a parallel loop never waits behind long-running background jobs.
+     * This lets one pool be shared by both.
+     * Jobs still queued when the pool is destroyed are abandoned,
+     * so their futures report a broken promise.
+     * Jobs already running are allowed to finish.
+     */
+    class ThreadPool
+    {
+    private:
+        /** Shared between a forEachChunk call and the jobs it queues. */
+        struct ChunkState
+        {
+            std::atomic<std::size_t> nextChunk{0};
+            std::mutex mutex;
+            std::condition_variable allFinished;
+            std::size_t finishedChunks{0};
+
+            /** Each chunk's exception, written only by the thread that claimed it. */
+            std::vector<std::exception_ptr> errors;
+
+            explicit ChunkState(std::size_t chunkCount) : errors(chunkCount)
+            {
+            }
+        };
+
+        std::mutex mutex;
+        std::condition_variable jobAvailable;
+        std::deque<std::function<void()>> jobs;
+        bool stopping{false};
+        std::vector<std::thread> workers;
+
+    public:
+        /** Creates a pool with the given number of threads, at least one. */
+        explicit ThreadPool(unsigned int threadCount);
+
+        /** Creates a pool with one thread fewer than the machine has hardware threads, at least one. */
+        ThreadPool();
+
+        ~ThreadPool();
+
+        ThreadPool(const ThreadPool&) = delete;
+        ThreadPool& operator=(const ThreadPool&) = delete;
+
+        template <typename Func>
+        std::future<std::invoke_result_t<Func>> submit(Func&& f)
+        {
+            return enqueue(std::forward<Func>(f), false);
+        }
+
+        std::size_t getThreadCount() const;
+
+        /**
+         * Returns how many chunks forEachChunk will split a range of the given size into.
+         * This is one per pool thread plus one for the calling thread,
+         * but never so many that a chunk is smaller than minChunkSize,
+         * and always at least one.
+         */
+        std::size_t getChunkCount(std::size_t count, std::size_t minChunkSize) const;
+
+        /**
+         * Splits the range [0, count) into contiguous chunks in ascending order
+         * and calls f(chunkIndex, begin, end) once for each of them.
+         * Chunks are claimed in order by whichever thread gets to them first,
+         * the calling thread included, so the caller never waits
+         * on a chunk that no thread has started.
+         * Returns once every chunk has finished.
+         * If chunks throw, the exception from the lowest chunk index is rethrown.
+         */
+        template <typename Func>
+        void forEachChunk(std::size_t count, std::size_t minChunkSize, const Func& f)
+        {
+            auto chunkCount = getChunkCount(count, minChunkSize);
+            auto state = std::make_shared<ChunkState>(chunkCount);
+
+            // Jobs left in the queue after every chunk is claimed find nothing to do,
+            // so they may outlive this call, but they never touch f.
+            auto runChunks = [state, &f, count, chunkCount]() {
+                for (auto i = state->nextChunk++; i < chunkCount; i = state->nextChunk++)
+                {
+                    auto begin = (count * i) / chunkCount;
+                    auto end = (count * (i + 1)) / chunkCount;
+                    try
+                    {
+                        f(i, begin, end);
+                    }
+                    catch (...)
+                    {
+                        state->errors[i] = std::current_exception();
+                    }
+
+                    std::scoped_lock<std::mutex> lock(state->mutex);
+                    state->finishedChunks += 1;
+                    if (state->finishedChunks == chunkCount)
+                    {
+                        state->allFinished.notify_all();
+                    }
+                }
+            };
+
+            for (std::size_t i = 1; i < chunkCount; ++i)
+            {
+                enqueue(runChunks, true);
+            }
+
+            runChunks();
+
+            // Every chunk has been claimed, but some may still be running on the pool.
+            {
+                std::unique_lock<std::mutex> lock(state->mutex);
+                state->allFinished.wait(lock, [&]() { return state->finishedChunks == chunkCount; });
+            }
+
+            for (const auto& error : state->errors)
+            {
+                if (error)
+                {
+                    std::rethrow_exception(error);
+                }
+            }
+        }
+
+    private:
+        /** Queues the job at the back, or at the front if urgent. */
+        template <typename Func>
+        std::future<std::invoke_result_t<Func>> enqueue(Func&& f, bool urgent)
+        {
+            using Result = std::invoke_result_t<Func>;
+
+            // std::function requires copyable callables,
+            // so the task has to live behind a shared_ptr.
+            auto task = std::make_shared<std::packaged_task<Result()>>(std::forward<Func>(f));
+            auto future = task->get_future();
+
+            {
+                std::scoped_lock<std::mutex> lock(mutex);
+                if (urgent)
+                {
+                    jobs.emplace_front([task]() { (*task)(); });
+                }
+                else
+                {
+                    jobs.emplace_back([task]() { (*task)(); });
+                }
+            }
+            jobAvailable.notify_one();
+
+            return future;
+        }
+
+        void run();
+    };
+}
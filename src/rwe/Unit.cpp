@@ -63,8 +63,8 @@ namespace rwe
         return SimVector(sin(rotation), 0_ss, cos(rotation));
     }
 
-    Unit::Unit(const UnitMesh& mesh, std::unique_ptr<CobEnvironment>&& cobEnvironment, SelectionMesh&& selectionMesh)
-        : mesh(mesh), cobEnvironment(std::move(cobEnvironment)), selectionMesh(std::move(selectionMesh))
+    Unit::Unit(const UnitMesh& mesh, std::unique_ptr<CobEnvironment>&& cobEnvironment, const std::shared_ptr<SelectionMesh>& selectionMesh)
+        : mesh(mesh), cobEnvironment(std::move(cobEnvironment)), selectionMesh(selectionMesh)
     {
     }
 
@@ -139,130 +139,81 @@ namespace rwe
         return commander;
     }
 
-    void Unit::moveObject(const std::string& pieceName, Axis axis, SimScalar targetPosition, SimScalar speed)
+    std::optional<std::reference_wrapper<UnitMesh::Piece>> Unit::findScriptPiece(unsigned int pieceId)
     {
-        auto piece = mesh.find(pieceName);
-        if (!piece)
+        if (pieceId >= scriptPieceIndices.size() || !scriptPieceIndices[pieceId])
         {
-            throw std::runtime_error("Invalid piece name: " + pieceName);
+            return std::nullopt;
         }
 
-        UnitMesh::MoveOperation op(targetPosition, speed);
+        return mesh.pieces[*scriptPieceIndices[pieceId]];
+    }
 
-        switch (axis)
+    std::optional<std::reference_wrapper<const UnitMesh::Piece>> Unit::findScriptPiece(unsigned int pieceId) const
+    {
+        if (pieceId >= scriptPieceIndices.size() || !scriptPieceIndices[pieceId])
         {
-            case Axis::X:
-                piece->get().xMoveOperation = op;
-                break;
-            case Axis::Y:
-                piece->get().yMoveOperation = op;
-                break;
-            case Axis::Z:
-                piece->get().zMoveOperation = op;
-                break;
+            return std::nullopt;
         }
+
+        return mesh.pieces[*scriptPieceIndices[pieceId]];
     }
 
-    void Unit::moveObjectNow(const std::string& pieceName, Axis axis, SimScalar targetPosition)
+    std::optional<Matrix4x<SimScalar>> Unit::getPieceTransform(unsigned int pieceId) const
     {
-        auto piece = mesh.find(pieceName);
-        if (!piece)
+        if (pieceId >= scriptPieceIndices.size() || !scriptPieceIndices[pieceId])
         {
-            throw std::runtime_error("Invalid piece name: " + pieceName);
+            return std::nullopt;
         }
 
-        switch (axis)
-        {
-            case Axis::X:
-                piece->get().offset.x = targetPosition;
-                piece->get().xMoveOperation = std::nullopt;
-                break;
-            case Axis::Y:
-                piece->get().offset.y = targetPosition;
-                piece->get().yMoveOperation = std::nullopt;
-                break;
-            case Axis::Z:
-                piece->get().offset.z = targetPosition;
-                piece->get().zMoveOperation = std::nullopt;
-                break;
-        }
+        return mesh.getPieceTransform(*scriptPieceIndices[pieceId]);
     }
 
-    void Unit::turnObject(const std::string& pieceName, Axis axis, SimAngle targetAngle, SimScalar speed)
+    static unsigned int getScriptPieceIndex(const Unit& unit, unsigned int pieceId)
     {
-        auto piece = mesh.find(pieceName);
-        if (!piece)
+        if (pieceId >= unit.scriptPieceIndices.size() || !unit.scriptPieceIndices[pieceId])
         {
-            throw std::runtime_error("Invalid piece name: " + pieceName);
+            throw std::runtime_error("Invalid piece name: " + unit.cobEnvironment->_script->pieces.at(pieceId));
         }
 
-        UnitMesh::TurnOperation op(targetAngle, speed);
+        return *unit.scriptPieceIndices[pieceId];
+    }
 
-        switch (axis)
-        {
-            case Axis::X:
-                piece->get().xTurnOperation = op;
-                break;
-            case Axis::Y:
-                piece->get().yTurnOperation = op;
-                break;
-            case Axis::Z:
-                piece->get().zTurnOperation = op;
-                break;
-        }
+    void Unit::moveObject(unsigned int pieceId, Axis axis, SimScalar targetPosition, SimScalar speed)
+    {
+        mesh.setMoveOperation(getScriptPieceIndex(*this, pieceId), axis, UnitMesh::MoveOperation(targetPosition, speed));
     }
 
-    void Unit::turnObjectNow(const std::string& pieceName, Axis axis, SimAngle targetAngle)
+    void Unit::moveObjectNow(unsigned int pieceId, Axis axis, SimScalar targetPosition)
     {
-        auto piece = mesh.find(pieceName);
-        if (!piece)
-        {
-            throw std::runtime_error("Invalid piece name: " + pieceName);
-        }
+        auto pieceIndex = getScriptPieceIndex(*this, pieceId);
+        mesh.setPieceOffset(pieceIndex, axis, targetPosition);
+        mesh.setMoveOperation(pieceIndex, axis, std::nullopt);
+    }
 
-        switch (axis)
-        {
-            case Axis::X:
-                piece->get().rotationX = targetAngle;
-                piece->get().xTurnOperation = std::nullopt;
-                break;
-            case Axis::Y:
-                piece->get().rotationY = targetAngle;
-                piece->get().yTurnOperation = std::nullopt;
-                break;
-            case Axis::Z:
-                piece->get().rotationZ = targetAngle;
-                piece->get().zTurnOperation = std::nullopt;
-                break;
-        }
+    void Unit::turnObject(unsigned int pieceId, Axis axis, SimAngle targetAngle, SimScalar speed)
+    {
+        mesh.setTurnOperation(getScriptPieceIndex(*this, pieceId), axis, UnitMesh::TurnOperation(targetAngle, speed));
     }
 
-    void Unit::spinObject(const std::string& pieceName, Axis axis, SimScalar speed, SimScalar acceleration)
+    void Unit::turnObjectNow(unsigned int pieceId, Axis axis, SimAngle targetAngle)
     {
-        auto piece = mesh.find(pieceName);
-        if (!piece)
-        {
-            throw std::runtime_error("Invalid piece name: " + pieceName);
-        }
+        auto pieceIndex = getScriptPieceIndex(*this, pieceId);
+        mesh.setPieceRotation(pieceIndex, axis, targetAngle);
+        mesh.setTurnOperation(pieceIndex, axis, std::nullopt);
+    }
 
+    void Unit::spinObject(unsigned int pieceId, Axis axis, SimScalar speed, SimScalar acceleration)
+    {
         UnitMesh::SpinOperation op(acceleration == 0_ss ? speed : 0_ss, speed, acceleration);
-
-        switch (axis)
-        {
-            case Axis::X:
-                piece->get().xTurnOperation = op;
-                break;
-            case Axis::Y:
-                piece->get().yTurnOperation = op;
-                break;
-            case Axis::Z:
-                piece->get().zTurnOperation = op;
-                break;
-        }
+        mesh.setTurnOperation(getScriptPieceIndex(*this, pieceId), axis, op);
     }
 
-    void setStopSpinOp(std::optional<UnitMesh::TurnOperationUnion>& existingOp, SimScalar deceleration)
+    void Unit::stopSpinObject(unsigned int pieceId, Axis axis, SimScalar deceleration)
     {
+        auto pieceIndex = getScriptPieceIndex(*this, pieceId);
+
+        auto existingOp = mesh.getTurnOperation(pieceIndex, axis);
         if (!existingOp)
         {
             return;
@@ -275,76 +226,21 @@ namespace rwe
 
         if (deceleration == 0_ss)
         {
-            existingOp = std::nullopt;
+            mesh.setTurnOperation(pieceIndex, axis, std::nullopt);
             return;
         }
 
-        existingOp = UnitMesh::StopSpinOperation(spinOp->currentSpeed, deceleration);
+        mesh.setTurnOperation(pieceIndex, axis, UnitMesh::StopSpinOperation(spinOp->currentSpeed, deceleration));
     }
 
-    void Unit::stopSpinObject(const std::string& pieceName, Axis axis, SimScalar deceleration)
+    bool Unit::isMoveInProgress(unsigned int pieceId, Axis axis) const
     {
-
-        auto piece = mesh.find(pieceName);
-        if (!piece)
-        {
-            throw std::runtime_error("Invalid piece name: " + pieceName);
-        }
-
-        switch (axis)
-        {
-            case Axis::X:
-                setStopSpinOp(piece->get().xTurnOperation, deceleration);
-                break;
-            case Axis::Y:
-                setStopSpinOp(piece->get().yTurnOperation, deceleration);
-                break;
-            case Axis::Z:
-                setStopSpinOp(piece->get().zTurnOperation, deceleration);
-                break;
-        }
+        return mesh.getMoveOperation(getScriptPieceIndex(*this, pieceId), axis).has_value();
     }
 
-    bool Unit::isMoveInProgress(const std::string& pieceName, Axis axis) const
+    bool Unit::isTurnInProgress(unsigned int pieceId, Axis axis) const
     {
-        auto piece = mesh.find(pieceName);
-        if (!piece)
-        {
-            throw std::runtime_error("Invalid piece name " + pieceName);
-        }
-
-        switch (axis)
-        {
-            case Axis::X:
-                return !!(piece->get().xMoveOperation);
-            case Axis::Y:
-                return !!(piece->get().yMoveOperation);
-            case Axis::Z:
-                return !!(piece->get().zMoveOperation);
-        }
-
-        throw std::logic_error("Invalid axis");
-    }
-
-    bool Unit::isTurnInProgress(const std::string& pieceName, Axis axis) const
-    {
-        auto piece = mesh.find(pieceName);
-        if (!piece)
-        {
-            throw std::runtime_error("Invalid piece name " + pieceName);
-        }
-
-        switch (axis)
-        {
-            case Axis::X:
-                return !!(piece->get().xTurnOperation);
-            case Axis::Y:
-                return !!(piece->get().yTurnOperation);
-            case Axis::Z:
-                return !!(piece->get().zTurnOperation);
-        }
-
-        throw std::logic_error("Invalid axis");
+        return mesh.getTurnOperation(getScriptPieceIndex(*this, pieceId), axis).has_value();
     }
 
     std::optional<float> Unit::selectionIntersect(const Ray3f& ray) const
@@ -352,7 +248,7 @@ namespace rwe
         auto inverseTransform = toFloatMatrix(getInverseTransform());
         auto line = ray.toLine();
         Line3f modelSpaceLine(inverseTransform * line.start, inverseTransform * line.end);
-        auto v = selectionMesh.collisionMesh.intersectLine(modelSpaceLine);
+        auto v = selectionMesh->collisionMesh.intersectLine(modelSpaceLine);
         if (!v)
         {
             return std::nullopt;
@@ -481,7 +377,7 @@ namespace rwe
         }
 
         weapon->state = UnitWeaponStateIdle();
-        cobEnvironment->createThread("TargetCleared", {static_cast<int>(weaponIndex)});
+        cobEnvironment->createThread(CobEntryPoint::TargetCleared, {static_cast<int>(weaponIndex)});
     }
 
     void Unit::clearWeaponTargets()
@@ -510,13 +406,13 @@ namespace rwe
     void Unit::activate()
     {
         activated = true;
-        cobEnvironment->createThread("Activate");
+        cobEnvironment->createThread(CobEntryPoint::Activate);
     }
 
     void Unit::deactivate()
     {
         activated = false;
-        cobEnvironment->createThread("Deactivate");
+        cobEnvironment->createThread(CobEntryPoint::Deactivate);
     }
 
     MovementClass Unit::getAdHocMovementClass() const
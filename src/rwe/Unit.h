@@ -3,7 +3,6 @@
 #include <deque>
 #include <memory>
 #include <optional>
-#include <rwe/AudioService.h>
 #include <rwe/DiscreteRect.h>
 #include <rwe/Energy.h>
 #include <rwe/Grid.h>
@@ -15,9 +14,11 @@
 #include <rwe/SimAngle.h>
 #include <rwe/SimScalar.h>
 #include <rwe/SimVector.h>
+#include <rwe/SoundHandle.h>
 #include <rwe/UnitFireOrders.h>
 #include <rwe/UnitMesh.h>
 #include <rwe/UnitOrder.h>
+#include <rwe/UnitTypeId.h>
 #include <rwe/UnitWeapon.h>
 #include <rwe/cob/CobEnvironment.h>
 #include <rwe/geometry/BoundingBox3f.h>
@@ -134,17 +135,29 @@ namespace rwe
     public:
         std::string name;
         std::string unitType;
+
+        /** Interned unitType, for indexing per-unit-type tables. */
+        UnitTypeId unitTypeId{0};
+
         UnitMesh mesh;
+
+        /**
+         * Maps each piece id in the unit's COB script
+         * to the index of the piece with that name in the mesh,
+         * or to nullopt if the mesh has no such piece.
+         */
+        std::vector<std::optional<unsigned int>> scriptPieceIndices;
         SimVector position;
         std::unique_ptr<CobEnvironment> cobEnvironment;
-        SelectionMesh selectionMesh;
-        std::optional<AudioService::SoundHandle> selectionSound;
-        std::optional<AudioService::SoundHandle> okSound;
-        std::optional<AudioService::SoundHandle> arrivedSound;
-        std::optional<AudioService::SoundHandle> buildSound;
-        std::optional<AudioService::SoundHandle> completeSound;
-        std::optional<AudioService::SoundHandle> activateSound;
-        std::optional<AudioService::SoundHandle> deactivateSound;
+        /** Shared by every unit of the same type and team color. */
+        std::shared_ptr<SelectionMesh> selectionMesh;
+        std::optional<SoundHandle> selectionSound;
+        std::optional<SoundHandle> okSound;
+        std::optional<SoundHandle> arrivedSound;
+        std::optional<SoundHandle> buildSound;
+        std::optional<SoundHandle> completeSound;
+        std::optional<SoundHandle> activateSound;
+        std::optional<SoundHandle> deactivateSound;
         PlayerId owner;
 
         /**
@@ -276,7 +289,7 @@ namespace rwe
 
         static SimVector toDirection(SimAngle rotation);
 
-        Unit(const UnitMesh& mesh, std::unique_ptr<CobEnvironment>&& cobEnvironment, SelectionMesh&& selectionMesh);
+        Unit(const UnitMesh& mesh, std::unique_ptr<CobEnvironment>&& cobEnvironment, const std::shared_ptr<SelectionMesh>& selectionMesh);
 
         bool isBeingBuilt() const;
 
@@ -297,21 +310,35 @@ namespace rwe
 
         bool isCommander() const;
 
-        void moveObject(const std::string& pieceName, Axis axis, SimScalar targetPosition, SimScalar speed);
+        /**
+         * Returns the mesh piece for the given COB script piece id,
+         * or nullopt if the mesh has no piece with that name.
+         */
+        std::optional<std::reference_wrapper<UnitMesh::Piece>> findScriptPiece(unsigned int pieceId);
+
+        std::optional<std::reference_wrapper<const UnitMesh::Piece>> findScriptPiece(unsigned int pieceId) const;
+
+        /**
+         * Returns the transform from the space of the given COB script piece
+         * to the unit's space, or nullopt if the mesh has no such piece.
+         */
+        std::optional<Matrix4x<SimScalar>> getPieceTransform(unsigned int pieceId) const;
+
+        void moveObject(unsigned int pieceId, Axis axis, SimScalar targetPosition, SimScalar speed);
 
-        void moveObjectNow(const std::string& pieceName, Axis axis, SimScalar targetPosition);
+        void moveObjectNow(unsigned int pieceId, Axis axis, SimScalar targetPosition);
 
-        void turnObject(const std::string& pieceName, Axis axis, SimAngle targetAngle, SimScalar speed);
+        void turnObject(unsigned int pieceId, Axis axis, SimAngle targetAngle, SimScalar speed);
 
-        void turnObjectNow(const std::string& pieceName, Axis axis, SimAngle targetAngle);
+        void turnObjectNow(unsigned int pieceId, Axis axis, SimAngle targetAngle);
 
-        void spinObject(const std::string& pieceName, Axis axis, SimScalar speed, SimScalar acceleration);
+        void spinObject(unsigned int pieceId, Axis axis, SimScalar speed, SimScalar acceleration);
 
-        void stopSpinObject(const std::string& pieceName, Axis axis, SimScalar deceleration);
+        void stopSpinObject(unsigned int pieceId, Axis axis, SimScalar deceleration);
 
-        bool isMoveInProgress(const std::string& pieceName, Axis axis) const;
+        bool isMoveInProgress(unsigned int pieceId, Axis axis) const;
 
-        bool isTurnInProgress(const std::string& pieceName, Axis axis) const;
+        bool isTurnInProgress(unsigned int pieceId, Axis axis) const;
 
         /**
          * Returns a value if the given ray intersects this unit
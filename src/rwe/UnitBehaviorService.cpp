@@ -1,5 +1,5 @@
 #include "UnitBehaviorService.h"
-#include <rwe/GameScene.h>
+#include <rwe/SimulationDriver.h>
 #include <rwe/cob/CobExecutionContext.h>
 #include <rwe/geometry/Circle2x.h>
 #include <rwe/math/rwe_math.h>
@@ -26,29 +26,29 @@ namespace rwe
     }
 
     UnitBehaviorService::UnitBehaviorService(
-        GameScene* scene,
+        SimulationDriver* driver,
         UnitFactory* unitFactory,
         CobExecutionService* cobExecutionService)
-        : scene(scene), unitFactory(unitFactory), cobExecutionService(cobExecutionService)
+        : driver(driver), unitFactory(unitFactory), cobExecutionService(cobExecutionService)
     {
     }
 
     void UnitBehaviorService::onCreate(UnitId unitId)
     {
-        auto& sim = scene->getSimulation();
+        auto& sim = driver->getSimulation();
         auto& unit = sim.getUnit(unitId);
 
-        unit.cobEnvironment->createThread("Create", std::vector<int>());
+        unit.cobEnvironment->createThread(CobEntryPoint::Create);
 
         // set speed for metal extractors
         if (unit.extractsMetal != Metal(0))
         {
-            auto footprint = scene->computeFootprintRegion(unit.position, unit.footprintX, unit.footprintZ);
+            auto footprint = driver->computeFootprintRegion(unit.position, unit.footprintX, unit.footprintZ);
             auto metalValue = sim.metalGrid.accumulate(sim.metalGrid.clipRegion(footprint), 0u, std::plus<>());
-            unit.cobEnvironment->createThread("SetSpeed", {static_cast<int>(metalValue)});
+            unit.cobEnvironment->createThread(CobEntryPoint::SetSpeed, {static_cast<int>(metalValue)});
         }
 
-        cobExecutionService->run(*scene, scene->getSimulation(), unitId);
+        cobExecutionService->run(*driver, driver->getSimulation(), unitId);
 
         // measure z distances for ballistics
         for (int i = 0; i < unit.weapons.size(); ++i)
@@ -66,9 +66,15 @@ namespace rwe
 
     void UnitBehaviorService::update(UnitId unitId)
     {
-        auto& unit = scene->getSimulation().getUnit(unitId);
+        auto& sim = driver->getSimulation();
+        auto& unit = sim.getUnit(unitId);
 
         auto previousSpeed = unit.currentSpeed;
+        auto previousPosition = unit.position;
+        auto previousRotation = unit.rotation;
+        auto previousTargetAngle = unit.targetAngle;
+        auto previousTargetSpeed = unit.targetSpeed;
+        auto previousInCollision = unit.inCollision;
 
         // Clear steering targets.
         unit.targetAngle = unit.rotation;
@@ -122,15 +128,32 @@ namespace rwe
 
             if (unit.currentSpeed > 0_ss && previousSpeed == 0_ss)
             {
-                unit.cobEnvironment->createThread("StartMoving");
+                unit.cobEnvironment->createThread(CobEntryPoint::StartMoving);
             }
             else if (unit.currentSpeed == 0_ss && previousSpeed > 0_ss)
             {
-                unit.cobEnvironment->createThread("StopMoving");
+                unit.cobEnvironment->createThread(CobEntryPoint::StopMoving);
             }
 
             updateUnitPosition(unitId);
         }
+
+        // A unit with nothing to do and that isn't moving is left untouched,
+        // so it need not be rehashed.
+        // Anything that is busy may have changed its behaviour state.
+        auto changed = !unit.orders.empty()
+            || !unit.buildQueue.empty()
+            || !std::holds_alternative<IdleState>(unit.behaviourState)
+            || unit.currentSpeed != previousSpeed
+            || unit.position != previousPosition
+            || unit.rotation != previousRotation
+            || unit.targetAngle != previousTargetAngle
+            || unit.targetSpeed != previousTargetSpeed
+            || unit.inCollision != previousInCollision;
+        if (changed)
+        {
+            sim.changedUnits.push_back(unitId);
+        }
     }
 
     std::pair<SimAngle, SimAngle> UnitBehaviorService::computeHeadingAndPitch(SimAngle rotation, const SimVector& from, const SimVector& to, SimScalar speed, SimScalar gravity, SimScalar zOffset, ProjectilePhysicsType projectileType)
@@ -251,7 +274,7 @@ namespace rwe
 
     void UnitBehaviorService::updateWeapon(UnitId id, unsigned int weaponIndex)
     {
-        auto& unit = scene->getSimulation().getUnit(id);
+        auto& unit = driver->getSimulation().getUnit(id);
         auto& weapon = unit.weapons[weaponIndex];
         if (!weapon)
         {
@@ -263,10 +286,10 @@ namespace rwe
             // attempt to acquire a target
             if (!weapon->commandFire && unit.fireOrders == UnitFireOrders::FireAtWill)
             {
-                for (const auto& entry : scene->getSimulation().units)
+                const auto& sim = driver->getSimulation();
+                for (const auto& otherUnitId : sim.findUnitsNear(unit.position, weapon->maxRange))
                 {
-                    auto otherUnitId = entry.first;
-                    const auto& otherUnit = entry.second;
+                    const auto& otherUnit = sim.getUnit(otherUnitId);
 
                     if (otherUnit.isDead())
                     {
@@ -329,11 +352,11 @@ namespace rwe
                 auto heading = headingAndPitch.first;
                 auto pitch = headingAndPitch.second;
 
-                auto threadId = unit.cobEnvironment->createThread(getAimScriptName(weaponIndex), {toCobAngle(heading).value, toCobAngle(pitch).value});
+                auto threadId = unit.cobEnvironment->createThread(getAimEntryPoint(weaponIndex), {toCobAngle(heading).value, toCobAngle(pitch).value});
 
                 if (threadId)
                 {
-                    aimingState->aimInfo = UnitWeaponStateAttacking::AimInfo{*threadId, heading, pitch};
+                    aimingState->aimInfo = UnitWeaponStateAttacking::AimInfo{(*threadId)->getHandle(), heading, pitch};
                 }
                 else
                 {
@@ -388,7 +411,7 @@ namespace rwe
     {
         std::uniform_int_distribution dist(SimAngle(0).value, maxAngle.value);
         std::uniform_int_distribution dist2(0, 1);
-        auto& rng = scene->getSimulation().rng;
+        auto& rng = driver->getSimulation().rng;
         auto angle = SimAngle(dist(rng));
         if (dist2(rng))
         {
@@ -400,7 +423,7 @@ namespace rwe
 
     void UnitBehaviorService::tryFireWeapon(UnitId id, unsigned int weaponIndex, SimAngle heading, SimAngle pitch, const SimVector& targetPosition)
     {
-        auto& unit = scene->getSimulation().getUnit(id);
+        auto& unit = driver->getSimulation().getUnit(id);
         auto& weapon = unit.weapons[weaponIndex];
 
         if (!weapon)
@@ -409,7 +432,7 @@ namespace rwe
         }
 
         // wait for the weapon to reload
-        auto gameTime = scene->getGameTime();
+        auto gameTime = driver->getGameTime();
         if (gameTime < weapon->readyTime)
         {
             return;
@@ -438,15 +461,15 @@ namespace rwe
 
         if (weapon->startSmoke)
         {
-            scene->createLightSmoke(firingPoint);
+            driver->createLightSmoke(firingPoint);
         }
-        scene->getSimulation().spawnProjectile(unit.owner, *weapon, firingPoint, direction, (targetPosition - firingPoint).length());
+        driver->getSimulation().spawnProjectile(unit.owner, *weapon, firingPoint, direction, (targetPosition - firingPoint).length());
 
         if (weapon->soundStart)
         {
-            scene->playSoundAt(simVectorToFloat(firingPoint), *weapon->soundStart);
+            driver->playSoundAt(simVectorToFloat(firingPoint), *weapon->soundStart);
         }
-        unit.cobEnvironment->createThread(getFireScriptName(weaponIndex));
+        unit.cobEnvironment->createThread(getFireEntryPoint(weaponIndex));
 
         ++weapon->burstNumber;
         if (weapon->burstNumber >= weapon->burst)
@@ -469,14 +492,14 @@ namespace rwe
 
     void UnitBehaviorService::updateUnitRotation(UnitId id)
     {
-        auto& unit = scene->getSimulation().getUnit(id);
-        auto turnRateThisFrame = SimAngle(unit.turnRate.value);
+        auto& unit = driver->getSimulation().getUnit(id);
+        auto turnRateThisFrame = simAngleFromSimScalar(unit.turnRate);
         unit.rotation = turnTowards(unit.rotation, unit.targetAngle, turnRateThisFrame);
     }
 
     void UnitBehaviorService::updateUnitSpeed(UnitId id)
     {
-        auto& unit = scene->getSimulation().getUnit(id);
+        auto& unit = driver->getSimulation().getUnit(id);
 
         if (unit.targetSpeed > unit.currentSpeed)
         {
@@ -504,7 +527,7 @@ namespace rwe
         }
 
         auto effectiveMaxSpeed = unit.maxSpeed;
-        if (unit.position.y < scene->getTerrain().getSeaLevel())
+        if (unit.position.y < driver->getTerrain().getSeaLevel())
         {
             effectiveMaxSpeed /= 2_ss;
         }
@@ -513,7 +536,7 @@ namespace rwe
 
     void UnitBehaviorService::updateUnitPosition(UnitId unitId)
     {
-        auto& unit = scene->getSimulation().getUnit(unitId);
+        auto& unit = driver->getSimulation().getUnit(unitId);
 
         auto direction = Unit::toDirection(unit.rotation);
 
@@ -522,7 +545,7 @@ namespace rwe
         if (unit.currentSpeed > 0_ss)
         {
             auto newPosition = unit.position + (direction * unit.currentSpeed);
-            newPosition.y = scene->getTerrain().getHeightAt(newPosition.x, newPosition.z);
+            newPosition.y = driver->getTerrain().getHeightAt(newPosition.x, newPosition.z);
 
             if (!tryApplyMovementToPosition(unitId, newPosition))
             {
@@ -545,8 +568,8 @@ namespace rwe
                     newPos1 = unit.position + (direction * maskX * unit.currentSpeed);
                     newPos2 = unit.position + (direction * maskZ * unit.currentSpeed);
                 }
-                newPos1.y = scene->getTerrain().getHeightAt(newPos1.x, newPos1.z);
-                newPos2.y = scene->getTerrain().getHeightAt(newPos2.x, newPos2.z);
+                newPos1.y = driver->getTerrain().getHeightAt(newPos1.x, newPos1.z);
+                newPos2.y = driver->getTerrain().getHeightAt(newPos2.x, newPos2.z);
 
                 if (!tryApplyMovementToPosition(unitId, newPos1))
                 {
@@ -558,13 +581,13 @@ namespace rwe
 
     bool UnitBehaviorService::tryApplyMovementToPosition(UnitId id, const SimVector& newPosition)
     {
-        auto& sim = scene->getSimulation();
+        auto& sim = driver->getSimulation();
         auto& unit = sim.getUnit(id);
 
         // check for collision at the new position
-        auto newFootprintRegion = scene->computeFootprintRegion(newPosition, unit.footprintX, unit.footprintZ);
+        auto newFootprintRegion = driver->computeFootprintRegion(newPosition, unit.footprintX, unit.footprintZ);
 
-        if (scene->isCollisionAt(newFootprintRegion, id))
+        if (driver->isCollisionAt(newFootprintRegion, id))
         {
             return false;
         }
@@ -578,86 +601,93 @@ namespace rwe
         }
 
         // we passed all collision checks, update accordingly
-        auto footprintRegion = scene->computeFootprintRegion(unit.position, unit.footprintX, unit.footprintZ);
-        scene->moveUnitOccupiedArea(footprintRegion, newFootprintRegion, id);
+        auto footprintRegion = driver->computeFootprintRegion(unit.position, unit.footprintX, unit.footprintZ);
+        driver->moveUnitOccupiedArea(footprintRegion, newFootprintRegion, id);
         unit.position = newPosition;
         return true;
     }
 
-    std::string UnitBehaviorService::getAimScriptName(unsigned int weaponIndex) const
+    CobEntryPoint UnitBehaviorService::getAimEntryPoint(unsigned int weaponIndex) const
     {
         switch (weaponIndex)
         {
             case 0:
-                return "AimPrimary";
+                return CobEntryPoint::AimPrimary;
             case 1:
-                return "AimSecondary";
+                return CobEntryPoint::AimSecondary;
             case 2:
-                return "AimTertiary";
+                return CobEntryPoint::AimTertiary;
             default:
-                throw std::logic_error("Invalid wepaon index: " + std::to_string(weaponIndex));
+                throw std::logic_error("Invalid weapon index: " + std::to_string(weaponIndex));
         }
     }
 
-    std::string UnitBehaviorService::getAimFromScriptName(unsigned int weaponIndex) const
+    CobEntryPoint UnitBehaviorService::getAimFromEntryPoint(unsigned int weaponIndex) const
     {
         switch (weaponIndex)
         {
             case 0:
-                return "AimFromPrimary";
+                return CobEntryPoint::AimFromPrimary;
             case 1:
-                return "AimFromSecondary";
+                return CobEntryPoint::AimFromSecondary;
             case 2:
-                return "AimFromTertiary";
+                return CobEntryPoint::AimFromTertiary;
             default:
                 throw std::logic_error("Invalid weapon index: " + std::to_string(weaponIndex));
         }
     }
 
-    std::string UnitBehaviorService::getFireScriptName(unsigned int weaponIndex) const
+    CobEntryPoint UnitBehaviorService::getFireEntryPoint(unsigned int weaponIndex) const
     {
         switch (weaponIndex)
         {
             case 0:
-                return "FirePrimary";
+                return CobEntryPoint::FirePrimary;
             case 1:
-                return "FireSecondary";
+                return CobEntryPoint::FireSecondary;
             case 2:
-                return "FireTertiary";
+                return CobEntryPoint::FireTertiary;
             default:
                 throw std::logic_error("Invalid weapon index: " + std::to_string(weaponIndex));
         }
     }
 
-    std::string UnitBehaviorService::getQueryScriptName(unsigned int weaponIndex) const
+    CobEntryPoint UnitBehaviorService::getQueryEntryPoint(unsigned int weaponIndex) const
     {
         switch (weaponIndex)
         {
             case 0:
-                return "QueryPrimary";
+                return CobEntryPoint::QueryPrimary;
             case 1:
-                return "QuerySecondary";
+                return CobEntryPoint::QuerySecondary;
             case 2:
-                return "QueryTertiary";
+                return CobEntryPoint::QueryTertiary;
             default:
-                throw std::logic_error("Invalid wepaon index: " + std::to_string(weaponIndex));
+                throw std::logic_error("Invalid weapon index: " + std::to_string(weaponIndex));
         }
     }
 
-    std::optional<int> UnitBehaviorService::runCobQuery(UnitId id, const std::string& name)
+    std::optional<int> UnitBehaviorService::runCobQuery(UnitId id, CobEntryPoint entryPoint)
     {
-        auto& unit = scene->getSimulation().getUnit(id);
-        auto thread = unit.cobEnvironment->createNonScheduledThread(name, {0});
+        auto& unit = driver->getSimulation().getUnit(id);
+        auto thread = unit.cobEnvironment->createNonScheduledThread(entryPoint, {0});
         if (!thread)
         {
             return std::nullopt;
         }
-        CobExecutionContext context(scene, &scene->getSimulation(), unit.cobEnvironment.get(), &*thread, id);
+        // Behavior runs one unit at a time,
+        // so anything the query does can be applied straight away.
+        CobCommandBuffer commands;
+        CobExecutionContext context(&commands, &driver->getSimulation(), &driver->getSimulation().rng, unit.cobEnvironment.get(), &*thread, id);
         auto status = context.execute();
         if (std::get_if<CobEnvironment::FinishedStatus>(&status) == nullptr)
         {
             throw std::runtime_error("Synchronous cob query thread blocked before completion");
         }
+        for (const auto& command : commands.unitCommands)
+        {
+            driver->applyCobUnitCommand(command);
+        }
 
         auto result = thread->returnLocals[0];
         return result;
@@ -665,14 +695,13 @@ namespace rwe
 
     SimVector UnitBehaviorService::getAimingPoint(UnitId id, unsigned int weaponIndex)
     {
-        const auto& unit = scene->getSimulation().getUnit(id);
+        const auto& unit = driver->getSimulation().getUnit(id);
         return unit.getTransform() * getLocalAimingPoint(id, weaponIndex);
     }
 
     SimVector UnitBehaviorService::getLocalAimingPoint(UnitId id, unsigned int weaponIndex)
     {
-        auto scriptName = getAimFromScriptName(weaponIndex);
-        auto pieceId = runCobQuery(id, scriptName);
+        auto pieceId = runCobQuery(id, getAimFromEntryPoint(weaponIndex));
         if (!pieceId)
         {
             return getLocalFiringPoint(id, weaponIndex);
@@ -683,15 +712,14 @@ namespace rwe
 
     SimVector UnitBehaviorService::getFiringPoint(UnitId id, unsigned int weaponIndex)
     {
-        const auto& unit = scene->getSimulation().getUnit(id);
+        const auto& unit = driver->getSimulation().getUnit(id);
         return unit.getTransform() * getLocalFiringPoint(id, weaponIndex);
     }
 
     SimVector UnitBehaviorService::getLocalFiringPoint(UnitId id, unsigned int weaponIndex)
     {
 
-        auto scriptName = getQueryScriptName(weaponIndex);
-        auto pieceId = runCobQuery(id, scriptName);
+        auto pieceId = runCobQuery(id, getQueryEntryPoint(weaponIndex));
         if (!pieceId)
         {
             return SimVector(0_ss, 0_ss, 0_ss);
@@ -702,10 +730,10 @@ namespace rwe
 
     SimVector UnitBehaviorService::getSweetSpot(UnitId id)
     {
-        auto pieceId = runCobQuery(id, "SweetSpot");
+        auto pieceId = runCobQuery(id, CobEntryPoint::SweetSpot);
         if (!pieceId)
         {
-            return scene->getSimulation().getUnit(id).position;
+            return driver->getSimulation().getUnit(id).position;
         }
 
         return getPiecePosition(id, *pieceId);
@@ -713,7 +741,7 @@ namespace rwe
 
     std::optional<SimVector> UnitBehaviorService::tryGetSweetSpot(UnitId id)
     {
-        if (!scene->getSimulation().unitExists(id))
+        if (!driver->getSimulation().unitExists(id))
         {
             return std::nullopt;
         }
@@ -744,12 +772,12 @@ namespace rwe
 
     bool UnitBehaviorService::handleMoveOrder(UnitId unitId, const MoveOrder& moveOrder)
     {
-        auto& unit = scene->getSimulation().getUnit(unitId);
+        auto& unit = driver->getSimulation().getUnit(unitId);
 
         if (auto idleState = std::get_if<IdleState>(&unit.behaviourState); idleState != nullptr)
         {
             // request a path to follow
-            scene->getSimulation().requestPath(unitId);
+            driver->getSimulation().requestPath(unitId);
             const auto& destination = moveOrder.destination;
             unit.behaviourState = MovingState{destination, std::nullopt, true};
         }
@@ -758,7 +786,7 @@ namespace rwe
             // if we are colliding, request a new path
             if (unit.inCollision && !movingState->pathRequested)
             {
-                auto& sim = scene->getSimulation();
+                auto& sim = driver->getSimulation();
 
                 // only request a new path if we don't have one yet,
                 // or we've already had our current one for a bit
@@ -781,7 +809,7 @@ namespace rwe
 
                     if (unit.arrivedSound)
                     {
-                        scene->playNotificationSound(unit.owner, *unit.arrivedSound);
+                        driver->playNotificationSound(unit.owner, *unit.arrivedSound);
                     }
 
                     return true;
@@ -794,7 +822,7 @@ namespace rwe
 
     bool UnitBehaviorService::handleAttackOrder(UnitId unitId, const AttackOrder& attackOrder)
     {
-        auto& unit = scene->getSimulation().getUnit(unitId);
+        auto& unit = driver->getSimulation().getUnit(unitId);
 
         if (!unit.weapons[0])
         {
@@ -816,7 +844,7 @@ namespace rwe
                 if (unit.position.distanceSquared(*targetPosition) > maxRangeSquared)
                 {
                     // request a path to follow
-                    scene->getSimulation().requestPath(unitId);
+                    driver->getSimulation().requestPath(unitId);
                     auto destination = attackTargetToMovingStateGoal(attackOrder.target);
                     unit.behaviourState = MovingState{destination, std::nullopt, true};
                 }
@@ -845,7 +873,7 @@ namespace rwe
                     // if we are colliding, request a new path
                     if (unit.inCollision && !movingState->pathRequested)
                     {
-                        auto& sim = scene->getSimulation();
+                        auto& sim = driver->getSimulation();
 
                         // only request a new path if we don't have one yet,
                         // or we've already had our current one for a bit
@@ -876,14 +904,14 @@ namespace rwe
 
     bool UnitBehaviorService::handleBuildOrder(UnitId unitId, const BuildOrder& buildOrder)
     {
-        auto& unit = scene->getSimulation().getUnit(unitId);
+        auto& unit = driver->getSimulation().getUnit(unitId);
 
         if (auto idleState = std::get_if<IdleState>(&unit.behaviourState); idleState != nullptr)
         {
             // request a path to get to the build site
             auto footprint = unitFactory->getUnitFootprint(buildOrder.unitType);
-            auto footprintRect = scene->computeFootprintRegion(buildOrder.position, footprint.x, footprint.y);
-            scene->getSimulation().requestPath(unitId);
+            auto footprintRect = driver->computeFootprintRegion(buildOrder.position, footprint.x, footprint.y);
+            driver->getSimulation().requestPath(unitId);
             unit.behaviourState = MovingState{footprintRect, std::nullopt, true};
         }
         else if (auto movingState = std::get_if<MovingState>(&unit.behaviourState); movingState != nullptr)
@@ -891,7 +919,7 @@ namespace rwe
             // if we are colliding, request a new path
             if (unit.inCollision && !movingState->pathRequested)
             {
-                auto& sim = scene->getSimulation();
+                auto& sim = driver->getSimulation();
 
                 // only request a new path if we don't have one yet,
                 // or we've already had our current one for a bit
@@ -909,7 +937,7 @@ namespace rwe
                 if (followPath(unit, *pathToFollow))
                 {
                     unit.behaviourState = CreatingUnitState{buildOrder.unitType, unit.owner, buildOrder.position};
-                    scene->getSimulation().unitCreationRequests.push_back(unitId);
+                    driver->getSimulation().unitCreationRequests.push_back(unitId);
                 }
             }
         }
@@ -925,7 +953,7 @@ namespace rwe
                 [&](const UnitCreationStatusDone& d) {
                     if (unit.buildSound)
                     {
-                        scene->playNotificationSound(unit.owner, *unit.buildSound);
+                        driver->playNotificationSound(unit.owner, *unit.buildSound);
                     }
 
                     auto nanoFromPosition = getNanoPoint(unitId);
@@ -933,7 +961,7 @@ namespace rwe
                     auto heading = headingAndPitch.first;
                     auto pitch = headingAndPitch.second;
 
-                    unit.cobEnvironment->createThread("StartBuilding", {toCobAngle(heading).value, toCobAngle(pitch).value});
+                    unit.cobEnvironment->createThread(CobEntryPoint::StartBuilding, {toCobAngle(heading).value, toCobAngle(pitch).value});
                     unit.behaviourState = BuildingState{d.unitId, std::nullopt};
                     return false;
                 },
@@ -943,19 +971,19 @@ namespace rwe
         }
         else if (auto buildingState = std::get_if<BuildingState>(&unit.behaviourState); buildingState != nullptr)
         {
-            if (!scene->getSimulation().unitExists(buildingState->targetUnit))
+            if (!driver->getSimulation().unitExists(buildingState->targetUnit))
             {
                 // the unit has gone away (maybe it was killed?), give up
-                unit.cobEnvironment->createThread("StopBuilding");
+                unit.cobEnvironment->createThread(CobEntryPoint::StopBuilding);
                 unit.behaviourState = IdleState();
                 return true;
             }
 
-            auto& targetUnit = scene->getSimulation().getUnit(buildingState->targetUnit);
+            auto& targetUnit = driver->getSimulation().getUnit(buildingState->targetUnit);
             if (targetUnit.isDead())
             {
                 // the target is dead, give up
-                unit.cobEnvironment->createThread("StopBuilding");
+                unit.cobEnvironment->createThread(CobEntryPoint::StopBuilding);
                 unit.behaviourState = IdleState();
                 return true;
             }
@@ -964,7 +992,7 @@ namespace rwe
             {
                 // the target does not need to be built anymore.
                 // Probably because it's finished -- we did it!
-                unit.cobEnvironment->createThread("StopBuilding");
+                unit.cobEnvironment->createThread(CobEntryPoint::StopBuilding);
                 unit.behaviourState = IdleState();
                 return true;
             }
@@ -975,7 +1003,7 @@ namespace rwe
                 return false;
             }
 
-            auto& sim = scene->getSimulation();
+            auto& sim = driver->getSimulation();
             auto costs = targetUnit.getBuildCostInfo(unit.workerTimePerTick);
             auto gotResources = sim.addResourceDelta(
                 unitId,
@@ -984,6 +1012,8 @@ namespace rwe
                 -costs.energyCost,
                 -costs.metalCost);
 
+            sim.changedUnits.push_back(unitId);
+
             if (!gotResources)
             {
                 // we don't have resources available to build -- wait
@@ -992,16 +1022,17 @@ namespace rwe
             }
             buildingState->nanoParticleOrigin = getNanoPoint(unitId);
 
+            sim.changedUnits.push_back(buildingState->targetUnit);
             if (targetUnit.addBuildProgress(unit.workerTimePerTick))
             {
                 // play sound when the unit is completed
                 if (targetUnit.completeSound)
                 {
-                    scene->playNotificationSound(targetUnit.owner, *targetUnit.completeSound);
+                    driver->playNotificationSound(targetUnit.owner, *targetUnit.completeSound);
                 }
                 if (targetUnit.activateWhenBuilt)
                 {
-                    scene->activateUnit(buildingState->targetUnit);
+                    driver->activateUnit(buildingState->targetUnit);
                 }
             }
         }
@@ -1011,12 +1042,12 @@ namespace rwe
 
     bool UnitBehaviorService::handleBuggerOffOrder(UnitId unitId, const BuggerOffOrder& buggerOffOrder)
     {
-        auto& unit = scene->getSimulation().getUnit(unitId);
+        auto& unit = driver->getSimulation().getUnit(unitId);
         if (auto idleState = std::get_if<IdleState>(&unit.behaviourState); idleState != nullptr)
         {
             // request a path to get to the build site
             auto destRect = buggerOffOrder.rect.expand((unit.footprintX * 3) - 4, (unit.footprintZ * 3) - 4);
-            scene->getSimulation().requestPath(unitId);
+            driver->getSimulation().requestPath(unitId);
             unit.behaviourState = MovingState{destRect, std::nullopt, true};
         }
         else if (auto movingState = std::get_if<MovingState>(&unit.behaviourState); movingState != nullptr)
@@ -1024,7 +1055,7 @@ namespace rwe
             // if we are colliding, request a new path
             if (unit.inCollision && !movingState->pathRequested)
             {
-                auto& sim = scene->getSimulation();
+                auto& sim = driver->getSimulation();
 
                 // only request a new path if we don't have one yet,
                 // or we've already had our current one for a bit
@@ -1052,7 +1083,7 @@ namespace rwe
 
     bool UnitBehaviorService::handleCompleteBuildOrder(rwe::UnitId unitId, const rwe::CompleteBuildOrder& buildOrder)
     {
-        auto& sim = scene->getSimulation();
+        auto& sim = driver->getSimulation();
         auto& unit = sim.getUnit(unitId);
 
         auto targetUnitRef = sim.tryGetUnit(buildOrder.target);
@@ -1060,7 +1091,7 @@ namespace rwe
         {
             if (std::holds_alternative<BuildingState>(unit.behaviourState))
             {
-                unit.cobEnvironment->createThread("StopBuilding");
+                unit.cobEnvironment->createThread(CobEntryPoint::StopBuilding);
             }
             unit.behaviourState = IdleState();
             return true;
@@ -1076,14 +1107,14 @@ namespace rwe
                 auto heading = headingAndPitch.first;
                 auto pitch = headingAndPitch.second;
 
-                unit.cobEnvironment->createThread("StartBuilding", {toCobAngle(heading).value, toCobAngle(pitch).value});
+                unit.cobEnvironment->createThread(CobEntryPoint::StartBuilding, {toCobAngle(heading).value, toCobAngle(pitch).value});
                 unit.behaviourState = BuildingState{buildOrder.target};
                 return false;
             }
 
             // request a path to get to the build site
-            auto footprintRect = scene->computeFootprintRegion(targetUnit.position, targetUnit.footprintX, targetUnit.footprintZ);
-            scene->getSimulation().requestPath(unitId);
+            auto footprintRect = driver->computeFootprintRegion(targetUnit.position, targetUnit.footprintX, targetUnit.footprintZ);
+            driver->getSimulation().requestPath(unitId);
             unit.behaviourState = MovingState{footprintRect, std::nullopt, true};
         }
         else if (auto movingState = std::get_if<MovingState>(&unit.behaviourState); movingState != nullptr)
@@ -1095,7 +1126,7 @@ namespace rwe
                 auto heading = headingAndPitch.first;
                 auto pitch = headingAndPitch.second;
 
-                unit.cobEnvironment->createThread("StartBuilding", {toCobAngle(heading).value, toCobAngle(pitch).value});
+                unit.cobEnvironment->createThread(CobEntryPoint::StartBuilding, {toCobAngle(heading).value, toCobAngle(pitch).value});
                 unit.behaviourState = BuildingState{buildOrder.target};
                 return false;
             }
@@ -1123,7 +1154,7 @@ namespace rwe
                     auto heading = headingAndPitch.first;
                     auto pitch = headingAndPitch.second;
 
-                    unit.cobEnvironment->createThread("StartBuilding", {toCobAngle(heading).value, toCobAngle(pitch).value});
+                    unit.cobEnvironment->createThread(CobEntryPoint::StartBuilding, {toCobAngle(heading).value, toCobAngle(pitch).value});
                     unit.behaviourState = BuildingState{buildOrder.target};
                 }
             }
@@ -1144,6 +1175,8 @@ namespace rwe
                 -costs.energyCost,
                 -costs.metalCost);
 
+            sim.changedUnits.push_back(unitId);
+
             if (!gotResources)
             {
                 // we don't have resources available to build -- wait
@@ -1152,16 +1185,17 @@ namespace rwe
             }
             buildingState->nanoParticleOrigin = getNanoPoint(unitId);
 
+            sim.changedUnits.push_back(buildingState->targetUnit);
             if (targetUnit.addBuildProgress(unit.workerTimePerTick))
             {
                 // play sound when the unit is completed
                 if (targetUnit.completeSound)
                 {
-                    scene->playNotificationSound(targetUnit.owner, *targetUnit.completeSound);
+                    driver->playNotificationSound(targetUnit.owner, *targetUnit.completeSound);
                 }
                 if (targetUnit.activateWhenBuilt)
                 {
-                    scene->activateUnit(buildingState->targetUnit);
+                    driver->activateUnit(buildingState->targetUnit);
                 }
             }
         }
@@ -1171,12 +1205,12 @@ namespace rwe
 
     bool UnitBehaviorService::handleBuild(UnitId unitId, const std::string& unitType)
     {
-        auto& unit = scene->getSimulation().getUnit(unitId);
+        auto& unit = driver->getSimulation().getUnit(unitId);
 
         return match(
             unit.factoryState,
             [&](const FactoryStateIdle&) {
-                scene->activateUnit(unitId);
+                driver->activateUnit(unitId);
                 unit.factoryState = FactoryStateBuilding();
                 return false;
             },
@@ -1187,7 +1221,7 @@ namespace rwe
                         return false;
                     },
                     [&](const UnitCreationStatusDone& s) {
-                        unit.cobEnvironment->createThread("StartBuilding");
+                        unit.cobEnvironment->createThread(CobEntryPoint::StartBuilding);
                         unit.factoryState = FactoryStateBuilding{std::make_pair(s.unitId, std::optional<SimVector>())};
                         return false;
                     },
@@ -1202,23 +1236,23 @@ namespace rwe
                     return false;
                 }
 
-                auto& sim = scene->getSimulation();
+                auto& sim = driver->getSimulation();
 
                 auto buildPieceInfo = getBuildPieceInfo(unitId);
                 buildPieceInfo.position.y = sim.terrain.getHeightAt(buildPieceInfo.position.x, buildPieceInfo.position.z);
                 if (!state.targetUnit)
                 {
                     unit.factoryState = FactoryStateCreatingUnit{unitType, unit.owner, buildPieceInfo.position};
-                    scene->getSimulation().unitCreationRequests.push_back(unitId);
+                    driver->getSimulation().unitCreationRequests.push_back(unitId);
                     return false;
                 }
 
-                auto& targetUnit = scene->getSimulation().getUnit(state.targetUnit->first);
+                auto& targetUnit = driver->getSimulation().getUnit(state.targetUnit->first);
                 if (targetUnit.unitType != unitType)
                 {
                     if (targetUnit.isBeingBuilt() && !targetUnit.isDead())
                     {
-                        scene->quietlyKillUnit(state.targetUnit->first);
+                        driver->quietlyKillUnit(state.targetUnit->first);
                     }
                     state.targetUnit = std::nullopt;
                     return false;
@@ -1226,8 +1260,8 @@ namespace rwe
 
                 if (targetUnit.isDead())
                 {
-                    unit.cobEnvironment->createThread("StopBuilding");
-                    scene->deactivateUnit(unitId);
+                    unit.cobEnvironment->createThread(CobEntryPoint::StopBuilding);
+                    driver->deactivateUnit(unitId);
                     unit.factoryState = FactoryStateIdle();
                     return true;
                 }
@@ -1236,17 +1270,18 @@ namespace rwe
                 {
                     if (targetUnit.orders.empty())
                     {
-                        auto footprintRect = scene->computeFootprintRegion(unit.position, unit.footprintX, unit.footprintZ);
+                        auto footprintRect = driver->computeFootprintRegion(unit.position, unit.footprintX, unit.footprintZ);
                         targetUnit.addOrder(BuggerOffOrder(footprintRect));
                     }
-                    unit.cobEnvironment->createThread("StopBuilding");
-                    scene->deactivateUnit(unitId);
+                    unit.cobEnvironment->createThread(CobEntryPoint::StopBuilding);
+                    driver->deactivateUnit(unitId);
                     unit.factoryState = FactoryStateIdle();
                     return true;
                 }
 
                 tryApplyMovementToPosition(state.targetUnit->first, buildPieceInfo.position);
                 targetUnit.rotation = buildPieceInfo.rotation;
+                sim.changedUnits.push_back(state.targetUnit->first);
 
                 auto costs = targetUnit.getBuildCostInfo(unit.workerTimePerTick);
                 auto gotResources = sim.addResourceDelta(
@@ -1256,6 +1291,8 @@ namespace rwe
                     -costs.energyCost,
                     -costs.metalCost);
 
+                sim.changedUnits.push_back(unitId);
+
                 if (!gotResources)
                 {
                     // we don't have resources available to build -- wait
@@ -1269,11 +1306,11 @@ namespace rwe
                     // play sound when the unit is completed
                     if (targetUnit.completeSound)
                     {
-                        scene->playNotificationSound(targetUnit.owner, *targetUnit.completeSound);
+                        driver->playNotificationSound(targetUnit.owner, *targetUnit.completeSound);
                     }
                     if (targetUnit.activateWhenBuilt)
                     {
-                        scene->activateUnit(state.targetUnit->first);
+                        driver->activateUnit(state.targetUnit->first);
                     }
                 }
 
@@ -1283,7 +1320,7 @@ namespace rwe
 
     void UnitBehaviorService::clearBuild(UnitId unitId)
     {
-        auto& unit = scene->getSimulation().getUnit(unitId);
+        auto& unit = driver->getSimulation().getUnit(unitId);
 
         match(
             unit.factoryState,
@@ -1294,31 +1331,31 @@ namespace rwe
                 match(
                     state.status,
                     [&](const UnitCreationStatusDone& d) {
-                        scene->quietlyKillUnit(d.unitId);
+                        driver->quietlyKillUnit(d.unitId);
                     },
                     [&](const auto&) {
                         // do nothing
                     });
-                scene->deactivateUnit(unitId);
+                driver->deactivateUnit(unitId);
                 unit.factoryState = FactoryStateIdle();
             },
             [&](const FactoryStateBuilding& state) {
                 if (state.targetUnit)
                 {
-                    scene->quietlyKillUnit(state.targetUnit->first);
-                    unit.cobEnvironment->createThread("StopBuilding");
+                    driver->quietlyKillUnit(state.targetUnit->first);
+                    unit.cobEnvironment->createThread(CobEntryPoint::StopBuilding);
                 }
-                scene->deactivateUnit(unitId);
+                driver->deactivateUnit(unitId);
                 unit.factoryState = FactoryStateIdle();
             });
     }
 
     SimVector UnitBehaviorService::getNanoPoint(UnitId id)
     {
-        auto pieceId = runCobQuery(id, "QueryNanoPiece");
+        auto pieceId = runCobQuery(id, CobEntryPoint::QueryNanoPiece);
         if (!pieceId)
         {
-            return scene->getSimulation().getUnit(id).position;
+            return driver->getSimulation().getUnit(id).position;
         }
 
         return getPiecePosition(id, *pieceId);
@@ -1326,10 +1363,9 @@ namespace rwe
 
     SimVector UnitBehaviorService::getPieceLocalPosition(UnitId id, unsigned int pieceId)
     {
-        auto& unit = scene->getSimulation().getUnit(id);
+        auto& unit = driver->getSimulation().getUnit(id);
 
-        const auto& pieceName = unit.cobEnvironment->_script->pieces.at(pieceId);
-        auto pieceTransform = unit.mesh.getPieceTransform(pieceName);
+        auto pieceTransform = unit.getPieceTransform(pieceId);
         if (!pieceTransform)
         {
             throw std::logic_error("Failed to find piece offset");
@@ -1340,7 +1376,7 @@ namespace rwe
 
     SimVector UnitBehaviorService::getPiecePosition(UnitId id, unsigned int pieceId)
     {
-        auto& unit = scene->getSimulation().getUnit(id);
+        auto& unit = driver->getSimulation().getUnit(id);
 
         return unit.getTransform() * getPieceLocalPosition(id, pieceId);
     }
@@ -1352,10 +1388,9 @@ namespace rwe
 
     SimAngle UnitBehaviorService::getPieceXZRotation(UnitId id, unsigned int pieceId)
     {
-        auto& unit = scene->getSimulation().getUnit(id);
+        auto& unit = driver->getSimulation().getUnit(id);
 
-        const auto& pieceName = unit.cobEnvironment->_script->pieces.at(pieceId);
-        auto pieceTransform = unit.mesh.getPieceTransform(pieceName);
+        auto pieceTransform = unit.getPieceTransform(pieceId);
         if (!pieceTransform)
         {
             throw std::logic_error("Failed to find piece offset");
@@ -1378,10 +1413,10 @@ namespace rwe
 
     UnitBehaviorService::BuildPieceInfo UnitBehaviorService::getBuildPieceInfo(UnitId id)
     {
-        auto pieceId = runCobQuery(id, "QueryBuildInfo");
+        auto pieceId = runCobQuery(id, CobEntryPoint::QueryBuildInfo);
         if (!pieceId)
         {
-            const auto& unit = scene->getSimulation().getUnit(id);
+            const auto& unit = driver->getSimulation().getUnit(id);
             return BuildPieceInfo{unit.position, unit.rotation};
         }
 
@@ -1402,8 +1437,8 @@ namespace rwe
             target,
             [](const SimVector& target) { return MovingStateGoal(target); },
             [this](UnitId unitId) {
-                const auto& targetUnit = scene->getSimulation().getUnit(unitId);
-                return MovingStateGoal(scene->computeFootprintRegion(targetUnit.position, targetUnit.footprintX, targetUnit.footprintZ));
+                const auto& targetUnit = driver->getSimulation().getUnit(unitId);
+                return MovingStateGoal(driver->computeFootprintRegion(targetUnit.position, targetUnit.footprintX, targetUnit.footprintZ));
             });
     }
 }
@@ -11,18 +11,18 @@
 
 namespace rwe
 {
-    class GameScene;
+    class SimulationDriver;
 
     class UnitBehaviorService
     {
     private:
-        GameScene* const scene;
+        SimulationDriver* const driver;
         UnitFactory* const unitFactory;
         CobExecutionService* const cobExecutionService;
 
     public:
         UnitBehaviorService(
-            GameScene* scene,
+            SimulationDriver* driver,
             UnitFactory* unitFactory,
             CobExecutionService* cobExecutionService);
 
@@ -79,12 +79,12 @@ namespace rwe
 
         bool tryApplyMovementToPosition(UnitId id, const SimVector& newPosition);
 
-        std::string getAimScriptName(unsigned int weaponIndex) const;
-        std::string getAimFromScriptName(unsigned int weaponIndex) const;
-        std::string getFireScriptName(unsigned int weaponIndex) const;
-        std::string getQueryScriptName(unsigned int weaponIndex) const;
+        CobEntryPoint getAimEntryPoint(unsigned int weaponIndex) const;
+        CobEntryPoint getAimFromEntryPoint(unsigned int weaponIndex) const;
+        CobEntryPoint getFireEntryPoint(unsigned int weaponIndex) const;
+        CobEntryPoint getQueryEntryPoint(unsigned int weaponIndex) const;
 
-        std::optional<int> runCobQuery(UnitId id, const std::string& name);
+        std::optional<int> runCobQuery(UnitId id, CobEntryPoint entryPoint);
 
         SimVector getAimingPoint(UnitId id, unsigned int weaponIndex);
         SimVector getLocalAimingPoint(UnitId id, unsigned int weaponIndex);
@@ -21,7 +21,38 @@ namespace rwe
 
     void UnitDatabase::addUnitInfo(const std::string& unitName, const UnitFbi& info)
     {
-        map.insert({toUpper(unitName), info});
+        auto key = toUpper(unitName);
+        if (map.insert({key, info}).second)
+        {
+            unitTypeIds.insert({std::move(key), UnitTypeId(static_cast<unsigned int>(unitTypeIds.size()))});
+        }
+    }
+
+    std::optional<UnitTypeId> UnitDatabase::tryGetUnitTypeId(const std::string& unitName) const
+    {
+        auto it = unitTypeIds.find(toUpper(unitName));
+        if (it == unitTypeIds.end())
+        {
+            return std::nullopt;
+        }
+
+        return it->second;
+    }
+
+    UnitTypeId UnitDatabase::getUnitTypeId(const std::string& unitName) const
+    {
+        auto id = tryGetUnitTypeId(unitName);
+        if (!id)
+        {
+            throw std::runtime_error("No FBI data found for unit " + unitName);
+        }
+
+        return *id;
+    }
+
+    unsigned int UnitDatabase::getUnitTypeCount() const
+    {
+        return static_cast<unsigned int>(unitTypeIds.size());
     }
 
     const CobScript& UnitDatabase::getUnitScript(const std::string& unitName) const
@@ -85,7 +116,7 @@ namespace rwe
         soundClassMap.insert({className, std::move(soundClass)});
     }
 
-    const AudioService::SoundHandle& UnitDatabase::getSoundHandle(const std::string& sound) const
+    const SoundHandle& UnitDatabase::getSoundHandle(const std::string& sound) const
     {
         auto it = soundMap.find(sound);
         if (it == soundMap.end())
@@ -96,7 +127,7 @@ namespace rwe
         return it->second;
     }
 
-    std::optional<AudioService::SoundHandle> UnitDatabase::tryGetSoundHandle(const std::string& sound)
+    std::optional<SoundHandle> UnitDatabase::tryGetSoundHandle(const std::string& sound)
     {
         auto it = soundMap.find(sound);
         if (it == soundMap.end())
@@ -107,7 +138,7 @@ namespace rwe
         return it->second;
     }
 
-    void UnitDatabase::addSound(const std::string& soundName, const AudioService::SoundHandle& sound)
+    void UnitDatabase::addSound(const std::string& soundName, const SoundHandle& sound)
     {
         soundMap.insert({soundName, sound});
     }
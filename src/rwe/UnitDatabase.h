@@ -1,11 +1,17 @@
 #pragma once
 
-#include <rwe/AudioService.h>
+#include <optional>
 #include <rwe/Cob.h>
 #include <rwe/MovementClass.h>
 #include <rwe/SoundClass.h>
+#include <rwe/SoundHandle.h>
+#include <rwe/UnitTypeId.h>
 #include <rwe/WeaponTdf.h>
 #include <rwe/fbi/UnitFbi.h>
+#include <rwe/gui.h>
+#include <string>
+#include <unordered_map>
+#include <vector>
 
 namespace rwe
 {
@@ -17,6 +23,9 @@ namespace rwe
     private:
         std::unordered_map<std::string, UnitFbi> map;
 
+        /** Unit type ids by upper-cased unit name, handed out in the order units are added. */
+        std::unordered_map<std::string, UnitTypeId> unitTypeIds;
+
         std::unordered_map<std::string, CobScript> cobMap;
 
         std::unordered_map<std::string, WeaponTdf> weaponMap;
@@ -25,7 +34,7 @@ namespace rwe
 
         std::unordered_map<std::string, MovementClass> movementClassMap;
 
-        std::unordered_map<std::string, AudioService::SoundHandle> soundMap;
+        std::unordered_map<std::string, SoundHandle> soundMap;
 
         std::unordered_map<std::string, std::vector<std::vector<GuiEntry>>> builderGuisMap;
 
@@ -36,6 +45,13 @@ namespace rwe
 
         void addUnitInfo(const std::string& unitName, const UnitFbi& info);
 
+        std::optional<UnitTypeId> tryGetUnitTypeId(const std::string& unitName) const;
+
+        UnitTypeId getUnitTypeId(const std::string& unitName) const;
+
+        /** Returns the number of unit types, which is one more than the highest unit type id. */
+        unsigned int getUnitTypeCount() const;
+
         const CobScript& getUnitScript(const std::string& unitName) const;
 
         void addUnitScript(const std::string& unitName, CobScript&& cob);
@@ -54,11 +70,11 @@ namespace rwe
 
         void addMovementClass(const std::string& className, MovementClass&& movementClass);
 
-        const AudioService::SoundHandle& getSoundHandle(const std::string& sound) const;
+        const SoundHandle& getSoundHandle(const std::string& sound) const;
 
-        std::optional<AudioService::SoundHandle> tryGetSoundHandle(const std::string& sound);
+        std::optional<SoundHandle> tryGetSoundHandle(const std::string& sound);
 
-        void addSound(const std::string& soundName, const AudioService::SoundHandle& sound);
+        void addSound(const std::string& soundName, const SoundHandle& sound);
 
         std::optional<std::reference_wrapper<const std::vector<std::vector<GuiEntry>>>> tryGetBuilderGui(const std::string& unitName) const;
 
@@ -19,12 +19,11 @@ namespace rwe
     {
     }
 
-    void setShadeRecursive(UnitMesh& mesh, bool shade)
+    void setShade(UnitMesh& mesh, bool shade)
     {
-        mesh.shaded = shade;
-        for (auto& c : mesh.children)
+        for (auto& piece : mesh.pieces)
         {
-            setShadeRecursive(c, shade);
+            piece.shaded = shade;
         }
     }
 
@@ -105,14 +104,19 @@ namespace rwe
         if (fbi.bmCode) // unit is mobile
         {
             // don't shade mobile units
-            setShadeRecursive(meshInfo.mesh, false);
+            setShade(meshInfo.mesh, false);
         }
 
         const auto& script = unitDatabase.getUnitScript(fbi.unitName);
         auto cobEnv = std::make_unique<CobEnvironment>(&script);
-        Unit unit(meshInfo.mesh, std::move(cobEnv), std::move(meshInfo.selectionMesh));
+        Unit unit(meshInfo.mesh, std::move(cobEnv), meshInfo.selectionMesh);
+        for (const auto& pieceName : script.pieces)
+        {
+            unit.scriptPieceIndices.push_back(unit.mesh.findPieceIndex(pieceName));
+        }
         unit.name = fbi.name;
         unit.unitType = toUpper(unitType);
+        unit.unitTypeId = unitDatabase.getUnitTypeId(unitType);
         unit.owner = owner;
         unit.position = position;
         unit.height = meshInfo.height;
@@ -328,6 +332,7 @@ namespace rwe
     {
         const auto& tdf = unitDatabase.getWeapon(weaponType);
         UnitWeapon weapon;
+        weapon.definition = getWeaponDefinition(weaponType);
 
         weapon.maxRange = SimScalar(tdf.range);
         weapon.reloadTime = SimScalar(tdf.reloadTime);
@@ -344,11 +349,44 @@ namespace rwe
             : tdf.ballistic ? ProjectilePhysicsType::Ballistic
                             : ProjectilePhysicsType::LineOfSight;
 
+        weapon.commandFire = tdf.commandFire;
+        weapon.startSmoke = tdf.startSmoke;
+        if (!tdf.soundStart.empty())
+        {
+            weapon.soundStart = unitDatabase.tryGetSoundHandle(tdf.soundStart);
+        }
+
+        if (tdf.weaponTimer != 0.0f)
+        {
+            weapon.weaponTimer = GameTime(static_cast<unsigned int>(tdf.weaponTimer * 60.0f));
+        }
+
+        return weapon;
+    }
+
+    std::shared_ptr<const WeaponDefinition> UnitFactory::getWeaponDefinition(const std::string& weaponType)
+    {
+        auto key = toUpper(weaponType);
+        auto it = weaponDefinitions.find(key);
+        if (it == weaponDefinitions.end())
+        {
+            it = weaponDefinitions.insert({std::move(key), createWeaponDefinition(weaponType)}).first;
+        }
+
+        return it->second;
+    }
+
+    std::shared_ptr<const WeaponDefinition> UnitFactory::createWeaponDefinition(const std::string& weaponType)
+    {
+        const auto& tdf = unitDatabase.getWeapon(weaponType);
+        auto weapon = std::make_shared<WeaponDefinition>();
+        weapon->weaponType = weaponType;
+
         switch (tdf.renderType)
         {
             case 0:
             {
-                weapon.renderType = ProjectileRenderTypeLaser{
+                weapon->renderType = ProjectileRenderTypeLaser{
                     getLaserColor(tdf.color),
                     getLaserColor(tdf.color2),
                     SimScalar(tdf.duration * 60.0f * 2.0f), // duration seems to match better if doubled
@@ -358,82 +396,86 @@ namespace rwe
             case 1:
             {
                 auto mesh = meshService.loadProjectileMesh(tdf.model, PlayerColorIndex(0));
-                setShadeRecursive(mesh, false);
-                weapon.renderType = ProjectileRenderTypeModel{
+                setShade(mesh, false);
+                weapon->renderType = ProjectileRenderTypeModel{
                     std::make_shared<UnitMesh>(std::move(mesh)), ProjectileRenderTypeModel::RotationMode::HalfZ};
                 break;
             }
             case 3:
             {
                 auto mesh = meshService.loadProjectileMesh(tdf.model, PlayerColorIndex(0));
-                setShadeRecursive(mesh, false);
-                weapon.renderType = ProjectileRenderTypeModel{
+                setShade(mesh, false);
+                weapon->renderType = ProjectileRenderTypeModel{
                     std::make_shared<UnitMesh>(std::move(mesh)), ProjectileRenderTypeModel::RotationMode::QuarterY};
                 break;
             }
             case 4:
             {
                 auto sprite = textureService->getGafEntry("anims/fx.gaf", getFxName(tdf.color));
-                weapon.renderType = ProjectileRenderTypeSprite{sprite};
+                weapon->renderType = ProjectileRenderTypeSprite{sprite};
                 break;
             }
             case 6:
             {
                 auto mesh = meshService.loadProjectileMesh(tdf.model, PlayerColorIndex(0));
-                setShadeRecursive(mesh, false);
-                weapon.renderType = ProjectileRenderTypeModel{
+                setShade(mesh, false);
+                weapon->renderType = ProjectileRenderTypeModel{
                     std::make_shared<UnitMesh>(std::move(mesh)), ProjectileRenderTypeModel::RotationMode::None};
                 break;
             }
             default:
             {
-                weapon.renderType = ProjectileRenderTypeLaser{
+                weapon->renderType = ProjectileRenderTypeLaser{
                     Vector3f(0.0f, 0.0f, 0.0f),
                     Vector3f(0.0f, 0.0f, 0.0f),
                     SimScalar(4.0f)};
                 break;
             }
         }
-        weapon.commandFire = tdf.commandFire;
-        weapon.startSmoke = tdf.startSmoke;
-        weapon.endSmoke = tdf.endSmoke;
+        weapon->endSmoke = tdf.endSmoke;
         if (tdf.smokeTrail)
         {
-            weapon.smokeTrail = GameTime(static_cast<unsigned int>(tdf.smokeDelay * 60.0f));
-        }
-        if (!tdf.soundStart.empty())
-        {
-            weapon.soundStart = unitDatabase.tryGetSoundHandle(tdf.soundStart);
+            weapon->smokeTrail = GameTime(static_cast<unsigned int>(tdf.smokeDelay * 60.0f));
         }
         if (!tdf.soundHit.empty())
         {
-            weapon.soundHit = unitDatabase.tryGetSoundHandle(tdf.soundHit);
+            weapon->soundHit = unitDatabase.tryGetSoundHandle(tdf.soundHit);
         }
         if (!tdf.soundWater.empty())
         {
-            weapon.soundWater = unitDatabase.tryGetSoundHandle(tdf.soundWater);
+            weapon->soundWater = unitDatabase.tryGetSoundHandle(tdf.soundWater);
         }
         if (!tdf.explosionGaf.empty() && !tdf.explosionArt.empty())
         {
-            weapon.explosion = textureService->getGafEntry("anims/" + tdf.explosionGaf + ".gaf", tdf.explosionArt);
+            weapon->explosion = textureService->getGafEntry("anims/" + tdf.explosionGaf + ".gaf", tdf.explosionArt);
         }
         if (!tdf.waterExplosionGaf.empty() && !tdf.waterExplosionArt.empty())
         {
-            weapon.waterExplosion = textureService->getGafEntry("anims/" + tdf.waterExplosionGaf + ".gaf", tdf.waterExplosionArt);
+            weapon->waterExplosion = textureService->getGafEntry("anims/" + tdf.waterExplosionGaf + ".gaf", tdf.waterExplosionArt);
         }
 
+        // Unit types without their own entry take the default damage,
+        // so fill that in first and overwrite it with the specific entries.
+        auto defaultDamage = WeaponDefinition::NoDamage;
         for (const auto& p : tdf.damage)
         {
-            weapon.damage.insert_or_assign(toUpper(p.first), p.second);
+            if (toUpper(p.first) == "DEFAULT")
+            {
+                defaultDamage = p.second;
+            }
         }
-
-        weapon.damageRadius = SimScalar(static_cast<float>(tdf.areaOfEffect) / 2.0f);
-
-        if (tdf.weaponTimer != 0.0f)
+        weapon->damage.assign(unitDatabase.getUnitTypeCount(), defaultDamage);
+        for (const auto& p : tdf.damage)
         {
-            weapon.weaponTimer = GameTime(static_cast<unsigned int>(tdf.weaponTimer * 60.0f));
+            // entries for units that aren't loaded can never be hit
+            if (auto unitTypeId = unitDatabase.tryGetUnitTypeId(p.first))
+            {
+                weapon->damage[unitTypeId->value] = p.second;
+            }
         }
 
+        weapon->damageRadius = SimScalar(static_cast<float>(tdf.areaOfEffect) / 2.0f);
+
         return weapon;
     }
 
@@ -1,12 +1,15 @@
 #pragma once
 
+#include <memory>
 #include <rwe/MeshService.h>
 #include <rwe/MovementClass.h>
 #include <rwe/MovementClassCollisionService.h>
 #include <rwe/SimVector.h>
 #include <rwe/Unit.h>
 #include <rwe/UnitDatabase.h>
+#include <rwe/WeaponDefinition.h>
 #include <string>
+#include <unordered_map>
 
 namespace rwe
 {
@@ -20,6 +23,9 @@ namespace rwe
         const ColorPalette* palette;
         const ColorPalette* guiPalette;
 
+        /** Weapon definitions by upper-cased weapon name, created the first time each is needed. */
+        std::unordered_map<std::string, std::shared_ptr<const WeaponDefinition>> weaponDefinitions;
+
     public:
         UnitFactory(
             TextureService* textureService,
@@ -43,9 +49,13 @@ namespace rwe
 
         bool isValidUnitType(const std::string& unitType) const;
 
-    private:
         UnitWeapon createWeapon(const std::string& weaponType);
 
+        std::shared_ptr<const WeaponDefinition> getWeaponDefinition(const std::string& weaponType);
+
+    private:
+        std::shared_ptr<const WeaponDefinition> createWeaponDefinition(const std::string& weaponType);
+
         Vector3f getLaserColor(unsigned int colorIndex);
     };
 }
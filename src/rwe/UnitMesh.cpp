@@ -4,145 +4,366 @@
 #include <boost/algorithm/string.hpp>
 #include <rwe/math/Matrix4f.h>
 #include <rwe/math/rwe_math.h>
+#include <rwe/overloaded.h>
 #include <rwe/util.h>
 
 namespace rwe
 {
-    void applyMoveOperation(std::optional<UnitMesh::MoveOperation>& op, SimScalar& currentPos, SimScalar dt)
+    static SimScalar& getOffset(UnitMesh::Piece& piece, Axis axis)
     {
-        if (op)
+        switch (axis)
         {
-            auto remaining = op->targetPosition - currentPos;
-            auto frameSpeed = op->speed * dt;
-            if (abs(remaining) <= frameSpeed)
-            {
-                currentPos = op->targetPosition;
-                op = std::nullopt;
-            }
-            else
-            {
-                currentPos += frameSpeed * (remaining > 0_ss ? 1_ss : -1_ss);
-            }
+            case Axis::X:
+                return piece.offset.x;
+            case Axis::Y:
+                return piece.offset.y;
+            case Axis::Z:
+                return piece.offset.z;
         }
+
+        throw std::logic_error("Invalid axis");
     }
 
-    void applyTurnOperation(std::optional<UnitMesh::TurnOperationUnion>& op, SimAngle& currentAngle, SimScalar dt)
+    static SimAngle& getRotation(UnitMesh::Piece& piece, Axis axis)
     {
-        if (!op)
+        switch (axis)
         {
-            return;
+            case Axis::X:
+                return piece.rotationX;
+            case Axis::Y:
+                return piece.rotationY;
+            case Axis::Z:
+                return piece.rotationZ;
         }
 
-        if (auto turnOp = std::get_if<UnitMesh::TurnOperation>(&*op); turnOp != nullptr)
+        throw std::logic_error("Invalid axis");
+    }
+
+    /** Returns true if the move finished. */
+    static bool applyMove(SimScalar& currentPos, SimScalar targetPosition, SimScalar speed, SimScalar dt)
+    {
+        auto remaining = targetPosition - currentPos;
+        auto frameSpeed = speed * dt;
+        if (abs(remaining) <= frameSpeed)
         {
-            auto frameSpeed = simAngleFromSimScalar(turnOp->speed * dt);
-            currentAngle = turnTowards(currentAngle, turnOp->targetAngle, frameSpeed);
-            if (currentAngle == turnOp->targetAngle)
-            {
-                op = std::nullopt;
-            }
+            currentPos = targetPosition;
+            return true;
+        }
 
-            return;
+        currentPos += frameSpeed * (remaining > 0_ss ? 1_ss : -1_ss);
+        return false;
+    }
+
+    /** Returns true if the turn finished. */
+    static bool applyTurn(SimAngle& currentAngle, SimAngle targetAngle, SimScalar speed, SimScalar dt)
+    {
+        auto frameSpeed = simAngleFromSimScalar(speed * dt);
+        currentAngle = turnTowards(currentAngle, targetAngle, frameSpeed);
+        return currentAngle == targetAngle;
+    }
+
+    static void applyRotation(SimAngle& currentAngle, SimScalar speed, SimScalar dt)
+    {
+        auto frameSpeed = speed * dt;
+        if (frameSpeed > 0_ss)
+        {
+            currentAngle += simAngleFromSimScalar(frameSpeed);
         }
+        else
+        {
+            currentAngle -= simAngleFromSimScalar(-frameSpeed);
+        }
+    }
 
-        if (auto spinOp = std::get_if<UnitMesh::SpinOperation>(&*op); spinOp != nullptr)
+    static void applySpin(SimAngle& currentAngle, SimScalar& currentSpeed, SimScalar targetSpeed, SimScalar acceleration, SimScalar dt)
+    {
+        auto frameAccel = acceleration / 2_ss;
+        auto remaining = targetSpeed - currentSpeed;
+        if (abs(remaining) <= frameAccel)
         {
-            auto frameAccel = spinOp->acceleration / 2_ss;
-            auto remaining = spinOp->targetSpeed - spinOp->currentSpeed;
-            if (abs(remaining) <= frameAccel)
-            {
-                spinOp->currentSpeed = spinOp->targetSpeed;
-            }
-            else
-            {
-                spinOp->currentSpeed += frameAccel * (remaining > 0_ss ? 1_ss : -1_ss);
-            }
+            currentSpeed = targetSpeed;
+        }
+        else
+        {
+            currentSpeed += frameAccel * (remaining > 0_ss ? 1_ss : -1_ss);
+        }
 
-            auto frameSpeed = spinOp->currentSpeed * dt;
-            if (frameSpeed > 0_ss)
-            {
-                currentAngle += SimAngle(frameSpeed.value);
-            }
-            else
+        applyRotation(currentAngle, currentSpeed, dt);
+    }
+
+    /** Returns true if the spin has stopped. */
+    static bool applyStopSpin(SimAngle& currentAngle, SimScalar& currentSpeed, SimScalar deceleration, SimScalar dt)
+    {
+        auto frameDecel = deceleration / 2_ss;
+        if (abs(currentSpeed) <= frameDecel)
+        {
+            return true;
+        }
+
+        currentSpeed -= frameDecel * (currentSpeed > 0_ss ? 1_ss : -1_ss);
+        applyRotation(currentAngle, currentSpeed, dt);
+        return false;
+    }
+
+    static std::optional<std::size_t> findOperation(const UnitMesh::Operations& ops, unsigned int pieceIndex, Axis axis, bool turn)
+    {
+        for (std::size_t i = 0; i < ops.size(); ++i)
+        {
+            if (ops.pieces[i] == pieceIndex && ops.axes[i] == axis && (ops.kinds[i] != UnitMesh::OperationKind::Move) == turn)
             {
-                currentAngle -= SimAngle(-frameSpeed.value);
+                return i;
             }
-            return;
         }
 
-        if (auto stopSpinOp = std::get_if<UnitMesh::StopSpinOperation>(&*op); stopSpinOp != nullptr)
+        return std::nullopt;
+    }
+
+    std::size_t UnitMesh::Operations::size() const
+    {
+        return pieces.size();
+    }
+
+    bool UnitMesh::Operations::empty() const
+    {
+        return pieces.empty();
+    }
+
+    void UnitMesh::Operations::add(unsigned int piece, Axis axis, OperationKind kind, SimScalar target, SimAngle targetAngle, SimScalar speed, SimScalar acceleration)
+    {
+        pieces.push_back(piece);
+        axes.push_back(axis);
+        kinds.push_back(kind);
+        targets.push_back(target);
+        targetAngles.push_back(targetAngle);
+        speeds.push_back(speed);
+        accelerations.push_back(acceleration);
+    }
+
+    void UnitMesh::Operations::remove(std::size_t index)
+    {
+        auto last = size() - 1;
+        pieces[index] = pieces[last];
+        axes[index] = axes[last];
+        kinds[index] = kinds[last];
+        targets[index] = targets[last];
+        targetAngles[index] = targetAngles[last];
+        speeds[index] = speeds[last];
+        accelerations[index] = accelerations[last];
+
+        pieces.pop_back();
+        axes.pop_back();
+        kinds.pop_back();
+        targets.pop_back();
+        targetAngles.pop_back();
+        speeds.pop_back();
+        accelerations.pop_back();
+    }
+
+    std::optional<unsigned int> UnitMesh::findPieceIndex(const std::string& pieceName) const
+    {
+        for (unsigned int i = 0; i < pieces.size(); ++i)
         {
-            auto frameDecel = stopSpinOp->deceleration / 2_ss;
-            if (abs(stopSpinOp->currentSpeed) <= frameDecel)
+            if (boost::iequals(pieceName, pieces[i].name))
             {
-                op = std::nullopt;
-                return;
+                return i;
             }
+        }
 
-            stopSpinOp->currentSpeed -= frameDecel * (stopSpinOp->currentSpeed > 0_ss ? 1_ss : -1_ss);
-            auto frameSpeed = stopSpinOp->currentSpeed * dt;
-            if (frameSpeed > 0_ss)
+        return std::nullopt;
+    }
+
+    const Matrix4x<SimScalar>& UnitMesh::getPieceTransform(unsigned int pieceIndex) const
+    {
+        return getPieceTransforms()[pieceIndex];
+    }
+
+    const std::vector<Matrix4x<SimScalar>>& UnitMesh::getPieceTransforms() const
+    {
+        // pieces may have been added since the cache was built
+        if (pieceTransforms.size() != pieces.size())
+        {
+            pieceTransforms.resize(pieces.size());
+            dirtyPieceTransforms.assign(pieces.size(), true);
+            anyPieceTransformDirty = true;
+        }
+
+        if (!anyPieceTransformDirty)
+        {
+            return pieceTransforms;
+        }
+
+        // Parents come before their children,
+        // so a dirty parent has been rebuilt, and is still marked,
+        // by the time its children are reached.
+        for (std::size_t i = 0; i < pieces.size(); ++i)
+        {
+            const auto& piece = pieces[i];
+            if (piece.parent && dirtyPieceTransforms[*piece.parent])
             {
-                currentAngle += SimAngle(frameSpeed.value);
+                dirtyPieceTransforms[i] = true;
             }
-            else
+
+            if (!dirtyPieceTransforms[i])
             {
-                currentAngle -= SimAngle(-frameSpeed.value);
+                continue;
             }
-            return;
+
+            pieceTransforms[i] = piece.parent
+                ? pieceTransforms[*piece.parent] * piece.getTransform()
+                : piece.getTransform();
         }
+
+        dirtyPieceTransforms.assign(pieces.size(), false);
+        anyPieceTransformDirty = false;
+
+        return pieceTransforms;
     }
 
-    std::optional<std::reference_wrapper<const UnitMesh>> UnitMesh::find(const std::string& pieceName) const
+    void UnitMesh::setPieceOffset(unsigned int pieceIndex, Axis axis, SimScalar value)
     {
-        if (boost::iequals(pieceName, name))
+        getOffset(pieces[pieceIndex], axis) = value;
+        invalidatePieceTransform(pieceIndex);
+    }
+
+    void UnitMesh::setPieceRotation(unsigned int pieceIndex, Axis axis, SimAngle value)
+    {
+        getRotation(pieces[pieceIndex], axis) = value;
+        invalidatePieceTransform(pieceIndex);
+    }
+
+    void UnitMesh::invalidatePieceTransform(unsigned int pieceIndex)
+    {
+        // if the cache is the wrong size it will be rebuilt anyway
+        if (pieceIndex < dirtyPieceTransforms.size())
         {
-            return *this;
+            dirtyPieceTransforms[pieceIndex] = true;
         }
+        anyPieceTransformDirty = true;
+    }
 
-        for (auto& c : children)
+    void UnitMesh::invalidatePieceTransforms()
+    {
+        dirtyPieceTransforms.assign(dirtyPieceTransforms.size(), true);
+        anyPieceTransformDirty = true;
+    }
+
+    std::optional<UnitMesh::MoveOperation> UnitMesh::getMoveOperation(unsigned int pieceIndex, Axis axis) const
+    {
+        auto index = findOperation(operations, pieceIndex, axis, false);
+        if (!index)
         {
-            auto piece = c.find(pieceName);
-            if (piece)
-            {
-                return piece;
-            }
+            return std::nullopt;
         }
 
-        return std::nullopt;
+        return MoveOperation(operations.targets[*index], operations.speeds[*index]);
+    }
+
+    void UnitMesh::setMoveOperation(unsigned int pieceIndex, Axis axis, const std::optional<MoveOperation>& op)
+    {
+        if (auto index = findOperation(operations, pieceIndex, axis, false))
+        {
+            operations.remove(*index);
+        }
+
+        if (op)
+        {
+            operations.add(pieceIndex, axis, OperationKind::Move, op->targetPosition, SimAngle(0), op->speed, 0_ss);
+        }
     }
 
-    std::optional<std::reference_wrapper<UnitMesh>> UnitMesh::find(const std::string& pieceName)
+    std::optional<UnitMesh::TurnOperationUnion> UnitMesh::getTurnOperation(unsigned int pieceIndex, Axis axis) const
     {
-        auto value = static_cast<const UnitMesh&>(*this).find(pieceName);
-        if (!value)
+        auto index = findOperation(operations, pieceIndex, axis, true);
+        if (!index)
         {
             return std::nullopt;
         }
 
-        return std::ref(const_cast<UnitMesh&>(value->get()));
+        auto i = *index;
+        switch (operations.kinds[i])
+        {
+            case OperationKind::Turn:
+                return TurnOperation(operations.targetAngles[i], operations.speeds[i]);
+            case OperationKind::Spin:
+                return SpinOperation(operations.speeds[i], operations.targets[i], operations.accelerations[i]);
+            case OperationKind::StopSpin:
+                return StopSpinOperation(operations.speeds[i], operations.accelerations[i]);
+            default:
+                throw std::logic_error("Invalid turn operation kind");
+        }
     }
 
-    std::optional<Matrix4x<SimScalar>> UnitMesh::getPieceTransform(const std::string& pieceName) const
+    void UnitMesh::setTurnOperation(unsigned int pieceIndex, Axis axis, const std::optional<TurnOperationUnion>& op)
     {
-        if (boost::iequals(pieceName, name))
+        if (auto index = findOperation(operations, pieceIndex, axis, true))
+        {
+            operations.remove(*index);
+        }
+
+        if (!op)
         {
-            return getTransform();
+            return;
         }
 
-        for (auto& c : children)
+        match(
+            *op,
+            [&](const TurnOperation& o) {
+                operations.add(pieceIndex, axis, OperationKind::Turn, 0_ss, o.targetAngle, o.speed, 0_ss);
+            },
+            [&](const SpinOperation& o) {
+                operations.add(pieceIndex, axis, OperationKind::Spin, o.targetSpeed, SimAngle(0), o.currentSpeed, o.acceleration);
+            },
+            [&](const StopSpinOperation& o) {
+                operations.add(pieceIndex, axis, OperationKind::StopSpin, 0_ss, SimAngle(0), o.currentSpeed, o.deceleration);
+            });
+    }
+
+    bool UnitMesh::update(SimScalar dt)
+    {
+        auto anyFinished = false;
+
+        // Each operation drives a different piece axis,
+        // so the order they are applied in doesn't matter
+        // and finished ones can be swapped out from anywhere.
+        for (std::size_t i = 0; i < operations.size();)
         {
-            auto childTransform = c.getPieceTransform(pieceName);
-            if (childTransform)
+            auto pieceIndex = operations.pieces[i];
+            auto& piece = pieces[pieceIndex];
+            auto axis = operations.axes[i];
+            invalidatePieceTransform(pieceIndex);
+
+            auto finished = false;
+            switch (operations.kinds[i])
+            {
+                case OperationKind::Move:
+                    finished = applyMove(getOffset(piece, axis), operations.targets[i], operations.speeds[i], dt);
+                    break;
+                case OperationKind::Turn:
+                    finished = applyTurn(getRotation(piece, axis), operations.targetAngles[i], operations.speeds[i], dt);
+                    break;
+                case OperationKind::Spin:
+                    applySpin(getRotation(piece, axis), operations.speeds[i], operations.targets[i], operations.accelerations[i], dt);
+                    break;
+                case OperationKind::StopSpin:
+                    finished = applyStopSpin(getRotation(piece, axis), operations.speeds[i], operations.accelerations[i], dt);
+                    break;
+            }
+
+            if (finished)
+            {
+                operations.remove(i);
+                anyFinished = true;
+            }
+            else
             {
-                return getTransform() * (*childTransform);
+                ++i;
             }
         }
 
-        return std::nullopt;
+        return anyFinished;
     }
 
-    Matrix4x<SimScalar> UnitMesh::getTransform() const
+    Matrix4x<SimScalar> UnitMesh::Piece::getTransform() const
     {
         return Matrix4x<SimScalar>::translation(origin + offset)
             * Matrix4x<SimScalar>::rotationZXY(
@@ -154,22 +375,6 @@ namespace rwe
                 cos(rotationZ));
     }
 
-    void UnitMesh::update(SimScalar dt)
-    {
-        applyMoveOperation(xMoveOperation, offset.x, dt);
-        applyMoveOperation(yMoveOperation, offset.y, dt);
-        applyMoveOperation(zMoveOperation, offset.z, dt);
-
-        applyTurnOperation(xTurnOperation, rotationX, dt);
-        applyTurnOperation(yTurnOperation, rotationY, dt);
-        applyTurnOperation(zTurnOperation, rotationZ, dt);
-
-        for (auto& c : children)
-        {
-            c.update(dt);
-        }
-    }
-
     UnitMesh::MoveOperation::MoveOperation(SimScalar targetPosition, SimScalar speed)
         : targetPosition(targetPosition), speed(speed)
     {
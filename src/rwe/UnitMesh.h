@@ -7,6 +7,7 @@
 #include <rwe/SimAngle.h>
 #include <rwe/math/Matrix4f.h>
 #include <rwe/math/Vector3f.h>
+#include <rwe/util.h>
 #include <string>
 #include <variant>
 #include <vector>
@@ -60,33 +61,131 @@ namespace rwe
 
         using TurnOperationUnion = std::variant<TurnOperation, SpinOperation, StopSpinOperation>;
 
-        std::string name;
-        Vector3x<SimScalar> origin;
-        std::shared_ptr<ShaderMesh> mesh;
-        std::vector<UnitMesh> children;
-        bool visible{true};
-        bool shaded{true};
-        Vector3x<SimScalar> offset{0_ss, 0_ss, 0_ss};
-        SimAngle rotationX{0};
-        SimAngle rotationY{0};
-        SimAngle rotationZ{0};
+        enum class OperationKind : std::uint8_t
+        {
+            Move,
+            Turn,
+            Spin,
+            StopSpin,
+        };
+
+        /**
+         * The move and turn operations in progress on the mesh's pieces,
+         * one entry per operation in structure-of-arrays form,
+         * so that update only visits pieces that are actually moving.
+         * A piece has at most one move and one turn operation on each axis.
+         * Entries are in no particular order.
+         */
+        struct Operations
+        {
+            std::vector<unsigned int> pieces;
+            std::vector<Axis> axes;
+            std::vector<OperationKind> kinds;
+
+            /** The position a move is heading for, or the speed a spin is accelerating to. */
+            std::vector<SimScalar> targets;
+
+            /** The angle a turn is heading for. Unused by other kinds. */
+            std::vector<SimAngle> targetAngles;
+
+            /** The speed of a move or turn, or the current speed of a spin. */
+            std::vector<SimScalar> speeds;
+
+            /** The acceleration of a spin, or the deceleration of a stopping spin. */
+            std::vector<SimScalar> accelerations;
+
+            std::size_t size() const;
+
+            bool empty() const;
+
+            void add(unsigned int piece, Axis axis, OperationKind kind, SimScalar target, SimAngle targetAngle, SimScalar speed, SimScalar acceleration);
+
+            /** Removes the entry by moving the last entry into its place. */
+            void remove(std::size_t index);
+        };
+
+        struct Piece
+        {
+            std::string name;
+
+            /**
+             * Index of this piece's parent in the mesh's piece list,
+             * or nullopt for the root piece.
+             */
+            std::optional<unsigned int> parent;
+
+            Vector3x<SimScalar> origin;
+            std::shared_ptr<ShaderMesh> mesh;
+            bool visible{true};
+            bool shaded{true};
+            Vector3x<SimScalar> offset{0_ss, 0_ss, 0_ss};
+            SimAngle rotationX{0};
+            SimAngle rotationY{0};
+            SimAngle rotationZ{0};
+
+            /** Returns the transform from this piece's space to its parent's. */
+            Matrix4x<SimScalar> getTransform() const;
+        };
+
+        /**
+         * The pieces of the mesh in depth-first order,
+         * starting with the root.
+         * A piece's parent always comes before it.
+         */
+        std::vector<Piece> pieces;
+
+        Operations operations;
+
+        /**
+         * Each piece's transform to the unit's space, shared by the simulation and the renderer.
+         * Rebuilt lazily for the pieces marked dirty, and their descendants,
+         * the next time a transform is asked for.
+         */
+        mutable std::vector<Matrix4x<SimScalar>> pieceTransforms;
+        mutable std::vector<bool> dirtyPieceTransforms;
+        mutable bool anyPieceTransformDirty{true};
+
+        /**
+         * Returns the index of the piece with the given name,
+         * compared case-insensitively.
+         * This is a linear search, so callers that look up the same piece
+         * repeatedly should resolve the index once and keep it.
+         */
+        std::optional<unsigned int> findPieceIndex(const std::string& pieceName) const;
+
+        /** Returns the transform from the given piece's space to the unit's. */
+        const Matrix4x<SimScalar>& getPieceTransform(unsigned int pieceIndex) const;
+
+        /** Returns the transforms of all the pieces to the unit's space, indexed like pieces. */
+        const std::vector<Matrix4x<SimScalar>>& getPieceTransforms() const;
+
+        void setPieceOffset(unsigned int pieceIndex, Axis axis, SimScalar value);
+
+        void setPieceRotation(unsigned int pieceIndex, Axis axis, SimAngle value);
 
-        std::optional<MoveOperation> xMoveOperation;
-        std::optional<MoveOperation> yMoveOperation;
-        std::optional<MoveOperation> zMoveOperation;
+        /**
+         * Must be called after changing a piece's offset or rotation directly,
+         * rather than through the setters or update.
+         */
+        void invalidatePieceTransform(unsigned int pieceIndex);
 
-        std::optional<TurnOperationUnion> xTurnOperation;
-        std::optional<TurnOperationUnion> yTurnOperation;
-        std::optional<TurnOperationUnion> zTurnOperation;
+        void invalidatePieceTransforms();
 
-        std::optional<std::reference_wrapper<const UnitMesh>> find(const std::string& pieceName) const;
+        std::optional<MoveOperation> getMoveOperation(unsigned int pieceIndex, Axis axis) const;
 
-        std::optional<std::reference_wrapper<UnitMesh>> find(const std::string& pieceName);
+        /** Replaces the piece's move operation on the axis, or cancels it if op is empty. */
+        void setMoveOperation(unsigned int pieceIndex, Axis axis, const std::optional<MoveOperation>& op);
 
-        std::optional<Matrix4x<SimScalar>> getPieceTransform(const std::string& pieceName) const;
+        std::optional<TurnOperationUnion> getTurnOperation(unsigned int pieceIndex, Axis axis) const;
 
-        Matrix4x<SimScalar> getTransform() const;
+        /** Replaces the piece's turn or spin operation on the axis, or cancels it if op is empty. */
+        void setTurnOperation(unsigned int pieceIndex, Axis axis, const std::optional<TurnOperationUnion>& op);
 
-        void update(SimScalar dt);
+        /**
+         * Advances the pieces' move and turn operations.
+         * Returns true if any of them finished,
+         * which is how cob threads waiting on them learn to check again.
+         */
+        bool update(SimScalar dt);
     };
 }
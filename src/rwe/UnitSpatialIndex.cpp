@@ -0,0 +1,102 @@
+#include "UnitSpatialIndex.h"
+#include <algorithm>
+
+namespace rwe
+{
+    UnitSpatialIndex::UnitSpatialIndex(std::size_t widthInCells, std::size_t heightInCells)
+        : widthInCells(widthInCells),
+          heightInCells(heightInCells),
+          buckets((widthInCells + BucketSize - 1) / BucketSize, (heightInCells + BucketSize - 1) / BucketSize)
+    {
+    }
+
+    void UnitSpatialIndex::insert(UnitId unitId, const DiscreteRect& footprint)
+    {
+        auto region = toBucketRegion(footprint);
+        if (!region)
+        {
+            return;
+        }
+
+        buckets.forEach(*region, [unitId](auto& bucket) { bucket.push_back(unitId); });
+    }
+
+    void UnitSpatialIndex::remove(UnitId unitId, const DiscreteRect& footprint)
+    {
+        auto region = toBucketRegion(footprint);
+        if (!region)
+        {
+            return;
+        }
+
+        buckets.forEach(*region, [unitId](auto& bucket) {
+            auto it = std::find(bucket.begin(), bucket.end(), unitId);
+            if (it != bucket.end())
+            {
+                // order within a bucket is irrelevant,
+                // queries sort their results.
+                *it = bucket.back();
+                bucket.pop_back();
+            }
+        });
+    }
+
+    void UnitSpatialIndex::move(UnitId unitId, const DiscreteRect& oldFootprint, const DiscreteRect& newFootprint)
+    {
+        auto oldRegion = toBucketRegion(oldFootprint);
+        auto newRegion = toBucketRegion(newFootprint);
+
+        // Most moves stay within the same set of buckets,
+        // in which case there is nothing to do.
+        if (oldRegion && newRegion
+            && oldRegion->x == newRegion->x
+            && oldRegion->y == newRegion->y
+            && oldRegion->width == newRegion->width
+            && oldRegion->height == newRegion->height)
+        {
+            return;
+        }
+
+        remove(unitId, oldFootprint);
+        insert(unitId, newFootprint);
+    }
+
+    std::vector<UnitId> UnitSpatialIndex::query(const DiscreteRect& rect) const
+    {
+        std::vector<UnitId> result;
+
+        auto region = toBucketRegion(rect);
+        if (!region)
+        {
+            return result;
+        }
+
+        region->forEach([&](const auto& coords) {
+            const auto& bucket = buckets.get(coords);
+            result.insert(result.end(), bucket.begin(), bucket.end());
+        });
+
+        // Sorting makes the result independent of bucket layout and insertion history,
+        // which the simulation needs to stay deterministic.
+        std::sort(result.begin(), result.end(), [](const auto& a, const auto& b) { return a.value < b.value; });
+        result.erase(std::unique(result.begin(), result.end()), result.end());
+
+        return result;
+    }
+
+    std::optional<GridRegion> UnitSpatialIndex::toBucketRegion(const DiscreteRect& rect) const
+    {
+        auto clipped = rect.intersection(DiscreteRect(0, 0, widthInCells, heightInCells));
+        if (!clipped)
+        {
+            return std::nullopt;
+        }
+
+        auto minX = static_cast<std::size_t>(clipped->x) / BucketSize;
+        auto minY = static_cast<std::size_t>(clipped->y) / BucketSize;
+        auto maxX = (static_cast<std::size_t>(clipped->x) + clipped->width - 1) / BucketSize;
+        auto maxY = (static_cast<std::size_t>(clipped->y) + clipped->height - 1) / BucketSize;
+
+        return GridRegion::fromCoordinates(GridCoordinates(minX, minY), GridCoordinates(maxX, maxY));
+    }
+}
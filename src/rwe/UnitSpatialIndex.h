@@ -0,0 +1,53 @@
+#pragma once
+
+#include <optional>
+#include <rwe/DiscreteRect.h>
+#include <rwe/Grid.h>
+#include <rwe/UnitId.h>
+#include <vector>
+
+namespace rwe
+{
+    /**
+     * A uniform grid of buckets over the map's heightmap cells,
+     * used to quickly find the units near some location
+     * without scanning every unit in the simulation.
+     *
+     * Each unit is recorded in every bucket that its footprint overlaps.
+     * The index must be kept in step with unit footprints
+     * as units are added, moved and removed.
+     */
+    class UnitSpatialIndex
+    {
+    public:
+        /** The width and height of each bucket, in heightmap cells. */
+        static constexpr unsigned int BucketSize = 8;
+
+    private:
+        std::size_t widthInCells;
+        std::size_t heightInCells;
+
+        Grid<std::vector<UnitId>> buckets;
+
+    public:
+        UnitSpatialIndex(std::size_t widthInCells, std::size_t heightInCells);
+
+        void insert(UnitId unitId, const DiscreteRect& footprint);
+
+        void remove(UnitId unitId, const DiscreteRect& footprint);
+
+        void move(UnitId unitId, const DiscreteRect& oldFootprint, const DiscreteRect& newFootprint);
+
+        /**
+         * Returns the IDs of all units that might overlap the given rectangle
+         * of heightmap cells, in ascending ID order with no duplicates.
+         * This is a broad-phase query. Units in the same bucket as the
+         * rectangle are returned even if they don't actually overlap it,
+         * so callers must do their own precise checks.
+         */
+        std::vector<UnitId> query(const DiscreteRect& rect) const;
+
+    private:
+        std::optional<GridRegion> toBucketRegion(const DiscreteRect& rect) const;
+    };
+}
@@ -0,0 +1,14 @@
+#pragma once
+
+#include <rwe/OpaqueId.h>
+
+namespace rwe
+{
+    struct UnitTypeIdTag;
+
+    /**
+     * Dense index of a unit type, assigned as unit definitions are loaded.
+     * Lets per-unit-type tables be plain arrays instead of maps keyed by name.
+     */
+    using UnitTypeId = OpaqueId<unsigned int, UnitTypeIdTag>;
+}
@@ -1,13 +1,14 @@
 #pragma once
 
-#include <rwe/AudioService.h>
+#include <memory>
 #include <rwe/GameTime.h>
 #include <rwe/ProjectilePhysicsType.h>
-#include <rwe/ProjectileRenderType.h>
-#include <rwe/SpriteSeries.h>
+#include <rwe/SoundHandle.h>
 #include <rwe/UnitId.h>
+#include <rwe/WeaponDefinition.h>
 #include <rwe/cob/CobThread.h>
 #include <rwe/math/Vector3f.h>
+#include <string>
 #include <variant>
 
 namespace rwe
@@ -22,7 +23,7 @@ namespace rwe
     {
         struct AimInfo
         {
-            const CobThread* thread;
+            CobThreadHandle thread;
             SimAngle lastHeading;
             SimAngle lastPitch;
         };
@@ -41,6 +42,9 @@ namespace rwe
 
     struct UnitWeapon
     {
+        /** The weapon type's shared definition, which projectiles fired by this weapon also refer to. */
+        std::shared_ptr<const WeaponDefinition> definition;
+
         ProjectilePhysicsType physicsType;
 
         SimScalar maxRange;
@@ -48,16 +52,8 @@ namespace rwe
         SimScalar reloadTime;
 
         bool startSmoke;
-        bool endSmoke;
-
-        std::optional<GameTime> smokeTrail;
-
-        std::optional<AudioService::SoundHandle> soundStart;
-        std::optional<AudioService::SoundHandle> soundHit;
-        std::optional<AudioService::SoundHandle> soundWater;
 
-        std::optional<std::shared_ptr<SpriteSeries>> explosion;
-        std::optional<std::shared_ptr<SpriteSeries>> waterExplosion;
+        std::optional<SoundHandle> soundStart;
 
         /** The number of shots in a burst. */
         int burst;
@@ -78,18 +74,12 @@ namespace rwe
 
         SimAngle pitchTolerance;
 
-        ProjectileRenderType renderType;
-
         /** Projectile velocity in pixels/tick. */
         SimScalar velocity;
 
         /** If true, the weapon only fires on command and does not auto-target. */
         bool commandFire;
 
-        std::unordered_map<std::string, unsigned int> damage;
-
-        SimScalar damageRadius;
-
         /** Number of ticks projectiles fired from this weapon live for */
         std::optional<GameTime> weaponTimer;
 
@@ -6,8 +6,10 @@
 #include <optional>
 #include <rwe/OpaqueId.h>
 #include <rwe/overloaded.h>
+#include <stdexcept>
 #include <utility>
 #include <variant>
+#include <vector>
 
 namespace rwe
 {
@@ -227,6 +229,74 @@ namespace rwe
                 [&](OccupiedEntry& e) { return e.first == id ? iterator(it, vec.end()) : end(); });
         }
 
+        /**
+         * Returns, for each slot, the id of its occupant,
+         * or of its last occupant if the slot is free.
+         */
+        std::vector<Id> getSlotIds() const
+        {
+            std::vector<Id> ids;
+            ids.reserve(vec.size());
+            for (const auto& entry : vec)
+            {
+                ids.push_back(match(
+                    entry,
+                    [](const FreeEntry& e) { return e.id; },
+                    [](const OccupiedEntry& e) { return e.first; }));
+            }
+            return ids;
+        }
+
+        /** Returns the indices of free slots in the order they will be reused. */
+        std::vector<unsigned int> getFreeSlots() const
+        {
+            std::vector<unsigned int> indices;
+            for (auto index = firstFreeSlotIndex; index; index = std::get<FreeEntry>(vec[index->value]).nextIndex)
+            {
+                indices.push_back(index->value);
+            }
+            return indices;
+        }
+
+        /**
+         * Discards the contents of the map and recreates the given slot layout,
+         * as returned by getSlotIds and getFreeSlots.
+         * Slots that are not in the free list are left empty
+         * and must be filled with emplaceAt.
+         */
+        void resetLayout(const std::vector<Id>& slotIds, const std::vector<unsigned int>& freeSlots)
+        {
+            vec.clear();
+            for (const auto& id : slotIds)
+            {
+                vec.emplace_back(FreeEntry(id, std::nullopt));
+            }
+
+            firstFreeSlotIndex = std::nullopt;
+            for (auto it = freeSlots.rbegin(); it != freeSlots.rend(); ++it)
+            {
+                if (*it >= vec.size())
+                {
+                    throw std::runtime_error("Free slot index out of range");
+                }
+                std::get<FreeEntry>(vec[*it]).nextIndex = firstFreeSlotIndex;
+                firstFreeSlotIndex = Index(*it);
+            }
+        }
+
+        /** Fills a slot left empty by resetLayout with the given id. */
+        template <typename... Args>
+        void emplaceAt(Id id, Args&&... args)
+        {
+            auto index = extractIndex(id);
+            if (index.value >= vec.size() || !std::holds_alternative<FreeEntry>(vec[index.value]))
+            {
+                throw std::runtime_error("Slot for given ID is not available");
+            }
+
+            vec[index.value] = std::make_pair(id, T(std::forward<Args>(args)...));
+        }
+
     private:
         static Index extractIndex(Id id)
         {
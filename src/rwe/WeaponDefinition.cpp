@@ -0,0 +1,15 @@
+#include "WeaponDefinition.h"
+#include <stdexcept>
+
+namespace rwe
+{
+    unsigned int WeaponDefinition::getDamage(UnitTypeId unitType) const
+    {
+        if (unitType.value >= damage.size() || damage[unitType.value] == NoDamage)
+        {
+            throw std::runtime_error("Failed to find damage entry for weapon " + weaponType);
+        }
+
+        return damage[unitType.value];
+    }
+}
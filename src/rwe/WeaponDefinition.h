@@ -0,0 +1,60 @@
+#pragma once
+
+#include <limits>
+#include <memory>
+#include <optional>
+#include <rwe/GameTime.h>
+#include <rwe/ProjectileRenderType.h>
+#include <rwe/SimScalar.h>
+#include <rwe/SoundHandle.h>
+#include <rwe/SpriteSeries.h>
+#include <rwe/UnitTypeId.h>
+#include <string>
+#include <vector>
+
+namespace rwe
+{
+    /**
+     * The parts of a weapon type that projectiles need,
+     * which are the same for every shot.
+     * Created once per weapon type and shared by every weapon
+     * and projectile of that type, so must not be modified.
+     */
+    struct WeaponDefinition
+    {
+        /** Marks unit types that the weapon has no damage entry for. */
+        static constexpr unsigned int NoDamage = std::numeric_limits<unsigned int>::max();
+
+        /** The name of the weapon definition. */
+        std::string weaponType;
+
+        ProjectileRenderType renderType;
+
+        /** If true, projectiles create smoke on impact. */
+        bool endSmoke;
+
+        /**
+         * If set, smoke is emitted from projectiles.
+         * The set value indicates the delay in ticks between each emission.
+         * A value of 0 indicates that smoke is emitted every tick,
+         * a value of 1 is every other tick, etc.
+         */
+        std::optional<GameTime> smokeTrail;
+
+        std::optional<SoundHandle> soundHit;
+        std::optional<SoundHandle> soundWater;
+
+        std::optional<std::shared_ptr<SpriteSeries>> explosion;
+        std::optional<std::shared_ptr<SpriteSeries>> waterExplosion;
+
+        /**
+         * Damage dealt to each unit type, indexed by unit type id.
+         * Unit types without an entry of their own take the default damage.
+         */
+        std::vector<unsigned int> damage;
+
+        SimScalar damageRadius;
+
+        unsigned int getDamage(UnitTypeId unitType) const;
+    };
+}
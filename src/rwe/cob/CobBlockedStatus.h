@@ -0,0 +1,48 @@
+#pragma once
+
+#include <rwe/GameTime.h>
+#include <rwe/util.h>
+#include <variant>
+
+namespace rwe
+{
+    /** Emitted when a cob thread has to wait for something before it can continue. */
+    struct CobBlockedStatus
+    {
+        struct Move
+        {
+            unsigned int object;
+            Axis axis;
+
+            Move(unsigned int object, Axis axis) : object(object), axis(axis)
+            {
+            }
+        };
+
+        struct Turn
+        {
+            unsigned int object;
+            Axis axis;
+
+            Turn(unsigned int object, Axis axis) : object(object), axis(axis)
+            {
+            }
+        };
+
+        struct Sleep
+        {
+            GameTime wakeUpTime;
+
+            explicit Sleep(GameTime wakeUpTime) : wakeUpTime(wakeUpTime)
+            {
+            }
+        };
+
+        using Condition = std::variant<Move, Turn, Sleep>;
+
+        Condition condition;
+
+    public:
+        explicit CobBlockedStatus(const Condition& condition) : condition(condition) {}
+    };
+}
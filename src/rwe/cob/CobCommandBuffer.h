@@ -0,0 +1,65 @@
+#pragma once
+
+#include <rwe/GameTime.h>
+#include <rwe/UnitId.h>
+#include <utility>
+#include <variant>
+#include <vector>
+
+namespace rwe
+{
+    /**
+     * Something a cob script did that reaches outside its own unit.
+     * Scripts record these instead of applying them directly,
+     * so that units can be run in parallel
+     * and the effects applied afterwards in unit order.
+     * Flags on the unit itself are set as soon as the script sets them,
+     * so that the script reads back what it wrote;
+     * the command carries the rest, e.g. changes to the occupied grid.
+     */
+    struct CobUnitCommand
+    {
+        struct SetActivation
+        {
+            bool value;
+        };
+
+        struct SetBuildStance
+        {
+            bool value;
+        };
+
+        struct SetYardOpen
+        {
+            bool value;
+        };
+
+        struct BuggerOff
+        {
+        };
+
+        using Command = std::variant<SetActivation, SetBuildStance, SetYardOpen, BuggerOff>;
+
+        UnitId unit;
+        Command command;
+
+        CobUnitCommand(const UnitId& unit, const Command& command) : unit(unit), command(command)
+        {
+        }
+    };
+
+    /** Collects the effects of running cob scripts until they can be applied. */
+    struct CobCommandBuffer
+    {
+        std::vector<CobUnitCommand> unitCommands;
+
+        /** Threads that went to sleep, to be added to the simulation's sleep timers. */
+        std::vector<std::pair<UnitId, GameTime>> sleepTimers;
+
+        void clear()
+        {
+            unitCommands.clear();
+            sleepTimers.clear();
+        }
+    };
+}
@@ -0,0 +1,37 @@
+#include "CobEntryPoint.h"
+#include <array>
+
+namespace rwe
+{
+    static const std::array<const char*, CobEntryPointCount> entryPointNames{
+        "Create",
+        "StartMoving",
+        "StopMoving",
+        "SetSpeed",
+        "Activate",
+        "Deactivate",
+        "StartBuilding",
+        "StopBuilding",
+        "QueryNanoPiece",
+        "QueryBuildInfo",
+        "SweetSpot",
+        "TargetCleared",
+        "AimPrimary",
+        "AimSecondary",
+        "AimTertiary",
+        "AimFromPrimary",
+        "AimFromSecondary",
+        "AimFromTertiary",
+        "FirePrimary",
+        "FireSecondary",
+        "FireTertiary",
+        "QueryPrimary",
+        "QuerySecondary",
+        "QueryTertiary",
+    };
+
+    const char* getCobEntryPointName(CobEntryPoint entryPoint)
+    {
+        return entryPointNames[static_cast<unsigned int>(entryPoint)];
+    }
+}
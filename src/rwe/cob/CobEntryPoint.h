@@ -0,0 +1,49 @@
+#pragma once
+
+namespace rwe
+{
+    /**
+     * The cob functions that the engine itself calls.
+     * Each script resolves these to its own function indices when it is parsed,
+     * so the engine can start them without looking anything up by name.
+     *
+     * The weapon functions are listed in weapon order,
+     * primary, secondary, then tertiary.
+     */
+    enum class CobEntryPoint
+    {
+        Create,
+        StartMoving,
+        StopMoving,
+        SetSpeed,
+        Activate,
+        Deactivate,
+        StartBuilding,
+        StopBuilding,
+        QueryNanoPiece,
+        QueryBuildInfo,
+        SweetSpot,
+        TargetCleared,
+
+        AimPrimary,
+        AimSecondary,
+        AimTertiary,
+
+        AimFromPrimary,
+        AimFromSecondary,
+        AimFromTertiary,
+
+        FirePrimary,
+        FireSecondary,
+        FireTertiary,
+
+        QueryPrimary,
+        QuerySecondary,
+        QueryTertiary,
+    };
+
+    static constexpr unsigned int CobEntryPointCount = static_cast<unsigned int>(CobEntryPoint::QueryTertiary) + 1;
+
+    /** Returns the name of the cob function for the entry point. */
+    const char* getCobEntryPointName(CobEntryPoint entryPoint);
+}
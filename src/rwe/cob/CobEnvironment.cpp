@@ -38,18 +38,57 @@ namespace rwe
     CobThread CobEnvironment::createNonScheduledThread(unsigned int functionId, const std::vector<int>& params)
     {
         const auto& functionInfo = _script->functions.at(functionId);
-        CobThread thread(functionInfo.name);
-        thread.callStack.emplace(functionInfo.address, params);
+        CobThread thread(functionId);
+        thread.pushFrame(functionInfo.address, params);
         return thread;
     }
 
+    std::optional<CobThread> CobEnvironment::createNonScheduledThread(CobEntryPoint entryPoint, std::initializer_list<int> params)
+    {
+        const auto& functionId = _script->entryPoints[static_cast<unsigned int>(entryPoint)];
+        if (!functionId)
+        {
+            return std::nullopt;
+        }
+
+        CobThread thread(*functionId);
+        thread.pushFrame(_script->functions[*functionId].address, params);
+        return thread;
+    }
+
+    CobThread& CobEnvironment::acquireThread(unsigned int functionId, unsigned int signalMask)
+    {
+        if (functionId >= _script->functions.size())
+        {
+            throw std::out_of_range("Invalid cob function id: " + std::to_string(functionId));
+        }
+
+        CobThread* thread;
+        if (!freeThreads.empty())
+        {
+            thread = freeThreads.front();
+            freeThreads.pop_front();
+            thread->reset(functionId, signalMask);
+        }
+        else
+        {
+            thread = &threadPool.emplace_back(functionId, signalMask);
+        }
+
+        getSignalGroup(signalMask).threads.push_back(thread);
+        return *thread;
+    }
+
     const CobThread* CobEnvironment::createThread(unsigned int functionId, const std::vector<int>& params, unsigned int signalMask)
     {
-        const auto& functionInfo = _script->functions.at(functionId);
-        auto& thread = threads.emplace_back(std::make_unique<CobThread>(functionInfo.name, signalMask));
-        thread->callStack.emplace(functionInfo.address, params);
-        readyQueue.push_back(thread.get());
-        return thread.get();
+        auto& thread = acquireThread(functionId, signalMask);
+        thread.pushFrame(_script->functions[functionId].address, params);
+        readyQueue.push_back(&thread);
+        if (!profile.empty())
+        {
+            profile[functionId].threadsCreated += 1;
+        }
+        return &thread;
     }
 
     const CobThread* CobEnvironment::createThread(unsigned int functionId, const std::vector<int>& params)
@@ -75,84 +114,113 @@ namespace rwe
         return createThread(functionName, std::vector<int>());
     }
 
-    void CobEnvironment::deleteThread(const CobThread* thread)
+    std::optional<const CobThread*> CobEnvironment::createThread(CobEntryPoint entryPoint, std::initializer_list<int> params)
     {
-        auto it = std::find_if(threads.begin(), threads.end(), [thread](const auto& t) { return t.get() == thread; });
-        if (it != threads.end())
+        const auto& functionId = _script->entryPoints[static_cast<unsigned int>(entryPoint)];
+        if (!functionId)
+        {
+            // silently ignore, as when starting by name
+            return std::nullopt;
+        }
+
+        auto& thread = acquireThread(*functionId, 0);
+        thread.pushFrame(_script->functions[*functionId].address, params);
+        readyQueue.push_back(&thread);
+        if (!profile.empty())
         {
-            threads.erase(it);
+            profile[*functionId].threadsCreated += 1;
         }
+        return &thread;
     }
 
-    void CobEnvironment::sendSignal(unsigned int signal)
+    std::optional<const CobThread*> CobEnvironment::createThread(CobEntryPoint entryPoint)
     {
-        for (auto it = threads.begin(); it != threads.end();)
-        {
-            if ((*it)->signalMask & signal)
-            {
-                // remove references to the thread
-                removeThreadFromQueues(it->get());
+        return createThread(entryPoint, {});
+    }
 
-                // delete the thread
-                it = threads.erase(it);
-            }
-            else
+    void CobEnvironment::deleteThread(CobThread* thread)
+    {
+        for (auto queue : {&readyQueue, &blockedQueue, &finishedQueue})
+        {
+            if (queue->contains(thread))
             {
-                ++it;
+                queue->remove(thread);
+                break;
             }
         }
+
+        getSignalGroup(thread->signalMask).threads.remove(thread);
+        thread->generation += 1;
+        freeThreads.push_front(thread);
     }
 
-    std::optional<int> CobEnvironment::tryReapThread(const CobThread* thread)
+    void CobEnvironment::deleteAllThreads()
     {
-        auto it = std::find(finishedQueue.begin(), finishedQueue.end(), thread);
-        if (it == finishedQueue.end())
+        for (auto queue : {&readyQueue, &blockedQueue, &finishedQueue})
         {
-            return std::nullopt;
+            while (!queue->empty())
+            {
+                deleteThread(queue->front());
+            }
         }
-
-        auto val = (*it)->returnValue;
-        return val;
     }
 
-    void CobEnvironment::removeThreadFromQueues(const CobThread* thread)
+    void CobEnvironment::sendSignal(unsigned int signal)
     {
+        for (auto& group : signalGroups)
         {
-            auto it = std::find(readyQueue.begin(), readyQueue.end(), thread);
-            if (it != readyQueue.end())
+            if (group.signalMask & signal)
             {
-                readyQueue.erase(it);
+                while (!group.threads.empty())
+                {
+                    deleteThread(group.threads.front());
+                }
             }
         }
+    }
 
+    void CobEnvironment::setSignalMask(CobThread* thread, unsigned int signalMask)
+    {
+        if (thread->signalGroupLink.list != nullptr)
         {
-            auto it = std::find_if(blockedQueue.begin(), blockedQueue.end(), [thread](const auto& pair) { return pair.second == thread; });
-            if (it != blockedQueue.end())
-            {
-                blockedQueue.erase(it);
-            }
+            getSignalGroup(thread->signalMask).threads.remove(thread);
+            getSignalGroup(signalMask).threads.push_back(thread);
         }
 
+        thread->signalMask = signalMask;
+    }
+
+    std::optional<int> CobEnvironment::tryReapThread(const CobThreadHandle& handle)
+    {
+        if (!handle.isCurrent() || !finishedQueue.contains(handle.thread))
         {
-            auto it = std::find(finishedQueue.begin(), finishedQueue.end(), thread);
-            if (it != finishedQueue.end())
-            {
-                finishedQueue.erase(it);
-            }
+            return std::nullopt;
         }
+
+        return handle.thread->returnValue;
     }
 
     bool CobEnvironment::isNotCorrupt() const
     {
-        auto sizes = readyQueue.size() + blockedQueue.size() + finishedQueue.size();
-        if (sizes != threads.size())
+        auto sizes = readyQueue.size() + blockedQueue.size() + finishedQueue.size() + freeThreads.size();
+        if (sizes != threadPool.size())
+        {
+            return false;
+        }
+
+        unsigned int groupedThreads = 0;
+        for (const auto& group : signalGroups)
+        {
+            groupedThreads += group.threads.size();
+        }
+        if (groupedThreads != threadPool.size() - freeThreads.size())
         {
             return false;
         }
 
-        for (const auto& ptr : threads)
+        for (const auto& thread : blockedQueue)
         {
-            if (!isPresentInAQueue(ptr.get()))
+            if (!thread->blockedCondition)
             {
                 return false;
             }
@@ -161,32 +229,28 @@ namespace rwe
         return true;
     }
 
-    bool CobEnvironment::isPresentInAQueue(const CobThread* thread) const
+    void CobEnvironment::setProfilingEnabled(bool enabled)
     {
+        if (enabled)
         {
-            auto it = std::find(readyQueue.begin(), readyQueue.end(), thread);
-            if (it != readyQueue.end())
-            {
-                return true;
-            }
+            profile.resize(_script->functions.size());
         }
-
+        else
         {
-            auto it = std::find_if(blockedQueue.begin(), blockedQueue.end(), [thread](const auto& pair) { return pair.second == thread; });
-            if (it != blockedQueue.end())
-            {
-                return true;
-            }
+            profile.clear();
         }
+    }
 
+    CobEnvironment::SignalGroup& CobEnvironment::getSignalGroup(unsigned int signalMask)
+    {
+        for (auto& group : signalGroups)
         {
-            auto it = std::find(finishedQueue.begin(), finishedQueue.end(), thread);
-            if (it != finishedQueue.end())
+            if (group.signalMask == signalMask)
             {
-                return true;
+                return group;
             }
         }
 
-        return false;
+        return signalGroups.emplace_back(signalMask);
     }
 }
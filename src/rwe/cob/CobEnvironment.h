@@ -1,10 +1,16 @@
 #pragma once
 
+#include <deque>
 #include <memory>
+#include <optional>
 #include <rwe/Cob.h>
 #include <rwe/GameTime.h>
 #include <rwe/UnitId.h>
+#include <rwe/cob/CobBlockedStatus.h>
+#include <rwe/cob/CobEntryPoint.h>
+#include <rwe/cob/CobFunctionProfile.h>
 #include <rwe/cob/CobThread.h>
+#include <rwe/cob/CobThreadList.h>
 #include <variant>
 #include <vector>
 
@@ -16,44 +22,8 @@ namespace rwe
     class CobEnvironment
     {
     public:
-        struct BlockedStatus
-        {
-            struct Move
-            {
-                unsigned int object;
-                Axis axis;
-
-                Move(unsigned int object, Axis axis) : object(object), axis(axis)
-                {
-                }
-            };
-
-            struct Turn
-            {
-                unsigned int object;
-                Axis axis;
-
-                Turn(unsigned int object, Axis axis) : object(object), axis(axis)
-                {
-                }
-            };
-
-            struct Sleep
-            {
-                GameTime wakeUpTime;
-
-                explicit Sleep(GameTime wakeUpTime) : wakeUpTime(wakeUpTime)
-                {
-                }
-            };
+        using BlockedStatus = CobBlockedStatus;
 
-            using Condition = std::variant<Move, Turn, Sleep>;
-
-            Condition condition;
-
-        public:
-            explicit BlockedStatus(const Condition& condition) : condition(condition) {}
-        };
         struct FinishedStatus
         {
         };
@@ -75,11 +45,54 @@ namespace rwe
 
         std::vector<int> _statics;
 
-        std::vector<std::unique_ptr<CobThread>> threads;
+        /**
+         * Every live thread is in exactly one of these queues,
+         * except while it is being executed.
+         * Blocked threads keep what they are waiting for in blockedCondition.
+         */
+        CobThreadQueue readyQueue;
+        CobThreadQueue blockedQueue;
+        CobThreadQueue finishedQueue;
+
+        /**
+         * Set when a blocked thread may be able to continue,
+         * because a sleep has come due or a piece operation has finished.
+         * Blocked threads are only rechecked when this is set.
+         */
+        bool blockedQueueDirty{false};
+
+        /**
+         * Counters for each of the script's functions, indexed by function id.
+         * Empty unless profiling is enabled, so that updating them is skipped.
+         */
+        std::vector<CobFunctionProfile> profile;
+
+    private:
+        struct SignalGroup
+        {
+            unsigned int signalMask;
+            CobThreadList<&CobThread::signalGroupLink> threads;
+
+            explicit SignalGroup(unsigned int signalMask) : signalMask(signalMask) {}
+        };
+
+        /**
+         * Storage for the environment's threads.
+         * Threads are never destroyed, only returned to freeThreads,
+         * so starting a thread usually doesn't allocate
+         * and threads never move.
+         */
+        std::deque<CobThread> threadPool;
 
-        std::deque<CobThread*> readyQueue;
-        std::deque<std::pair<BlockedStatus, CobThread*>> blockedQueue;
-        std::deque<CobThread*> finishedQueue;
+        CobThreadQueue freeThreads;
+
+        /**
+         * Live threads grouped by signal mask,
+         * so a signal only has to look at the masks it matches.
+         * There are rarely more than a handful of distinct masks,
+         * so groups are kept once created.
+         */
+        std::deque<SignalGroup> signalGroups;
 
     public:
         explicit CobEnvironment(const CobScript* _script);
@@ -100,6 +113,8 @@ namespace rwe
 
         CobThread createNonScheduledThread(unsigned int functionId, const std::vector<int>& params);
 
+        std::optional<CobThread> createNonScheduledThread(CobEntryPoint entryPoint, std::initializer_list<int> params);
+
         const CobThread* createThread(unsigned int functionId, const std::vector<int>& params, unsigned int signalMask);
 
         const CobThread* createThread(unsigned int functionId, const std::vector<int>& params);
@@ -108,7 +123,25 @@ namespace rwe
 
         std::optional<const CobThread*> createThread(const std::string& functionName);
 
-        void deleteThread(const CobThread* thread);
+        /**
+         * Starts the function implementing the entry point.
+         * If the script doesn't implement it, nothing happens.
+         */
+        std::optional<const CobThread*> createThread(CobEntryPoint entryPoint, std::initializer_list<int> params);
+
+        std::optional<const CobThread*> createThread(CobEntryPoint entryPoint);
+
+        /**
+         * Takes a thread from the pool for the given function.
+         * The thread has no call frame and is not in any queue,
+         * so the caller must put it in one.
+         */
+        CobThread& acquireThread(unsigned int functionId, unsigned int signalMask);
+
+        /** Removes the thread from its queue and returns it to the pool. */
+        void deleteThread(CobThread* thread);
+
+        void deleteAllThreads();
 
         /**
          * Sends a signal to all threads.
@@ -117,6 +150,13 @@ namespace rwe
          */
         void sendSignal(unsigned int signal);
 
+        /**
+         * Changes the thread's signal mask.
+         * Threads not created by the environment are allowed,
+         * in which case this just sets the mask.
+         */
+        void setSignalMask(CobThread* thread, unsigned int signalMask);
+
         /**
          * Attempts to collect the return value from a thread.
          * The return value will be available for collection
@@ -124,14 +164,17 @@ namespace rwe
          * If the return value is not collected,
          * the cob execution service will clean up the thread
          * next frame.
+         * A thread that has been killed, or deleted and reused
+         * for another function, never has a value to collect.
          */
-        std::optional<int> tryReapThread(const CobThread* thread);
+        std::optional<int> tryReapThread(const CobThreadHandle& handle);
 
         bool isNotCorrupt() const;
 
-    private:
-        void removeThreadFromQueues(const CobThread* thread);
+        /** Starts or stops counting what each function costs in profile. */
+        void setProfilingEnabled(bool enabled);
 
-        bool isPresentInAQueue(const CobThread* thread) const;
+    private:
+        SignalGroup& getSignalGroup(unsigned int signalMask);
     };
 }
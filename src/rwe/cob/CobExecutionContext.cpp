@@ -1,494 +1,734 @@
 #include "CobExecutionContext.h"
+#include <cassert>
 #include <random>
-#include <rwe/GameScene.h>
-#include <rwe/SceneManager.h>
 #include <rwe/cob/CobConstants.h>
-#include <rwe/cob/CobOpCode.h>
 #include <rwe/cob/cob_util.h>
 #include <rwe/fixed_point.h>
 
+// GCC and Clang can jump straight from the end of one instruction's code
+// to the start of the next via a table of label addresses.
+// Elsewhere every instruction goes back through a switch.
+#if defined(__GNUC__)
+#define RWE_COB_COMPUTED_GOTO
+#endif
+
+#ifdef RWE_COB_COMPUTED_GOTO
+#define RWE_COB_CASE(name) op##name:
+#define RWE_COB_DISPATCH()                                      \
+    do                                                          \
+    {                                                           \
+        instructionCount += ip->sourceInstructionCount;         \
+        goto* dispatchTable[static_cast<unsigned int>(ip->op)]; \
+    } while (false)
+#else
+#define RWE_COB_CASE(name) case CobOp::name:
+#define RWE_COB_DISPATCH()                              \
+    do                                                  \
+    {                                                   \
+        instructionCount += ip->sourceInstructionCount; \
+        goto dispatch;                                  \
+    } while (false)
+#endif
+
+#define RWE_COB_NEXT()        \
+    do                        \
+    {                         \
+        ip = code + ip->next; \
+        RWE_COB_DISPATCH();   \
+    } while (false)
+
+#define RWE_COB_JUMP_IF(condition, target) \
+    do                                     \
+    {                                      \
+        if (condition)                     \
+        {                                  \
+            ip = code + (target);          \
+        }                                  \
+        else                               \
+        {                                  \
+            ip = code + ip->next;          \
+        }                                  \
+        RWE_COB_DISPATCH();                \
+    } while (false)
+
 namespace rwe
 {
     CobExecutionContext::CobExecutionContext(
-        GameScene* scene,
+        CobCommandBuffer* commands,
         GameSimulation* sim,
+        std::minstd_rand* rng,
         CobEnvironment* env,
         CobThread* thread,
-        UnitId unitId) : scene(scene), sim(sim), env(env), thread(thread), unitId(unitId)
+        UnitId unitId) : commands(commands), sim(sim), rng(rng), env(env), thread(thread), unitId(unitId)
     {
     }
 
     CobEnvironment::Status CobExecutionContext::execute()
     {
-        while (!thread->callStack.empty())
-        {
-            auto instruction = nextInstruction();
-            switch (static_cast<OpCode>(instruction))
-            {
-                case OpCode::RAND:
-                    randomNumber();
-                    break;
-
-                case OpCode::ADD:
-                    add();
-                    break;
-                case OpCode::SUB:
-                    subtract();
-                    break;
-                case OpCode::MUL:
-                    multiply();
-                    break;
-                case OpCode::DIV:
-                    divide();
-                    break;
-
-                case OpCode::SET_LESS:
-                    compareLessThan();
-                    break;
-                case OpCode::SET_LESS_OR_EQUAL:
-                    compareLessThanOrEqual();
-                    break;
-                case OpCode::SET_EQUAL:
-                    compareEqual();
-                    break;
-                case OpCode::SET_NOT_EQUAL:
-                    compareNotEqual();
-                    break;
-                case OpCode::SET_GREATER:
-                    compareGreaterThan();
-                    break;
-                case OpCode::SET_GREATER_OR_EQUAL:
-                    compareGreaterThanOrEqual();
-                    break;
-
-                case OpCode::JUMP:
-                    jump();
-                    break;
-                case OpCode::JUMP_IF_ZERO:
-                    jumpIfZero();
-                    break;
-
-                case OpCode::LOGICAL_AND:
-                    logicalAnd();
-                    break;
-                case OpCode::LOGICAL_OR:
-                    logicalOr();
-                    break;
-                case OpCode::LOGICAL_XOR:
-                    logicalXor();
-                    break;
-                case OpCode::LOGICAL_NOT:
-                    logicalNot();
-                    break;
-
-                case OpCode::BITWISE_AND:
-                    bitwiseAnd();
-                    break;
-                case OpCode::BITWISE_OR:
-                    bitwiseOr();
-                    break;
-                case OpCode::BITWISE_XOR:
-                    bitwiseXor();
-                    break;
-                case OpCode::BITWISE_NOT:
-                    bitwiseNot();
-                    break;
-
-                case OpCode::MOVE:
-                    moveObject();
-                    break;
-                case OpCode::MOVE_NOW:
-                    moveObjectNow();
-                    break;
-                case OpCode::TURN:
-                    turnObject();
-                    break;
-                case OpCode::TURN_NOW:
-                    turnObjectNow();
-                    break;
-                case OpCode::SPIN:
-                    spinObject();
-                    break;
-                case OpCode::STOP_SPIN:
-                    stopSpinObject();
-                    break;
-                case OpCode::EXPLODE:
-                    explode();
-                    break;
-                case OpCode::EMIT_SFX:
-                    emitSmoke();
-                    break;
-                case OpCode::SHOW:
-                    showObject();
-                    break;
-                case OpCode::HIDE:
-                    hideObject();
-                    break;
-                case OpCode::SHADE:
-                    enableShading();
-                    break;
-                case OpCode::DONT_SHADE:
-                    disableShading();
-                    break;
-                case OpCode::CACHE:
-                    enableCaching();
-                    break;
-                case OpCode::DONT_CACHE:
-                    disableCaching();
-                    break;
-                case OpCode::ATTACH_UNIT:
-                    attachUnit();
-                    break;
-                case OpCode::DROP_UNIT:
-                    detachUnit();
-                    break;
-
-                case OpCode::WAIT_FOR_MOVE:
-                {
-                    auto object = nextInstruction();
-                    auto axis = nextInstructionAsAxis();
-
-                    return CobEnvironment::BlockedStatus(CobEnvironment::BlockedStatus::Move(object, axis));
-                }
-                case OpCode::WAIT_FOR_TURN:
-                {
-                    auto object = nextInstruction();
-                    auto axis = nextInstructionAsAxis();
-
-                    return CobEnvironment::BlockedStatus(CobEnvironment::BlockedStatus::Turn(object, axis));
-                }
-                case OpCode::SLEEP:
-                {
-                    auto duration = popSleepDuration();
-                    auto wakeUpTime = sim->gameTime + duration.toGameTime();
-                    return CobEnvironment::BlockedStatus(CobEnvironment::BlockedStatus::Sleep(wakeUpTime));
-                }
-
-                case OpCode::CALL_SCRIPT:
-                    callScript();
-                    break;
-                case OpCode::RETURN:
-                    returnFromScript();
-                    break;
-                case OpCode::START_SCRIPT:
-                    startScript();
-                    break;
-
-                case OpCode::SIGNAL:
-                    sendSignal();
-                    break;
-                case OpCode::SET_SIGNAL_MASK:
-                    setSignalMask();
-                    break;
-
-                case OpCode::CREATE_LOCAL_VAR:
-                    createLocalVariable();
-                    break;
-                case OpCode::PUSH_CONSTANT:
-                    pushConstant();
-                    break;
-                case OpCode::PUSH_LOCAL_VAR:
-                    pushLocalVariable();
-                    break;
-                case OpCode::POP_LOCAL_VAR:
-                    popLocalVariable();
-                    break;
-                case OpCode::PUSH_STATIC:
-                    pushStaticVariable();
-                    break;
-                case OpCode::POP_STATIC:
-                    popStaticVariable();
-                    break;
-                case OpCode::POP_STACK:
-                    popStackOperation();
-                    break;
-
-                case OpCode::GET_VALUE:
-                    getValue();
-                    break;
-                case OpCode::GET_VALUE_WITH_ARGS:
-                    getValueWithArgs();
-                    break;
-
-                case OpCode::SET_VALUE:
-                    setValue();
-                    break;
-
-                default:
-                    throw std::runtime_error("Unsupported opcode " + std::to_string(instruction));
-            }
-        }
-
-        return CobEnvironment::FinishedStatus();
-    }
-
-    void CobExecutionContext::randomNumber()
-    {
-        auto high = pop();
-        auto low = pop();
-
-        std::uniform_int_distribution<int> dist(low, high);
-        auto value = dist(sim->rng);
-        push(value);
-    }
+        if (thread->callStack.empty())
+        {
+            return CobEnvironment::FinishedStatus();
+        }
 
-    void CobExecutionContext::add()
-    {
-        auto b = pop();
-        auto a = pop();
-        push(a + b);
-    }
+        const auto& program = env->script()->decodedInstructions;
+        assert(!program.empty());
+        const CobInstruction* const code = program.data();
+
+        // Decoded jump targets always lie within the program,
+        // but addresses from elsewhere must be checked.
+        auto at = [&program, code](unsigned int address) {
+            return address < program.size() ? code + address : code + (program.size() - 1);
+        };
+
+        // Saves the address to continue from when the thread next runs.
+        auto suspend = [this](const CobInstruction* ip) {
+            thread->callStack.top().instructionIndex = ip->next;
+        };
+
+        const CobInstruction* ip = at(thread->callStack.top().instructionIndex);
+
+#ifdef RWE_COB_COMPUTED_GOTO
+        // Must be in the same order as CobOp.
+        static const void* const dispatchTable[] = {
+            &&opUnsupported,
+            &&opEndOfCode,
+            &&opInvalidAxis,
+            &&opMove,
+            &&opTurn,
+            &&opSpin,
+            &&opStopSpin,
+            &&opShow,
+            &&opHide,
+            &&opCache,
+            &&opDontCache,
+            &&opMoveNow,
+            &&opTurnNow,
+            &&opShade,
+            &&opDontShade,
+            &&opEmitSfx,
+            &&opWaitForTurn,
+            &&opWaitForMove,
+            &&opSleep,
+            &&opPushConstant,
+            &&opPushLocalVar,
+            &&opPushStatic,
+            &&opCreateLocalVar,
+            &&opPopLocalVar,
+            &&opPopStatic,
+            &&opPopStack,
+            &&opAdd,
+            &&opSub,
+            &&opMul,
+            &&opDiv,
+            &&opBitwiseAnd,
+            &&opBitwiseOr,
+            &&opBitwiseXor,
+            &&opBitwiseNot,
+            &&opRand,
+            &&opGetValue,
+            &&opGetValueWithArgs,
+            &&opSetValue,
+            &&opSetLess,
+            &&opSetLessOrEqual,
+            &&opSetGreater,
+            &&opSetGreaterOrEqual,
+            &&opSetEqual,
+            &&opSetNotEqual,
+            &&opLogicalAnd,
+            &&opLogicalOr,
+            &&opLogicalXor,
+            &&opLogicalNot,
+            &&opStartScript,
+            &&opCallScript,
+            &&opJump,
+            &&opReturn,
+            &&opJumpIfZero,
+            &&opSignal,
+            &&opSetSignalMask,
+            &&opExplode,
+            &&opAttachUnit,
+            &&opDropUnit,
+            &&opJumpUnlessLess,
+            &&opJumpUnlessLessOrEqual,
+            &&opJumpUnlessGreater,
+            &&opJumpUnlessGreaterOrEqual,
+            &&opJumpUnlessEqual,
+            &&opJumpUnlessNotEqual,
+            &&opJumpUnlessLessConstant,
+            &&opJumpUnlessLessOrEqualConstant,
+            &&opJumpUnlessGreaterConstant,
+            &&opJumpUnlessGreaterOrEqualConstant,
+            &&opJumpUnlessEqualConstant,
+            &&opJumpUnlessNotEqualConstant,
+        };
+        static_assert(sizeof(dispatchTable) / sizeof(dispatchTable[0]) == CobOpCount);
+
+        RWE_COB_DISPATCH();
+#else
+        instructionCount += ip->sourceInstructionCount;
+    dispatch:
+        switch (ip->op)
+        {
+#endif
 
-    void CobExecutionContext::subtract()
-    {
-        auto b = pop();
-        auto a = pop();
-        push(a - b);
-    }
+        RWE_COB_CASE(Unsupported)
+        {
+            throw std::runtime_error("Unsupported opcode " + std::to_string(ip->a));
+        }
+        RWE_COB_CASE(EndOfCode)
+        {
+            throw std::out_of_range("Cob instruction index out of range");
+        }
+        RWE_COB_CASE(InvalidAxis)
+        {
+            throw std::runtime_error("Invalid axis: " + std::to_string(ip->a));
+        }
 
-    void CobExecutionContext::multiply()
-    {
-        auto b = pop();
-        auto a = pop();
-        push(a * b);
-    }
+        RWE_COB_CASE(Move)
+        {
+            moveObject(ip->a, static_cast<Axis>(ip->b));
+            RWE_COB_NEXT();
+        }
+        RWE_COB_CASE(Turn)
+        {
+            turnObject(ip->a, static_cast<Axis>(ip->b));
+            RWE_COB_NEXT();
+        }
+        RWE_COB_CASE(Spin)
+        {
+            spinObject(ip->a, static_cast<Axis>(ip->b));
+            RWE_COB_NEXT();
+        }
+        RWE_COB_CASE(StopSpin)
+        {
+            stopSpinObject(ip->a, static_cast<Axis>(ip->b));
+            RWE_COB_NEXT();
+        }
+        RWE_COB_CASE(Show)
+        {
+            sim->showObject(unitId, ip->a);
+            RWE_COB_NEXT();
+        }
+        RWE_COB_CASE(Hide)
+        {
+            sim->hideObject(unitId, ip->a);
+            RWE_COB_NEXT();
+        }
+        RWE_COB_CASE(Cache)
+        {
+            // do nothing, RWE does not have the concept of caching
+            RWE_COB_NEXT();
+        }
+        RWE_COB_CASE(DontCache)
+        {
+            // do nothing, RWE does not have the concept of caching
+            RWE_COB_NEXT();
+        }
+        RWE_COB_CASE(MoveNow)
+        {
+            moveObjectNow(ip->a, static_cast<Axis>(ip->b));
+            RWE_COB_NEXT();
+        }
+        RWE_COB_CASE(TurnNow)
+        {
+            turnObjectNow(ip->a, static_cast<Axis>(ip->b));
+            RWE_COB_NEXT();
+        }
+        RWE_COB_CASE(Shade)
+        {
+            sim->enableShading(unitId, ip->a);
+            RWE_COB_NEXT();
+        }
+        RWE_COB_CASE(DontShade)
+        {
+            sim->disableShading(unitId, ip->a);
+            RWE_COB_NEXT();
+        }
+        RWE_COB_CASE(EmitSfx)
+        {
+            emitSmoke(ip->a);
+            RWE_COB_NEXT();
+        }
 
-    void CobExecutionContext::divide()
-    {
-        auto b = pop();
-        auto a = pop();
-        push(a / b);
-    }
+        RWE_COB_CASE(WaitForTurn)
+        {
+            // If the piece has already stopped there will be no notification,
+            // so have the unit's blocked threads checked next tick.
+            if (!sim->isPieceTurning(unitId, ip->a, static_cast<Axis>(ip->b)))
+            {
+                env->blockedQueueDirty = true;
+            }
+            suspend(ip);
+            return CobEnvironment::BlockedStatus(CobEnvironment::BlockedStatus::Turn(ip->a, static_cast<Axis>(ip->b)));
+        }
+        RWE_COB_CASE(WaitForMove)
+        {
+            if (!sim->isPieceMoving(unitId, ip->a, static_cast<Axis>(ip->b)))
+            {
+                env->blockedQueueDirty = true;
+            }
+            suspend(ip);
+            return CobEnvironment::BlockedStatus(CobEnvironment::BlockedStatus::Move(ip->a, static_cast<Axis>(ip->b)));
+        }
+        RWE_COB_CASE(Sleep)
+        {
+            auto duration = popSleepDuration();
+            auto wakeUpTime = sim->gameTime + duration.toGameTime();
+            suspend(ip);
+            return CobEnvironment::BlockedStatus(CobEnvironment::BlockedStatus::Sleep(wakeUpTime));
+        }
 
-    void CobExecutionContext::compareLessThan()
-    {
-        auto b = pop();
-        auto a = pop();
-        push(a < b ? CobTrue : CobFalse);
-    }
+        RWE_COB_CASE(PushConstant)
+        {
+            if (thread->stack.full())
+            {
+                // Out of room for values; end the thread rather than the game.
+                return CobEnvironment::FinishedStatus();
+            }
+            push(static_cast<int>(ip->a));
+            RWE_COB_NEXT();
+        }
+        RWE_COB_CASE(PushLocalVar)
+        {
+            if (thread->stack.full())
+            {
+                return CobEnvironment::FinishedStatus();
+            }
+            push(getLocalVariable(ip->a));
+            RWE_COB_NEXT();
+        }
+        RWE_COB_CASE(PushStatic)
+        {
+            if (thread->stack.full())
+            {
+                return CobEnvironment::FinishedStatus();
+            }
+            push(env->getStatic(ip->a));
+            RWE_COB_NEXT();
+        }
+        RWE_COB_CASE(CreateLocalVar)
+        {
+            if (!createLocalVariable())
+            {
+                // Out of room for locals; end the thread rather than the game.
+                return CobEnvironment::FinishedStatus();
+            }
+            RWE_COB_NEXT();
+        }
+        RWE_COB_CASE(PopLocalVar)
+        {
+            auto value = pop();
+            getLocalVariable(ip->a) = value;
+            RWE_COB_NEXT();
+        }
+        RWE_COB_CASE(PopStatic)
+        {
+            auto value = pop();
+            env->setStatic(ip->a, value);
+            RWE_COB_NEXT();
+        }
+        RWE_COB_CASE(PopStack)
+        {
+            pop();
+            RWE_COB_NEXT();
+        }
 
-    void CobExecutionContext::compareLessThanOrEqual()
-    {
-        auto b = pop();
-        auto a = pop();
-        push(a <= b ? CobTrue : CobFalse);
-    }
+        RWE_COB_CASE(Add)
+        {
+            auto b = pop();
+            auto a = pop();
+            push(a + b);
+            RWE_COB_NEXT();
+        }
+        RWE_COB_CASE(Sub)
+        {
+            auto b = pop();
+            auto a = pop();
+            push(a - b);
+            RWE_COB_NEXT();
+        }
+        RWE_COB_CASE(Mul)
+        {
+            auto b = pop();
+            auto a = pop();
+            push(a * b);
+            RWE_COB_NEXT();
+        }
+        RWE_COB_CASE(Div)
+        {
+            auto b = pop();
+            auto a = pop();
+            push(a / b);
+            RWE_COB_NEXT();
+        }
 
-    void CobExecutionContext::compareEqual()
-    {
-        auto b = pop();
-        auto a = pop();
-        push(a == b ? CobTrue : CobFalse);
-    }
+        RWE_COB_CASE(BitwiseAnd)
+        {
+            auto b = pop();
+            auto a = pop();
+            push(a & b);
+            RWE_COB_NEXT();
+        }
+        RWE_COB_CASE(BitwiseOr)
+        {
+            auto b = pop();
+            auto a = pop();
+            push(a | b);
+            RWE_COB_NEXT();
+        }
+        RWE_COB_CASE(BitwiseXor)
+        {
+            auto b = pop();
+            auto a = pop();
+            push(a ^ b);
+            RWE_COB_NEXT();
+        }
+        RWE_COB_CASE(BitwiseNot)
+        {
+            auto v = pop();
+            push(~v);
+            RWE_COB_NEXT();
+        }
 
-    void CobExecutionContext::compareNotEqual()
-    {
-        auto b = pop();
-        auto a = pop();
-        push(a != b ? CobTrue : CobFalse);
-    }
+        RWE_COB_CASE(Rand)
+        {
+            randomNumber();
+            RWE_COB_NEXT();
+        }
+        RWE_COB_CASE(GetValue)
+        {
+            getValue();
+            RWE_COB_NEXT();
+        }
+        RWE_COB_CASE(GetValueWithArgs)
+        {
+            getValueWithArgs();
+            RWE_COB_NEXT();
+        }
+        RWE_COB_CASE(SetValue)
+        {
+            setValue();
+            RWE_COB_NEXT();
+        }
 
-    void CobExecutionContext::compareGreaterThan()
-    {
-        auto b = pop();
-        auto a = pop();
-        push(a > b ? CobTrue : CobFalse);
-    }
+        RWE_COB_CASE(SetLess)
+        {
+            auto b = pop();
+            auto a = pop();
+            push(a < b ? CobTrue : CobFalse);
+            RWE_COB_NEXT();
+        }
+        RWE_COB_CASE(SetLessOrEqual)
+        {
+            auto b = pop();
+            auto a = pop();
+            push(a <= b ? CobTrue : CobFalse);
+            RWE_COB_NEXT();
+        }
+        RWE_COB_CASE(SetGreater)
+        {
+            auto b = pop();
+            auto a = pop();
+            push(a > b ? CobTrue : CobFalse);
+            RWE_COB_NEXT();
+        }
+        RWE_COB_CASE(SetGreaterOrEqual)
+        {
+            auto b = pop();
+            auto a = pop();
+            push(a >= b ? CobTrue : CobFalse);
+            RWE_COB_NEXT();
+        }
+        RWE_COB_CASE(SetEqual)
+        {
+            auto b = pop();
+            auto a = pop();
+            push(a == b ? CobTrue : CobFalse);
+            RWE_COB_NEXT();
+        }
+        RWE_COB_CASE(SetNotEqual)
+        {
+            auto b = pop();
+            auto a = pop();
+            push(a != b ? CobTrue : CobFalse);
+            RWE_COB_NEXT();
+        }
+        RWE_COB_CASE(LogicalAnd)
+        {
+            auto b = pop();
+            auto a = pop();
+            push(a && b ? CobTrue : CobFalse);
+            RWE_COB_NEXT();
+        }
+        RWE_COB_CASE(LogicalOr)
+        {
+            auto b = pop();
+            auto a = pop();
+            push(a || b ? CobTrue : CobFalse);
+            RWE_COB_NEXT();
+        }
+        RWE_COB_CASE(LogicalXor)
+        {
+            auto b = pop();
+            auto a = pop();
+            push(!a != !b ? CobTrue : CobFalse);
+            RWE_COB_NEXT();
+        }
+        RWE_COB_CASE(LogicalNot)
+        {
+            auto v = pop();
+            push(!v ? CobTrue : CobFalse);
+            RWE_COB_NEXT();
+        }
 
-    void CobExecutionContext::compareGreaterThanOrEqual()
-    {
-        auto b = pop();
-        auto a = pop();
-        push(a >= b ? CobTrue : CobFalse);
-    }
+        RWE_COB_CASE(StartScript)
+        {
+            startScript(ip->a, ip->b);
+            RWE_COB_NEXT();
+        }
+        RWE_COB_CASE(CallScript)
+        {
+            suspend(ip);
+            if (!callScript(ip->a, ip->b))
+            {
+                // Runaway recursion; end the thread rather than the game.
+                return CobEnvironment::FinishedStatus();
+            }
+            ip = at(thread->callStack.top().instructionIndex);
+            RWE_COB_DISPATCH();
+        }
+        RWE_COB_CASE(Jump)
+        {
+            ip = code + ip->a;
+            RWE_COB_DISPATCH();
+        }
+        RWE_COB_CASE(Return)
+        {
+            returnFromScript();
+            if (thread->callStack.empty())
+            {
+                return CobEnvironment::FinishedStatus();
+            }
+            ip = at(thread->callStack.top().instructionIndex);
+            RWE_COB_DISPATCH();
+        }
+        RWE_COB_CASE(JumpIfZero)
+        {
+            RWE_COB_JUMP_IF(pop() == 0, ip->a);
+        }
+        RWE_COB_CASE(Signal)
+        {
+            auto signal = popSignal();
+            if (!env->profile.empty())
+            {
+                env->profile[thread->functionId].signalsSent += 1;
+            }
+            if (thread->signalMask & signal)
+            {
+                // The signal kills this thread too, which can't happen while it runs,
+                // so leave it to the execution service to send.
+                suspend(ip);
+                return CobEnvironment::SignalStatus{signal};
+            }
+            env->sendSignal(signal);
+            RWE_COB_NEXT();
+        }
+        RWE_COB_CASE(SetSignalMask)
+        {
+            setSignalMask();
+            RWE_COB_NEXT();
+        }
 
-    void CobExecutionContext::jump()
-    {
-        auto jumpOffset = nextInstruction();
-        thread->callStack.top().instructionIndex = jumpOffset;
-    }
+        RWE_COB_CASE(Explode)
+        {
+            explode(ip->a);
+            RWE_COB_NEXT();
+        }
 
-    void CobExecutionContext::jumpIfZero()
-    {
-        auto jumpOffset = nextInstruction();
-        auto value = pop();
-        if (value == 0)
+        RWE_COB_CASE(AttachUnit)
         {
-            thread->callStack.top().instructionIndex = jumpOffset;
+            attachUnit();
+            RWE_COB_NEXT();
+        }
+        RWE_COB_CASE(DropUnit)
+        {
+            detachUnit();
+            RWE_COB_NEXT();
         }
-    }
 
-    void CobExecutionContext::logicalAnd()
-    {
-        auto b = pop();
-        auto a = pop();
-        push(a && b ? CobTrue : CobFalse);
-    }
+        RWE_COB_CASE(JumpUnlessLess)
+        {
+            auto b = pop();
+            auto a = pop();
+            RWE_COB_JUMP_IF(!(a < b), ip->a);
+        }
+        RWE_COB_CASE(JumpUnlessLessOrEqual)
+        {
+            auto b = pop();
+            auto a = pop();
+            RWE_COB_JUMP_IF(!(a <= b), ip->a);
+        }
+        RWE_COB_CASE(JumpUnlessGreater)
+        {
+            auto b = pop();
+            auto a = pop();
+            RWE_COB_JUMP_IF(!(a > b), ip->a);
+        }
+        RWE_COB_CASE(JumpUnlessGreaterOrEqual)
+        {
+            auto b = pop();
+            auto a = pop();
+            RWE_COB_JUMP_IF(!(a >= b), ip->a);
+        }
+        RWE_COB_CASE(JumpUnlessEqual)
+        {
+            auto b = pop();
+            auto a = pop();
+            RWE_COB_JUMP_IF(!(a == b), ip->a);
+        }
+        RWE_COB_CASE(JumpUnlessNotEqual)
+        {
+            auto b = pop();
+            auto a = pop();
+            RWE_COB_JUMP_IF(!(a != b), ip->a);
+        }
 
-    void CobExecutionContext::logicalOr()
-    {
-        auto b = pop();
-        auto a = pop();
-        push(a || b ? CobTrue : CobFalse);
-    }
+        RWE_COB_CASE(JumpUnlessLessConstant)
+        {
+            auto a = pop();
+            RWE_COB_JUMP_IF(!(a < static_cast<int>(ip->a)), ip->b);
+        }
+        RWE_COB_CASE(JumpUnlessLessOrEqualConstant)
+        {
+            auto a = pop();
+            RWE_COB_JUMP_IF(!(a <= static_cast<int>(ip->a)), ip->b);
+        }
+        RWE_COB_CASE(JumpUnlessGreaterConstant)
+        {
+            auto a = pop();
+            RWE_COB_JUMP_IF(!(a > static_cast<int>(ip->a)), ip->b);
+        }
+        RWE_COB_CASE(JumpUnlessGreaterOrEqualConstant)
+        {
+            auto a = pop();
+            RWE_COB_JUMP_IF(!(a >= static_cast<int>(ip->a)), ip->b);
+        }
+        RWE_COB_CASE(JumpUnlessEqualConstant)
+        {
+            auto a = pop();
+            RWE_COB_JUMP_IF(!(a == static_cast<int>(ip->a)), ip->b);
+        }
+        RWE_COB_CASE(JumpUnlessNotEqualConstant)
+        {
+            auto a = pop();
+            RWE_COB_JUMP_IF(!(a != static_cast<int>(ip->a)), ip->b);
+        }
 
-    void CobExecutionContext::logicalXor()
-    {
-        auto b = pop();
-        auto a = pop();
-        push(!a != !b ? CobTrue : CobFalse);
-    }
+#ifndef RWE_COB_COMPUTED_GOTO
+        }
 
-    void CobExecutionContext::logicalNot()
-    {
-        auto v = pop();
-        push(!v ? CobTrue : CobFalse);
+        throw std::logic_error("Invalid decoded cob instruction");
+#endif
     }
 
-    void CobExecutionContext::bitwiseAnd()
-    {
-        auto b = pop();
-        auto a = pop();
-        push(a & b);
-    }
+#undef RWE_COB_JUMP_IF
+#undef RWE_COB_NEXT
+#undef RWE_COB_DISPATCH
+#undef RWE_COB_CASE
+#undef RWE_COB_COMPUTED_GOTO
 
-    void CobExecutionContext::bitwiseOr()
+    std::uint64_t CobExecutionContext::getInstructionCount() const
     {
-        auto b = pop();
-        auto a = pop();
-        push(a | b);
+        return instructionCount;
     }
 
-    void CobExecutionContext::bitwiseXor()
+    void CobExecutionContext::randomNumber()
     {
-        auto b = pop();
-        auto a = pop();
-        push(a ^ b);
-    }
+        auto high = pop();
+        auto low = pop();
 
-    void CobExecutionContext::bitwiseNot()
-    {
-        auto v = pop();
-        push(~v);
+        std::uniform_int_distribution<int> dist(low, high);
+        auto value = dist(*rng);
+        push(value);
     }
 
-    void CobExecutionContext::moveObject()
+    void CobExecutionContext::moveObject(unsigned int object, Axis axis)
     {
-        auto object = nextInstruction();
-        auto axis = nextInstructionAsAxis();
         auto position = popPosition();
         if (axis == Axis::X) // flip x-axis translations to match our right-handed coordinates
         {
             position = -position;
         }
         auto speed = popSpeed();
-        sim->moveObject(unitId, getObjectName(object), axis, position.toWorldDistance(), speed.toSimScalar());
+        sim->moveObject(unitId, object, axis, position.toWorldDistance(), speed.toSimScalar());
     }
 
-    void CobExecutionContext::moveObjectNow()
+    void CobExecutionContext::moveObjectNow(unsigned int object, Axis axis)
     {
-        auto object = nextInstruction();
-        auto axis = nextInstructionAsAxis();
         auto position = popPosition();
         if (axis == Axis::X) // flip x-axis translations to match our right-handed coordinates
         {
             position = -position;
         }
-        sim->moveObjectNow(unitId, getObjectName(object), axis, position.toWorldDistance());
+        sim->moveObjectNow(unitId, object, axis, position.toWorldDistance());
+
+        // this cancels any move in progress, which may unblock a thread
+        env->blockedQueueDirty = true;
     }
 
-    void CobExecutionContext::turnObject()
+    void CobExecutionContext::turnObject(unsigned int object, Axis axis)
     {
-        auto object = nextInstruction();
-        auto axis = nextInstructionAsAxis();
         auto angle = popAngle();
         if (axis == Axis::Z) // flip z-axis rotations to match our right-handed coordinates
         {
             angle = -angle;
         }
         auto speed = popAngularSpeed();
-        sim->turnObject(unitId, getObjectName(object), axis, toWorldAngle(angle), speed.toSimScalar());
+        sim->turnObject(unitId, object, axis, toWorldAngle(angle), speed.toSimScalar());
     }
 
-    void CobExecutionContext::turnObjectNow()
+    void CobExecutionContext::turnObjectNow(unsigned int object, Axis axis)
     {
-        auto object = nextInstruction();
-        auto axis = nextInstructionAsAxis();
         auto angle = popAngle();
         if (axis == Axis::Z) // flip z-axis rotations to match our right-handed coordinates
         {
             angle = -angle;
         }
-        sim->turnObjectNow(unitId, getObjectName(object), axis, toWorldAngle(angle));
+        sim->turnObjectNow(unitId, object, axis, toWorldAngle(angle));
+        env->blockedQueueDirty = true;
     }
 
-    void CobExecutionContext::spinObject()
+    void CobExecutionContext::spinObject(unsigned int object, Axis axis)
     {
-        auto object = nextInstruction();
-        auto axis = nextInstructionAsAxis();
         auto targetSpeed = popAngularSpeed();
         auto acceleration = popAngularSpeed();
-        sim->spinObject(unitId, getObjectName(object), axis, targetSpeed.toSimScalar(), acceleration.toSimScalar());
+        sim->spinObject(unitId, object, axis, targetSpeed.toSimScalar(), acceleration.toSimScalar());
     }
 
-    void CobExecutionContext::stopSpinObject()
+    void CobExecutionContext::stopSpinObject(unsigned int object, Axis axis)
     {
-        auto object = nextInstruction();
-        auto axis = nextInstructionAsAxis();
         auto deceleration = popAngularSpeed();
-        sim->stopSpinObject(unitId, getObjectName(object), axis, deceleration.toSimScalar());
+        sim->stopSpinObject(unitId, object, axis, deceleration.toSimScalar());
+
+        // with no deceleration the spin stops immediately
+        if (deceleration.value == 0)
+        {
+            env->blockedQueueDirty = true;
+        }
     }
 
-    void CobExecutionContext::explode()
+    void CobExecutionContext::explode(unsigned int /*object*/)
     {
-        /*auto object = */ nextInstruction();
         /*auto explosionType = */ pop();
         // TODO: this
     }
 
-    void CobExecutionContext::emitSmoke()
+    void CobExecutionContext::emitSmoke(unsigned int /*piece*/)
     {
-        /*auto piece = */ nextInstruction();
         /*auto smokeType = */ pop();
         // TODO: this
     }
 
-    void CobExecutionContext::showObject()
-    {
-        auto object = nextInstruction();
-        sim->showObject(unitId, getObjectName(object));
-    }
-
-    void CobExecutionContext::hideObject()
-    {
-        auto object = nextInstruction();
-        sim->hideObject(unitId, getObjectName(object));
-    }
-
-    void CobExecutionContext::enableShading()
-    {
-        auto object = nextInstruction();
-        sim->enableShading(unitId, getObjectName(object));
-    }
-
-    void CobExecutionContext::disableShading()
-    {
-        auto object = nextInstruction();
-        sim->disableShading(unitId, getObjectName(object));
-    }
-
-    void CobExecutionContext::enableCaching()
-    {
-        nextInstruction(); // object
-        // do nothing, RWE does not have the concept of caching
-    }
-
-    void CobExecutionContext::disableCaching()
-    {
-        nextInstruction(); // object
-        // do nothing, RWE does not have the concept of caching
-    }
-
     void CobExecutionContext::attachUnit()
     {
         /*auto piece = */ pop();
@@ -505,31 +745,32 @@ namespace rwe
     void CobExecutionContext::returnFromScript()
     {
         thread->returnValue = pop();
-        thread->returnLocals = thread->callStack.top().locals;
-        thread->callStack.pop();
+        const auto& frame = thread->callStack.top();
+        thread->returnLocals.assign(thread->locals.begin() + frame.localsStart, thread->locals.end());
+        thread->popFrame();
     }
 
-    void CobExecutionContext::callScript()
+    bool CobExecutionContext::callScript(unsigned int functionId, unsigned int paramCount)
     {
-        auto functionId = nextInstruction();
-        auto paramCount = nextInstruction();
+        const auto& functionInfo = env->script()->functions.at(functionId);
+        if (thread->callStack.full() || thread->locals.size() + paramCount > thread->locals.capacity())
+        {
+            return false;
+        }
 
-        // collect up the parameters
-        std::vector<int> params(paramCount);
+        thread->callStack.push(CobFunction(functionInfo.address, thread->locals.size()));
+
+        // the parameters become the first locals of the new frame
         for (unsigned int i = 0; i < paramCount; ++i)
         {
-            params[i] = pop();
+            thread->locals.push(pop());
         }
 
-        const auto& functionInfo = env->script()->functions.at(functionId);
-        thread->callStack.emplace(functionInfo.address, params);
+        return true;
     }
 
-    void CobExecutionContext::startScript()
+    void CobExecutionContext::startScript(unsigned int functionId, unsigned int paramCount)
     {
-        auto functionId = nextInstruction();
-        auto paramCount = nextInstruction();
-
         std::vector<int> params(paramCount);
         for (unsigned int i = 0; i < paramCount; ++i)
         {
@@ -539,62 +780,35 @@ namespace rwe
         env->createThread(functionId, params, thread->signalMask);
     }
 
-    void CobExecutionContext::sendSignal()
-    {
-        auto signal = popSignal();
-        env->sendSignal(signal);
-    }
-
     void CobExecutionContext::setSignalMask()
     {
         auto mask = popSignalMask();
-        thread->signalMask = mask;
+        env->setSignalMask(thread, mask);
     }
 
-    void CobExecutionContext::createLocalVariable()
+    bool CobExecutionContext::createLocalVariable()
     {
-        if (thread->callStack.top().localCount == thread->callStack.top().locals.size())
+        auto& frame = thread->callStack.top();
+        if (frame.localsStart + frame.localCount == thread->locals.size())
         {
-            thread->callStack.top().locals.emplace_back();
+            if (thread->locals.full())
+            {
+                return false;
+            }
+            thread->locals.push(0);
         }
-        thread->callStack.top().localCount += 1;
+        frame.localCount += 1;
+        return true;
     }
 
-    void CobExecutionContext::pushConstant()
+    int& CobExecutionContext::getLocalVariable(unsigned int variableId)
     {
-        auto constant = nextInstruction();
-        push(constant);
-    }
-
-    void CobExecutionContext::pushLocalVariable()
-    {
-        auto variableId = nextInstruction();
-        push(thread->callStack.top().locals.at(variableId));
-    }
-
-    void CobExecutionContext::popLocalVariable()
-    {
-        auto variableId = nextInstruction();
-        auto value = pop();
-        thread->callStack.top().locals.at(variableId) = value;
-    }
-
-    void CobExecutionContext::pushStaticVariable()
-    {
-        auto variableId = nextInstruction();
-        push(env->getStatic(variableId));
-    }
-
-    void CobExecutionContext::popStaticVariable()
-    {
-        auto variableId = nextInstruction();
-        auto value = pop();
-        env->setStatic(variableId, value);
-    }
-
-    void CobExecutionContext::popStackOperation()
-    {
-        pop();
+        auto localsStart = thread->callStack.top().localsStart;
+        if (variableId >= thread->locals.size() - localsStart)
+        {
+            throw std::out_of_range("Invalid local variable: " + std::to_string(variableId));
+        }
+        return thread->locals[localsStart + variableId];
     }
 
     void CobExecutionContext::getValue()
@@ -676,30 +890,11 @@ namespace rwe
 
     void CobExecutionContext::push(int val)
     {
+        // Only the push instructions leave more values on the stack than they take off,
+        // and they check for room first.
         thread->stack.push(val);
     }
 
-    Axis CobExecutionContext::nextInstructionAsAxis()
-    {
-        auto val = nextInstruction();
-        switch (val)
-        {
-            case 0:
-                return Axis::X;
-            case 1:
-                return Axis::Y;
-            case 2:
-                return Axis::Z;
-            default:
-                throw std::runtime_error("Invalid axis: " + std::to_string(val));
-        }
-    }
-
-    unsigned int CobExecutionContext::nextInstruction()
-    {
-        return env->script()->instructions.at(thread->callStack.top().instructionIndex++);
-    }
-
     const std::string& CobExecutionContext::getObjectName(unsigned int objectId)
     {
         return env->_script->pieces.at(objectId);
@@ -733,12 +928,11 @@ namespace rwe
             case CobValueId::PieceXZ:
             {
                 auto pieceId = arg1;
-                const auto& pieceName = getObjectName(pieceId);
                 const auto& unit = sim->getUnit(unitId);
-                auto pieceTransform = unit.mesh.getPieceTransform(pieceName);
+                auto pieceTransform = unit.getPieceTransform(pieceId);
                 if (!pieceTransform)
                 {
-                    throw std::runtime_error("Unknown piece " + pieceName);
+                    throw std::runtime_error("Unknown piece " + getObjectName(pieceId));
                 }
                 auto pos = unit.getTransform() * (*pieceTransform) * SimVector(0_ss, 0_ss, 0_ss);
                 return packCoords(pos.x, pos.z);
@@ -746,12 +940,11 @@ namespace rwe
             case CobValueId::PieceY:
             {
                 auto pieceId = arg1;
-                const auto& pieceName = getObjectName(pieceId);
                 const auto& unit = sim->getUnit(unitId);
-                auto pieceTransform = unit.mesh.getPieceTransform(pieceName);
+                auto pieceTransform = unit.getPieceTransform(pieceId);
                 if (!pieceTransform)
                 {
-                    throw std::runtime_error("Unknown piece " + pieceName);
+                    throw std::runtime_error("Unknown piece " + getObjectName(pieceId));
                 }
                 const auto& pos = unit.getTransform() * (*pieceTransform) * SimVector(0_ss, 0_ss, 0_ss);
                 return simScalarToFixed(pos.y);
@@ -874,14 +1067,10 @@ namespace rwe
         {
             case CobValueId::Activation:
             {
-                if (value)
-                {
-                    scene->activateUnit(unitId);
-                }
-                else
-                {
-                    scene->deactivateUnit(unitId);
-                }
+                // The unit's own flag changes straight away so that the script can read it back.
+                // Starting the Activate/Deactivate script and telling the player waits for the command.
+                sim->getUnit(unitId).activated = value != 0;
+                commands->unitCommands.emplace_back(unitId, CobUnitCommand::SetActivation{value != 0});
                 return;
             }
             case CobValueId::StandingMoveOrders:
@@ -890,19 +1079,30 @@ namespace rwe
                 return; // TODO
             case CobValueId::InBuildStance:
             {
-                scene->setBuildStance(unitId, value != 0);
+                sim->getUnit(unitId).inBuildStance = value != 0;
+                commands->unitCommands.emplace_back(unitId, CobUnitCommand::SetBuildStance{value != 0});
                 return;
             }
             case CobValueId::Busy:
                 return; // TODO
             case CobValueId::YardOpen:
             {
-                scene->setYardOpen(unitId, value != 0);
+                // Nothing moves on the occupied grid while scripts run,
+                // so the command will succeed exactly when this check does.
+                auto open = value != 0;
+                if (sim->canSetYardOpen(unitId, open))
+                {
+                    sim->getUnit(unitId).yardOpen = open;
+                    commands->unitCommands.emplace_back(unitId, CobUnitCommand::SetYardOpen{open});
+                }
                 return;
             }
             case CobValueId::BuggerOff:
             {
-                scene->setBuggerOff(unitId, value != 0);
+                if (value)
+                {
+                    commands->unitCommands.emplace_back(unitId, CobUnitCommand::BuggerOff());
+                }
                 return;
             }
             case CobValueId::Armored:
@@ -1,7 +1,10 @@
 #pragma once
 
+#include <cstdint>
+#include <random>
 #include <rwe/GameSimulation.h>
 #include <rwe/cob/CobAngularSpeed.h>
+#include <rwe/cob/CobCommandBuffer.h>
 #include <rwe/cob/CobEnvironment.h>
 #include <rwe/cob/CobPosition.h>
 #include <rwe/cob/CobSleepDuration.h>
@@ -10,99 +13,56 @@
 
 namespace rwe
 {
-    class GameScene;
-
+    /**
+     * Runs one cob thread of a unit.
+     * The thread may change its own unit directly,
+     * but anything that reaches further is recorded in the command buffer,
+     * and random numbers come from the given generator rather than the simulation's,
+     * so that different units can be run at the same time.
+     */
     class CobExecutionContext
     {
     private:
-        GameScene* const scene;
+        CobCommandBuffer* const commands;
         GameSimulation* const sim;
+        std::minstd_rand* const rng;
         CobEnvironment* const env;
         CobThread* const thread;
         const UnitId unitId;
 
+        std::uint64_t instructionCount{0};
+
     public:
-        CobExecutionContext(GameScene* scene, GameSimulation* sim, CobEnvironment* env, CobThread* thread, UnitId unitId);
+        CobExecutionContext(CobCommandBuffer* commands, GameSimulation* sim, std::minstd_rand* rng, CobEnvironment* env, CobThread* thread, UnitId unitId);
 
         CobEnvironment::Status execute();
 
+        /**
+         * The number of raw cob instructions executed by this context so far.
+         * A fused instruction counts as all the instructions it replaced.
+         */
+        std::uint64_t getInstructionCount() const;
+
     private:
         // utility
         void randomNumber();
 
-        // arithmetic
-        void add();
-
-        void subtract();
-
-        void multiply();
-
-        void divide();
-
-        // comparision
-        void compareLessThan();
-
-        void compareLessThanOrEqual();
-
-        void compareEqual();
-
-        void compareNotEqual();
-
-        void compareGreaterThan();
-
-        void compareGreaterThanOrEqual();
-
-        // control flow
-        void jump();
-
-        void jumpIfZero();
-
-        // boolean logic
-        void logicalAnd();
-
-        void logicalOr();
-
-        void logicalXor();
-
-        void logicalNot();
-
-        // bitwise logic
-        void bitwiseAnd();
-
-        void bitwiseOr();
-
-        void bitwiseXor();
-
-        void bitwiseNot();
-
         // control object pieces
-        void moveObject();
-
-        void moveObjectNow();
-
-        void turnObject();
-
-        void turnObjectNow();
-
-        void spinObject();
+        void moveObject(unsigned int object, Axis axis);
 
-        void stopSpinObject();
+        void moveObjectNow(unsigned int object, Axis axis);
 
-        void explode();
+        void turnObject(unsigned int object, Axis axis);
 
-        void emitSmoke();
+        void turnObjectNow(unsigned int object, Axis axis);
 
-        void showObject();
+        void spinObject(unsigned int object, Axis axis);
 
-        void hideObject();
+        void stopSpinObject(unsigned int object, Axis axis);
 
-        void enableShading();
+        void explode(unsigned int object);
 
-        void disableShading();
-
-        void enableCaching();
-
-        void disableCaching();
+        void emitSmoke(unsigned int piece);
 
         void attachUnit();
 
@@ -111,29 +71,19 @@ namespace rwe
         // script dispatch and return
         void returnFromScript();
 
-        void callScript();
+        /** Returns false, calling nothing, if the thread has no room for another frame. */
+        bool callScript(unsigned int functionId, unsigned int paramCount);
 
-        void startScript();
+        void startScript(unsigned int functionId, unsigned int paramCount);
 
         // signalling
-        void sendSignal();
-
         void setSignalMask();
 
         // variables
-        void createLocalVariable();
-
-        void pushConstant();
-
-        void pushLocalVariable();
+        /** Returns false, creating nothing, if the thread has no room for another local. */
+        bool createLocalVariable();
 
-        void popLocalVariable();
-
-        void pushStaticVariable();
-
-        void popStaticVariable();
-
-        void popStackOperation();
+        int& getLocalVariable(unsigned int variableId);
 
         void getValue();
 
@@ -154,9 +104,6 @@ namespace rwe
         CobValueId popValueId();
         void push(int val);
 
-        unsigned int nextInstruction();
-        Axis nextInstructionAsAxis();
-
         const std::string& getObjectName(unsigned int objectId);
 
         int getValueInternal(CobValueId valueId, int arg1, int arg2, int arg3, int arg4);
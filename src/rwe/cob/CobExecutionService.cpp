@@ -1,82 +1,217 @@
 #include "CobExecutionService.h"
-#include <rwe/GameScene.h>
+#include <algorithm>
+#include <rwe/SimulationDriver.h>
 #include <rwe/cob/CobExecutionContext.h>
 #include <rwe/overloaded.h>
+#include <rwe/rwe_time.h>
 
 namespace rwe
 {
-    void CobExecutionService::run(GameScene& scene, GameSimulation& simulation, UnitId unitId)
+    void CobExecutionService::wakeSleepingThreads(GameSimulation& simulation)
+    {
+        std::vector<UnitId> dueUnits;
+        simulation.cobSleepTimers.advance(simulation.gameTime, dueUnits);
+
+        for (auto unitId : dueUnits)
+        {
+            // the unit may have died since the thread went to sleep
+            auto unit = simulation.tryGetUnit(unitId);
+            if (unit)
+            {
+                unit->get().cobEnvironment->blockedQueueDirty = true;
+            }
+        }
+    }
+
+    /**
+     * Mixes the unit's id into the tick's seed,
+     * so that each unit gets its own sequence of random numbers
+     * no matter which thread runs it.
+     */
+    static std::minstd_rand::result_type getUnitRandomSeed(std::uint32_t tickSeed, UnitId unitId)
+    {
+        auto x = tickSeed ^ (unitId.value * 0x9e3779b9u);
+        x ^= x >> 16;
+        x *= 0x85ebca6bu;
+        x ^= x >> 13;
+        x *= 0xc2b2ae35u;
+        x ^= x >> 16;
+        return x;
+    }
+
+    std::uint64_t CobExecutionService::runUnits(ThreadPool& threadPool, GameSimulation& simulation, const std::vector<UnitId>& unitIds, std::vector<CobUnitCommand>& commands)
+    {
+        assert(std::is_sorted(unitIds.begin(), unitIds.end(), [](const auto& a, const auto& b) { return a.value < b.value; }));
+
+        auto tickSeed = static_cast<std::uint32_t>(simulation.rng());
+
+        auto chunkCount = threadPool.getChunkCount(unitIds.size(), MinUnitsPerJob);
+        if (jobs.size() < chunkCount)
+        {
+            jobs.resize(chunkCount);
+        }
+
+        threadPool.forEachChunk(unitIds.size(), MinUnitsPerJob, [&](std::size_t chunk, std::size_t begin, std::size_t end) {
+            auto& job = jobs[chunk];
+            job.buffer.clear();
+            job.instructionCount = 0;
+            for (auto i = begin; i < end; ++i)
+            {
+                auto unitId = unitIds[i];
+                std::minstd_rand rng(getUnitRandomSeed(tickSeed, unitId));
+                job.instructionCount += run(simulation, unitId, rng, job.buffer);
+            }
+        });
+
+        // Each job ran a contiguous run of units,
+        // so taking the jobs in order puts everything in unit order.
+        std::uint64_t instructionCount = 0;
+        for (std::size_t i = 0; i < chunkCount; ++i)
+        {
+            const auto& job = jobs[i];
+            for (const auto& [unitId, wakeUpTime] : job.buffer.sleepTimers)
+            {
+                simulation.cobSleepTimers.schedule(unitId, wakeUpTime);
+            }
+            commands.insert(commands.end(), job.buffer.unitCommands.begin(), job.buffer.unitCommands.end());
+            instructionCount += job.instructionCount;
+        }
+
+        return instructionCount;
+    }
+
+    std::uint64_t CobExecutionService::run(SimulationDriver& driver, GameSimulation& simulation, UnitId unitId)
+    {
+        CobCommandBuffer buffer;
+        auto instructionCount = run(simulation, unitId, simulation.rng, buffer);
+
+        for (const auto& [sleepingUnitId, wakeUpTime] : buffer.sleepTimers)
+        {
+            simulation.cobSleepTimers.schedule(sleepingUnitId, wakeUpTime);
+        }
+        for (const auto& command : buffer.unitCommands)
+        {
+            driver.applyCobUnitCommand(command);
+        }
+
+        return instructionCount;
+    }
+
+    std::uint64_t CobExecutionService::run(GameSimulation& simulation, UnitId unitId, std::minstd_rand& rng, CobCommandBuffer& buffer)
     {
         auto& unit = simulation.getUnit(unitId);
         auto& env = *unit.cobEnvironment;
 
+        // Nothing can happen until a thread is started or unblocked,
+        // so idle units are not worth looking at.
+        if (env.readyQueue.empty() && env.finishedQueue.empty() && !env.blockedQueueDirty)
+        {
+            return 0;
+        }
+
         assert(env.isNotCorrupt());
 
+        const bool profiling = !env.profile.empty();
+
         // clean up any finished threads that were not reaped last frame
-        for (const auto& thread : env.finishedQueue)
+        while (!env.finishedQueue.empty())
         {
-            env.deleteThread(thread);
+            env.deleteThread(env.finishedQueue.front());
         }
-        env.finishedQueue.clear();
 
         assert(env.isNotCorrupt());
 
         // check if any blocked threads can be unblocked
         // and move them back into the ready queue
-        for (auto it = env.blockedQueue.begin(); it != env.blockedQueue.end();)
+        if (env.blockedQueueDirty)
         {
-            const auto& pair = *it;
-            const auto& status = pair.first;
-
-            auto isUnblocked = match(
-                status.condition,
-                [&env, &simulation, unitId](const CobEnvironment::BlockedStatus::Move& condition) {
-                    const auto& pieceName = env._script->pieces.at(condition.object);
-                    return !simulation.isPieceMoving(unitId, pieceName, condition.axis);
-                },
-                [&env, &simulation, unitId](const CobEnvironment::BlockedStatus::Turn& condition) {
-                    const auto& pieceName = env._script->pieces.at(condition.object);
-                    return !simulation.isPieceTurning(unitId, pieceName, condition.axis);
-                },
-                [&simulation](const CobEnvironment::BlockedStatus::Sleep& condition) {
-                    return simulation.gameTime >= condition.wakeUpTime;
-                });
+            env.blockedQueueDirty = false;
 
-            if (isUnblocked)
+            for (auto it = env.blockedQueue.begin(); it != env.blockedQueue.end();)
             {
-                env.readyQueue.push_back(pair.second);
-                it = env.blockedQueue.erase(it);
-            }
-            else
-            {
-                ++it;
+                auto thread = *it;
+
+                if (profiling)
+                {
+                    env.profile[thread->functionId].blockedPolls += 1;
+                }
+
+                auto isUnblocked = match(
+                    *thread->blockedCondition,
+                    [&simulation, unitId](const CobEnvironment::BlockedStatus::Move& condition) {
+                        return !simulation.isPieceMoving(unitId, condition.object, condition.axis);
+                    },
+                    [&simulation, unitId](const CobEnvironment::BlockedStatus::Turn& condition) {
+                        return !simulation.isPieceTurning(unitId, condition.object, condition.axis);
+                    },
+                    [&simulation](const CobEnvironment::BlockedStatus::Sleep& condition) {
+                        return simulation.gameTime >= condition.wakeUpTime;
+                    });
+
+                if (isUnblocked)
+                {
+                    it = env.blockedQueue.erase(it);
+                    thread->blockedCondition = std::nullopt;
+                    env.readyQueue.push_back(thread);
+                }
+                else
+                {
+                    ++it;
+                }
             }
         }
 
         assert(env.isNotCorrupt());
 
+        std::uint64_t instructionCount = 0;
+
         // execute ready threads
         while (!env.readyQueue.empty())
         {
             auto thread = env.readyQueue.front();
             env.readyQueue.pop_front();
 
-            CobExecutionContext context(&scene, &simulation, &env, thread, unitId);
+            // the thread may be killed by its own signal
+            auto functionId = thread->functionId;
+            Timestamp start;
+            if (profiling)
+            {
+                start = getTimestamp();
+            }
+
+            CobExecutionContext context(&buffer, &simulation, &rng, &env, thread, unitId);
 
             match(
                 context.execute(),
-                [&env, thread](const CobEnvironment::BlockedStatus& status) {
-                    env.blockedQueue.emplace_back(status, thread);
+                [&buffer, &env, thread, unitId](const CobEnvironment::BlockedStatus& status) {
+                    thread->blockedCondition = status.condition;
+                    env.blockedQueue.push_back(thread);
+                    if (auto sleep = std::get_if<CobEnvironment::BlockedStatus::Sleep>(&status.condition); sleep != nullptr)
+                    {
+                        buffer.sleepTimers.emplace_back(unitId, sleep->wakeUpTime);
+                    }
                 },
                 [&env, thread](const CobEnvironment::FinishedStatus&) {
-                    env.finishedQueue.emplace_back(thread);
+                    env.finishedQueue.push_back(thread);
                 },
                 [&env, thread](const CobEnvironment::SignalStatus& status) {
-                    env.readyQueue.emplace_front(thread);
+                    env.readyQueue.push_front(thread);
                     env.sendSignal(status.signal);
                 });
+
+            instructionCount += context.getInstructionCount();
+
+            if (profiling)
+            {
+                auto& functionProfile = env.profile[functionId];
+                functionProfile.instructions += context.getInstructionCount();
+                functionProfile.runs += 1;
+                functionProfile.time += getTimestamp() - start;
+            }
         }
 
         assert(env.isNotCorrupt());
+
+        return instructionCount;
     }
 }
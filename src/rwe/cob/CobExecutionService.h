@@ -1,14 +1,69 @@
 #pragma once
 
+#include <cstdint>
+#include <random>
 #include <rwe/GameSimulation.h>
+#include <rwe/ThreadPool.h>
+#include <rwe/cob/CobCommandBuffer.h>
+#include <vector>
 
 namespace rwe
 {
-    class GameScene;
+    class SimulationDriver;
 
     class CobExecutionService
     {
     public:
-        void run(GameScene& scene, GameSimulation& simulation, UnitId unitId);
+        /** Units are not split across more jobs than would leave a job with fewer than this. */
+        static constexpr std::size_t MinUnitsPerJob = 32;
+
+    private:
+        struct Job
+        {
+            CobCommandBuffer buffer;
+            std::uint64_t instructionCount{0};
+        };
+
+        /** Kept between ticks so the buffers don't have to be reallocated. */
+        std::vector<Job> jobs;
+
+    public:
+        /**
+         * Flags the units whose sleeping threads have come due,
+         * so that run rechecks their blocked threads.
+         * Must be called once per tick, before any unit is run.
+         */
+        void wakeSleepingThreads(GameSimulation& simulation);
+
+        /**
+         * Runs the scripts of the given units, spread across the thread pool.
+         * The ids must be in ascending order, as simulation.units iterates them.
+         *
+         * While the scripts run each unit only touches its own state.
+         * The effects they have on anything else are appended to commands
+         * in ascending unit order, for the caller to apply afterwards.
+         * Each unit draws random numbers from its own generator,
+         * seeded from the simulation's generator and the unit's id,
+         * so the outcome doesn't depend on how the units were divided between threads.
+         *
+         * Returns the number of cob instructions executed.
+         */
+        std::uint64_t runUnits(ThreadPool& threadPool, GameSimulation& simulation, const std::vector<UnitId>& unitIds, std::vector<CobUnitCommand>& commands);
+
+        /**
+         * Runs the unit's scripts on the calling thread
+         * and applies their effects immediately through the driver.
+         * Random numbers come from the simulation's generator.
+         */
+        std::uint64_t run(SimulationDriver& driver, GameSimulation& simulation, UnitId unitId);
+
+        /**
+         * Runs the unit's ready cob threads until they block or finish.
+         * Units with nothing ready to run and nothing that might unblock
+         * are skipped without looking at their threads.
+         * Effects outside the unit are recorded into buffer.
+         * Returns the number of cob instructions executed.
+         */
+        std::uint64_t run(GameSimulation& simulation, UnitId unitId, std::minstd_rand& rng, CobCommandBuffer& buffer);
     };
 }
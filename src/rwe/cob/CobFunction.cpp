@@ -2,12 +2,8 @@
 
 namespace rwe
 {
-    CobFunction::CobFunction(unsigned int instructionIndex, const std::vector<int>& locals)
-        : instructionIndex(instructionIndex), locals(locals)
-    {
-    }
-
-    CobFunction::CobFunction(unsigned int instructionIndex) : instructionIndex(instructionIndex)
+    CobFunction::CobFunction(unsigned int instructionIndex, unsigned int localsStart)
+        : instructionIndex(instructionIndex), localsStart(localsStart)
     {
     }
 }
@@ -1,19 +1,22 @@
 #pragma once
 
-#include <vector>
-
 namespace rwe
 {
+    /**
+     * A frame on a cob thread's call stack.
+     * The frame's locals live in the thread's locals stack,
+     * starting at localsStart and running up to the start of the next frame's.
+     */
     class CobFunction
     {
     public:
-        unsigned int instructionIndex;
-        std::vector<int> locals;
+        unsigned int instructionIndex{0};
+        unsigned int localsStart{0};
         unsigned int localCount{0};
 
     public:
-        CobFunction(unsigned int instructionIndex, const std::vector<int>& locals);
+        CobFunction() = default;
 
-        explicit CobFunction(unsigned int instructionIndex);
+        CobFunction(unsigned int instructionIndex, unsigned int localsStart);
     };
 }
@@ -0,0 +1,15 @@
+#include "CobFunctionProfile.h"
+
+namespace rwe
+{
+    CobFunctionProfile& CobFunctionProfile::operator+=(const CobFunctionProfile& rhs)
+    {
+        instructions += rhs.instructions;
+        runs += rhs.runs;
+        threadsCreated += rhs.threadsCreated;
+        blockedPolls += rhs.blockedPolls;
+        signalsSent += rhs.signalsSent;
+        time += rhs.time;
+        return *this;
+    }
+}
@@ -0,0 +1,32 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+
+namespace rwe
+{
+    /**
+     * What one cob function cost while profiling was enabled.
+     * Work done by a thread is counted against the function the thread started in,
+     * including any functions it called.
+     */
+    struct CobFunctionProfile
+    {
+        std::uint64_t instructions{0};
+
+        /** Number of times a thread was resumed. */
+        std::uint64_t runs{0};
+
+        std::uint64_t threadsCreated{0};
+
+        /** Number of times a blocked thread was checked to see whether it could continue. */
+        std::uint64_t blockedPolls{0};
+
+        std::uint64_t signalsSent{0};
+
+        /** Wall time spent executing threads. */
+        std::chrono::nanoseconds time{0};
+
+        CobFunctionProfile& operator+=(const CobFunctionProfile& rhs);
+    };
+}
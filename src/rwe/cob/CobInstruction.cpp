@@ -0,0 +1,301 @@
+#include "CobInstruction.h"
+#include <optional>
+#include <rwe/cob/CobOpCode.h>
+
+namespace rwe
+{
+    class CobDecoder
+    {
+    private:
+        const std::vector<std::uint32_t>& code;
+
+    public:
+        explicit CobDecoder(const std::vector<std::uint32_t>& code) : code(code)
+        {
+        }
+
+        CobInstruction decodeAt(std::uint32_t address) const
+        {
+            auto fused = decodeFusedAt(address);
+            if (fused)
+            {
+                return *fused;
+            }
+
+            return decodeSingleAt(address);
+        }
+
+    private:
+        std::uint32_t endAddress() const
+        {
+            return static_cast<std::uint32_t>(code.size());
+        }
+
+        bool hasWords(std::uint32_t address, std::uint32_t count) const
+        {
+            return address <= code.size() && count <= code.size() - address;
+        }
+
+        std::uint32_t jumpTarget(std::uint32_t target) const
+        {
+            return target < code.size() ? target : endAddress();
+        }
+
+        static CobInstruction make(CobOp op, std::uint32_t address, std::uint32_t length, std::uint32_t a = 0, std::uint32_t b = 0)
+        {
+            return CobInstruction{op, 1, address + length, a, b};
+        }
+
+        CobInstruction decodeSingleAt(std::uint32_t address) const
+        {
+            if (!hasWords(address, 1))
+            {
+                return make(CobOp::EndOfCode, address, 0);
+            }
+
+            auto opCode = code[address];
+            switch (static_cast<OpCode>(opCode))
+            {
+                case OpCode::MOVE:
+                    return withPieceOperands(CobOp::Move, address);
+                case OpCode::TURN:
+                    return withPieceOperands(CobOp::Turn, address);
+                case OpCode::SPIN:
+                    return withPieceOperands(CobOp::Spin, address);
+                case OpCode::STOP_SPIN:
+                    return withPieceOperands(CobOp::StopSpin, address);
+                case OpCode::MOVE_NOW:
+                    return withPieceOperands(CobOp::MoveNow, address);
+                case OpCode::TURN_NOW:
+                    return withPieceOperands(CobOp::TurnNow, address);
+                case OpCode::WAIT_FOR_TURN:
+                    return withPieceOperands(CobOp::WaitForTurn, address);
+                case OpCode::WAIT_FOR_MOVE:
+                    return withPieceOperands(CobOp::WaitForMove, address);
+
+                case OpCode::SHOW:
+                    return withOperands(CobOp::Show, address, 1);
+                case OpCode::HIDE:
+                    return withOperands(CobOp::Hide, address, 1);
+                case OpCode::CACHE:
+                    return withOperands(CobOp::Cache, address, 1);
+                case OpCode::DONT_CACHE:
+                    return withOperands(CobOp::DontCache, address, 1);
+                case OpCode::SHADE:
+                    return withOperands(CobOp::Shade, address, 1);
+                case OpCode::DONT_SHADE:
+                    return withOperands(CobOp::DontShade, address, 1);
+                case OpCode::EMIT_SFX:
+                    return withOperands(CobOp::EmitSfx, address, 1);
+                case OpCode::EXPLODE:
+                    return withOperands(CobOp::Explode, address, 1);
+
+                case OpCode::SLEEP:
+                    return make(CobOp::Sleep, address, 1);
+
+                case OpCode::PUSH_CONSTANT:
+                    return withOperands(CobOp::PushConstant, address, 1);
+                case OpCode::PUSH_LOCAL_VAR:
+                    return withOperands(CobOp::PushLocalVar, address, 1);
+                case OpCode::PUSH_STATIC:
+                    return withOperands(CobOp::PushStatic, address, 1);
+                case OpCode::CREATE_LOCAL_VAR:
+                    return make(CobOp::CreateLocalVar, address, 1);
+                case OpCode::POP_LOCAL_VAR:
+                    return withOperands(CobOp::PopLocalVar, address, 1);
+                case OpCode::POP_STATIC:
+                    return withOperands(CobOp::PopStatic, address, 1);
+                case OpCode::POP_STACK:
+                    return make(CobOp::PopStack, address, 1);
+
+                case OpCode::ADD:
+                    return make(CobOp::Add, address, 1);
+                case OpCode::SUB:
+                    return make(CobOp::Sub, address, 1);
+                case OpCode::MUL:
+                    return make(CobOp::Mul, address, 1);
+                case OpCode::DIV:
+                    return make(CobOp::Div, address, 1);
+
+                case OpCode::BITWISE_AND:
+                    return make(CobOp::BitwiseAnd, address, 1);
+                case OpCode::BITWISE_OR:
+                    return make(CobOp::BitwiseOr, address, 1);
+                case OpCode::BITWISE_XOR:
+                    return make(CobOp::BitwiseXor, address, 1);
+                case OpCode::BITWISE_NOT:
+                    return make(CobOp::BitwiseNot, address, 1);
+
+                case OpCode::RAND:
+                    return make(CobOp::Rand, address, 1);
+                case OpCode::GET_VALUE:
+                    return make(CobOp::GetValue, address, 1);
+                case OpCode::GET_VALUE_WITH_ARGS:
+                    return make(CobOp::GetValueWithArgs, address, 1);
+                case OpCode::SET_VALUE:
+                    return make(CobOp::SetValue, address, 1);
+
+                case OpCode::SET_LESS:
+                    return make(CobOp::SetLess, address, 1);
+                case OpCode::SET_LESS_OR_EQUAL:
+                    return make(CobOp::SetLessOrEqual, address, 1);
+                case OpCode::SET_GREATER:
+                    return make(CobOp::SetGreater, address, 1);
+                case OpCode::SET_GREATER_OR_EQUAL:
+                    return make(CobOp::SetGreaterOrEqual, address, 1);
+                case OpCode::SET_EQUAL:
+                    return make(CobOp::SetEqual, address, 1);
+                case OpCode::SET_NOT_EQUAL:
+                    return make(CobOp::SetNotEqual, address, 1);
+                case OpCode::LOGICAL_AND:
+                    return make(CobOp::LogicalAnd, address, 1);
+                case OpCode::LOGICAL_OR:
+                    return make(CobOp::LogicalOr, address, 1);
+                case OpCode::LOGICAL_XOR:
+                    return make(CobOp::LogicalXor, address, 1);
+                case OpCode::LOGICAL_NOT:
+                    return make(CobOp::LogicalNot, address, 1);
+
+                case OpCode::START_SCRIPT:
+                    return withOperands(CobOp::StartScript, address, 2);
+                case OpCode::CALL_SCRIPT:
+                    return withOperands(CobOp::CallScript, address, 2);
+                case OpCode::JUMP:
+                    return withJumpTarget(CobOp::Jump, address);
+                case OpCode::RETURN:
+                    return make(CobOp::Return, address, 1);
+                case OpCode::JUMP_IF_ZERO:
+                    return withJumpTarget(CobOp::JumpIfZero, address);
+                case OpCode::SIGNAL:
+                    return make(CobOp::Signal, address, 1);
+                case OpCode::SET_SIGNAL_MASK:
+                    return make(CobOp::SetSignalMask, address, 1);
+
+                case OpCode::ATTACH_UNIT:
+                    return make(CobOp::AttachUnit, address, 1);
+                case OpCode::DROP_UNIT:
+                    return make(CobOp::DropUnit, address, 1);
+
+                default:
+                    return make(CobOp::Unsupported, address, 1, opCode);
+            }
+        }
+
+        CobInstruction withOperands(CobOp op, std::uint32_t address, std::uint32_t operandCount) const
+        {
+            if (!hasWords(address, 1 + operandCount))
+            {
+                return make(CobOp::EndOfCode, address, 0);
+            }
+
+            auto a = operandCount >= 1 ? code[address + 1] : 0;
+            auto b = operandCount >= 2 ? code[address + 2] : 0;
+            return make(op, address, 1 + operandCount, a, b);
+        }
+
+        CobInstruction withPieceOperands(CobOp op, std::uint32_t address) const
+        {
+            auto instruction = withOperands(op, address, 2);
+            if (instruction.op != CobOp::EndOfCode && instruction.b > 2)
+            {
+                return make(CobOp::InvalidAxis, address, 3, instruction.b);
+            }
+
+            return instruction;
+        }
+
+        CobInstruction withJumpTarget(CobOp op, std::uint32_t address) const
+        {
+            auto instruction = withOperands(op, address, 1);
+            instruction.a = jumpTarget(instruction.a);
+            return instruction;
+        }
+
+        static std::optional<CobOp> getFusedComparison(std::uint32_t opCode, bool withConstant)
+        {
+            switch (static_cast<OpCode>(opCode))
+            {
+                case OpCode::SET_LESS:
+                    return withConstant ? CobOp::JumpUnlessLessConstant : CobOp::JumpUnlessLess;
+                case OpCode::SET_LESS_OR_EQUAL:
+                    return withConstant ? CobOp::JumpUnlessLessOrEqualConstant : CobOp::JumpUnlessLessOrEqual;
+                case OpCode::SET_GREATER:
+                    return withConstant ? CobOp::JumpUnlessGreaterConstant : CobOp::JumpUnlessGreater;
+                case OpCode::SET_GREATER_OR_EQUAL:
+                    return withConstant ? CobOp::JumpUnlessGreaterOrEqualConstant : CobOp::JumpUnlessGreaterOrEqual;
+                case OpCode::SET_EQUAL:
+                    return withConstant ? CobOp::JumpUnlessEqualConstant : CobOp::JumpUnlessEqual;
+                case OpCode::SET_NOT_EQUAL:
+                    return withConstant ? CobOp::JumpUnlessNotEqualConstant : CobOp::JumpUnlessNotEqual;
+                default:
+                    return std::nullopt;
+            }
+        }
+
+        bool isJumpIfZeroAt(std::uint32_t address) const
+        {
+            return hasWords(address, 2) && static_cast<OpCode>(code[address]) == OpCode::JUMP_IF_ZERO;
+        }
+
+        /**
+         * Recognises the sequences that conditionals compile to.
+         * Only instructions that can't block or call out are fused,
+         * so a thread can never be suspended partway through one.
+         */
+        std::optional<CobInstruction> decodeFusedAt(std::uint32_t address) const
+        {
+            if (!hasWords(address, 1))
+            {
+                return std::nullopt;
+            }
+
+            auto opCode = static_cast<OpCode>(code[address]);
+
+            // compare, JUMP_IF_ZERO
+            if (auto op = getFusedComparison(code[address], false); op && isJumpIfZeroAt(address + 1))
+            {
+                auto target = jumpTarget(code[address + 2]);
+                return CobInstruction{*op, 2, address + 3, target, 0};
+            }
+
+            if (opCode == OpCode::PUSH_CONSTANT && hasWords(address, 2))
+            {
+                auto constant = code[address + 1];
+
+                // PUSH_CONSTANT, JUMP_IF_ZERO, as in while (TRUE).
+                // The branch is decided here and becomes an unconditional jump.
+                if (isJumpIfZeroAt(address + 2))
+                {
+                    auto target = constant == 0 ? jumpTarget(code[address + 3]) : address + 4;
+                    return CobInstruction{CobOp::Jump, 2, address + 4, target, 0};
+                }
+
+                // PUSH_CONSTANT, compare, JUMP_IF_ZERO
+                if (hasWords(address + 2, 1))
+                {
+                    if (auto op = getFusedComparison(code[address + 2], true); op && isJumpIfZeroAt(address + 3))
+                    {
+                        auto target = jumpTarget(code[address + 4]);
+                        return CobInstruction{*op, 3, address + 5, constant, target};
+                    }
+                }
+            }
+
+            return std::nullopt;
+        }
+    };
+
+    std::vector<CobInstruction> decodeCobInstructions(const std::vector<std::uint32_t>& instructions)
+    {
+        CobDecoder decoder(instructions);
+
+        std::vector<CobInstruction> decoded;
+        decoded.reserve(instructions.size() + 1);
+        for (std::uint32_t address = 0; address <= instructions.size(); ++address)
+        {
+            decoded.push_back(decoder.decodeAt(address));
+        }
+
+        return decoded;
+    }
+}
@@ -0,0 +1,154 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+namespace rwe
+{
+    /**
+     * The operation of a decoded cob instruction.
+     * Most correspond one-to-one with an OpCode.
+     * The rest are fused forms of common sequences of opcodes,
+     * or stand in for code that cannot be run.
+     *
+     * CobExecutionContext keeps a dispatch table in the same order,
+     * so new values must be added there too.
+     */
+    enum class CobOp : std::uint8_t
+    {
+        /** The opcode was not recognised. a is the opcode. */
+        Unsupported,
+        /** The instruction, or one of its operands, lies beyond the end of the code. */
+        EndOfCode,
+        /** A piece instruction had an axis operand other than 0, 1 or 2. a is the axis. */
+        InvalidAxis,
+
+        Move,
+        Turn,
+        Spin,
+        StopSpin,
+        Show,
+        Hide,
+        Cache,
+        DontCache,
+        MoveNow,
+        TurnNow,
+        Shade,
+        DontShade,
+        EmitSfx,
+
+        WaitForTurn,
+        WaitForMove,
+        Sleep,
+
+        PushConstant,
+        PushLocalVar,
+        PushStatic,
+        CreateLocalVar,
+        PopLocalVar,
+        PopStatic,
+        PopStack,
+
+        Add,
+        Sub,
+        Mul,
+        Div,
+
+        BitwiseAnd,
+        BitwiseOr,
+        BitwiseXor,
+        BitwiseNot,
+
+        Rand,
+        GetValue,
+        GetValueWithArgs,
+        SetValue,
+
+        SetLess,
+        SetLessOrEqual,
+        SetGreater,
+        SetGreaterOrEqual,
+        SetEqual,
+        SetNotEqual,
+        LogicalAnd,
+        LogicalOr,
+        LogicalXor,
+        LogicalNot,
+
+        StartScript,
+        CallScript,
+        Jump,
+        Return,
+        JumpIfZero,
+        Signal,
+        SetSignalMask,
+
+        Explode,
+
+        AttachUnit,
+        DropUnit,
+
+        /**
+         * A comparison immediately followed by JUMP_IF_ZERO.
+         * Pops two values and jumps to a if the comparison is false.
+         */
+        JumpUnlessLess,
+        JumpUnlessLessOrEqual,
+        JumpUnlessGreater,
+        JumpUnlessGreaterOrEqual,
+        JumpUnlessEqual,
+        JumpUnlessNotEqual,
+
+        /**
+         * PUSH_CONSTANT, then a comparison, then JUMP_IF_ZERO.
+         * Pops one value, compares it with the constant a
+         * and jumps to b if the comparison is false.
+         */
+        JumpUnlessLessConstant,
+        JumpUnlessLessOrEqualConstant,
+        JumpUnlessGreaterConstant,
+        JumpUnlessGreaterOrEqualConstant,
+        JumpUnlessEqualConstant,
+        JumpUnlessNotEqualConstant,
+    };
+
+    static constexpr unsigned int CobOpCount = static_cast<unsigned int>(CobOp::JumpUnlessNotEqualConstant) + 1;
+
+    /**
+     * A cob instruction with its operands already read out of the code
+     * and its jump target already checked.
+     *
+     * Decoded instructions are indexed by the address of the raw instruction
+     * they were decoded from, so a thread's instruction index
+     * means the same thing in both forms.
+     */
+    struct CobInstruction
+    {
+        CobOp op;
+
+        /** The number of raw instructions this stands for. */
+        std::uint8_t sourceInstructionCount;
+
+        /** The address of the instruction that follows this one. */
+        std::uint32_t next;
+
+        /**
+         * Operands. For piece instructions these are the piece and axis,
+         * for CALL_SCRIPT and START_SCRIPT the function and parameter count,
+         * for jumps a is the target and for variable access a is the variable.
+         */
+        std::uint32_t a;
+        std::uint32_t b;
+    };
+
+    /**
+     * Decodes cob code ahead of time.
+     *
+     * The result has one entry for every address in the code,
+     * as jumps may in principle land on any of them,
+     * followed by an EndOfCode entry at the address one past the end.
+     * Jumps to anywhere outside the code are redirected to that entry,
+     * so the interpreter never has to check an address.
+     */
+    std::vector<CobInstruction> decodeCobInstructions(const std::vector<std::uint32_t>& instructions);
+}
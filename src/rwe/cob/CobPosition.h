@@ -27,7 +27,7 @@ namespace rwe
 
         static CobPosition fromWorldDistance(SimScalar d)
         {
-            return CobPosition(d.value * 65536.0f);
+            return CobPosition(simScalarToFixed(d));
         }
     };
 }
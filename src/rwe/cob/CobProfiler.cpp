@@ -0,0 +1,124 @@
+#include "CobProfiler.h"
+#include <algorithm>
+#include <cassert>
+#include <fstream>
+#include <rwe/rwe_string.h>
+#include <rwe/cob/CobEnvironment.h>
+#include <tuple>
+
+namespace rwe
+{
+    void CobProfiler::collect(const std::string& unitType, CobEnvironment& env)
+    {
+        if (env.profile.empty())
+        {
+            return;
+        }
+
+        auto& unitTypeProfile = unitTypes[unitType];
+        if (unitTypeProfile.functions.empty())
+        {
+            for (const auto& function : env.script()->functions)
+            {
+                unitTypeProfile.functionNames.push_back(function.name);
+            }
+            unitTypeProfile.functions.resize(env.profile.size());
+        }
+
+        // Units of the same type always share a script.
+        assert(unitTypeProfile.functions.size() == env.profile.size());
+
+        for (std::size_t i = 0; i < env.profile.size(); ++i)
+        {
+            unitTypeProfile.functions[i] += env.profile[i];
+            env.profile[i] = CobFunctionProfile();
+        }
+    }
+
+    void CobProfiler::clear()
+    {
+        unitTypes.clear();
+    }
+
+    std::vector<CobProfiler::Entry> CobProfiler::getEntries() const
+    {
+        std::vector<Entry> entries;
+        for (const auto& [unitType, unitTypeProfile] : unitTypes)
+        {
+            for (std::size_t i = 0; i < unitTypeProfile.functions.size(); ++i)
+            {
+                const auto& profile = unitTypeProfile.functions[i];
+                if (profile.runs == 0 && profile.threadsCreated == 0 && profile.blockedPolls == 0)
+                {
+                    continue;
+                }
+                entries.push_back(Entry{unitType, unitTypeProfile.functionNames[i], profile});
+            }
+        }
+
+        // ties are broken by name so that dumps are stable
+        std::sort(entries.begin(), entries.end(), [](const auto& a, const auto& b) {
+            if (a.profile.time != b.profile.time)
+            {
+                return a.profile.time > b.profile.time;
+            }
+            return std::tie(a.unitType, a.functionName) < std::tie(b.unitType, b.functionName);
+        });
+
+        return entries;
+    }
+
+    void writeCobProfileCsv(std::ostream& os, const std::vector<CobProfiler::Entry>& entries)
+    {
+        os << "unitType,function,timeNs,instructions,runs,threadsCreated,blockedPolls,signalsSent\n";
+        for (const auto& e : entries)
+        {
+            // unit type and function names are plain identifiers, so need no quoting
+            os << e.unitType << ','
+               << e.functionName << ','
+               << e.profile.time.count() << ','
+               << e.profile.instructions << ','
+               << e.profile.runs << ','
+               << e.profile.threadsCreated << ','
+               << e.profile.blockedPolls << ','
+               << e.profile.signalsSent << '\n';
+        }
+    }
+
+    nlohmann::json dumpJson(const std::vector<CobProfiler::Entry>& entries)
+    {
+        auto j = nlohmann::json::array();
+        for (const auto& e : entries)
+        {
+            j.push_back(nlohmann::json{
+                {"unitType", e.unitType},
+                {"function", e.functionName},
+                {"timeNs", e.profile.time.count()},
+                {"instructions", e.profile.instructions},
+                {"runs", e.profile.runs},
+                {"threadsCreated", e.profile.threadsCreated},
+                {"blockedPolls", e.profile.blockedPolls},
+                {"signalsSent", e.profile.signalsSent},
+            });
+        }
+        return j;
+    }
+
+    void saveCobProfile(const std::string& path, const std::vector<CobProfiler::Entry>& entries)
+    {
+        std::ofstream os(path);
+        if (!os.is_open())
+        {
+            throw std::runtime_error("Failed to open cob profile file " + path);
+        }
+
+        if (endsWith(toUpper(path), ".JSON"))
+        {
+            os << dumpJson(entries).dump(2) << '\n';
+        }
+        else
+        {
+            writeCobProfileCsv(os, entries);
+        }
+    }
+}
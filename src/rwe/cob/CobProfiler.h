@@ -0,0 +1,59 @@
+#pragma once
+
+#include <nlohmann/json.hpp>
+#include <ostream>
+#include <rwe/cob/CobFunctionProfile.h>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace rwe
+{
+    class CobEnvironment;
+
+    /**
+     * Totals the profiles of every unit's cob functions by unit type,
+     * to find the scripts that take up the most of the tick.
+     */
+    class CobProfiler
+    {
+    public:
+        struct Entry
+        {
+            std::string unitType;
+            std::string functionName;
+            CobFunctionProfile profile;
+        };
+
+    private:
+        struct UnitTypeProfile
+        {
+            std::vector<std::string> functionNames;
+
+            /** Indexed by function id. */
+            std::vector<CobFunctionProfile> functions;
+        };
+
+        std::unordered_map<std::string, UnitTypeProfile> unitTypes;
+
+    public:
+        /**
+         * Adds the environment's counters to the totals for the unit type
+         * and zeroes them, so that they are not counted again.
+         * Does nothing if the environment is not being profiled.
+         */
+        void collect(const std::string& unitType, CobEnvironment& env);
+
+        void clear();
+
+        /** Returns the totals for every function that has done anything, the most time first. */
+        std::vector<Entry> getEntries() const;
+    };
+
+    void writeCobProfileCsv(std::ostream& os, const std::vector<CobProfiler::Entry>& entries);
+
+    nlohmann::json dumpJson(const std::vector<CobProfiler::Entry>& entries);
+
+    /** Writes the entries to the file as JSON if the path ends in .json, otherwise as CSV. */
+    void saveCobProfile(const std::string& path, const std::vector<CobProfiler::Entry>& entries);
+}
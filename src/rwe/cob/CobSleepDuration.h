@@ -2,7 +2,6 @@
 
 #include <rwe/GameTime.h>
 #include <rwe/OpaqueId.h>
-#include <rwe/SceneManager.h>
 
 namespace rwe
 {
@@ -14,7 +13,7 @@ namespace rwe
 
         GameTime toGameTime() const
         {
-            return GameTime(value / SceneManager::TickInterval);
+            return GameTime(value / TickInterval);
         }
     };
 }
@@ -0,0 +1,85 @@
+#pragma once
+
+#include <array>
+#include <cassert>
+#include <stdexcept>
+#include <string>
+
+namespace rwe
+{
+    /**
+     * A stack with a fixed capacity whose elements are stored inline,
+     * so that pushing and popping never allocate.
+     * Pushing beyond the capacity throws,
+     * so callers that can recover check full() first.
+     * Elements are indexed from the bottom of the stack.
+     */
+    template <typename T, unsigned int Capacity>
+    class CobStack
+    {
+    private:
+        std::array<T, Capacity> items;
+        unsigned int count{0};
+
+    public:
+        static constexpr unsigned int capacity() { return Capacity; }
+
+        unsigned int size() const { return count; }
+
+        bool empty() const { return count == 0; }
+
+        bool full() const { return count == Capacity; }
+
+        void push(const T& item)
+        {
+            if (count == Capacity)
+            {
+                throw std::runtime_error("Cob stack capacity of " + std::to_string(Capacity) + " exceeded");
+            }
+            items[count++] = item;
+        }
+
+        void pop()
+        {
+            assert(count > 0);
+            --count;
+        }
+
+        T& top()
+        {
+            assert(count > 0);
+            return items[count - 1];
+        }
+
+        const T& top() const
+        {
+            assert(count > 0);
+            return items[count - 1];
+        }
+
+        T& operator[](unsigned int i)
+        {
+            assert(i < count);
+            return items[i];
+        }
+
+        const T& operator[](unsigned int i) const
+        {
+            assert(i < count);
+            return items[i];
+        }
+
+        /** Pops elements until the stack is the given size. */
+        void truncate(unsigned int newSize)
+        {
+            assert(newSize <= count);
+            count = newSize;
+        }
+
+        void clear() { count = 0; }
+
+        const T* begin() const { return items.data(); }
+
+        const T* end() const { return items.data() + count; }
+    };
+}
@@ -1,12 +1,67 @@
 #include "CobThread.h"
+#include <cassert>
 
 namespace rwe
 {
-    CobThread::CobThread(const std::string& name, unsigned int signalMask) : name(name), signalMask(signalMask)
+    bool CobThreadHandle::isCurrent() const
     {
+        return thread != nullptr && thread->generation == generation;
     }
 
-    CobThread::CobThread(const std::string& name) : name(name)
+    CobThread::CobThread(unsigned int functionId, unsigned int signalMask) : functionId(functionId), signalMask(signalMask)
     {
     }
+
+    CobThread::CobThread(unsigned int functionId) : functionId(functionId)
+    {
+    }
+
+    void CobThread::reset(unsigned int newFunctionId, unsigned int newSignalMask)
+    {
+        assert(queueLink.list == nullptr && signalGroupLink.list == nullptr);
+
+        functionId = newFunctionId;
+        signalMask = newSignalMask;
+        stack.clear();
+        callStack.clear();
+        locals.clear();
+        returnValue = 0;
+        // keeps its capacity for the next function to use
+        returnLocals.clear();
+        blockedCondition = std::nullopt;
+    }
+
+    CobThreadHandle CobThread::getHandle() const
+    {
+        return CobThreadHandle{this, generation};
+    }
+
+    void CobThread::pushFrame(unsigned int instructionIndex, const std::vector<int>& params)
+    {
+        callStack.push(CobFunction(instructionIndex, locals.size()));
+        for (auto p : params)
+        {
+            locals.push(p);
+        }
+    }
+
+    void CobThread::pushFrame(unsigned int instructionIndex, std::initializer_list<int> params)
+    {
+        callStack.push(CobFunction(instructionIndex, locals.size()));
+        for (auto p : params)
+        {
+            locals.push(p);
+        }
+    }
+
+    void CobThread::popFrame()
+    {
+        locals.truncate(callStack.top().localsStart);
+        callStack.pop();
+    }
+
+    unsigned int CobThread::getLocalsEnd(unsigned int frameIndex) const
+    {
+        return frameIndex + 1 < callStack.size() ? callStack[frameIndex + 1].localsStart : locals.size();
+    }
 }
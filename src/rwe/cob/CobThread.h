@@ -1,25 +1,68 @@
 #pragma once
 
+#include <initializer_list>
+#include <optional>
+#include <rwe/cob/CobBlockedStatus.h>
 #include <rwe/cob/CobFunction.h>
-#include <rwe/util.h>
-#include <stack>
-#include <variant>
+#include <rwe/cob/CobStack.h>
 #include <vector>
 
 namespace rwe
 {
+    class CobThread;
+
+    /** A thread's place in an intrusive list of threads. See CobThreadList. */
+    struct CobThreadLink
+    {
+        CobThread* previous{nullptr};
+        CobThread* next{nullptr};
+
+        /** The list the thread is in, or null if it is not in one. */
+        const void* list{nullptr};
+    };
+
+    /**
+     * Refers to a thread started by a CobEnvironment.
+     * The environment reuses threads once they are deleted,
+     * so the handle also records the thread's generation
+     * to tell whether the thread has been deleted since.
+     */
+    struct CobThreadHandle
+    {
+        const CobThread* thread{nullptr};
+        unsigned int generation{0};
+
+        /** Returns true if the handle refers to a thread that has not been deleted since. */
+        bool isCurrent() const;
+    };
+
     class CobThread
     {
     public:
-        std::string name;
+        /*
+         * The stacks are stored inline so that running a thread never allocates.
+         * A script only keeps the operands of the expression it is evaluating on the value stack,
+         * declares a handful of locals per function and nests calls a few levels deep,
+         * so these limits leave plenty of headroom for working scripts.
+         * A thread that reaches one is stuck in a runaway loop or recursion and is ended.
+         */
+        static constexpr unsigned int MaxStackSize = 256;
+        static constexpr unsigned int MaxLocals = 256;
+        static constexpr unsigned int MaxCallDepth = 32;
 
-        std::stack<int> stack;
+        /** Index into the script's functions of the function the thread started in. */
+        unsigned int functionId;
+
+        CobStack<int, MaxStackSize> stack;
 
         unsigned int signalMask{0};
 
-        std::stack<CobFunction> callStack;
+        CobStack<CobFunction, MaxCallDepth> callStack;
+
+        /** The locals of every function in the call stack, outermost first. */
+        CobStack<int, MaxLocals> locals;
 
-        int returnValue;
+        int returnValue{0};
 
         /**
          * Required for query functions, which communicate back to the engine
@@ -27,9 +70,44 @@ namespace rwe
          */
         std::vector<int> returnLocals;
 
+        /** What the thread is waiting for, while it is blocked. */
+        std::optional<CobBlockedStatus::Condition> blockedCondition;
+
+        /** Links the thread into its environment's ready, blocked or finished queue, or its free list. */
+        CobThreadLink queueLink;
+
+        /** Links the thread into the group of its environment's threads with the same signal mask. */
+        CobThreadLink signalGroupLink;
+
+        /** Incremented each time the environment deletes the thread. */
+        unsigned int generation{0};
+
     public:
-        CobThread(const std::string& name, unsigned int signalMask);
+        CobThread(unsigned int functionId, unsigned int signalMask);
+
+        explicit CobThread(unsigned int functionId);
+
+        /**
+         * Puts the thread back into the state it was constructed in,
+         * so that it can be reused for a new function.
+         * The thread must not be in any list.
+         */
+        void reset(unsigned int functionId, unsigned int signalMask);
+
+        CobThreadHandle getHandle() const;
+
+        /**
+         * Pushes a new frame onto the call stack
+         * whose locals are initially the given parameters.
+         */
+        void pushFrame(unsigned int instructionIndex, const std::vector<int>& params);
+
+        void pushFrame(unsigned int instructionIndex, std::initializer_list<int> params);
+
+        /** Pops the top frame off the call stack, along with its locals. */
+        void popFrame();
 
-        explicit CobThread(const std::string& name);
+        /** Returns the index in locals one past the last local of the given frame. */
+        unsigned int getLocalsEnd(unsigned int frameIndex) const;
     };
 }
@@ -0,0 +1,152 @@
+#pragma once
+
+#include <cassert>
+#include <rwe/cob/CobThread.h>
+
+namespace rwe
+{
+    /**
+     * A doubly linked list of cob threads
+     * that keeps its links inside the threads themselves,
+     * so adding and removing threads never allocates
+     * and any thread can be removed in constant time.
+     *
+     * Link selects which of the thread's links the list uses.
+     * A thread can be in only one list per link at a time.
+     * Threads refer back to the list they are in,
+     * so lists cannot be copied or moved.
+     */
+    template <CobThreadLink CobThread::*Link>
+    class CobThreadList
+    {
+    public:
+        class Iterator
+        {
+        private:
+            CobThread* thread;
+
+        public:
+            explicit Iterator(CobThread* thread) : thread(thread) {}
+
+            CobThread* operator*() const { return thread; }
+
+            Iterator& operator++()
+            {
+                thread = (thread->*Link).next;
+                return *this;
+            }
+
+            bool operator==(const Iterator& rhs) const { return thread == rhs.thread; }
+
+            bool operator!=(const Iterator& rhs) const { return thread != rhs.thread; }
+        };
+
+    private:
+        CobThread* head{nullptr};
+        CobThread* tail{nullptr};
+        unsigned int count{0};
+
+    public:
+        CobThreadList() = default;
+
+        CobThreadList(const CobThreadList&) = delete;
+        CobThreadList& operator=(const CobThreadList&) = delete;
+        CobThreadList(CobThreadList&&) = delete;
+        CobThreadList& operator=(CobThreadList&&) = delete;
+
+        bool empty() const { return count == 0; }
+
+        unsigned int size() const { return count; }
+
+        CobThread* front() const
+        {
+            assert(count > 0);
+            return head;
+        }
+
+        bool contains(const CobThread* thread) const { return (thread->*Link).list == this; }
+
+        void push_back(CobThread* thread)
+        {
+            auto& link = thread->*Link;
+            assert(link.list == nullptr);
+            link.list = this;
+            link.previous = tail;
+            link.next = nullptr;
+            if (tail != nullptr)
+            {
+                (tail->*Link).next = thread;
+            }
+            else
+            {
+                head = thread;
+            }
+            tail = thread;
+            ++count;
+        }
+
+        void push_front(CobThread* thread)
+        {
+            auto& link = thread->*Link;
+            assert(link.list == nullptr);
+            link.list = this;
+            link.previous = nullptr;
+            link.next = head;
+            if (head != nullptr)
+            {
+                (head->*Link).previous = thread;
+            }
+            else
+            {
+                tail = thread;
+            }
+            head = thread;
+            ++count;
+        }
+
+        void pop_front()
+        {
+            remove(front());
+        }
+
+        void remove(CobThread* thread)
+        {
+            auto& link = thread->*Link;
+            assert(link.list == this);
+            if (link.previous != nullptr)
+            {
+                (link.previous->*Link).next = link.next;
+            }
+            else
+            {
+                head = link.next;
+            }
+            if (link.next != nullptr)
+            {
+                (link.next->*Link).previous = link.previous;
+            }
+            else
+            {
+                tail = link.previous;
+            }
+            link = CobThreadLink();
+            --count;
+        }
+
+        /** Removes the thread at the iterator and returns an iterator to the one after it. */
+        Iterator erase(Iterator it)
+        {
+            auto thread = *it;
+            ++it;
+            remove(thread);
+            return it;
+        }
+
+        Iterator begin() const { return Iterator(head); }
+
+        Iterator end() const { return Iterator(nullptr); }
+    };
+
+    /** A list of threads linked through CobThread::queueLink. */
+    using CobThreadQueue = CobThreadList<&CobThread::queueLink>;
+}
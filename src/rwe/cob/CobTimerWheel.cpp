@@ -0,0 +1,63 @@
+#include "CobTimerWheel.h"
+#include <algorithm>
+
+namespace rwe
+{
+    void CobTimerWheel::schedule(UnitId unitId, GameTime wakeUpTime)
+    {
+        auto slotTime = wakeUpTime > currentTime ? wakeUpTime : currentTime + GameTime(1);
+        slots[slotTime.value % SlotCount].push_back(Entry{wakeUpTime, unitId});
+    }
+
+    void CobTimerWheel::advance(GameTime time, std::vector<UnitId>& dueUnits)
+    {
+        if (time <= currentTime)
+        {
+            return;
+        }
+
+        // after a full turn every slot has been visited,
+        // so there is no point going round again
+        auto ticks = std::min(time.value - currentTime.value, SlotCount);
+        for (unsigned int i = 1; i <= ticks; ++i)
+        {
+            auto& slot = slots[(currentTime.value + i) % SlotCount];
+            for (std::size_t j = 0; j < slot.size();)
+            {
+                if (slot[j].wakeUpTime <= time)
+                {
+                    dueUnits.push_back(slot[j].unitId);
+                    slot[j] = slot.back();
+                    slot.pop_back();
+                }
+                else
+                {
+                    ++j;
+                }
+            }
+        }
+
+        currentTime = time;
+    }
+
+    void CobTimerWheel::reset(GameTime time)
+    {
+        for (auto& slot : slots)
+        {
+            slot.clear();
+        }
+
+        currentTime = time;
+    }
+
+    std::size_t CobTimerWheel::size() const
+    {
+        std::size_t total = 0;
+        for (const auto& slot : slots)
+        {
+            total += slot.size();
+        }
+
+        return total;
+    }
+}
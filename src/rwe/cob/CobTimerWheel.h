@@ -0,0 +1,59 @@
+#pragma once
+
+#include <array>
+#include <rwe/GameTime.h>
+#include <rwe/UnitId.h>
+#include <vector>
+
+namespace rwe
+{
+    /**
+     * Keeps track of when units have sleeping cob threads due to wake up.
+     *
+     * Entries are hashed into a ring of slots by their wake-up time,
+     * so advancing by a tick only has to look at the one slot for that tick.
+     * Entries more than one turn of the ring away stay in their slot
+     * and are passed over until they come due.
+     *
+     * The wheel only says which units might have a thread to wake.
+     * Threads that are killed before they wake leave stale entries behind,
+     * which is harmless as the unit's blocked threads are checked regardless.
+     */
+    class CobTimerWheel
+    {
+    public:
+        static constexpr unsigned int SlotCount = 256;
+
+    private:
+        struct Entry
+        {
+            GameTime wakeUpTime;
+            UnitId unitId;
+        };
+
+        std::array<std::vector<Entry>, SlotCount> slots;
+
+        /** Entries due at or before this time have already been handed out. */
+        GameTime currentTime{0};
+
+    public:
+        /**
+         * Adds an entry for the unit at the given time.
+         * Times that have already passed come due on the next advance.
+         */
+        void schedule(UnitId unitId, GameTime wakeUpTime);
+
+        /**
+         * Advances the wheel to the given time,
+         * appending the unit of every entry that has come due to dueUnits
+         * and removing those entries.
+         * A unit appears once for each of its entries.
+         */
+        void advance(GameTime time, std::vector<UnitId>& dueUnits);
+
+        /** Removes all entries and moves the wheel to the given time. */
+        void reset(GameTime time);
+
+        std::size_t size() const;
+    };
+}
@@ -8,8 +8,8 @@ namespace rwe
 {
     uint32_t packCoords(SimScalar x, SimScalar z)
     {
-        auto intX = static_cast<int16_t>(x.value);
-        auto intZ = static_cast<int16_t>(z.value);
+        auto intX = static_cast<int16_t>(simScalarToInt(x));
+        auto intZ = static_cast<int16_t>(simScalarToInt(z));
         return (static_cast<uint32_t>(intX) << 16) | (static_cast<uint32_t>(intZ) & 0xffff);
     }
 
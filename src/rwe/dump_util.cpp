@@ -18,6 +18,11 @@ namespace rwe
     {
         return i;
     }
+
+    nlohmann::json dumpJson(int64_t i)
+    {
+        return i;
+    }
     nlohmann::json dumpJson(const std::string& s)
     {
         return s;
@@ -86,19 +91,12 @@ namespace rwe
     }
     nlohmann::json dumpJson(const Projectile& projectile)
     {
-        nlohmann::json j{
+        return nlohmann::json{
+            {"weaponType", projectile.weapon->weaponType},
             {"owner", dumpJson(projectile.owner)},
             {"position", dumpJson(projectile.position)},
             {"origin", dumpJson(projectile.origin)},
-            {"velocity", dumpJson(projectile.velocity)},
-            {"damageRadius", dumpJson(projectile.damageRadius)}};
-
-        for (const auto& [t, damage] : projectile.damage)
-        {
-            j["damage"][t] = dumpJson(damage);
-        }
-
-        return j;
+            {"velocity", dumpJson(projectile.velocity)}};
     }
     nlohmann::json dumpJson(const IdleState&)
     {
@@ -17,6 +17,8 @@ namespace rwe
 
     nlohmann::json dumpJson(int32_t i);
 
+    nlohmann::json dumpJson(int64_t i);
+
     nlohmann::json dumpJson(const std::string& s);
 
     nlohmann::json dumpJson(const char* s);
@@ -2,6 +2,9 @@
 
 namespace rwe
 {
+    /** The number of fractional bits in the 16.16 fixed-point values used by TA data files and COB scripts. */
+    constexpr unsigned int FixedPointFractionalBits = 16;
+
     int toFixedPoint(float val);
 
     float fromFixedPoint(int val);
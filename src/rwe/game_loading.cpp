@@ -0,0 +1,437 @@
+#include "game_loading.h"
+#include <algorithm>
+#include <boost/interprocess/streams/bufferstream.hpp>
+#include <cassert>
+#include <iterator>
+#include <rwe/AudioService.h>
+#include <rwe/WeaponTdf.h>
+#include <rwe/tdf.h>
+#include <rwe/tnt/TntArchive.h>
+
+namespace rwe
+{
+    static unsigned int computeMidpointHeight(const Grid<unsigned char>& heightmap, std::size_t x, std::size_t y)
+    {
+        assert(x < heightmap.getWidth() - 1);
+        assert(y < heightmap.getHeight() - 1);
+        return (heightmap.get(x, y) + heightmap.get(x + 1, y) + heightmap.get(x, y + 1) + heightmap.get(x + 1, y + 1)) / 4u;
+    }
+
+    static std::vector<TextureRegion> getTileTextures(GraphicsContext* graphics, const ColorPalette* palette, TntArchive& tnt)
+    {
+        static const unsigned int tileWidth = 32;
+        static const unsigned int tileHeight = 32;
+        static const unsigned int textureWidth = 1024;
+        static const unsigned int textureHeight = 1024;
+        static const auto textureWidthInTiles = textureWidth / tileWidth;
+        static const auto textureHeightInTiles = textureHeight / tileHeight;
+        static const auto tilesPerTexture = textureWidthInTiles * textureHeightInTiles;
+
+        std::vector<TextureRegion> tileTextures;
+
+        Grid<Color> textureBuffer(textureWidth, textureHeight);
+
+        std::vector<SharedTextureHandle> textureHandles;
+
+        // Without a GPU the regions are still needed to describe the map, just with no textures.
+        auto createTexture = [graphics](const Grid<Color>& image) {
+            return graphics == nullptr ? SharedTextureHandle() : SharedTextureHandle(graphics->createTexture(image));
+        };
+
+        // read the tile graphics into textures
+        {
+            unsigned int tileCount = 0;
+            tnt.readTiles([&createTexture, palette, &tileCount, &textureBuffer, &textureHandles](const char* tile) {
+                if (tileCount == tilesPerTexture)
+                {
+                    textureHandles.push_back(createTexture(textureBuffer));
+                    tileCount = 0;
+                }
+
+                auto tileX = tileCount % textureWidthInTiles;
+                auto tileY = tileCount / textureWidthInTiles;
+                auto startX = tileX * tileWidth;
+                auto startY = tileY * tileHeight;
+                for (unsigned int dy = 0; dy < tileHeight; ++dy)
+                {
+                    for (unsigned int dx = 0; dx < tileWidth; ++dx)
+                    {
+                        auto textureX = startX + dx;
+                        auto textureY = startY + dy;
+                        auto index = static_cast<unsigned char>(tile[(dy * tileWidth) + dx]);
+                        textureBuffer.set(textureX, textureY, (*palette)[index]);
+                    }
+                }
+
+                tileCount += 1;
+            });
+        }
+        textureHandles.push_back(createTexture(textureBuffer));
+
+        // populate the list of texture regions referencing the textures
+        for (unsigned int i = 0; i < tnt.getHeader().numberOfTiles; ++i)
+        {
+            auto textureIndex = i / tilesPerTexture;
+            auto tileIndex = i % tilesPerTexture;
+            const float regionWidth = static_cast<float>(tileWidth) / static_cast<float>(textureWidth);
+            const float regionHeight = static_cast<float>(tileHeight) / static_cast<float>(textureHeight);
+            auto x = tileIndex % textureWidthInTiles;
+            auto y = tileIndex / textureWidthInTiles;
+
+            assert(textureHandles.size() > i / tilesPerTexture);
+            tileTextures.emplace_back(
+                textureHandles[textureIndex],
+                Rectangle2f::fromTopLeft(x * regionWidth, y * regionHeight, regionWidth, regionHeight));
+        }
+
+        return tileTextures;
+    }
+
+    static Grid<std::size_t> getMapData(TntArchive& tnt)
+    {
+        auto mapWidthInTiles = tnt.getHeader().width / 2;
+        auto mapHeightInTiles = tnt.getHeader().height / 2;
+        std::vector<uint16_t> mapData(mapWidthInTiles * mapHeightInTiles);
+        tnt.readMapData(mapData.data());
+        std::vector<std::size_t> dataCopy;
+        dataCopy.reserve(mapData.size());
+        std::copy(mapData.begin(), mapData.end(), std::back_inserter(dataCopy));
+        Grid<std::size_t> dataGrid(mapWidthInTiles, mapHeightInTiles, std::move(dataCopy));
+        return dataGrid;
+    }
+
+    static std::vector<FeatureDefinition> getFeatures(MapFeatureService* featureService, TntArchive& tnt)
+    {
+        std::vector<FeatureDefinition> features;
+
+        tnt.readFeatures([featureService, &features](const auto& featureName) {
+            const auto& feature = featureService->getFeatureDefinition(featureName);
+            features.push_back(feature);
+        });
+
+        return features;
+    }
+
+    static MapFeature createFeature(TextureService* textureService, const SimVector& pos, const FeatureDefinition& definition)
+    {
+        MapFeature f;
+        f.footprintX = definition.footprintX;
+        f.footprintZ = definition.footprintZ;
+        f.height = SimScalar(definition.height);
+        f.isBlocking = definition.blocking;
+        f.isIndestructible = definition.indestructible;
+        f.metal = definition.metal;
+        f.position = pos;
+        f.transparentAnimation = definition.animTrans;
+        f.transparentShadow = definition.shadTrans;
+        if (!definition.fileName.empty() && !definition.seqName.empty())
+        {
+            f.animation = textureService->getGafEntry("anims/" + definition.fileName + ".GAF", definition.seqName);
+        }
+        if (!f.animation)
+        {
+            f.animation = textureService->getDefaultSpriteSeries();
+        }
+
+        if (!definition.fileName.empty() && !definition.seqNameShad.empty())
+        {
+            // Some third-party features have broken shadow anim names (e.g. "empty"),
+            // ignore them if they don't exist.
+            f.shadowAnimation = textureService->tryGetGafEntry("anims/" + definition.fileName + ".GAF", definition.seqNameShad);
+        }
+
+        return f;
+    }
+
+    static Grid<unsigned char> getHeightGrid(const Grid<TntTileAttributes>& attrs)
+    {
+        const auto& sourceData = attrs.getVector();
+
+        std::vector<unsigned char> data;
+        data.reserve(sourceData.size());
+
+        std::transform(sourceData.begin(), sourceData.end(), std::back_inserter(data), [](const TntTileAttributes& e) {
+            return e.height;
+        });
+
+        return Grid<unsigned char>(attrs.getWidth(), attrs.getHeight(), std::move(data));
+    }
+
+    static SimVector computeFeaturePosition(
+        const MapTerrain& terrain,
+        const FeatureDefinition& featureDefinition,
+        std::size_t x,
+        std::size_t y)
+    {
+        const auto& heightmap = terrain.getHeightMap();
+
+        unsigned int height = 0;
+        if (x < heightmap.getWidth() - 1 && y < heightmap.getHeight() - 1)
+        {
+            height = computeMidpointHeight(heightmap, x, y);
+        }
+
+        auto position = terrain.heightmapIndexToWorldCorner(x, y);
+        position.y = SimScalar(height);
+
+        position.x += (SimScalar(featureDefinition.footprintX) * MapTerrain::HeightTileWidthInWorldUnits) / 2_ss;
+        position.z += (SimScalar(featureDefinition.footprintZ) * MapTerrain::HeightTileHeightInWorldUnits) / 2_ss;
+
+        return position;
+    }
+
+    static void preloadSound(AudioService* audioService, UnitDatabase& db, const std::string& soundName)
+    {
+        if (audioService == nullptr)
+        {
+            return;
+        }
+
+        auto sound = audioService->loadSound(soundName);
+        if (!sound)
+        {
+            return; // sometimes sound categories name invalid sounds
+        }
+
+        db.addSound(soundName, *sound);
+    }
+
+    static void preloadSound(AudioService* audioService, UnitDatabase& db, const std::optional<std::string>& soundName)
+    {
+        if (!soundName)
+        {
+            return;
+        }
+
+        preloadSound(audioService, db, *soundName);
+    }
+
+    static std::optional<std::vector<std::vector<GuiEntry>>> loadBuilderGui(AbstractVirtualFileSystem* vfs, const std::string& unitName)
+    {
+        std::vector<std::vector<GuiEntry>> entries;
+        for (int i = 1; auto rawGui = vfs->readFile("guis/" + unitName + std::to_string(i) + ".GUI"); ++i)
+        {
+            auto parsedGui = parseGuiFromBytes(*rawGui);
+            if (!parsedGui)
+            {
+                throw std::runtime_error("Failed to parse unit builder GUI: " + unitName + std::to_string(i));
+            }
+            entries.push_back(std::move(*parsedGui));
+        }
+
+        if (entries.empty())
+        {
+            return std::nullopt;
+        }
+
+        return entries;
+    }
+
+    GameSimulation createInitialSimulation(
+        AbstractVirtualFileSystem* vfs,
+        GraphicsContext* graphics,
+        TextureService* textureService,
+        const ColorPalette* palette,
+        MapFeatureService* featureService,
+        const std::string& mapName,
+        const OtaRecord& ota,
+        unsigned int schemaIndex)
+    {
+        auto tntBytes = vfs->readFileView("maps/" + mapName + ".tnt");
+        if (!tntBytes)
+        {
+            throw std::runtime_error("Failed to load map bytes");
+        }
+
+        boost::interprocess::ibufferstream tntStream(tntBytes->data(), tntBytes->size());
+        TntArchive tnt(&tntStream);
+
+        auto tileTextures = getTileTextures(graphics, palette, tnt);
+
+        auto dataGrid = getMapData(tnt);
+
+        Grid<TntTileAttributes> mapAttributes(tnt.getHeader().width, tnt.getHeader().height);
+        tnt.readMapAttributes(mapAttributes.getData());
+
+        auto heightGrid = getHeightGrid(mapAttributes);
+
+        MapTerrain terrain(
+            std::move(tileTextures),
+            std::move(dataGrid),
+            std::move(heightGrid),
+            SimScalar(tnt.getHeader().seaLevel));
+
+        const auto& schema = ota.schemas.at(schemaIndex);
+
+        GameSimulation simulation(std::move(terrain), schema.surfaceMetal);
+
+        auto featureTemplates = getFeatures(featureService, tnt);
+
+        for (std::size_t y = 0; y < mapAttributes.getHeight(); ++y)
+        {
+            for (std::size_t x = 0; x < mapAttributes.getWidth(); ++x)
+            {
+                const auto& e = mapAttributes.get(x, y);
+                switch (e.feature)
+                {
+                    case TntTileAttributes::FeatureNone:
+                    case TntTileAttributes::FeatureUnknown:
+                    case TntTileAttributes::FeatureVoid:
+                        break;
+                    default:
+                        const auto& featureTemplate = featureTemplates[e.feature];
+                        auto pos = computeFeaturePosition(simulation.terrain, featureTemplate, x, y);
+                        auto feature = createFeature(textureService, pos, featureTemplate);
+                        simulation.addFeature(std::move(feature));
+                }
+            }
+        }
+
+        // add features from the OTA schema
+        for (const auto& f : schema.features)
+        {
+            const auto& featureTemplate = featureService->getFeatureDefinition(f.featureName);
+            auto pos = computeFeaturePosition(simulation.terrain, featureTemplate, f.xPos, f.zPos);
+            auto feature = createFeature(textureService, pos, featureTemplate);
+            simulation.addFeature(std::move(feature));
+        }
+
+        return simulation;
+    }
+
+    UnitDatabase createUnitDatabase(AbstractVirtualFileSystem* vfs, AudioService* audioService)
+    {
+        UnitDatabase db;
+
+        // read sound categories
+        {
+            auto bytes = vfs->readFileView("gamedata/SOUND.TDF");
+            if (!bytes)
+            {
+                throw std::runtime_error("Failed to read gamedata/SOUND.TDF");
+            }
+
+            auto sounds = parseSoundTdf(parseTdfFromBytes(bytes->asStringView()));
+            for (auto& s : sounds)
+            {
+                const auto& c = s.second;
+                preloadSound(audioService, db, c.select1);
+                preloadSound(audioService, db, c.unitComplete);
+                preloadSound(audioService, db, c.activate);
+                preloadSound(audioService, db, c.deactivate);
+                preloadSound(audioService, db, c.ok1);
+                preloadSound(audioService, db, c.arrived1);
+                preloadSound(audioService, db, c.cant1);
+                preloadSound(audioService, db, c.underAttack);
+                preloadSound(audioService, db, c.build);
+                preloadSound(audioService, db, c.repair);
+                preloadSound(audioService, db, c.working);
+                preloadSound(audioService, db, c.cloak);
+                preloadSound(audioService, db, c.uncloak);
+                preloadSound(audioService, db, c.capture);
+                preloadSound(audioService, db, c.count5);
+                preloadSound(audioService, db, c.count4);
+                preloadSound(audioService, db, c.count3);
+                preloadSound(audioService, db, c.count2);
+                preloadSound(audioService, db, c.count1);
+                preloadSound(audioService, db, c.count0);
+                preloadSound(audioService, db, c.cancelDestruct);
+                db.addSoundClass(s.first, std::move(s.second));
+            }
+        }
+
+        // read movement classes
+        {
+            auto bytes = vfs->readFileView("gamedata/MOVEINFO.TDF");
+            if (!bytes)
+            {
+                throw std::runtime_error("Failed to read gamedata/MOVEINFO.TDF");
+            }
+
+            auto classes = parseMovementTdf(parseTdfFromBytes(bytes->asStringView()));
+            for (auto& c : classes)
+            {
+                auto name = c.second.name;
+                db.addMovementClass(name, std::move(c.second));
+            }
+        }
+
+        // read weapons
+        {
+            auto weaponFiles = vfs->getFileNames("weapons", ".tdf");
+
+            for (const auto& fileName : weaponFiles)
+            {
+                auto bytes = vfs->readFileView("weapons/" + fileName);
+                if (!bytes)
+                {
+                    throw std::runtime_error("File in listing could not be read: " + fileName);
+                }
+
+                auto entries = parseWeaponTdf(parseTdfFromBytes(bytes->asStringView()));
+
+                for (auto& pair : entries)
+                {
+                    preloadSound(audioService, db, pair.second.soundStart);
+                    preloadSound(audioService, db, pair.second.soundHit);
+                    preloadSound(audioService, db, pair.second.soundWater);
+                    db.addWeapon(pair.first, std::move(pair.second));
+                }
+            }
+        }
+
+        // read unit FBIs
+        {
+            auto fbis = vfs->getFileNames("units", ".fbi");
+
+            for (const auto& fbiName : fbis)
+            {
+                auto bytes = vfs->readFileView("units/" + fbiName);
+                if (!bytes)
+                {
+                    throw std::runtime_error("File in listing could not be read: " + fbiName);
+                }
+
+                auto fbi = parseUnitFbi(parseTdfFromBytes(bytes->asStringView()));
+
+                // if it's a builder, also attempt to read its gui pages
+                if (fbi.builder)
+                {
+                    auto guiPages = loadBuilderGui(vfs, fbi.unitName);
+                    if (guiPages)
+                    {
+                        db.addBuilderGui(fbi.unitName, std::move(*guiPages));
+                    }
+
+                    // TODO: if no gui defined, attempt to build it dynamically?
+                    // Need a database of download.tdf mappings first...
+                }
+
+                db.addUnitInfo(fbi.unitName, fbi);
+            }
+        }
+
+        // read unit scripts
+        {
+            auto scripts = vfs->getFileNames("scripts", ".cob");
+
+            for (const auto& scriptName : scripts)
+            {
+                auto bytes = vfs->readFileView("scripts/" + scriptName);
+                if (!bytes)
+                {
+                    throw std::runtime_error("File in listing could not be read: " + scriptName);
+                }
+
+                boost::interprocess::ibufferstream s(bytes->data(), bytes->size());
+                auto cob = parseCob(s);
+
+                auto scriptNameWithoutExtension = scriptName.substr(0, scriptName.size() - 4);
+
+                db.addUnitScript(scriptNameWithoutExtension, std::move(cob));
+            }
+        }
+
+        return db;
+    }
+}
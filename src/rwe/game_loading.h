@@ -0,0 +1,37 @@
+#pragma once
+
+#include <rwe/ColorPalette.h>
+#include <rwe/GameSimulation.h>
+#include <rwe/GraphicsContext.h>
+#include <rwe/MapFeatureService.h>
+#include <rwe/TextureService.h>
+#include <rwe/UnitDatabase.h>
+#include <rwe/ota.h>
+#include <rwe/vfs/AbstractVirtualFileSystem.h>
+#include <string>
+
+namespace rwe
+{
+    class AudioService;
+
+    /**
+     * Loads the map and its features into a new simulation.
+     * graphics may be null, in which case the map's tiles
+     * are not uploaded to the GPU.
+     */
+    GameSimulation createInitialSimulation(
+        AbstractVirtualFileSystem* vfs,
+        GraphicsContext* graphics,
+        TextureService* textureService,
+        const ColorPalette* palette,
+        MapFeatureService* featureService,
+        const std::string& mapName,
+        const OtaRecord& ota,
+        unsigned int schemaIndex);
+
+    /**
+     * Reads all unit, weapon, movement class and script definitions.
+     * audioService may be null, in which case no sounds are loaded.
+     */
+    UnitDatabase createUnitDatabase(AbstractVirtualFileSystem* vfs, AudioService* audioService);
+}
@@ -29,12 +29,20 @@ namespace rwe
         Partial
     };
 
+    /** A vertex expanded during a search, kept for debug visualisation. */
+    template <typename T>
+    struct AStarClosedVertex
+    {
+        T vertex;
+        std::optional<T> predecessor;
+    };
+
     template <typename T, typename Cost>
     struct AStarPathInfo
     {
         AStarPathType type;
         std::vector<T> path;
-        std::unordered_map<T, AStarVertexInfo<T, Cost>> closedVertices;
+        std::vector<AStarClosedVertex<T>> closedVertices;
     };
 
     template <typename T, typename Cost = float>
@@ -67,7 +75,7 @@ namespace rwe
                 if (isGoal(current.vertex))
                 {
                     spdlog::get("rwe")->debug("Found goal after visiting {0} vertices", openListPopsPerformed);
-                    return AStarPathInfo<T, Cost>{AStarPathType::Complete, walkPath(current), std::move(closedVertices)};
+                    return AStarPathInfo<T, Cost>{AStarPathType::Complete, walkPath(current), toClosedList(closedVertices)};
                 }
 
                 auto estimatedCostToGoal = estimateCostToGoal(current.vertex);
@@ -89,7 +97,7 @@ namespace rwe
             }
 
             spdlog::get("rwe")->debug("Failed to find goal, visited {0} vertices", openListPopsPerformed);
-            return AStarPathInfo<T, Cost>{AStarPathType::Partial, walkPath(*(closestVertex->second)), std::move(closedVertices)};
+            return AStarPathInfo<T, Cost>{AStarPathType::Partial, walkPath(*(closestVertex->second)), toClosedList(closedVertices)};
         }
 
     protected:
@@ -113,5 +121,21 @@ namespace rwe
             std::reverse(items.begin(), items.end());
             return items;
         }
+
+        static std::vector<AStarClosedVertex<T>> toClosedList(const std::unordered_map<T, VertexInfo>& closedVertices)
+        {
+            std::vector<AStarClosedVertex<T>> list;
+            list.reserve(closedVertices.size());
+            for (const auto& item : closedVertices)
+            {
+                std::optional<T> predecessor;
+                if (item.second.predecessor)
+                {
+                    predecessor = (*item.second.predecessor)->vertex;
+                }
+                list.push_back(AStarClosedVertex<T>{item.second.vertex, predecessor});
+            }
+            return list;
+        }
     };
 }
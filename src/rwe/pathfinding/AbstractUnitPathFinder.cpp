@@ -3,37 +3,51 @@
 namespace rwe
 {
     AbstractUnitPathFinder::AbstractUnitPathFinder(
-        GameSimulation* simulation,
-        MovementClassCollisionService* collisionService,
+        const OccupiedGrid* occupiedGrid,
+        const FootprintCollisionMap* collisionMap,
+        const Grid<char>* walkableGrid,
         UnitId self,
-        std::optional<MovementClassId> movementClass,
+        const DiscreteRect& selfArea,
         unsigned int footprintX,
         unsigned int footprintZ)
-        : simulation(simulation),
-          collisionService(collisionService),
+        : GridAStarPathFinder<PathCost>(occupiedGrid->getWidth(), occupiedGrid->getHeight()),
+          occupiedGrid(occupiedGrid),
+          collisionMap(collisionMap),
+          walkableGrid(walkableGrid),
           self(self),
-          movementClass(movementClass),
+          selfArea(selfArea),
           footprintX(footprintX),
           footprintZ(footprintZ)
     {
+        assert(collisionMap == nullptr || (collisionMap->getFootprintX() == footprintX && collisionMap->getFootprintZ() == footprintZ));
     }
 
-    std::vector<AbstractUnitPathFinder::VertexInfo>
-    AbstractUnitPathFinder::getSuccessors(const VertexInfo& info)
+    void AbstractUnitPathFinder::restrictSearchTo(const DiscreteRect& area)
+    {
+        searchArea = area;
+    }
+
+    void AbstractUnitPathFinder::getSuccessors(
+        const Point& vertex,
+        const std::optional<Point>& predecessor,
+        const PathCost& costToReach,
+        std::vector<Successor>& out)
     {
         std::optional<Direction> prevDirection;
-        if (info.predecessor)
+        if (predecessor)
         {
-            prevDirection = pointToDirection(info.vertex - (*info.predecessor)->vertex);
+            prevDirection = pointToDirection(vertex - *predecessor);
         }
 
-        auto neighbours = getNeighbours(info.vertex);
-
-        std::vector<VertexInfo> vs;
-        for (const auto& neighbour : neighbours)
+        for (auto direction : Directions)
         {
-            auto direction = pointToDirection(neighbour - info.vertex);
-            auto distance = octileDistance(info.vertex, neighbour);
+            auto neighbour = step(vertex, direction);
+            if (!isWalkable(neighbour))
+            {
+                continue;
+            }
+
+            auto distance = octileDistance(vertex, neighbour);
             assert(distance.diagonal == 0 || distance.straight == 0);
             if (isRoughTerrain(neighbour))
             {
@@ -42,16 +56,40 @@ namespace rwe
             }
             unsigned int turns = (!prevDirection || direction == *prevDirection) ? 0 : 1;
             PathCost cost(distance, turns);
-            vs.push_back(VertexInfo{info.costToReach + cost, neighbour, &info});
+            out.push_back(Successor{neighbour, costToReach + cost});
         }
-
-        return vs;
     }
 
     bool AbstractUnitPathFinder::isWalkable(const Point& p) const
     {
+        if (searchArea && !searchArea->contains(p))
+        {
+            return false;
+        }
+
+        if (walkableGrid && !walkableGrid->tryGetValue(p).value_or(false))
+        {
+            return false;
+        }
+
         DiscreteRect rect(p.x, p.y, footprintX, footprintZ);
-        return (movementClass ? collisionService->isWalkable(*movementClass, p) : true) && !simulation->isCollisionAt(rect, self);
+
+        if (collisionMap)
+        {
+            if (!collisionMap->isBlocked(p))
+            {
+                return true;
+            }
+
+            // The map can't tell whether the collision is with ourselves,
+            // which only matters if we overlap our own cells.
+            if (!rect.intersection(selfArea))
+            {
+                return false;
+            }
+        }
+
+        return !isCollisionAt(*occupiedGrid, rect, self);
     }
 
     bool AbstractUnitPathFinder::isWalkable(int x, int y) const
@@ -61,8 +99,13 @@ namespace rwe
 
     bool AbstractUnitPathFinder::isRoughTerrain(const Point& p) const
     {
+        if (collisionMap)
+        {
+            return collisionMap->isRough(p);
+        }
+
         DiscreteRect rect(p.x, p.y, footprintX, footprintZ);
-        return simulation->isAdjacentToObstacle(rect);
+        return isAdjacentToObstacle(*occupiedGrid, rect);
     }
 
     Point AbstractUnitPathFinder::step(const Point& p, Direction d) const
@@ -70,24 +113,4 @@ namespace rwe
         auto directionVector = directionToPoint(d);
         return p + directionVector;
     }
-
-    std::vector<Point> AbstractUnitPathFinder::getNeighbours(const Point& p)
-    {
-        std::vector<Point> neighbours;
-        neighbours.reserve(Directions.size());
-
-        for (auto d : Directions)
-        {
-            auto newPosition = step(p, d);
-
-            if (!isWalkable(newPosition))
-            {
-                continue;
-            }
-
-            neighbours.push_back(newPosition);
-        }
-
-        return neighbours;
-    }
 }
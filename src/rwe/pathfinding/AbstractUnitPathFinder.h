@@ -1,11 +1,14 @@
 #pragma once
 
+#include <optional>
 #include <rwe/DiscreteRect.h>
 #include <rwe/EightWayDirection.h>
-#include <rwe/GameSimulation.h>
-#include <rwe/MovementClassCollisionService.h>
+#include <rwe/Grid.h>
+#include <rwe/OccupiedGrid.h>
 #include <rwe/UnitId.h>
 #include <rwe/pathfinding/AStarPathFinder.h>
+#include <rwe/pathfinding/FootprintCollisionMap.h>
+#include <rwe/pathfinding/GridAStarPathFinder.h>
 #include <rwe/pathfinding/PathCost.h>
 #include <rwe/pathfinding/pathfinding_utils.h>
 
@@ -14,27 +17,46 @@ namespace rwe
     /**
      * Standard unit pathfinder.
      */
-    class AbstractUnitPathFinder : public AStarPathFinder<Point, PathCost>
+    class AbstractUnitPathFinder : public GridAStarPathFinder<PathCost>
     {
     private:
-        GameSimulation* const simulation;
-        MovementClassCollisionService* const collisionService;
+        const OccupiedGrid* const occupiedGrid;
+        const FootprintCollisionMap* const collisionMap;
+        const Grid<char>* const walkableGrid;
         const UnitId self;
-        const std::optional<MovementClassId> movementClass;
+        const DiscreteRect selfArea;
         const unsigned int footprintX;
         const unsigned int footprintZ;
+        std::optional<DiscreteRect> searchArea;
 
     public:
+        /**
+         * walkableGrid may be null, in which case the unit
+         * is only restricted by what occupies the map.
+         *
+         * collisionMap may be null, in which case collisions
+         * are checked against the occupied grid directly.
+         * Otherwise it must be for the same footprint size and describe the same grid.
+         * selfArea is the part of the grid occupied by the unit itself,
+         * which the collision map knows nothing about.
+         */
         AbstractUnitPathFinder(
-            GameSimulation* simulation,
-            MovementClassCollisionService* collisionService,
+            const OccupiedGrid* occupiedGrid,
+            const FootprintCollisionMap* collisionMap,
+            const Grid<char>* walkableGrid,
             UnitId self,
-            std::optional<MovementClassId> movementClass,
+            const DiscreteRect& selfArea,
             unsigned int footprintX,
             unsigned int footprintZ);
 
+        /**
+         * Stops the search from visiting positions outside the given area.
+         * Goals outside the area are never found.
+         */
+        void restrictSearchTo(const DiscreteRect& area);
+
     protected:
-        std::vector<VertexInfo> getSuccessors(const VertexInfo& vertex) override;
+        void getSuccessors(const Point& vertex, const std::optional<Point>& predecessor, const PathCost& costToReach, std::vector<Successor>& out) override;
 
     private:
         bool isWalkable(const Point& p) const;
@@ -44,7 +66,5 @@ namespace rwe
         bool isRoughTerrain(const Point& p) const;
 
         Point step(const Point& p, Direction d) const;
-
-        std::vector<Point> getNeighbours(const Point& p);
     };
 }
@@ -0,0 +1,68 @@
+#include "FootprintCollisionMap.h"
+#include <algorithm>
+
+namespace rwe
+{
+    FootprintCollisionMap::FootprintCollisionMap(const OccupiedGrid& occupiedGrid, unsigned int footprintX, unsigned int footprintZ)
+        : footprintX(footprintX),
+          footprintZ(footprintZ),
+          flags(occupiedGrid.getWidth(), occupiedGrid.getHeight(), 0)
+    {
+        for (std::size_t y = 0; y < flags.getHeight(); ++y)
+        {
+            for (std::size_t x = 0; x < flags.getWidth(); ++x)
+            {
+                flags.set(x, y, computeFlags(occupiedGrid, x, y));
+            }
+        }
+    }
+
+    void FootprintCollisionMap::update(const OccupiedGrid& occupiedGrid, const DiscreteRect& changedRect)
+    {
+        // A footprint's flags depend on the cells it covers
+        // plus a one cell border around it,
+        // so any footprint whose top-left is within this distance
+        // of the changed cells may be affected.
+        auto margin = std::max(footprintX, footprintZ) + 1;
+        auto region = flags.clipRegion(DiscreteRect(
+            changedRect.x - static_cast<int>(margin),
+            changedRect.y - static_cast<int>(margin),
+            changedRect.width + (2 * margin),
+            changedRect.height + (2 * margin)));
+
+        for (unsigned int y = region.y; y < region.y + region.height; ++y)
+        {
+            for (unsigned int x = region.x; x < region.x + region.width; ++x)
+            {
+                flags.set(x, y, computeFlags(occupiedGrid, x, y));
+            }
+        }
+    }
+
+    unsigned int FootprintCollisionMap::getFootprintX() const
+    {
+        return footprintX;
+    }
+
+    unsigned int FootprintCollisionMap::getFootprintZ() const
+    {
+        return footprintZ;
+    }
+
+    unsigned char FootprintCollisionMap::computeFlags(const OccupiedGrid& occupiedGrid, int x, int y) const
+    {
+        DiscreteRect rect(x, y, footprintX, footprintZ);
+
+        unsigned char result = 0;
+        if (isCollisionAt(occupiedGrid, rect))
+        {
+            result |= BlockedFlag;
+        }
+        if (isAdjacentToObstacle(occupiedGrid, rect))
+        {
+            result |= RoughFlag;
+        }
+
+        return result;
+    }
+}
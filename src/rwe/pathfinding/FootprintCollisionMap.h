@@ -0,0 +1,65 @@
+#pragma once
+
+#include <rwe/DiscreteRect.h>
+#include <rwe/Grid.h>
+#include <rwe/OccupiedGrid.h>
+#include <rwe/Point.h>
+
+namespace rwe
+{
+    /**
+     * Caches, for one footprint size, what the unit path finder
+     * would otherwise have to work out from the occupied grid
+     * for every cell it visits.
+     *
+     * Each cell holds flags for a footprint whose top-left corner is at that cell:
+     * whether it collides with anything (as isCollisionAt)
+     * and whether it is next to an obstacle (as isAdjacentToObstacle).
+     * The map is kept up to date by telling it which parts
+     * of the occupied grid have changed.
+     */
+    class FootprintCollisionMap
+    {
+    public:
+        static constexpr unsigned char BlockedFlag = 1;
+        static constexpr unsigned char RoughFlag = 2;
+
+    private:
+        unsigned int footprintX;
+        unsigned int footprintZ;
+        Grid<unsigned char> flags;
+
+    public:
+        FootprintCollisionMap(const OccupiedGrid& occupiedGrid, unsigned int footprintX, unsigned int footprintZ);
+
+        /**
+         * Recomputes the flags of every footprint
+         * that could be affected by a change to the given rectangle
+         * of the occupied grid.
+         */
+        void update(const OccupiedGrid& occupiedGrid, const DiscreteRect& changedRect);
+
+        /** Footprints that lie partly outside the grid are always blocked. */
+        bool isBlocked(const Point& p) const
+        {
+            if (p.x < 0 || p.y < 0 || static_cast<std::size_t>(p.x) >= flags.getWidth() || static_cast<std::size_t>(p.y) >= flags.getHeight())
+            {
+                return true;
+            }
+            return (flags.get(p.x, p.y) & BlockedFlag) != 0;
+        }
+
+        /** Must only be called for footprints within the grid. */
+        bool isRough(const Point& p) const
+        {
+            return (flags.get(p.x, p.y) & RoughFlag) != 0;
+        }
+
+        unsigned int getFootprintX() const;
+
+        unsigned int getFootprintZ() const;
+
+    private:
+        unsigned char computeFlags(const OccupiedGrid& occupiedGrid, int x, int y) const;
+    };
+}
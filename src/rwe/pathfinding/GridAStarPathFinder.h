@@ -0,0 +1,227 @@
+#pragma once
+
+#include <algorithm>
+#include <limits>
+#include <optional>
+#include <rwe/IndexedMinHeap.h>
+#include <rwe/Point.h>
+#include <rwe/pathfinding/AStarPathFinder.h>
+#include <spdlog/spdlog.h>
+#include <vector>
+
+namespace rwe
+{
+    template <typename Cost>
+    struct GridAStarSuccessor
+    {
+        Point vertex;
+        Cost costToReach;
+    };
+
+    /**
+     * A* search specialised for vertices that are cells of a fixed-size grid.
+     *
+     * Produces the same paths as AStarPathFinder over the same graph,
+     * but keeps the search state in flat arrays indexed by cell
+     * rather than in hash maps keyed by vertex.
+     * The arrays are owned by the calling thread and reused from one search
+     * to the next, with a generation stamp standing in for clearing them,
+     * so a search allocates almost nothing once the thread has warmed up.
+     */
+    template <typename Cost>
+    class GridAStarPathFinder
+    {
+    public:
+        using Successor = GridAStarSuccessor<Cost>;
+
+    private:
+        static constexpr std::size_t NoPredecessor = std::numeric_limits<std::size_t>::max();
+
+        struct SearchState
+        {
+            IndexedMinHeap<Cost> openVertices;
+            std::vector<Cost> costToReach;
+            std::vector<std::size_t> predecessors;
+            std::vector<unsigned int> closedStamps;
+            unsigned int generation{0};
+
+            /** Closed vertices in the order they were expanded. */
+            std::vector<std::size_t> closedOrder;
+
+            std::vector<Successor> successors;
+
+            void reset(std::size_t size)
+            {
+                openVertices.reset(size);
+                if (size > costToReach.size())
+                {
+                    costToReach.resize(size);
+                    predecessors.resize(size);
+                    closedStamps.resize(size, 0);
+                }
+
+                generation += 1;
+                if (generation == 0)
+                {
+                    std::fill(closedStamps.begin(), closedStamps.end(), 0);
+                    generation = 1;
+                }
+
+                closedOrder.clear();
+            }
+
+            bool isClosed(std::size_t index) const
+            {
+                return closedStamps[index] == generation;
+            }
+        };
+
+        const std::size_t gridWidth;
+        const std::size_t gridHeight;
+
+    public:
+        GridAStarPathFinder(std::size_t gridWidth, std::size_t gridHeight) : gridWidth(gridWidth), gridHeight(gridHeight)
+        {
+        }
+
+        virtual ~GridAStarPathFinder() = default;
+
+        AStarPathInfo<Point, Cost> findPath(const Point& start)
+        {
+            if (!isInGrid(start))
+            {
+                return AStarPathInfo<Point, Cost>{AStarPathType::Partial, std::vector<Point>{start}, {}};
+            }
+
+            auto& state = getSearchState();
+            state.reset(gridWidth * gridHeight);
+
+            auto startIndex = toIndex(start);
+            state.openVertices.pushOrDecrease(startIndex, estimateCostToGoal(start));
+            state.costToReach[startIndex] = Cost();
+            state.predecessors[startIndex] = NoPredecessor;
+
+            std::optional<std::pair<Cost, std::size_t>> closestVertex;
+
+            unsigned int openListPopsPerformed = 0;
+
+            while (!state.openVertices.empty() && openListPopsPerformed < MaxOpenListQueries)
+            {
+                auto currentIndex = state.openVertices.top().index;
+                state.openVertices.pop();
+                state.closedStamps[currentIndex] = state.generation;
+                state.closedOrder.push_back(currentIndex);
+                openListPopsPerformed += 1;
+
+                auto current = toPoint(currentIndex);
+
+                if (isGoal(current))
+                {
+                    spdlog::get("rwe")->debug("Found goal after visiting {0} vertices", openListPopsPerformed);
+                    return AStarPathInfo<Point, Cost>{AStarPathType::Complete, walkPath(state, currentIndex), toClosedList(state)};
+                }
+
+                auto estimatedCostToGoal = estimateCostToGoal(current);
+                if (!closestVertex || estimatedCostToGoal < closestVertex->first)
+                {
+                    closestVertex = std::pair<Cost, std::size_t>(estimatedCostToGoal, currentIndex);
+                }
+
+                auto predecessorIndex = state.predecessors[currentIndex];
+                std::optional<Point> predecessor;
+                if (predecessorIndex != NoPredecessor)
+                {
+                    predecessor = toPoint(predecessorIndex);
+                }
+
+                state.successors.clear();
+                getSuccessors(current, predecessor, state.costToReach[currentIndex], state.successors);
+
+                for (const auto& s : state.successors)
+                {
+                    auto index = toIndex(s.vertex);
+                    if (state.isClosed(index))
+                    {
+                        continue;
+                    }
+
+                    auto estimatedTotalCost = s.costToReach + estimateCostToGoal(s.vertex);
+                    if (state.openVertices.pushOrDecrease(index, estimatedTotalCost))
+                    {
+                        state.costToReach[index] = s.costToReach;
+                        state.predecessors[index] = currentIndex;
+                    }
+                }
+            }
+
+            spdlog::get("rwe")->debug("Failed to find goal, visited {0} vertices", openListPopsPerformed);
+            return AStarPathInfo<Point, Cost>{AStarPathType::Partial, walkPath(state, closestVertex->second), toClosedList(state)};
+        }
+
+    protected:
+        virtual bool isGoal(const Point& vertex) = 0;
+
+        virtual Cost estimateCostToGoal(const Point& vertex) = 0;
+
+        /**
+         * Appends the successors of the vertex to the output list.
+         * Successors must lie within the grid.
+         */
+        virtual void getSuccessors(const Point& vertex, const std::optional<Point>& predecessor, const Cost& costToReach, std::vector<Successor>& out) = 0;
+
+        bool isInGrid(const Point& p) const
+        {
+            return p.x >= 0 && p.y >= 0 && static_cast<std::size_t>(p.x) < gridWidth && static_cast<std::size_t>(p.y) < gridHeight;
+        }
+
+    private:
+        /**
+         * Each thread gets its own state, so that searches
+         * on different path finding workers never share it.
+         */
+        static SearchState& getSearchState()
+        {
+            static thread_local SearchState state;
+            return state;
+        }
+
+        std::size_t toIndex(const Point& p) const
+        {
+            return (static_cast<std::size_t>(p.y) * gridWidth) + static_cast<std::size_t>(p.x);
+        }
+
+        Point toPoint(std::size_t index) const
+        {
+            return Point(static_cast<int>(index % gridWidth), static_cast<int>(index / gridWidth));
+        }
+
+        std::vector<Point> walkPath(const SearchState& state, std::size_t index) const
+        {
+            std::vector<Point> items;
+            while (index != NoPredecessor)
+            {
+                items.push_back(toPoint(index));
+                index = state.predecessors[index];
+            }
+
+            std::reverse(items.begin(), items.end());
+            return items;
+        }
+
+        std::vector<AStarClosedVertex<Point>> toClosedList(const SearchState& state) const
+        {
+            std::vector<AStarClosedVertex<Point>> list;
+            list.reserve(state.closedOrder.size());
+            for (auto index : state.closedOrder)
+            {
+                std::optional<Point> predecessor;
+                if (state.predecessors[index] != NoPredecessor)
+                {
+                    predecessor = toPoint(state.predecessors[index]);
+                }
+                list.push_back(AStarClosedVertex<Point>{toPoint(index), predecessor});
+            }
+            return list;
+        }
+    };
+}
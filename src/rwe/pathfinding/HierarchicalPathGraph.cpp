@@ -0,0 +1,481 @@
+#include "HierarchicalPathGraph.h"
+#include <algorithm>
+#include <queue>
+#include <rwe/EightWayDirection.h>
+#include <rwe/pathfinding/AStarPathFinder.h>
+#include <rwe/pathfinding/pathfinding_utils.h>
+
+namespace rwe
+{
+    /**
+     * Searches the graph of cluster entrances.
+     * The start vertex is joined to the entrances of its own cluster
+     * via the costs passed in at construction.
+     */
+    class HierarchicalPathGraph::AbstractPathFinder : public AStarPathFinder<Point, OctileDistance>
+    {
+    private:
+        const HierarchicalPathGraph* const graph;
+        const Point start;
+        const std::vector<std::pair<Point, OctileDistance>> startPaths;
+        const std::vector<unsigned int>& goalComponents;
+        const std::vector<Point>& goals;
+
+    public:
+        AbstractPathFinder(
+            const HierarchicalPathGraph* graph,
+            const Point& start,
+            std::vector<std::pair<Point, OctileDistance>>&& startPaths,
+            const std::vector<unsigned int>& goalComponents,
+            const std::vector<Point>& goals)
+            : graph(graph), start(start), startPaths(std::move(startPaths)), goalComponents(goalComponents), goals(goals)
+        {
+        }
+
+    protected:
+        bool isGoal(const Point& vertex) override
+        {
+            auto component = graph->getComponent(vertex);
+            return std::find(goalComponents.begin(), goalComponents.end(), component) != goalComponents.end();
+        }
+
+        OctileDistance estimateCostToGoal(const Point& vertex) override
+        {
+            std::optional<OctileDistance> best;
+            for (const auto& goal : goals)
+            {
+                auto distance = octileDistance(vertex, goal);
+                if (!best || distance < *best)
+                {
+                    best = distance;
+                }
+            }
+
+            return *best;
+        }
+
+        std::vector<VertexInfo> getSuccessors(const VertexInfo& info) override
+        {
+            std::vector<VertexInfo> vs;
+
+            if (info.vertex == start)
+            {
+                for (const auto& p : startPaths)
+                {
+                    vs.push_back(VertexInfo{info.costToReach + p.second, p.first, &info});
+                }
+
+                // If the start is itself an entrance,
+                // its exits are only reachable by expanding it below.
+            }
+
+            const auto& cluster = *graph->clusters[graph->getClusterIndex(info.vertex)];
+            auto it = std::find_if(cluster.entrances.begin(), cluster.entrances.end(), [&](const auto& e) { return e.position == info.vertex; });
+            if (it == cluster.entrances.end())
+            {
+                return vs;
+            }
+
+            for (const auto& exit : it->exits)
+            {
+                vs.push_back(VertexInfo{info.costToReach + OctileDistance(1, 0), exit, &info});
+            }
+
+            for (const auto& path : it->paths)
+            {
+                vs.push_back(VertexInfo{info.costToReach + path.second, cluster.entrances[path.first].position, &info});
+            }
+
+            return vs;
+        }
+    };
+
+    HierarchicalPathGraph::HierarchicalPathGraph(
+        const GameSimulation* simulation,
+        const Grid<char>* walkableGrid,
+        unsigned int footprintX,
+        unsigned int footprintZ)
+        : simulation(simulation),
+          walkableGrid(walkableGrid),
+          footprintX(footprintX),
+          footprintZ(footprintZ),
+          clustersX((walkableGrid->getWidth() + ClusterSize - 1) / ClusterSize),
+          clustersY((walkableGrid->getHeight() + ClusterSize - 1) / ClusterSize)
+    {
+        std::vector<std::shared_ptr<Cluster>> newClusters;
+        for (std::size_t y = 0; y < clustersY; ++y)
+        {
+            for (std::size_t x = 0; x < clustersX; ++x)
+            {
+                auto left = x * ClusterSize;
+                auto top = y * ClusterSize;
+                auto width = std::min<std::size_t>(ClusterSize, walkableGrid->getWidth() - left);
+                auto height = std::min<std::size_t>(ClusterSize, walkableGrid->getHeight() - top);
+                auto cluster = std::make_shared<Cluster>(Cluster{
+                    DiscreteRect(left, top, width, height),
+                    Grid<char>(width, height, false),
+                    Grid<unsigned int>(width, height, 0),
+                    {}});
+                cluster->passable.forEachIndexed([&](const auto& c, auto& cell) { cell = computePassable(left + c.x, top + c.y); });
+                newClusters.push_back(cluster);
+                clusters.push_back(std::move(cluster));
+            }
+        }
+
+        // Entrances are placed by looking at passability on both sides of a border,
+        // so every cluster's cells must be known before any are rebuilt.
+        for (std::size_t i = 0; i < newClusters.size(); ++i)
+        {
+            rebuildCluster(i, *newClusters[i]);
+        }
+    }
+
+    void HierarchicalPathGraph::invalidate(const DiscreteRect& occupiedRect)
+    {
+        // Grid cells are the top-left corner of the unit's footprint,
+        // so every cell whose footprint overlaps the rect is affected.
+        DiscreteRect affectedRect(
+            occupiedRect.x - static_cast<int>(footprintX) + 1,
+            occupiedRect.y - static_cast<int>(footprintZ) + 1,
+            occupiedRect.width + footprintX - 1,
+            occupiedRect.height + footprintZ - 1);
+        auto region = walkableGrid->clipRegion(affectedRect);
+
+        // Other copies of the graph may share our clusters,
+        // so each one that changes is copied before it is touched.
+        std::vector<std::pair<std::size_t, std::shared_ptr<Cluster>>> copiedClusters;
+        auto getMutableCluster = [&](std::size_t index) -> Cluster& {
+            auto it = std::find_if(copiedClusters.begin(), copiedClusters.end(), [&](const auto& e) { return e.first == index; });
+            if (it != copiedClusters.end())
+            {
+                return *it->second;
+            }
+
+            auto copy = std::make_shared<Cluster>(*clusters[index]);
+            clusters[index] = copy;
+            copiedClusters.emplace_back(index, copy);
+            return *copy;
+        };
+
+        std::vector<std::size_t> changedClusters;
+        region.forEach([&](const auto& c) {
+            Point p(c.x, c.y);
+            auto index = getClusterIndex(p);
+            const auto& area = clusters[index]->area;
+            char newValue = computePassable(p.x, p.y);
+            if (clusters[index]->passable.get(p.x - area.x, p.y - area.y) != newValue)
+            {
+                getMutableCluster(index).passable.set(p.x - area.x, p.y - area.y, newValue);
+                changedClusters.push_back(index);
+            }
+        });
+
+        // Entrances are shared with neighbouring clusters,
+        // so those must be rebuilt too.
+        std::vector<std::size_t> dirtyClusters;
+        for (auto index : changedClusters)
+        {
+            auto x = index % clustersX;
+            auto y = index / clustersX;
+            dirtyClusters.push_back(index);
+            if (x > 0)
+            {
+                dirtyClusters.push_back(index - 1);
+            }
+            if (x + 1 < clustersX)
+            {
+                dirtyClusters.push_back(index + 1);
+            }
+            if (y > 0)
+            {
+                dirtyClusters.push_back(index - clustersX);
+            }
+            if (y + 1 < clustersY)
+            {
+                dirtyClusters.push_back(index + clustersX);
+            }
+        }
+
+        std::sort(dirtyClusters.begin(), dirtyClusters.end());
+        dirtyClusters.erase(std::unique(dirtyClusters.begin(), dirtyClusters.end()), dirtyClusters.end());
+
+        for (auto index : dirtyClusters)
+        {
+            rebuildCluster(index, getMutableCluster(index));
+        }
+    }
+
+    bool HierarchicalPathGraph::isPassable(const Point& p) const
+    {
+        if (p.x < 0 || p.y < 0 || p.x >= static_cast<int>(walkableGrid->getWidth()) || p.y >= static_cast<int>(walkableGrid->getHeight()))
+        {
+            return false;
+        }
+
+        const auto& cluster = *clusters[getClusterIndex(p)];
+        return cluster.passable.get(p.x - cluster.area.x, p.y - cluster.area.y);
+    }
+
+    std::optional<std::vector<Point>> HierarchicalPathGraph::findPath(const Point& start, const std::vector<Point>& goals) const
+    {
+        if (!isPassable(start))
+        {
+            return std::nullopt;
+        }
+
+        std::vector<Point> openGoals;
+        std::vector<unsigned int> goalComponents;
+        for (const auto& goal : goals)
+        {
+            if (!isPassable(goal))
+            {
+                continue;
+            }
+
+            openGoals.push_back(goal);
+            goalComponents.push_back(getComponent(goal));
+        }
+
+        if (openGoals.empty())
+        {
+            return std::nullopt;
+        }
+
+        if (std::find(goalComponents.begin(), goalComponents.end(), getComponent(start)) != goalComponents.end())
+        {
+            return std::vector<Point>{start};
+        }
+
+        const auto& startCluster = *clusters[getClusterIndex(start)];
+        auto costs = computeCostsWithin(startCluster, start);
+        std::vector<std::pair<Point, OctileDistance>> startPaths;
+        for (const auto& e : startCluster.entrances)
+        {
+            const auto& cost = costs[(e.position.y - startCluster.area.y) * startCluster.area.width + (e.position.x - startCluster.area.x)];
+            if (cost)
+            {
+                startPaths.emplace_back(e.position, *cost);
+            }
+        }
+
+        AbstractPathFinder pathFinder(this, start, std::move(startPaths), goalComponents, openGoals);
+        auto result = pathFinder.findPath(start);
+        if (result.type != AStarPathType::Complete)
+        {
+            return std::nullopt;
+        }
+
+        return std::move(result.path);
+    }
+
+    DiscreteRect HierarchicalPathGraph::getClusterArea(const Point& p) const
+    {
+        return clusters[getClusterIndex(p)]->area;
+    }
+
+    std::size_t HierarchicalPathGraph::getClusterIndex(const Point& p) const
+    {
+        return ((p.y / ClusterSize) * clustersX) + (p.x / ClusterSize);
+    }
+
+    unsigned int HierarchicalPathGraph::getComponent(const Point& p) const
+    {
+        const auto& cluster = *clusters[getClusterIndex(p)];
+        return cluster.components.get(p.x - cluster.area.x, p.y - cluster.area.y);
+    }
+
+    bool HierarchicalPathGraph::computePassable(int x, int y) const
+    {
+        return walkableGrid->get(x, y) && !simulation->isStaticCollisionAt(DiscreteRect(x, y, footprintX, footprintZ));
+    }
+
+    void HierarchicalPathGraph::rebuildCluster(std::size_t index, Cluster& cluster)
+    {
+        const auto& area = cluster.area;
+        auto x = index % clustersX;
+        auto y = index / clustersX;
+
+        cluster.entrances.clear();
+
+        if (x > 0)
+        {
+            addBorderEntrances(cluster, Point(area.x, area.y), Point(-1, 0), Point(0, 1), area.height);
+        }
+        if (x + 1 < clustersX)
+        {
+            addBorderEntrances(cluster, Point(area.x + area.width - 1, area.y), Point(1, 0), Point(0, 1), area.height);
+        }
+        if (y > 0)
+        {
+            addBorderEntrances(cluster, Point(area.x, area.y), Point(0, -1), Point(1, 0), area.width);
+        }
+        if (y + 1 < clustersY)
+        {
+            addBorderEntrances(cluster, Point(area.x, area.y + area.height - 1), Point(0, 1), Point(1, 0), area.width);
+        }
+
+        labelComponents(index, cluster);
+
+        for (auto& entrance : cluster.entrances)
+        {
+            auto costs = computeCostsWithin(cluster, entrance.position);
+            for (std::size_t i = 0; i < cluster.entrances.size(); ++i)
+            {
+                const auto& other = cluster.entrances[i];
+                if (other.position == entrance.position)
+                {
+                    continue;
+                }
+
+                const auto& cost = costs[(other.position.y - area.y) * area.width + (other.position.x - area.x)];
+                if (cost)
+                {
+                    entrance.paths.emplace_back(i, *cost);
+                }
+            }
+        }
+    }
+
+    void HierarchicalPathGraph::addBorderEntrances(Cluster& cluster, const Point& first, const Point& outward, const Point& along, unsigned int length)
+    {
+        auto cellAt = [&](unsigned int i) {
+            return Point(first.x + (along.x * static_cast<int>(i)), first.y + (along.y * static_cast<int>(i)));
+        };
+
+        auto addEntrance = [&](const Point& position) {
+            auto it = std::find_if(cluster.entrances.begin(), cluster.entrances.end(), [&](const auto& e) { return e.position == position; });
+            if (it == cluster.entrances.end())
+            {
+                cluster.entrances.push_back(Entrance{position, {}, {}});
+                it = cluster.entrances.end() - 1;
+            }
+            it->exits.push_back(position + outward);
+        };
+
+        // The cluster on the other side of the border scans the same pairs of cells
+        // in the same order, so both sides agree on where the entrances go.
+        std::optional<unsigned int> runStart;
+        for (unsigned int i = 0; i <= length; ++i)
+        {
+            auto open = i < length && isPassable(cellAt(i)) && isPassable(cellAt(i) + outward);
+            if (open && !runStart)
+            {
+                runStart = i;
+            }
+            else if (!open && runStart)
+            {
+                auto runLength = i - *runStart;
+                if (runLength < MaxSingleEntranceWidth)
+                {
+                    addEntrance(cellAt(*runStart + ((runLength - 1) / 2)));
+                }
+                else
+                {
+                    addEntrance(cellAt(*runStart));
+                    addEntrance(cellAt(i - 1));
+                }
+                runStart = std::nullopt;
+            }
+        }
+    }
+
+    void HierarchicalPathGraph::labelComponents(std::size_t index, Cluster& cluster)
+    {
+        auto& components = cluster.components;
+        const auto& passable = cluster.passable;
+        components.set(components.getRegion(), 0);
+
+        auto nextLabel = static_cast<unsigned int>(index * ClusterSize * ClusterSize) + 1;
+
+        // Works in coordinates relative to the cluster.
+        DiscreteRect area(0, 0, passable.getWidth(), passable.getHeight());
+
+        std::vector<Point> openList;
+        passable.getRegion().forEach([&](const auto& c) {
+            if (!passable.get(c) || components.get(c) != 0)
+            {
+                return;
+            }
+
+            auto label = nextLabel++;
+            components.get(c) = label;
+            openList.emplace_back(c.x, c.y);
+            while (!openList.empty())
+            {
+                auto p = openList.back();
+                openList.pop_back();
+                for (auto d : Directions)
+                {
+                    auto n = p + directionToPoint(d);
+                    if (n.x < area.x || n.y < area.y || n.x >= area.x + static_cast<int>(area.width) || n.y >= area.y + static_cast<int>(area.height))
+                    {
+                        continue;
+                    }
+
+                    if (!passable.get(n.x, n.y) || components.get(n.x, n.y) != 0)
+                    {
+                        continue;
+                    }
+
+                    components.get(n.x, n.y) = label;
+                    openList.push_back(n);
+                }
+            }
+        });
+    }
+
+    std::vector<std::optional<OctileDistance>> HierarchicalPathGraph::computeCostsWithin(const Cluster& cluster, const Point& start)
+    {
+        const auto& area = cluster.area;
+        std::vector<std::optional<OctileDistance>> costs(area.width * area.height);
+        auto toIndex = [&](const Point& p) { return (p.y - area.y) * area.width + (p.x - area.x); };
+
+        using Entry = std::pair<float, Point>;
+        auto greater = [](const Entry& a, const Entry& b) { return a.first > b.first; };
+        std::priority_queue<Entry, std::vector<Entry>, decltype(greater)> openList(greater);
+
+        costs[toIndex(start)] = OctileDistance(0, 0);
+        openList.emplace(0.0f, start);
+
+        std::vector<char> closed(costs.size(), false);
+
+        while (!openList.empty())
+        {
+            auto p = openList.top().second;
+            openList.pop();
+
+            auto index = toIndex(p);
+            if (closed[index])
+            {
+                continue;
+            }
+            closed[index] = true;
+
+            for (auto d : Directions)
+            {
+                auto step = directionToPoint(d);
+                auto n = p + step;
+                if (n.x < area.x || n.y < area.y || n.x >= area.x + static_cast<int>(area.width) || n.y >= area.y + static_cast<int>(area.height))
+                {
+                    continue;
+                }
+
+                if (!cluster.passable.get(n.x - area.x, n.y - area.y))
+                {
+                    continue;
+                }
+
+                auto stepCost = (step.x != 0 && step.y != 0) ? OctileDistance(0, 1) : OctileDistance(1, 0);
+                auto newCost = *costs[index] + stepCost;
+                auto& existing = costs[toIndex(n)];
+                if (!existing || newCost < *existing)
+                {
+                    existing = newCost;
+                    openList.emplace(newCost.asFloat(), n);
+                }
+            }
+        }
+
+        return costs;
+    }
+}
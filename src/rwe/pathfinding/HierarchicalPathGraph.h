@@ -0,0 +1,142 @@
+#pragma once
+
+#include <memory>
+#include <optional>
+#include <rwe/DiscreteRect.h>
+#include <rwe/GameSimulation.h>
+#include <rwe/Grid.h>
+#include <rwe/Point.h>
+#include <rwe/pathfinding/OctileDistance.h>
+#include <vector>
+
+namespace rwe
+{
+    /**
+     * A coarse graph over the walkable grid of one movement class,
+     * used to plan long paths without searching every cell along the way.
+     *
+     * The grid is divided into square clusters.
+     * Wherever open cells line up on both sides of the border between two clusters,
+     * an entrance is placed, and the costs of travelling between
+     * the entrances within each cluster are precomputed.
+     * Paths are planned by hopping from entrance to entrance,
+     * and the caller then refines each hop with a regular grid search.
+     *
+     * Only static obstacles -- terrain, features and buildings -- are considered.
+     * Mobile units come and go too quickly to be worth caching,
+     * so they are left for the refining search to deal with.
+     *
+     * Clusters are immutable once built and shared between copies of the graph.
+     * Invalidating a copy replaces only the clusters it rebuilds,
+     * so copying the graph to modify it costs one pointer per cluster.
+     */
+    class HierarchicalPathGraph
+    {
+    public:
+        /** The width and height of each cluster, in grid cells. */
+        static constexpr unsigned int ClusterSize = 16;
+
+        /**
+         * Openings in a cluster border narrower than this
+         * get a single entrance in the middle.
+         * Wider openings get an entrance at each end.
+         */
+        static constexpr unsigned int MaxSingleEntranceWidth = 6;
+
+    private:
+        class AbstractPathFinder;
+
+        struct Entrance
+        {
+            Point position;
+
+            /** Cells in neighbouring clusters one straight step away from this entrance. */
+            std::vector<Point> exits;
+
+            /** Other entrances in the same cluster reachable from this one, and the cost to reach them. */
+            std::vector<std::pair<std::size_t, OctileDistance>> paths;
+        };
+
+        struct Cluster
+        {
+            DiscreteRect area;
+
+            /** Whether the footprint fits at each cell of the area, relative to its top-left corner. */
+            Grid<char> passable;
+
+            /**
+             * Labels the connected regions of open cells within the cluster.
+             * Labels are unique across the whole graph, 0 marks a blocked cell.
+             */
+            Grid<unsigned int> components;
+
+            std::vector<Entrance> entrances;
+        };
+
+        const GameSimulation* simulation;
+        const Grid<char>* walkableGrid;
+        unsigned int footprintX;
+        unsigned int footprintZ;
+
+        std::size_t clustersX;
+        std::size_t clustersY;
+
+        std::vector<std::shared_ptr<const Cluster>> clusters;
+
+    public:
+        HierarchicalPathGraph(const GameSimulation* simulation, const Grid<char>* walkableGrid, unsigned int footprintX, unsigned int footprintZ);
+
+        /**
+         * Notifies the graph that static obstacles within the given rectangle
+         * of the occupied grid have changed.
+         * Only clusters where passability actually changed are rebuilt,
+         * along with their immediate neighbours whose entrances they share.
+         */
+        void invalidate(const DiscreteRect& occupiedRect);
+
+        bool isPassable(const Point& p) const;
+
+        /**
+         * Plans a path from start to a cell in the same cluster region
+         * as one of the goals, via cluster entrances.
+         * The returned path begins at start and ends at the entrance
+         * from which a goal can be reached without leaving the cluster.
+         * If start is already in such a region, the path is just start.
+         *
+         * Returns nothing if the start or all the goals are blocked,
+         * or if no route through the graph could be found.
+         */
+        std::optional<std::vector<Point>> findPath(const Point& start, const std::vector<Point>& goals) const;
+
+        /**
+         * Returns the area of the grid covered by the cluster containing p.
+         * Each hop of a path returned by findPath stays within
+         * the clusters of the points at either end.
+         */
+        DiscreteRect getClusterArea(const Point& p) const;
+
+    private:
+        std::size_t getClusterIndex(const Point& p) const;
+
+        unsigned int getComponent(const Point& p) const;
+
+        bool computePassable(int x, int y) const;
+
+        /**
+         * Recomputes the entrances and components of the cluster at the given index,
+         * which must already be installed in clusters.
+         */
+        void rebuildCluster(std::size_t index, Cluster& cluster);
+
+        void addBorderEntrances(Cluster& cluster, const Point& first, const Point& outward, const Point& along, unsigned int length);
+
+        void labelComponents(std::size_t index, Cluster& cluster);
+
+        /**
+         * Returns the cost of reaching every cell of the cluster from start,
+         * moving only through open cells inside the cluster.
+         * Cells are indexed row by row relative to the cluster area.
+         */
+        static std::vector<std::optional<OctileDistance>> computeCostsWithin(const Cluster& cluster, const Point& start);
+    };
+}
@@ -1,59 +1,133 @@
 #include "PathFindingService.h"
-#include <future>
+#include <algorithm>
+#include <rwe/overloaded.h>
 #include <rwe/pathfinding/UnitPathFinder.h>
 #include <rwe/pathfinding/UnitPerimeterPathFinder.h>
 #include <rwe/pathfinding/pathfinding_utils.h>
 
 namespace rwe
 {
-    static const unsigned int MaxTasksPerTick = 10;
+    static SimVector getWorldCenter(const MapTerrain& terrain, const DiscreteRect& rect)
+    {
+        auto corner = terrain.heightmapIndexToWorldCorner(rect.x, rect.y);
+
+        auto halfWorldWidth = (SimScalar(rect.width) * MapTerrain::HeightTileWidthInWorldUnits) / 2_ss;
+        auto halfWorldHeight = (SimScalar(rect.height) * MapTerrain::HeightTileHeightInWorldUnits) / 2_ss;
+
+        auto center = corner + SimVector(halfWorldWidth, 0_ss, halfWorldHeight);
+        center.y = terrain.getHeightAt(center.x, center.z);
+        return center;
+    }
+
+    static DiscreteRect expandTopLeft(const DiscreteRect& rect, unsigned int width, unsigned int height)
+    {
+        return DiscreteRect(
+            rect.x - static_cast<int>(width),
+            rect.y - static_cast<int>(height),
+            rect.width + width,
+            rect.height + height);
+    }
 
-    PathFindingService::PathFindingService(GameSimulation* simulation, MovementClassCollisionService* collisionService)
-        : simulation(simulation), collisionService(collisionService)
+    static DiscreteRect boundingRect(const DiscreteRect& a, const DiscreteRect& b)
     {
+        return DiscreteRect::fromPoints(
+            Point(std::min(a.x, b.x), std::min(a.y, b.y)),
+            Point(
+                std::max(a.x + static_cast<int>(a.width), b.x + static_cast<int>(b.width)) - 1,
+                std::max(a.y + static_cast<int>(a.height), b.y + static_cast<int>(b.height)) - 1));
     }
 
-    void PathFindingService::update()
+    /**
+     * Finds a path by planning over the movement class's hierarchical graph
+     * and refining each hop with a grid search.
+     * findFinalLeg is used to search from the last hop to the real goal.
+     *
+     * Returns nothing if the graph can't be used,
+     * or if something the graph doesn't know about blocks a hop,
+     * in which case the caller should search the whole grid instead.
+     */
+    static std::optional<AStarPathInfo<Point, PathCost>> findHierarchicalPath(
+        const PathTask& task,
+        const Point& start,
+        const std::vector<Point>& goals,
+        const std::function<AStarPathInfo<Point, PathCost>(const Point&)>& findFinalLeg)
     {
-        auto& requests = simulation->pathRequests;
-        unsigned int tasksDone = 0;
-        while (!requests.empty() && tasksDone < MaxTasksPerTick)
+        if (!task.pathGraph)
         {
-            auto& request = requests.front();
+            return std::nullopt;
+        }
 
-            auto& unit = simulation->getUnit(request.unitId);
+        auto abstractPath = task.pathGraph->findPath(start, goals);
+        if (!abstractPath)
+        {
+            return std::nullopt;
+        }
 
-            if (auto movingState = std::get_if<MovingState>(&unit.behaviourState); movingState != nullptr)
+        auto selfArea = computeFootprintRegion(*task.terrain, task.position, task.footprintX, task.footprintZ);
+
+        AStarPathInfo<Point, PathCost> result{AStarPathType::Complete, std::vector<Point>{start}, {}};
+
+        for (auto it = ++abstractPath->cbegin(); it != abstractPath->cend(); ++it)
+        {
+            auto hopStart = result.path.back();
+            auto hopArea = boundingRect(task.pathGraph->getClusterArea(hopStart), task.pathGraph->getClusterArea(*it));
+
+            UnitPathFinder pathFinder(task.occupiedGrid.get(), task.collisionMap.get(), task.walkableGrid, task.unitId, selfArea, task.footprintX, task.footprintZ, *it);
+            pathFinder.restrictSearchTo(hopArea);
+            auto leg = pathFinder.findPath(hopStart);
+
+            if (leg.type == AStarPathType::Partial)
             {
-                UnitPath path = std::visit(FindPathVisitor(this, request.unitId), movingState->destination);
-                movingState->path = PathFollowingInfo(std::move(path), simulation->gameTime);
-                movingState->pathRequested = false;
+                // Something the graph doesn't know about,
+                // most likely another unit, is in the way.
+                // The rest of the plan may no longer make sense,
+                // so leave it to a search of the whole grid.
+                return std::nullopt;
             }
 
-            requests.pop_front();
-            tasksDone += 1;
+            result.path.insert(result.path.end(), ++leg.path.cbegin(), leg.path.cend());
         }
+
+        auto finalLeg = findFinalLeg(result.path.back());
+        result.path.insert(result.path.end(), ++finalLeg.path.cbegin(), finalLeg.path.cend());
+        result.type = finalLeg.type;
+        result.closedVertices = std::move(finalLeg.closedVertices);
+
+        return result;
     }
 
-    UnitPath PathFindingService::findPath(UnitId unitId, const DiscreteRect& destination)
+    static PathResult findPathToRect(const PathTask& task, const DiscreteRect& destination)
     {
-        const auto& unit = simulation->getUnit(unitId);
-
-        auto start = simulation->computeFootprintRegion(unit.position, unit.footprintX, unit.footprintZ);
+        auto start = computeFootprintRegion(*task.terrain, task.position, task.footprintX, task.footprintZ);
         // expand the goal rect to take into account our own collision rect
-        auto goal = expandTopLeft(destination, unit.footprintX, unit.footprintZ);
+        auto goal = expandTopLeft(destination, task.footprintX, task.footprintZ);
 
-        UnitPerimeterPathFinder pathFinder(simulation, collisionService, unitId, unit.movementClass, unit.footprintX, unit.footprintZ, goal);
+        auto findPathFrom = [&](const Point& p) {
+            UnitPerimeterPathFinder pathFinder(task.occupiedGrid.get(), task.collisionMap.get(), task.walkableGrid, task.unitId, start, task.footprintX, task.footprintZ, goal);
+            return pathFinder.findPath(p);
+        };
 
-        auto path = pathFinder.findPath(Point(start.x, start.y));
-        lastPathDebugInfo = AStarPathInfo<Point, PathCost>{path.type, path.path, std::move(path.closedVertices)};
+        std::vector<Point> goalCells;
+        for (int x = goal.x; x <= goal.x + static_cast<int>(goal.width); ++x)
+        {
+            goalCells.emplace_back(x, goal.y);
+            goalCells.emplace_back(x, goal.y + static_cast<int>(goal.height));
+        }
+        for (int y = goal.y + 1; y < goal.y + static_cast<int>(goal.height); ++y)
+        {
+            goalCells.emplace_back(goal.x, y);
+            goalCells.emplace_back(goal.x + static_cast<int>(goal.width), y);
+        }
+
+        auto hierarchicalPath = findHierarchicalPath(task, Point(start.x, start.y), goalCells, findPathFrom);
+        auto path = hierarchicalPath ? std::move(*hierarchicalPath) : findPathFrom(Point(start.x, start.y));
 
         assert(path.path.size() >= 1);
 
         if (path.path.size() == 1)
         {
             // The path is trivial, we are already at the goal.
-            return UnitPath{std::vector<SimVector>{unit.position}};
+            return PathResult{UnitPath{std::vector<SimVector>{task.position}}, std::move(path)};
         }
 
         auto simplifiedPath = runSimplifyPath(path.path);
@@ -61,23 +135,25 @@ namespace rwe
         std::vector<SimVector> waypoints;
         for (auto it = ++simplifiedPath.cbegin(); it != simplifiedPath.cend(); ++it)
         {
-            waypoints.push_back(getWorldCenter(DiscreteRect(it->x, it->y, unit.footprintX, unit.footprintZ)));
+            waypoints.push_back(getWorldCenter(*task.terrain, DiscreteRect(it->x, it->y, task.footprintX, task.footprintZ)));
         }
 
-        return UnitPath{std::move(waypoints)};
+        return PathResult{UnitPath{std::move(waypoints)}, std::move(path)};
     }
 
-    UnitPath PathFindingService::findPath(UnitId unitId, const SimVector& destination)
+    static PathResult findPathToPosition(const PathTask& task, const SimVector& destination)
     {
-        const auto& unit = simulation->getUnit(unitId);
+        auto start = computeFootprintRegion(*task.terrain, task.position, task.footprintX, task.footprintZ);
+        auto goal = computeFootprintRegion(*task.terrain, destination, task.footprintX, task.footprintZ);
 
-        auto start = simulation->computeFootprintRegion(unit.position, unit.footprintX, unit.footprintZ);
-        auto goal = simulation->computeFootprintRegion(destination, unit.footprintX, unit.footprintZ);
+        auto findPathFrom = [&](const Point& p) {
+            UnitPathFinder pathFinder(task.occupiedGrid.get(), task.collisionMap.get(), task.walkableGrid, task.unitId, start, task.footprintX, task.footprintZ, Point(goal.x, goal.y));
+            return pathFinder.findPath(p);
+        };
 
-        UnitPathFinder pathFinder(simulation, collisionService, unitId, unit.movementClass, unit.footprintX, unit.footprintZ, Point(goal.x, goal.y));
-
-        auto path = pathFinder.findPath(Point(start.x, start.y));
-        lastPathDebugInfo = AStarPathInfo<Point, PathCost>{path.type, path.path, std::move(path.closedVertices)};
+        auto hierarchicalPath = findHierarchicalPath(task, Point(start.x, start.y), std::vector<Point>{Point(goal.x, goal.y)}, findPathFrom);
+        auto path = hierarchicalPath ? std::move(*hierarchicalPath) : findPathFrom(Point(start.x, start.y));
+        AStarPathInfo<Point, PathCost> debugInfo{path.type, path.path, std::move(path.closedVertices)};
 
         if (path.type == AStarPathType::Partial)
         {
@@ -89,7 +165,7 @@ namespace rwe
         if (path.path.size() == 1)
         {
             // The path is trivial, we are already at the goal.
-            return UnitPath{std::vector<SimVector>{destination}};
+            return PathResult{UnitPath{std::vector<SimVector>{destination}}, std::move(debugInfo)};
         }
 
         auto simplifiedPath = runSimplifyPath(path.path);
@@ -97,31 +173,218 @@ namespace rwe
         std::vector<SimVector> waypoints;
         for (auto it = ++simplifiedPath.cbegin(); it != simplifiedPath.cend(); ++it)
         {
-            waypoints.push_back(getWorldCenter(DiscreteRect(it->x, it->y, unit.footprintX, unit.footprintZ)));
+            waypoints.push_back(getWorldCenter(*task.terrain, DiscreteRect(it->x, it->y, task.footprintX, task.footprintZ)));
         }
         waypoints.back() = destination;
 
-        return UnitPath{std::move(waypoints)};
+        return PathResult{UnitPath{std::move(waypoints)}, std::move(debugInfo)};
     }
 
-    SimVector PathFindingService::getWorldCenter(const DiscreteRect& rect)
+    PathResult findPath(const PathTask& task)
     {
-        auto corner = simulation->terrain.heightmapIndexToWorldCorner(rect.x, rect.y);
+        return match(
+            task.destination,
+            [&](const SimVector& destination) { return findPathToPosition(task, destination); },
+            [&](const DiscreteRect& destination) { return findPathToRect(task, destination); });
+    }
 
-        auto halfWorldWidth = (SimScalar(rect.width) * MapTerrain::HeightTileWidthInWorldUnits) / 2_ss;
-        auto halfWorldHeight = (SimScalar(rect.height) * MapTerrain::HeightTileHeightInWorldUnits) / 2_ss;
+    PathFindingService::PathFindingService(GameSimulation* simulation, MovementClassCollisionService* collisionService, ThreadPool* threadPool)
+        : simulation(simulation), collisionService(collisionService), threadPool(threadPool)
+    {
+    }
 
-        auto center = corner + SimVector(halfWorldWidth, 0_ss, halfWorldHeight);
-        center.y = simulation->terrain.getHeightAt(center.x, center.z);
-        return center;
+    PathFindingService::~PathFindingService()
+    {
+        for (auto& pending : pendingPaths)
+        {
+            pending.result.wait();
+        }
     }
 
-    DiscreteRect PathFindingService::expandTopLeft(const DiscreteRect& rect, unsigned int width, unsigned int height)
+    void PathFindingService::update()
     {
-        return DiscreteRect(
-            rect.x - static_cast<int>(width),
-            rect.y - static_cast<int>(height),
-            rect.width + width,
-            rect.height + height);
+        applyStaticCollisionChanges();
+        applyOccupiedGridChanges();
+        deliverPaths();
+        startPathTasks();
+    }
+
+    std::vector<PendingPathSnapshot> PathFindingService::capturePendingPaths() const
+    {
+        std::vector<PendingPathSnapshot> paths;
+        for (const auto& pending : pendingPaths)
+        {
+            paths.push_back(PendingPathSnapshot{pending.dueTime, pending.unitId, pending.destination, pending.result.get().path.waypoints});
+        }
+
+        return paths;
+    }
+
+    void PathFindingService::restorePendingPaths(const std::vector<PendingPathSnapshot>& paths)
+    {
+        for (auto& pending : pendingPaths)
+        {
+            pending.result.wait();
+        }
+        pendingPaths.clear();
+
+        for (const auto& path : paths)
+        {
+            std::promise<PathResult> result;
+            result.set_value(PathResult{UnitPath{path.waypoints}, {}});
+            pendingPaths.push_back(PendingPath{path.dueTime, path.unitId, path.destination, result.get_future().share()});
+        }
+    }
+
+    void PathFindingService::applyStaticCollisionChanges()
+    {
+        if (simulation->staticCollisionChanges.empty())
+        {
+            return;
+        }
+
+        for (auto& entry : pathGraphs)
+        {
+            // Tasks in flight may still be reading the old graph,
+            // so make the changes to a copy.
+            // This is cheap, the copy shares clusters until they are rebuilt.
+            auto graph = std::make_shared<HierarchicalPathGraph>(*entry.second);
+            for (const auto& rect : simulation->staticCollisionChanges)
+            {
+                graph->invalidate(rect);
+            }
+            entry.second = std::move(graph);
+        }
+
+        simulation->staticCollisionChanges.clear();
+    }
+
+    void PathFindingService::applyOccupiedGridChanges()
+    {
+        if (simulation->occupiedGridChanges.empty())
+        {
+            return;
+        }
+
+        for (auto& entry : collisionMaps)
+        {
+            // Only this thread hands out references to the map,
+            // so if we hold the only one, no task can be reading it.
+            if (entry.second.use_count() > 1)
+            {
+                entry.second = std::make_shared<FootprintCollisionMap>(*entry.second);
+            }
+
+            for (const auto& rect : simulation->occupiedGridChanges)
+            {
+                entry.second->update(simulation->occupiedGrid, rect);
+            }
+        }
+
+        simulation->occupiedGridChanges.clear();
+    }
+
+    void PathFindingService::deliverPaths()
+    {
+        while (!pendingPaths.empty() && pendingPaths.front().dueTime <= simulation->gameTime)
+        {
+            auto& pending = pendingPaths.front();
+
+            // Blocks if the worker is running behind.
+            // The result must be delivered on exactly this tick.
+            auto result = pending.result.get();
+
+            if (auto unit = simulation->tryGetUnit(pending.unitId); unit)
+            {
+                // If the unit has been given a different destination in the meantime,
+                // this path is no use to it and a new one will already have been requested.
+                auto movingState = std::get_if<MovingState>(&unit->get().behaviourState);
+                if (movingState != nullptr && movingState->destination == pending.destination)
+                {
+                    movingState->path = PathFollowingInfo(std::move(result.path), simulation->gameTime);
+                    movingState->pathRequested = false;
+                    simulation->changedUnits.push_back(pending.unitId);
+                }
+            }
+
+            lastPathDebugInfo = std::move(result.debugInfo);
+
+            pendingPaths.pop_front();
+        }
+    }
+
+    void PathFindingService::startPathTasks()
+    {
+        auto& requests = simulation->pathRequests;
+        if (requests.empty())
+        {
+            return;
+        }
+
+        // Every task started this tick shares the same snapshot.
+        auto occupiedGrid = std::make_shared<const OccupiedGrid>(simulation->occupiedGrid);
+
+        unsigned int tasksStarted = 0;
+        while (!requests.empty() && tasksStarted < MaxTasksPerTick)
+        {
+            auto& request = requests.front();
+
+            const auto& unit = simulation->getUnit(request.unitId);
+
+            if (auto movingState = std::get_if<MovingState>(&unit.behaviourState); movingState != nullptr)
+            {
+                startPathTask(simulation->gameTime + GameTime(PathLatencyTicks), request.unitId, unit.position, movingState->destination, occupiedGrid);
+            }
+
+            requests.pop_front();
+            tasksStarted += 1;
+        }
+    }
+
+    void PathFindingService::startPathTask(GameTime dueTime, UnitId unitId, const SimVector& start, const MovingStateGoal& destination, std::shared_ptr<const OccupiedGrid> occupiedGrid)
+    {
+        const auto& unit = simulation->getUnit(unitId);
+
+        PathTask task{
+            unitId,
+            start,
+            unit.footprintX,
+            unit.footprintZ,
+            destination,
+            &simulation->terrain,
+            std::move(occupiedGrid),
+            getCollisionMap(unit.footprintX, unit.footprintZ),
+            unit.movementClass ? &collisionService->getGrid(*unit.movementClass) : nullptr,
+            unit.movementClass ? getPathGraph(*unit.movementClass, unit.footprintX, unit.footprintZ) : nullptr};
+
+        auto result = threadPool->submit([task = std::move(task)]() { return findPath(task); });
+        pendingPaths.push_back(PendingPath{dueTime, unitId, destination, result.share()});
+    }
+
+    std::shared_ptr<const HierarchicalPathGraph> PathFindingService::getPathGraph(MovementClassId movementClass, unsigned int footprintX, unsigned int footprintZ)
+    {
+        auto key = std::make_tuple(movementClass.value, footprintX, footprintZ);
+        auto it = pathGraphs.find(key);
+        if (it == pathGraphs.end())
+        {
+            const auto& walkableGrid = collisionService->getGrid(movementClass);
+            auto graph = std::make_shared<const HierarchicalPathGraph>(simulation, &walkableGrid, footprintX, footprintZ);
+            it = pathGraphs.emplace(key, std::move(graph)).first;
+        }
+
+        return it->second;
+    }
+
+    std::shared_ptr<const FootprintCollisionMap> PathFindingService::getCollisionMap(unsigned int footprintX, unsigned int footprintZ)
+    {
+        auto key = std::make_pair(footprintX, footprintZ);
+        auto it = collisionMaps.find(key);
+        if (it == collisionMaps.end())
+        {
+            auto map = std::make_shared<FootprintCollisionMap>(simulation->occupiedGrid, footprintX, footprintZ);
+            it = collisionMaps.emplace(key, std::move(map)).first;
+        }
+
+        return it->second;
     }
 }
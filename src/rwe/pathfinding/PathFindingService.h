@@ -1,58 +1,167 @@
 #pragma once
 
 #include <deque>
+#include <functional>
+#include <future>
+#include <map>
+#include <memory>
 #include <rwe/GameSimulation.h>
+#include <rwe/GameTime.h>
 #include <rwe/MovementClassCollisionService.h>
+#include <rwe/OccupiedGrid.h>
 #include <rwe/Point.h>
+#include <rwe/ThreadPool.h>
 #include <rwe/UnitId.h>
 #include <rwe/math/Vector3f.h>
 #include <rwe/pathfinding/AStarPathFinder.h>
+#include <rwe/pathfinding/FootprintCollisionMap.h>
+#include <rwe/pathfinding/HierarchicalPathGraph.h>
 #include <rwe/pathfinding/OctileDistance.h>
 #include <rwe/pathfinding/PathCost.h>
 #include <rwe/pathfinding/UnitPath.h>
+#include <rwe/snapshot/SimulationSnapshot.h>
+#include <tuple>
 
 namespace rwe
 {
+    /**
+     * Everything needed to search for one unit's path,
+     * captured on the simulation thread so that the search itself
+     * can run on a worker without touching the live simulation.
+     */
+    struct PathTask
+    {
+        UnitId unitId;
+        SimVector position;
+        unsigned int footprintX;
+        unsigned int footprintZ;
+        MovingStateGoal destination;
+
+        /** The terrain never changes during a game, so it is safe to share. */
+        const MapTerrain* terrain;
+
+        std::shared_ptr<const OccupiedGrid> occupiedGrid;
+
+        /** Describes the same snapshot as occupiedGrid, for the unit's footprint size. */
+        std::shared_ptr<const FootprintCollisionMap> collisionMap;
+
+        /** Null if the unit has no movement class. */
+        const Grid<char>* walkableGrid;
+
+        /** Null if the unit has no movement class. */
+        std::shared_ptr<const HierarchicalPathGraph> pathGraph;
+    };
+
+    struct PathResult
+    {
+        UnitPath path;
+        AStarPathInfo<Point, PathCost> debugInfo;
+    };
+
+    /**
+     * Searches for the path described by the task.
+     * This only reads from the task, so may be called from any thread.
+     */
+    PathResult findPath(const PathTask& task);
+
+    /**
+     * Services unit path requests on a pool of worker threads.
+     *
+     * Each tick, queued requests are captured as tasks against a snapshot
+     * of the occupied grid and handed to the workers.
+     * The finished paths are given to their units a fixed number of ticks later,
+     * in the order the requests were made, regardless of how quickly
+     * the workers actually got through them.
+     * This keeps the game state identical between peers.
+     * Snapshots carry the results of searches still in flight,
+     * so a peer that restores one delivers the same paths
+     * in the same order on the same ticks as a peer that kept running.
+     */
     class PathFindingService
     {
+    public:
+        /** The maximum number of path searches started each tick. */
+        static constexpr unsigned int MaxTasksPerTick = 64;
+
+        /** The number of ticks between a path search starting and its result being delivered. */
+        static constexpr unsigned int PathLatencyTicks = 2;
+
     private:
-        class FindPathVisitor
+        struct PendingPath
         {
-        private:
-            PathFindingService* svc;
+            GameTime dueTime;
             UnitId unitId;
-
-        public:
-            FindPathVisitor(PathFindingService* svc, const UnitId& unitId) : svc(svc), unitId(unitId)
-            {
-            }
-
-            UnitPath operator()(const SimVector& pos) const
-            {
-                return svc->findPath(unitId, pos);
-            }
-            UnitPath operator()(const DiscreteRect& pos) const
-            {
-                return svc->findPath(unitId, pos);
-            }
+            MovingStateGoal destination;
+            std::shared_future<PathResult> result;
         };
 
         GameSimulation* const simulation;
         MovementClassCollisionService* const collisionService;
 
+        /**
+         * Keyed by movement class and footprint size,
+         * since units of the same class may have different footprints.
+         * Built on demand the first time a unit of each kind needs a path.
+         * Graphs are never modified once shared with a task.
+         * Changes are made to a copy which then replaces the original.
+         * The copy shares every cluster that the changes do not touch.
+         */
+        std::map<std::tuple<decltype(MovementClassId::value), unsigned int, unsigned int>, std::shared_ptr<const HierarchicalPathGraph>> pathGraphs;
+
+        /**
+         * Collision maps for each footprint size that has needed a path,
+         * kept in step with the occupied grid.
+         * Maps still shared with a task are replaced rather than modified.
+         */
+        std::map<std::pair<unsigned int, unsigned int>, std::shared_ptr<FootprintCollisionMap>> collisionMaps;
+
+        std::deque<PendingPath> pendingPaths;
+
+        ThreadPool* const threadPool;
+
     public:
-        PathFindingService(GameSimulation* simulation, MovementClassCollisionService* collisionService);
+        /**
+         * The thread pool is shared with the rest of the game and outlives the service,
+         * so the destructor waits for any searches still running on it.
+         */
+        PathFindingService(GameSimulation* simulation, MovementClassCollisionService* collisionService, ThreadPool* threadPool);
+
+        ~PathFindingService();
+
+        PathFindingService(const PathFindingService&) = delete;
+        PathFindingService& operator=(const PathFindingService&) = delete;
 
         AStarPathInfo<Point, PathCost> lastPathDebugInfo;
 
         void update();
 
+        /**
+         * Describes the searches that have started but not yet been delivered,
+         * including their results.
+         * Waits for any searches still running on the workers.
+         */
+        std::vector<PendingPathSnapshot> capturePendingPaths() const;
+
+        /**
+         * Abandons the searches in progress and replaces them with the given ones,
+         * whose saved results are delivered when originally due.
+         * Call this after restoring the simulation from the same snapshot.
+         */
+        void restorePendingPaths(const std::vector<PendingPathSnapshot>& paths);
+
     private:
-        UnitPath findPath(UnitId unitId, const SimVector& destination);
-        UnitPath findPath(UnitId unitId, const DiscreteRect& destination);
+        void applyStaticCollisionChanges();
+
+        void applyOccupiedGridChanges();
+
+        void deliverPaths();
+
+        void startPathTasks();
+
+        void startPathTask(GameTime dueTime, UnitId unitId, const SimVector& start, const MovingStateGoal& destination, std::shared_ptr<const OccupiedGrid> occupiedGrid);
 
-        SimVector getWorldCenter(const DiscreteRect& discreteRect);
+        std::shared_ptr<const HierarchicalPathGraph> getPathGraph(MovementClassId movementClass, unsigned int footprintX, unsigned int footprintZ);
 
-        DiscreteRect expandTopLeft(const DiscreteRect& rect, unsigned int width, unsigned int height);
+        std::shared_ptr<const FootprintCollisionMap> getCollisionMap(unsigned int footprintX, unsigned int footprintZ);
     };
 }
@@ -3,18 +3,20 @@
 namespace rwe
 {
     UnitPathFinder::UnitPathFinder(
-        GameSimulation* simulation,
-        MovementClassCollisionService* collisionService,
+        const OccupiedGrid* occupiedGrid,
+        const FootprintCollisionMap* collisionMap,
+        const Grid<char>* walkableGrid,
         UnitId self,
-        std::optional<MovementClassId> movementClass,
+        const DiscreteRect& selfArea,
         unsigned int footprintX,
         unsigned int footprintZ,
         const Point& goal)
         : AbstractUnitPathFinder(
-            simulation,
-            collisionService,
+            occupiedGrid,
+            collisionMap,
+            walkableGrid,
             self,
-            movementClass,
+            selfArea,
             footprintX,
             footprintZ),
           goal(goal)
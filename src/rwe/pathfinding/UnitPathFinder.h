@@ -2,8 +2,6 @@
 
 #include <rwe/DiscreteRect.h>
 #include <rwe/EightWayDirection.h>
-#include <rwe/GameSimulation.h>
-#include <rwe/MovementClassCollisionService.h>
 #include <rwe/UnitId.h>
 #include <rwe/pathfinding/AStarPathFinder.h>
 #include <rwe/pathfinding/AbstractUnitPathFinder.h>
@@ -22,10 +20,11 @@ namespace rwe
 
     public:
         UnitPathFinder(
-            GameSimulation* simulation,
-            MovementClassCollisionService* collisionService,
+            const OccupiedGrid* occupiedGrid,
+            const FootprintCollisionMap* collisionMap,
+            const Grid<char>* walkableGrid,
             UnitId self,
-            std::optional<MovementClassId> movementClass,
+            const DiscreteRect& selfArea,
             unsigned int footprintX,
             unsigned int footprintZ,
             const Point& goal);
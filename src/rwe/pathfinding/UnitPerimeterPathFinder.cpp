@@ -3,17 +3,19 @@
 namespace rwe
 {
     UnitPerimeterPathFinder::UnitPerimeterPathFinder(
-        GameSimulation* simulation,
-        MovementClassCollisionService* collisionService,
+        const OccupiedGrid* occupiedGrid,
+        const FootprintCollisionMap* collisionMap,
+        const Grid<char>* walkableGrid,
         const UnitId& self,
-        const std::optional<MovementClassId>& movementClass,
+        const DiscreteRect& selfArea,
         unsigned int footprintX,
         unsigned int footprintZ,
         const DiscreteRect& goalRect)
-        : AbstractUnitPathFinder(simulation,
-            collisionService,
+        : AbstractUnitPathFinder(occupiedGrid,
+            collisionMap,
+            walkableGrid,
             self,
-            movementClass,
+            selfArea,
             footprintX,
             footprintZ),
           goalRect(goalRect)
@@ -17,10 +17,11 @@ namespace rwe
     protected:
     public:
         UnitPerimeterPathFinder(
-            GameSimulation* simulation,
-            MovementClassCollisionService* collisionService,
+            const OccupiedGrid* occupiedGrid,
+            const FootprintCollisionMap* collisionMap,
+            const Grid<char>* walkableGrid,
             const UnitId& self,
-            const std::optional<MovementClassId>& movementClass,
+            const DiscreteRect& selfArea,
             unsigned int footprintX,
             unsigned int footprintZ,
             const DiscreteRect& goalRect);
@@ -137,9 +137,15 @@ namespace rwe
 
     void serializeVector(const SimVector& v, proto::SimVector& out)
     {
-        out.set_x(simScalarToFloat(v.x));
-        out.set_y(simScalarToFloat(v.y));
-        out.set_z(simScalarToFloat(v.z));
+#ifdef RWE_FIXED_POINT_SIM
+        out.set_fixed_x(v.x.value);
+        out.set_fixed_y(v.y.value);
+        out.set_fixed_z(v.z.value);
+#else
+        out.set_x(v.x.value);
+        out.set_y(v.y.value);
+        out.set_z(v.z.value);
+#endif
     }
 
     proto::PlayerUnitCommand::IssueOrder::IssueKind
@@ -315,6 +321,20 @@ namespace rwe
 
     SimVector deserializeVector(const proto::SimVector& v)
     {
+#ifdef RWE_FIXED_POINT_SIM
+        if (!v.has_fixed_x() || !v.has_fixed_y() || !v.has_fixed_z())
+        {
+            throw std::runtime_error("Received a vector from a floating-point simulation build");
+        }
+
+        return SimVector(SimScalar::fromRaw(v.fixed_x()), SimScalar::fromRaw(v.fixed_y()), SimScalar::fromRaw(v.fixed_z()));
+#else
+        if (!v.has_x() || !v.has_y() || !v.has_z())
+        {
+            throw std::runtime_error("Received a vector from a fixed-point simulation build");
+        }
+
         return SimVector(SimScalar(v.x()), SimScalar(v.y()), SimScalar(v.z()));
+#endif
     }
 }
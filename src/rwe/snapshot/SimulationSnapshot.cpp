@@ -0,0 +1,571 @@
+#include "SimulationSnapshot.h"
+#include <algorithm>
+#include <rwe/UnitFactory.h>
+#include <rwe/overloaded.h>
+#include <sstream>
+
+namespace rwe
+{
+    template <typename T, typename Tag>
+    VectorMapLayoutSnapshot captureLayout(const VectorMap<T, Tag>& map)
+    {
+        VectorMapLayoutSnapshot layout;
+        for (const auto& id : map.getSlotIds())
+        {
+            layout.slotIds.push_back(id.value);
+        }
+        layout.freeSlots = map.getFreeSlots();
+        return layout;
+    }
+
+    template <typename T, typename Tag>
+    void restoreLayout(const VectorMapLayoutSnapshot& layout, VectorMap<T, Tag>& map)
+    {
+        std::vector<OpaqueId<unsigned int, Tag>> ids;
+        ids.reserve(layout.slotIds.size());
+        for (auto id : layout.slotIds)
+        {
+            ids.emplace_back(id);
+        }
+        map.resetLayout(ids, layout.freeSlots);
+    }
+
+    PlayerSnapshot capturePlayer(const GamePlayerInfo& p)
+    {
+        return PlayerSnapshot{
+            p.status,
+            p.metal,
+            p.maxMetal,
+            p.energy,
+            p.maxEnergy,
+            p.metalStalled,
+            p.energyStalled,
+            p.desiredMetalConsumptionBuffer,
+            p.desiredEnergyConsumptionBuffer,
+            p.previousDesiredMetalConsumptionBuffer,
+            p.previousDesiredEnergyConsumptionBuffer,
+            p.actualMetalConsumptionBuffer,
+            p.actualEnergyConsumptionBuffer,
+            p.metalProductionBuffer,
+            p.energyProductionBuffer};
+    }
+
+    void restorePlayer(const PlayerSnapshot& s, GamePlayerInfo& p)
+    {
+        p.status = s.status;
+        p.metal = s.metal;
+        p.maxMetal = s.maxMetal;
+        p.energy = s.energy;
+        p.maxEnergy = s.maxEnergy;
+        p.metalStalled = s.metalStalled;
+        p.energyStalled = s.energyStalled;
+        p.desiredMetalConsumptionBuffer = s.desiredMetalConsumptionBuffer;
+        p.desiredEnergyConsumptionBuffer = s.desiredEnergyConsumptionBuffer;
+        p.previousDesiredMetalConsumptionBuffer = s.previousDesiredMetalConsumptionBuffer;
+        p.previousDesiredEnergyConsumptionBuffer = s.previousDesiredEnergyConsumptionBuffer;
+        p.actualMetalConsumptionBuffer = s.actualMetalConsumptionBuffer;
+        p.actualEnergyConsumptionBuffer = s.actualEnergyConsumptionBuffer;
+        p.metalProductionBuffer = s.metalProductionBuffer;
+        p.energyProductionBuffer = s.energyProductionBuffer;
+    }
+
+    /** Returns the environment's live threads in snapshot order: ready, then blocked, then finished. */
+    std::vector<const CobThread*> getThreads(const CobEnvironment& env)
+    {
+        std::vector<const CobThread*> threads;
+        threads.reserve(env.readyQueue.size() + env.blockedQueue.size() + env.finishedQueue.size());
+        for (auto thread : env.readyQueue)
+        {
+            threads.push_back(thread);
+        }
+        for (auto thread : env.blockedQueue)
+        {
+            threads.push_back(thread);
+        }
+        for (auto thread : env.finishedQueue)
+        {
+            threads.push_back(thread);
+        }
+        return threads;
+    }
+
+    unsigned int getThreadIndex(const std::vector<const CobThread*>& threads, const CobThread* thread)
+    {
+        auto it = std::find(threads.begin(), threads.end(), thread);
+        if (it == threads.end())
+        {
+            throw std::logic_error("Cob thread is not owned by the environment");
+        }
+        return static_cast<unsigned int>(it - threads.begin());
+    }
+
+    std::vector<CobFunctionSnapshot> captureCallStack(const CobThread& thread)
+    {
+        std::vector<CobFunctionSnapshot> callStack;
+        for (unsigned int i = 0; i < thread.callStack.size(); ++i)
+        {
+            const auto& frame = thread.callStack[i];
+            callStack.push_back(CobFunctionSnapshot{
+                frame.instructionIndex,
+                std::vector<int>(thread.locals.begin() + frame.localsStart, thread.locals.begin() + thread.getLocalsEnd(i)),
+                frame.localCount});
+        }
+        return callStack;
+    }
+
+    CobEnvironmentSnapshot captureCobEnvironment(const CobEnvironment& env)
+    {
+        CobEnvironmentSnapshot s;
+        s.statics = env._statics;
+
+        auto threads = getThreads(env);
+        for (const auto& thread : threads)
+        {
+            s.threads.push_back(CobThreadSnapshot{
+                thread->functionId,
+                std::vector<int>(thread->stack.begin(), thread->stack.end()),
+                thread->signalMask,
+                captureCallStack(*thread),
+                thread->returnValue,
+                thread->returnLocals});
+        }
+
+        for (auto thread : env.readyQueue)
+        {
+            s.readyQueue.push_back(getThreadIndex(threads, thread));
+        }
+        for (auto thread : env.blockedQueue)
+        {
+            s.blockedQueue.push_back(BlockedCobThreadSnapshot{*thread->blockedCondition, getThreadIndex(threads, thread)});
+        }
+        for (auto thread : env.finishedQueue)
+        {
+            s.finishedQueue.push_back(getThreadIndex(threads, thread));
+        }
+
+        return s;
+    }
+
+    CobThread* getThreadAt(const std::vector<CobThread*>& threads, unsigned int index)
+    {
+        if (index >= threads.size())
+        {
+            throw std::runtime_error("Cob thread index out of range in snapshot");
+        }
+        return threads[index];
+    }
+
+    CobThread* getUnqueuedThreadAt(const std::vector<CobThread*>& threads, unsigned int index)
+    {
+        auto thread = getThreadAt(threads, index);
+        if (thread->queueLink.list != nullptr)
+        {
+            throw std::runtime_error("Cob thread is in more than one queue in snapshot");
+        }
+        return thread;
+    }
+
+    /** Returns the restored threads in snapshot order. */
+    std::vector<CobThread*> restoreCobEnvironment(const CobEnvironmentSnapshot& s, CobEnvironment& env)
+    {
+        env._statics = s.statics;
+
+        env.deleteAllThreads();
+
+        std::vector<CobThread*> threads;
+        threads.reserve(s.threads.size());
+        for (const auto& t : s.threads)
+        {
+            auto& thread = env.acquireThread(t.functionId, t.signalMask);
+            for (auto v : t.stack)
+            {
+                thread.stack.push(v);
+            }
+            for (const auto& f : t.callStack)
+            {
+                thread.pushFrame(f.instructionIndex, f.locals);
+                thread.callStack.top().localCount = f.localCount;
+            }
+            thread.returnValue = t.returnValue;
+            thread.returnLocals = t.returnLocals;
+            threads.push_back(&thread);
+        }
+
+        for (auto index : s.readyQueue)
+        {
+            env.readyQueue.push_back(getUnqueuedThreadAt(threads, index));
+        }
+        for (const auto& entry : s.blockedQueue)
+        {
+            auto thread = getUnqueuedThreadAt(threads, entry.thread);
+            thread->blockedCondition = entry.condition;
+            env.blockedQueue.push_back(thread);
+        }
+        for (auto index : s.finishedQueue)
+        {
+            env.finishedQueue.push_back(getUnqueuedThreadAt(threads, index));
+        }
+
+        if (env.readyQueue.size() + env.blockedQueue.size() + env.finishedQueue.size() != threads.size())
+        {
+            throw std::runtime_error("Cob thread is not in any queue in snapshot");
+        }
+
+        return threads;
+    }
+
+    void capturePieces(const UnitMesh& mesh, std::vector<UnitPieceSnapshot>& pieces)
+    {
+        for (unsigned int i = 0; i < mesh.pieces.size(); ++i)
+        {
+            const auto& piece = mesh.pieces[i];
+            pieces.push_back(UnitPieceSnapshot{
+                piece.visible,
+                piece.shaded,
+                piece.offset,
+                piece.rotationX,
+                piece.rotationY,
+                piece.rotationZ,
+                mesh.getMoveOperation(i, Axis::X),
+                mesh.getMoveOperation(i, Axis::Y),
+                mesh.getMoveOperation(i, Axis::Z),
+                mesh.getTurnOperation(i, Axis::X),
+                mesh.getTurnOperation(i, Axis::Y),
+                mesh.getTurnOperation(i, Axis::Z)});
+        }
+    }
+
+    void restorePieces(const std::vector<UnitPieceSnapshot>& pieces, UnitMesh& mesh)
+    {
+        if (pieces.size() != mesh.pieces.size())
+        {
+            throw std::runtime_error("Snapshot has a different number of pieces than the unit's mesh");
+        }
+
+        mesh.operations = UnitMesh::Operations();
+        for (unsigned int i = 0; i < pieces.size(); ++i)
+        {
+            const auto& p = pieces[i];
+            auto& piece = mesh.pieces[i];
+            piece.visible = p.visible;
+            piece.shaded = p.shaded;
+            piece.offset = p.offset;
+            piece.rotationX = p.rotationX;
+            piece.rotationY = p.rotationY;
+            piece.rotationZ = p.rotationZ;
+            mesh.setMoveOperation(i, Axis::X, p.xMoveOperation);
+            mesh.setMoveOperation(i, Axis::Y, p.yMoveOperation);
+            mesh.setMoveOperation(i, Axis::Z, p.zMoveOperation);
+            mesh.setTurnOperation(i, Axis::X, p.xTurnOperation);
+            mesh.setTurnOperation(i, Axis::Y, p.yTurnOperation);
+            mesh.setTurnOperation(i, Axis::Z, p.zTurnOperation);
+        }
+        mesh.invalidatePieceTransforms();
+    }
+
+    UnitWeaponSnapshot captureWeapon(const UnitWeapon& weapon, const CobEnvironment& env)
+    {
+        auto state = match(
+            weapon.state,
+            [](const UnitWeaponStateIdle&) -> UnitWeaponStateSnapshot { return UnitWeaponStateIdleSnapshot(); },
+            [&](const UnitWeaponStateAttacking& s) -> UnitWeaponStateSnapshot {
+                UnitWeaponStateAttackingSnapshot a{s.target, std::nullopt};
+                if (s.aimInfo)
+                {
+                    std::optional<unsigned int> thread;
+                    if (s.aimInfo->thread.isCurrent())
+                    {
+                        thread = getThreadIndex(getThreads(env), s.aimInfo->thread.thread);
+                    }
+                    a.aimInfo = UnitWeaponStateAttackingSnapshot::AimInfo{thread, s.aimInfo->lastHeading, s.aimInfo->lastPitch};
+                }
+                return a;
+            });
+
+        return UnitWeaponSnapshot{weapon.burstNumber, weapon.readyTime, weapon.ballisticZOffset, state};
+    }
+
+    void restoreWeapon(const UnitWeaponSnapshot& s, const std::vector<CobThread*>& threads, UnitWeapon& weapon)
+    {
+        weapon.burstNumber = s.burstNumber;
+        weapon.readyTime = s.readyTime;
+        weapon.ballisticZOffset = s.ballisticZOffset;
+        weapon.state = match(
+            s.state,
+            [](const UnitWeaponStateIdleSnapshot&) -> UnitWeaponState { return UnitWeaponStateIdle(); },
+            [&](const UnitWeaponStateAttackingSnapshot& a) -> UnitWeaponState {
+                UnitWeaponStateAttacking state(a.target);
+                if (a.aimInfo)
+                {
+                    auto thread = a.aimInfo->thread ? getThreadAt(threads, *a.aimInfo->thread)->getHandle() : CobThreadHandle();
+                    state.aimInfo = UnitWeaponStateAttacking::AimInfo{thread, a.aimInfo->lastHeading, a.aimInfo->lastPitch};
+                }
+                return state;
+            });
+    }
+
+    UnitStateSnapshot captureBehaviourState(const UnitState& state)
+    {
+        return match(
+            state,
+            [](const MovingState& s) -> UnitStateSnapshot {
+                MovingStateSnapshot m{s.destination, std::nullopt, s.pathRequested};
+                if (s.path)
+                {
+                    const auto& waypoints = s.path->path.waypoints;
+                    auto currentWaypoint = static_cast<unsigned int>(s.path->currentWaypoint - waypoints.cbegin());
+                    m.path = PathFollowingSnapshot{waypoints, s.path->pathCreationTime, currentWaypoint};
+                }
+                return m;
+            },
+            [](const auto& s) -> UnitStateSnapshot { return s; });
+    }
+
+    UnitState restoreBehaviourState(const UnitStateSnapshot& state)
+    {
+        return match(
+            state,
+            [](const MovingStateSnapshot& s) -> UnitState {
+                MovingState m{s.destination, std::nullopt, s.pathRequested};
+                if (s.path)
+                {
+                    if (s.path->currentWaypoint > s.path->waypoints.size())
+                    {
+                        throw std::runtime_error("Path waypoint index out of range in snapshot");
+                    }
+                    m.path.emplace(UnitPath{s.path->waypoints}, s.path->pathCreationTime);
+                    m.path->currentWaypoint = m.path->path.waypoints.cbegin() + s.path->currentWaypoint;
+                }
+                return m;
+            },
+            [](const auto& s) -> UnitState { return s; });
+    }
+
+    UnitSnapshot captureUnit(UnitId id, const Unit& unit)
+    {
+        UnitSnapshot s{
+            id,
+            unit.unitType,
+            unit.owner,
+            unit.position,
+            unit.rotation,
+            unit.currentSpeed,
+            unit.targetAngle,
+            unit.targetSpeed,
+            unit.hitPoints,
+            unit.lifeState,
+            std::vector<UnitOrder>(unit.orders.begin(), unit.orders.end()),
+            captureBehaviourState(unit.behaviourState),
+            unit.inBuildStance,
+            unit.yardOpen,
+            unit.inCollision,
+            {},
+            unit.fireOrders,
+            unit.buildTimeCompleted,
+            unit.activated,
+            unit.isSufficientlyPowered,
+            unit.energyProductionBuffer,
+            unit.metalProductionBuffer,
+            unit.previousEnergyConsumptionBuffer,
+            unit.previousMetalConsumptionBuffer,
+            unit.energyConsumptionBuffer,
+            unit.metalConsumptionBuffer,
+            std::vector<std::pair<std::string, int>>(unit.buildQueue.begin(), unit.buildQueue.end()),
+            unit.factoryState,
+            {},
+            captureCobEnvironment(*unit.cobEnvironment)};
+
+        for (std::size_t i = 0; i < unit.weapons.size(); ++i)
+        {
+            if (unit.weapons[i])
+            {
+                s.weapons[i] = captureWeapon(*unit.weapons[i], *unit.cobEnvironment);
+            }
+        }
+
+        capturePieces(unit.mesh, s.pieces);
+
+        return s;
+    }
+
+    void restoreUnit(const UnitSnapshot& s, Unit& unit)
+    {
+        unit.rotation = s.rotation;
+        unit.currentSpeed = s.currentSpeed;
+        unit.targetAngle = s.targetAngle;
+        unit.targetSpeed = s.targetSpeed;
+        unit.hitPoints = s.hitPoints;
+        unit.lifeState = s.lifeState;
+        unit.orders.assign(s.orders.begin(), s.orders.end());
+        unit.behaviourState = restoreBehaviourState(s.behaviourState);
+        unit.inBuildStance = s.inBuildStance;
+        unit.yardOpen = s.yardOpen;
+        unit.inCollision = s.inCollision;
+        unit.fireOrders = s.fireOrders;
+        unit.buildTimeCompleted = s.buildTimeCompleted;
+        unit.activated = s.activated;
+        unit.isSufficientlyPowered = s.isSufficientlyPowered;
+        unit.energyProductionBuffer = s.energyProductionBuffer;
+        unit.metalProductionBuffer = s.metalProductionBuffer;
+        unit.previousEnergyConsumptionBuffer = s.previousEnergyConsumptionBuffer;
+        unit.previousMetalConsumptionBuffer = s.previousMetalConsumptionBuffer;
+        unit.energyConsumptionBuffer = s.energyConsumptionBuffer;
+        unit.metalConsumptionBuffer = s.metalConsumptionBuffer;
+        unit.buildQueue.assign(s.buildQueue.begin(), s.buildQueue.end());
+        unit.factoryState = s.factoryState;
+
+        // Threads must be restored before weapons, which refer to them.
+        auto threads = restoreCobEnvironment(s.cobEnvironment, *unit.cobEnvironment);
+
+        for (std::size_t i = 0; i < unit.weapons.size(); ++i)
+        {
+            if (unit.weapons[i].has_value() != s.weapons[i].has_value())
+            {
+                throw std::runtime_error("Snapshot weapons do not match unit type " + s.unitType);
+            }
+            if (s.weapons[i])
+            {
+                restoreWeapon(*s.weapons[i], threads, *unit.weapons[i]);
+            }
+        }
+
+        restorePieces(s.pieces, unit.mesh);
+    }
+
+    SimulationSnapshot captureSnapshot(const GameSimulation& simulation)
+    {
+        SimulationSnapshot snapshot;
+        snapshot.gameTime = simulation.gameTime;
+
+        std::ostringstream rngStream;
+        rngStream << simulation.rng;
+        snapshot.rngState = rngStream.str();
+
+        snapshot.nextUnitId = simulation.nextUnitId;
+
+        for (const auto& player : simulation.players)
+        {
+            snapshot.players.push_back(capturePlayer(player));
+        }
+
+        snapshot.unitSlots = captureLayout(simulation.units);
+        for (const auto& [id, unit] : simulation.units)
+        {
+            snapshot.units.push_back(captureUnit(id, unit));
+        }
+
+        snapshot.projectileSlots = captureLayout(simulation.projectiles);
+        for (const auto& [id, projectile] : simulation.projectiles)
+        {
+            snapshot.projectiles.push_back(ProjectileSnapshot{
+                id,
+                projectile.weapon->weaponType,
+                projectile.owner,
+                projectile.position,
+                projectile.origin,
+                projectile.velocity,
+                projectile.lastSmoke,
+                projectile.dieOnFrame,
+                projectile.isDead});
+        }
+
+        snapshot.occupiedGrid = simulation.occupiedGrid;
+
+        for (const auto& request : simulation.pathRequests)
+        {
+            snapshot.pathRequests.push_back(request.unitId);
+        }
+        snapshot.unitCreationRequests.assign(simulation.unitCreationRequests.begin(), simulation.unitCreationRequests.end());
+
+        return snapshot;
+    }
+
+    void restoreSnapshot(const SimulationSnapshot& snapshot, GameSimulation& simulation, UnitFactory& unitFactory)
+    {
+        if (snapshot.players.size() != simulation.players.size())
+        {
+            throw std::runtime_error("Snapshot player count does not match the simulation");
+        }
+        if (snapshot.occupiedGrid.getWidth() != simulation.occupiedGrid.getWidth() || snapshot.occupiedGrid.getHeight() != simulation.occupiedGrid.getHeight())
+        {
+            throw std::runtime_error("Snapshot map size does not match the simulation");
+        }
+
+        for (const auto& entry : simulation.units)
+        {
+            simulation.changedUnits.push_back(entry.first);
+        }
+
+        simulation.gameTime = snapshot.gameTime;
+
+        std::istringstream rngStream(snapshot.rngState);
+        rngStream >> simulation.rng;
+        if (!rngStream)
+        {
+            throw std::runtime_error("Invalid random number generator state in snapshot");
+        }
+
+        simulation.nextUnitId = snapshot.nextUnitId;
+
+        for (std::size_t i = 0; i < snapshot.players.size(); ++i)
+        {
+            restorePlayer(snapshot.players[i], simulation.players[i]);
+        }
+
+        simulation.unitIndex = UnitSpatialIndex(simulation.occupiedGrid.getWidth(), simulation.occupiedGrid.getHeight());
+        restoreLayout(snapshot.unitSlots, simulation.units);
+        for (const auto& s : snapshot.units)
+        {
+            auto unit = unitFactory.createUnit(s.unitType, s.owner, simulation.getPlayer(s.owner).color, s.position);
+            restoreUnit(s, unit);
+
+            auto footprint = simulation.computeFootprintRegion(unit.position, unit.footprintX, unit.footprintZ);
+            simulation.units.emplaceAt(s.id, std::move(unit));
+            simulation.unitIndex.insert(s.id, footprint);
+            simulation.changedUnits.push_back(s.id);
+        }
+
+        // Sleep timers are not saved, so rebuild them from the blocked threads.
+        // Every unit checks its blocked threads once in case one was due to wake.
+        simulation.cobSleepTimers.reset(simulation.gameTime);
+        for (auto& entry : simulation.units)
+        {
+            auto& env = *entry.second.cobEnvironment;
+            env.blockedQueueDirty = true;
+            for (auto thread : env.blockedQueue)
+            {
+                if (auto sleep = std::get_if<CobEnvironment::BlockedStatus::Sleep>(&*thread->blockedCondition); sleep != nullptr)
+                {
+                    simulation.cobSleepTimers.schedule(entry.first, sleep->wakeUpTime);
+                }
+            }
+        }
+
+        restoreLayout(snapshot.projectileSlots, simulation.projectiles);
+        for (const auto& s : snapshot.projectiles)
+        {
+            auto weapon = unitFactory.createWeapon(s.weaponType);
+            auto projectile = simulation.createProjectileFromWeapon(s.owner, weapon, s.position, SimVector(0_ss, 0_ss, 0_ss), 0_ss);
+            projectile.origin = s.origin;
+            projectile.velocity = s.velocity;
+            projectile.lastSmoke = s.lastSmoke;
+            projectile.dieOnFrame = s.dieOnFrame;
+            projectile.isDead = s.isDead;
+            simulation.projectiles.emplaceAt(s.id, std::move(projectile));
+        }
+
+        simulation.occupiedGrid = snapshot.occupiedGrid;
+
+        // Everything the pathfinder knew about the grid is now stale.
+        DiscreteRect wholeGrid(0, 0, simulation.occupiedGrid.getWidth(), simulation.occupiedGrid.getHeight());
+        simulation.staticCollisionChanges.push_back(wholeGrid);
+        simulation.occupiedGridChanges.push_back(wholeGrid);
+
+        simulation.pathRequests.clear();
+        for (const auto& id : snapshot.pathRequests)
+        {
+            simulation.pathRequests.push_back(PathRequest{id});
+        }
+        simulation.unitCreationRequests.assign(snapshot.unitCreationRequests.begin(), snapshot.unitCreationRequests.end());
+    }
+}
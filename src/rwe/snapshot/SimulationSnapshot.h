@@ -0,0 +1,292 @@
+#pragma once
+
+#include <array>
+#include <optional>
+#include <rwe/DiscreteRect.h>
+#include <rwe/GameSimulation.h>
+#include <rwe/GameTime.h>
+#include <rwe/OccupiedGrid.h>
+#include <rwe/PlayerId.h>
+#include <rwe/ProjectileId.h>
+#include <rwe/SimAngle.h>
+#include <rwe/SimScalar.h>
+#include <rwe/SimVector.h>
+#include <rwe/UnitId.h>
+#include <rwe/UnitMesh.h>
+#include <rwe/UnitOrder.h>
+#include <rwe/cob/CobEnvironment.h>
+#include <string>
+#include <variant>
+#include <vector>
+
+namespace rwe
+{
+    class UnitFactory;
+
+    /**
+     * The slot layout of a VectorMap,
+     * needed to restore it such that future ids are allocated
+     * exactly as they would have been in the original.
+     */
+    struct VectorMapLayoutSnapshot
+    {
+        /** For each slot, the id of its occupant, or of the last occupant if free. */
+        std::vector<unsigned int> slotIds;
+
+        /** Indices of free slots, in the order they will be reused. */
+        std::vector<unsigned int> freeSlots;
+    };
+
+    struct PlayerSnapshot
+    {
+        GamePlayerStatus status;
+        Metal metal;
+        Metal maxMetal;
+        Energy energy;
+        Energy maxEnergy;
+        bool metalStalled;
+        bool energyStalled;
+        Metal desiredMetalConsumptionBuffer;
+        Energy desiredEnergyConsumptionBuffer;
+        Metal previousDesiredMetalConsumptionBuffer;
+        Energy previousDesiredEnergyConsumptionBuffer;
+        Metal actualMetalConsumptionBuffer;
+        Energy actualEnergyConsumptionBuffer;
+        Metal metalProductionBuffer;
+        Energy energyProductionBuffer;
+    };
+
+    struct CobFunctionSnapshot
+    {
+        unsigned int instructionIndex;
+        std::vector<int> locals;
+        unsigned int localCount;
+    };
+
+    struct CobThreadSnapshot
+    {
+        /** Index of the function in the unit's script. */
+        unsigned int functionId;
+
+        /** Bottom of the stack first. */
+        std::vector<int> stack;
+
+        unsigned int signalMask;
+
+        /** Outermost call first. */
+        std::vector<CobFunctionSnapshot> callStack;
+
+        int returnValue;
+
+        std::vector<int> returnLocals;
+    };
+
+    struct BlockedCobThreadSnapshot
+    {
+        CobEnvironment::BlockedStatus::Condition condition;
+
+        /** Index into CobEnvironmentSnapshot::threads. */
+        unsigned int thread;
+    };
+
+    /** Threads in the queues are referred to by their index into threads. */
+    struct CobEnvironmentSnapshot
+    {
+        std::vector<int> statics;
+        std::vector<CobThreadSnapshot> threads;
+        std::vector<unsigned int> readyQueue;
+        std::vector<BlockedCobThreadSnapshot> blockedQueue;
+        std::vector<unsigned int> finishedQueue;
+    };
+
+    /** The animation state of one piece of a unit's mesh. */
+    struct UnitPieceSnapshot
+    {
+        bool visible;
+        bool shaded;
+        SimVector offset;
+        SimAngle rotationX;
+        SimAngle rotationY;
+        SimAngle rotationZ;
+
+        std::optional<UnitMesh::MoveOperation> xMoveOperation;
+        std::optional<UnitMesh::MoveOperation> yMoveOperation;
+        std::optional<UnitMesh::MoveOperation> zMoveOperation;
+
+        std::optional<UnitMesh::TurnOperationUnion> xTurnOperation;
+        std::optional<UnitMesh::TurnOperationUnion> yTurnOperation;
+        std::optional<UnitMesh::TurnOperationUnion> zTurnOperation;
+    };
+
+    struct UnitWeaponStateIdleSnapshot
+    {
+    };
+
+    struct UnitWeaponStateAttackingSnapshot
+    {
+        struct AimInfo
+        {
+            /**
+             * Index into the unit's CobEnvironmentSnapshot::threads.
+             * Empty if the aiming thread has been killed since it was started.
+             */
+            std::optional<unsigned int> thread;
+            SimAngle lastHeading;
+            SimAngle lastPitch;
+        };
+
+        std::variant<UnitId, SimVector> target;
+        std::optional<AimInfo> aimInfo;
+    };
+
+    using UnitWeaponStateSnapshot = std::variant<UnitWeaponStateIdleSnapshot, UnitWeaponStateAttackingSnapshot>;
+
+    struct UnitWeaponSnapshot
+    {
+        int burstNumber;
+        GameTime readyTime;
+        SimScalar ballisticZOffset;
+        UnitWeaponStateSnapshot state;
+    };
+
+    struct PathFollowingSnapshot
+    {
+        std::vector<SimVector> waypoints;
+        GameTime pathCreationTime;
+        unsigned int currentWaypoint;
+    };
+
+    struct MovingStateSnapshot
+    {
+        MovingStateGoal destination;
+        std::optional<PathFollowingSnapshot> path;
+        bool pathRequested;
+    };
+
+    using UnitStateSnapshot = std::variant<IdleState, MovingStateSnapshot, CreatingUnitState, BuildingState>;
+
+    /**
+     * A path search that had been handed to the pathfinding workers
+     * but not yet delivered to its unit.
+     * The search ran against the grid as it was when it started,
+     * which the snapshot no longer has, so its result is saved instead
+     * and delivered on the same tick after restore.
+     */
+    struct PendingPathSnapshot
+    {
+        GameTime dueTime;
+        UnitId unitId;
+        MovingStateGoal destination;
+        std::vector<SimVector> waypoints;
+    };
+
+    /**
+     * Everything about a unit that changes during the game.
+     * Everything else is recreated from the unit's type on restore.
+     */
+    struct UnitSnapshot
+    {
+        UnitId id;
+        std::string unitType;
+        PlayerId owner;
+        SimVector position;
+        SimAngle rotation;
+        SimScalar currentSpeed;
+        SimAngle targetAngle;
+        SimScalar targetSpeed;
+        unsigned int hitPoints;
+        Unit::LifeState lifeState;
+        std::vector<UnitOrder> orders;
+        UnitStateSnapshot behaviourState;
+        bool inBuildStance;
+        bool yardOpen;
+        bool inCollision;
+        std::array<std::optional<UnitWeaponSnapshot>, 3> weapons;
+        UnitFireOrders fireOrders;
+        unsigned int buildTimeCompleted;
+        bool activated;
+        bool isSufficientlyPowered;
+        Energy energyProductionBuffer;
+        Metal metalProductionBuffer;
+        Energy previousEnergyConsumptionBuffer;
+        Metal previousMetalConsumptionBuffer;
+        Energy energyConsumptionBuffer;
+        Metal metalConsumptionBuffer;
+        std::vector<std::pair<std::string, int>> buildQueue;
+        FactoryState factoryState;
+
+        /** The state of each piece of the unit's mesh, in the same order as UnitMesh::pieces. */
+        std::vector<UnitPieceSnapshot> pieces;
+
+        CobEnvironmentSnapshot cobEnvironment;
+    };
+
+    /**
+     * Everything about a projectile that changes during the game.
+     * Everything else is recreated from the weapon that fired it on restore.
+     */
+    struct ProjectileSnapshot
+    {
+        ProjectileId id;
+        std::string weaponType;
+        PlayerId owner;
+        SimVector position;
+        SimVector origin;
+        SimVector velocity;
+        GameTime lastSmoke;
+        std::optional<GameTime> dieOnFrame;
+        bool isDead;
+    };
+
+    /**
+     * The state of a GameSimulation at the end of a tick,
+     * minus anything that is fixed when the game is loaded
+     * (terrain, features, unit and weapon definitions)
+     * and purely visual effects such as explosions and smoke.
+     *
+     * A snapshot can therefore only be restored into a simulation
+     * loaded from the same map with the same players.
+     */
+    struct SimulationSnapshot
+    {
+        /** Increment whenever the serialized form changes. */
+        static constexpr std::uint32_t FormatVersion = 7;
+
+        GameTime gameTime;
+
+        /** The state of the simulation's random number generator in its textual form. */
+        std::string rngState;
+
+        UnitId nextUnitId;
+
+        std::vector<PlayerSnapshot> players;
+
+        VectorMapLayoutSnapshot unitSlots;
+        std::vector<UnitSnapshot> units;
+
+        VectorMapLayoutSnapshot projectileSlots;
+        std::vector<ProjectileSnapshot> projectiles;
+
+        Grid<OccupiedCell> occupiedGrid;
+
+        std::vector<UnitId> pathRequests;
+        std::vector<UnitId> unitCreationRequests;
+
+        /**
+         * Searches in flight on the pathfinding workers, in delivery order.
+         * These live outside the simulation,
+         * so captureSnapshot leaves this empty and SimulationDriver fills it in.
+         */
+        std::vector<PendingPathSnapshot> pendingPaths;
+    };
+
+    SimulationSnapshot captureSnapshot(const GameSimulation& simulation);
+
+    /**
+     * Replaces the dynamic state of the simulation with the snapshot.
+     * Units and projectiles are recreated via the unit factory.
+     * The simulation must have been loaded from the same map
+     * with the same players as the one the snapshot was taken from.
+     */
+    void restoreSnapshot(const SimulationSnapshot& snapshot, GameSimulation& simulation, UnitFactory& unitFactory);
+}
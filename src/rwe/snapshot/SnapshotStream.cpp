@@ -0,0 +1,178 @@
+#include "SnapshotStream.h"
+#include <algorithm>
+#include <array>
+#include <rwe/snapshot/snapshot_io.h>
+#include <unordered_map>
+#include <zlib.h>
+
+namespace rwe
+{
+    static constexpr std::array<char, 4> SnapshotStreamMagic{'R', 'W', 'E', 'S'};
+    static constexpr std::uint32_t SnapshotStreamVersion = 3;
+
+    enum class SnapshotRecordKind : std::uint8_t
+    {
+        Keyframe = 0,
+        Delta = 1,
+    };
+
+    template <typename T>
+    static void writeStreamValue(std::ostream& stream, const T& value)
+    {
+        stream.write(reinterpret_cast<const char*>(&value), sizeof(T));
+    }
+
+    template <typename T>
+    static bool tryReadStreamValue(std::istream& stream, T& value)
+    {
+        stream.read(reinterpret_cast<char*>(&value), sizeof(T));
+        return stream.gcount() == sizeof(T);
+    }
+
+    template <typename T>
+    static T readStreamValue(std::istream& stream)
+    {
+        T value;
+        if (!tryReadStreamValue(stream, value))
+        {
+            throw SnapshotException("Unexpected end of snapshot stream");
+        }
+        return value;
+    }
+
+    /**
+     * XORs each section of the previous snapshot into the section of data with the same key,
+     * up to the length of the shorter of the two.
+     * Everything outside the sections, such as their lengths, is left alone,
+     * so the same sections are found again when undoing the XOR.
+     */
+    static void xorSections(std::vector<char>& data, const std::vector<char>& previous)
+    {
+        std::unordered_map<std::uint64_t, SnapshotSection> previousSections;
+        for (const auto& section : findSnapshotSections(previous))
+        {
+            previousSections.emplace(section.key, section);
+        }
+
+        for (const auto& section : findSnapshotSections(data))
+        {
+            auto it = previousSections.find(section.key);
+            if (it == previousSections.end())
+            {
+                continue;
+            }
+
+            const auto& previousSection = it->second;
+            auto size = std::min(section.size, previousSection.size);
+            for (std::size_t j = 0; j < size; ++j)
+            {
+                data[section.offset + j] ^= previous[previousSection.offset + j];
+            }
+        }
+    }
+
+    SnapshotStreamWriter::SnapshotStreamWriter(std::ostream* stream, unsigned int keyframeInterval)
+        : stream(stream), keyframeInterval(std::max(keyframeInterval, 1u))
+    {
+        stream->write(SnapshotStreamMagic.data(), SnapshotStreamMagic.size());
+        writeStreamValue(*stream, SnapshotStreamVersion);
+    }
+
+    void SnapshotStreamWriter::write(GameTime gameTime, const std::vector<char>& snapshot)
+    {
+        auto kind = recordsSinceKeyframe == 0 ? SnapshotRecordKind::Keyframe : SnapshotRecordKind::Delta;
+
+        auto data = snapshot;
+        if (kind == SnapshotRecordKind::Delta)
+        {
+            xorSections(data, previous);
+        }
+
+        auto compressedSize = compressBound(data.size());
+        std::vector<char> compressed(compressedSize);
+        auto result = compress2(
+            reinterpret_cast<Bytef*>(compressed.data()),
+            &compressedSize,
+            reinterpret_cast<const Bytef*>(data.data()),
+            data.size(),
+            Z_BEST_SPEED);
+        if (result != Z_OK)
+        {
+            throw SnapshotException("Failed to compress snapshot");
+        }
+
+        writeStreamValue(*stream, kind);
+        writeStreamValue(*stream, gameTime.value);
+        writeStreamValue(*stream, static_cast<std::uint32_t>(data.size()));
+        writeStreamValue(*stream, static_cast<std::uint32_t>(compressedSize));
+        stream->write(compressed.data(), compressedSize);
+
+        previous = snapshot;
+        recordsSinceKeyframe = (recordsSinceKeyframe + 1) % keyframeInterval;
+    }
+
+    SnapshotStreamReader::SnapshotStreamReader(std::istream* stream) : stream(stream)
+    {
+        std::array<char, 4> magic;
+        stream->read(magic.data(), magic.size());
+        if (stream->gcount() != static_cast<std::streamsize>(magic.size()) || magic != SnapshotStreamMagic)
+        {
+            throw SnapshotException("Not a snapshot stream");
+        }
+
+        auto version = readStreamValue<std::uint32_t>(*stream);
+        if (version != SnapshotStreamVersion)
+        {
+            throw SnapshotException("Unsupported snapshot stream version " + std::to_string(version));
+        }
+    }
+
+    std::optional<std::pair<GameTime, std::vector<char>>> SnapshotStreamReader::read()
+    {
+        SnapshotRecordKind kind;
+        if (!tryReadStreamValue(*stream, kind))
+        {
+            return std::nullopt;
+        }
+        if (kind != SnapshotRecordKind::Keyframe && kind != SnapshotRecordKind::Delta)
+        {
+            throw SnapshotException("Invalid snapshot record kind");
+        }
+        if (kind == SnapshotRecordKind::Delta && !seenKeyframe)
+        {
+            throw SnapshotException("Snapshot stream delta record has no preceding keyframe");
+        }
+
+        auto gameTime = GameTime(readStreamValue<unsigned int>(*stream));
+        auto size = readStreamValue<std::uint32_t>(*stream);
+        auto compressedSize = readStreamValue<std::uint32_t>(*stream);
+
+        std::vector<char> compressed(compressedSize);
+        stream->read(compressed.data(), compressedSize);
+        if (stream->gcount() != static_cast<std::streamsize>(compressedSize))
+        {
+            throw SnapshotException("Unexpected end of snapshot stream");
+        }
+
+        std::vector<char> data(size);
+        uLongf decompressedSize = size;
+        auto result = uncompress(
+            reinterpret_cast<Bytef*>(data.data()),
+            &decompressedSize,
+            reinterpret_cast<const Bytef*>(compressed.data()),
+            compressedSize);
+        if (result != Z_OK || decompressedSize != size)
+        {
+            throw SnapshotException("Failed to decompress snapshot record");
+        }
+
+        if (kind == SnapshotRecordKind::Delta)
+        {
+            xorSections(data, previous);
+        }
+
+        seenKeyframe = true;
+        previous = data;
+        return std::make_pair(gameTime, std::move(data));
+    }
+}
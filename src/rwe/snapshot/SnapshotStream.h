@@ -0,0 +1,61 @@
+#pragma once
+
+#include <cstdint>
+#include <istream>
+#include <optional>
+#include <ostream>
+#include <rwe/GameTime.h>
+#include <utility>
+#include <vector>
+
+namespace rwe
+{
+    /**
+     * Writes a sequence of snapshots, as produced by serializeSnapshot, to a stream.
+     *
+     * Every keyframeInterval-th record is a keyframe holding the snapshot itself.
+     * The records in between are deltas, where each section of the snapshot
+     * is XORed byte-for-byte against the same section of the previous one,
+     * as far as the shorter of the two goes.
+     * Each unit's record is its own section, matched up by unit id,
+     * so a unit whose record changes length, or that appears or disappears,
+     * doesn't disturb the deltas of the others.
+     * Consecutive snapshots are mostly identical, so deltas are mostly zeros.
+     * Every record is then zlib compressed.
+     *
+     * A reader can only start decoding from a keyframe.
+     */
+    class SnapshotStreamWriter
+    {
+    private:
+        std::ostream* stream;
+        unsigned int keyframeInterval;
+        unsigned int recordsSinceKeyframe{0};
+        std::vector<char> previous;
+
+    public:
+        SnapshotStreamWriter(std::ostream* stream, unsigned int keyframeInterval);
+
+        void write(GameTime gameTime, const std::vector<char>& snapshot);
+    };
+
+    /** Reads back the snapshots written by SnapshotStreamWriter. */
+    class SnapshotStreamReader
+    {
+    private:
+        std::istream* stream;
+        std::vector<char> previous;
+        bool seenKeyframe{false};
+
+    public:
+        /** Throws SnapshotException if the stream does not begin with a valid header. */
+        explicit SnapshotStreamReader(std::istream* stream);
+
+        /**
+         * Returns the next snapshot in the stream,
+         * or nothing if the end of the stream has been reached.
+         * Throws SnapshotException if the stream is corrupt.
+         */
+        std::optional<std::pair<GameTime, std::vector<char>>> read();
+    };
+}
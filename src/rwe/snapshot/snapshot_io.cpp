@@ -0,0 +1,1129 @@
+#include "snapshot_io.h"
+#include <cstring>
+#include <rwe/overloaded.h>
+#include <type_traits>
+#include <utility>
+
+namespace rwe
+{
+    SnapshotException::SnapshotException(const std::string& __arg) : runtime_error(__arg)
+    {
+    }
+
+    SnapshotException::SnapshotException(const char* string) : runtime_error(string)
+    {
+    }
+
+    /*
+     * Every struct in a snapshot lists its fields once, in visitFields.
+     * The binary writer, binary reader and JSON dumper all walk that list,
+     * so the three can't drift apart.
+     * The binary form is the fields in order with no names or padding,
+     * in the host's byte order.
+     */
+
+    template <typename F>
+    void visitFields(DiscreteRect& r, F&& f)
+    {
+        f("x", r.x);
+        f("y", r.y);
+        f("width", r.width);
+        f("height", r.height);
+    }
+
+    template <typename F>
+    void visitFields(IdleState&, F&&)
+    {
+    }
+
+    template <typename F>
+    void visitFields(UnitCreationStatusPending&, F&&)
+    {
+    }
+
+    template <typename F>
+    void visitFields(UnitCreationStatusFailed&, F&&)
+    {
+    }
+
+    template <typename F>
+    void visitFields(UnitCreationStatusDone& s, F&& f)
+    {
+        f("unitId", s.unitId);
+    }
+
+    template <typename F>
+    void visitFields(CreatingUnitState& s, F&& f)
+    {
+        f("unitType", s.unitType);
+        f("owner", s.owner);
+        f("position", s.position);
+        f("status", s.status);
+    }
+
+    template <typename F>
+    void visitFields(BuildingState& s, F&& f)
+    {
+        f("targetUnit", s.targetUnit);
+        f("nanoParticleOrigin", s.nanoParticleOrigin);
+    }
+
+    template <typename F>
+    void visitFields(FactoryStateIdle&, F&&)
+    {
+    }
+
+    template <typename F>
+    void visitFields(FactoryStateCreatingUnit& s, F&& f)
+    {
+        f("unitType", s.unitType);
+        f("owner", s.owner);
+        f("position", s.position);
+        f("status", s.status);
+    }
+
+    template <typename F>
+    void visitFields(FactoryStateBuilding& s, F&& f)
+    {
+        f("targetUnit", s.targetUnit);
+    }
+
+    template <typename F>
+    void visitFields(MoveOrder& o, F&& f)
+    {
+        f("destination", o.destination);
+    }
+
+    template <typename F>
+    void visitFields(AttackOrder& o, F&& f)
+    {
+        f("target", o.target);
+    }
+
+    template <typename F>
+    void visitFields(BuildOrder& o, F&& f)
+    {
+        f("unitType", o.unitType);
+        f("position", o.position);
+    }
+
+    template <typename F>
+    void visitFields(BuggerOffOrder& o, F&& f)
+    {
+        f("rect", o.rect);
+    }
+
+    template <typename F>
+    void visitFields(CompleteBuildOrder& o, F&& f)
+    {
+        f("target", o.target);
+    }
+
+    template <typename F>
+    void visitFields(UnitMesh::MoveOperation& o, F&& f)
+    {
+        f("targetPosition", o.targetPosition);
+        f("speed", o.speed);
+    }
+
+    template <typename F>
+    void visitFields(UnitMesh::TurnOperation& o, F&& f)
+    {
+        f("targetAngle", o.targetAngle);
+        f("speed", o.speed);
+    }
+
+    template <typename F>
+    void visitFields(UnitMesh::SpinOperation& o, F&& f)
+    {
+        f("currentSpeed", o.currentSpeed);
+        f("targetSpeed", o.targetSpeed);
+        f("acceleration", o.acceleration);
+    }
+
+    template <typename F>
+    void visitFields(UnitMesh::StopSpinOperation& o, F&& f)
+    {
+        f("currentSpeed", o.currentSpeed);
+        f("deceleration", o.deceleration);
+    }
+
+    template <typename F>
+    void visitFields(CobFunctionSnapshot& c, F&& f)
+    {
+        f("instructionIndex", c.instructionIndex);
+        f("locals", c.locals);
+        f("localCount", c.localCount);
+    }
+
+    template <typename F>
+    void visitFields(CobEnvironment::BlockedStatus::Move& s, F&& f)
+    {
+        f("object", s.object);
+        f("axis", s.axis);
+    }
+
+    template <typename F>
+    void visitFields(CobEnvironment::BlockedStatus::Turn& s, F&& f)
+    {
+        f("object", s.object);
+        f("axis", s.axis);
+    }
+
+    template <typename F>
+    void visitFields(CobEnvironment::BlockedStatus::Sleep& s, F&& f)
+    {
+        f("wakeUpTime", s.wakeUpTime);
+    }
+
+    template <typename F>
+    void visitFields(VectorMapLayoutSnapshot& s, F&& f)
+    {
+        f("slotIds", s.slotIds);
+        f("freeSlots", s.freeSlots);
+    }
+
+    template <typename F>
+    void visitFields(PlayerSnapshot& p, F&& f)
+    {
+        f("status", p.status);
+        f("metal", p.metal);
+        f("maxMetal", p.maxMetal);
+        f("energy", p.energy);
+        f("maxEnergy", p.maxEnergy);
+        f("metalStalled", p.metalStalled);
+        f("energyStalled", p.energyStalled);
+        f("desiredMetalConsumptionBuffer", p.desiredMetalConsumptionBuffer);
+        f("desiredEnergyConsumptionBuffer", p.desiredEnergyConsumptionBuffer);
+        f("previousDesiredMetalConsumptionBuffer", p.previousDesiredMetalConsumptionBuffer);
+        f("previousDesiredEnergyConsumptionBuffer", p.previousDesiredEnergyConsumptionBuffer);
+        f("actualMetalConsumptionBuffer", p.actualMetalConsumptionBuffer);
+        f("actualEnergyConsumptionBuffer", p.actualEnergyConsumptionBuffer);
+        f("metalProductionBuffer", p.metalProductionBuffer);
+        f("energyProductionBuffer", p.energyProductionBuffer);
+    }
+
+    template <typename F>
+    void visitFields(CobThreadSnapshot& t, F&& f)
+    {
+        f("functionId", t.functionId);
+        f("stack", t.stack);
+        f("signalMask", t.signalMask);
+        f("callStack", t.callStack);
+        f("returnValue", t.returnValue);
+        f("returnLocals", t.returnLocals);
+    }
+
+    template <typename F>
+    void visitFields(BlockedCobThreadSnapshot& t, F&& f)
+    {
+        f("condition", t.condition);
+        f("thread", t.thread);
+    }
+
+    template <typename F>
+    void visitFields(CobEnvironmentSnapshot& e, F&& f)
+    {
+        f("statics", e.statics);
+        f("threads", e.threads);
+        f("readyQueue", e.readyQueue);
+        f("blockedQueue", e.blockedQueue);
+        f("finishedQueue", e.finishedQueue);
+    }
+
+    template <typename F>
+    void visitFields(UnitPieceSnapshot& p, F&& f)
+    {
+        f("visible", p.visible);
+        f("shaded", p.shaded);
+        f("offset", p.offset);
+        f("rotationX", p.rotationX);
+        f("rotationY", p.rotationY);
+        f("rotationZ", p.rotationZ);
+        f("xMoveOperation", p.xMoveOperation);
+        f("yMoveOperation", p.yMoveOperation);
+        f("zMoveOperation", p.zMoveOperation);
+        f("xTurnOperation", p.xTurnOperation);
+        f("yTurnOperation", p.yTurnOperation);
+        f("zTurnOperation", p.zTurnOperation);
+    }
+
+    template <typename F>
+    void visitFields(UnitWeaponStateIdleSnapshot&, F&&)
+    {
+    }
+
+    template <typename F>
+    void visitFields(UnitWeaponStateAttackingSnapshot::AimInfo& a, F&& f)
+    {
+        f("thread", a.thread);
+        f("lastHeading", a.lastHeading);
+        f("lastPitch", a.lastPitch);
+    }
+
+    template <typename F>
+    void visitFields(UnitWeaponStateAttackingSnapshot& s, F&& f)
+    {
+        f("target", s.target);
+        f("aimInfo", s.aimInfo);
+    }
+
+    template <typename F>
+    void visitFields(UnitWeaponSnapshot& w, F&& f)
+    {
+        f("burstNumber", w.burstNumber);
+        f("readyTime", w.readyTime);
+        f("ballisticZOffset", w.ballisticZOffset);
+        f("state", w.state);
+    }
+
+    template <typename F>
+    void visitFields(PathFollowingSnapshot& p, F&& f)
+    {
+        f("waypoints", p.waypoints);
+        f("pathCreationTime", p.pathCreationTime);
+        f("currentWaypoint", p.currentWaypoint);
+    }
+
+    template <typename F>
+    void visitFields(MovingStateSnapshot& m, F&& f)
+    {
+        f("destination", m.destination);
+        f("path", m.path);
+        f("pathRequested", m.pathRequested);
+    }
+
+    template <typename F>
+    void visitFields(UnitSnapshot& u, F&& f)
+    {
+        f("id", u.id);
+        f("unitType", u.unitType);
+        f("owner", u.owner);
+        f("position", u.position);
+        f("rotation", u.rotation);
+        f("currentSpeed", u.currentSpeed);
+        f("targetAngle", u.targetAngle);
+        f("targetSpeed", u.targetSpeed);
+        f("hitPoints", u.hitPoints);
+        f("lifeState", u.lifeState);
+        f("orders", u.orders);
+        f("behaviourState", u.behaviourState);
+        f("inBuildStance", u.inBuildStance);
+        f("yardOpen", u.yardOpen);
+        f("inCollision", u.inCollision);
+        f("weapons", u.weapons);
+        f("fireOrders", u.fireOrders);
+        f("buildTimeCompleted", u.buildTimeCompleted);
+        f("activated", u.activated);
+        f("isSufficientlyPowered", u.isSufficientlyPowered);
+        f("energyProductionBuffer", u.energyProductionBuffer);
+        f("metalProductionBuffer", u.metalProductionBuffer);
+        f("previousEnergyConsumptionBuffer", u.previousEnergyConsumptionBuffer);
+        f("previousMetalConsumptionBuffer", u.previousMetalConsumptionBuffer);
+        f("energyConsumptionBuffer", u.energyConsumptionBuffer);
+        f("metalConsumptionBuffer", u.metalConsumptionBuffer);
+        f("buildQueue", u.buildQueue);
+        f("factoryState", u.factoryState);
+        f("pieces", u.pieces);
+        f("cobEnvironment", u.cobEnvironment);
+    }
+
+    template <typename F>
+    void visitFields(ProjectileSnapshot& p, F&& f)
+    {
+        f("id", p.id);
+        f("weaponType", p.weaponType);
+        f("owner", p.owner);
+        f("position", p.position);
+        f("origin", p.origin);
+        f("velocity", p.velocity);
+        f("lastSmoke", p.lastSmoke);
+        f("dieOnFrame", p.dieOnFrame);
+        f("isDead", p.isDead);
+    }
+
+    template <typename F>
+    void visitFields(PendingPathSnapshot& p, F&& f)
+    {
+        f("dueTime", p.dueTime);
+        f("unitId", p.unitId);
+        f("destination", p.destination);
+        f("waypoints", p.waypoints);
+    }
+
+    template <typename F>
+    void visitFields(SimulationSnapshot& s, F&& f)
+    {
+        // Each field is written as its own length-prefixed section, in this order.
+        // findSnapshotSections keys the sections by their position here.
+        f("occupiedGrid", s.occupiedGrid);
+        f("gameTime", s.gameTime);
+        f("nextUnitId", s.nextUnitId);
+        f("players", s.players);
+        f("rngState", s.rngState);
+        f("unitSlots", s.unitSlots);
+        f("units", s.units);
+        f("projectileSlots", s.projectileSlots);
+        f("projectiles", s.projectiles);
+        f("pathRequests", s.pathRequests);
+        f("unitCreationRequests", s.unitCreationRequests);
+        f("pendingPaths", s.pendingPaths);
+    }
+
+    /**
+     * Creates a placeholder value to be overwritten by the reader,
+     * for types that have no default constructor.
+     */
+    template <typename T>
+    struct SnapshotPlaceholder
+    {
+        static T create() { return T(); }
+    };
+
+    template <typename T, typename... Ts>
+    struct SnapshotPlaceholder<std::variant<T, Ts...>>
+    {
+        static std::variant<T, Ts...> create() { return std::variant<T, Ts...>(std::in_place_index<0>, SnapshotPlaceholder<T>::create()); }
+    };
+
+    template <>
+    struct SnapshotPlaceholder<MoveOrder>
+    {
+        static MoveOrder create() { return MoveOrder(SimVector()); }
+    };
+
+    template <>
+    struct SnapshotPlaceholder<AttackOrder>
+    {
+        static AttackOrder create() { return AttackOrder(UnitId()); }
+    };
+
+    template <>
+    struct SnapshotPlaceholder<BuildOrder>
+    {
+        static BuildOrder create() { return BuildOrder(std::string(), SimVector()); }
+    };
+
+    template <>
+    struct SnapshotPlaceholder<BuggerOffOrder>
+    {
+        static BuggerOffOrder create() { return BuggerOffOrder(DiscreteRect()); }
+    };
+
+    template <>
+    struct SnapshotPlaceholder<CompleteBuildOrder>
+    {
+        static CompleteBuildOrder create() { return CompleteBuildOrder(UnitId()); }
+    };
+
+    template <>
+    struct SnapshotPlaceholder<UnitMesh::MoveOperation>
+    {
+        static UnitMesh::MoveOperation create() { return UnitMesh::MoveOperation(SimScalar(), SimScalar()); }
+    };
+
+    template <>
+    struct SnapshotPlaceholder<UnitMesh::TurnOperation>
+    {
+        static UnitMesh::TurnOperation create() { return UnitMesh::TurnOperation(SimAngle(), SimScalar()); }
+    };
+
+    template <>
+    struct SnapshotPlaceholder<UnitMesh::SpinOperation>
+    {
+        static UnitMesh::SpinOperation create() { return UnitMesh::SpinOperation(SimScalar(), SimScalar(), SimScalar()); }
+    };
+
+    template <>
+    struct SnapshotPlaceholder<UnitMesh::StopSpinOperation>
+    {
+        static UnitMesh::StopSpinOperation create() { return UnitMesh::StopSpinOperation(SimScalar(), SimScalar()); }
+    };
+
+    template <>
+    struct SnapshotPlaceholder<CobFunctionSnapshot>
+    {
+        static CobFunctionSnapshot create() { return CobFunctionSnapshot{0, {}, 0}; }
+    };
+
+    template <>
+    struct SnapshotPlaceholder<CobEnvironment::BlockedStatus::Move>
+    {
+        static CobEnvironment::BlockedStatus::Move create() { return CobEnvironment::BlockedStatus::Move(0, Axis::X); }
+    };
+
+    template <>
+    struct SnapshotPlaceholder<CobEnvironment::BlockedStatus::Turn>
+    {
+        static CobEnvironment::BlockedStatus::Turn create() { return CobEnvironment::BlockedStatus::Turn(0, Axis::X); }
+    };
+
+    template <>
+    struct SnapshotPlaceholder<CobEnvironment::BlockedStatus::Sleep>
+    {
+        static CobEnvironment::BlockedStatus::Sleep create() { return CobEnvironment::BlockedStatus::Sleep(GameTime(0)); }
+    };
+
+    template <>
+    struct SnapshotPlaceholder<BlockedCobThreadSnapshot>
+    {
+        static BlockedCobThreadSnapshot create() { return BlockedCobThreadSnapshot{CobEnvironment::BlockedStatus::Sleep(GameTime(0)), 0}; }
+    };
+
+    class SnapshotWriter
+    {
+    private:
+        std::vector<char>* buffer;
+
+    public:
+        explicit SnapshotWriter(std::vector<char>* buffer) : buffer(buffer)
+        {
+        }
+
+        template <typename T>
+        void writeRaw(const T& value)
+        {
+            static_assert(std::is_trivially_copyable_v<T>);
+            auto p = reinterpret_cast<const char*>(&value);
+            buffer->insert(buffer->end(), p, p + sizeof(T));
+        }
+
+        void writeBytes(const char* data, std::size_t size)
+        {
+            buffer->insert(buffer->end(), data, data + size);
+        }
+    };
+
+    class SnapshotReader
+    {
+    private:
+        const char* it;
+        const char* end;
+
+    public:
+        SnapshotReader(const char* begin, const char* end) : it(begin), end(end)
+        {
+        }
+
+        template <typename T>
+        T readRaw()
+        {
+            static_assert(std::is_trivially_copyable_v<T>);
+            T value;
+            readBytes(reinterpret_cast<char*>(&value), sizeof(T));
+            return value;
+        }
+
+        void readBytes(char* out, std::size_t size)
+        {
+            if (remaining() < size)
+            {
+                throw SnapshotException("Unexpected end of snapshot data");
+            }
+            std::memcpy(out, it, size);
+            it += size;
+        }
+
+        /** Reads an element count, rejecting counts that the remaining data can't possibly hold. */
+        std::size_t readCount()
+        {
+            auto count = readRaw<std::uint32_t>();
+            if (count > remaining())
+            {
+                throw SnapshotException("Snapshot element count is larger than the remaining data");
+            }
+            return count;
+        }
+
+        void skip(std::size_t size)
+        {
+            if (remaining() < size)
+            {
+                throw SnapshotException("Unexpected end of snapshot data");
+            }
+            it += size;
+        }
+
+        std::size_t remaining() const
+        {
+            return static_cast<std::size_t>(end - it);
+        }
+    };
+
+    /** Accepts any function for visitFields, used to detect snapshot structs. */
+    struct AnyFieldVisitor
+    {
+        template <typename T>
+        void operator()(const char*, T&)
+        {
+        }
+    };
+
+    template <typename T>
+    using IsSnapshotStruct = decltype(visitFields(std::declval<T&>(), std::declval<AnyFieldVisitor&>()));
+
+    // Declarations, so that the templates below can find each other.
+
+    template <typename T, std::enable_if_t<std::is_arithmetic_v<T>, int> = 0>
+    void writeValue(SnapshotWriter& w, const T& v);
+    template <typename T, std::enable_if_t<std::is_enum_v<T>, int> = 0>
+    void writeValue(SnapshotWriter& w, const T& v);
+    template <typename T, typename Tag>
+    void writeValue(SnapshotWriter& w, const OpaqueId<T, Tag>& v);
+    template <typename T>
+    void writeValue(SnapshotWriter& w, const Vector3x<T>& v);
+    void writeValue(SnapshotWriter& w, const std::string& v);
+    void writeValue(SnapshotWriter& w, const Grid<OccupiedCell>& v);
+    void writeValue(SnapshotWriter& w, const std::vector<UnitSnapshot>& v);
+    template <typename T>
+    void writeValue(SnapshotWriter& w, const std::vector<T>& v);
+    template <typename T, std::size_t N>
+    void writeValue(SnapshotWriter& w, const std::array<T, N>& v);
+    template <typename T>
+    void writeValue(SnapshotWriter& w, const std::optional<T>& v);
+    template <typename A, typename B>
+    void writeValue(SnapshotWriter& w, const std::pair<A, B>& v);
+    template <typename... Ts>
+    void writeValue(SnapshotWriter& w, const std::variant<Ts...>& v);
+    template <typename T, typename = IsSnapshotStruct<T>>
+    void writeValue(SnapshotWriter& w, const T& v);
+
+    template <typename T, std::enable_if_t<std::is_arithmetic_v<T>, int> = 0>
+    void readValue(SnapshotReader& r, T& v);
+    template <typename T, std::enable_if_t<std::is_enum_v<T>, int> = 0>
+    void readValue(SnapshotReader& r, T& v);
+    template <typename T, typename Tag>
+    void readValue(SnapshotReader& r, OpaqueId<T, Tag>& v);
+    template <typename T>
+    void readValue(SnapshotReader& r, Vector3x<T>& v);
+    void readValue(SnapshotReader& r, std::string& v);
+    void readValue(SnapshotReader& r, Grid<OccupiedCell>& v);
+    void readValue(SnapshotReader& r, std::vector<UnitSnapshot>& v);
+    template <typename T>
+    void readValue(SnapshotReader& r, std::vector<T>& v);
+    template <typename T, std::size_t N>
+    void readValue(SnapshotReader& r, std::array<T, N>& v);
+    template <typename T>
+    void readValue(SnapshotReader& r, std::optional<T>& v);
+    template <typename A, typename B>
+    void readValue(SnapshotReader& r, std::pair<A, B>& v);
+    template <typename... Ts>
+    void readValue(SnapshotReader& r, std::variant<Ts...>& v);
+    template <typename T, typename = IsSnapshotStruct<T>>
+    void readValue(SnapshotReader& r, T& v);
+
+    template <typename T, std::enable_if_t<std::is_arithmetic_v<T>, int> = 0>
+    nlohmann::json valueToJson(const T& v);
+    template <typename T, std::enable_if_t<std::is_enum_v<T>, int> = 0>
+    nlohmann::json valueToJson(const T& v);
+    template <typename T, typename Tag>
+    nlohmann::json valueToJson(const OpaqueId<T, Tag>& v);
+    template <typename T>
+    nlohmann::json valueToJson(const Vector3x<T>& v);
+    nlohmann::json valueToJson(const std::string& v);
+    nlohmann::json valueToJson(const Grid<OccupiedCell>& v);
+    template <typename T>
+    nlohmann::json valueToJson(const std::vector<T>& v);
+    template <typename T, std::size_t N>
+    nlohmann::json valueToJson(const std::array<T, N>& v);
+    template <typename T>
+    nlohmann::json valueToJson(const std::optional<T>& v);
+    template <typename A, typename B>
+    nlohmann::json valueToJson(const std::pair<A, B>& v);
+    template <typename... Ts>
+    nlohmann::json valueToJson(const std::variant<Ts...>& v);
+    template <typename T, typename = IsSnapshotStruct<T>>
+    nlohmann::json valueToJson(const T& v);
+
+    // Writing
+
+    template <typename T, std::enable_if_t<std::is_arithmetic_v<T>, int>>
+    void writeValue(SnapshotWriter& w, const T& v)
+    {
+        w.writeRaw(v);
+    }
+
+    template <typename T, std::enable_if_t<std::is_enum_v<T>, int>>
+    void writeValue(SnapshotWriter& w, const T& v)
+    {
+        w.writeRaw(static_cast<std::underlying_type_t<T>>(v));
+    }
+
+    template <typename T, typename Tag>
+    void writeValue(SnapshotWriter& w, const OpaqueId<T, Tag>& v)
+    {
+        writeValue(w, v.value);
+    }
+
+    template <typename T>
+    void writeValue(SnapshotWriter& w, const Vector3x<T>& v)
+    {
+        writeValue(w, v.x);
+        writeValue(w, v.y);
+        writeValue(w, v.z);
+    }
+
+    void writeValue(SnapshotWriter& w, const std::string& v)
+    {
+        w.writeRaw(static_cast<std::uint32_t>(v.size()));
+        w.writeBytes(v.data(), v.size());
+    }
+
+    void writeValue(SnapshotWriter& w, const Grid<OccupiedCell>& v)
+    {
+        static_assert(std::is_trivially_copyable_v<OccupiedCell>);
+        w.writeRaw(static_cast<std::uint32_t>(v.getWidth()));
+        w.writeRaw(static_cast<std::uint32_t>(v.getHeight()));
+        w.writeBytes(reinterpret_cast<const char*>(v.getData()), v.getWidth() * v.getHeight() * sizeof(OccupiedCell));
+    }
+
+    void writeValue(SnapshotWriter& w, const std::vector<UnitSnapshot>& v)
+    {
+        // Each unit's record is prefixed with its length,
+        // so that findSnapshotSections can pick out the records of individual units.
+        w.writeRaw(static_cast<std::uint32_t>(v.size()));
+        std::vector<char> record;
+        for (const auto& e : v)
+        {
+            record.clear();
+            SnapshotWriter recordWriter(&record);
+            writeValue(recordWriter, e);
+            w.writeRaw(static_cast<std::uint32_t>(record.size()));
+            w.writeBytes(record.data(), record.size());
+        }
+    }
+
+    template <typename T>
+    void writeValue(SnapshotWriter& w, const std::vector<T>& v)
+    {
+        w.writeRaw(static_cast<std::uint32_t>(v.size()));
+        for (const auto& e : v)
+        {
+            writeValue(w, e);
+        }
+    }
+
+    template <typename T, std::size_t N>
+    void writeValue(SnapshotWriter& w, const std::array<T, N>& v)
+    {
+        for (const auto& e : v)
+        {
+            writeValue(w, e);
+        }
+    }
+
+    template <typename T>
+    void writeValue(SnapshotWriter& w, const std::optional<T>& v)
+    {
+        writeValue(w, v.has_value());
+        if (v)
+        {
+            writeValue(w, *v);
+        }
+    }
+
+    template <typename A, typename B>
+    void writeValue(SnapshotWriter& w, const std::pair<A, B>& v)
+    {
+        writeValue(w, v.first);
+        writeValue(w, v.second);
+    }
+
+    template <typename... Ts>
+    void writeValue(SnapshotWriter& w, const std::variant<Ts...>& v)
+    {
+        static_assert(sizeof...(Ts) <= 256);
+        w.writeRaw(static_cast<std::uint8_t>(v.index()));
+        std::visit([&w](const auto& x) { writeValue(w, x); }, v);
+    }
+
+    template <typename T, typename>
+    void writeValue(SnapshotWriter& w, const T& v)
+    {
+        // visitFields doesn't modify anything, it's just not const-generic
+        visitFields(const_cast<T&>(v), [&w](const char*, const auto& field) { writeValue(w, field); });
+    }
+
+    // Reading
+
+    template <typename T, std::enable_if_t<std::is_arithmetic_v<T>, int>>
+    void readValue(SnapshotReader& r, T& v)
+    {
+        v = r.readRaw<T>();
+    }
+
+    template <typename T, std::enable_if_t<std::is_enum_v<T>, int>>
+    void readValue(SnapshotReader& r, T& v)
+    {
+        v = static_cast<T>(r.readRaw<std::underlying_type_t<T>>());
+    }
+
+    template <typename T, typename Tag>
+    void readValue(SnapshotReader& r, OpaqueId<T, Tag>& v)
+    {
+        readValue(r, v.value);
+    }
+
+    template <typename T>
+    void readValue(SnapshotReader& r, Vector3x<T>& v)
+    {
+        readValue(r, v.x);
+        readValue(r, v.y);
+        readValue(r, v.z);
+    }
+
+    void readValue(SnapshotReader& r, std::string& v)
+    {
+        v.resize(r.readCount());
+        r.readBytes(v.data(), v.size());
+    }
+
+    void readValue(SnapshotReader& r, Grid<OccupiedCell>& v)
+    {
+        auto width = r.readRaw<std::uint32_t>();
+        auto height = r.readRaw<std::uint32_t>();
+        auto size = static_cast<std::size_t>(width) * height;
+        if (size > r.remaining() / sizeof(OccupiedCell))
+        {
+            throw SnapshotException("Snapshot grid is larger than the remaining data");
+        }
+
+        std::vector<OccupiedCell> data(size);
+        r.readBytes(reinterpret_cast<char*>(data.data()), size * sizeof(OccupiedCell));
+        v = Grid<OccupiedCell>(width, height, std::move(data));
+    }
+
+    void readValue(SnapshotReader& r, std::vector<UnitSnapshot>& v)
+    {
+        auto count = r.readCount();
+        v.clear();
+        v.reserve(count);
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            auto length = r.readRaw<std::uint32_t>();
+            if (length > r.remaining())
+            {
+                throw SnapshotException("Snapshot unit record is truncated");
+            }
+
+            auto remainingBefore = r.remaining();
+            auto e = SnapshotPlaceholder<UnitSnapshot>::create();
+            readValue(r, e);
+            if (remainingBefore - r.remaining() != length)
+            {
+                throw SnapshotException("Snapshot unit record does not match its length");
+            }
+            v.push_back(std::move(e));
+        }
+    }
+
+    template <typename T>
+    void readValue(SnapshotReader& r, std::vector<T>& v)
+    {
+        auto count = r.readCount();
+        v.clear();
+        v.reserve(count);
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            auto e = SnapshotPlaceholder<T>::create();
+            readValue(r, e);
+            v.push_back(std::move(e));
+        }
+    }
+
+    template <typename T, std::size_t N>
+    void readValue(SnapshotReader& r, std::array<T, N>& v)
+    {
+        for (auto& e : v)
+        {
+            readValue(r, e);
+        }
+    }
+
+    template <typename T>
+    void readValue(SnapshotReader& r, std::optional<T>& v)
+    {
+        bool present;
+        readValue(r, present);
+        if (!present)
+        {
+            v = std::nullopt;
+            return;
+        }
+
+        auto e = SnapshotPlaceholder<T>::create();
+        readValue(r, e);
+        v = std::move(e);
+    }
+
+    template <typename A, typename B>
+    void readValue(SnapshotReader& r, std::pair<A, B>& v)
+    {
+        readValue(r, v.first);
+        readValue(r, v.second);
+    }
+
+    template <typename V, std::size_t I>
+    V readVariantAlternative(SnapshotReader& r)
+    {
+        auto e = SnapshotPlaceholder<std::variant_alternative_t<I, V>>::create();
+        readValue(r, e);
+        return V(std::in_place_index<I>, std::move(e));
+    }
+
+    template <typename V, std::size_t... Is>
+    V readVariant(SnapshotReader& r, std::size_t index, std::index_sequence<Is...>)
+    {
+        using Reader = V (*)(SnapshotReader&);
+        static constexpr Reader readers[] = {&readVariantAlternative<V, Is>...};
+        return readers[index](r);
+    }
+
+    template <typename... Ts>
+    void readValue(SnapshotReader& r, std::variant<Ts...>& v)
+    {
+        auto index = r.readRaw<std::uint8_t>();
+        if (index >= sizeof...(Ts))
+        {
+            throw SnapshotException("Invalid variant index in snapshot");
+        }
+        v = readVariant<std::variant<Ts...>>(r, index, std::index_sequence_for<Ts...>());
+    }
+
+    template <typename T, typename>
+    void readValue(SnapshotReader& r, T& v)
+    {
+        visitFields(v, [&r](const char*, auto& field) { readValue(r, field); });
+    }
+
+    // JSON
+
+    template <typename T, std::enable_if_t<std::is_arithmetic_v<T>, int>>
+    nlohmann::json valueToJson(const T& v)
+    {
+        return v;
+    }
+
+    template <typename T, std::enable_if_t<std::is_enum_v<T>, int>>
+    nlohmann::json valueToJson(const T& v)
+    {
+        return static_cast<std::underlying_type_t<T>>(v);
+    }
+
+    template <typename T, typename Tag>
+    nlohmann::json valueToJson(const OpaqueId<T, Tag>& v)
+    {
+        return valueToJson(v.value);
+    }
+
+    template <typename T>
+    nlohmann::json valueToJson(const Vector3x<T>& v)
+    {
+        return nlohmann::json{
+            {"x", valueToJson(v.x)},
+            {"y", valueToJson(v.y)},
+            {"z", valueToJson(v.z)}};
+    }
+
+    nlohmann::json valueToJson(const std::string& v)
+    {
+        return v;
+    }
+
+    nlohmann::json valueToJson(const Grid<OccupiedCell>& v)
+    {
+        // Only list the cells that have something in them,
+        // most of the map is usually empty.
+        nlohmann::json cells = nlohmann::json::array();
+        for (std::size_t y = 0; y < v.getHeight(); ++y)
+        {
+            for (std::size_t x = 0; x < v.getWidth(); ++x)
+            {
+                const auto& cell = v.get(x, y);
+                if (cell == OccupiedCell())
+                {
+                    continue;
+                }
+
+                nlohmann::json j{{"x", x}, {"y", y}};
+                if (auto unit = cell.getUnit(); unit)
+                {
+                    j["unit"] = unit->value;
+                }
+                if (auto feature = cell.getFeature(); feature)
+                {
+                    j["feature"] = feature->value;
+                }
+                if (auto building = cell.getBuildingCell(); building)
+                {
+                    j["building"] = building->unit.value;
+                    j["passable"] = building->passable;
+                }
+                cells.push_back(std::move(j));
+            }
+        }
+
+        return nlohmann::json{
+            {"width", v.getWidth()},
+            {"height", v.getHeight()},
+            {"cells", std::move(cells)}};
+    }
+
+    template <typename T>
+    nlohmann::json valueToJson(const std::vector<T>& v)
+    {
+        nlohmann::json j = nlohmann::json::array();
+        for (const auto& e : v)
+        {
+            j.push_back(valueToJson(e));
+        }
+        return j;
+    }
+
+    template <typename T, std::size_t N>
+    nlohmann::json valueToJson(const std::array<T, N>& v)
+    {
+        nlohmann::json j = nlohmann::json::array();
+        for (const auto& e : v)
+        {
+            j.push_back(valueToJson(e));
+        }
+        return j;
+    }
+
+    template <typename T>
+    nlohmann::json valueToJson(const std::optional<T>& v)
+    {
+        return v ? valueToJson(*v) : nlohmann::json();
+    }
+
+    template <typename A, typename B>
+    nlohmann::json valueToJson(const std::pair<A, B>& v)
+    {
+        return nlohmann::json{
+            {"first", valueToJson(v.first)},
+            {"second", valueToJson(v.second)}};
+    }
+
+    template <typename... Ts>
+    nlohmann::json valueToJson(const std::variant<Ts...>& v)
+    {
+        nlohmann::json j;
+        j["variant"] = v.index();
+        j["data"] = std::visit([](const auto& x) { return valueToJson(x); }, v);
+        return j;
+    }
+
+    template <typename T, typename>
+    nlohmann::json valueToJson(const T& v)
+    {
+        nlohmann::json j = nlohmann::json::object();
+        visitFields(const_cast<T&>(v), [&j](const char* name, const auto& field) { j[name] = valueToJson(field); });
+        return j;
+    }
+
+    std::vector<char> serializeSnapshot(const SimulationSnapshot& snapshot)
+    {
+        std::vector<char> buffer;
+        SnapshotWriter writer(&buffer);
+        writer.writeRaw(SimulationSnapshot::FormatVersion);
+        visitFields(const_cast<SimulationSnapshot&>(snapshot), [&](const char*, const auto& field) {
+            auto lengthOffset = buffer.size();
+            writer.writeRaw(std::uint32_t(0));
+            writeValue(writer, field);
+            auto length = static_cast<std::uint32_t>(buffer.size() - lengthOffset - sizeof(std::uint32_t));
+            std::memcpy(buffer.data() + lengthOffset, &length, sizeof(length));
+        });
+        return buffer;
+    }
+
+    SimulationSnapshot deserializeSnapshot(const std::vector<char>& data)
+    {
+        SnapshotReader reader(data.data(), data.data() + data.size());
+        auto version = reader.readRaw<std::uint32_t>();
+        if (version != SimulationSnapshot::FormatVersion)
+        {
+            throw SnapshotException("Unsupported snapshot format version " + std::to_string(version) + ", expected " + std::to_string(SimulationSnapshot::FormatVersion));
+        }
+
+        SimulationSnapshot snapshot;
+        visitFields(snapshot, [&reader](const char* name, auto& field) {
+            auto length = reader.readRaw<std::uint32_t>();
+            if (length > reader.remaining())
+            {
+                throw SnapshotException(std::string("Snapshot section ") + name + " is truncated");
+            }
+
+            auto remainingBefore = reader.remaining();
+            readValue(reader, field);
+            if (remainingBefore - reader.remaining() != length)
+            {
+                throw SnapshotException(std::string("Snapshot section ") + name + " does not match its length");
+            }
+        });
+
+        if (reader.remaining() != 0)
+        {
+            throw SnapshotException("Unexpected trailing data after snapshot");
+        }
+
+        return snapshot;
+    }
+
+    std::vector<SnapshotSection> findSnapshotSections(const std::vector<char>& data)
+    {
+        SnapshotReader reader(data.data(), data.data() + data.size());
+        auto version = reader.readRaw<std::uint32_t>();
+        if (version != SimulationSnapshot::FormatVersion)
+        {
+            throw SnapshotException("Unsupported snapshot format version " + std::to_string(version) + ", expected " + std::to_string(SimulationSnapshot::FormatVersion));
+        }
+
+        std::vector<SnapshotSection> sections;
+        std::uint64_t key = 0;
+
+        // Only used to walk the fields in order, nothing is read into it.
+        SimulationSnapshot layout;
+        visitFields(layout, [&](const char* name, auto& field) {
+            auto length = reader.readRaw<std::uint32_t>();
+            if (length > reader.remaining())
+            {
+                throw SnapshotException(std::string("Snapshot section ") + name + " is truncated");
+            }
+
+            auto offset = data.size() - reader.remaining();
+            if constexpr (std::is_same_v<std::decay_t<decltype(field)>, std::vector<UnitSnapshot>>)
+            {
+                SnapshotReader unitsReader(data.data() + offset, data.data() + offset + length);
+                auto count = unitsReader.readCount();
+                for (std::size_t i = 0; i < count; ++i)
+                {
+                    auto recordLength = unitsReader.readRaw<std::uint32_t>();
+                    auto id = unitsReader.readRaw<decltype(UnitId::value)>();
+                    if (recordLength < sizeof(id) || recordLength - sizeof(id) > unitsReader.remaining())
+                    {
+                        throw SnapshotException("Snapshot unit record is truncated");
+                    }
+
+                    auto recordOffset = offset + length - unitsReader.remaining();
+                    sections.push_back(SnapshotSection{SnapshotSection::UnitKeyBase + id, recordOffset, recordLength - sizeof(id)});
+                    unitsReader.skip(recordLength - sizeof(id));
+                }
+            }
+            else
+            {
+                sections.push_back(SnapshotSection{key, offset, length});
+            }
+
+            reader.skip(length);
+            ++key;
+        });
+
+        return sections;
+    }
+
+    nlohmann::json dumpJson(const SimulationSnapshot& snapshot)
+    {
+        return valueToJson(snapshot);
+    }
+}
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <cstdint>
+#include <nlohmann/json.hpp>
+#include <rwe/snapshot/SimulationSnapshot.h>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace rwe
+{
+    class SnapshotException : public std::runtime_error
+    {
+    public:
+        explicit SnapshotException(const std::string& __arg);
+
+        explicit SnapshotException(const char* string);
+    };
+
+    /** A byte range within serialized snapshot data. */
+    struct SnapshotSection
+    {
+        /** Added to a unit's id to give the key of its record. */
+        static constexpr std::uint64_t UnitKeyBase = std::uint64_t(1) << 32;
+
+        /**
+         * Identifies the same section in other snapshots.
+         * Top-level fields are numbered in order,
+         * and each unit's record is keyed by its id.
+         */
+        std::uint64_t key;
+
+        std::size_t offset;
+        std::size_t size;
+    };
+
+    /**
+     * Encodes the snapshot in the binary snapshot format.
+     * The encoding is prefixed with SimulationSnapshot::FormatVersion.
+     * Each top-level field of the snapshot follows as a section,
+     * prefixed with its length in bytes.
+     * Sections that only change size when the map does,
+     * such as the occupied grid, come first.
+     */
+    std::vector<char> serializeSnapshot(const SimulationSnapshot& snapshot);
+
+    /**
+     * Decodes a snapshot produced by serializeSnapshot.
+     * Throws SnapshotException if the data is truncated, malformed
+     * or was written with a different format version.
+     */
+    SimulationSnapshot deserializeSnapshot(const std::vector<char>& data);
+
+    /**
+     * Returns where each section of a snapshot produced by serializeSnapshot lies,
+     * without decoding the sections themselves.
+     * The units field is broken down into a section per unit,
+     * covering the unit's record after its id.
+     * Section lengths and unit ids lie outside every section.
+     * Throws SnapshotException if the sections are truncated
+     * or the data was written with a different format version.
+     */
+    std::vector<SnapshotSection> findSnapshotSections(const std::vector<char>& data);
+
+    nlohmann::json dumpJson(const SimulationSnapshot& snapshot);
+}
@@ -43,13 +43,39 @@ namespace rwe
 
     TdfBlock parseTdfFromBytes(const std::vector<char>& bytes)
     {
-        std::string tdfString(bytes.data(), bytes.size());
-        return parseTdfFromString(tdfString);
+        return parseTdfFromBytes(std::string_view(bytes.data(), bytes.size()));
     }
 
     std::vector<TdfBlock> parseListTdfFromBytes(const std::vector<char>& bytes)
     {
-        std::string tdfString(bytes.data(), bytes.size());
-        return parseListTdfFromString(tdfString);
+        return parseListTdfFromBytes(std::string_view(bytes.data(), bytes.size()));
+    }
+
+    using ConstUtf8BytesIterator = utf8::iterator<const char*>;
+
+    TdfBlock parseTdfFromBytes(std::string_view bytes)
+    {
+        auto begin = bytes.data();
+        auto end = begin + bytes.size();
+        if (!utf8::is_valid(begin, end))
+        {
+            return parseTdfFromString(latin1ToUtf8(std::string(bytes)));
+        }
+
+        TdfParser<ConstUtf8BytesIterator, TdfBlock> parser(new SimpleTdfAdapter);
+        return parser.parse(ConstUtf8BytesIterator(begin, begin, end), ConstUtf8BytesIterator(end, begin, end));
+    }
+
+    std::vector<TdfBlock> parseListTdfFromBytes(std::string_view bytes)
+    {
+        auto begin = bytes.data();
+        auto end = begin + bytes.size();
+        if (!utf8::is_valid(begin, end))
+        {
+            return parseListTdfFromString(latin1ToUtf8(std::string(bytes)));
+        }
+
+        TdfParser<ConstUtf8BytesIterator, std::vector<TdfBlock>> parser(new ListTdfAdapter);
+        return parser.parse(ConstUtf8BytesIterator(begin, begin, end), ConstUtf8BytesIterator(end, begin, end));
     }
 }
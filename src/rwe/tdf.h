@@ -2,6 +2,7 @@
 
 #include <rwe/rwe_string.h>
 #include <rwe/tdf/TdfBlock.h>
+#include <string_view>
 
 namespace rwe
 {
@@ -14,4 +15,9 @@ namespace rwe
     TdfBlock parseTdfFromBytes(const std::vector<char>& bytes);
 
     std::vector<TdfBlock> parseListTdfFromBytes(const std::vector<char>& bytes);
+
+    /** Parses the bytes where they are, copying them only if they need converting from latin1. */
+    TdfBlock parseTdfFromBytes(std::string_view bytes);
+
+    std::vector<TdfBlock> parseListTdfFromBytes(std::string_view bytes);
 }
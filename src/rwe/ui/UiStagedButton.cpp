@@ -1,4 +1,5 @@
 #include "UiStagedButton.h"
+#include <SDL.h>
 
 namespace rwe
 {
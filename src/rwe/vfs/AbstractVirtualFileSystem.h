@@ -2,6 +2,7 @@
 
 #include <optional>
 #include <rwe/gui.h>
+#include <rwe/vfs/FileView.h>
 #include <string>
 #include <vector>
 
@@ -12,10 +13,18 @@ namespace rwe
     public:
         virtual ~AbstractVirtualFileSystem() = default;
         virtual std::optional<std::vector<char>> readFile(const std::string& filename) const = 0;
+
+        /**
+         * Returns a view of the file's contents.
+         * Filesystems that can avoid copying the file, e.g. by mapping it, do so.
+         * By default this just wraps readFile.
+         */
+        virtual std::optional<FileView> readFileView(const std::string& filename) const;
         virtual std::vector<std::string> getFileNames(const std::string& directory, const std::string& extension) = 0;
         virtual std::vector<std::string> getFileNamesRecursive(const std::string& directory, const std::string& extension) = 0;
 
         std::vector<char> readFileOrThrow(const std::string& filename) const;
+        FileView readFileViewOrThrow(const std::string& filename) const;
         std::vector<GuiEntry> readGuiOrThrow(const std::string& filename) const;
     };
 
@@ -23,5 +32,11 @@ namespace rwe
     {
     public:
         virtual const std::string& getPath() const = 0;
+
+        /**
+         * Returns the path of every file in the filesystem relative to its root,
+         * cased as in the filesystem and separated by forward slashes.
+         */
+        virtual std::vector<std::string> getAllFileNames() const = 0;
     };
 }
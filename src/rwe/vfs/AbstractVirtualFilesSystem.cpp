@@ -3,6 +3,16 @@
 
 namespace rwe
 {
+    std::optional<FileView> AbstractVirtualFileSystem::readFileView(const std::string& filename) const
+    {
+        auto bytes = readFile(filename);
+        if (!bytes)
+        {
+            return std::nullopt;
+        }
+        return FileView(std::move(*bytes));
+    }
+
     std::vector<char> AbstractVirtualFileSystem::readFileOrThrow(const std::string& filename) const
     {
         auto bytes = readFile(filename);
@@ -13,6 +23,16 @@ namespace rwe
         return *bytes;
     }
 
+    FileView AbstractVirtualFileSystem::readFileViewOrThrow(const std::string& filename) const
+    {
+        auto view = readFileView(filename);
+        if (!view)
+        {
+            throw std::runtime_error("Couldn't read " + filename);
+        }
+        return *view;
+    }
+
     std::vector<GuiEntry> AbstractVirtualFileSystem::readGuiOrThrow(const std::string& filename) const
     {
         auto parsedGui = parseGuiFromBytes(readFileOrThrow(filename));
@@ -12,16 +12,24 @@ namespace rwe
 {
     std::optional<std::vector<char>> CompositeVirtualFileSystem::readFile(const std::string& filename) const
     {
-        for (const auto& fs : filesystems)
+        auto it = fileIndex.find(toUpper(filename));
+        if (it == fileIndex.end())
         {
-            auto file = fs->readFile(filename);
-            if (file)
-            {
-                return file;
-            }
+            return std::nullopt;
         }
 
-        return std::nullopt;
+        return filesystems[it->second.fileSystem]->readFile(it->second.path);
+    }
+
+    std::optional<FileView> CompositeVirtualFileSystem::readFileView(const std::string& filename) const
+    {
+        auto it = fileIndex.find(toUpper(filename));
+        if (it == fileIndex.end())
+        {
+            return std::nullopt;
+        }
+
+        return filesystems[it->second.fileSystem]->readFileView(it->second.path);
     }
 
     std::optional<std::vector<char>> CompositeVirtualFileSystem::readFileFromSource(const std::string& source, const std::string& filename) const
@@ -47,75 +55,131 @@ namespace rwe
     std::vector<std::string>
     CompositeVirtualFileSystem::getFileNames(const std::string& directory, const std::string& extension)
     {
-        std::set<std::string> entries;
+        return getMatchingFileNames(directoryIndex, directory, extension);
+    }
 
-        for (const auto& fs : filesystems)
+    std::vector<std::pair<std::string, std::string>>
+    CompositeVirtualFileSystem::getFileNamesWithSources(const std::string& directory, const std::string& extension)
+    {
+        return getMatchingFileNamesWithSources(directoryIndex, directory, extension);
+    }
+
+    std::vector<std::string>
+    CompositeVirtualFileSystem::getFileNamesRecursive(const std::string& directory, const std::string& extension)
+    {
+        return getMatchingFileNames(recursiveDirectoryIndex, directory, extension);
+    }
+
+    std::vector<std::pair<std::string, std::string>>
+    CompositeVirtualFileSystem::getFileNamesRecursiveWithSources(const std::string& directory, const std::string& extension)
+    {
+        return getMatchingFileNamesWithSources(recursiveDirectoryIndex, directory, extension);
+    }
+
+    void CompositeVirtualFileSystem::clear()
+    {
+        filesystems.clear();
+        fileIndex.clear();
+        directoryIndex.clear();
+        recursiveDirectoryIndex.clear();
+    }
+
+    void CompositeVirtualFileSystem::refreshIndex()
+    {
+        fileIndex.clear();
+        directoryIndex.clear();
+        recursiveDirectoryIndex.clear();
+        for (std::size_t i = 0; i < filesystems.size(); ++i)
         {
-            auto v = fs->getFileNames(directory, extension);
-            entries.insert(v.begin(), v.end());
+            indexFileSystem(i);
         }
+    }
 
-        std::vector<std::string> v(entries.begin(), entries.end());
-        return v;
+    void CompositeVirtualFileSystem::indexFileSystem(std::size_t index)
+    {
+        for (const auto& path : filesystems[index]->getAllFileNames())
+        {
+            auto upperPath = toUpper(path);
+
+            auto lastSlash = path.rfind('/');
+            auto directory = lastSlash == std::string::npos ? std::string() : upperPath.substr(0, lastSlash);
+            auto name = lastSlash == std::string::npos ? path : path.substr(lastSlash + 1);
+            directoryIndex[directory].push_back(IndexEntry{name, index});
+
+            recursiveDirectoryIndex[std::string()].push_back(IndexEntry{path, index});
+            for (auto slash = path.find('/'); slash != std::string::npos; slash = path.find('/', slash + 1))
+            {
+                recursiveDirectoryIndex[upperPath.substr(0, slash)].push_back(IndexEntry{path.substr(slash + 1), index});
+            }
+
+            // earlier filesystems take priority, so don't replace their entry
+            fileIndex.insert({std::move(upperPath), IndexEntry{path, index}});
+        }
     }
 
-    std::vector<std::pair<std::string, std::string>>
-    CompositeVirtualFileSystem::getFileNamesWithSources(const std::string& directory, const std::string& extension)
+    std::vector<const CompositeVirtualFileSystem::IndexEntry*> CompositeVirtualFileSystem::findMatchingEntries(
+        const DirectoryIndex& index,
+        const std::string& directory,
+        const std::string& extension) const
     {
-        std::map<std::string, std::string> entries;
+        auto key = toUpper(directory);
+        while (!key.empty() && key.back() == '/')
+        {
+            key.pop_back();
+        }
 
-        for (const auto& fs : filesystems)
+        std::vector<const IndexEntry*> v;
+
+        auto it = index.find(key);
+        if (it == index.end())
+        {
+            return v;
+        }
+
+        auto upperExtension = toUpper(extension);
+        for (const auto& e : it->second)
         {
-            auto v = fs->getFileNames(directory, extension);
-            for (const auto& filename : v)
+            if (toUpper(fs::path(e.path).extension().string()) == upperExtension)
             {
-                entries.insert({filename, fs->getPath()});
+                v.push_back(&e);
             }
         }
 
-        std::vector<std::pair<std::string, std::string>> v(entries.begin(), entries.end());
         return v;
     }
 
-    std::vector<std::string>
-    CompositeVirtualFileSystem::getFileNamesRecursive(const std::string& directory, const std::string& extension)
+    std::vector<std::string> CompositeVirtualFileSystem::getMatchingFileNames(
+        const DirectoryIndex& index,
+        const std::string& directory,
+        const std::string& extension) const
     {
         std::set<std::string> entries;
-
-        for (const auto& fs : filesystems)
+        for (const auto e : findMatchingEntries(index, directory, extension))
         {
-            auto v = fs->getFileNamesRecursive(directory, extension);
-            entries.insert(v.begin(), v.end());
+            entries.insert(e->path);
         }
 
         std::vector<std::string> v(entries.begin(), entries.end());
         return v;
     }
 
-    std::vector<std::pair<std::string, std::string>>
-    CompositeVirtualFileSystem::getFileNamesRecursiveWithSources(const std::string& directory, const std::string& extension)
+    std::vector<std::pair<std::string, std::string>> CompositeVirtualFileSystem::getMatchingFileNamesWithSources(
+        const DirectoryIndex& index,
+        const std::string& directory,
+        const std::string& extension) const
     {
+        // entries are in filesystem order, so the first source of each name is kept
         std::map<std::string, std::string> entries;
-
-        for (const auto& fs : filesystems)
+        for (const auto e : findMatchingEntries(index, directory, extension))
         {
-            auto v = fs->getFileNamesRecursive(directory, extension);
-            for (const auto& filename : v)
-            {
-                entries.insert({filename, fs->getPath()});
-            }
+            entries.insert({e->path, filesystems[e->fileSystem]->getPath()});
         }
 
         std::vector<std::pair<std::string, std::string>> v(entries.begin(), entries.end());
         return v;
     }
 
-    void CompositeVirtualFileSystem::clear()
-    {
-        filesystems.clear();
-    }
-
-    void addHpisWithExtension(CompositeVirtualFileSystem& vfs, const fs::path& searchPath, const std::string& extension)
+    void addHpisWithExtension(CompositeVirtualFileSystem& vfs, const fs::path& searchPath, const std::string& extension, ThreadPool* threadPool)
     {
         fs::directory_iterator it(searchPath);
         fs::directory_iterator end;
@@ -126,12 +190,17 @@ namespace rwe
             auto ext = e.path().extension().string();
             if (toUpper(ext) == toUpper(extension))
             {
-                vfs.emplaceFileSystem<HpiFileSystem>(e.path().string());
+                vfs.emplaceFileSystem<HpiFileSystem>(e.path().string(), threadPool);
             }
         }
     }
 
     void addToVfs(CompositeVirtualFileSystem& vfs, const boost::filesystem::path& searchPath)
+    {
+        addToVfs(vfs, searchPath, nullptr);
+    }
+
+    void addToVfs(CompositeVirtualFileSystem& vfs, const boost::filesystem::path& searchPath, ThreadPool* threadPool)
     {
         std::vector<std::string> hpiExtensions{".hpi", ".ufo", ".ccx", ".gpf", ".gp3"};
 
@@ -140,7 +209,7 @@ namespace rwe
         // scan for HPIs to add
         for (auto it = hpiExtensions.rbegin(); it != hpiExtensions.rend(); ++it)
         {
-            addHpisWithExtension(vfs, searchPath, *it);
+            addHpisWithExtension(vfs, searchPath, *it, threadPool);
         }
     }
 
@@ -3,17 +3,56 @@
 #include <boost/filesystem.hpp>
 #include <memory>
 #include <rwe/vfs/AbstractVirtualFileSystem.h>
+#include <unordered_map>
 
 namespace rwe
 {
+    class ThreadPool;
+
     class CompositeVirtualFileSystem final : public AbstractVirtualFileSystem
     {
     private:
+        struct IndexEntry
+        {
+            /** The path of the file, cased as in its filesystem. */
+            std::string path;
+
+            /** The index of the filesystem in filesystems. */
+            std::size_t fileSystem;
+        };
+
+        using DirectoryIndex = std::unordered_map<std::string, std::vector<IndexEntry>>;
+
+        /**
+         * Filesystems are searched in the order they were added.
+         * Their contents are indexed when they are added,
+         * so files added to a mounted directory afterwards
+         * cannot be read or listed until refreshIndex is called.
+         */
         std::vector<std::unique_ptr<LeafVirtualFileSystem>> filesystems;
 
+        /**
+         * The first filesystem to contain each file, keyed by upper-cased path.
+         * Later filesystems' copies of the file are hidden by it.
+         */
+        std::unordered_map<std::string, IndexEntry> fileIndex;
+
+        /**
+         * For each upper-cased directory path, the files directly inside it
+         * in every filesystem, in filesystem order.
+         * Paths are relative to the directory.
+         */
+        DirectoryIndex directoryIndex;
+
+        /** As directoryIndex, but with the files anywhere below each directory. */
+        DirectoryIndex recursiveDirectoryIndex;
+
     public:
+        /** Only finds files that were in the index when it was last built. */
         std::optional<std::vector<char>> readFile(const std::string& filename) const override;
 
+        std::optional<FileView> readFileView(const std::string& filename) const override;
+
         std::optional<std::vector<char>> readFileFromSource(const std::string& source, const std::string& filename) const;
 
         std::vector<std::string> getFileNames(const std::string& directory, const std::string& extension) override;
@@ -28,14 +67,40 @@ namespace rwe
 
         void clear();
 
+        /**
+         * Indexes the contents of every filesystem again,
+         * e.g. after files have been added to a directory.
+         */
+        void refreshIndex();
+
         template <typename T, typename... Args>
         void emplaceFileSystem(Args&&... args)
         {
             filesystems.emplace_back(std::make_unique<T>(std::forward<Args>(args)...));
+            indexFileSystem(filesystems.size() - 1);
         }
+
+    private:
+        void indexFileSystem(std::size_t index);
+
+        /** Returns the entries in the directory with the extension, compared case-insensitively. */
+        std::vector<const IndexEntry*> findMatchingEntries(const DirectoryIndex& index, const std::string& directory, const std::string& extension) const;
+
+        std::vector<std::string> getMatchingFileNames(const DirectoryIndex& index, const std::string& directory, const std::string& extension) const;
+
+        std::vector<std::pair<std::string, std::string>>
+        getMatchingFileNamesWithSources(const DirectoryIndex& index, const std::string& directory, const std::string& extension) const;
     };
 
 
     void addToVfs(CompositeVirtualFileSystem& vfs, const boost::filesystem::path& searchPath);
+
+    /**
+     * Adds the search path and the archives in it to the filesystem.
+     * The files present now are indexed; see CompositeVirtualFileSystem::refreshIndex.
+     * Large compressed files in the archives are decompressed in parallel on the thread pool,
+     * which must outlive the filesystem.
+     */
+    void addToVfs(CompositeVirtualFileSystem& vfs, const boost::filesystem::path& searchPath, ThreadPool* threadPool);
     CompositeVirtualFileSystem constructVfs(const boost::filesystem::path& searchPath);
 }
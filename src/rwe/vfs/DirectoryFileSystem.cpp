@@ -1,8 +1,9 @@
 #include "DirectoryFileSystem.h"
 
-#include <fstream>
+#include <memory>
 #include <rwe/rwe_string.h>
-#include <sstream>
+#include <rwe/vfs/MappedFile.h>
+#include <set>
 
 namespace fs = boost::filesystem;
 
@@ -62,31 +63,69 @@ namespace rwe
         return pathString;
     }
 
-    std::optional<std::vector<char>> DirectoryFileSystem::readFile(const std::string& filename) const
+    std::optional<fs::path> DirectoryFileSystem::resolvePath(const std::string& filename) const
     {
         fs::path fullPath(path);
-        auto correctlyCasedPath = findPathCaseInsensitive(path, filename);
-        if (!correctlyCasedPath)
+        fullPath /= filename;
+
+        // names from getAllFileNames are already correctly cased,
+        // so only search when the name as given doesn't exist
+        if (!fs::is_regular_file(fullPath))
+        {
+            auto correctlyCasedPath = findPathCaseInsensitive(path, filename);
+            if (!correctlyCasedPath)
+            {
+                return std::nullopt;
+            }
+
+            fullPath = path;
+            fullPath /= *correctlyCasedPath;
+        }
+
+        return fullPath;
+    }
+
+    std::optional<std::vector<char>> DirectoryFileSystem::readFile(const std::string& filename) const
+    {
+        auto view = readFileView(filename);
+        if (!view)
         {
             return std::nullopt;
         }
 
-        fullPath /= *correctlyCasedPath;
+        return std::vector<char>(view->begin(), view->end());
+    }
 
-        std::ifstream input(fullPath.string(), std::ios::binary);
-        if (!input.is_open())
+    std::optional<FileView> DirectoryFileSystem::readFileView(const std::string& filename) const
+    {
+        auto fullPath = resolvePath(filename);
+        if (!fullPath)
         {
             return std::nullopt;
         }
 
-        std::ostringstream buf;
-        buf << input.rdbuf();
-        const auto& str = buf.str();
+        boost::system::error_code ec;
+        auto size = fs::file_size(*fullPath, ec);
+        if (ec)
+        {
+            return std::nullopt;
+        }
 
-        std::vector<char> output(str.length());
-        std::copy(str.begin(), str.end(), output.begin());
+        // empty files can't be mapped
+        if (size == 0)
+        {
+            return FileView(std::vector<char>());
+        }
 
-        return output;
+        try
+        {
+            auto file = std::make_shared<const MappedFile>(fullPath->string());
+            return FileView(file, file->data(), file->size());
+        }
+        catch (const std::runtime_error&)
+        {
+            return std::nullopt;
+        }
     }
 
     std::vector<std::string> DirectoryFileSystem::getFileNames(const std::string& directory, const std::string& extension)
@@ -162,4 +201,54 @@ namespace rwe
 
         return v;
     }
+
+    /**
+     * Lists every file below the directory, following symlinks.
+     * ancestors holds the canonical paths of the directories being listed
+     * further up the tree, so that a symlink back to one of them is not followed.
+     */
+    static void appendAllFileNames(const fs::path& directory, const std::string& prefix, std::set<fs::path>& ancestors, std::vector<std::string>& v)
+    {
+        boost::system::error_code ec;
+        auto canonicalPath = fs::canonical(directory, ec);
+        if (ec || !ancestors.insert(canonicalPath).second)
+        {
+            return;
+        }
+
+        // directories we aren't allowed to read are skipped rather than failing the whole mount
+        fs::directory_iterator it(directory, ec);
+        fs::directory_iterator end;
+
+        for (; !ec && it != end; it.increment(ec))
+        {
+            const auto& e = *it;
+            auto name = prefix + e.path().filename().string();
+            if (e.status().type() == fs::file_type::directory_file)
+            {
+                appendAllFileNames(e.path(), name + "/", ancestors, v);
+            }
+            else
+            {
+                v.push_back(name);
+            }
+        }
+
+        ancestors.erase(canonicalPath);
+    }
+
+    std::vector<std::string> DirectoryFileSystem::getAllFileNames() const
+    {
+        std::vector<std::string> v;
+
+        // FIXME: TOCTOU error here
+        if (!fs::exists(path))
+        {
+            return v;
+        }
+
+        std::set<fs::path> ancestors;
+        appendAllFileNames(path, "", ancestors, v);
+        return v;
+    }
 }
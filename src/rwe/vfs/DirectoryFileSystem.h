@@ -21,8 +21,20 @@ namespace rwe
 
         std::optional<std::vector<char>> readFile(const std::string& filename) const override;
 
+        /** Maps the file into memory rather than reading it. */
+        std::optional<FileView> readFileView(const std::string& filename) const override;
+
         std::vector<std::string> getFileNames(const std::string& directory, const std::string& filter) override;
 
         std::vector<std::string> getFileNamesRecursive(const std::string& directory, const std::string& extension) override;
+
+        /**
+         * Includes files in symlinked directories,
+         * except where the symlink leads back to a directory above it.
+         */
+        std::vector<std::string> getAllFileNames() const override;
+
+    private:
+        std::optional<boost::filesystem::path> resolvePath(const std::string& filename) const;
     };
 }
@@ -0,0 +1,42 @@
+#include "FileView.h"
+
+namespace rwe
+{
+    FileView::FileView(std::shared_ptr<const void> owner, const char* data, std::size_t size)
+        : owner(std::move(owner)), _data(data), _size(size)
+    {
+    }
+
+    FileView::FileView(std::vector<char>&& bytes)
+    {
+        auto buffer = std::make_shared<const std::vector<char>>(std::move(bytes));
+        _data = buffer->data();
+        _size = buffer->size();
+        owner = std::move(buffer);
+    }
+
+    const char* FileView::data() const
+    {
+        return _data;
+    }
+
+    std::size_t FileView::size() const
+    {
+        return _size;
+    }
+
+    const char* FileView::begin() const
+    {
+        return _data;
+    }
+
+    const char* FileView::end() const
+    {
+        return _data + _size;
+    }
+
+    std::string_view FileView::asStringView() const
+    {
+        return std::string_view(_data, _size);
+    }
+}
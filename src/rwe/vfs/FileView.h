@@ -0,0 +1,40 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <string_view>
+#include <vector>
+
+namespace rwe
+{
+    /**
+     * A read-only view of the contents of a file.
+     * The bytes may belong to a mapped file or to a buffer the view owns.
+     * Copies of the view share the bytes,
+     * which stay alive for as long as any copy does.
+     */
+    class FileView
+    {
+    private:
+        std::shared_ptr<const void> owner;
+        const char* _data;
+        std::size_t _size;
+
+    public:
+        /** Creates a view of bytes kept alive by owner. */
+        FileView(std::shared_ptr<const void> owner, const char* data, std::size_t size);
+
+        /** Creates a view that owns the buffer. */
+        explicit FileView(std::vector<char>&& bytes);
+
+        const char* data() const;
+
+        std::size_t size() const;
+
+        const char* begin() const;
+
+        const char* end() const;
+
+        std::string_view asStringView() const;
+    };
+}
@@ -16,21 +16,46 @@ namespace rwe
             return std::nullopt;
         }
 
-        std::vector<char> buffer(file->get().size);
-        hpi.extract(*file, buffer.data());
+        return extract(*file);
+    }
 
-        return buffer;
+    std::optional<FileView> HpiFileSystem::readFileView(const std::string& filename) const
+    {
+        auto file = hpi.findFile(filename);
+        if (!file)
+        {
+            return std::nullopt;
+        }
+
+        if (auto data = hpi.tryGetStoredData(*file); data != nullptr)
+        {
+            return FileView(this->file, data, file->get().size);
+        }
+
+        return FileView(extract(*file));
     }
 
-    HpiFileSystem::HpiFileSystem(const std::string& file)
-        : name(file),
-          stream(file, std::ios::binary),
-          hpi(&stream)
+    std::vector<char> HpiFileSystem::extract(const HpiArchive::File& file) const
     {
-        if (!stream.is_open())
+        std::vector<char> buffer(file.size);
+        if (threadPool != nullptr)
         {
-            throw std::runtime_error("Could not open file");
+            hpi.extract(file, buffer.data(), *threadPool);
         }
+        else
+        {
+            hpi.extract(file, buffer.data());
+        }
+
+        return buffer;
+    }
+
+    HpiFileSystem::HpiFileSystem(const std::string& file, ThreadPool* threadPool)
+        : name(file),
+          file(std::make_shared<const MappedFile>(file)),
+          hpi(this->file->data(), this->file->size()),
+          threadPool(threadPool)
+    {
     }
 
     std::vector<std::string> HpiFileSystem::getFileNames(const std::string& directory, const std::string& extension)
@@ -58,6 +83,28 @@ namespace rwe
         return getFileNamesRecursiveInternal(*dir, extension);
     }
 
+    std::vector<std::string> HpiFileSystem::getAllFileNames() const
+    {
+        std::vector<std::string> v;
+        appendAllFileNames(hpi.root(), "", v);
+        return v;
+    }
+
+    void HpiFileSystem::appendAllFileNames(const HpiArchive::Directory& directory, const std::string& prefix, std::vector<std::string>& v)
+    {
+        for (const auto& e : directory.entries)
+        {
+            if (auto d = std::get_if<HpiArchive::Directory>(&e.data); d != nullptr)
+            {
+                appendAllFileNames(*d, prefix + e.name + "/", v);
+            }
+            else
+            {
+                v.push_back(prefix + e.name);
+            }
+        }
+    }
+
     std::vector<std::string>
     HpiFileSystem::getFileNamesInternal(const HpiArchive::Directory& directory, const std::string& extension)
     {
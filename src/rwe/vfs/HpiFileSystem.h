@@ -1,8 +1,9 @@
 #pragma once
 
-#include <fstream>
+#include <memory>
 #include <rwe/Hpi.h>
 #include <rwe/vfs/AbstractVirtualFileSystem.h>
+#include <rwe/vfs/MappedFile.h>
 
 namespace rwe
 {
@@ -26,24 +27,36 @@ namespace rwe
 
     private:
         std::string name;
-        std::ifstream stream;
+        /** Shared with the views of files stored in it as they are. */
+        std::shared_ptr<const MappedFile> file;
         HpiArchive hpi;
 
+        /** Decompresses large files in parallel if set. */
+        ThreadPool* threadPool;
+
     public:
-        explicit HpiFileSystem(const std::string& file);
+        /** threadPool may be null, in which case files are extracted on the calling thread. */
+        HpiFileSystem(const std::string& file, ThreadPool* threadPool);
 
     public:
         const std::string& getPath() const override;
 
         std::optional<std::vector<char>> readFile(const std::string& filename) const override;
 
+        std::optional<FileView> readFileView(const std::string& filename) const override;
+
         std::vector<std::string> getFileNames(const std::string& directory, const std::string& extension) override;
 
         std::vector<std::string>
         getFileNamesRecursive(const std::string& directory, const std::string& extension) override;
 
+        std::vector<std::string> getAllFileNames() const override;
+
     private:
+        std::vector<char> extract(const HpiArchive::File& file) const;
+
         std::vector<std::string> getFileNamesInternal(const HpiArchive::Directory& directory, const std::string& extension);
         std::vector<std::string> getFileNamesRecursiveInternal(const HpiArchive::Directory& directory, const std::string& extension);
+        static void appendAllFileNames(const HpiArchive::Directory& directory, const std::string& prefix, std::vector<std::string>& v);
     };
 }
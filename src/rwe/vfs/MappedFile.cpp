@@ -0,0 +1,45 @@
+#include "MappedFile.h"
+#include <stdexcept>
+
+namespace rwe
+{
+    boost::interprocess::file_mapping openFileMapping(const std::string& path)
+    {
+        try
+        {
+            return boost::interprocess::file_mapping(path.c_str(), boost::interprocess::read_only);
+        }
+        catch (const boost::interprocess::interprocess_exception&)
+        {
+            throw std::runtime_error("Could not open file " + path);
+        }
+    }
+
+    boost::interprocess::mapped_region mapWholeFile(const boost::interprocess::file_mapping& mapping, const std::string& path)
+    {
+        try
+        {
+            return boost::interprocess::mapped_region(mapping, boost::interprocess::read_only);
+        }
+        catch (const boost::interprocess::interprocess_exception&)
+        {
+            // empty files can't be mapped
+            throw std::runtime_error("Could not map file " + path);
+        }
+    }
+
+    MappedFile::MappedFile(const std::string& path)
+        : mapping(openFileMapping(path)), region(mapWholeFile(mapping, path))
+    {
+    }
+
+    const char* MappedFile::data() const
+    {
+        return static_cast<const char*>(region.get_address());
+    }
+
+    std::size_t MappedFile::size() const
+    {
+        return region.get_size();
+    }
+}
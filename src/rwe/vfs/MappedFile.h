@@ -0,0 +1,27 @@
+#pragma once
+
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+#include <cstddef>
+#include <string>
+
+namespace rwe
+{
+    /**
+     * A whole file mapped read-only into memory.
+     * The bytes are never written, so any number of threads may read them at once.
+     */
+    class MappedFile
+    {
+    private:
+        boost::interprocess::file_mapping mapping;
+        boost::interprocess::mapped_region region;
+
+    public:
+        explicit MappedFile(const std::string& path);
+
+        const char* data() const;
+
+        std::size_t size() const;
+    };
+}
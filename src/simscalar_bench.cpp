@@ -0,0 +1,160 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <iostream>
+#include <random>
+#include <rwe/SimScalar.h>
+#include <rwe/util.h>
+#include <string>
+#include <vector>
+
+/**
+ * Compares the throughput of the float and fixed-point SimScalar backends
+ * on a steering kernel shaped like the unit movement code:
+ * each tick every unit measures the distance to its waypoint,
+ * turns towards it and moves along its heading.
+ *
+ * Both backends are built into this binary regardless of RWE_FIXED_POINT_SIM.
+ * To compare whole-game tick times, run rwe_headless from a build
+ * configured with each setting.
+ */
+namespace rwe
+{
+    struct FloatBackend
+    {
+        using Scalar = FloatSimScalar;
+        static constexpr const char* Name = "float";
+
+        static Scalar fromFloat(float f) { return Scalar(f); }
+        static float toFloat(Scalar s) { return s.value; }
+        static Scalar sqrt(Scalar s) { return Scalar(std::sqrt(s.value)); }
+        static std::uint16_t atan2(Scalar y, Scalar x)
+        {
+            return static_cast<std::uint16_t>(static_cast<int>(std::round((std::atan2(y.value, x.value) / Pif) * 32768.0f)));
+        }
+        static Scalar sin(std::uint16_t a) { return Scalar(std::sin(static_cast<float>(a) / 32768.0f * Pif)); }
+        static Scalar cos(std::uint16_t a) { return Scalar(std::cos(static_cast<float>(a) / 32768.0f * Pif)); }
+    };
+
+    struct FixedBackend
+    {
+        using Scalar = FixedSimScalar;
+        static constexpr const char* Name = "fixed";
+
+        static Scalar fromFloat(float f) { return Scalar(f); }
+        static float toFloat(Scalar s) { return static_cast<float>(s.value) / static_cast<float>(Scalar::One); }
+        static Scalar sqrt(Scalar s) { return rwe::sqrt(s); }
+        static std::uint16_t atan2(Scalar y, Scalar x) { return fixedAtan2(y, x); }
+        static Scalar sin(std::uint16_t a) { return fixedSin(a); }
+        static Scalar cos(std::uint16_t a) { return fixedCos(a); }
+    };
+
+    template <typename Backend>
+    struct BenchUnit
+    {
+        typename Backend::Scalar x;
+        typename Backend::Scalar z;
+        typename Backend::Scalar speed;
+        std::uint16_t heading;
+        std::size_t waypoint;
+    };
+
+    template <typename Backend>
+    void tick(std::vector<BenchUnit<Backend>>& units, const std::vector<std::pair<typename Backend::Scalar, typename Backend::Scalar>>& waypoints)
+    {
+        using Scalar = typename Backend::Scalar;
+        const Scalar arrivalDistance(16);
+        const Scalar maxSpeed(2);
+        const Scalar acceleration = Backend::fromFloat(0.125f);
+        const int turnRate = 400;
+
+        for (auto& u : units)
+        {
+            auto dx = waypoints[u.waypoint].first - u.x;
+            auto dz = waypoints[u.waypoint].second - u.z;
+            auto distance = Backend::sqrt((dx * dx) + (dz * dz));
+            if (distance < arrivalDistance)
+            {
+                u.waypoint = (u.waypoint + 1) % waypoints.size();
+                u.speed = Scalar(0);
+                continue;
+            }
+
+            auto desiredHeading = Backend::atan2(dx, dz);
+            auto turn = static_cast<int>(static_cast<std::int16_t>(desiredHeading - u.heading));
+            turn = std::clamp(turn, -turnRate, turnRate);
+            u.heading = static_cast<std::uint16_t>(u.heading + turn);
+
+            u.speed += acceleration;
+            if (u.speed > maxSpeed)
+            {
+                u.speed = maxSpeed;
+            }
+
+            u.x += Backend::sin(u.heading) * u.speed;
+            u.z += Backend::cos(u.heading) * u.speed;
+        }
+    }
+
+    template <typename Backend>
+    void runBench(const std::vector<std::pair<float, float>>& waypointFloats, std::size_t unitCount, std::size_t tickCount)
+    {
+        std::vector<std::pair<typename Backend::Scalar, typename Backend::Scalar>> waypoints;
+        for (const auto& w : waypointFloats)
+        {
+            waypoints.emplace_back(Backend::fromFloat(w.first), Backend::fromFloat(w.second));
+        }
+
+        std::vector<BenchUnit<Backend>> units;
+        for (std::size_t i = 0; i < unitCount; ++i)
+        {
+            const auto& start = waypoints[i % waypoints.size()];
+            units.push_back(BenchUnit<Backend>{start.first, start.second, typename Backend::Scalar(0), 0, (i + 1) % waypoints.size()});
+        }
+
+        auto start = std::chrono::steady_clock::now();
+        for (std::size_t i = 0; i < tickCount; ++i)
+        {
+            tick<Backend>(units, waypoints);
+        }
+        auto end = std::chrono::steady_clock::now();
+        auto ms = std::chrono::duration<double, std::milli>(end - start).count();
+
+        // Printed so that the work can't be optimised away,
+        // and so that fixed-point results can be compared across machines.
+        double checksum = 0.0;
+        for (const auto& u : units)
+        {
+            checksum += Backend::toFloat(u.x) + Backend::toFloat(u.z);
+        }
+
+        std::cout << "  " << Backend::Name << ": " << ms << " ms (" << (tickCount / (ms / 1000.0)) << " ticks/s), checksum " << checksum << std::endl;
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    std::size_t unitCount = argc > 1 ? std::stoul(argv[1]) : 2000;
+    std::size_t tickCount = argc > 2 ? std::stoul(argv[2]) : 2000;
+
+    if (unitCount == 0 || tickCount == 0)
+    {
+        std::cerr << "Usage: simscalar_bench [unit count] [tick count]" << std::endl;
+        return 1;
+    }
+
+    std::mt19937 rng(1234);
+    std::uniform_real_distribution<float> coord(-2048.0f, 2048.0f);
+    std::vector<std::pair<float, float>> waypoints;
+    for (int i = 0; i < 64; ++i)
+    {
+        waypoints.emplace_back(coord(rng), coord(rng));
+    }
+
+    std::cout << unitCount << " units, " << tickCount << " ticks" << std::endl;
+    rwe::runBench<rwe::FloatBackend>(waypoints, unitCount, tickCount);
+    rwe::runBench<rwe::FixedBackend>(waypoints, unitCount, tickCount);
+
+    return 0;
+}
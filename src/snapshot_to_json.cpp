@@ -0,0 +1,54 @@
+#include <fstream>
+#include <iostream>
+#include <rwe/snapshot/SnapshotStream.h>
+#include <rwe/snapshot/snapshot_io.h>
+#include <string>
+
+/**
+ * Converts a snapshot stream, as written by the state log
+ * or a desync dump, into JSON, one snapshot per line.
+ */
+int main(int argc, char* argv[])
+{
+    if (argc < 2)
+    {
+        std::cerr << "Usage: snapshot_to_json <snapshot file> [output file]" << std::endl;
+        return 1;
+    }
+
+    std::ifstream input(argv[1], std::ios::binary);
+    if (!input)
+    {
+        std::cerr << "Failed to open " << argv[1] << std::endl;
+        return 1;
+    }
+
+    std::ofstream outputFile;
+    if (argc > 2)
+    {
+        outputFile.open(argv[2]);
+        if (!outputFile)
+        {
+            std::cerr << "Failed to open " << argv[2] << std::endl;
+            return 1;
+        }
+    }
+    std::ostream& output = argc > 2 ? outputFile : std::cout;
+
+    try
+    {
+        rwe::SnapshotStreamReader reader(&input);
+        while (auto record = reader.read())
+        {
+            auto snapshot = rwe::deserializeSnapshot(record->second);
+            output << rwe::dumpJson(snapshot) << "\n";
+        }
+    }
+    catch (const rwe::SnapshotException& e)
+    {
+        std::cerr << "Failed to read snapshot: " << e.what() << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,146 @@
+#include <catch2/catch.hpp>
+#include <cmath>
+#include <rapidcheck/catch.h>
+#include <rwe/FixedSimScalar.h>
+
+namespace rwe
+{
+    static constexpr double Pi = 3.14159265358979323846;
+
+    static float toFloat(FixedSimScalar s)
+    {
+        return static_cast<float>(s.value) / static_cast<float>(FixedSimScalar::One);
+    }
+
+    TEST_CASE("FixedSimScalar")
+    {
+        SECTION("converts from integers and floats")
+        {
+            REQUIRE(FixedSimScalar(3).value == 3 * 65536);
+            REQUIRE(FixedSimScalar(-3).value == -3 * 65536);
+            REQUIRE(FixedSimScalar(1.5f).value == 98304);
+            REQUIRE(FixedSimScalar(-1.5f).value == -98304);
+        }
+
+        SECTION("rounds floats to the nearest step")
+        {
+            REQUIRE(FixedSimScalar(0.4f / 65536.0f).value == 0);
+            REQUIRE(FixedSimScalar(0.6f / 65536.0f).value == 1);
+            REQUIRE(FixedSimScalar(-0.6f / 65536.0f).value == -1);
+        }
+
+        SECTION("does arithmetic")
+        {
+            REQUIRE(FixedSimScalar(2) + FixedSimScalar(3) == FixedSimScalar(5));
+            REQUIRE(FixedSimScalar(2) - FixedSimScalar(3) == FixedSimScalar(-1));
+            REQUIRE(FixedSimScalar(2.5f) * FixedSimScalar(4) == FixedSimScalar(10));
+            REQUIRE(FixedSimScalar(-2.5f) * FixedSimScalar(4) == FixedSimScalar(-10));
+            REQUIRE(FixedSimScalar(10) / FixedSimScalar(4) == FixedSimScalar(2.5f));
+            REQUIRE(FixedSimScalar(7) % FixedSimScalar(4) == FixedSimScalar(3));
+            REQUIRE(-FixedSimScalar(7) == FixedSimScalar(-7));
+        }
+
+        SECTION("multiplies squared world distances without overflow")
+        {
+            auto d = FixedSimScalar(20000);
+            REQUIRE(d * d == FixedSimScalar(400000000));
+        }
+
+        SECTION("saturates on division by zero")
+        {
+            REQUIRE(FixedSimScalar(1) / FixedSimScalar(0) > FixedSimScalar(1000000));
+            REQUIRE(FixedSimScalar(-1) / FixedSimScalar(0) < FixedSimScalar(-1000000));
+        }
+
+        SECTION("compares")
+        {
+            REQUIRE(FixedSimScalar(1) < FixedSimScalar(2));
+            REQUIRE(FixedSimScalar(-2) < FixedSimScalar(-1));
+            REQUIRE(FixedSimScalar(2) >= FixedSimScalar(2));
+            REQUIRE(FixedSimScalar(2) != FixedSimScalar(3));
+        }
+    }
+
+    TEST_CASE("sqrt(FixedSimScalar)")
+    {
+        SECTION("returns exact roots of perfect squares")
+        {
+            REQUIRE(sqrt(FixedSimScalar(0)) == FixedSimScalar(0));
+            REQUIRE(sqrt(FixedSimScalar(1)) == FixedSimScalar(1));
+            REQUIRE(sqrt(FixedSimScalar(16)) == FixedSimScalar(4));
+            REQUIRE(sqrt(FixedSimScalar(2.25f)) == FixedSimScalar(1.5f));
+            REQUIRE(sqrt(FixedSimScalar(400000000)) == FixedSimScalar(20000));
+        }
+
+        SECTION("returns 0 for negative numbers")
+        {
+            REQUIRE(sqrt(FixedSimScalar(-4)) == FixedSimScalar(0));
+        }
+
+        rc::prop("is within one step of the true root", [](unsigned int raw) {
+            auto s = FixedSimScalar::fromRaw(raw);
+            auto expected = std::sqrt(static_cast<double>(raw) / 65536.0);
+            RC_ASSERT(std::abs(static_cast<double>(sqrt(s).value) / 65536.0 - expected) <= 1.0 / 65536.0);
+        });
+    }
+
+    TEST_CASE("fixedSin/fixedCos")
+    {
+        SECTION("are exact at quarter turns")
+        {
+            REQUIRE(fixedSin(0) == FixedSimScalar(0));
+            REQUIRE(fixedSin(16384) == FixedSimScalar(1));
+            REQUIRE(fixedSin(32768) == FixedSimScalar(0));
+            REQUIRE(fixedSin(49152) == FixedSimScalar(-1));
+            REQUIRE(fixedCos(0) == FixedSimScalar(1));
+            REQUIRE(fixedCos(16384) == FixedSimScalar(0));
+            REQUIRE(fixedCos(32768) == FixedSimScalar(-1));
+            REQUIRE(fixedCos(49152) == FixedSimScalar(0));
+        }
+
+        rc::prop("match std::sin and std::cos", [](std::uint16_t a) {
+            auto radians = static_cast<double>(a) / 32768.0 * Pi;
+            RC_ASSERT(std::abs(toFloat(fixedSin(a)) - std::sin(radians)) <= 2.0 / 65536.0);
+            RC_ASSERT(std::abs(toFloat(fixedCos(a)) - std::cos(radians)) <= 2.0 / 65536.0);
+        });
+    }
+
+    TEST_CASE("fixedAtan2")
+    {
+        SECTION("returns 0 for the origin")
+        {
+            REQUIRE(fixedAtan2(FixedSimScalar(0), FixedSimScalar(0)) == 0);
+        }
+
+        SECTION("returns the right angle for each axis and diagonal")
+        {
+            REQUIRE(fixedAtan2(FixedSimScalar(0), FixedSimScalar(5)) == 0);
+            REQUIRE(fixedAtan2(FixedSimScalar(5), FixedSimScalar(5)) == 8192);
+            REQUIRE(fixedAtan2(FixedSimScalar(5), FixedSimScalar(0)) == 16384);
+            REQUIRE(fixedAtan2(FixedSimScalar(5), FixedSimScalar(-5)) == 24576);
+            REQUIRE(fixedAtan2(FixedSimScalar(0), FixedSimScalar(-5)) == 32768);
+            REQUIRE(fixedAtan2(FixedSimScalar(-5), FixedSimScalar(-5)) == 40960);
+            REQUIRE(fixedAtan2(FixedSimScalar(-5), FixedSimScalar(0)) == 49152);
+            REQUIRE(fixedAtan2(FixedSimScalar(-5), FixedSimScalar(5)) == 57344);
+        }
+
+        SECTION("works for large vectors")
+        {
+            REQUIRE(fixedAtan2(FixedSimScalar(1000000), FixedSimScalar(1000000)) == 8192);
+        }
+
+        rc::prop("matches std::atan2", [](int y, int x) {
+            RC_PRE(x != 0 || y != 0);
+            auto expected = std::atan2(static_cast<double>(y), static_cast<double>(x)) / Pi * 32768.0;
+            auto actual = static_cast<double>(fixedAtan2(FixedSimScalar::fromRaw(y), FixedSimScalar::fromRaw(x)));
+            auto diff = std::abs(actual - (expected < 0 ? expected + 65536.0 : expected));
+            RC_ASSERT(std::min(diff, 65536.0 - diff) <= 2.0);
+        });
+
+        rc::prop("is inverted by fixedSin and fixedCos", [](std::uint16_t a) {
+            auto result = fixedAtan2(fixedSin(a) * FixedSimScalar(1000), fixedCos(a) * FixedSimScalar(1000));
+            auto diff = static_cast<std::uint16_t>(result - a);
+            RC_ASSERT(std::min<int>(diff, 65536 - diff) <= 2);
+        });
+    }
+}
@@ -42,13 +42,17 @@ namespace rwe
         }
         SECTION("works on string")
         {
-            REQUIRE(computeHashOf(std::string("A")) == GameHash(65));
-            REQUIRE(computeHashOf(std::string("fred")) == GameHash(417));
+            REQUIRE(computeHashOf(std::string("A")) == GameHash(3289118412));
+            REQUIRE(computeHashOf(std::string("fred")) == GameHash(2561928520));
+        }
+        SECTION("string hash depends on character order")
+        {
+            REQUIRE(computeHashOf(std::string("fred")) != computeHashOf(std::string("derf")));
         }
         SECTION("works on char*")
         {
-            REQUIRE(computeHashOf("A") == GameHash(65));
-            REQUIRE(computeHashOf("fred") == GameHash(417));
+            REQUIRE(computeHashOf("A") == GameHash(3289118412));
+            REQUIRE(computeHashOf("fred") == GameHash(2561928520));
         }
         SECTION("works on optional")
         {
@@ -0,0 +1,229 @@
+#include <algorithm>
+#include <catch2/catch.hpp>
+#include <cstring>
+#include <rwe/Hpi.h>
+#include <rwe/ThreadPool.h>
+#include <string>
+#include <thread>
+#include <vector>
+#include <zlib.h>
+
+namespace rwe
+{
+    template <typename T>
+    static void appendRaw(std::vector<char>& buffer, const T& value)
+    {
+        auto p = reinterpret_cast<const char*>(&value);
+        buffer.insert(buffer.end(), p, p + sizeof(T));
+    }
+
+    template <typename T>
+    static void writeRaw(std::vector<char>& buffer, std::size_t offset, const T& value)
+    {
+        std::memcpy(buffer.data() + offset, &value, sizeof(T));
+    }
+
+    static std::vector<char> zlibCompress(const std::string& input)
+    {
+        auto size = compressBound(static_cast<uLong>(input.size()));
+        std::vector<char> output(size);
+        auto result = compress(
+            reinterpret_cast<Bytef*>(output.data()),
+            &size,
+            reinterpret_cast<const Bytef*>(input.data()),
+            static_cast<uLong>(input.size()));
+        REQUIRE(result == Z_OK);
+        output.resize(size);
+        return output;
+    }
+
+    /**
+     * Builds an archive whose root contains
+     * PLAIN.TXT, stored uncompressed, and ZIPPED.TXT, stored as zlib chunks.
+     */
+    static std::vector<char> createArchive(const std::string& plain, const std::string& zipped, uint32_t headerKey)
+    {
+        const uint32_t start = sizeof(HpiVersion) + sizeof(HpiHeader);
+        const uint32_t entryListOffset = start + sizeof(HpiDirectoryData);
+        const uint32_t plainNameOffset = entryListOffset + (2 * sizeof(HpiDirectoryEntry));
+        const uint32_t zippedNameOffset = plainNameOffset + 10;
+        const uint32_t plainDataOffset = zippedNameOffset + 11;
+        const uint32_t zippedDataOffset = plainDataOffset + sizeof(HpiFileData);
+        const uint32_t directorySize = zippedDataOffset + sizeof(HpiFileData);
+
+        std::vector<char> buffer;
+        appendRaw(buffer, HpiVersion{HpiMagicNumber, HpiVersionNumber});
+        appendRaw(buffer, HpiHeader{directorySize, headerKey, start});
+        appendRaw(buffer, HpiDirectoryData{2, entryListOffset});
+        appendRaw(buffer, HpiDirectoryEntry{plainNameOffset, plainDataOffset, 0});
+        appendRaw(buffer, HpiDirectoryEntry{zippedNameOffset, zippedDataOffset, 0});
+        buffer.insert(buffer.end(), "PLAIN.TXT", "PLAIN.TXT" + 10);
+        buffer.insert(buffer.end(), "ZIPPED.TXT", "ZIPPED.TXT" + 11);
+        appendRaw(buffer, HpiFileData{0, 0, 0});
+        appendRaw(buffer, HpiFileData{0, 0, 0});
+        REQUIRE(buffer.size() == directorySize);
+
+        writeRaw(buffer, plainDataOffset, HpiFileData{static_cast<uint32_t>(buffer.size()), static_cast<uint32_t>(plain.size()), 0});
+        buffer.insert(buffer.end(), plain.begin(), plain.end());
+
+        std::vector<std::vector<char>> chunks;
+        for (std::size_t i = 0; i < zipped.size(); i += HpiChunkSize)
+        {
+            chunks.push_back(zlibCompress(zipped.substr(i, HpiChunkSize)));
+        }
+
+        writeRaw(buffer, zippedDataOffset, HpiFileData{static_cast<uint32_t>(buffer.size()), static_cast<uint32_t>(zipped.size()), 2});
+        for (const auto& chunk : chunks)
+        {
+            appendRaw(buffer, static_cast<uint32_t>(sizeof(HpiChunk) + chunk.size()));
+        }
+        for (std::size_t i = 0; i < chunks.size(); ++i)
+        {
+            const auto& chunk = chunks[i];
+            uint32_t checksum = 0;
+            for (auto c : chunk)
+            {
+                checksum += static_cast<unsigned char>(c);
+            }
+
+            auto decompressedSize = std::min(HpiChunkSize, zipped.size() - (i * HpiChunkSize));
+            appendRaw(buffer, HpiChunk{HpiChunkMagicNumber, 2, 2, 0, static_cast<uint32_t>(chunk.size()), static_cast<uint32_t>(decompressedSize), checksum});
+            buffer.insert(buffer.end(), chunk.begin(), chunk.end());
+        }
+
+        // everything after the header is encrypted with the key and the position of each byte
+        auto key = transformKey(static_cast<unsigned char>(headerKey));
+        if (key != 0)
+        {
+            for (std::size_t i = start; i < buffer.size(); ++i)
+            {
+                auto pos = static_cast<unsigned char>(i);
+                buffer[i] = static_cast<char>((pos ^ key) ^ static_cast<unsigned char>(buffer[i]));
+            }
+        }
+
+        return buffer;
+    }
+
+    static std::string extract(const HpiArchive& archive, const std::string& path)
+    {
+        auto file = archive.findFile(path);
+        REQUIRE(file);
+        std::string result(file->get().size, '\0');
+        archive.extract(*file, result.data());
+        return result;
+    }
+
+    TEST_CASE("HpiArchive")
+    {
+        std::string plain = "plain file contents";
+        std::string zipped(5000, 'z');
+        for (std::size_t i = 0; i < zipped.size(); i += 7)
+        {
+            zipped[i] = static_cast<char>('a' + (i % 26));
+        }
+
+        SECTION("extracts uncompressed and compressed files")
+        {
+            auto bytes = createArchive(plain, zipped, 0);
+            HpiArchive archive(bytes.data(), bytes.size());
+
+            REQUIRE(extract(archive, "PLAIN.TXT") == plain);
+            REQUIRE(extract(archive, "ZIPPED.TXT") == zipped);
+        }
+
+        SECTION("decrypts encrypted archives")
+        {
+            auto bytes = createArchive(plain, zipped, 0x7F);
+            HpiArchive archive(bytes.data(), bytes.size());
+
+            REQUIRE(extract(archive, "PLAIN.TXT") == plain);
+            REQUIRE(extract(archive, "ZIPPED.TXT") == zipped);
+        }
+
+        SECTION("finds files case-insensitively")
+        {
+            auto bytes = createArchive(plain, zipped, 0x7F);
+            HpiArchive archive(bytes.data(), bytes.size());
+
+            REQUIRE(archive.findFile("plain.txt"));
+            REQUIRE(!archive.findFile("missing.txt"));
+        }
+
+        SECTION("extracts from several threads at once")
+        {
+            auto bytes = createArchive(plain, zipped, 0x7F);
+            HpiArchive archive(bytes.data(), bytes.size());
+
+            std::vector<std::string> results(8);
+            std::vector<std::thread> threads;
+            for (std::size_t i = 0; i < results.size(); ++i)
+            {
+                threads.emplace_back([&, i]() {
+                    for (int j = 0; j < 20; ++j)
+                    {
+                        auto file = archive.findFile(i % 2 == 0 ? "PLAIN.TXT" : "ZIPPED.TXT");
+                        results[i].assign(file->get().size, '\0');
+                        archive.extract(*file, results[i].data());
+                    }
+                });
+            }
+            for (auto& t : threads)
+            {
+                t.join();
+            }
+
+            for (std::size_t i = 0; i < results.size(); ++i)
+            {
+                REQUIRE(results[i] == (i % 2 == 0 ? plain : zipped));
+            }
+        }
+
+        SECTION("extracts large files in parallel")
+        {
+            std::string large(HpiArchive::MinParallelChunks * HpiChunkSize + 1000, '\0');
+            for (std::size_t i = 0; i < large.size(); ++i)
+            {
+                large[i] = static_cast<char>('a' + ((i * 7) % 26));
+            }
+
+            auto bytes = createArchive(plain, large, 0x7F);
+            HpiArchive archive(bytes.data(), bytes.size());
+            auto file = archive.findFile("ZIPPED.TXT");
+            REQUIRE(file);
+
+            ThreadPool threadPool(3);
+            std::string result(file->get().size, '\0');
+            archive.extract(*file, result.data(), threadPool);
+            REQUIRE(result == large);
+
+            REQUIRE(extract(archive, "ZIPPED.TXT") == large);
+        }
+
+        SECTION("gives the stored bytes of uncompressed files in unencrypted archives")
+        {
+            auto bytes = createArchive(plain, zipped, 0);
+            HpiArchive archive(bytes.data(), bytes.size());
+
+            auto data = archive.tryGetStoredData(*archive.findFile("PLAIN.TXT"));
+            REQUIRE(data != nullptr);
+            REQUIRE(std::string(data, plain.size()) == plain);
+            REQUIRE(archive.tryGetStoredData(*archive.findFile("ZIPPED.TXT")) == nullptr);
+
+            auto encryptedBytes = createArchive(plain, zipped, 0x7F);
+            HpiArchive encryptedArchive(encryptedBytes.data(), encryptedBytes.size());
+            REQUIRE(encryptedArchive.tryGetStoredData(*encryptedArchive.findFile("PLAIN.TXT")) == nullptr);
+        }
+
+        SECTION("throws when a file runs past the end of the archive")
+        {
+            auto bytes = createArchive(plain, zipped, 0x7F);
+            HpiArchive archive(bytes.data(), bytes.size() - 1);
+
+            auto file = archive.findFile("ZIPPED.TXT");
+            REQUIRE(file);
+            std::vector<char> buffer(file->get().size);
+            REQUIRE_THROWS_AS(archive.extract(*file, buffer.data()), HpiException);
+        }
+    }
+}
@@ -0,0 +1,61 @@
+#include "simulation_test_util.h"
+#include <catch2/catch.hpp>
+#include <rwe/GameHash_util.h>
+#include <rwe/IncrementalGameHash.h>
+#include <rwe/OpaqueId_io.h>
+
+namespace rwe
+{
+    TEST_CASE("IncrementalGameHash")
+    {
+        auto script = createTestScript({}, {}, 0);
+        auto sim = createFlatSimulation(32, 32);
+        auto unitA = *sim.tryAddUnit(createTestUnit(&script, SimVector(0_ss, 0_ss, 0_ss)));
+        auto unitB = *sim.tryAddUnit(createTestUnit(&script, SimVector(64_ss, 0_ss, 64_ss)));
+
+        IncrementalGameHash hash;
+
+        SECTION("matches the full hash for new units")
+        {
+            REQUIRE(hash.update(sim) == sim.computeHash());
+            REQUIRE(sim.changedUnits.empty());
+        }
+
+        SECTION("matches the full hash after a unit is marked changed")
+        {
+            hash.update(sim);
+            sim.getUnit(unitA).hitPoints = 50;
+            sim.changedUnits.push_back(unitA);
+            sim.changedUnits.push_back(unitA);
+            REQUIRE(hash.update(sim) == sim.computeHash());
+        }
+
+        SECTION("does not see changes that were not marked")
+        {
+            auto before = hash.update(sim);
+            sim.getUnit(unitB).hitPoints = 50;
+            REQUIRE(hash.update(sim) == before);
+            REQUIRE(before != sim.computeHash());
+
+            hash.rebuild(sim);
+            REQUIRE(hash.update(sim) == sim.computeHash());
+        }
+
+        SECTION("matches the full hash after a unit is removed")
+        {
+            hash.update(sim);
+            sim.units.remove(unitA);
+            sim.changedUnits.push_back(unitA);
+            REQUIRE(hash.update(sim) == sim.computeHash());
+        }
+
+        SECTION("includes game time")
+        {
+            auto before = hash.update(sim);
+            sim.gameTime += GameTime(1);
+            auto after = hash.update(sim);
+            REQUIRE(after != before);
+            REQUIRE(after == sim.computeHash());
+        }
+    }
+}
@@ -0,0 +1,138 @@
+#include "rc_gen_optional.h"
+#include <catch2/catch.hpp>
+#include <optional>
+#include <rapidcheck/catch.h>
+#include <rwe/IndexedMinHeap.h>
+#include <rwe/MinHeap.h>
+#include <vector>
+
+namespace rwe
+{
+    TEST_CASE("IndexedMinHeap")
+    {
+        SECTION("starts empty")
+        {
+            IndexedMinHeap<int> heap(8);
+            REQUIRE(heap.empty());
+        }
+
+        SECTION("is not empty after insertion")
+        {
+            IndexedMinHeap<int> heap(8);
+            heap.pushOrDecrease(3, 1);
+            REQUIRE(!heap.empty());
+            REQUIRE(heap.contains(3));
+            REQUIRE(!heap.contains(2));
+        }
+
+        SECTION("emits elements in priority order")
+        {
+            IndexedMinHeap<int> heap(8);
+            heap.pushOrDecrease(0, 5);
+            heap.pushOrDecrease(1, 8);
+            heap.pushOrDecrease(2, 2);
+            heap.pushOrDecrease(3, 1);
+            heap.pushOrDecrease(4, 4);
+
+            REQUIRE(heap.top().index == 3);
+            heap.pop();
+            REQUIRE(heap.top().index == 2);
+            heap.pop();
+            REQUIRE(heap.top().index == 4);
+            heap.pop();
+            REQUIRE(heap.top().index == 0);
+            heap.pop();
+            REQUIRE(heap.top().index == 1);
+            REQUIRE(heap.top().priority == 8);
+            heap.pop();
+            REQUIRE(heap.empty());
+            REQUIRE(!heap.contains(1));
+        }
+
+        SECTION(".pushOrDecrease")
+        {
+            SECTION("decreases the priority of an element")
+            {
+                IndexedMinHeap<double> heap(8);
+                heap.pushOrDecrease(1, 1.0);
+                heap.pushOrDecrease(2, 4.0);
+                heap.pushOrDecrease(3, 3.0);
+                REQUIRE(heap.pushOrDecrease(2, 2.0));
+
+                heap.pop();
+                REQUIRE(heap.top().index == 2);
+                REQUIRE(heap.top().priority == 2.0);
+            }
+
+            SECTION("doesn't decrease the priority when the existing one is better")
+            {
+                IndexedMinHeap<double> heap(8);
+                heap.pushOrDecrease(1, 1.0);
+                heap.pushOrDecrease(2, 4.0);
+                heap.pushOrDecrease(3, 3.0);
+                REQUIRE(!heap.pushOrDecrease(2, 6.0));
+
+                heap.pop();
+                REQUIRE(heap.top().index == 3);
+                heap.pop();
+                REQUIRE(heap.top().index == 2);
+                REQUIRE(heap.top().priority == 4.0);
+            }
+        }
+
+        SECTION(".clear forgets all elements")
+        {
+            IndexedMinHeap<int> heap(8);
+            heap.pushOrDecrease(1, 1);
+            heap.pushOrDecrease(2, 2);
+            heap.clear();
+            REQUIRE(heap.empty());
+            REQUIRE(!heap.contains(1));
+
+            heap.pushOrDecrease(2, 7);
+            REQUIRE(heap.top().index == 2);
+            REQUIRE(heap.top().priority == 7);
+        }
+
+        SECTION(".reset grows the capacity")
+        {
+            IndexedMinHeap<int> heap(2);
+            heap.reset(16);
+            REQUIRE(heap.capacity() == 16);
+            heap.pushOrDecrease(15, 1);
+            REQUIRE(heap.top().index == 15);
+        }
+    }
+
+    TEST_CASE("IndexedMinHeap RapidCheck")
+    {
+        rc::prop("emits items in the same order as MinHeap", [](const std::vector<std::optional<std::pair<unsigned int, int>>>& inputs) {
+            const std::size_t capacity = 32;
+
+            IndexedMinHeap<int> heap(capacity);
+            auto expectedHeap = createMinHeap<std::size_t, std::pair<std::size_t, int>>(
+                [](const auto& p) { return p.first; },
+                [](const auto& a, const auto& b) { return a.second < b.second; });
+
+            for (const auto& elem : inputs)
+            {
+                if (elem)
+                {
+                    auto index = elem->first % capacity;
+                    heap.pushOrDecrease(index, elem->second);
+                    expectedHeap.pushOrDecrease({index, elem->second});
+                }
+                else if (!expectedHeap.empty())
+                {
+                    RC_ASSERT(!heap.empty());
+                    RC_ASSERT(heap.top().index == expectedHeap.top().first);
+                    RC_ASSERT(heap.top().priority == expectedHeap.top().second);
+                    heap.pop();
+                    expectedHeap.pop();
+                }
+
+                RC_ASSERT(heap.empty() == expectedHeap.empty());
+            }
+        });
+    }
+}
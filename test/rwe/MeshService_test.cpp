@@ -0,0 +1,121 @@
+#include <catch2/catch.hpp>
+#include <cstring>
+#include <rwe/MeshService.h>
+
+namespace rwe
+{
+    /** Serves the same file for every name and counts how often it is read. */
+    class CountingFileSystem final : public AbstractVirtualFileSystem
+    {
+    private:
+        std::vector<char> file;
+
+    public:
+        mutable unsigned int readCount{0};
+
+        explicit CountingFileSystem(std::vector<char> file) : file(std::move(file))
+        {
+        }
+
+        std::optional<std::vector<char>> readFile(const std::string&) const override
+        {
+            readCount += 1;
+            return file;
+        }
+
+        std::vector<std::string> getFileNames(const std::string&, const std::string&) override
+        {
+            throw std::logic_error("Not implemented");
+        }
+
+        std::vector<std::string> getFileNamesRecursive(const std::string&, const std::string&) override
+        {
+            throw std::logic_error("Not implemented");
+        }
+    };
+
+    template <typename T>
+    static void appendRaw(std::vector<char>& bytes, const T& value)
+    {
+        const auto offset = bytes.size();
+        bytes.resize(offset + sizeof(T));
+        std::memcpy(bytes.data() + offset, &value, sizeof(T));
+    }
+
+    /** Creates a 3do with a single piece called "base" whose only face is a colored quad. */
+    static std::vector<char> createTest3do()
+    {
+        const uint32_t nameOffset = sizeof(_3doObject);
+        const uint32_t verticesOffset = nameOffset + 5;
+        const uint32_t primitivesOffset = verticesOffset + (4 * sizeof(_3doVertex));
+        const uint32_t primitiveVerticesOffset = primitivesOffset + sizeof(_3doPrimitive);
+
+        std::vector<char> bytes;
+        appendRaw(bytes, _3doObject{_3doMagicNumber, 4, 1, 0, 0, 0, 0, nameOffset, 0, verticesOffset, primitivesOffset, 0, 0});
+        bytes.insert(bytes.end(), {'b', 'a', 's', 'e', '\0'});
+        appendRaw(bytes, _3doVertex{0, 0, 0});
+        appendRaw(bytes, _3doVertex{65536, 0, 0});
+        appendRaw(bytes, _3doVertex{65536, 0, 65536});
+        appendRaw(bytes, _3doVertex{0, 65536, 65536});
+        appendRaw(bytes, _3doPrimitive{0, 4, 0, primitiveVerticesOffset, 0, 0, 0, 1});
+        for (uint16_t i = 0; i < 4; ++i)
+        {
+            appendRaw(bytes, i);
+        }
+        return bytes;
+    }
+
+    TEST_CASE("MeshService")
+    {
+        CountingFileSystem vfs(createTest3do());
+        MeshService meshService(&vfs, nullptr, nullptr, SharedTextureHandle(), {}, {}, std::vector<Vector2f>{Vector2f(0.0f, 0.0f)});
+
+        SECTION("reads each unit mesh once per name and team color")
+        {
+            auto first = meshService.loadUnitMesh("armcom", PlayerColorIndex(0));
+            REQUIRE(vfs.readCount == 1);
+            REQUIRE(first.mesh.pieces.size() == 1);
+            REQUIRE(first.height == 1_ss);
+
+            auto second = meshService.loadUnitMesh("ARMCOM", PlayerColorIndex(0));
+            REQUIRE(vfs.readCount == 1);
+
+            auto otherColor = meshService.loadUnitMesh("ArmCom", PlayerColorIndex(1));
+            REQUIRE(vfs.readCount == 2);
+            REQUIRE(otherColor.mesh.pieces[0].mesh != first.mesh.pieces[0].mesh);
+            REQUIRE(otherColor.selectionMesh != first.selectionMesh);
+
+            SECTION("copies share their GPU meshes but not their piece state")
+            {
+                REQUIRE(second.mesh.pieces[0].mesh == first.mesh.pieces[0].mesh);
+                REQUIRE(second.selectionMesh == first.selectionMesh);
+
+                first.mesh.setPieceOffset(0, Axis::X, 5_ss);
+                first.mesh.setMoveOperation(0, Axis::Y, UnitMesh::MoveOperation(3_ss, 1_ss));
+                REQUIRE(second.mesh.pieces[0].offset.x == 0_ss);
+                REQUIRE(second.mesh.operations.empty());
+
+                auto third = meshService.loadUnitMesh("armcom", PlayerColorIndex(0));
+                REQUIRE(vfs.readCount == 2);
+                REQUIRE(third.mesh.pieces[0].offset.x == 0_ss);
+                REQUIRE(third.mesh.operations.empty());
+            }
+        }
+
+        SECTION("reads each projectile mesh once per name and team color")
+        {
+            auto first = meshService.loadProjectileMesh("missile", PlayerColorIndex(0));
+            REQUIRE(vfs.readCount == 1);
+
+            auto second = meshService.loadProjectileMesh("Missile", PlayerColorIndex(0));
+            REQUIRE(vfs.readCount == 1);
+            REQUIRE(second.pieces[0].mesh == first.pieces[0].mesh);
+
+            first.setPieceOffset(0, Axis::Z, 2_ss);
+            REQUIRE(second.pieces[0].offset.z == 0_ss);
+
+            meshService.loadProjectileMesh("missile", PlayerColorIndex(1));
+            REQUIRE(vfs.readCount == 2);
+        }
+    }
+}
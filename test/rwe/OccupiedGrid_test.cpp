@@ -0,0 +1,104 @@
+#include <catch2/catch.hpp>
+#include <rwe/OccupiedGrid.h>
+
+namespace rwe
+{
+    TEST_CASE("OccupiedCell")
+    {
+        SECTION("starts empty")
+        {
+            OccupiedCell cell;
+            REQUIRE(cell.getOccupiedType() == OccupiedType::None);
+            REQUIRE(!cell.getUnit());
+            REQUIRE(!cell.getFeature());
+            REQUIRE(!cell.getBuildingCell());
+            REQUIRE(!cell.isBlocking());
+        }
+
+        SECTION("holds a unit")
+        {
+            auto cell = OccupiedCell::fromUnit(UnitId(0x123401));
+            REQUIRE(cell.getOccupiedType() == OccupiedType::Unit);
+            REQUIRE(cell.getUnit() == UnitId(0x123401));
+            REQUIRE(!cell.getFeature());
+            REQUIRE(cell.isBlocking());
+            REQUIRE(!cell.isBlockingFor(UnitId(0x123401)));
+            REQUIRE(cell.isBlockingFor(UnitId(0x123402)));
+            REQUIRE(!cell.isStaticallyBlocking());
+        }
+
+        SECTION("holds a feature")
+        {
+            auto cell = OccupiedCell::fromFeature(FeatureId(77));
+            REQUIRE(cell.getOccupiedType() == OccupiedType::Feature);
+            REQUIRE(cell.getFeature() == FeatureId(77));
+            REQUIRE(!cell.getUnit());
+            REQUIRE(cell.isBlockingFor(UnitId(77)));
+            REQUIRE(cell.isStaticallyBlocking());
+        }
+
+        SECTION("holds the largest id that fits")
+        {
+            auto largestId = OccupiedCell::MaxIdValue - 1;
+            REQUIRE(OccupiedCell::fromUnit(UnitId(largestId)).getUnit() == UnitId(largestId));
+            REQUIRE(OccupiedCell::fromFeature(FeatureId(largestId)).getFeature() == FeatureId(largestId));
+
+            OccupiedCell cell;
+            cell.setBuildingCell(BuildingOccupiedCell{UnitId(largestId), false});
+            REQUIRE(cell.getBuildingCell()->unit == UnitId(largestId));
+        }
+
+        SECTION("rejects ids too large to fit")
+        {
+            REQUIRE_THROWS_AS(OccupiedCell::fromUnit(UnitId(OccupiedCell::MaxIdValue)), std::out_of_range);
+            REQUIRE_THROWS_AS(OccupiedCell::fromFeature(FeatureId(OccupiedCell::MaxIdValue)), std::out_of_range);
+
+            OccupiedCell cell;
+            REQUIRE_THROWS_AS(cell.setBuildingCell(BuildingOccupiedCell{UnitId(OccupiedCell::MaxIdValue), true}), std::out_of_range);
+            REQUIRE(!cell.getBuildingCell());
+        }
+
+        SECTION("holds a building alongside an occupant")
+        {
+            auto cell = OccupiedCell::fromUnit(UnitId(5));
+            cell.setBuildingCell(BuildingOccupiedCell{UnitId(9), true});
+            REQUIRE(cell.getUnit() == UnitId(5));
+            REQUIRE(cell.getBuildingCell()->unit == UnitId(9));
+            REQUIRE(cell.getBuildingCell()->passable);
+            REQUIRE(cell.isBuildingCellOf(UnitId(9)));
+            REQUIRE(!cell.hasImpassableBuilding());
+
+            cell.clearOccupant();
+            REQUIRE(!cell.isBlocking());
+
+            cell.setBuildingCell(BuildingOccupiedCell{UnitId(9), false});
+            REQUIRE(cell.isBlocking());
+            REQUIRE(!cell.isBlockingFor(UnitId(9)));
+            REQUIRE(cell.isStaticallyBlocking());
+
+            cell.clearBuildingCell();
+            REQUIRE(cell == OccupiedCell());
+        }
+    }
+
+    TEST_CASE("isCollisionAt")
+    {
+        OccupiedGrid grid(8, 8, OccupiedCell());
+        grid.set(3, 4, OccupiedCell::fromUnit(UnitId(2)));
+
+        REQUIRE(isCollisionAt(grid, DiscreteRect(2, 3, 2, 2)));
+        REQUIRE(!isCollisionAt(grid, DiscreteRect(4, 3, 2, 2)));
+        REQUIRE(!isCollisionAt(grid, DiscreteRect(2, 3, 2, 2), UnitId(2)));
+        REQUIRE(isCollisionAt(grid, DiscreteRect(2, 3, 2, 2), UnitId(3)));
+
+        // outside the grid
+        REQUIRE(isCollisionAt(grid, DiscreteRect(7, 0, 2, 2)));
+        REQUIRE(isCollisionAt(grid, DiscreteRect(-1, 0, 2, 2), UnitId(2)));
+        REQUIRE(isStaticCollisionAt(grid, DiscreteRect(7, 7, 2, 1)));
+
+        // only features and buildings count as static
+        REQUIRE(!isStaticCollisionAt(grid, DiscreteRect(2, 3, 2, 2)));
+        grid.set(0, 0, OccupiedCell::fromFeature(FeatureId(1)));
+        REQUIRE(isStaticCollisionAt(grid, DiscreteRect(0, 0, 2, 2)));
+    }
+}
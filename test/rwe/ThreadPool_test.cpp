@@ -0,0 +1,111 @@
+#include <atomic>
+#include <catch2/catch.hpp>
+#include <rwe/ThreadPool.h>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace rwe
+{
+    TEST_CASE("ThreadPool")
+    {
+        SECTION("runs submitted jobs and returns their results")
+        {
+            ThreadPool pool(2);
+            auto a = pool.submit([]() { return 1 + 2; });
+            auto b = pool.submit([]() { return std::string("foo"); });
+            REQUIRE(a.get() == 3);
+            REQUIRE(b.get() == "foo");
+        }
+
+        SECTION("runs every job")
+        {
+            std::atomic<int> counter{0};
+            std::vector<std::future<void>> futures;
+
+            {
+                ThreadPool pool(4);
+                for (int i = 0; i < 100; ++i)
+                {
+                    futures.push_back(pool.submit([&counter]() { counter += 1; }));
+                }
+
+                for (auto& f : futures)
+                {
+                    f.get();
+                }
+            }
+
+            REQUIRE(counter == 100);
+        }
+
+        SECTION("reports exceptions through the future")
+        {
+            ThreadPool pool(1);
+            auto f = pool.submit([]() -> int { throw std::runtime_error("oops"); });
+            REQUIRE_THROWS_AS(f.get(), std::runtime_error);
+        }
+
+        SECTION("splits ranges into contiguous chunks")
+        {
+            ThreadPool pool(3);
+            REQUIRE(pool.getChunkCount(0, 10) == 1);
+            REQUIRE(pool.getChunkCount(25, 10) == 2);
+            REQUIRE(pool.getChunkCount(1000, 10) == 4);
+
+            std::vector<std::pair<std::size_t, std::size_t>> chunks(4);
+            pool.forEachChunk(1000, 10, [&chunks](std::size_t chunk, std::size_t begin, std::size_t end) {
+                chunks[chunk] = {begin, end};
+            });
+
+            REQUIRE(chunks.front().first == 0);
+            REQUIRE(chunks.back().second == 1000);
+            for (std::size_t i = 1; i < chunks.size(); ++i)
+            {
+                REQUIRE(chunks[i].first == chunks[i - 1].second);
+                REQUIRE(chunks[i].second > chunks[i].first);
+            }
+        }
+
+        SECTION("rethrows the exception from the lowest chunk")
+        {
+            ThreadPool pool(3);
+            std::atomic<int> finished{0};
+            auto f = [&finished](std::size_t chunk, std::size_t, std::size_t) {
+                finished += 1;
+                if (chunk >= 2)
+                {
+                    throw std::runtime_error("chunk " + std::to_string(chunk));
+                }
+            };
+            REQUIRE_THROWS_WITH(pool.forEachChunk(100, 1, f), "chunk 2");
+            REQUIRE(finished == 4);
+        }
+
+        SECTION("runs chunks on the caller when the pool is busy")
+        {
+            ThreadPool pool(1);
+            std::promise<void> gate;
+            auto blocker = pool.submit([future = gate.get_future()]() { future.wait(); });
+
+            auto caller = std::this_thread::get_id();
+            std::vector<std::thread::id> threads(2);
+            pool.forEachChunk(2, 1, [&threads](std::size_t chunk, std::size_t, std::size_t) {
+                threads[chunk] = std::this_thread::get_id();
+            });
+
+            REQUIRE(threads == std::vector<std::thread::id>{caller, caller});
+
+            gate.set_value();
+            blocker.get();
+        }
+
+        SECTION("always has at least one thread")
+        {
+            ThreadPool pool(0);
+            REQUIRE(pool.getThreadCount() == 1);
+            REQUIRE(pool.submit([]() { return 5; }).get() == 5);
+        }
+    }
+}
@@ -0,0 +1,131 @@
+#include <catch2/catch.hpp>
+#include <rwe/OpaqueId_io.h>
+#include <rwe/SimVector.h>
+#include <rwe/UnitMesh.h>
+
+namespace rwe
+{
+    static UnitMesh::Piece& addPiece(UnitMesh& mesh, const std::string& name, std::optional<unsigned int> parent, const Vector3x<SimScalar>& origin)
+    {
+        auto& piece = mesh.pieces.emplace_back();
+        piece.name = name;
+        piece.parent = parent;
+        piece.origin = origin;
+        return piece;
+    }
+
+    TEST_CASE("UnitMesh")
+    {
+        UnitMesh mesh;
+        addPiece(mesh, "base", std::nullopt, Vector3x<SimScalar>(1_ss, 0_ss, 0_ss));
+        addPiece(mesh, "turret", 0, Vector3x<SimScalar>(0_ss, 2_ss, 0_ss));
+        addPiece(mesh, "barrel", 1, Vector3x<SimScalar>(0_ss, 0_ss, 3_ss));
+        addPiece(mesh, "flare", 0, Vector3x<SimScalar>(0_ss, 0_ss, 4_ss));
+
+        SECTION("finds pieces by name, ignoring case")
+        {
+            REQUIRE(mesh.findPieceIndex("base") == 0u);
+            REQUIRE(mesh.findPieceIndex("BARREL") == 2u);
+            REQUIRE(mesh.findPieceIndex("Flare") == 3u);
+            REQUIRE(mesh.findPieceIndex("wheel") == std::nullopt);
+        }
+
+        SECTION("piece transforms include every ancestor")
+        {
+            auto origin = SimVector(0_ss, 0_ss, 0_ss);
+            REQUIRE(mesh.getPieceTransform(0) * origin == SimVector(1_ss, 0_ss, 0_ss));
+            REQUIRE(mesh.getPieceTransform(2) * origin == SimVector(1_ss, 2_ss, 3_ss));
+            REQUIRE(mesh.getPieceTransform(3) * origin == SimVector(1_ss, 0_ss, 4_ss));
+
+            mesh.setPieceOffset(1, Axis::Y, 5_ss);
+            REQUIRE(mesh.getPieceTransform(2) * origin == SimVector(1_ss, 7_ss, 3_ss));
+            REQUIRE(mesh.getPieceTransform(3) * origin == SimVector(1_ss, 0_ss, 4_ss));
+        }
+
+        SECTION("piece transforms follow changes made after they were computed")
+        {
+            auto origin = SimVector(0_ss, 0_ss, 0_ss);
+            REQUIRE(mesh.getPieceTransform(2) * origin == SimVector(1_ss, 2_ss, 3_ss));
+
+            mesh.setPieceRotation(0, Axis::Y, QuarterTurn);
+            REQUIRE(mesh.getPieceTransform(0) * origin == SimVector(1_ss, 0_ss, 0_ss));
+            REQUIRE(mesh.getPieceTransform(2) * origin != SimVector(1_ss, 2_ss, 3_ss));
+            REQUIRE(mesh.getPieceTransform(2) * origin == mesh.getPieceTransform(0) * mesh.pieces[1].getTransform() * mesh.pieces[2].getTransform() * origin);
+
+            mesh.setMoveOperation(1, Axis::Y, UnitMesh::MoveOperation(1_ss, 1_ss));
+            mesh.update(1_ss);
+            REQUIRE(mesh.pieces[1].offset.y == 1_ss);
+            REQUIRE(mesh.getPieceTransform(2) * origin == mesh.getPieceTransform(0) * mesh.pieces[1].getTransform() * mesh.pieces[2].getTransform() * origin);
+
+            // changing a piece directly needs the cache to be told
+            mesh.pieces[3].offset.x = 2_ss;
+            mesh.invalidatePieceTransform(3);
+            REQUIRE(mesh.getPieceTransform(3) * origin == mesh.getPieceTransform(0) * mesh.pieces[3].getTransform() * origin);
+        }
+
+        SECTION("update advances the operations of every piece")
+        {
+            mesh.setMoveOperation(0, Axis::X, UnitMesh::MoveOperation(10_ss, 1_ss));
+            mesh.setMoveOperation(2, Axis::Y, UnitMesh::MoveOperation(-10_ss, 2_ss));
+
+            REQUIRE(!mesh.update(1_ss));
+
+            REQUIRE(mesh.pieces[0].offset.x == 1_ss);
+            REQUIRE(mesh.pieces[2].offset.y == -2_ss);
+            REQUIRE(mesh.pieces[1].offset == SimVector(0_ss, 0_ss, 0_ss));
+        }
+
+        SECTION("update reports when an operation finishes")
+        {
+            mesh.setMoveOperation(1, Axis::Z, UnitMesh::MoveOperation(3_ss, 2_ss));
+            mesh.setTurnOperation(3, Axis::Y, UnitMesh::SpinOperation(1_ss, 1_ss, 0_ss));
+
+            REQUIRE(!mesh.update(1_ss));
+            REQUIRE(mesh.update(1_ss));
+            REQUIRE(!mesh.getMoveOperation(1, Axis::Z));
+
+            // spinning never finishes by itself
+            REQUIRE(!mesh.update(1_ss));
+        }
+
+        SECTION("keeps only the operations in progress")
+        {
+            REQUIRE(mesh.operations.empty());
+
+            mesh.setMoveOperation(1, Axis::X, UnitMesh::MoveOperation(1_ss, 1_ss));
+            mesh.setMoveOperation(1, Axis::Y, UnitMesh::MoveOperation(5_ss, 1_ss));
+            mesh.setTurnOperation(1, Axis::X, UnitMesh::TurnOperation(SimAngle(100), 1000_ss));
+            REQUIRE(mesh.operations.size() == 3);
+
+            // replacing an operation doesn't add another
+            mesh.setMoveOperation(1, Axis::Y, UnitMesh::MoveOperation(2_ss, 1_ss));
+            REQUIRE(mesh.operations.size() == 3);
+            REQUIRE(mesh.getMoveOperation(1, Axis::Y)->targetPosition == 2_ss);
+
+            REQUIRE(mesh.update(1_ss));
+            REQUIRE(mesh.operations.size() == 1);
+            REQUIRE(mesh.pieces[1].offset == SimVector(1_ss, 1_ss, 0_ss));
+            REQUIRE(mesh.pieces[1].rotationX == SimAngle(100));
+            REQUIRE(!mesh.getTurnOperation(1, Axis::X));
+            REQUIRE(mesh.getMoveOperation(1, Axis::Y));
+
+            mesh.setMoveOperation(1, Axis::Y, std::nullopt);
+            REQUIRE(mesh.operations.empty());
+        }
+
+        SECTION("spins can be slowed to a stop")
+        {
+            mesh.setTurnOperation(2, Axis::Z, UnitMesh::SpinOperation(4_ss, 4_ss, 2_ss));
+            REQUIRE(std::get<UnitMesh::SpinOperation>(*mesh.getTurnOperation(2, Axis::Z)).targetSpeed == 4_ss);
+
+            mesh.setTurnOperation(2, Axis::Z, UnitMesh::StopSpinOperation(4_ss, 4_ss));
+            REQUIRE(mesh.operations.size() == 1);
+
+            REQUIRE(!mesh.update(1_ss));
+            REQUIRE(mesh.pieces[2].rotationZ == SimAngle(2));
+            REQUIRE(mesh.update(1_ss));
+            REQUIRE(mesh.pieces[2].rotationZ == SimAngle(2));
+            REQUIRE(mesh.operations.empty());
+        }
+    }
+}
@@ -0,0 +1,65 @@
+#include <catch2/catch.hpp>
+#include <rwe/UnitSpatialIndex.h>
+
+namespace rwe
+{
+    TEST_CASE("UnitSpatialIndex")
+    {
+        UnitSpatialIndex index(64, 64);
+
+        SECTION("starts empty")
+        {
+            REQUIRE(index.query(DiscreteRect(0, 0, 64, 64)).empty());
+        }
+
+        SECTION("finds inserted units")
+        {
+            index.insert(UnitId(1), DiscreteRect(2, 2, 2, 2));
+            index.insert(UnitId(2), DiscreteRect(40, 40, 3, 3));
+
+            REQUIRE(index.query(DiscreteRect(0, 0, 4, 4)) == std::vector<UnitId>{UnitId(1)});
+            REQUIRE(index.query(DiscreteRect(41, 41, 1, 1)) == std::vector<UnitId>{UnitId(2)});
+            REQUIRE(index.query(DiscreteRect(20, 20, 2, 2)).empty());
+        }
+
+        SECTION("returns results in ascending ID order without duplicates")
+        {
+            // spans four buckets
+            index.insert(UnitId(7), DiscreteRect(6, 6, 4, 4));
+            index.insert(UnitId(3), DiscreteRect(1, 1, 2, 2));
+            index.insert(UnitId(5), DiscreteRect(9, 1, 2, 2));
+
+            std::vector<UnitId> expected{UnitId(3), UnitId(5), UnitId(7)};
+            REQUIRE(index.query(DiscreteRect(0, 0, 16, 16)) == expected);
+        }
+
+        SECTION("forgets removed units")
+        {
+            index.insert(UnitId(1), DiscreteRect(6, 6, 4, 4));
+            index.insert(UnitId(2), DiscreteRect(6, 6, 1, 1));
+            index.remove(UnitId(1), DiscreteRect(6, 6, 4, 4));
+
+            REQUIRE(index.query(DiscreteRect(0, 0, 64, 64)) == std::vector<UnitId>{UnitId(2)});
+        }
+
+        SECTION("tracks moved units")
+        {
+            index.insert(UnitId(1), DiscreteRect(2, 2, 2, 2));
+
+            index.move(UnitId(1), DiscreteRect(2, 2, 2, 2), DiscreteRect(3, 3, 2, 2));
+            REQUIRE(index.query(DiscreteRect(0, 0, 8, 8)) == std::vector<UnitId>{UnitId(1)});
+
+            index.move(UnitId(1), DiscreteRect(3, 3, 2, 2), DiscreteRect(30, 30, 2, 2));
+            REQUIRE(index.query(DiscreteRect(0, 0, 8, 8)).empty());
+            REQUIRE(index.query(DiscreteRect(30, 30, 1, 1)) == std::vector<UnitId>{UnitId(1)});
+        }
+
+        SECTION("clips queries to the map")
+        {
+            index.insert(UnitId(1), DiscreteRect(62, 62, 2, 2));
+
+            REQUIRE(index.query(DiscreteRect(60, 60, 100, 100)) == std::vector<UnitId>{UnitId(1)});
+            REQUIRE(index.query(DiscreteRect(-10, -10, 5, 5)).empty());
+        }
+    }
+}
@@ -286,6 +286,33 @@ namespace rwe
             REQUIRE(c.find(dId) == c.end());
         }
 
+        SECTION("layout can be restored into another map")
+        {
+            VectorMap<char, IdTag> m;
+            auto aId = m.emplace('a');
+            auto bId = m.emplace('b');
+            auto cId = m.emplace('c');
+            m.emplace('d');
+            m.remove(cId);
+            m.remove(aId);
+
+            VectorMap<char, IdTag> n;
+            n.emplace('x');
+            n.resetLayout(m.getSlotIds(), m.getFreeSlots());
+            REQUIRE(n.find(Id(0)) == n.end());
+
+            n.emplaceAt(bId, 'b');
+            n.emplaceAt(Id(768), 'd');
+            REQUIRE(n.tryGet(bId) == 'b');
+            REQUIRE(n.tryGet(Id(768)) == 'd');
+            REQUIRE_THROWS(n.emplaceAt(bId, 'z'));
+
+            // new elements reuse slots in the same order as the original
+            REQUIRE(n.emplace('e') == m.emplace('e'));
+            REQUIRE(n.emplace('f') == m.emplace('f'));
+            REQUIRE(n.emplace('g') == m.emplace('g'));
+        }
+
         rc::prop("can insert and remove elements and it doesn't break", [](std::vector<std::optional<int>> ops) {
             VectorMap<int, IdTag> m;
 
@@ -0,0 +1,30 @@
+#include <catch2/catch.hpp>
+#include <rwe/WeaponDefinition.h>
+
+namespace rwe
+{
+    TEST_CASE("WeaponDefinition")
+    {
+        SECTION("getDamage")
+        {
+            WeaponDefinition weapon;
+            weapon.damage = {10, WeaponDefinition::NoDamage, 30};
+
+            SECTION("returns the damage for the unit type")
+            {
+                REQUIRE(weapon.getDamage(UnitTypeId(0)) == 10);
+                REQUIRE(weapon.getDamage(UnitTypeId(2)) == 30);
+            }
+
+            SECTION("throws for unit types without damage")
+            {
+                REQUIRE_THROWS(weapon.getDamage(UnitTypeId(1)));
+            }
+
+            SECTION("throws for unit types it doesn't know about")
+            {
+                REQUIRE_THROWS(weapon.getDamage(UnitTypeId(3)));
+            }
+        }
+    }
+}
@@ -0,0 +1,145 @@
+#include <catch2/catch.hpp>
+#include <rwe/cob/CobEnvironment.h>
+
+namespace rwe
+{
+    static CobScript createScript(std::vector<CobFunctionInfo>&& functions)
+    {
+        CobScript script;
+        script.functions = std::move(functions);
+        script.staticVariableCount = 0;
+        script.entryPoints = resolveCobEntryPoints(script.functions);
+        return script;
+    }
+
+    TEST_CASE("resolveCobEntryPoints")
+    {
+        std::vector<CobFunctionInfo> functions{{"Create", 0}, {"AimPrimary", 10}, {"queryprimary", 20}, {"QueryTertiary", 30}};
+        auto table = resolveCobEntryPoints(functions);
+
+        REQUIRE(table[static_cast<unsigned int>(CobEntryPoint::Create)] == 0u);
+        REQUIRE(table[static_cast<unsigned int>(CobEntryPoint::AimPrimary)] == 1u);
+        REQUIRE(table[static_cast<unsigned int>(CobEntryPoint::QueryTertiary)] == 3u);
+
+        // names must match exactly, as when looking up by name
+        REQUIRE(table[static_cast<unsigned int>(CobEntryPoint::QueryPrimary)] == std::nullopt);
+        REQUIRE(table[static_cast<unsigned int>(CobEntryPoint::StartMoving)] == std::nullopt);
+    }
+
+    TEST_CASE("CobEnvironment")
+    {
+        auto script = createScript({{"Create", 0}, {"AimPrimary", 10}});
+        CobEnvironment env(&script);
+
+        SECTION("starts entry points with parameters")
+        {
+            auto thread = env.createThread(CobEntryPoint::AimPrimary, {3, 4});
+            REQUIRE(thread);
+            REQUIRE(env.readyQueue.size() == 1);
+            REQUIRE(env.readyQueue.front() == *thread);
+            REQUIRE((*thread)->functionId == 1);
+            REQUIRE((*thread)->callStack.top().instructionIndex == 10);
+            REQUIRE((*thread)->locals.size() == 2);
+            REQUIRE((*thread)->locals[0] == 3);
+            REQUIRE((*thread)->locals[1] == 4);
+        }
+
+        SECTION("ignores entry points the script doesn't implement")
+        {
+            REQUIRE(!env.createThread(CobEntryPoint::StartMoving));
+            REQUIRE(env.readyQueue.empty());
+
+            REQUIRE(!env.createNonScheduledThread(CobEntryPoint::QueryPrimary, {0}));
+        }
+
+        SECTION("creates non-scheduled threads for entry points")
+        {
+            auto thread = env.createNonScheduledThread(CobEntryPoint::Create, {0});
+            REQUIRE(thread);
+            REQUIRE(thread->callStack.top().instructionIndex == 0);
+            REQUIRE(env.readyQueue.empty());
+        }
+
+        SECTION("reuses deleted threads")
+        {
+            auto first = env.createThread(0, {}, 0);
+            env.deleteThread(const_cast<CobThread*>(first));
+            REQUIRE(env.readyQueue.empty());
+            REQUIRE(env.isNotCorrupt());
+
+            auto second = env.createThread(1, {7}, 0);
+            REQUIRE(second == first);
+            REQUIRE(second->functionId == 1);
+            REQUIRE(second->stack.empty());
+            REQUIRE(second->callStack.size() == 1);
+            REQUIRE(second->locals.size() == 1);
+            REQUIRE(second->locals[0] == 7);
+            REQUIRE(env.readyQueue.size() == 1);
+            REQUIRE(env.isNotCorrupt());
+        }
+
+        SECTION("doesn't reap through the handle of a deleted thread")
+        {
+            auto first = const_cast<CobThread*>(env.createThread(1, {}, 1));
+            auto handle = first->getHandle();
+            env.sendSignal(1);
+            REQUIRE(!handle.isCurrent());
+
+            auto second = const_cast<CobThread*>(env.createThread(0, {}, 0));
+            REQUIRE(second == first);
+            second->returnValue = 1;
+            env.readyQueue.remove(second);
+            env.finishedQueue.push_back(second);
+
+            REQUIRE(!env.tryReapThread(handle));
+            REQUIRE(env.tryReapThread(second->getHandle()) == 1);
+        }
+
+        SECTION("signals kill only threads with a matching mask")
+        {
+            auto a = env.createThread(0, {}, 1);
+            auto b = env.createThread(0, {}, 2);
+            auto c = env.createThread(0, {}, 3);
+            auto d = env.createThread(0, {}, 0);
+
+            env.sendSignal(2);
+
+            REQUIRE(env.readyQueue.size() == 2);
+            REQUIRE(env.readyQueue.contains(a));
+            REQUIRE(!env.readyQueue.contains(b));
+            REQUIRE(!env.readyQueue.contains(c));
+            REQUIRE(env.readyQueue.contains(d));
+            REQUIRE(env.isNotCorrupt());
+        }
+
+        SECTION("signals reach threads in every queue")
+        {
+            auto a = env.createThread(0, {}, 1);
+            auto b = const_cast<CobThread*>(env.createThread(0, {}, 1));
+            env.readyQueue.remove(b);
+            b->blockedCondition = CobEnvironment::BlockedStatus::Sleep(GameTime(5));
+            env.blockedQueue.push_back(b);
+
+            env.sendSignal(1);
+
+            REQUIRE(!env.readyQueue.contains(a));
+            REQUIRE(env.blockedQueue.empty());
+            REQUIRE(env.isNotCorrupt());
+        }
+
+        SECTION("changing a thread's mask changes which signals kill it")
+        {
+            auto thread = const_cast<CobThread*>(env.createThread(0, {}, 1));
+
+            env.setSignalMask(thread, 4);
+            REQUIRE(thread->signalMask == 4);
+
+            env.sendSignal(1);
+            REQUIRE(env.readyQueue.contains(thread));
+
+            env.sendSignal(4);
+            REQUIRE(env.readyQueue.empty());
+            REQUIRE(env.isNotCorrupt());
+        }
+    }
+}
@@ -0,0 +1,329 @@
+#include "../simulation_test_util.h"
+#include <catch2/catch.hpp>
+#include <rwe/cob/CobExecutionContext.h>
+#include <rwe/cob/CobOpCode.h>
+
+namespace rwe
+{
+    static std::uint32_t op(OpCode code)
+    {
+        return static_cast<std::uint32_t>(code);
+    }
+
+    static UnitId addBuilding(GameSimulation& sim, const CobScript* script)
+    {
+        auto unit = createTestUnit(script, sim.terrain.heightmapIndexToWorldCenter(1, 1));
+        unit.isMobile = false;
+        unit.yardMap = Grid<YardMapCell>(1, 1, YardMapCell::GroundPassableWhenOpen);
+
+        auto unitId = sim.tryAddUnit(std::move(unit));
+        REQUIRE(unitId);
+        return *unitId;
+    }
+
+    TEST_CASE("CobExecutionContext")
+    {
+        auto sim = createFlatSimulation(4, 4);
+
+        SECTION("runs loops over locals")
+        {
+            // local i, total; while (i < 10) { total = total + i; i = i + 1; } return total;
+            auto script = createTestScript(
+                {
+                    op(OpCode::CREATE_LOCAL_VAR),
+                    op(OpCode::CREATE_LOCAL_VAR),
+                    op(OpCode::PUSH_LOCAL_VAR), 0, // 2
+                    op(OpCode::PUSH_CONSTANT), 10,
+                    op(OpCode::SET_LESS),
+                    op(OpCode::JUMP_IF_ZERO), 25,
+                    op(OpCode::PUSH_LOCAL_VAR), 1, // 9
+                    op(OpCode::PUSH_LOCAL_VAR), 0,
+                    op(OpCode::ADD),
+                    op(OpCode::POP_LOCAL_VAR), 1,
+                    op(OpCode::PUSH_LOCAL_VAR), 0, // 16
+                    op(OpCode::PUSH_CONSTANT), 1,
+                    op(OpCode::ADD),
+                    op(OpCode::POP_LOCAL_VAR), 0,
+                    op(OpCode::JUMP), 2, // 23
+                    op(OpCode::PUSH_LOCAL_VAR), 1, // 25
+                    op(OpCode::RETURN),
+                },
+                {{"Sum", 0}}, 1);
+            CobEnvironment env(&script);
+            auto thread = env.createNonScheduledThread(0, {});
+
+            CobExecutionContext context(nullptr, &sim, &sim.rng, &env, &thread, UnitId(0));
+            auto status = context.execute();
+
+            REQUIRE(std::holds_alternative<CobEnvironment::FinishedStatus>(status));
+            REQUIRE(thread.returnValue == 45);
+            REQUIRE(thread.callStack.empty());
+            REQUIRE(thread.locals.empty());
+
+            // fused instructions count as what they replaced
+            REQUIRE(context.getInstructionCount() == 2 + (13 * 10) + 4 + 2);
+        }
+
+        SECTION("calls functions with parameters")
+        {
+            auto script = createTestScript(
+                {
+                    // Main: local x = 4; Sub(10, 3); return x;
+                    op(OpCode::CREATE_LOCAL_VAR),
+                    op(OpCode::PUSH_CONSTANT), 4,
+                    op(OpCode::POP_LOCAL_VAR), 0,
+                    op(OpCode::PUSH_CONSTANT), 3,
+                    op(OpCode::PUSH_CONSTANT), 10,
+                    op(OpCode::CALL_SCRIPT), 1, 2,
+                    op(OpCode::PUSH_LOCAL_VAR), 0,
+                    op(OpCode::RETURN),
+                    // Sub(a, b): static0 = a - b; return 0;
+                    op(OpCode::PUSH_LOCAL_VAR), 0, // 15
+                    op(OpCode::PUSH_LOCAL_VAR), 1,
+                    op(OpCode::SUB),
+                    op(OpCode::POP_STATIC), 0,
+                    op(OpCode::PUSH_CONSTANT), 0,
+                    op(OpCode::RETURN),
+                },
+                {{"Main", 0}, {"Sub", 15}}, 1);
+            CobEnvironment env(&script);
+            auto thread = env.createNonScheduledThread(0, {});
+
+            CobExecutionContext context(nullptr, &sim, &sim.rng, &env, &thread, UnitId(0));
+            auto status = context.execute();
+
+            REQUIRE(std::holds_alternative<CobEnvironment::FinishedStatus>(status));
+            REQUIRE(env.getStatic(0) == 7);
+            REQUIRE(thread.returnValue == 4);
+        }
+
+        SECTION("returns the final values of the parameters")
+        {
+            auto script = createTestScript(
+                {
+                    op(OpCode::PUSH_CONSTANT), 9,
+                    op(OpCode::POP_LOCAL_VAR), 0,
+                    op(OpCode::PUSH_CONSTANT), 0,
+                    op(OpCode::RETURN),
+                },
+                {{"QueryPrimary", 0}}, 1);
+            CobEnvironment env(&script);
+            auto thread = env.createNonScheduledThread(0, {0});
+
+            CobExecutionContext context(nullptr, &sim, &sim.rng, &env, &thread, UnitId(0));
+            context.execute();
+
+            REQUIRE(thread.returnLocals == std::vector<int>{9});
+        }
+
+        SECTION("resumes after sleeping")
+        {
+            auto script = createTestScript(
+                {
+                    op(OpCode::PUSH_CONSTANT), 100,
+                    op(OpCode::SLEEP),
+                    op(OpCode::PUSH_CONSTANT), 5,
+                    op(OpCode::RETURN),
+                },
+                {{"Main", 0}}, 1);
+            CobEnvironment env(&script);
+            auto thread = env.createNonScheduledThread(0, {});
+
+            {
+                CobExecutionContext context(nullptr, &sim, &sim.rng, &env, &thread, UnitId(0));
+                auto status = context.execute();
+                REQUIRE(std::holds_alternative<CobEnvironment::BlockedStatus>(status));
+                REQUIRE(thread.callStack.top().instructionIndex == 3);
+            }
+
+            {
+                CobExecutionContext context(nullptr, &sim, &sim.rng, &env, &thread, UnitId(0));
+                auto status = context.execute();
+                REQUIRE(std::holds_alternative<CobEnvironment::FinishedStatus>(status));
+                REQUIRE(thread.returnValue == 5);
+            }
+        }
+
+        SECTION("records effects outside the unit as commands")
+        {
+            // set ACTIVATION to 1; set INBUILDSTANCE to 0; set BUGGER_OFF to 0; return 0;
+            auto script = createTestScript(
+                {
+                    op(OpCode::PUSH_CONSTANT), static_cast<std::uint32_t>(CobValueId::Activation),
+                    op(OpCode::PUSH_CONSTANT), 1,
+                    op(OpCode::SET_VALUE),
+                    op(OpCode::PUSH_CONSTANT), static_cast<std::uint32_t>(CobValueId::InBuildStance),
+                    op(OpCode::PUSH_CONSTANT), 0,
+                    op(OpCode::SET_VALUE),
+                    op(OpCode::PUSH_CONSTANT), static_cast<std::uint32_t>(CobValueId::BuggerOff),
+                    op(OpCode::PUSH_CONSTANT), 0,
+                    op(OpCode::SET_VALUE),
+                    op(OpCode::PUSH_CONSTANT), 0,
+                    op(OpCode::RETURN),
+                },
+                {{"Main", 0}}, 1);
+            CobEnvironment env(&script);
+            auto thread = env.createNonScheduledThread(0, {});
+            auto unitId = addBuilding(sim, &script);
+
+            CobCommandBuffer commands;
+            CobExecutionContext context(&commands, &sim, &sim.rng, &env, &thread, unitId);
+            context.execute();
+
+            REQUIRE(commands.unitCommands.size() == 2);
+            REQUIRE(commands.unitCommands[0].unit == unitId);
+            REQUIRE(std::get<CobUnitCommand::SetActivation>(commands.unitCommands[0].command).value);
+            REQUIRE(!std::get<CobUnitCommand::SetBuildStance>(commands.unitCommands[1].command).value);
+        }
+
+        SECTION("reads back values it set before the commands are applied")
+        {
+            // set YARD_OPEN to 1; set ACTIVATION to 1; static0 = get ACTIVATION; return get YARD_OPEN;
+            auto script = createTestScript(
+                {
+                    op(OpCode::PUSH_CONSTANT), static_cast<std::uint32_t>(CobValueId::YardOpen),
+                    op(OpCode::PUSH_CONSTANT), 1,
+                    op(OpCode::SET_VALUE),
+                    op(OpCode::PUSH_CONSTANT), static_cast<std::uint32_t>(CobValueId::Activation),
+                    op(OpCode::PUSH_CONSTANT), 1,
+                    op(OpCode::SET_VALUE),
+                    op(OpCode::PUSH_CONSTANT), static_cast<std::uint32_t>(CobValueId::Activation),
+                    op(OpCode::GET_VALUE),
+                    op(OpCode::POP_STATIC), 0,
+                    op(OpCode::PUSH_CONSTANT), static_cast<std::uint32_t>(CobValueId::YardOpen),
+                    op(OpCode::GET_VALUE),
+                    op(OpCode::RETURN),
+                },
+                {{"Main", 0}}, 1);
+            CobEnvironment env(&script);
+            auto thread = env.createNonScheduledThread(0, {});
+            auto unitId = addBuilding(sim, &script);
+
+            CobCommandBuffer commands;
+            CobExecutionContext context(&commands, &sim, &sim.rng, &env, &thread, unitId);
+            context.execute();
+
+            REQUIRE(thread.returnValue == 1);
+            REQUIRE(env.getStatic(0) == 1);
+
+            // the occupied grid still waits for the command
+            REQUIRE(commands.unitCommands.size() == 2);
+            REQUIRE(std::get<CobUnitCommand::SetYardOpen>(commands.unitCommands[0].command).value);
+            auto footprint = sim.occupiedGrid.tryToRegion(sim.computeFootprintRegion(sim.getUnit(unitId).position, 1, 1));
+            REQUIRE(footprint);
+            auto buildingCell = sim.occupiedGrid.get(footprint->x, footprint->y).getBuildingCell();
+            REQUIRE(buildingCell);
+            REQUIRE(!buildingCell->passable);
+        }
+
+        SECTION("draws random numbers from the given generator")
+        {
+            // return rand(1, 1000);
+            auto script = createTestScript(
+                {
+                    op(OpCode::PUSH_CONSTANT), 1,
+                    op(OpCode::PUSH_CONSTANT), 1000,
+                    op(OpCode::RAND),
+                    op(OpCode::RETURN),
+                },
+                {{"Main", 0}}, 1);
+            CobEnvironment env(&script);
+            auto thread = env.createNonScheduledThread(0, {});
+            auto simRng = sim.rng;
+
+            std::minstd_rand rng(5);
+            CobExecutionContext context(nullptr, &sim, &rng, &env, &thread, UnitId(0));
+            context.execute();
+
+            std::minstd_rand expectedRng(5);
+            REQUIRE(thread.returnValue == std::uniform_int_distribution<int>(1, 1000)(expectedRng));
+            REQUIRE(rng == expectedRng);
+            REQUIRE(sim.rng == simRng);
+        }
+
+        SECTION("ends the thread when a script leaves too many values on the stack")
+        {
+            // local i; while (i < 1000) { push i; i = i + 1; } return pop;
+            auto script = createTestScript(
+                {
+                    op(OpCode::CREATE_LOCAL_VAR),
+                    op(OpCode::PUSH_LOCAL_VAR), 0, // 1
+                    op(OpCode::PUSH_CONSTANT), 1000,
+                    op(OpCode::SET_LESS),
+                    op(OpCode::JUMP_IF_ZERO), 19,
+                    op(OpCode::PUSH_LOCAL_VAR), 0,
+                    op(OpCode::PUSH_LOCAL_VAR), 0,
+                    op(OpCode::PUSH_CONSTANT), 1,
+                    op(OpCode::ADD),
+                    op(OpCode::POP_LOCAL_VAR), 0,
+                    op(OpCode::JUMP), 1, // 17
+                    op(OpCode::RETURN), // 19
+                },
+                {{"Main", 0}}, 1);
+            CobEnvironment env(&script);
+            auto thread = env.createNonScheduledThread(0, {});
+
+            CobExecutionContext context(nullptr, &sim, &sim.rng, &env, &thread, UnitId(0));
+            auto status = context.execute();
+
+            REQUIRE(std::holds_alternative<CobEnvironment::FinishedStatus>(status));
+            REQUIRE(thread.stack.size() == CobThread::MaxStackSize);
+            REQUIRE(thread.stack[0] == 0);
+            REQUIRE(thread.callStack.size() == 1);
+        }
+
+        SECTION("ends the thread when it recurses too deeply")
+        {
+            // Main: Main(); return 1;
+            auto script = createTestScript(
+                {
+                    op(OpCode::CALL_SCRIPT), 0, 0,
+                    op(OpCode::PUSH_CONSTANT), 1,
+                    op(OpCode::RETURN),
+                },
+                {{"Main", 0}}, 1);
+            CobEnvironment env(&script);
+            auto thread = env.createNonScheduledThread(0, {});
+
+            CobExecutionContext context(nullptr, &sim, &sim.rng, &env, &thread, UnitId(0));
+            auto status = context.execute();
+
+            REQUIRE(std::holds_alternative<CobEnvironment::FinishedStatus>(status));
+            REQUIRE(thread.callStack.size() == CobThread::MaxCallDepth);
+        }
+
+        SECTION("ends the thread when it declares too many locals")
+        {
+            // local x0, ..., x128; x128 = 7; return x128;
+            std::vector<std::uint32_t> instructions(CobThread::MaxLocals + 1, op(OpCode::CREATE_LOCAL_VAR));
+            instructions.insert(
+                instructions.end(),
+                {
+                    op(OpCode::PUSH_CONSTANT), 7,
+                    op(OpCode::POP_LOCAL_VAR), CobThread::MaxLocals,
+                    op(OpCode::PUSH_LOCAL_VAR), CobThread::MaxLocals,
+                    op(OpCode::RETURN),
+                });
+            auto script = createTestScript(std::move(instructions), {{"Main", 0}}, 1);
+            CobEnvironment env(&script);
+            auto thread = env.createNonScheduledThread(0, {});
+
+            CobExecutionContext context(nullptr, &sim, &sim.rng, &env, &thread, UnitId(0));
+            auto status = context.execute();
+
+            REQUIRE(std::holds_alternative<CobEnvironment::FinishedStatus>(status));
+            REQUIRE(thread.locals.size() == CobThread::MaxLocals);
+            REQUIRE(thread.callStack.top().localCount == CobThread::MaxLocals);
+        }
+
+        SECTION("throws when running off the end of the code")
+        {
+            auto script = createTestScript({op(OpCode::PUSH_CONSTANT), 1}, {{"Main", 0}}, 1);
+            CobEnvironment env(&script);
+            auto thread = env.createNonScheduledThread(0, {});
+
+            CobExecutionContext context(nullptr, &sim, &sim.rng, &env, &thread, UnitId(0));
+            REQUIRE_THROWS_AS(context.execute(), std::out_of_range);
+        }
+    }
+}
@@ -0,0 +1,134 @@
+#include <algorithm>
+#include "../simulation_test_util.h"
+#include <catch2/catch.hpp>
+#include <rwe/cob/CobExecutionService.h>
+#include <rwe/cob/CobOpCode.h>
+#include <rwe/cob/CobValueId.h>
+
+namespace rwe
+{
+    static std::uint32_t op(OpCode code)
+    {
+        return static_cast<std::uint32_t>(code);
+    }
+
+    struct ScriptRun
+    {
+        std::vector<int> randomValues;
+        std::vector<UnitId> activatedUnits;
+        std::uint64_t instructionCount;
+        std::size_t sleepingThreads;
+    };
+
+    /** Runs every unit's Create script once with the given number of worker threads. */
+    static ScriptRun runScripts(const CobScript& script, unsigned int unitCount, unsigned int workerCount)
+    {
+        const unsigned int gridSide = 10;
+        auto sim = createFlatSimulation((gridSide * 2) + 2, (gridSide * 2) + 2);
+
+        std::vector<UnitId> unitIds;
+        for (unsigned int i = 0; i < unitCount; ++i)
+        {
+            auto position = sim.terrain.heightmapIndexToWorldCenter(static_cast<int>(((i % gridSide) * 2) + 1), static_cast<int>(((i / gridSide) * 2) + 1));
+            auto unitId = sim.tryAddUnit(createTestUnit(&script, position));
+            REQUIRE(unitId);
+            unitIds.push_back(*unitId);
+            sim.getUnit(*unitId).cobEnvironment->createThread(0, {});
+        }
+
+        ThreadPool threadPool(workerCount);
+        CobExecutionService service;
+        std::vector<CobUnitCommand> commands;
+        auto instructionCount = service.runUnits(threadPool, sim, unitIds, commands);
+
+        ScriptRun result{{}, {}, instructionCount, sim.cobSleepTimers.size()};
+        for (auto unitId : unitIds)
+        {
+            result.randomValues.push_back(sim.getUnit(unitId).cobEnvironment->getStatic(0));
+        }
+        for (const auto& command : commands)
+        {
+            REQUIRE(std::get<CobUnitCommand::SetActivation>(command.command).value);
+            result.activatedUnits.push_back(command.unit);
+        }
+        return result;
+    }
+
+    TEST_CASE("CobExecutionService")
+    {
+        // static0 = rand(1, 1000000); set ACTIVATION to 1; sleep 100;
+        auto script = createTestScript(
+            {
+                op(OpCode::PUSH_CONSTANT), 1,
+                op(OpCode::PUSH_CONSTANT), 1000000,
+                op(OpCode::RAND),
+                op(OpCode::POP_STATIC), 0,
+                op(OpCode::PUSH_CONSTANT), static_cast<std::uint32_t>(CobValueId::Activation),
+                op(OpCode::PUSH_CONSTANT), 1,
+                op(OpCode::SET_VALUE),
+                op(OpCode::PUSH_CONSTANT), 100,
+                op(OpCode::SLEEP),
+                op(OpCode::PUSH_CONSTANT), 0,
+                op(OpCode::RETURN),
+            },
+            {{"Create", 0}},
+            1);
+
+        SECTION("gives the same results however many threads run the units")
+        {
+            auto fewerThreads = runScripts(script, 100, 1);
+            auto moreThreads = runScripts(script, 100, 3);
+
+            REQUIRE(moreThreads.randomValues == fewerThreads.randomValues);
+            REQUIRE(moreThreads.activatedUnits == fewerThreads.activatedUnits);
+            REQUIRE(moreThreads.instructionCount == fewerThreads.instructionCount);
+            REQUIRE(moreThreads.sleepingThreads == 100);
+        }
+
+        SECTION("returns commands in unit order")
+        {
+            auto result = runScripts(script, 100, 3);
+
+            REQUIRE(result.activatedUnits.size() == 100);
+            REQUIRE(std::is_sorted(result.activatedUnits.begin(), result.activatedUnits.end(), [](const auto& a, const auto& b) { return a.value < b.value; }));
+        }
+
+        SECTION("gives each unit its own random numbers")
+        {
+            auto result = runScripts(script, 100, 3);
+
+            std::sort(result.randomValues.begin(), result.randomValues.end());
+            auto distinctValues = std::unique(result.randomValues.begin(), result.randomValues.end()) - result.randomValues.begin();
+            REQUIRE(distinctValues > 90);
+        }
+
+        SECTION("counts the work done by each function when profiling")
+        {
+            auto sim = createFlatSimulation(4, 4);
+            auto unitId = sim.tryAddUnit(createTestUnit(&script, sim.terrain.heightmapIndexToWorldCenter(1, 1)));
+            REQUIRE(unitId);
+            auto& env = *sim.getUnit(*unitId).cobEnvironment;
+            env.setProfilingEnabled(true);
+            env.createThread(0, {});
+
+            CobExecutionService service;
+            std::minstd_rand rng;
+            CobCommandBuffer buffer;
+            auto instructionCount = service.run(sim, *unitId, rng, buffer);
+
+            REQUIRE(env.profile[0].threadsCreated == 1);
+            REQUIRE(env.profile[0].runs == 1);
+            REQUIRE(env.profile[0].instructions == instructionCount);
+            REQUIRE(env.profile[0].blockedPolls == 0);
+
+            // the sleeping thread is checked again once its timer is due
+            REQUIRE(buffer.sleepTimers.size() == 1);
+            sim.cobSleepTimers.schedule(*unitId, buffer.sleepTimers[0].second);
+            sim.gameTime = buffer.sleepTimers[0].second;
+            service.wakeSleepingThreads(sim);
+            service.run(sim, *unitId, rng, buffer);
+            REQUIRE(env.profile[0].blockedPolls == 1);
+            REQUIRE(env.profile[0].runs == 2);
+        }
+    }
+}
@@ -0,0 +1,116 @@
+#include <catch2/catch.hpp>
+#include <rwe/cob/CobInstruction.h>
+#include <rwe/cob/CobOpCode.h>
+
+namespace rwe
+{
+    static std::uint32_t op(OpCode code)
+    {
+        return static_cast<std::uint32_t>(code);
+    }
+
+    TEST_CASE("decodeCobInstructions")
+    {
+        SECTION("decodes an entry for every address plus one past the end")
+        {
+            std::vector<std::uint32_t> code{op(OpCode::PUSH_CONSTANT), 5, op(OpCode::RETURN)};
+            auto decoded = decodeCobInstructions(code);
+            REQUIRE(decoded.size() == 4);
+
+            REQUIRE(decoded[0].op == CobOp::PushConstant);
+            REQUIRE(decoded[0].a == 5);
+            REQUIRE(decoded[0].next == 2);
+            REQUIRE(decoded[0].sourceInstructionCount == 1);
+
+            REQUIRE(decoded[2].op == CobOp::Return);
+            REQUIRE(decoded[2].next == 3);
+
+            REQUIRE(decoded[3].op == CobOp::EndOfCode);
+        }
+
+        SECTION("reads piece operands")
+        {
+            std::vector<std::uint32_t> code{op(OpCode::MOVE), 3, 1, op(OpCode::TURN), 3, 7};
+            auto decoded = decodeCobInstructions(code);
+
+            REQUIRE(decoded[0].op == CobOp::Move);
+            REQUIRE(decoded[0].a == 3);
+            REQUIRE(decoded[0].b == 1);
+            REQUIRE(decoded[0].next == 3);
+
+            REQUIRE(decoded[3].op == CobOp::InvalidAxis);
+            REQUIRE(decoded[3].a == 7);
+        }
+
+        SECTION("marks instructions whose operands run off the end")
+        {
+            std::vector<std::uint32_t> code{op(OpCode::CALL_SCRIPT), 1};
+            auto decoded = decodeCobInstructions(code);
+            REQUIRE(decoded[0].op == CobOp::EndOfCode);
+        }
+
+        SECTION("marks unknown opcodes")
+        {
+            std::vector<std::uint32_t> code{0x12345678};
+            auto decoded = decodeCobInstructions(code);
+            REQUIRE(decoded[0].op == CobOp::Unsupported);
+            REQUIRE(decoded[0].a == 0x12345678);
+        }
+
+        SECTION("redirects jumps outside the code to the end")
+        {
+            std::vector<std::uint32_t> code{op(OpCode::JUMP), 100, op(OpCode::JUMP), 0};
+            auto decoded = decodeCobInstructions(code);
+            REQUIRE(decoded[0].op == CobOp::Jump);
+            REQUIRE(decoded[0].a == 4);
+            REQUIRE(decoded[2].a == 0);
+        }
+
+        SECTION("fuses a constant comparison followed by a conditional jump")
+        {
+            std::vector<std::uint32_t> code{
+                op(OpCode::PUSH_CONSTANT),
+                10,
+                op(OpCode::SET_LESS),
+                op(OpCode::JUMP_IF_ZERO),
+                0,
+                op(OpCode::RETURN)};
+            auto decoded = decodeCobInstructions(code);
+
+            REQUIRE(decoded[0].op == CobOp::JumpUnlessLessConstant);
+            REQUIRE(decoded[0].a == 10);
+            REQUIRE(decoded[0].b == 0);
+            REQUIRE(decoded[0].next == 5);
+            REQUIRE(decoded[0].sourceInstructionCount == 3);
+
+            // a jump straight to the comparison still works
+            REQUIRE(decoded[2].op == CobOp::JumpUnlessLess);
+            REQUIRE(decoded[2].a == 0);
+            REQUIRE(decoded[2].next == 5);
+            REQUIRE(decoded[2].sourceInstructionCount == 2);
+
+            REQUIRE(decoded[3].op == CobOp::JumpIfZero);
+        }
+
+        SECTION("turns a conditional jump on a constant into a plain jump")
+        {
+            std::vector<std::uint32_t> code{
+                op(OpCode::PUSH_CONSTANT),
+                1,
+                op(OpCode::JUMP_IF_ZERO),
+                7,
+                op(OpCode::PUSH_CONSTANT),
+                0,
+                op(OpCode::JUMP_IF_ZERO),
+                0};
+            auto decoded = decodeCobInstructions(code);
+
+            REQUIRE(decoded[0].op == CobOp::Jump);
+            REQUIRE(decoded[0].a == 4);
+            REQUIRE(decoded[0].sourceInstructionCount == 2);
+
+            REQUIRE(decoded[4].op == CobOp::Jump);
+            REQUIRE(decoded[4].a == 0);
+        }
+    }
+}
@@ -0,0 +1,118 @@
+#include <catch2/catch.hpp>
+#include <rwe/cob/CobEnvironment.h>
+#include <rwe/cob/CobProfiler.h>
+#include <sstream>
+
+namespace rwe
+{
+    TEST_CASE("CobProfiler")
+    {
+        CobScript script;
+        script.functions = {{"Create", 0}, {"Activate", 0}, {"Killed", 0}};
+
+        SECTION("does nothing for environments that are not profiled")
+        {
+            CobEnvironment env(&script);
+            CobProfiler profiler;
+            profiler.collect("ARMCOM", env);
+            REQUIRE(profiler.getEntries().empty());
+        }
+
+        SECTION("totals each function across units of the same type")
+        {
+            CobEnvironment env1(&script);
+            env1.setProfilingEnabled(true);
+            CobEnvironment env2(&script);
+            env2.setProfilingEnabled(true);
+
+            env1.profile[1].runs = 2;
+            env1.profile[1].instructions = 100;
+            env1.profile[1].time = std::chrono::nanoseconds(50);
+            env2.profile[1].runs = 3;
+            env2.profile[1].instructions = 20;
+            env2.profile[1].signalsSent = 1;
+            env2.profile[1].time = std::chrono::nanoseconds(10);
+
+            CobProfiler profiler;
+            profiler.collect("ARMCOM", env1);
+            profiler.collect("ARMCOM", env2);
+
+            auto entries = profiler.getEntries();
+            REQUIRE(entries.size() == 1);
+            REQUIRE(entries[0].unitType == "ARMCOM");
+            REQUIRE(entries[0].functionName == "Activate");
+            REQUIRE(entries[0].profile.runs == 5);
+            REQUIRE(entries[0].profile.instructions == 120);
+            REQUIRE(entries[0].profile.signalsSent == 1);
+            REQUIRE(entries[0].profile.time == std::chrono::nanoseconds(60));
+
+            SECTION("and zeroes the environment's counters")
+            {
+                REQUIRE(env1.profile[1].runs == 0);
+                REQUIRE(env2.profile[1].instructions == 0);
+
+                profiler.collect("ARMCOM", env1);
+                REQUIRE(profiler.getEntries()[0].profile.runs == 5);
+            }
+        }
+
+        SECTION("counts threads created while profiling")
+        {
+            CobEnvironment env(&script);
+            env.setProfilingEnabled(true);
+            env.createThread(2, {});
+            env.createThread(2, {});
+
+            REQUIRE(env.profile[2].threadsCreated == 2);
+            REQUIRE(env.profile[0].threadsCreated == 0);
+        }
+
+        SECTION("orders entries by time, then by name")
+        {
+            CobEnvironment env1(&script);
+            env1.setProfilingEnabled(true);
+            env1.profile[0].runs = 1;
+            env1.profile[0].time = std::chrono::nanoseconds(10);
+            env1.profile[2].runs = 1;
+            env1.profile[2].time = std::chrono::nanoseconds(30);
+
+            CobEnvironment env2(&script);
+            env2.setProfilingEnabled(true);
+            env2.profile[0].runs = 1;
+            env2.profile[0].time = std::chrono::nanoseconds(10);
+
+            CobProfiler profiler;
+            profiler.collect("CORCOM", env1);
+            profiler.collect("ARMCOM", env2);
+
+            auto entries = profiler.getEntries();
+            REQUIRE(entries.size() == 3);
+            REQUIRE(entries[0].unitType == "CORCOM");
+            REQUIRE(entries[0].functionName == "Killed");
+            REQUIRE(entries[1].unitType == "ARMCOM");
+            REQUIRE(entries[1].functionName == "Create");
+            REQUIRE(entries[2].unitType == "CORCOM");
+            REQUIRE(entries[2].functionName == "Create");
+
+            SECTION("when written as CSV")
+            {
+                std::ostringstream os;
+                writeCobProfileCsv(os, entries);
+                REQUIRE(os.str() == "unitType,function,timeNs,instructions,runs,threadsCreated,blockedPolls,signalsSent\n"
+                                    "CORCOM,Killed,30,0,1,0,0,0\n"
+                                    "ARMCOM,Create,10,0,1,0,0,0\n"
+                                    "CORCOM,Create,10,0,1,0,0,0\n");
+            }
+
+            SECTION("when written as JSON")
+            {
+                auto j = dumpJson(entries);
+                REQUIRE(j.size() == 3);
+                REQUIRE(j[0]["unitType"] == "CORCOM");
+                REQUIRE(j[0]["function"] == "Killed");
+                REQUIRE(j[0]["timeNs"] == 30);
+                REQUIRE(j[0]["runs"] == 1);
+            }
+        }
+    }
+}
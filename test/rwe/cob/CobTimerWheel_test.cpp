@@ -0,0 +1,81 @@
+#include <algorithm>
+#include <catch2/catch.hpp>
+#include <rwe/OpaqueId_io.h>
+#include <rwe/cob/CobTimerWheel.h>
+
+namespace rwe
+{
+    static std::vector<UnitId> advance(CobTimerWheel& wheel, unsigned int time)
+    {
+        std::vector<UnitId> dueUnits;
+        wheel.advance(GameTime(time), dueUnits);
+        std::sort(dueUnits.begin(), dueUnits.end(), [](const auto& a, const auto& b) { return a.value < b.value; });
+        return dueUnits;
+    }
+
+    TEST_CASE("CobTimerWheel")
+    {
+        CobTimerWheel wheel;
+
+        SECTION("hands out units when their time comes")
+        {
+            wheel.schedule(UnitId(1), GameTime(3));
+            wheel.schedule(UnitId(2), GameTime(5));
+
+            REQUIRE(advance(wheel, 2).empty());
+            REQUIRE(advance(wheel, 3) == std::vector<UnitId>{UnitId(1)});
+            REQUIRE(advance(wheel, 4).empty());
+            REQUIRE(advance(wheel, 5) == std::vector<UnitId>{UnitId(2)});
+            REQUIRE(wheel.size() == 0);
+        }
+
+        SECTION("hands out everything passed over in one advance")
+        {
+            wheel.schedule(UnitId(1), GameTime(3));
+            wheel.schedule(UnitId(2), GameTime(5));
+            wheel.schedule(UnitId(3), GameTime(9));
+
+            REQUIRE(advance(wheel, 6) == std::vector<UnitId>{UnitId(1), UnitId(2)});
+            REQUIRE(wheel.size() == 1);
+        }
+
+        SECTION("keeps entries more than a turn away until they are due")
+        {
+            auto farTime = CobTimerWheel::SlotCount + 10;
+            wheel.schedule(UnitId(4), GameTime(farTime));
+
+            REQUIRE(advance(wheel, 10).empty());
+            REQUIRE(advance(wheel, farTime - 1).empty());
+            REQUIRE(advance(wheel, farTime) == std::vector<UnitId>{UnitId(4)});
+        }
+
+        SECTION("handles jumps longer than a turn")
+        {
+            wheel.schedule(UnitId(1), GameTime(20));
+            wheel.schedule(UnitId(2), GameTime(CobTimerWheel::SlotCount * 3));
+
+            REQUIRE(advance(wheel, CobTimerWheel::SlotCount * 2) == std::vector<UnitId>{UnitId(1)});
+            REQUIRE(advance(wheel, CobTimerWheel::SlotCount * 3) == std::vector<UnitId>{UnitId(2)});
+        }
+
+        SECTION("entries already in the past come due on the next advance")
+        {
+            advance(wheel, 10);
+            wheel.schedule(UnitId(1), GameTime(10));
+            wheel.schedule(UnitId(2), GameTime(4));
+
+            REQUIRE(advance(wheel, 10).empty());
+            REQUIRE(advance(wheel, 11) == std::vector<UnitId>{UnitId(1), UnitId(2)});
+        }
+
+        SECTION("reset discards entries")
+        {
+            wheel.schedule(UnitId(1), GameTime(3));
+            wheel.reset(GameTime(100));
+            REQUIRE(wheel.size() == 0);
+
+            wheel.schedule(UnitId(2), GameTime(101));
+            REQUIRE(advance(wheel, 101) == std::vector<UnitId>{UnitId(2)});
+        }
+    }
+}
@@ -0,0 +1,62 @@
+#include <catch2/catch.hpp>
+#include <rwe/pathfinding/FootprintCollisionMap.h>
+
+namespace rwe
+{
+    static void placeObstacle(OccupiedGrid& grid, int x, int y)
+    {
+        grid.set(x, y, OccupiedCell::fromFeature(FeatureId(0)));
+    }
+
+    static void requireMatchesGrid(const FootprintCollisionMap& map, const OccupiedGrid& grid, unsigned int footprintX, unsigned int footprintZ)
+    {
+        for (int y = -1; y <= static_cast<int>(grid.getHeight()); ++y)
+        {
+            for (int x = -1; x <= static_cast<int>(grid.getWidth()); ++x)
+            {
+                DiscreteRect rect(x, y, footprintX, footprintZ);
+                REQUIRE(map.isBlocked(Point(x, y)) == isCollisionAt(grid, rect));
+                if (grid.contains(rect))
+                {
+                    REQUIRE(map.isRough(Point(x, y)) == isAdjacentToObstacle(grid, rect));
+                }
+            }
+        }
+    }
+
+    TEST_CASE("FootprintCollisionMap")
+    {
+        OccupiedGrid grid(12, 10, OccupiedCell());
+        placeObstacle(grid, 3, 3);
+        placeObstacle(grid, 8, 6);
+
+        SECTION("agrees with the occupied grid")
+        {
+            FootprintCollisionMap map(grid, 2, 3);
+            requireMatchesGrid(map, grid, 2, 3);
+        }
+
+        SECTION("treats footprints partly outside the grid as blocked")
+        {
+            FootprintCollisionMap map(grid, 2, 2);
+            REQUIRE(map.isBlocked(Point(11, 0)));
+            REQUIRE(map.isBlocked(Point(-1, 0)));
+            REQUIRE(!map.isBlocked(Point(10, 0)));
+        }
+
+        SECTION("follows changes to the occupied grid")
+        {
+            FootprintCollisionMap map(grid, 3, 2);
+
+            placeObstacle(grid, 6, 2);
+            map.update(grid, DiscreteRect(6, 2, 1, 1));
+            requireMatchesGrid(map, grid, 3, 2);
+
+            grid.set(GridRegion(3, 3, 1, 1), OccupiedCell());
+            grid.set(GridRegion(0, 8, 2, 2), OccupiedCell::fromUnit(UnitId(4)));
+            map.update(grid, DiscreteRect(3, 3, 1, 1));
+            map.update(grid, DiscreteRect(0, 8, 2, 2));
+            requireMatchesGrid(map, grid, 3, 2);
+        }
+    }
+}
@@ -0,0 +1,104 @@
+#include "../simulation_test_util.h"
+#include <catch2/catch.hpp>
+#include <rwe/pathfinding/HierarchicalPathGraph.h>
+
+namespace rwe
+{
+    static void placeObstacle(GameSimulation& sim, int x, int y)
+    {
+        sim.occupiedGrid.set(x, y, OccupiedCell::fromFeature(FeatureId(0)));
+    }
+
+    TEST_CASE("HierarchicalPathGraph")
+    {
+        ensureTestLogger();
+        auto sim = createFlatSimulation(64, 64);
+        Grid<char> walkable(64, 64, true);
+
+        SECTION("returns just the start when the goal is in the same cluster")
+        {
+            HierarchicalPathGraph graph(&sim, &walkable, 1, 1);
+            auto path = graph.findPath(Point(1, 1), std::vector<Point>{Point(10, 12)});
+            REQUIRE(path);
+            REQUIRE(*path == std::vector<Point>{Point(1, 1)});
+        }
+
+        SECTION("plans across clusters")
+        {
+            HierarchicalPathGraph graph(&sim, &walkable, 1, 1);
+            auto path = graph.findPath(Point(1, 1), std::vector<Point>{Point(60, 60)});
+            REQUIRE(path);
+            REQUIRE(path->front() == Point(1, 1));
+            REQUIRE(path->back().x / 16 == 3);
+            REQUIRE(path->back().y / 16 == 3);
+        }
+
+        SECTION("routes around walls through gaps")
+        {
+            for (int y = 0; y < 64; ++y)
+            {
+                if (y != 50)
+                {
+                    placeObstacle(sim, 20, y);
+                }
+            }
+
+            HierarchicalPathGraph graph(&sim, &walkable, 1, 1);
+            auto path = graph.findPath(Point(5, 5), std::vector<Point>{Point(40, 5)});
+            REQUIRE(path);
+            REQUIRE(path->back().x / 16 == 2);
+            REQUIRE(path->back().y / 16 == 0);
+            REQUIRE(std::any_of(path->begin(), path->end(), [](const auto& p) { return p.y >= 48; }));
+
+            SECTION("and notices when the gap is closed")
+            {
+                placeObstacle(sim, 20, 50);
+                graph.invalidate(DiscreteRect(20, 50, 1, 1));
+                REQUIRE(!graph.findPath(Point(5, 5), std::vector<Point>{Point(40, 5)}));
+            }
+
+            SECTION("and leaves copies alone when the gap is closed")
+            {
+                HierarchicalPathGraph copy(graph);
+                placeObstacle(sim, 20, 50);
+                copy.invalidate(DiscreteRect(20, 50, 1, 1));
+                REQUIRE(!copy.findPath(Point(5, 5), std::vector<Point>{Point(40, 5)}));
+                REQUIRE(!copy.isPassable(Point(20, 50)));
+                REQUIRE(graph.isPassable(Point(20, 50)));
+                REQUIRE(graph.findPath(Point(5, 5), std::vector<Point>{Point(40, 5)}));
+            }
+        }
+
+        SECTION("leaves the cluster through the entrance it starts on")
+        {
+            for (int y = 0; y < 64; ++y)
+            {
+                if (y != 5)
+                {
+                    placeObstacle(sim, 16, y);
+                }
+            }
+
+            HierarchicalPathGraph graph(&sim, &walkable, 1, 1);
+            auto path = graph.findPath(Point(15, 5), std::vector<Point>{Point(20, 5)});
+            REQUIRE(path);
+            REQUIRE(*path == std::vector<Point>{Point(15, 5), Point(16, 5)});
+        }
+
+        SECTION("treats cells under the footprint of an obstacle as blocked")
+        {
+            placeObstacle(sim, 10, 10);
+            HierarchicalPathGraph graph(&sim, &walkable, 2, 2);
+            REQUIRE(!graph.isPassable(Point(9, 9)));
+            REQUIRE(!graph.isPassable(Point(10, 10)));
+            REQUIRE(graph.isPassable(Point(11, 11)));
+        }
+
+        SECTION("fails when all goals are blocked")
+        {
+            placeObstacle(sim, 40, 40);
+            HierarchicalPathGraph graph(&sim, &walkable, 1, 1);
+            REQUIRE(!graph.findPath(Point(1, 1), std::vector<Point>{Point(40, 40)}));
+        }
+    }
+}
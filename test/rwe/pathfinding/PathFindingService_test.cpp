@@ -0,0 +1,193 @@
+#include "../simulation_test_util.h"
+#include <catch2/catch.hpp>
+#include <rwe/MovementClassCollisionService.h>
+#include <rwe/OpaqueId_io.h>
+#include <rwe/ThreadPool.h>
+#include <rwe/pathfinding/PathFindingService.h>
+#include <rwe/snapshot/SimulationSnapshot.h>
+#include <rwe/snapshot/snapshot_io.h>
+
+namespace rwe
+{
+    static void tick(GameSimulation& sim, PathFindingService& service)
+    {
+        sim.gameTime += GameTime(1);
+        service.update();
+    }
+
+    TEST_CASE("PathFindingService")
+    {
+        ensureTestLogger();
+        auto script = createTestScript({}, {}, 0);
+        MovementClassCollisionService collisionService;
+        ThreadPool threadPool(2);
+
+        auto sim = createFlatSimulation(32, 32, 1);
+        for (int y = 0; y < 24; ++y)
+        {
+            sim.occupiedGrid.set(16, y, OccupiedCell::fromFeature(FeatureId(0)));
+        }
+
+        auto addedUnitId = sim.tryAddUnit(createTestUnit(&script, SimVector(-200_ss, 0_ss, -200_ss)));
+        REQUIRE(addedUnitId);
+        auto unitId = *addedUnitId;
+
+        SimVector destination(200_ss, 0_ss, -200_ss);
+        auto requestPath = [&]() {
+            sim.getUnit(unitId).behaviourState = MovingState{destination, std::nullopt, true};
+            sim.requestPath(unitId);
+        };
+
+        auto getPath = [&]() -> std::optional<std::vector<SimVector>> {
+            const auto& movingState = std::get<MovingState>(sim.getUnit(unitId).behaviourState);
+            if (!movingState.path)
+            {
+                return std::nullopt;
+            }
+            return movingState.path->path.waypoints;
+        };
+
+        SECTION("delivers paths a fixed number of ticks after the request")
+        {
+            PathFindingService service(&sim, &collisionService, &threadPool);
+            requestPath();
+            tick(sim, service);
+            for (unsigned int i = 0; i < PathFindingService::PathLatencyTicks; ++i)
+            {
+                REQUIRE(!getPath());
+                tick(sim, service);
+            }
+
+            REQUIRE(getPath());
+            REQUIRE(!std::get<MovingState>(sim.getUnit(unitId).behaviourState).pathRequested);
+        }
+
+        SECTION("gets as close as it can when a unit blocks the way round")
+        {
+            sim.getUnit(unitId).movementClass = collisionService.registerMovementClass("TANKSH2", Grid<char>(32, 32, true));
+            for (int y = 24; y < 32; ++y)
+            {
+                sim.occupiedGrid.set(16, y, OccupiedCell::fromUnit(UnitId(unitId.value + 1)));
+            }
+
+            PathFindingService service(&sim, &collisionService, &threadPool);
+            requestPath();
+            for (unsigned int i = 0; i <= PathFindingService::PathLatencyTicks; ++i)
+            {
+                tick(sim, service);
+            }
+
+            // The path should run up to the wall level with the goal,
+            // not up to the gap and then straight through the wall.
+            auto path = getPath();
+            REQUIRE(path);
+            REQUIRE(path->size() >= 2);
+            const auto& closest = (*path)[path->size() - 2];
+            REQUIRE(closest.x < 0_ss);
+            REQUIRE(closest.z < -150_ss);
+            REQUIRE(path->back() == destination);
+        }
+
+        SECTION("restores searches in flight from a snapshot")
+        {
+            auto blocker = createTestUnit(&script, SimVector(200_ss, 0_ss, 200_ss));
+            blocker.footprintX = 4;
+            blocker.footprintZ = 4;
+            auto blockerId = sim.tryAddUnit(std::move(blocker));
+            REQUIRE(blockerId);
+
+            PathFindingService service(&sim, &collisionService, &threadPool);
+            requestPath();
+            tick(sim, service);
+            REQUIRE(sim.pathRequests.empty());
+
+            // Another unit moves into the gap in the wall while the search is running.
+            // The search has already taken its copy of the grid, so does not see it.
+            auto& blockerUnit = sim.getUnit(*blockerId);
+            auto oldRect = sim.computeFootprintRegion(blockerUnit.position, 4, 4);
+            blockerUnit.position = SimVector(8_ss, 0_ss, 160_ss);
+            sim.moveUnitOccupiedArea(oldRect, sim.computeFootprintRegion(blockerUnit.position, 4, 4), *blockerId);
+
+            auto snapshot = captureSnapshot(sim);
+            snapshot.pendingPaths = service.capturePendingPaths();
+            auto restoredSnapshot = deserializeSnapshot(serializeSnapshot(snapshot));
+            REQUIRE(restoredSnapshot.pendingPaths.size() == 1);
+
+            for (unsigned int i = 0; i < PathFindingService::PathLatencyTicks; ++i)
+            {
+                tick(sim, service);
+            }
+            auto originalPath = getPath();
+            REQUIRE(originalPath);
+            REQUIRE(originalPath->size() > 1);
+
+            // A search started now, with the other unit in the way, finds a different path.
+            requestPath();
+            for (unsigned int i = 0; i <= PathFindingService::PathLatencyTicks; ++i)
+            {
+                tick(sim, service);
+            }
+            REQUIRE(getPath());
+            REQUIRE(getPath() != originalPath);
+
+            // Rewind the unit to how it was when the snapshot was taken.
+            // The request is no longer queued, so only the restored search can answer it.
+            sim.gameTime = restoredSnapshot.gameTime;
+            sim.getUnit(unitId).behaviourState = MovingState{destination, std::nullopt, true};
+
+            PathFindingService restoredService(&sim, &collisionService, &threadPool);
+            restoredService.restorePendingPaths(restoredSnapshot.pendingPaths);
+            REQUIRE(restoredService.capturePendingPaths().size() == 1);
+
+            for (unsigned int i = 0; i < PathFindingService::PathLatencyTicks - 1; ++i)
+            {
+                tick(sim, restoredService);
+                REQUIRE(!getPath());
+            }
+
+            tick(sim, restoredService);
+            REQUIRE(getPath() == originalPath);
+            REQUIRE(!std::get<MovingState>(sim.getUnit(unitId).behaviourState).pathRequested);
+        }
+
+        SECTION("restored searches keep their request order and due tick")
+        {
+            auto otherUnitId = sim.tryAddUnit(createTestUnit(&script, SimVector(-200_ss, 0_ss, 200_ss)));
+            REQUIRE(otherUnitId);
+
+            PathFindingService service(&sim, &collisionService, &threadPool);
+            requestPath();
+            sim.getUnit(*otherUnitId).behaviourState = MovingState{destination, std::nullopt, true};
+            sim.requestPath(*otherUnitId);
+            tick(sim, service);
+
+            auto snapshot = captureSnapshot(sim);
+            snapshot.pendingPaths = service.capturePendingPaths();
+            auto restoredSnapshot = deserializeSnapshot(serializeSnapshot(snapshot));
+            REQUIRE(restoredSnapshot.pendingPaths.size() == 2);
+            REQUIRE(restoredSnapshot.pendingPaths[0].unitId == unitId);
+            REQUIRE(restoredSnapshot.pendingPaths[1].unitId == *otherUnitId);
+
+            auto runToDelivery = [&](PathFindingService& s) {
+                for (unsigned int i = 0; i < PathFindingService::PathLatencyTicks - 1; ++i)
+                {
+                    tick(sim, s);
+                }
+                sim.changedUnits.clear();
+                tick(sim, s);
+                return sim.changedUnits;
+            };
+
+            auto originalDeliveries = runToDelivery(service);
+            REQUIRE(originalDeliveries == std::vector<UnitId>{unitId, *otherUnitId});
+
+            sim.gameTime = restoredSnapshot.gameTime;
+            sim.getUnit(unitId).behaviourState = MovingState{destination, std::nullopt, true};
+            sim.getUnit(*otherUnitId).behaviourState = MovingState{destination, std::nullopt, true};
+
+            PathFindingService restoredService(&sim, &collisionService, &threadPool);
+            restoredService.restorePendingPaths(restoredSnapshot.pendingPaths);
+            REQUIRE(runToDelivery(restoredService) == originalDeliveries);
+        }
+    }
+}
@@ -0,0 +1,103 @@
+#include <catch2/catch.hpp>
+#include <rwe/OccupiedGrid.h>
+#include <rwe/pathfinding/FootprintCollisionMap.h>
+#include <rwe/pathfinding/UnitPathFinder.h>
+#include <spdlog/sinks/null_sink.h>
+#include <spdlog/spdlog.h>
+
+namespace rwe
+{
+    static void ensureLogger()
+    {
+        if (!spdlog::get("rwe"))
+        {
+            spdlog::create<spdlog::sinks::null_sink_mt>("rwe");
+        }
+    }
+
+    static void placeObstacle(OccupiedGrid& grid, int x, int y)
+    {
+        grid.set(x, y, OccupiedCell::fromFeature(FeatureId(0)));
+    }
+
+    TEST_CASE("UnitPathFinder")
+    {
+        ensureLogger();
+        OccupiedGrid grid(16, 16, OccupiedCell());
+
+        SECTION("finds a straight path")
+        {
+            UnitPathFinder finder(&grid, nullptr, nullptr, UnitId(0), DiscreteRect(0, 0, 0, 0), 1, 1, Point(5, 1));
+            auto result = finder.findPath(Point(1, 1));
+            REQUIRE(result.type == AStarPathType::Complete);
+            REQUIRE(result.path == std::vector<Point>{Point(1, 1), Point(2, 1), Point(3, 1), Point(4, 1), Point(5, 1)});
+        }
+
+        SECTION("routes around obstacles")
+        {
+            for (int y = 0; y < 15; ++y)
+            {
+                placeObstacle(grid, 8, y);
+            }
+
+            UnitPathFinder finder(&grid, nullptr, nullptr, UnitId(0), DiscreteRect(0, 0, 0, 0), 1, 1, Point(12, 2));
+            auto result = finder.findPath(Point(2, 2));
+            REQUIRE(result.type == AStarPathType::Complete);
+            REQUIRE(result.path.front() == Point(2, 2));
+            REQUIRE(result.path.back() == Point(12, 2));
+            REQUIRE(std::any_of(result.path.begin(), result.path.end(), [](const auto& p) { return p == Point(8, 15); }));
+        }
+
+        SECTION("returns a partial path towards an unreachable goal")
+        {
+            for (int y = 0; y < 16; ++y)
+            {
+                placeObstacle(grid, 8, y);
+            }
+
+            UnitPathFinder finder(&grid, nullptr, nullptr, UnitId(0), DiscreteRect(0, 0, 0, 0), 1, 1, Point(12, 2));
+            auto result = finder.findPath(Point(2, 2));
+            REQUIRE(result.type == AStarPathType::Partial);
+            REQUIRE(result.path.back() == Point(7, 2));
+        }
+
+        SECTION("gives the same result when searches are repeated")
+        {
+            placeObstacle(grid, 4, 4);
+            placeObstacle(grid, 5, 5);
+
+            UnitPathFinder finder(&grid, nullptr, nullptr, UnitId(0), DiscreteRect(0, 0, 0, 0), 2, 2, Point(10, 10));
+            auto first = finder.findPath(Point(0, 0));
+
+            UnitPathFinder other(&grid, nullptr, nullptr, UnitId(0), DiscreteRect(0, 0, 0, 0), 1, 1, Point(0, 15));
+            other.findPath(Point(15, 0));
+
+            auto second = finder.findPath(Point(0, 0));
+            REQUIRE(first.path == second.path);
+            REQUIRE(first.closedVertices.size() == second.closedVertices.size());
+        }
+
+        SECTION("gives the same result with a collision map")
+        {
+            for (int y = 2; y < 16; ++y)
+            {
+                placeObstacle(grid, 6, y);
+            }
+            placeObstacle(grid, 10, 3);
+
+            // The unit itself stands at the start
+            DiscreteRect selfArea(1, 1, 2, 2);
+            grid.set(GridRegion(1, 1, 2, 2), OccupiedCell::fromUnit(UnitId(1)));
+
+            FootprintCollisionMap collisionMap(grid, 2, 2);
+
+            UnitPathFinder withoutMap(&grid, nullptr, nullptr, UnitId(1), selfArea, 2, 2, Point(12, 12));
+            UnitPathFinder withMap(&grid, &collisionMap, nullptr, UnitId(1), selfArea, 2, 2, Point(12, 12));
+
+            auto expected = withoutMap.findPath(Point(1, 1));
+            auto actual = withMap.findPath(Point(1, 1));
+            REQUIRE(expected.type == AStarPathType::Complete);
+            REQUIRE(actual.path == expected.path);
+        }
+    }
+}
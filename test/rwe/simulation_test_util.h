@@ -0,0 +1,75 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <rwe/Cob.h>
+#include <rwe/GameSimulation.h>
+#include <spdlog/sinks/null_sink.h>
+#include <spdlog/spdlog.h>
+#include <vector>
+
+namespace rwe
+{
+    /** Registers a "rwe" logger that discards everything, for code that logs as it runs. */
+    inline void ensureTestLogger()
+    {
+        if (!spdlog::get("rwe"))
+        {
+            spdlog::create<spdlog::sinks::null_sink_mt>("rwe");
+        }
+    }
+
+    /** Creates a script from raw instructions, decoded and with entry points resolved as parseCob does. */
+    inline CobScript createTestScript(std::vector<std::uint32_t>&& instructions, std::vector<CobFunctionInfo>&& functions, unsigned int staticVariableCount)
+    {
+        CobScript script;
+        script.instructions = std::move(instructions);
+        script.functions = std::move(functions);
+        script.staticVariableCount = staticVariableCount;
+        script.decodedInstructions = decodeCobInstructions(script.instructions);
+        script.entryPoints = resolveCobEntryPoints(script.functions);
+        return script;
+    }
+
+    /**
+     * Creates a simulation on a flat map that is the given number of heightmap cells across,
+     * with the given number of computer players.
+     */
+    inline GameSimulation createFlatSimulation(std::size_t width, std::size_t height, unsigned int playerCount = 0)
+    {
+        MapTerrain terrain(
+            std::vector<TextureRegion>(),
+            Grid<std::size_t>(width / 2, height / 2, 0),
+            Grid<unsigned char>(width + 1, height + 1, 0),
+            0_ss);
+        GameSimulation sim(std::move(terrain), 0);
+        for (unsigned int i = 0; i < playerCount; ++i)
+        {
+            sim.addPlayer(GamePlayerInfo{std::nullopt, GamePlayerType::Computer, PlayerColorIndex(i), GamePlayerStatus::Alive, "ARM", Metal(1000), Metal(1000), Energy(1000), Energy(1000)});
+        }
+        return sim;
+    }
+
+    /** Creates a mesh with a single piece called "base". */
+    inline UnitMesh createTestMesh()
+    {
+        UnitMesh mesh;
+        mesh.pieces.emplace_back().name = "base";
+        return mesh;
+    }
+
+    /** Creates a mobile 1x1 unit owned by the first player. */
+    inline Unit createTestUnit(const CobScript* script, const SimVector& position, const UnitMesh& mesh = createTestMesh())
+    {
+        Unit unit(mesh, std::make_unique<CobEnvironment>(script), std::make_shared<SelectionMesh>(SelectionMesh{CollisionMesh(), GlMesh(VaoHandle(), VboHandle(), 0)}));
+        unit.unitType = "ARMCOM";
+        unit.owner = PlayerId(0);
+        unit.position = position;
+        unit.turnRate = 0_ss;
+        unit.footprintX = 1;
+        unit.footprintZ = 1;
+        unit.buildTime = 1;
+        unit.isMobile = true;
+        return unit;
+    }
+}
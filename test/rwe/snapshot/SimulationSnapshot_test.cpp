@@ -0,0 +1,64 @@
+#include "../simulation_test_util.h"
+#include <catch2/catch.hpp>
+#include <rwe/MeshService.h>
+#include <rwe/UnitFactory.h>
+#include <rwe/snapshot/SimulationSnapshot.h>
+#include <rwe/snapshot/snapshot_io.h>
+
+namespace rwe
+{
+    TEST_CASE("restoreSnapshot")
+    {
+        auto script = createTestScript({}, {}, 0);
+
+        // Units and projectiles are recreated from their definitions,
+        // so the factory is never asked for anything in a game without them.
+        MeshService meshService(nullptr, nullptr, nullptr, SharedTextureHandle(), {}, {}, {});
+        UnitFactory unitFactory(nullptr, UnitDatabase(), std::move(meshService), nullptr, nullptr, nullptr);
+
+        auto sim = createFlatSimulation(16, 16, 2);
+        sim.rng.discard(7);
+        sim.gameTime = GameTime(123);
+        sim.getPlayer(PlayerId(1)).metal = Metal(250);
+        sim.getPlayer(PlayerId(1)).status = GamePlayerStatus::Dead;
+        sim.occupiedGrid.set(3, 4, OccupiedCell::fromFeature(FeatureId(2)));
+
+        // Leave a freed slot behind so the slot layout has to be restored too.
+        auto occupiedGrid = sim.occupiedGrid;
+        auto removedUnitId = *sim.tryAddUnit(createTestUnit(&script, SimVector(8_ss, 0_ss, 8_ss)));
+        sim.units.remove(removedUnitId);
+        sim.occupiedGrid = occupiedGrid;
+
+        auto bytes = serializeSnapshot(captureSnapshot(sim));
+
+        auto restored = createFlatSimulation(16, 16, 2);
+        restored.tryAddUnit(createTestUnit(&script, SimVector(40_ss, 0_ss, 40_ss)));
+        restoreSnapshot(deserializeSnapshot(bytes), restored, unitFactory);
+
+        SECTION("reproduces the captured state exactly")
+        {
+            REQUIRE(serializeSnapshot(captureSnapshot(restored)) == bytes);
+        }
+
+        SECTION("reproduces the game hash")
+        {
+            REQUIRE(restored.computeHash() == sim.computeHash());
+        }
+
+        SECTION("discards units that were not in the snapshot")
+        {
+            REQUIRE(restored.units.begin() == restored.units.end());
+        }
+
+        SECTION("continues the random number sequence")
+        {
+            REQUIRE(restored.rng() == sim.rng());
+        }
+
+        SECTION("rejects snapshots from a different map")
+        {
+            auto other = createFlatSimulation(8, 8, 2);
+            REQUIRE_THROWS(restoreSnapshot(deserializeSnapshot(bytes), other, unitFactory));
+        }
+    }
+}
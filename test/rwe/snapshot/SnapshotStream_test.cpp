@@ -0,0 +1,138 @@
+#include <catch2/catch.hpp>
+#include <random>
+#include <rwe/OpaqueId_io.h>
+#include <rwe/snapshot/SnapshotStream.h>
+#include <rwe/snapshot/snapshot_io.h>
+#include <sstream>
+
+namespace rwe
+{
+    static std::vector<char> createSnapshot(unsigned int time, const std::string& rngState, std::vector<UnitId> pathRequests)
+    {
+        SimulationSnapshot snapshot;
+        snapshot.gameTime = GameTime(time);
+        snapshot.rngState = rngState;
+        snapshot.occupiedGrid = Grid<OccupiedCell>(4, 4);
+        snapshot.occupiedGrid.set(time % 4, 0, OccupiedCell::fromFeature(FeatureId(time)));
+        snapshot.pathRequests = std::move(pathRequests);
+        return serializeSnapshot(snapshot);
+    }
+
+    static std::size_t writeAndMeasure(std::stringstream& stream, SnapshotStreamWriter& writer, GameTime gameTime, const std::vector<char>& snapshot)
+    {
+        auto before = stream.tellp();
+        writer.write(gameTime, snapshot);
+        return static_cast<std::size_t>(stream.tellp() - before);
+    }
+
+    TEST_CASE("SnapshotStream")
+    {
+        std::vector<std::vector<char>> snapshots{
+            createSnapshot(0, "1 2 3", {}),
+            createSnapshot(1, "1 2 4", {UnitId(1)}),
+            createSnapshot(2, "1 2 3 4", {UnitId(1), UnitId(2)}),
+            createSnapshot(3, "", {}),
+            createSnapshot(4, "", {UnitId(7)}),
+            createSnapshot(5, "1 2 3", {})};
+
+        SECTION("round trips keyframes and deltas")
+        {
+            std::stringstream stream;
+            SnapshotStreamWriter writer(&stream, 3);
+            for (std::size_t i = 0; i < snapshots.size(); ++i)
+            {
+                writer.write(GameTime(i * 10), snapshots[i]);
+            }
+
+            SnapshotStreamReader reader(&stream);
+            for (std::size_t i = 0; i < snapshots.size(); ++i)
+            {
+                auto record = reader.read();
+                REQUIRE(record);
+                REQUIRE(record->first == GameTime(i * 10));
+                REQUIRE(record->second == snapshots[i]);
+            }
+            REQUIRE(!reader.read());
+        }
+
+        SECTION("keeps deltas small when a section changes size")
+        {
+            // Fill the grid and the last section with noise
+            // that only a delta against the previous snapshot can compress.
+            std::mt19937 rng;
+            SimulationSnapshot snapshot;
+            snapshot.occupiedGrid = Grid<OccupiedCell>(64, 64);
+            snapshot.occupiedGrid.forEachIndexed([&](const auto&, auto& cell) { cell = OccupiedCell::fromFeature(FeatureId(rng() % OccupiedCell::MaxIdValue)); });
+            for (int i = 0; i < 4096; ++i)
+            {
+                snapshot.unitCreationRequests.push_back(UnitId(rng()));
+            }
+            auto first = serializeSnapshot(snapshot);
+
+            snapshot.gameTime = GameTime(1);
+            snapshot.rngState = "a longer random number generator state";
+            snapshot.pathRequests.push_back(UnitId(3));
+            auto second = serializeSnapshot(snapshot);
+
+            std::stringstream stream;
+            SnapshotStreamWriter writer(&stream, 2);
+            auto keyframeSize = writeAndMeasure(stream, writer, GameTime(0), first);
+            auto deltaSize = writeAndMeasure(stream, writer, GameTime(1), second);
+            REQUIRE(deltaSize * 20 < keyframeSize);
+
+            SnapshotStreamReader reader(&stream);
+            REQUIRE(reader.read()->second == first);
+            REQUIRE(reader.read()->second == second);
+        }
+
+        SECTION("keeps deltas small when one unit's record changes size")
+        {
+            std::mt19937 rng;
+            SimulationSnapshot snapshot;
+            for (unsigned int i = 0; i < 256; ++i)
+            {
+                auto& unit = snapshot.units.emplace_back();
+                unit.id = UnitId(i * 2);
+                for (int j = 0; j < 16; ++j)
+                {
+                    unit.buildQueue.emplace_back("ARMPW", static_cast<int>(rng()));
+                }
+            }
+            auto first = serializeSnapshot(snapshot);
+
+            snapshot.units[3].buildQueue.emplace_back("ARMSOLAR", 1);
+            snapshot.units.erase(snapshot.units.begin() + 10);
+            auto& newUnit = snapshot.units.emplace_back();
+            newUnit.id = UnitId(1001);
+            auto second = serializeSnapshot(snapshot);
+
+            std::stringstream stream;
+            SnapshotStreamWriter writer(&stream, 2);
+            auto keyframeSize = writeAndMeasure(stream, writer, GameTime(0), first);
+            auto deltaSize = writeAndMeasure(stream, writer, GameTime(1), second);
+            REQUIRE(deltaSize * 10 < keyframeSize);
+
+            SnapshotStreamReader reader(&stream);
+            REQUIRE(reader.read()->second == first);
+            REQUIRE(reader.read()->second == second);
+        }
+
+        SECTION("rejects streams without a header")
+        {
+            std::stringstream stream("nonsense");
+            REQUIRE_THROWS_AS(SnapshotStreamReader(&stream), SnapshotException);
+        }
+
+        SECTION("rejects truncated records")
+        {
+            std::stringstream stream;
+            SnapshotStreamWriter writer(&stream, 1);
+            writer.write(GameTime(0), snapshots[0]);
+
+            auto data = stream.str();
+            std::stringstream truncated(data.substr(0, data.size() - 1));
+            SnapshotStreamReader reader(&truncated);
+            REQUIRE_THROWS_AS(reader.read(), SnapshotException);
+        }
+    }
+}
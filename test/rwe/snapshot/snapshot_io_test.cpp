@@ -0,0 +1,105 @@
+#include "../simulation_test_util.h"
+#include <catch2/catch.hpp>
+#include <rwe/OpaqueId_io.h>
+#include <rwe/snapshot/SimulationSnapshot.h>
+#include <rwe/snapshot/snapshot_io.h>
+
+namespace rwe
+{
+    TEST_CASE("snapshot serialization")
+    {
+        auto script = createTestScript({}, {{"Walk", 10}}, 2);
+        auto mesh = createTestMesh();
+        auto& turret = mesh.pieces.emplace_back();
+        turret.name = "turret";
+        turret.parent = 0;
+
+        auto sim = createFlatSimulation(16, 16);
+        sim.rng.discard(3);
+        sim.gameTime = GameTime(42);
+
+        auto unitId = *sim.tryAddUnit(createTestUnit(&script, SimVector(32_ss, 0_ss, 48_ss), mesh));
+        auto& unit = sim.getUnit(unitId);
+        unit.hitPoints = 17;
+        unit.addOrder(createMoveOrder(SimVector(1_ss, 2_ss, 3_ss)));
+        unit.addOrder(BuildOrder("ARMSOLAR", SimVector(4_ss, 5_ss, 6_ss)));
+        unit.behaviourState = MovingState{SimVector(1_ss, 2_ss, 3_ss), std::nullopt, true};
+        unit.buildQueue.emplace_back("ARMPW", 3);
+        unit.mesh.pieces[1].rotationY = SimAngle(100);
+        unit.mesh.setTurnOperation(1, Axis::Y, UnitMesh::SpinOperation(1_ss, 2_ss, 3_ss));
+
+        auto& env = *unit.cobEnvironment;
+        env.setStatic(1, 99);
+        auto& thread = env.acquireThread(0, 4);
+        thread.stack.push(5);
+        thread.stack.push(6);
+        thread.pushFrame(10, {1, 2});
+        thread.blockedCondition = CobEnvironment::BlockedStatus::Sleep(GameTime(50));
+        env.blockedQueue.push_back(&thread);
+
+        auto snapshot = captureSnapshot(sim);
+        auto bytes = serializeSnapshot(snapshot);
+
+        SECTION("round trips through the binary format")
+        {
+            auto decoded = deserializeSnapshot(bytes);
+            REQUIRE(serializeSnapshot(decoded) == bytes);
+
+            REQUIRE(decoded.gameTime == GameTime(42));
+            REQUIRE(decoded.rngState == snapshot.rngState);
+            REQUIRE(decoded.units.size() == 1);
+
+            const auto& u = decoded.units[0];
+            REQUIRE(u.id == unitId);
+            REQUIRE(u.unitType == "ARMCOM");
+            REQUIRE(u.hitPoints == 17);
+            REQUIRE(u.orders.size() == 2);
+            REQUIRE(std::get<BuildOrder>(u.orders[1]).unitType == "ARMSOLAR");
+            REQUIRE(std::get<MovingStateSnapshot>(u.behaviourState).pathRequested);
+            REQUIRE(u.buildQueue == std::vector<std::pair<std::string, int>>{{"ARMPW", 3}});
+
+            REQUIRE(u.pieces.size() == 2);
+            REQUIRE(u.pieces[1].rotationY == SimAngle(100));
+            REQUIRE(std::get<UnitMesh::SpinOperation>(*u.pieces[1].yTurnOperation).acceleration == 3_ss);
+
+            REQUIRE(u.cobEnvironment.statics == std::vector<int>{0, 99});
+            REQUIRE(u.cobEnvironment.threads.size() == 1);
+            REQUIRE(u.cobEnvironment.threads[0].functionId == 0);
+            REQUIRE(u.cobEnvironment.threads[0].stack == std::vector<int>{5, 6});
+            REQUIRE(u.cobEnvironment.threads[0].callStack[0].instructionIndex == 10);
+            REQUIRE(u.cobEnvironment.threads[0].callStack[0].locals == std::vector<int>{1, 2});
+            REQUIRE(u.cobEnvironment.blockedQueue.size() == 1);
+            REQUIRE(u.cobEnvironment.blockedQueue[0].thread == 0);
+
+            auto footprint = sim.computeFootprintRegion(SimVector(32_ss, 0_ss, 48_ss), 1, 1);
+            REQUIRE(decoded.occupiedGrid.get(footprint.x, footprint.y).getUnit() == unitId);
+        }
+
+        SECTION("rejects other format versions")
+        {
+            bytes[0] ^= 0x7f;
+            REQUIRE_THROWS_AS(deserializeSnapshot(bytes), SnapshotException);
+        }
+
+        SECTION("rejects truncated data")
+        {
+            bytes.resize(bytes.size() - 1);
+            REQUIRE_THROWS_AS(deserializeSnapshot(bytes), SnapshotException);
+        }
+
+        SECTION("rejects trailing data")
+        {
+            bytes.push_back(0);
+            REQUIRE_THROWS_AS(deserializeSnapshot(bytes), SnapshotException);
+        }
+
+        SECTION("can be dumped to json")
+        {
+            auto j = dumpJson(snapshot);
+            REQUIRE(j["gameTime"] == 42);
+            REQUIRE(j["units"][0]["unitType"] == "ARMCOM");
+            REQUIRE(j["units"][0]["cobEnvironment"]["threads"][0]["functionId"] == 0);
+            REQUIRE(j["occupiedGrid"]["cells"].size() == 1);
+        }
+    }
+}
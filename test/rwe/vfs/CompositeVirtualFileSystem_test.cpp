@@ -0,0 +1,225 @@
+#include <boost/filesystem.hpp>
+#include <catch2/catch.hpp>
+#include <fstream>
+#include <map>
+#include <rwe/vfs/CompositeVirtualFileSystem.h>
+#include <rwe/vfs/DirectoryFileSystem.h>
+
+namespace rwe
+{
+    /** Holds its files in memory. Only supports what the composite filesystem uses. */
+    class MemoryFileSystem final : public LeafVirtualFileSystem
+    {
+    private:
+        std::string name;
+        std::map<std::string, std::string> files;
+
+    public:
+        MemoryFileSystem(const std::string& name, std::map<std::string, std::string> files)
+            : name(name), files(std::move(files))
+        {
+        }
+
+        const std::string& getPath() const override
+        {
+            return name;
+        }
+
+        std::optional<std::vector<char>> readFile(const std::string& filename) const override
+        {
+            auto it = files.find(filename);
+            if (it == files.end())
+            {
+                return std::nullopt;
+            }
+
+            return std::vector<char>(it->second.begin(), it->second.end());
+        }
+
+        std::vector<std::string> getFileNames(const std::string&, const std::string&) override
+        {
+            throw std::logic_error("Not implemented");
+        }
+
+        std::vector<std::string> getFileNamesRecursive(const std::string&, const std::string&) override
+        {
+            throw std::logic_error("Not implemented");
+        }
+
+        std::vector<std::string> getAllFileNames() const override
+        {
+            std::vector<std::string> v;
+            for (const auto& e : files)
+            {
+                v.push_back(e.first);
+            }
+            return v;
+        }
+    };
+
+    /** Creates an empty directory and deletes it again when destroyed. */
+    class TemporaryDirectory
+    {
+    public:
+        const boost::filesystem::path path;
+
+        TemporaryDirectory()
+            : path(boost::filesystem::temp_directory_path() / boost::filesystem::unique_path())
+        {
+            boost::filesystem::create_directories(path);
+        }
+
+        ~TemporaryDirectory()
+        {
+            boost::system::error_code ec;
+            boost::filesystem::remove_all(path, ec);
+        }
+
+        TemporaryDirectory(const TemporaryDirectory&) = delete;
+        TemporaryDirectory& operator=(const TemporaryDirectory&) = delete;
+    };
+
+    static void writeString(const boost::filesystem::path& path, const std::string& contents)
+    {
+        boost::filesystem::create_directories(path.parent_path());
+        std::ofstream(path.string(), std::ios::binary) << contents;
+    }
+
+    static std::string readString(const CompositeVirtualFileSystem& vfs, const std::string& filename)
+    {
+        auto bytes = vfs.readFile(filename);
+        REQUIRE(bytes);
+        return std::string(bytes->begin(), bytes->end());
+    }
+
+    TEST_CASE("CompositeVirtualFileSystem")
+    {
+        CompositeVirtualFileSystem vfs;
+        vfs.emplaceFileSystem<MemoryFileSystem>(
+            "first",
+            std::map<std::string, std::string>{
+                {"Units/ARMCOM.fbi", "first armcom"},
+                {"maps/Foo.ota", "first foo"},
+            });
+        vfs.emplaceFileSystem<MemoryFileSystem>(
+            "second",
+            std::map<std::string, std::string>{
+                {"units/armcom.FBI", "second armcom"},
+                {"units/corcom.fbi", "second corcom"},
+                {"maps/bar.ota", "second bar"},
+                {"maps/bar.tnt", "second bar map"},
+                {"features/trees/tree.tdf", "tree"},
+                {"features/rock.tdf", "rock"},
+            });
+
+        SECTION("reads files case-insensitively")
+        {
+            REQUIRE(readString(vfs, "units/CORCOM.FBI") == "second corcom");
+            REQUIRE(!vfs.readFile("units/missing.fbi"));
+        }
+
+        SECTION("reads views of files case-insensitively")
+        {
+            auto view = vfs.readFileView("MAPS/BAR.TNT");
+            REQUIRE(view);
+            REQUIRE(view->asStringView() == "second bar map");
+            REQUIRE(!vfs.readFileView("maps/missing.tnt"));
+        }
+
+        SECTION("prefers the filesystem added first")
+        {
+            REQUIRE(readString(vfs, "units/armcom.fbi") == "first armcom");
+        }
+
+        SECTION("lists the files in a directory with the extension")
+        {
+            REQUIRE(vfs.getFileNames("maps", ".OTA") == std::vector<std::string>{"Foo.ota", "bar.ota"});
+            REQUIRE(vfs.getFileNames("MAPS/", ".ota") == std::vector<std::string>{"Foo.ota", "bar.ota"});
+            REQUIRE(vfs.getFileNames("features", ".tdf") == std::vector<std::string>{"rock.tdf"});
+            REQUIRE(vfs.getFileNames("missing", ".tdf").empty());
+            REQUIRE(vfs.getFileNames("maps", "").empty());
+        }
+
+        SECTION("lists the files below a directory")
+        {
+            REQUIRE(vfs.getFileNamesRecursive("features", ".tdf") == std::vector<std::string>{"rock.tdf", "trees/tree.tdf"});
+        }
+
+        SECTION("lists files with the filesystem they first appear in")
+        {
+            auto expected = std::vector<std::pair<std::string, std::string>>{{"ARMCOM.fbi", "first"}, {"armcom.FBI", "second"}, {"corcom.fbi", "second"}};
+            REQUIRE(vfs.getFileNamesWithSources("units", ".fbi") == expected);
+        }
+
+        SECTION("forgets everything when cleared")
+        {
+            vfs.clear();
+            REQUIRE(!vfs.readFile("units/corcom.fbi"));
+            REQUIRE(vfs.getFileNames("units", ".fbi").empty());
+        }
+    }
+
+    TEST_CASE("CompositeVirtualFileSystem with a directory")
+    {
+        TemporaryDirectory root;
+        writeString(root.path / "units" / "ARMCOM.fbi", "armcom");
+        writeString(root.path / "shared" / "Tree.tdf", "tree");
+        boost::filesystem::create_directory_symlink(root.path / "shared", root.path / "features");
+        boost::filesystem::create_directory_symlink(root.path, root.path / "units" / "loop");
+
+        CompositeVirtualFileSystem vfs;
+        vfs.emplaceFileSystem<DirectoryFileSystem>(root.path);
+
+        SECTION("indexes the contents of symlinked directories")
+        {
+            REQUIRE(vfs.getFileNames("features", ".tdf") == std::vector<std::string>{"Tree.tdf"});
+            REQUIRE(vfs.getFileNamesRecursive("", ".tdf") == std::vector<std::string>{"features/Tree.tdf", "shared/Tree.tdf"});
+        }
+
+        SECTION("does not follow symlinks back up the tree")
+        {
+            REQUIRE(vfs.getFileNamesRecursive("", ".fbi") == std::vector<std::string>{"units/ARMCOM.fbi"});
+        }
+
+        SECTION("prefers files in symlinked directories to later filesystems")
+        {
+            vfs.emplaceFileSystem<MemoryFileSystem>(
+                "archive",
+                std::map<std::string, std::string>{{"features/tree.tdf", "archive tree"}});
+            REQUIRE(readString(vfs, "features/tree.tdf") == "tree");
+        }
+
+        SECTION("reads files through symlinked directories case-insensitively")
+        {
+            REQUIRE(readString(vfs, "FEATURES/tree.TDF") == "tree");
+        }
+
+        SECTION("reads files added after the directory once the index is refreshed")
+        {
+            writeString(root.path / "maps" / "Foo.ota", "foo");
+            REQUIRE(!vfs.readFile("maps/foo.ota"));
+
+            vfs.refreshIndex();
+            REQUIRE(readString(vfs, "maps/foo.ota") == "foo");
+
+            auto view = vfs.readFileView("MAPS/FOO.OTA");
+            REQUIRE(view);
+            REQUIRE(view->asStringView() == "foo");
+
+            REQUIRE(!vfs.readFile("maps/missing.ota"));
+        }
+
+        SECTION("prefers files added to the directory to later filesystems once refreshed")
+        {
+            vfs.emplaceFileSystem<MemoryFileSystem>(
+                "archive",
+                std::map<std::string, std::string>{{"maps/Foo.ota", "archive foo"}});
+            writeString(root.path / "maps" / "Foo.ota", "foo");
+            REQUIRE(readString(vfs, "maps/foo.ota") == "archive foo");
+
+            vfs.refreshIndex();
+            REQUIRE(readString(vfs, "maps/foo.ota") == "foo");
+            REQUIRE(vfs.getFileNamesWithSources("maps", ".ota") == std::vector<std::pair<std::string, std::string>>{{"Foo.ota", root.path.string()}});
+        }
+    }
+}